@@ -0,0 +1,147 @@
+/**
+ * @file io_backend_bench.cpp
+ * @brief IoBackend 队列深度基准：对目录下的全部文件分别用线程池和 io_uring 后端、在不同队列深度下
+ *        批量 stat、读取，并把读到的内容写入临时目录，输出各自的吞吐。
+ * @details 用法：io_backend_bench <目录> [队列深度...] (默认 1 2 4 8 16 32 64)。\n
+ *  测的是当前页缓存状态下的吞吐；要测冷缓存 (真实的设备队列深度效果)，每轮之间需以 root 执行
+ *  `sync; echo 3 > /proc/sys/vm/drop_caches`，或在网络文件系统上运行。
+ */
+#include "../include/IoBackend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace Biogit;
+
+namespace {
+
+constexpr size_t FILES_PER_BATCH = 256;                  ///< 与检出时每批写出的文件数相同
+constexpr uint64_t MAX_WRITE_BYTES = 256ULL * 1024 * 1024; ///< 写入测试最多写出的字节数
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct RunResult {
+    double stat_seconds = 0;
+    double read_seconds = 0;
+    double write_seconds = 0;
+    uint64_t bytes_read = 0;
+    uint64_t bytes_written = 0;
+    size_t failures = 0;
+};
+
+RunResult run_once(IoBackend& backend, const std::vector<std::filesystem::path>& files, const std::filesystem::path& scratch_dir) {
+    RunResult result;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t begin = 0; begin < files.size(); begin += FILES_PER_BATCH) {
+        std::vector<std::filesystem::path> batch(files.begin() + begin, files.begin() + std::min(begin + FILES_PER_BATCH, files.size()));
+        for (const auto& stat_opt : backend.stat_files(batch)) {
+            if (!stat_opt) ++result.failures;
+        }
+    }
+    result.stat_seconds = seconds_since(start);
+
+    for (size_t begin = 0; begin < files.size(); begin += FILES_PER_BATCH) {
+        std::vector<std::filesystem::path> batch(files.begin() + begin, files.begin() + std::min(begin + FILES_PER_BATCH, files.size()));
+        start = std::chrono::steady_clock::now();
+        std::vector<std::optional<std::vector<std::byte>>> contents = backend.read_files(batch);
+        result.read_seconds += seconds_since(start);
+
+        std::vector<IoBackend::WriteRequest> requests;
+        for (size_t k = 0; k < contents.size(); ++k) {
+            if (!contents[k]) {
+                ++result.failures;
+                continue;
+            }
+            result.bytes_read += contents[k]->size();
+            if (result.bytes_written + contents[k]->size() > MAX_WRITE_BYTES) continue;
+            result.bytes_written += contents[k]->size();
+            requests.push_back({scratch_dir / std::to_string(begin + k), contents[k]->data(), contents[k]->size()});
+        }
+        start = std::chrono::steady_clock::now();
+        for (bool written : backend.write_files(requests)) {
+            if (!written) ++result.failures;
+        }
+        result.write_seconds += seconds_since(start);
+    }
+    return result;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "用法: " << argv[0] << " <目录> [队列深度...]" << std::endl;
+        return 1;
+    }
+    const std::filesystem::path root = argv[1];
+    std::vector<size_t> depths;
+    for (int i = 2; i < argc; ++i) {
+        const long depth = std::strtol(argv[i], nullptr, 10);
+        if (depth <= 0) {
+            std::cerr << "错误: 无效的队列深度 '" << argv[i] << "'" << std::endl;
+            return 1;
+        }
+        depths.push_back(static_cast<size_t>(depth));
+    }
+    if (depths.empty()) depths = {1, 2, 4, 8, 16, 32, 64};
+
+    std::vector<std::filesystem::path> files;
+    std::error_code ec;
+    for (std::filesystem::recursive_directory_iterator it(root, std::filesystem::directory_options::skip_permission_denied, ec), end;
+         !ec && it != end; it.increment(ec)) {
+        if (it->path().filename() == ".biogit") {
+            it.disable_recursion_pending();
+            continue;
+        }
+        if (it->is_regular_file(ec)) files.push_back(it->path());
+    }
+    if (ec) {
+        std::cerr << "错误: 无法遍历目录 '" << root.string() << "': " << ec.message() << std::endl;
+        return 1;
+    }
+    if (files.empty()) {
+        std::cerr << "错误: 目录 '" << root.string() << "' 中没有文件。" << std::endl;
+        return 1;
+    }
+
+    const std::filesystem::path scratch_dir =
+        std::filesystem::temp_directory_path() / ("biogit-io-bench-" + std::to_string(::getpid()));
+    std::filesystem::create_directories(scratch_dir, ec);
+    if (ec) {
+        std::cerr << "错误: 无法创建临时目录 '" << scratch_dir.string() << "': " << ec.message() << std::endl;
+        return 1;
+    }
+
+    std::cout << files.size() << " 个文件；io_uring " << (IoBackend::io_uring_available() ? "可用" : "不可用") << std::endl;
+    // 表头用 ASCII，setw 按字节计宽，中文会错位
+    std::cout << std::left << std::setw(10) << "backend" << std::right << std::setw(6) << "depth"
+              << std::setw(14) << "stat files/s" << std::setw(14) << "read MiB/s" << std::setw(14) << "write MiB/s"
+              << std::setw(8) << "failed" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    for (IoBackend::Kind kind : {IoBackend::Kind::ThreadPool, IoBackend::Kind::IoUring}) {
+        if (kind == IoBackend::Kind::IoUring && !IoBackend::io_uring_available()) continue;
+        for (size_t depth : depths) {
+            std::unique_ptr<IoBackend> backend = IoBackend::create(kind, depth);
+            const RunResult result = run_once(*backend, files, scratch_dir);
+            constexpr double MIB = 1024.0 * 1024.0;
+            std::cout << std::left << std::setw(10) << backend->name() << std::right << std::setw(6) << backend->queue_depth()
+                      << std::setw(14) << files.size() / std::max(result.stat_seconds, 1e-9)
+                      << std::setw(14) << result.bytes_read / MIB / std::max(result.read_seconds, 1e-9)
+                      << std::setw(14) << result.bytes_written / MIB / std::max(result.write_seconds, 1e-9)
+                      << std::setw(8) << result.failures << std::endl;
+        }
+    }
+
+    std::filesystem::remove_all(scratch_dir, ec);
+    return 0;
+}
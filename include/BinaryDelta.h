@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+#include <limits>
+#include <cstddef>
+#include <cstdint>
+
+namespace Biogit {
+
+/**
+ * @brief 二进制增量 (delta) 的编码与还原。
+ * @details
+ *  增量格式：<基准长度 varint><目标长度 varint>，之后是一串指令：\n
+ *  - COPY   (0x01) <偏移 varint><长度 varint>：从基准中复制一段；\n
+ *  - INSERT (0x02) <长度 varint><字面字节>：直接插入新数据。\n
+ *  varint 为 LEB128 (每字节低 7 位，最高位表示后面还有字节)。基准长度写入增量，
+ *  还原时基准不一致会直接失败，而不是得到错误的内容。
+ */
+namespace BinaryDelta {
+
+inline constexpr uint8_t OP_COPY = 0x01;
+inline constexpr uint8_t OP_INSERT = 0x02;
+
+/**
+ * @brief 在基准上执行增量，得到目标内容。
+ * @param max_target_size 允许的最大目标长度；头部声明的目标长度超过它时不执行任何指令直接失败。
+ * @return 目标内容；基准长度不符、目标长度超限、指令越界或目标长度不符时返回 std::nullopt。
+ */
+std::optional<std::vector<std::byte>> apply(const std::byte* base, size_t base_size,
+                                            const std::byte* delta, size_t delta_size,
+                                            size_t max_target_size = std::numeric_limits<size_t>::max());
+
+}
+
+/**
+ * @brief 基准内容的滚动哈希索引，用于对同一基准计算多个目标的增量。
+ * @details
+ *  把基准切成不重叠的 block_size 字节块，以多项式滚动哈希建立开放寻址哈希表。
+ *  编码时在目标上逐字节滚动同样长度的窗口查表，命中且内容一致后向前、向后扩展为最长匹配，
+ *  输出 COPY；无法匹配的字节累积为 INSERT。\n
+ *  块长度至少为 MIN_BLOCK_SIZE，基准很大时按比例加大，使索引条目数不超过 MAX_INDEX_ENTRIES。
+ *  索引只保存指针，基准内容在索引的生命周期内必须保持有效。
+ */
+class DeltaIndex {
+public:
+    static constexpr size_t MIN_BLOCK_SIZE = 16;
+    static constexpr size_t MAX_INDEX_ENTRIES = 1 << 22;
+    /// 同一哈希值最多比较的候选位置数 (高度重复的内容中限制查找代价)
+    static constexpr size_t MAX_CANDIDATES = 8;
+
+    DeltaIndex(const std::byte* base, size_t base_size);
+
+    /**
+     * @brief 计算把基准变为 target 的增量。
+     * @param max_delta_size 增量超过此大小时放弃 (调用者改为发送完整内容)。
+     * @return 增量；超过 max_delta_size 时返回 std::nullopt。
+     */
+    std::optional<std::vector<std::byte>> encode(const std::byte* target, size_t target_size,
+                                                 size_t max_delta_size = std::numeric_limits<size_t>::max()) const;
+
+    size_t block_size() const { return block_size_; }
+
+private:
+    /// 在索引中查找与 target[pos, pos + block_size) 一致的基准位置，返回向后扩展最长的一个
+    bool find_match(uint32_t hash, const std::byte* target, size_t target_size, size_t pos,
+                    size_t& out_base_offset, size_t& out_length) const;
+
+    const std::byte* base_;
+    size_t base_size_;
+    size_t block_size_;
+    uint32_t power_;            ///< MULTIPLIER^(block_size - 1)，滚动时移出首字节用
+    size_t table_mask_ = 0;
+    std::vector<uint32_t> hashes_;
+    std::vector<uint32_t> offsets_; ///< 基准偏移 + 1 (0 表示空槽)
+};
+
+}
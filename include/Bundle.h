@@ -0,0 +1,120 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <optional>
+#include <filesystem>
+#include <cstdint>
+
+#include "sha1.h"
+
+namespace Biogit {
+
+/**
+ * @brief 离线传输包 (bundle) 的头部：包含的引用和接收方必须已有的前置 Commit。
+ */
+struct BundleHeader {
+    std::vector<std::string> prerequisites;                  ///< 前置 Commit (接收方必须已有，其对象不在包内)
+    std::vector<std::pair<std::string, std::string>> refs;   ///< <引用全名 (如 refs/heads/main), Commit 哈希>
+    std::string head_ref;                                    ///< 创建方 HEAD 指向的分支引用 (可为空)
+};
+
+/**
+ * @brief 离线传输包的文件格式。
+ * @details
+ *  文本头部 (每行以 '\n' 结尾)：\n
+ *      # biogit bundle v1\n
+ *      -<前置 Commit 哈希>          (0 行或多行)\n
+ *      <Commit 哈希> <引用全名>     (1 行或多行)\n
+ *      @<分支引用全名>               (可选，创建方 HEAD 指向的分支)\n
+ *      <空行>\n
+ *  之后是对象流：PACK_MAGIC (4字节) + 对象数 (8字节大端)，再依次是每个对象：\n
+ *      20 字节二进制哈希 + 存储方式 (1字节：0 原样，1 zlib) + 规范长度 varint + 数据长度 varint + 数据\n
+ *  数据还原后是规范对象字节 "type size\0content"。最后是对象流 (从 PACK_MAGIC 起) 的 SHA-1，40 位十六进制。\n
+ *  读写都是顺序进行的，任一时刻只在内存中保留一个对象。
+ */
+namespace Bundle {
+
+inline constexpr const char* SIGNATURE = "# biogit bundle v1";
+inline constexpr char PACK_MAGIC[4] = {'B', 'P', 'C', 'K'};
+/// 对象流中的存储方式
+inline constexpr uint8_t STORED_RAW = 0;
+inline constexpr uint8_t STORED_ZLIB = 1;
+
+/// 文件是否以 bundle 签名开头
+bool is_bundle(const std::filesystem::path& file_path);
+
+}
+
+
+/**
+ * @brief 顺序写入离线传输包。先写入 <文件>.tmp，finish() 校验对象数后改名为最终文件。
+ */
+class BundleWriter {
+public:
+    /**
+     * @brief 创建文件并写入头部和对象流开头。
+     * @param object_count 之后将写入的对象数。
+     */
+    bool open(const std::filesystem::path& file_path, const BundleHeader& header, uint64_t object_count);
+
+    /// 写入一个对象的规范字节 (以 zlib 压缩，没有收益时原样写入)
+    bool add_object(const std::string& hash_hex, const char* data, size_t size);
+
+    /// 写入校验和并改名为最终文件
+    bool finish();
+
+    ~BundleWriter();
+
+private:
+    void write_bytes(const void* data, size_t size);
+
+    std::filesystem::path file_path_;
+    std::filesystem::path temp_path_;
+    std::ofstream ofs_;
+    SHA1::Hasher hasher_;
+    uint64_t expected_count_ = 0;
+    uint64_t written_count_ = 0;
+    bool finished_ = false;
+};
+
+
+/**
+ * @brief 顺序读取离线传输包。next() 逐个返回对象并校验哈希，读完后 verify_checksum() 校验整个对象流。
+ */
+class BundleReader {
+public:
+    /// 打开文件并解析头部
+    bool open(const std::filesystem::path& file_path);
+
+    const BundleHeader& header() const { return header_; }
+    uint64_t object_count() const { return object_count_; }
+
+    /**
+     * @brief 读取下一个对象。
+     * @param out_hash_hex 输出对象哈希。
+     * @param out_data 输出规范对象字节。
+     * @return 读到对象返回 true；对象已读完或出错时返回 false (用 failed() 区分)。
+     */
+    bool next(std::string& out_hash_hex, std::vector<char>& out_data);
+
+    bool failed() const { return failed_; }
+
+    /// 所有对象读完后校验对象流的 SHA-1
+    bool verify_checksum();
+
+private:
+    bool read_bytes(void* data, size_t size);
+    bool read_varint(uint64_t& value);
+
+    std::filesystem::path file_path_;
+    std::ifstream ifs_;
+    SHA1::Hasher hasher_;
+    BundleHeader header_;
+    uint64_t object_count_ = 0;
+    uint64_t read_count_ = 0;
+    bool failed_ = false;
+};
+
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <optional>
+#include <filesystem>
+#include <cstdint>
+
+namespace Biogit {
+
+/**
+ * @brief 一个简单的定长 Bloom 过滤器，用于记录某个 Commit 改动过的路径集合。
+ * @details
+ * 采用双重哈希 (h1 + i*h2) 生成 NUM_HASHES 个位下标，每个条目约占 BITS_PER_ENTRY 个比特。
+ * 查询结果只有两种：“一定不包含” 与 “可能包含”。
+ * 当改动路径过多时，过滤器被标记为饱和 (saturated)，任何查询都返回 “可能包含”。
+ */
+class BloomFilter {
+public:
+    static constexpr uint32_t BITS_PER_ENTRY = 10; ///< 每个条目分配的比特数
+    static constexpr uint32_t NUM_HASHES = 7;      ///< 每个条目设置的比特数
+    static constexpr uint32_t MIN_BITS = 64;       ///< 过滤器的最小比特数
+
+    BloomFilter() = default;
+
+    /**
+     * @brief 按预计条目数量构造一个空的过滤器。
+     * @param expected_entries 预计插入的条目数量。
+     */
+    explicit BloomFilter(size_t expected_entries);
+
+    /**
+     * @brief 构造一个饱和的过滤器 (对任何查询都返回 “可能包含”)。
+     */
+    static BloomFilter saturated();
+
+    /** @brief 向过滤器中加入一个键。*/
+    void add(const std::string& key);
+
+    /**
+     * @brief 查询键是否可能在过滤器中。
+     * @return false 表示一定不在；true 表示可能在。
+     */
+    bool might_contain(const std::string& key) const;
+
+    /** @brief 过滤器是否处于饱和状态。*/
+    bool is_saturated() const { return saturated_; }
+
+    /**
+     * @brief 将过滤器序列化为一行文本: "<比特数> <十六进制位图>" 或 "*" (饱和)。
+     */
+    std::string format_for_file() const;
+
+    /**
+     * @brief 从 format_for_file() 产生的文本解析出过滤器。
+     */
+    static std::optional<BloomFilter> parse_from_string(const std::string& text);
+
+private:
+    std::vector<uint8_t> bits_; ///< 位图
+    bool saturated_ = false;    ///< 是否饱和
+};
+
+
+/**
+ * @brief 每个 Commit 的 “改动路径” Bloom 过滤器的持久化存储 (.biogit/commit-bloom 旁路文件)。
+ * @details
+ * 文件为纯文本，每行格式: <Commit哈希> <比特数> <十六进制位图>，饱和时为 <Commit哈希> *。
+ * 过滤器中除了记录改动的文件路径外，还记录其所有父目录前缀 (例如 "data/chr7/a.fa" 会同时
+ * 加入 "data/chr7" 和 "data")，因此既可以按文件也可以按目录查询。
+ * 改动的比较基准为 Commit 的第一个父提交 (根提交与空树比较)，与 log 的第一父追溯保持一致。
+ */
+class ChangedPathBloomStore {
+public:
+    static const std::string FILE_NAME;              ///< 旁路文件名 "commit-bloom"
+    static constexpr size_t MAX_CHANGED_PATHS = 512; ///< 改动路径超过此数量时写入饱和过滤器
+
+    /**
+     * @brief 构造存储对象。
+     * @param biogit_dir_path 指向 .biogit 目录的路径。
+     */
+    explicit ChangedPathBloomStore(const std::filesystem::path& biogit_dir_path);
+
+    /**
+     * @brief 从磁盘加载所有过滤器。文件不存在视为空存储。
+     * @return 如果发生 I/O 错误返回 false。格式错误的行会被忽略 (按缺失处理)。
+     */
+    bool load();
+
+    /**
+     * @brief 获取指定 Commit 的过滤器。
+     * @return 如果存储中没有该 Commit 的记录，返回 nullptr。
+     */
+    const BloomFilter* get(const std::string& commit_hash) const;
+
+    /**
+     * @brief 根据改动的文件路径集合为 Commit 构建过滤器，加入内存并追加写入旁路文件。
+     * @details 不要求先 load()：只追加一行，不读取旁路文件。未加载时只能与本对象记录过的 Commit 去重，
+     *  重复的行无害 (load() 时以最后一行为准)。
+     * @param commit_hash Commit 哈希。
+     * @param changed_paths 相对于工作树根目录的改动文件路径 (使用 '/' 分隔)。
+     * @return 如果写入成功 (或该 Commit 已有记录)，返回 true。
+     */
+    bool record(const std::string& commit_hash, const std::set<std::string>& changed_paths);
+
+private:
+    std::filesystem::path file_path_;              ///< .biogit/commit-bloom 文件的完整路径
+    std::map<std::string, BloomFilter> filters_;   ///< 内存中的 <Commit哈希, 过滤器>
+};
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Biogit {
+
+/**
+ * @brief 内容定义分块 (CDC) 的参数。
+ */
+struct ChunkingParams {
+    size_t min_size = 16 * 1024;   ///< 最小块长度 (在此之前不检测切点)
+    size_t avg_size = 64 * 1024;   ///< 期望的平均块长度 (必须是 2 的幂)
+    size_t max_size = 256 * 1024;  ///< 最大块长度 (到达后强制切分)
+};
+
+/**
+ * @brief FastCDC 内容定义分块器。
+ * @details
+ *  使用 Gear 滚动哈希 (fp = (fp << 1) + GEAR[byte]) 在内容上寻找切点：哈希的高位与掩码相与为 0 时切分。
+ *  切点只取决于附近约 64 字节的内容，因此在文件中间插入/删除数据只会影响附近的一两个块，
+ *  其余块的哈希不变，可以在版本之间共享 (去重)。\n
+ *  采用 “归一化分块”：未到平均长度前使用更严格的掩码 (多 2 位)，超过后使用更宽松的掩码 (少 2 位)，
+ *  使块长度集中在平均值附近。
+ */
+class FastCdcChunker {
+public:
+    explicit FastCdcChunker(ChunkingParams params = {});
+
+    /**
+     * @brief 将数据切分为块。
+     * @return 各块的长度，依次相加等于 size。size 为 0 时返回空列表。
+     */
+    std::vector<size_t> split(const std::byte* data, size_t size) const;
+
+    const ChunkingParams& params() const { return params_; }
+
+private:
+    /// 返回从 data 开始的下一个块的长度
+    size_t next_cut(const uint8_t* data, size_t size) const;
+
+    ChunkingParams params_;
+    uint64_t mask_small_; ///< 未到平均长度前使用的掩码 (位数更多，更难命中)
+    uint64_t mask_large_; ///< 超过平均长度后使用的掩码 (位数更少，更易命中)
+};
+
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <filesystem>
+#include <iostream>
+#include <cstddef>
+
+namespace Biogit {
+
+/**
+ * @brief 文件中的一条记录 (FASTA 序列、FASTQ read、VCF 变异行等)，以行区间表示。
+ */
+struct DiffRecord {
+    std::string key;       ///< 对齐用的记录键 (序列 ID、read ID、CHROM+POS ...)
+    size_t first_line = 0; ///< 记录的第一行在文件行列表中的索引 (0-based)
+    size_t line_count = 0; ///< 记录占用的行数
+};
+
+/**
+ * @brief 统一差异格式中的一个 Hunk。
+ */
+struct DiffHunk {
+    size_t old_start = 0;            ///< 旧文件中第一行的索引 (0-based；old_count 为 0 时表示插入位置)
+    size_t old_count = 0;            ///< 旧文件中的行数
+    size_t new_start = 0;            ///< 新文件中第一行的索引 (0-based)
+    size_t new_count = 0;            ///< 新文件中的行数
+    std::string section;             ///< 附在 "@@ ... @@" 之后的定位信息 (例如 FASTA 标题行)
+    std::vector<std::string> lines;  ///< 带前缀 (' ' / '-' / '+') 的内容行
+};
+
+/**
+ * @brief 按记录比较文件的 diff 驱动接口。
+ * @details
+ *  对换行折叠的 FASTA 这类文件，按行运行 Myers 时插入一个碱基会使其后的所有行错位，
+ *  输出与染色体一样大且耗时接近二次方。驱动先把文件切分为记录，按记录键对齐两边的记录
+ *  (线性时间)，只对键相同但内容不同的记录做细粒度比较。\n
+ *  输出仍为统一差异格式，但 Hunk 只包含有改动的行 (记录内部不附带上下文行)。
+ */
+class DiffDriver {
+public:
+    virtual ~DiffDriver() = default;
+
+    /// 驱动名称，同时用于配置项 diff.<名称>.pattern
+    virtual const char* name() const = 0;
+
+    /// 默认匹配的文件名模式 (glob，匹配文件名；含 '/' 时匹配相对路径)
+    virtual std::vector<std::string> default_patterns() const = 0;
+
+    /**
+     * @brief 把文件行切分为记录。文件不符合格式时返回 std::nullopt (调用者回退到普通按行 diff)。
+     */
+    virtual std::optional<std::vector<DiffRecord>> split_records(const std::vector<std::string>& lines) const = 0;
+
+    /**
+     * @brief 比较一对键相同但内容不同的记录，把结果追加到 hunks。
+     * @details 默认实现对记录内的行运行 Myers，输出从第一处改动到最后一处改动的一个 Hunk。
+     */
+    virtual void diff_record(const std::vector<std::string>& lines_a, const DiffRecord& record_a,
+                             const std::vector<std::string>& lines_b, const DiffRecord& record_b,
+                             std::vector<DiffHunk>& hunks) const;
+
+    /**
+     * @brief 按记录比较两个版本。任一版本无法切分为记录时返回 std::nullopt。
+     * @return 按行号排序的 Hunk 列表 (相邻的记录级 Hunk 会合并)。
+     */
+    std::optional<std::vector<DiffHunk>> diff(const std::vector<std::string>& lines_a,
+                                              const std::vector<std::string>& lines_b) const;
+};
+
+
+/**
+ * @brief FASTA 驱动：以 '>' 标题行分记录 (键为序列 ID)，序列内容在字节级别比较。
+ * @details
+ *  序列行去掉换行拼接后，先剥离相同的前缀和后缀；中间部分逐字节扫描，遇到不同时在
+ *  RESYNC_WINDOW 范围内寻找两边重新对齐的位置 (之后 ANCHOR_LENGTH 个碱基相同)，
+ *  按 “两边跳过的字节数之和” 从小到大尝试，因此 SNP 和短插入/删除都能得到最小的改动段。
+ *  找不到对齐位置时，剩余部分视为一整段改动。\n
+ *  相近的改动合并后映射回所在的行输出，插入/删除碱基不会让后续的行全部成为差异。
+ */
+class FastaDiffDriver : public DiffDriver {
+public:
+    /// 重新对齐时要求相同的碱基数
+    static constexpr size_t ANCHOR_LENGTH = 32;
+    /// 重新对齐时每一边最多跳过的字节数
+    static constexpr size_t RESYNC_WINDOW = 4096;
+    /// 两处改动之间相同的碱基少于此数时合并为一个 Hunk
+    static constexpr size_t MERGE_GAP = 80;
+
+    const char* name() const override { return "fasta"; }
+    std::vector<std::string> default_patterns() const override;
+    std::optional<std::vector<DiffRecord>> split_records(const std::vector<std::string>& lines) const override;
+    void diff_record(const std::vector<std::string>& lines_a, const DiffRecord& record_a,
+                     const std::vector<std::string>& lines_b, const DiffRecord& record_b,
+                     std::vector<DiffHunk>& hunks) const override;
+};
+
+/**
+ * @brief FASTQ 驱动：严格 4 行一条记录 (键为 read ID)，记录内按行比较。
+ */
+class FastqDiffDriver : public DiffDriver {
+public:
+    const char* name() const override { return "fastq"; }
+    std::vector<std::string> default_patterns() const override;
+    std::optional<std::vector<DiffRecord>> split_records(const std::vector<std::string>& lines) const override;
+};
+
+/**
+ * @brief VCF 驱动：每个元信息/表头行是一条记录；数据行以 CHROM + POS 为键。
+ */
+class VcfDiffDriver : public DiffDriver {
+public:
+    const char* name() const override { return "vcf"; }
+    std::vector<std::string> default_patterns() const override;
+    std::optional<std::vector<DiffRecord>> split_records(const std::vector<std::string>& lines) const override;
+};
+
+
+/**
+ * @brief diff 驱动注册表与输出辅助函数。
+ */
+namespace DiffDrivers {
+
+/// 读取配置项的回调 (通常为 Repository::config_get)
+using ConfigLookup = std::function<std::optional<std::string>(const std::string& key)>;
+
+/**
+ * @brief 简单的 glob 匹配，支持 '*' 与 '?'。
+ */
+bool glob_match(const std::string& pattern, const std::string& text);
+
+/**
+ * @brief 按文件路径选择 diff 驱动。
+ * @details 配置项 diff.<驱动名>.pattern (以逗号或空格分隔的 glob 列表) 覆盖驱动的默认模式，设为空表示禁用该驱动。
+ * @return 匹配的驱动；没有匹配时返回 nullptr (使用普通按行 diff)。
+ */
+const DiffDriver* find_for_path(const std::filesystem::path& relative_path, const ConfigLookup& config);
+
+/**
+ * @brief 一次读出各驱动的 diff.<驱动名>.pattern 配置，返回只查询这份快照的回调。
+ * @details 供并行的 diff 任务共享：每个文件选择驱动时不再读取配置文件。
+ */
+ConfigLookup snapshot_config(const ConfigLookup& config);
+
+/**
+ * @brief 以统一差异格式打印 Hunk 列表 (文件识别头与 Utils::print_unified_diff 一致)。
+ */
+void print_hunks(const std::filesystem::path& old_file_path,
+                 const std::filesystem::path& new_file_path,
+                 const std::vector<DiffHunk>& hunks,
+                 const std::string& old_file_label_suffix,
+                 const std::string& new_file_label_suffix,
+                 const std::vector<std::string>& extended_header_lines,
+                 std::ostream& out = std::cout);
+
+/**
+ * @brief 统计 Hunk 中新增和删除的行数 (用于 diff --stat)。
+ * @return <新增行数, 删除行数>
+ */
+std::pair<int, int> count_changes(const std::vector<DiffHunk>& hunks);
+
+}
+
+}
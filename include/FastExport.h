@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <ostream>
+#include <filesystem>
+#include <cstdint>
+
+namespace Biogit {
+
+class Repository;
+
+/**
+ * @brief 把提交历史导出为批量导入流 (fast-export)，输出可以直接交给 fast-import。
+ * @details
+ *  提交按拓扑顺序 (父提交先于子提交) 输出，每个提交只给出相对第一个父提交的改动：\n
+ *      blob \n mark :<n> \n data <字节数>\n<内容>\n           (每个 Blob 只输出一次，之后用标记引用)\n
+ *      [reset <引用>]                                         (根提交之前)\n
+ *      commit <引用> \n mark :<n> \n author ... \n committer ... \n data ... \n
+ *          [from <提交>] \n [merge <提交>]... \n (D <路径> | M <模式> :<n> <路径>)... \n\n
+ *      reset <引用> \n from <提交> \n\n                        (引用最终指向的提交)\n
+ *  改动通过逐层比较 Tree 条目的哈希得到：哈希相同的子树直接跳过、从不展开，整个被删除的目录只输出一条 D。
+ *  内存中只保留待导出提交的集合和 对象哈希 -> 标记 的映射，不保留任何文件内容或完整的树。
+ */
+class FastExporter {
+public:
+    FastExporter(const Repository& repo, std::ostream& out);
+
+    /**
+     * @brief 导出引用可达、且不可从任何基准提交到达的全部提交，最后输出各引用的位置。
+     * @param refs <引用全名, Commit 哈希>，按输出顺序。
+     * @param bases 基准提交 (它们可达的提交视为接收方已有，被引用时直接写出哈希)。
+     * @return 全部成功返回 true；否则返回 false。
+     */
+    bool run(const std::vector<std::pair<std::string, std::string>>& refs, const std::vector<std::string>& bases);
+
+private:
+    /// 一个文件改动：deleted 为 true 时只用 path (可能是整个目录)
+    struct FileChange {
+        bool deleted;
+        std::string path;
+        std::string mode;
+        std::string hash;
+    };
+
+    bool collect_commits(const std::vector<std::pair<std::string, std::string>>& refs,
+                         const std::vector<std::string>& bases,
+                         std::vector<std::pair<std::string, size_t>>& out_ordered);
+    bool diff_trees(const std::string& old_tree_hash, const std::string& new_tree_hash,
+                    const std::string& prefix, std::vector<FileChange>& changes) const;
+    bool emit_blob(const std::string& blob_hash);
+    bool emit_commit(const std::string& commit_hash, const std::string& ref_name);
+    std::string commit_ref(const std::string& commit_hash) const;
+    static std::string quote_path(const std::string& path);
+
+    const Repository& repo_;
+    std::ostream& out_;
+    std::filesystem::path objects_dir_;
+
+    std::unordered_map<std::string, std::uint64_t> marks_;          ///< 已输出的 Blob/Commit 哈希 -> 标记
+    std::unordered_map<std::string, std::string> last_commit_on_ref_; ///< 引用 -> 本次在其上输出的最后一个提交
+    std::uint64_t next_mark_ = 1;
+    size_t blob_count_ = 0;
+    size_t commit_count_ = 0;
+};
+
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <filesystem>
+#include <memory>
+#include <istream>
+#include <optional>
+#include <cstdint>
+
+#include "ChangedPathBloom.h"
+#include "Chunker.h"
+
+namespace Biogit {
+
+class Repository;
+
+/**
+ * @brief 批量导入流 (fast-import) 的解析与执行。
+ * @details
+ *  从输入流读取按行组织的命令 (与 git fast-import 的常用子集兼容)：\n
+ *      blob \n mark :<n> \n data <字节数>\n<内容>\n
+ *      commit <引用> \n [mark :<n>] \n [author <姓名> <<邮箱>> <秒> <时区>] \n committer ... \n data ... \n
+ *          [from <提交>] \n [merge <提交>]... \n (M <模式> (:<n> | <哈希> | inline) <路径> | D <路径> | deleteall)...\n
+ *      reset <引用> \n [from <提交>] \n
+ *      progress <文本> \n checkpoint \n done \n
+ *  <提交> 可以是 :<标记>、40 位哈希、本次导入中的引用或仓库中已有的分支/标签。
+ *  data 也支持 "data <<<分隔符>" 形式。路径可用 C 风格引号包围。\n
+ *  每个分支在内存中保存一棵树：只有被修改的目录会被读入和重建，未修改的子树直接沿用原哈希。
+ *  对象直接写入对象库，不经过索引和工作区；引用在流结束后统一更新。
+ */
+class FastImporter {
+public:
+    /**
+     * @param repo 目标仓库。
+     * @param force 为 true 时允许非快进地覆盖已有引用。
+     */
+    FastImporter(Repository& repo, bool force);
+    ~FastImporter();
+
+    /**
+     * @brief 读取并执行整个导入流，最后更新引用。
+     * @return 全部成功返回 true；遇到格式错误或写入失败时返回 false (已更新的引用不回滚，未执行的命令被丢弃)。
+     */
+    bool run(std::istream& in);
+
+private:
+    struct TreeNode;
+
+    /// 内存中的目录条目：文件记录模式和 Blob 哈希；目录另有子树节点
+    struct TreeNodeEntry {
+        std::string mode;
+        std::string hash;
+        std::unique_ptr<TreeNode> subtree;
+    };
+
+    /// 内存中的目录：hash 非空表示内容与对象库中的该 Tree 一致；entries 只在需要时从对象库读入
+    struct TreeNode {
+        std::string hash;
+        bool loaded = false;
+        std::map<std::string, TreeNodeEntry> entries;
+    };
+
+    /// 导入过程中一个引用的状态
+    struct BranchState {
+        std::string commit_hash;
+        std::unique_ptr<TreeNode> root;
+    };
+
+    bool read_line(std::istream& in, std::string& line);
+    bool read_data(std::istream& in, const std::string& data_line, std::string& out_data);
+    bool error(const std::string& message);
+
+    bool parse_blob(std::istream& in);
+    bool parse_commit(std::istream& in, const std::string& ref_name);
+    bool parse_reset(std::istream& in, const std::string& ref_name);
+
+    std::optional<std::string> resolve_commit(const std::string& commit_ish);
+    std::optional<std::string> resolve_data_ref(const std::string& data_ref);
+    std::optional<std::string> store_blob(const std::string& data);
+    std::optional<std::uint64_t> parse_mark(const std::string& text) const;
+    std::optional<std::string> parse_path(const std::string& text) const;
+
+    bool load_node(TreeNode& node);
+    bool set_path(TreeNode& root, const std::string& path, const std::string& mode, const std::string& hash);
+    bool remove_path(TreeNode& node, const std::string& path);
+    std::optional<std::string> write_node(TreeNode& node);
+    BranchState& branch_state(const std::string& ref_name);
+
+    bool update_refs();
+
+    Repository& repo_;
+    bool force_;
+    std::filesystem::path objects_dir_;
+    uintmax_t chunk_threshold_;
+    FastCdcChunker chunker_;
+    ChangedPathBloomStore bloom_store_;
+
+    std::map<std::uint64_t, std::string> marks_;          ///< 标记 -> 对象哈希
+    std::map<std::string, BranchState> branches_;         ///< 引用全名 -> 状态
+    std::string pending_line_;                            ///< 预读的一行 (命令结束时读到的下一条命令)
+    bool has_pending_line_ = false;
+    size_t line_number_ = 0;
+    size_t blob_count_ = 0;
+    size_t commit_count_ = 0;
+    size_t ref_count_ = 0;                                ///< 实际更新的引用数
+};
+
+}
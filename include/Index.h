@@ -3,6 +3,9 @@
 #include <unordered_set>
 #include <filesystem>
 #include <chrono>
+#include <unordered_map>
+
+#include "PathTable.h"
 
 namespace Biogit {
 using std::string;
@@ -16,6 +19,7 @@ struct IndexEntry {
     std::chrono::system_clock::time_point mtime; // 文件最后修改时间
     uint64_t file_size;                 // 文件大小 (字节)
     std::filesystem::path file_path;    // 文件路径 (相对于工作树根目录，已规范化)
+    PathTable::PathId path_id = PathTable::ROOT; // 文件路径在所属 Index 路径表中的 ID (排序和查找都用它)
 
     // 用于 std::sort 和 std::vector 操作的比较运算符
     bool operator<(const IndexEntry& other) const {
@@ -39,11 +43,17 @@ struct IndexEntry {
 class Index {
 private:
     std::filesystem::path index_file_path_; // .biogit/index 文件的完整路径
-    std::vector<IndexEntry> entries_;       // 内存中存储的索引条目
+    PathTable paths_;                       // 条目路径的驻留表
+    mutable std::vector<IndexEntry> entries_; // 内存中存储的索引条目 (读取前按路径排序)
+    mutable std::unordered_map<PathTable::PathId, size_t> slots_; // 路径 ID -> entries_ 中的下标
+    mutable bool sorted_ = true;            // entries_ 是否已按路径排序
     bool loaded_ = false;                   // 标记索引是否已从磁盘加载
 
-    // 确保内部条目按文件路径排序
-    void sort_entries_();
+    // 确保内部条目按文件路径排序 (新增条目只追加到末尾，读取全部条目或写回前才排序一次)
+    void sort_entries_() const;
+
+    // 按路径 ID 添加或替换条目
+    void put_entry_(IndexEntry&& entry);
 
 public:
     /**
@@ -61,11 +71,21 @@ public:
 
     /**
      * @brief 将内存中的索引条目写回到磁盘上的 .biogit/index 文件。
-     * 所有修改 entries_的都sort 所以write内部不需要sort
+     * 写回前按路径排序 (新增条目只追加，此时才统一排序)
      * @return 如果写入成功，返回 true；否则返回 false。
      */
     bool write() const;
 
+    /**
+     * @brief 条目路径的驻留表 (IndexEntry::path_id 在此表中解析)。
+     */
+    const PathTable& paths() const { return paths_; }
+
+    /**
+     * @brief 在路径表中驻留 parent 目录下名为 name 的路径，返回其 ID (用于按目录逐级填充索引)。
+     */
+    PathTable::PathId intern_path(PathTable::PathId parent, std::string_view name) { return paths_.intern_child(parent, name); }
+
     /**
      * @brief 向索引中添加或更新一个文件条目。
      * @param relative_path 规范化的、相对于工作树根目录的文件路径。
@@ -82,6 +102,15 @@ public:
                              const std::chrono::system_clock::time_point& mtime,
                              uint64_t file_size);
 
+    /**
+     * @brief 同上，路径以本索引路径表中的 ID 给出 (见 intern_path)。
+     */
+    bool add_or_update_entry(PathTable::PathId path_id,
+                             const std::string& blob_hash_hex,
+                             const std::string& file_mode,
+                             const std::chrono::system_clock::time_point& mtime,
+                             uint64_t file_size);
+
     /**
      * @brief 从索引中移除一个文件条目。
      * @param relative_path 要移除的文件的路径 (相对于工作树根目录，已规范化)。
@@ -98,6 +127,12 @@ public:
       */
     std::optional<IndexEntry> get_entry(const std::filesystem::path& relative_path) const;
 
+    /**
+     * @brief 同 get_entry，但不复制条目：返回指向索引内条目的指针，找不到时返回 nullptr。
+     * 指针在索引被修改 (或新增条目后首次排序) 之前有效。
+     */
+    const IndexEntry* find_entry(const std::filesystem::path& relative_path) const;
+
     /**
      * @brief 获取所有索引条目的常量引用。
      * 调用者应确保索引已加载。
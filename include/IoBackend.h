@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Biogit {
+
+/**
+ * @brief 批量文件 I/O 后端：一次提交一批 stat / 读取 / 写入，由后端决定同时进行多少个 (队列深度)。
+ * @details
+ *  status、add 和检出 (_update_working_directory_from_tree) 逐个文件执行阻塞的 stat、open、read、write 时，
+ *  NVMe 和网络文件系统的吞吐受限于队列深度 1。两个实现：\n
+ *  - ThreadPool：在 OrderedTaskPool 的工作线程上执行普通的阻塞系统调用，队列深度即线程数；\n
+ *  - IoUring：用 io_uring (直接调用 io_uring_setup / io_uring_enter，不依赖 liburing) 批量提交
+ *    statx、openat、read、write、close，队列深度即环的大小，只占用调用线程。\n
+ *  内核不支持 io_uring (或被 seccomp 禁止) 时 create 自动退回线程池。
+ *  每个批量操作的结果与输入按下标一一对应；单个文件失败不影响其余文件。
+ */
+class IoBackend {
+public:
+    enum class Kind {
+        Auto,       ///< 支持时使用 io_uring，否则使用线程池
+        ThreadPool, ///< 线程池 + 阻塞系统调用
+        IoUring,    ///< io_uring 批量提交
+    };
+
+    /// stat 的结果 (跟随符号链接)
+    struct FileStat {
+        bool is_regular_file = false;
+        uint64_t size = 0;
+        std::filesystem::file_time_type mtime; ///< 与 std::filesystem::last_write_time 返回值相同
+    };
+
+    /// 一个写入请求：创建或截断 path 后写入 [data, data + size)；data 在调用期间必须有效
+    struct WriteRequest {
+        std::filesystem::path path;
+        const std::byte* data = nullptr;
+        size_t size = 0;
+    };
+
+    virtual ~IoBackend() = default;
+
+    /**
+     * @brief 创建后端。
+     * @param kind 后端种类；要求 IoUring 但当前系统不可用时退回线程池 (可由 kind() 查看实际使用的后端)。
+     * @param queue_depth 同时进行的操作数，0 表示使用硬件并发数 (io_uring 取其 4 倍，至少 32)。
+     */
+    static std::unique_ptr<IoBackend> create(Kind kind = Kind::Auto, size_t queue_depth = 0);
+
+    /// 解析配置值 "auto" / "threads" / "io_uring"，无法识别时返回 std::nullopt
+    static std::optional<Kind> parse_kind(const std::string& value);
+
+    /// 当前系统能否使用 io_uring 后端
+    static bool io_uring_available();
+
+    /// 实际使用的后端种类 (ThreadPool 或 IoUring)
+    virtual Kind kind() const = 0;
+
+    /// 后端名称 ("threads" / "io_uring")，用于提示和基准测试输出
+    virtual const char* name() const = 0;
+
+    virtual size_t queue_depth() const = 0;
+
+    /**
+     * @brief 批量 stat；路径不存在或无法访问时对应结果为 std::nullopt。
+     */
+    virtual std::vector<std::optional<FileStat>> stat_files(const std::vector<std::filesystem::path>& paths) = 0;
+
+    /**
+     * @brief 批量读取整个文件；无法打开、不是常规文件或读取出错时对应结果为 std::nullopt。
+     * @details 读取的长度以打开时的文件大小为准 (与 seekg/tellg 后整体读取相同)，读取中途遇到文件末尾时截短。
+     */
+    virtual std::vector<std::optional<std::vector<std::byte>>> read_files(const std::vector<std::filesystem::path>& paths) = 0;
+
+    /**
+     * @brief 批量写入文件 (不存在时以 0666 & ~umask 创建，存在时截断)；父目录必须已存在。
+     * @return 每个请求是否完整写入并成功关闭。
+     */
+    virtual std::vector<bool> write_files(const std::vector<WriteRequest>& requests) = 0;
+};
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <filesystem>
+#include <cstdint>
+
+namespace Biogit {
+
+/**
+ * @brief 大文件指针：代替大文件内容存入 Tree 的小 Blob。
+ * @details 文本格式 (每行以 '\n' 结尾)：
+ *      version biogit-lfs/1
+ *      oid sha1:<内容的40位SHA-1>
+ *      size <内容字节数>
+ */
+struct LfsPointer {
+    static const std::string VERSION_LINE; ///< 指针文件的首行
+    static constexpr size_t MAX_POINTER_SIZE = 200; ///< 指针文本的最大长度，超过则一定不是指针
+
+    std::string oid;   ///< 内容的 SHA-1 (40位十六进制)
+    uintmax_t size = 0; ///< 内容字节数
+
+    /// 序列化为指针文本
+    std::string serialize() const;
+
+    /// 从 Blob 内容解析指针；不是指针时返回 std::nullopt
+    static std::optional<LfsPointer> parse(const std::string& content);
+};
+
+/**
+ * @brief 本地大文件内容库 (.biogit/lfs/)。
+ * @details
+ *  内容按 SHA-1 寻址存放在 lfs/objects/<oid前2位>/<oid第3-4位>/<oid>。\n
+ *  所有读写都以固定大小的块进行，不会把整个大文件读入内存；
+ *  传输时接收方先把数据追加到 lfs/incoming/<oid>.part，收齐并校验哈希后再移入内容库。
+ */
+class LfsStore {
+public:
+    static const std::string DIR_NAME;              ///< lfs 目录名 (位于 .biogit/ 下)
+    static constexpr size_t BLOCK_SIZE = 1024 * 1024; ///< 流式读写与网络传输的块大小
+
+    explicit LfsStore(std::filesystem::path biogit_dir);
+
+    /// 内容在库中的路径
+    std::filesystem::path object_path(const std::string& oid) const;
+
+    /// 库中是否已有该内容
+    bool contains(const std::string& oid) const;
+
+    /**
+     * @brief 计算文件内容对应的指针 (流式计算哈希，不写入内容库)。
+     */
+    static std::optional<LfsPointer> pointer_for_file(const std::filesystem::path& file_path);
+
+    /**
+     * @brief 将文件内容存入内容库并返回其指针 (内容已存在时只计算哈希)。
+     */
+    std::optional<LfsPointer> store_file(const std::filesystem::path& file_path) const;
+
+    /**
+     * @brief 把指针对应的内容写到工作区文件。
+     * @param use_hardlink 为 true 时优先创建指向内容库的硬链接 (失败则回退为复制)。
+     * @return 内容库中没有该内容或写入失败时返回 false。
+     */
+    bool materialize(const LfsPointer& pointer, const std::filesystem::path& destination, bool use_hardlink) const;
+
+    /**
+     * @brief 读取内容库中某个内容从 offset 开始的至多 max_length 字节 (用于分块发送)。
+     */
+    std::optional<std::vector<char>> read_block(const std::string& oid, uintmax_t offset, size_t max_length) const;
+
+    /**
+     * @brief 接收一块数据并追加到未完成的内容文件中；收齐 total_size 字节后校验哈希并移入内容库。
+     * @param offset 必须等于已接收的字节数 (offset 为 0 时重新开始)。
+     * @return 数据被接受时返回 true；偏移不连续、写入失败或最终哈希不匹配时返回 false。
+     */
+    bool receive_block(const std::string& oid, uintmax_t offset, uintmax_t total_size, const char* data, size_t length) const;
+
+private:
+    std::filesystem::path lfs_dir_;
+};
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <filesystem>
+
+namespace Biogit {
+
+class Repository;
+
+/**
+ * @brief 仓库的本地常驻进程 (biogit2 daemon start)：只读命令交给它执行，省去每次启动进程、读取索引和展开 HEAD 树的开销。
+ * @details
+ *  常驻进程在 .biogit/daemon.sock 上监听 (Unix 域套接字，仅属主可访问)，一次处理一个请求。
+ *  每个请求都重新加载 Repository (只是解析几个路径)，因此 HEAD、引用、配置和工作区总是最新的；
+ *  跨请求保留的是进程内缓存：已展开的 Tree (按哈希，永不过期)、已解析的索引 (按索引文件的修改时间、状态改变时间、inode 和大小失效)、
+ *  引用文件内容 (同样按文件身份失效，最多 REF_CACHE_ENTRIES 个)、已校验的 Commit / Tree 对象 (最多 OBJECT_CACHE_BYTES 字节)、
+ *  alternates 等，以及已经读过的对象文件所在的页缓存。后两者只在常驻进程中启用，且都有上限，长时间运行也不会无限增长。\n
+ *  请求：<u32 字符串个数> 之后每个字符串为 <u32 长度><字节>，依次为 客户端工作目录、命令、参数...\n
+ *  响应：若干 'o' <u32 长度><输出字节> 帧，最后是 'x' <i32 退出码>。整数均为本机字节序 (两端总在同一台机器上)。\n
+ *  常驻进程定期检查套接字文件，文件被删除 (例如仓库被删除) 后自行退出。
+ */
+class LocalDaemon {
+public:
+    /// 套接字文件名 (位于 .biogit 目录，链接工作树位于其管理目录)
+    static const std::string SOCKET_FILE_NAME;
+
+    static constexpr size_t REF_CACHE_ENTRIES = 1024;              ///< 常驻进程缓存的引用文件个数上限
+    static constexpr size_t OBJECT_CACHE_BYTES = 64 * 1024 * 1024; ///< 常驻进程缓存的已校验对象内容总字节数上限
+
+    /// 常驻进程执行一条命令：返回退出码，输出写到 std::cout / std::cerr
+    using CommandHandler = std::function<int(Repository& repo, const std::string& command, const std::vector<std::string>& args)>;
+
+    /**
+     * @brief 在后台启动仓库的常驻进程 (已在运行时直接返回成功)。
+     * @details 父进程绑定好套接字后才 fork，返回时常驻进程已经可以接受连接。
+     * @param repo 要服务的仓库。
+     * @param handler 执行命令的函数。
+     * @return 启动成功或已在运行返回 true；否则返回 false。
+     */
+    static bool start(const Repository& repo, CommandHandler handler);
+
+    /**
+     * @brief 通知常驻进程退出。
+     * @return 常驻进程已确认退出返回 true；没有在运行返回 false。
+     */
+    static bool stop(const std::filesystem::path& mygit_dir);
+
+    /// 常驻进程是否在运行 (能否连接)
+    static bool is_running(const std::filesystem::path& mygit_dir);
+
+    /**
+     * @brief 把命令交给常驻进程执行，输出原样写到 std::cout。
+     * @return 常驻进程执行完毕时返回其退出码；没有常驻进程或无法连接时返回 std::nullopt (调用者在本进程执行)。
+     */
+    static std::optional<int> forward(const std::filesystem::path& mygit_dir, const std::string& command,
+                                      const std::vector<std::string>& args);
+};
+
+}
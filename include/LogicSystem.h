@@ -7,6 +7,7 @@
 namespace Biogit {
 class Csession;
 class LogicNode;
+class Repository;
 
 class LogicSystem : public Singleton<LogicSystem> {
     friend class Singleton<LogicSystem>;     // 允许 Singleton 模板访问其私有构造函数
@@ -52,9 +53,20 @@ private:
     void HandleReqCheckObjects(std::shared_ptr<Csession> session, uint16_t msg_id, const char* body_data, uint32_t body_length);
     void HandleReqPutObject(std::shared_ptr<Csession> session, uint16_t msg_id, const char* body_data, uint32_t body_length);
     void HandleReqUpdateRef(std::shared_ptr<Csession> session, uint16_t msg_id, const char* body_data, uint32_t body_length);
+    void HandleReqLfsCheck(std::shared_ptr<Csession> session, uint16_t msg_id, const char* body_data, uint32_t body_length);
+    void HandleReqLfsPutBlock(std::shared_ptr<Csession> session, uint16_t msg_id, const char* body_data, uint32_t body_length);
+    void HandleReqLfsGetBlock(std::shared_ptr<Csession> session, uint16_t msg_id, const char* body_data, uint32_t body_length);
+    void HandleReqDictNegotiate(std::shared_ptr<Csession> session, uint16_t msg_id, const char* body_data, uint32_t body_length);
+    void HandleReqDictGet(std::shared_ptr<Csession> session, uint16_t msg_id, const char* body_data, uint32_t body_length);
+    void HandleReqPutObjectDeflated(std::shared_ptr<Csession> session, uint16_t msg_id, const char* body_data, uint32_t body_length);
+    void HandleReqPutObjectDelta(std::shared_ptr<Csession> session, uint16_t msg_id, const char* body_data, uint32_t body_length);
     void HandleReqRegisterUser(std::shared_ptr<Csession> session, uint16_t msg_id, const char* body_data, uint32_t body_length);
     void HandleReqLoginUser(std::shared_ptr<Csession> session, uint16_t msg_id, const char* body_data, uint32_t body_length);
 
+    // 辅助函数, 校验上传对象的哈希并写入仓库 (各种 PUT_OBJECT 请求共用)
+    void StoreUploadedObject(std::shared_ptr<Csession> session, std::shared_ptr<Repository> active_repo,
+                             const std::string& object_hash_from_client, const char* object_raw_data, uint32_t object_data_len);
+
     // 辅助函数, 处理Token
     std::tuple<std::string, const char*, uint32_t> extractTokenAndPayload(const char* body_data_with_token, uint32_t body_length_with_token);
     bool authenticateAndPreparePayload(
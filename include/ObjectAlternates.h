@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+namespace Biogit {
+
+/**
+ * @brief 备用对象库 (alternates)：仓库可以只读地引用其他对象目录中的对象。
+ * @details
+ *  对象目录下的 info/alternates 文件每行记录一个备用对象目录 (绝对路径，或相对于本对象目录的路径；
+ *  空行和 '#' 开头的行忽略)。查找对象时先查本仓库，再依次查各备用目录；备用目录自身的 alternates
+ *  也会被递归读取 (最多 MAX_DEPTH 层)。写入对象时，只要任一目录已有该对象就不再写入本仓库。\n
+ *  服务器上同一参考仓库的多个 fork 共享一个对象池，相同的对象只存一份，也只占一份页缓存。
+ */
+namespace ObjectAlternates {
+
+/// alternates 文件相对于对象目录的路径
+inline constexpr const char* FILE_NAME = "info/alternates";
+
+/// 递归读取 alternates 的最大层数
+inline constexpr int MAX_DEPTH = 5;
+
+/**
+ * @brief 列出对象目录的所有备用目录 (按查找顺序，已去重，不含 objects_dir 本身)。
+ * @details 结果缓存在进程内，以递归读取过的每个 alternates 文件 (含各备用目录自身的) 的修改时间为准：
+ *  其中任一文件被修改、创建或删除后重新读取。
+ */
+std::vector<std::filesystem::path> list(const std::filesystem::path& objects_dir);
+
+/**
+ * @brief 对象文件的路径：本仓库存在则返回本仓库中的路径，否则返回第一个包含该对象的备用目录中的路径；
+ *        都不存在时返回本仓库中的路径 (调用者据此判断对象不存在或作为写入位置)。
+ */
+std::filesystem::path locate(const std::filesystem::path& objects_dir, const std::string& hash_hex);
+
+/**
+ * @brief 对象是否存在于本仓库或任一备用目录中。
+ */
+bool contains(const std::filesystem::path& objects_dir, const std::string& hash_hex);
+
+/**
+ * @brief 把 alternate_objects_dir 加入 objects_dir 的备用目录 (已存在时不重复添加)。
+ * @return 写入成功或已存在返回 true。
+ */
+bool add(const std::filesystem::path& objects_dir, const std::filesystem::path& alternate_objects_dir);
+
+}
+
+}
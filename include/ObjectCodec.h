@@ -0,0 +1,109 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <filesystem>
+#include <cstddef>
+#include <cstdint>
+
+namespace Biogit {
+
+/**
+ * @brief 对象内容编解码器接口 (位于对象库存储层之下)。
+ * @details
+ *  编解码器只改变对象在磁盘上的存储形式：对象哈希始终按规范格式 "type size\0content" 计算，
+ *  decode(encode(x)) 必须与 x 逐字节相同。网络传输和哈希校验使用的都是还原后的规范字节。
+ */
+class ObjectCodec {
+public:
+    virtual ~ObjectCodec() = default;
+
+    /// 写入存储头部的编解码器编号 (一经发布不可更改)
+    virtual uint8_t id() const = 0;
+
+    /// 编解码器名称 (用于提示信息)
+    virtual const char* name() const = 0;
+
+    /**
+     * @brief 内容嗅探：判断内容是否适合用此编解码器编码。
+     * @param path_hint 文件路径 (可为空)；扩展名匹配时放宽嗅探条件。
+     */
+    virtual bool accepts(const std::byte* data, size_t size, const std::filesystem::path& path_hint) const = 0;
+
+    /**
+     * @brief 编码对象内容 (不含对象头部)。内容不符合此编解码器的格式要求时返回 std::nullopt。
+     */
+    virtual std::optional<std::vector<std::byte>> encode(const std::byte* data, size_t size) const = 0;
+
+    /**
+     * @brief 还原对象内容。数据损坏时返回 std::nullopt。
+     */
+    virtual std::optional<std::vector<std::byte>> decode(const std::byte* data, size_t size) const = 0;
+};
+
+
+/**
+ * @brief FASTA/FASTQ 序列编解码器。
+ * @details
+ *  把文本拆成几个独立的流分别存储：
+ *  - 碱基：A/C/G/T 以 2 bit 打包；其余字符 (N、IUPAC 简并碱基等) 记入例外列表 (按相同字符的连续段记录)；
+ *  - 大小写：软屏蔽的小写区段以交替的段长度记录；
+ *  - 行布局：序列行长度按 “长度 × 连续行数” 游程编码，FASTA 中穿插标题行标记；
+ *  - 标题行、FASTQ 的 '+' 行和质量值：各自单独用 zlib 压缩。\n
+ *  含 '\r' 的内容、不满足严格 4 行记录格式的 FASTQ 不编码 (保持原样存储)。
+ */
+class SequenceCodec : public ObjectCodec {
+public:
+    uint8_t id() const override { return 1; }
+    const char* name() const override { return "sequence"; }
+    bool accepts(const std::byte* data, size_t size, const std::filesystem::path& path_hint) const override;
+    std::optional<std::vector<std::byte>> encode(const std::byte* data, size_t size) const override;
+    std::optional<std::vector<std::byte>> decode(const std::byte* data, size_t size) const override;
+};
+
+
+/**
+ * @brief 对象存储层的编解码器注册表与读写入口。
+ * @details
+ *  经编码存储的对象文件格式：MAGIC (4字节) + 编解码器编号 (1字节) + 规范对象头部 "type size\0" + 编码后的内容。\n
+ *  规范对象文件总以类型名开头，不会以 '\0' 开头，因此读取时可以凭首字节区分两种形式。
+ */
+namespace ObjectCodecs {
+
+/// 经编码存储的对象文件的前缀
+inline constexpr char MAGIC[4] = {'\0', 'B', 'G', 'C'};
+
+/// 小于此大小的对象不尝试编码
+inline constexpr size_t MIN_ENCODE_SIZE = 256;
+
+/// 按编号查找编解码器，未知编号返回 nullptr
+const ObjectCodec* find(uint8_t id);
+
+/// 按内容嗅探和路径选择编解码器，没有合适的返回 nullptr
+const ObjectCodec* select(const std::byte* data, size_t size, const std::filesystem::path& path_hint);
+
+/**
+ * @brief 把规范对象字节 ("type size\0content") 转换为磁盘存储字节。
+ * @details
+ *  blob/chunk 按内容选择编解码器；给出 objects_dir 且仓库有当前字典时，小型 Tree/Commit
+ *  以预设字典压缩 (编号 ZlibDictionaries::CODEC_ID，编码内容为 4 字节字典编号 + raw deflate 数据)。\n
+ *  编码失败、往返校验不一致或没有体积收益时原样返回。
+ */
+std::vector<std::byte> encode_for_storage(const std::vector<std::byte>& object_bytes,
+                                          const std::filesystem::path& path_hint = {},
+                                          const std::filesystem::path& objects_dir = {});
+
+/**
+ * @brief 把磁盘存储字节还原为规范对象字节 (未编码的内容原样返回)。数据损坏或编解码器未知时返回 std::nullopt。
+ * @param objects_dir 对象库目录，还原字典压缩的对象时用于查找字典。
+ */
+std::optional<std::vector<std::byte>> decode_from_storage(const std::vector<std::byte>& stored_bytes,
+                                                          const std::filesystem::path& objects_dir = {});
+
+/// 读取对象文件并还原为规范对象字节 (对象库目录由文件路径 objects/xx/rest 推出)
+std::optional<std::vector<std::byte>> read_object_file(const std::filesystem::path& file_path);
+
+}
+
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <filesystem>
+#include <cstddef>
+#include <variant>
+
+#include "sha1.h"
+#include "sha256.h"
+#include "blake3.h"
+
+namespace Biogit {
+
+/**
+ * @brief 对象格式 (对象哈希算法)：仓库在 init 时选定，之后不可更改。
+ * @details
+ *  SHA-1 仓库 (默认) 的配置与以前完全相同。选择其他算法时，init 写入
+ *  core.repositoryFormatVersion = 1 和 extensions.objectFormat = <算法名>；
+ *  不认识的格式版本或扩展的仓库拒绝加载，旧版本程序也不会把它当作 SHA-1 仓库读写。\n
+ *  - sha1：40 位十六进制，与 Git 兼容；
+ *  - sha256：64 位十六进制；
+ *  - blake3：64 位十六进制，单线程也比 SHA-1 快，大对象按 BLAKE3 的树结构在多个核上并行计算。\n
+ *  算法按对象目录登记在进程内 (Repository 加载时登记本仓库及其备用对象库，共享对象池在移入对象时登记)，
+ *  只拿到对象目录的对象读写函数据此计算哈希；查询未登记的目录是程序错误，不会按 SHA-1 猜测。
+ *  两个仓库的对象格式不同时，它们之间不能传输对象，也不能共享备用对象库。
+ */
+namespace ObjectFormat {
+
+/// 配置项：仓库格式版本 (使用扩展时为 1)
+inline constexpr const char* VERSION_KEY = "core.repositoryFormatVersion";
+
+/// 配置项：对象格式扩展
+inline constexpr const char* CONFIG_KEY = "extensions.objectFormat";
+
+/// 本程序支持的最高仓库格式版本
+inline constexpr int MAX_REPOSITORY_FORMAT_VERSION = 1;
+
+/// 对象哈希算法
+enum class Algorithm {
+    SHA1,
+    SHA256,
+    BLAKE3
+};
+
+/// 算法名称 (配置值和命令行参数中使用)
+const char* name(Algorithm algorithm);
+
+/// 由名称解析算法；不认识时返回 std::nullopt
+std::optional<Algorithm> parse(const std::string& name);
+
+/// 十六进制对象 ID 的长度 (SHA-1 为 40，其余为 64)
+size_t hex_length(Algorithm algorithm);
+
+/// 长度是否为某种对象格式的十六进制对象 ID 长度
+bool is_id_length(size_t length);
+
+/// 是否为完整的十六进制对象 ID (长度合法且全部为十六进制字符)
+bool is_hex_id(const std::string& text);
+
+/// 登记对象目录使用的算法
+void set_algorithm(const std::filesystem::path& objects_dir, Algorithm algorithm);
+
+/// 对象目录登记的算法；未登记时返回 std::nullopt
+std::optional<Algorithm> find_algorithm(const std::filesystem::path& objects_dir);
+
+/// 对象目录使用的算法；目录未登记时抛出 std::logic_error
+Algorithm algorithm_of(const std::filesystem::path& objects_dir);
+
+/// 用指定算法计算规范对象字节 ("type size\0content") 的十六进制哈希
+std::string hash(Algorithm algorithm, const std::vector<std::byte>& object_bytes);
+
+/// 用对象目录登记的算法计算规范对象字节的十六进制哈希
+std::string hash(const std::filesystem::path& objects_dir, const std::vector<std::byte>& object_bytes);
+
+/**
+ * @brief 按指定算法增量计算哈希 (流式计算工作区大文件的对象哈希，无需读入全部内容)。
+ */
+class Hasher {
+public:
+    explicit Hasher(Algorithm algorithm);
+
+    /// 追加数据
+    void update(const void* data, size_t length);
+
+    /// 结束计算并返回十六进制哈希 (调用后对象不应再使用)
+    std::string hex_digest();
+
+private:
+    std::variant<SHA1::Hasher, SHA256::Hasher, BLAKE3::Hasher> state_;
+};
+
+}
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <filesystem>
+#include <cstddef>
+
+namespace Biogit {
+
+/**
+ * @brief 对象库的写入层：对象文件要么完整存在，要么不存在。
+ * @details
+ *  内容先写入扇出子目录 (objects/ab/) 中的匿名临时文件 (O_TMPFILE)，写完后用 linkat 一次性给它对象文件名；
+ *  文件系统不支持 O_TMPFILE 时改为写入唯一命名的临时文件再 renameat。同名对象已存在 (EEXIST，
+ *  例如并发写入者先完成) 视为成功——对象按内容寻址，已存在的文件内容必然相同。\n
+ *  每个对象目录和已打开的扇出子目录的文件描述符缓存在进程内 (最多 MAX_CACHED_DIRS 个对象目录)，
+ *  写一个对象只需 open/write/linkat/close，不再逐个检查和创建目录。\n
+ *  持久化方式由配置项 core.fsyncObjects 决定：
+ *  - false (默认)：不主动刷盘。进程崩溃不会留下半截对象，但掉电时刚写入的对象可能丢失或为空；
+ *  - batch：每个对象写完后只发起回写，一次操作结束、移动引用之前对整个文件系统 syncfs 一次；
+ *    掉电只会影响尚未被任何引用指向的对象；
+ *  - true：每个对象 fdatasync 之后才给它文件名，掉电也不会出现内容不完整的对象文件。
+ */
+namespace ObjectWriter {
+
+/// 配置项名称
+inline constexpr const char* CONFIG_KEY = "core.fsyncObjects";
+
+/// 同时缓存文件描述符的对象目录个数 (服务器上有多个仓库时淘汰最久未用的)
+inline constexpr size_t MAX_CACHED_DIRS = 4;
+
+/// 持久化方式
+enum class Durability {
+    NONE,   ///< 不主动刷盘
+    BATCH,  ///< 每次操作结束时 syncfs 一次
+    EACH    ///< 每个对象 fdatasync
+};
+
+/// 解析配置值 (false/batch/true，未设置或无法识别时为 NONE)
+Durability parse_durability(const std::optional<std::string>& value);
+
+/// 设置对象目录的持久化方式 (Repository 加载时按配置设置)
+void set_durability(const std::filesystem::path& objects_dir, Durability durability);
+
+/**
+ * @brief 把已编码的对象存储字节写到 objects_dir 中 hash_hex 对应的位置。
+ * @details 不检查备用对象库：调用者应先用 ObjectAlternates::contains 判断对象是否已存在。
+ * @return 写入成功或对象已存在返回 true；失败时打印错误并返回 false (不会留下临时文件或半截对象)。
+ */
+bool write(const std::filesystem::path& objects_dir, const std::string& hash_hex, const std::vector<std::byte>& stored_bytes);
+
+/**
+ * @brief 用新的存储字节替换 objects_dir 中已有的对象文件 (例如 gc 换用新的压缩字典重新编码)。
+ * @details 内容写入唯一命名的临时文件后 renameat 原子替换，读者只会看到旧文件或新文件；
+ *  持久化方式与 write 相同，batch 模式下同样需要之后调用 sync。
+ * @return 替换成功返回 true；失败时打印错误并返回 false (原对象文件保持不变)。
+ */
+bool rewrite(const std::filesystem::path& objects_dir, const std::string& hash_hex, const std::vector<std::byte>& stored_bytes);
+
+/**
+ * @brief batch 模式下，把本进程写入 objects_dir 的对象刷到磁盘 (syncfs)；没有待刷的对象或其他模式下直接返回。
+ * @details 在移动引用 (分支、索引、远程跟踪分支等) 之前调用，保证引用指向的对象已经落盘。
+ * @return 刷盘成功或无需刷盘返回 true。
+ */
+bool sync(const std::filesystem::path& objects_dir);
+
+}
+
+}
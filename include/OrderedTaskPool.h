@@ -0,0 +1,42 @@
+#pragma once
+
+#include <functional>
+#include <ostream>
+#include <vector>
+#include <cstddef>
+
+namespace Biogit {
+
+/**
+ * @brief 按提交顺序输出结果的并行任务池 (用于多文件 diff 等 “并行计算、顺序输出” 的场景)。
+ * @details
+ *  每个任务把输出写入自己的缓冲区；工作线程从任务列表中依次领取任务并行执行，
+ *  调用线程则按任务下标顺序把缓冲区写入目标流，因此输出与串行执行完全一致。\n
+ *  已完成但尚未输出的任务数不超过 max_buffered，避免前面的大文件阻塞时后面的结果无限堆积在内存中。\n
+ *  只有一个任务或只有一个线程时直接在调用线程中串行执行，不创建线程。
+ */
+class OrderedTaskPool {
+public:
+    /// 一个任务：把结果写入给定的输出流
+    using Task = std::function<void(std::ostream& out)>;
+
+    /**
+     * @param num_threads 工作线程数，0 表示使用硬件并发数。
+     * @param max_buffered 最多缓冲的任务结果数，0 表示线程数的 4 倍。
+     */
+    explicit OrderedTaskPool(size_t num_threads = 0, size_t max_buffered = 0);
+
+    /**
+     * @brief 并行执行所有任务，并按下标顺序把结果写入 out。
+     * @details 任务抛出的异常会被捕获并打印到 std::cerr，不影响其余任务。
+     */
+    void run(const std::vector<Task>& tasks, std::ostream& out) const;
+
+    size_t thread_count() const { return num_threads_; }
+
+private:
+    size_t num_threads_;
+    size_t max_buffered_;
+};
+
+}
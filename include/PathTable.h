@@ -0,0 +1,107 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <filesystem>
+#include <cstdint>
+
+namespace Biogit {
+
+/**
+ * @brief 路径驻留表：把相对于工作树根目录的路径表示为 (父目录 ID, 名称) 的紧凑节点。
+ * @details
+ *  每个路径组件 (目录或文件名) 只存一份：名称保存在按块分配的内存区 (arena) 中，
+ *  节点只记录父节点 ID、深度和指向内存区的 string_view。同一目录下的大量文件共享父目录节点，
+ *  相等比较就是比较两个整数；排序 (less) 按路径组件逐级比较，结果与 std::filesystem::path 的 operator< 相同。\n
+ *  ID 在表的生命周期内稳定 (clear 之前不会改变)，父节点的 ID 总是小于子节点；复制表时按 ID 顺序重建，ID 保持不变。
+ */
+class PathTable {
+public:
+    using PathId = uint32_t;
+
+    /// 根目录 (空路径) 的 ID
+    static constexpr PathId ROOT = 0;
+
+    PathTable();
+    PathTable(const PathTable& other);
+    PathTable& operator=(const PathTable& other);
+    PathTable(PathTable&& other) noexcept = default;
+    PathTable& operator=(PathTable&& other) noexcept = default;
+
+    /**
+     * @brief 驻留一个相对路径 ('/' 分隔，空组件和 "." 忽略)，返回其 ID；空路径返回 ROOT。
+     */
+    PathId intern(std::string_view relative_path);
+
+    /**
+     * @brief 驻留 parent 目录下名为 name 的条目，返回其 ID。
+     */
+    PathId intern_child(PathId parent, std::string_view name);
+
+    /**
+     * @brief 查找已驻留的路径 (不插入新节点)；路径中有未驻留的组件时返回 std::nullopt。
+     */
+    std::optional<PathId> find(std::string_view relative_path) const;
+
+    /// 父目录的 ID (ROOT 的父目录是它自己)
+    PathId parent(PathId id) const { return nodes_[id].parent; }
+
+    /// 最后一个路径组件 (ROOT 为空)
+    std::string_view name(PathId id) const { return nodes_[id].name; }
+
+    /// 路径组件数 (ROOT 为 0)
+    uint32_t depth(PathId id) const { return nodes_[id].depth; }
+
+    /**
+     * @brief 按路径组件逐级比较，与 std::filesystem::path 的 operator< 顺序相同 (祖先排在后代之前)。
+     */
+    bool less(PathId a, PathId b) const;
+
+    /// '/' 分隔的完整相对路径
+    std::string generic_string(PathId id) const;
+
+    /// 完整相对路径
+    std::filesystem::path path(PathId id) const { return std::filesystem::path(generic_string(id)); }
+
+    /// 节点数 (包括 ROOT)
+    size_t size() const { return nodes_.size(); }
+
+    /// 清空所有节点 (只保留 ROOT)，之前的 ID 全部失效
+    void clear();
+
+private:
+    struct Node {
+        PathId parent;
+        uint32_t depth;
+        std::string_view name; ///< 指向 blocks_ 中的名称
+    };
+
+    struct ChildKey {
+        PathId parent;
+        std::string_view name;
+        bool operator==(const ChildKey& other) const { return parent == other.parent && name == other.name; }
+    };
+
+    struct ChildKeyHash {
+        size_t operator()(const ChildKey& key) const {
+            return std::hash<std::string_view>()(key.name) * 31 + key.parent;
+        }
+    };
+
+    /// 内存区每块的大小 (超过此长度的名称单独分配一块)
+    static constexpr size_t BLOCK_SIZE = 16 * 1024;
+
+    /// 把名称复制到内存区，返回指向副本的 string_view
+    std::string_view store_name_(std::string_view name);
+
+    std::vector<Node> nodes_;
+    std::unordered_map<ChildKey, PathId, ChildKeyHash> children_; ///< (父目录, 名称) -> ID
+    std::vector<std::unique_ptr<char[]>> blocks_;                 ///< 名称内存区
+    size_t block_used_ = BLOCK_SIZE;                              ///< 最后一块已使用的字节数
+};
+
+}
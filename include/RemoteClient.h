@@ -8,6 +8,7 @@
 #include <boost/asio.hpp>
 #include "protocol.h" // 包含我们定义的协议
 #include "msg_node.h"       // 用于构造发送消息
+#include "ZlibDictionary.h" // 小对象传输使用的预设字典
 
 // 前向声明
 namespace Biogit {
@@ -61,6 +62,9 @@ public:
                       std::vector<ObjectExistenceStatus>& out_existence_results);
     bool PutObject(const std::string& token, const std::string& object_hash, const char* raw_data, uint32_t data_length); // 添加 token 参数
     bool PutObject(const std::string& token, const std::string& object_hash, const std::vector<char>& raw_object_data_vec); // 添加 token 参数
+    /// 以服务器已有的 base_hash 对象为基准上传增量；服务器缺少基准或还原校验失败时返回 false (调用者改用 PutObject)
+    bool PutObjectDelta(const std::string& token, const std::string& object_hash, const std::string& base_hash,
+                        const std::vector<std::byte>& delta);
 
     uint16_t UpdateRef(const std::string& token, const std::string& ref_full_name, // 添加 token 参数
                        const std::string& new_commit_hash,
@@ -68,6 +72,22 @@ public:
                        bool force_update,
                        std::vector<char>& out_response_body);
 
+    // --- 大文件内容传输 (按块流式传输，单条消息不超过一块) ---
+    bool CheckLfsObjects(const std::string& token, const std::vector<std::string>& oids_to_check,
+                         std::vector<ObjectExistenceStatus>& out_existence_results);
+    bool PutLfsBlock(const std::string& token, const std::string& oid, uint64_t offset, uint64_t total_size,
+                     const char* block_data, uint32_t block_length);
+    bool GetLfsBlock(const std::string& token, const std::string& oid, uint64_t offset,
+                     uint64_t& out_total_size, std::vector<char>& out_block_data);
+
+    // --- 小型 Tree/Commit 的预设字典 ---
+    bool NegotiateDictionary(const std::string& token, const std::vector<uint32_t>& local_dictionary_ids,
+                             uint32_t& out_selected_id, uint32_t& out_server_current_id);
+    bool GetDictionary(const std::string& token, uint32_t dictionary_id, std::vector<std::byte>& out_dictionary_data);
+
+    /// 设置协商出的字典：之后 PutObject/GetObject 对小型 Tree/Commit 自动以它压缩传输 (nullptr 表示不压缩)
+    void SetWireDictionary(std::shared_ptr<const ZlibDictionary> dictionary) { _wire_dictionary = std::move(dictionary); }
+
 private:
     bool SendAndReceive(const SendNode& request_node,
                         uint16_t& out_response_id,
@@ -87,6 +107,7 @@ private:
     boost::asio::ip::tcp::socket _socket;
     boost::asio::ip::tcp::resolver _resolver;
     bool _is_connected;
+    std::shared_ptr<const ZlibDictionary> _wire_dictionary; // 协商出的传输字典
 };
 
 }
\ No newline at end of file
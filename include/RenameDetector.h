@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <optional>
+#include <functional>
+#include <filesystem>
+#include <cstdint>
+
+#include "ObjectFormat.h"
+
+namespace Biogit {
+
+/**
+ * @brief 一对被识别为重命名 (或复制) 的文件。
+ */
+struct RenamePair {
+    std::filesystem::path old_path; ///< 源路径 (旧版本中的路径)
+    std::filesystem::path new_path; ///< 目标路径 (新版本中的路径)
+    std::string old_blob_hash;      ///< 源 Blob 哈希
+    std::string new_blob_hash;      ///< 目标 Blob 哈希
+    int similarity = 0;             ///< 相似度 (0-100)，精确匹配为 100
+    bool is_copy = false;           ///< true: 复制 (源路径在新版本中仍然存在)；false: 重命名
+};
+
+/**
+ * @brief 重命名/复制检测的选项。
+ */
+struct RenameDetectionOptions {
+    int min_similarity = 50;          ///< 非精确匹配的最低相似度 (百分比)
+    bool detect_copies = false;       ///< 是否检测复制 (以未删除的文件为源)
+    size_t rename_limit = 1000;       ///< 非精确匹配时参与比较的 源+目标 文件数上限，超过则只做精确匹配
+    size_t max_candidates_per_file = 32; ///< 每个目标文件从索引中取出的候选源数量上限
+    bool exact_only = false;          ///< 只做精确匹配 (不读取任何 Blob 内容)
+    ObjectFormat::Algorithm object_format = ObjectFormat::Algorithm::SHA1; ///< 仓库的对象格式 (用于识别空 Blob)
+};
+
+/**
+ * @brief 基于内容相似度的重命名/复制检测器。
+ * @details
+ * 1. 精确匹配：Blob 哈希相同的 删除/新增 文件直接配对 (相似度 100%)，同名 (basename) 优先；
+ * 2. 非精确匹配：将内容按行 (过长的行按 64 字节) 切分为块，对块哈希 (带出现次数，视为多重集合)
+ *    计算 MinHash 签名；再用 LSH 分桶建立索引，只对同桶的候选对估计相似度，
+ *    避免 O(新增 × 删除) 的两两比较。最后按得分从高到低贪心配对。
+ */
+class RenameDetector {
+public:
+    /// 根据 Blob 哈希读取内容；失败返回 std::nullopt
+    using BlobLoader = std::function<std::optional<std::string>(const std::string& blob_hash)>;
+
+    static constexpr size_t SIGNATURE_SIZE = 64; ///< MinHash 签名长度
+    static constexpr size_t BAND_ROWS = 2;       ///< LSH 每个分段的行数 (共 SIGNATURE_SIZE / BAND_ROWS 段)
+
+    RenameDetector(BlobLoader loader, RenameDetectionOptions options);
+
+    /**
+     * @brief 在删除和新增的文件之间检测重命名 (以及可选的复制)。
+     * @param deleted 只存在于旧版本的文件 <路径, Blob哈希>。
+     * @param added 只存在于新版本的文件 <路径, Blob哈希>。
+     * @param copy_sources (可选) 两边都存在的文件 <路径, 旧版本Blob哈希>，仅在 detect_copies 时作为复制源。
+     * @return 检测到的配对列表，按新路径排序。每个新增文件最多出现一次，每个删除文件最多被重命名一次。
+     */
+    std::vector<RenamePair> detect(const std::map<std::filesystem::path, std::string>& deleted,
+                                   const std::map<std::filesystem::path, std::string>& added,
+                                   const std::map<std::filesystem::path, std::string>& copy_sources = {});
+
+private:
+    /// 一个文件的相似度草图
+    struct Sketch {
+        std::vector<uint64_t> signature; ///< MinHash 签名 (空内容为空向量)
+        size_t size = 0;                 ///< 内容字节数
+    };
+
+    /// 读取 Blob 并计算草图 (同一 Blob 只计算一次)
+    const Sketch* sketch_for(const std::string& blob_hash);
+
+    /// 由两个草图估计相似度 (0-100)
+    static int estimate_similarity(const Sketch& a, const Sketch& b);
+
+    BlobLoader loader_;
+    RenameDetectionOptions options_;
+    std::map<std::string, std::optional<Sketch>> sketch_cache_;
+};
+
+}
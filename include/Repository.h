@@ -7,16 +7,37 @@
 #include <map>
 #include <set>
 #include <optional>
+#include <iostream>
+#include <memory>
+#include <functional>
 
 // 项目内部依赖
 #include "sha1.h"       // SHA1 哈希计算
 #include "Index.h"      // 索引/暂存区管理
+#include "RenameDetector.h" // 重命名/复制检测
+#include "OrderedTaskPool.h" // 并行任务、顺序输出
+#include "LfsStore.h"    // 大文件指针与内容库
+#include "Bundle.h"      // 离线传输包
+#include "ObjectFormat.h" // 对象格式 (哈希算法)
 
 namespace Biogit {
 
 using std::string;
 using SHA1::sha1;
 
+class RemoteClient;
+class IoBackend;
+class DiffDriver;
+
+/**
+ * @brief Diff 的输出格式。
+ */
+enum class DiffOutputFormat {
+    PATCH,        ///< (默认) 统一差异格式的逐行差异
+    STAT,         ///< 每个文件的增删行数统计 (类似 git diff --stat)
+    NAME_ONLY,    ///< 只列出改动的文件路径 (不读取任何 Blob；只检测内容相同的重命名)
+    NAME_STATUS   ///< 列出改动状态 (A/D/M/R/C) 和文件路径 (不读取任何 Blob；只检测内容相同的重命名)
+};
 
 /**
  * @brief Diff 操作的选项配置。默认比较工作目录和暂存区
@@ -26,6 +47,10 @@ struct DiffOptions {
     std::string commit1_hash_str;     ///< 第一个参与比较的 Commit 标识符 (哈希、分支名、标签名等)
     std::string commit2_hash_str;     ///< 第二个参与比较的 Commit 标识符
     std::vector<std::filesystem::path> paths_to_diff; ///< 要进行 diff 的特定文件或目录路径列表。如果为空，则比较所有涉及的路径
+    bool detect_renames = true;       ///< 是否检测重命名 (仅对 Commit 之间及 --staged 比较有效)
+    bool detect_copies = false;       ///< 是否同时检测复制 (以未改动的文件为源)
+    int rename_similarity = 50;       ///< 非精确重命名的最低相似度 (百分比)
+    DiffOutputFormat output_format = DiffOutputFormat::PATCH; ///< 输出格式
 
     DiffOptions() : staged(false) {}  // 默认构造函数
 };
@@ -69,9 +94,12 @@ struct UserConfig {
  * |-- config           # 本地仓库配置文件
  * |-- MERGE_HEAD       # (可选) 合并操作中，记录正在被合并的 Commit 哈希
  * |-- BIOGIT_CONFLICTS # (可选) 合并冲突时，记录冲突文件列表
+ * |-- commit-bloom     # (可选) 每个 Commit 改动路径的 Bloom 过滤器，供路径限定的 log 使用
+ * |-- blame-cache/     # (可选) blame 计算出的行来源缓存，以 (Commit, 路径) 为键
  * `-- biogit_token     # (可选) 保存当前仓库与远程服务器交互的认证 Token (由 login 命令写入)
  */
 class Repository {
+    friend class FastImporter; // 批量导入直接使用仓库的内部解析和比较函数
 public:
     // --- 静态常量：定义 .biogit 仓库内部的关键目录和文件名 ---
     static const std::string MYGIT_DIR_NAME;     ///< .biogit 目录的名称。
@@ -85,15 +113,22 @@ public:
     static const std::string FILE_CONFLICTS;       ///< BIOGIT_CONFLICTS 文件的名称 (记录合并冲突)。
     static const std::string INDEX_FILE_NAME;      ///< index (暂存区) 文件的名称。
     static const std::string CONFIG_FILE_NAME;     ///< 本地仓库配置文件名。
+    static const std::string BLAME_CACHE_DIR_NAME; ///< blame 行来源缓存目录的名称。
+    static const std::string WORKTREES_DIR_NAME;   ///< 链接工作树管理目录的名称 (位于公共目录下)。
+    static const std::string WORKTREE_LINK_PREFIX; ///< 链接工作树 .biogit 文件内容的前缀。
+    static constexpr uintmax_t DEFAULT_CHUNK_THRESHOLD = 4 * 1024 * 1024; ///< 默认分块存储阈值 (字节)，可由 core.chunkThreshold 覆盖
+    static constexpr size_t MIN_DELTA_TARGET_SIZE = 1024; ///< push 时小于此大小的对象不尝试增量上传
 
 
     // --- 构造与加载 ---
     /**
      * @brief 初始化一个新的 BioGit 仓库。
      * @param work_tree_path 仓库的工作树根目录路径。默认为当前工作目录。
+     * @param object_format 对象哈希算法 (之后不可更改)；非 SHA-1 时在配置中写入仓库格式扩展。
      * @return 如果成功，返回一个包含 Repository 对象的 std::optional；否则返回 std::nullopt。
      */
-    static std::optional<Repository> init(const std::filesystem::path& work_tree_path = std::filesystem::current_path());
+    static std::optional<Repository> init(const std::filesystem::path& work_tree_path = std::filesystem::current_path(),
+                                          ObjectFormat::Algorithm object_format = ObjectFormat::Algorithm::SHA1);
 
     /**
      * @brief 加载一个已存在的 BioGit 仓库。
@@ -110,6 +145,36 @@ public:
      */
     static std::optional<Repository> clone(const std::string& remote_url_str,const std::filesystem::path& target_directory_path);
 
+    /**
+     * @brief 从离线传输包克隆一个仓库 (检出包中 HEAD 指向的分支，远程跟踪引用记在 origin 下)。
+     * @param bundle_path 离线传输包路径。
+     * @param target_directory_path 目标目录 (不存在或为空目录)。
+     * @return 如果成功，返回新仓库；否则返回 std::nullopt。
+     */
+    static std::optional<Repository> clone_from_bundle(const std::filesystem::path& bundle_path,
+                                                       const std::filesystem::path& target_directory_path);
+
+    /**
+     * @brief (服务器端) 以共享对象池为后盾 fork 一个仓库。
+     * @details 源仓库的对象先移入对象池 (源仓库经备用对象库继续读取)，新仓库只复制引用，
+     *  对象全部从对象池读取；之后各自推送的新对象写入各自的仓库。大文件内容以硬链接共享。
+     * @param source_work_tree 源仓库的工作树根目录。
+     * @param target_work_tree 新仓库的工作树根目录 (不能已是仓库)。
+     * @param pool_objects_dir 共享对象池的对象目录 (不存在时创建)。
+     * @return 成功时返回新仓库；否则返回 std::nullopt。
+     */
+    static std::optional<Repository> fork(const std::filesystem::path& source_work_tree,
+                                          const std::filesystem::path& target_work_tree,
+                                          const std::filesystem::path& pool_objects_dir);
+
+    /**
+     * @brief 把本仓库的对象移入共享对象池，并把对象池登记为本仓库的备用对象库。
+     * @details 先登记备用对象库、再逐个移动对象，移动过程中每个对象都能在本仓库或对象池之一找到；
+     *  对象池中已有的对象直接删除本地副本。以字典压缩存放的对象所需的字典一并复制到对象池。
+     * @return 移入对象池 (或删除重复副本) 的对象数；失败返回 std::nullopt。
+     */
+    std::optional<size_t> share_objects_with_pool(const std::filesystem::path& pool_objects_dir) const;
+
     // --- 核心本地操作 ---
     /**
      * @brief 将指定路径的文件或目录内容添加到索引 (暂存区)。
@@ -139,6 +204,14 @@ public:
      */
     std::optional<std::string> commit(const std::string& message);
 
+    /**
+     * @brief 整理对象库：从小型 Tree/Commit 对象中抽样训练 zlib 预设字典，保存为新版本并设为当前字典，
+     *        再用它重新编码这些对象 (字典同时用于网络传输，见 ZlibDictionaries)。
+     * @details 样本不足、或新字典的压缩效果不优于当前字典时保留当前字典，只重新编码尚未使用当前字典的对象。
+     * @return 如果成功，返回 true；否则返回 false。
+     */
+    bool gc();
+
     // --- 信息展示与比较 ---
     /**
      * @brief 显示当前仓库的工作区、暂存区和HEAD之间的状态。
@@ -147,8 +220,18 @@ public:
 
     /**
      * @brief 显示当前分支的提交历史 (从 HEAD 开始回溯)。
+     * @param paths_filter (可选) 路径限定。非空时只显示改动过这些文件或目录的 Commit，
+     * 并借助 .biogit/commit-bloom 中的改动路径过滤器跳过一定未改动这些路径的 Commit。
+     */
+    void log(const std::vector<std::filesystem::path>& paths_filter = {}) const;
+
+    /**
+     * @brief 逐行显示文件每一行最后被修改时所在的 Commit、作者和时间 (类似 git blame)。
+     * @param file_path 要追溯的文件路径。
+     * @param commit_ish (可选) 从哪个 Commit 开始追溯。默认为 HEAD。
+     * @return 如果成功，返回 true；否则返回 false。
      */
-    void log() const;
+    bool blame(const std::filesystem::path& file_path, const std::string& commit_ish = "HEAD") const;
 
     /**
      * @brief 根据提供的选项显示差异。
@@ -185,6 +268,20 @@ public:
      */
     bool switch_branch(const std::string& target_identifier);
 
+    // --- 工作树管理 ---
+    /**
+     * @brief 为指定分支新建一个链接工作树，共享本仓库的对象库、引用和配置，HEAD 和索引各自独立。
+     * @param worktree_path 新工作树的路径 (不存在或为空目录)。
+     * @param branch_name 要检出的本地分支，不能已在其他工作树中检出。
+     * @return 如果成功，返回 true；否则返回 false。
+     */
+    bool worktree_add(const std::filesystem::path& worktree_path, const std::string& branch_name);
+
+    /**
+     * @brief 列出主工作树和所有链接工作树。
+     */
+    void worktree_list() const;
+
     // --- 标签管理 ---
     /**
      * @brief 创建一个新的轻量标签。
@@ -349,6 +446,50 @@ public:
               bool force,
               const std::string& token);
 
+    /**
+     * @brief 把指定引用的历史写入离线传输包 (不经服务器批量传输)。
+     * @param bundle_path 输出文件路径。
+     * @param ref_specs 分支、标签、引用全名或 --all；"<基准>..<引用>" 表示接收方已有 <基准> (记为前置提交)。
+     * @return 如果成功，返回 true；否则返回 false。
+     */
+    bool bundle_create(const std::filesystem::path& bundle_path, const std::vector<std::string>& ref_specs) const;
+
+    /**
+     * @brief 从离线传输包导入对象，并更新 refs/remotes/<远程名>/ 下的远程跟踪引用。
+     * @param bundle_path 离线传输包路径。
+     * @param remote_name 远程名称，默认为 "origin"。
+     * @return 如果成功，返回 true；否则返回 false。
+     */
+    bool bundle_unbundle(const std::filesystem::path& bundle_path, const std::string& remote_name = "origin");
+
+    /**
+     * @brief 从输入流批量导入提交 (fast-import 格式，见 FastImport.h)，不经过索引和工作区。
+     * @param in 导入流。
+     * @param force 是否允许非快进地覆盖已有引用。
+     * @return 如果全部成功，返回 true；否则返回 false。
+     */
+    bool fast_import(std::istream& in, bool force = false);
+
+    /**
+     * @brief 把指定引用的历史按拓扑顺序导出为 fast-import 格式的流 (见 FastExport.h)。
+     * @param ref_specs 分支、标签、引用全名或 --all；"<基准>..<引用>" 表示只导出 <基准> 之后的提交。
+     * @param out 输出流。
+     * @return 如果成功，返回 true；否则返回 false。
+     */
+    bool fast_export(const std::vector<std::string>& ref_specs, std::ostream& out) const;
+
+    /**
+     * @brief 把某个提交的树 (或其中一个路径) 以 tar 格式写出，不经过检出。
+     * @param commit_ish 分支、标签或提交哈希。
+     * @param sub_path 只归档该路径 (文件或目录，为空表示整棵树)。
+     * @param prefix 加在归档内每个路径之前的前缀 (如 "project-1.0/")。
+     * @param out 输出流。
+     * @param gzip 是否以 gzip 压缩。
+     * @return 如果成功，返回 true；否则返回 false (输出可能不完整)。
+     */
+    bool archive(const std::string& commit_ish, const std::string& sub_path, const std::string& prefix,
+                 std::ostream& out, bool gzip) const;
+
     /**
      * @brief (客户端) 从指定的远程仓库获取更新。
      * @param remote_name 要从中获取的远程仓库的别名。
@@ -375,10 +516,14 @@ public:
     // --- 路径与信息访问 (供内部和可能的外部工具使用) ---
     /** @brief 获取工作树的根目录路径。*/
     const std::filesystem::path& get_work_tree_root() const;
-    /** @brief 获取 .biogit 目录的路径。*/
+    /** @brief 获取 .biogit 目录的路径 (链接工作树为其管理目录)。*/
     const std::filesystem::path& get_mygit_directory() const;
+    /** @brief 获取对象、引用和配置所在的公共目录 (主仓库的 .biogit)。*/
+    const std::filesystem::path& get_common_directory() const;
     /** @brief 获取 objects 目录的路径。*/
     std::filesystem::path get_objects_directory() const;
+    /** @brief 获取仓库的对象格式 (对象哈希算法)。*/
+    ObjectFormat::Algorithm get_object_format() const;
     /** @brief 获取 refs 目录的路径。*/
     std::filesystem::path get_refs_directory() const;
     /** @brief 获取 refs/heads 目录的路径。*/
@@ -398,6 +543,19 @@ public:
      */
     static std::optional<std::filesystem::path> find_repository_root(const std::filesystem::path& starting_path);
 
+    /**
+     * @brief 检查引用全名能否安全地作为公共目录下的相对路径使用。
+     * @details 必须以 "refs/" 开头；不得含 ".."、反斜杠或控制字符，不得有空的或为 "." 的路径分量。
+     *  来自外部输入 (离线传输包、导入流、推送请求) 的引用名在拼接成文件路径前都要先经过此检查。
+     */
+    static bool is_valid_ref_name(const std::string& ref_full_name);
+
+    /**
+     * @brief 设置引用文件 (HEAD、分支、标签) 进程内缓存的条目数上限；0 (默认) 表示关闭并清空。
+     * @details 供常驻进程 (daemon) 在多次请求之间复用未改变的引用文件内容。
+     */
+    static void set_ref_cache_capacity(size_t entries);
+
     /**
      * @brief (公开API) 根据给定的 SHA-1 哈希 (或唯一前缀) 加载并显示对象内容。
      * @param object_hash_prefix 对象的哈希前缀。
@@ -406,6 +564,25 @@ public:
      */
     bool show_object_by_hash(const std::string &object_hash_prefix, bool pretty_print=true);
 
+    /**
+     * @brief 批量查询对象：从 in 逐行读取对象名，向 out 写出带长度的应答，供外部工具长期驻留调用。
+     * @details 对象名可以是完整哈希、哈希前缀、分支/标签/HEAD，或 "<提交>:<路径>"。每个应答为
+     *  "<哈希> <类型> <大小>\n<内容>\n"；找不到时为 "<对象名> missing\n"。每个应答后立即刷新输出。
+     * @param check_only 为 true 时只输出 "<哈希> <类型> <大小>\n"，只读取对象头部。
+     * @return 输入读完时返回 true；写出失败时返回 false。
+     */
+    bool cat_file_batch(std::istream& in, std::ostream& out, bool check_only) const;
+
+    /**
+     * @brief 列出提交中某个路径的 Tree 条目 (只读取路径经过的各级 Tree)。
+     * @details 路径为空或以 '/' 结尾且是目录时，列出该目录的条目；否则只列出路径本身对应的条目。
+     *  每行为 "<模式> <类型> <哈希>\t<路径>"，与 show 一个 Tree 的格式相同。
+     * @param commit_ish 分支名、标签名、HEAD 或提交哈希 (前缀)。
+     * @param relative_path 相对于仓库根目录的路径 ('/' 分隔)。
+     * @return 成功返回 true；提交或路径不存在时返回 false。
+     */
+    bool ls_tree(const std::string& commit_ish, const std::string& relative_path) const;
+
 private:
     /**
      * @brief (私有构造函数) 通过工作树路径创建 Repository 实例。
@@ -421,15 +598,21 @@ private:
     std::optional<std::filesystem::path> normalize_and_relativize_path(const std::filesystem::path& user_path) const;
 
     /**
-     * @brief (内部) 从已排序的索引条目构建层级的 Tree 对象，并返回根 Tree 对象的 SHA-1 哈希。
+     * @brief (内部) 从索引条目构建层级的 Tree 对象 (按路径表中的目录 ID 分组)，并返回根 Tree 对象的哈希。
      */
-    std::optional<std::string> _build_trees_and_get_root_hash(const std::vector<IndexEntry>& sorted_index_entries);
+    std::optional<std::string> _build_trees_and_get_root_hash(const Index& index);
 
     /**
      * @brief (内部) 获取当前 HEAD 指向的 Commit 的 SHA-1 哈希。
      */
     std::optional<std::string> _get_head_commit_hash() const;
 
+    /**
+     * @brief (内部) 读取引用文件的首行 (去除首尾空白)；启用引用缓存时，文件身份未变则直接复用上次的内容。
+     * @return 文件不存在、不是常规文件或为空时返回 std::nullopt。
+     */
+    static std::optional<std::string> _read_ref_file(const std::filesystem::path& ref_file_path);
+
     /**
      * @brief (内部) 解析 Commit-ish 字符串 (分支名, "HEAD", 标签名, 哈希前缀, 完整哈希) 为完整的 Commit SHA-1 哈希。
      */
@@ -447,6 +630,29 @@ private:
         std::map<std::filesystem::path, std::pair<std::string, std::string>>& files_map
     ) const;
 
+    /**
+     * @brief (内部) 取得 Tree 展开后的 <文件相对路径, <Blob哈希, 文件模式>> 映射 (进程内缓存，常驻进程中跨请求复用)。
+     */
+    std::shared_ptr<const std::map<std::filesystem::path, std::pair<std::string, std::string>>>
+    _flattened_tree(const std::string& tree_hash_hex) const;
+
+    /**
+     * @brief (内部) 取得已解析的索引；索引文件的修改时间、状态改变时间、inode 和大小都未变时复用上次的解析结果
+     *        (刚写入、时间戳尚未落定的索引不缓存)。
+     * @return 索引文件存在但解析失败时返回 nullptr。
+     */
+    std::shared_ptr<const Index> _index_snapshot() const;
+
+    /**
+     * @brief (内部) 只加载 Tree 中某个路径 (文件或目录) 下的文件条目到映射中，不展开路径以外的子树。
+     * @param relative_path 相对于根 Tree 的路径；为空或 "." 时加载整棵树。
+     */
+    void _load_tree_contents_at_path(
+        const std::string& tree_hash_hex,
+        const std::filesystem::path& relative_path,
+        std::map<std::filesystem::path, std::pair<std::string, std::string>>& files_map
+    ) const;
+
     /**
      * @brief (内部) 从给定的 Tree 哈希递归地将文件条目填充到 Index 对象中。
      * @param tree_hash_hex 要加载的 Tree 对象的哈希。
@@ -455,7 +661,7 @@ private:
      */
     void _populate_index_from_tree_recursive(
         const std::string& tree_hash_hex,
-        const std::filesystem::path& current_path_prefix,
+        PathTable::PathId parent_dir_id,
         Index& target_index // 直接修改传入的 Index 对象
     ) const;
 
@@ -488,6 +694,59 @@ private:
      */
     std::optional<std::vector<std::string>> _get_blob_lines(const std::string& blob_hash) const;
 
+    /**
+     * @brief (内部) 读取分块存储阈值 (配置项 core.chunkThreshold，单位字节；0 表示不分块)。
+     */
+    uintmax_t _chunk_threshold() const;
+
+    /**
+     * @brief (内部) 读取大文件指针存储阈值 (配置项 lfs.threshold，单位字节；0 表示不启用，为默认值)。
+     */
+    uintmax_t _lfs_threshold() const;
+
+    /**
+     * @brief (内部) 若工作区文件达到大文件阈值，返回 add 时会为它存入的指针 Blob 的哈希 (流式计算，不把文件读入内存)。
+     * @param absolute_path 工作区文件的绝对路径。
+     * @param lfs_threshold 调用方读取的 _lfs_threshold()。
+     * @return 未启用大文件存储或文件小于阈值时返回 std::nullopt，调用方按普通 Blob 计算哈希。
+     */
+    std::optional<std::string> _lfs_pointer_blob_hash(const std::filesystem::path& absolute_path, uintmax_t lfs_threshold) const;
+
+    /**
+     * @brief (内部) 收集一组提交的 Tree 中引用的所有大文件指针 (按内容 oid 去重)。
+     */
+    std::map<std::string, LfsPointer> _collect_lfs_pointers(const std::vector<std::string>& commit_hashes) const;
+
+    /**
+     * @brief (内部) push 时把服务器内容库中缺少的大文件内容按块上传 (在上传指针 Blob 之前进行)。
+     * @return 所有需要的内容都已在服务器上时返回 true。
+     */
+    bool _push_lfs_contents(RemoteClient& client, const std::string& token, const std::vector<std::string>& commit_hashes) const;
+
+    /**
+     * @brief (内部) fetch 后按块下载本地内容库中缺少的大文件内容 (只针对给定提交的 Tree，历史版本的内容按需再取)。
+     * @return 所有需要的内容都已在本地时返回 true。
+     */
+    bool _fetch_lfs_contents(RemoteClient& client, const std::string& token, const std::vector<std::string>& commit_hashes) const;
+
+    /**
+     * @brief (内部) 与服务器协商小型 Tree/Commit 传输使用的预设字典，并设置到 client 上。
+     * @param adopt_remote_dictionary 为 true (fetch) 时，本地没有服务器的当前字典就先下载它；
+     *        本地还没有任何字典时把它设为当前字典。
+     * @details 服务器不支持协商或双方没有共同的字典时，对象按原样传输。
+     */
+    void _negotiate_wire_dictionary(RemoteClient& client, const std::string& token, bool adopt_remote_dictionary) const;
+
+    /**
+     * @brief (内部) 为 push 要上传的文件内容寻找服务器上已有的增量基准。
+     * @details 把每个待发送提交的 Tree 与远程分支顶端的 Tree 比较，同一路径在远程的旧版本即为基准。
+     *  两个版本都分块存储时，新版本的每个 chunk 以旧版本中覆盖相同偏移的 chunk 为基准；
+     *  新版本分块而旧版本是普通 Blob 时，各 chunk 都以整个旧 Blob 为基准。
+     * @return <目标对象哈希, 基准对象哈希>；远程分支不存在或本地没有其顶端提交时为空。
+     */
+    std::map<std::string, std::string> _collect_delta_bases(const std::string& remote_tip_hash,
+                                                            const std::vector<std::string>& commits_to_send) const;
+
     /**
      * @brief (内部) 检查当前工作区和索引相对于 HEAD 是否“干净”(即没有未提交的更改)。
      */
@@ -495,8 +754,65 @@ private:
 
     /**
      * @brief (内部) 获取工作目录中指定相对路径文件的内容，并按行分割。
+     * @param lfs_threshold 调用方读取的 _lfs_threshold() (达到阈值的文件以指针文本参与比较)。
+     */
+    std::optional<std::vector<std::string>> _get_workdir_lines(const std::filesystem::path& relative_path, uintmax_t lfs_threshold) const;
+
+    /**
+     * @brief 一次 diff 调用中各文件共用的配置：创建并行任务之前读取一次，任务中不再读取配置文件。
+     */
+    struct DiffSettings {
+        uintmax_t lfs_threshold = 0; ///< _lfs_threshold()
+        bool binary_delta = false;   ///< diff.binaryDelta
+        std::function<std::optional<std::string>(const std::string&)> driver_config; ///< diff.<驱动名>.pattern 的快照
+    };
+
+    /**
+     * @brief (内部) 读取 diff 用到的配置 (见 DiffSettings)。
+     */
+    DiffSettings _diff_settings() const;
+
+    /**
+     * @brief 内容探测结果：是否为二进制，以及内容大小。
+     */
+    struct ContentProbe {
+        bool binary = false; ///< 开头抽样判定为二进制
+        uintmax_t size = 0;  ///< 内容大小 (字节)
+    };
+
+    /**
+     * @brief (内部) 探测 Blob 是否为二进制，只读取开头部分；结果按 Blob 哈希缓存在进程内。
+     */
+    std::optional<ContentProbe> _probe_blob(const std::string& blob_hash) const;
+
+    /**
+     * @brief (内部) 探测工作区文件是否为二进制 (达到大文件阈值的文件以指针文本比较，视为文本)。
+     */
+    std::optional<ContentProbe> _probe_workdir_file(const std::filesystem::path& relative_path, uintmax_t lfs_threshold) const;
+
+    /**
+     * @brief (内部) 以流式读取计算工作区文件作为 Blob 的对象哈希 (对象头部 + 文件内容)，不把整个文件读入内存。
+     * @return 对象哈希；文件无法读取时返回 std::nullopt。
+     */
+    std::optional<std::string> _hash_workdir_file(const std::filesystem::path& absolute_path) const;
+
+    /**
+     * @brief (内部) 任一版本为二进制时打印 "Binary files ... differ" 摘要并返回 true，调用者不再按行比较。
+     * @param old_blob_hash 旧版本 Blob 哈希 (为空表示文件不存在)。
+     * @param new_blob_hash 新版本 Blob 哈希 (为空且 new_from_workdir 为 false 表示文件不存在)。
+     * @param new_from_workdir 新版本来自工作区文件 new_path。
+     * @param extended_header_lines 紧跟在 "diff --biogit" 行之后的扩展头 (重命名/复制)。
+     * @details settings.binary_delta (配置项 diff.binaryDelta) 为 true 时，额外按内容定义分块估算新版本相对旧版本的增量字节数
+     *  (需要读取两边的完整内容，任一边超过 64 MiB 时不估算)。
      */
-    std::optional<std::vector<std::string>> _get_workdir_lines(const std::filesystem::path& relative_path) const;
+    bool _print_binary_diff_if_needed(const std::filesystem::path& old_path,
+                                      const std::filesystem::path& new_path,
+                                      const std::string& old_blob_hash,
+                                      const std::string& new_blob_hash,
+                                      bool new_from_workdir,
+                                      const std::vector<std::string>& extended_header_lines,
+                                      const DiffSettings& settings,
+                                      std::ostream& out) const;
 
     /**
      * @brief (内部) 执行文件内容的差异比较，并以统一差异格式打印结果。
@@ -506,7 +822,77 @@ private:
         const std::vector<std::string> &lines_a,
         const std::string &label_a_suffix,
         const std::vector<std::string> &lines_b,
-        const std::string &label_b_suffix);
+        const std::string &label_b_suffix,
+        const DiffSettings &settings,
+        std::ostream &out = std::cout) const;
+
+    /**
+     * @brief 摘要模式 (--stat / --name-only / --name-status) 下收集的一条文件改动。
+     */
+    struct DiffFileChange {
+        char status = 'M';                ///< 'A' 新增, 'D' 删除, 'M' 修改, 'R' 重命名, 'C' 复制
+        std::filesystem::path old_path;   ///< 旧路径 (新增时与 new_path 相同)
+        std::filesystem::path new_path;   ///< 新路径
+        std::string old_blob_hash;        ///< 旧 Blob 哈希 (新增时为空)
+        std::string new_blob_hash;        ///< 新 Blob 哈希 (删除时为空；来自工作区时为空)
+        bool new_from_workdir = false;    ///< 新版本内容是否来自工作区文件
+        int similarity = 0;               ///< 重命名/复制的相似度
+    };
+
+    /**
+     * @brief (内部) 以摘要格式打印收集到的文件改动。
+     * @details NAME_ONLY / NAME_STATUS 不读取任何内容；STAT 只为统计增删行数读取内容。
+     */
+    void _print_diff_summary(const std::vector<DiffFileChange>& changes, DiffOutputFormat format, const DiffSettings& settings) const;
+
+    /**
+     * @brief (内部) 在删除和新增的文件之间检测重命名/复制。
+     * @details 非精确匹配的文件数上限由配置项 diff.renameLimit 决定 (默认 1000)。
+     * @param deleted 只存在于旧版本的文件 <路径, Blob哈希>。
+     * @param added 只存在于新版本的文件 <路径, Blob哈希>。
+     * @param copy_sources 两边都存在的文件 <路径, 旧Blob哈希>，仅在 detect_copies 为 true 时使用。
+     * @param detect_copies 是否检测复制。
+     * @param min_similarity 非精确匹配的最低相似度 (百分比)。
+     * @param exact_only 只按 Blob 哈希做精确匹配，不读取任何内容 (--name-only / --name-status)。
+     */
+    std::vector<RenamePair> _detect_renames(
+        const std::map<std::filesystem::path, std::string>& deleted,
+        const std::map<std::filesystem::path, std::string>& added,
+        const std::map<std::filesystem::path, std::string>& copy_sources,
+        bool detect_copies,
+        int min_similarity,
+        bool exact_only = false) const;
+
+    /**
+     * @brief (内部) 打印一对重命名/复制文件的差异 (带 similarity/rename/copy 扩展头)。
+     */
+    void _print_rename_diff(const RenamePair& rename_pair,
+                            const std::string& label_a_suffix,
+                            const std::string& label_b_suffix,
+                            const DiffSettings& settings,
+                            std::ostream& out = std::cout) const;
+
+    /**
+     * @brief (内部) 并行执行逐文件的 diff 任务，并按路径顺序输出。
+     * @details 线程数由配置项 diff.threads 决定 (默认使用全部核心，1 表示串行)。
+     */
+    void _run_diff_tasks(const std::vector<OrderedTaskPool::Task>& diff_tasks) const;
+
+    /**
+     * @brief (内部) 读取线程数配置项 (如 diff.threads)；未设置或无效时返回 0 (使用全部核心)。
+     */
+    size_t _configured_thread_count(const std::string& config_key) const;
+
+    /**
+     * @brief (内部) 按配置创建批量文件 I/O 后端：core.ioBackend 选择 auto / threads / io_uring (默认 auto)，
+     *        core.ioThreads 为队列深度 (0 或未设置时按硬件并发数)。
+     */
+    std::unique_ptr<IoBackend> _io_backend() const;
+
+    /**
+     * @brief (内部) 按路径选择按记录比较的 diff 驱动 (见 DiffDriver.h)；没有匹配时返回 nullptr。
+     */
+    const DiffDriver* _diff_driver_for(const std::filesystem::path& relative_path, const DiffSettings& settings) const;
 
     /**
      * @brief (内部) 查找两个 Commit 之间的最近共同祖先 (LCA)。
@@ -559,15 +945,138 @@ private:
                                             std::set<std::string>& objects_to_collect,
                                             std::set<std::string>& visited_objects) const;
 
+    /**
+     * @brief blame 结果中一行的来源。
+     */
+    struct BlameOrigin {
+        std::string commit_hash; ///< 引入该行的 Commit 哈希
+        int line_index = 0;      ///< 该行在引入它的 Commit 版本中的行号 (0-based)
+    };
+
+    /**
+     * @brief (内部) 在 Tree 中按路径逐级查找文件的 Blob 哈希。
+     * @param tree_hash_hex 根 Tree 的哈希。
+     * @param relative_path 以 '/' 分隔的文件相对路径。
+     * @return 找到文件时返回 Blob 哈希；否则返回 std::nullopt。
+     */
+    std::optional<std::string> _find_blob_hash_in_tree(const std::string& tree_hash_hex, const std::string& relative_path) const;
+
+    /// (内部) 已读取的 Tree 条目缓存：Tree 哈希 -> (名称 -> <模式, 哈希>)
+    using TreeEntryCache = std::map<std::string, std::map<std::string, std::pair<std::string, std::string>>>;
+
+    /**
+     * @brief (内部) 在 Tree 中按路径逐级查找条目 (文件或目录)。
+     * @param cache 可选的条目缓存，批量查询同一棵树中的多个路径时避免重复读取上层目录。
+     * @return 找到时返回 <模式, 哈希>；否则返回 std::nullopt。
+     */
+    std::optional<std::pair<std::string, std::string>> _find_entry_in_tree(const std::string& tree_hash_hex,
+                                                                           const std::string& relative_path,
+                                                                           TreeEntryCache* cache = nullptr) const;
+
+    /**
+     * @brief (内部) 把对象名解析为完整的对象哈希：完整哈希或前缀、提交名，或 "<提交>:<路径>" (路径为空时为根 Tree)。
+     */
+    std::optional<std::string> _resolve_object_name(const std::string& name, TreeEntryCache* cache = nullptr) const;
+
+    /**
+     * @brief (内部) 只读取对象头部得到 <类型, 大小>。分块存储的 Blob 报告为 blob 及其完整大小；
+     *  经编解码器存储的对象需要完整还原。
+     */
+    std::optional<std::pair<std::string, uintmax_t>> _read_object_header(const std::string& full_hash) const;
+
+    /** @brief (内部) 获取 (Commit, 路径) 对应的 blame 缓存文件路径。*/
+    std::filesystem::path _blame_cache_file_path(const std::string& commit_hash, const std::string& relative_path) const;
+
+    /** @brief (内部) 读取 (Commit, 路径) 的 blame 缓存；未命中返回 std::nullopt。*/
+    std::optional<std::vector<BlameOrigin>> _load_blame_cache(const std::string& commit_hash, const std::string& relative_path) const;
+
+    /** @brief (内部) 写入 (Commit, 路径) 的 blame 缓存。*/
+    bool _save_blame_cache(const std::string& commit_hash, const std::string& relative_path,
+                           const std::vector<BlameOrigin>& origins) const;
+
+    /**
+     * @brief (内部) 比较两个 Tree，收集所有内容或模式发生变化的文件路径。
+     * @details 哈希相同的子 Tree 会被整体跳过。任一 Tree 哈希为空时视为空树。
+     * @param old_tree_hash 旧 Tree 的哈希 (可为空)。
+     * @param new_tree_hash 新 Tree 的哈希 (可为空)。
+     * @param current_path_prefix 当前路径前缀。
+     * @param changed_paths 输出参数，存储以 '/' 分隔的改动文件相对路径。
+     * @return 有 Tree 无法加载时返回 false，此时 changed_paths 不完整，不能据此写入改动路径过滤器。
+     */
+    bool _collect_changed_paths(const std::string& old_tree_hash,
+                                const std::string& new_tree_hash,
+                                const std::filesystem::path& current_path_prefix,
+                                std::set<std::string>& changed_paths) const;
+
+    /**
+     * @brief (内部) 计算 Commit 相对于其第一个父提交改动的文件路径，并记录到改动路径过滤器中。
+     * @param commit_hash 已保存的 Commit 的哈希。
+     * @return 改动的文件路径集合；如果 Commit 或某个 Tree 无法加载则返回 std::nullopt (不写入过滤器)。
+     */
+    std::optional<std::set<std::string>> _record_changed_paths(const std::string& commit_hash) const;
+
+    /**
+     * @brief (内部) 移动引用或写入索引之前调用：core.fsyncObjects = batch 时把本次操作写入的对象刷到磁盘。
+     * @return 刷盘成功或无需刷盘返回 true。
+     */
+    bool _sync_objects() const;
+
     /**
      * @brief (内部) 检查具有给定名称的本地分支是否存在。
      */
     bool branch_exists(const std::string& branch_name) const;
 
+    /**
+     * @brief (内部) 列出共享同一公共目录的所有工作树：(工作树根目录, 管理目录)，主工作树在前。
+     */
+    std::vector<std::pair<std::filesystem::path, std::filesystem::path>> _list_worktrees() const;
+
+    /**
+     * @brief (内部) 查找已检出指定分支的工作树。
+     * @param skip_current 是否跳过当前工作树。
+     * @return 检出该分支的工作树根目录；没有则返回 std::nullopt。
+     */
+    std::optional<std::filesystem::path> _worktree_with_branch(const std::string& branch_name,
+                                                               bool skip_current = true) const;
+
+    /** @brief (内部) 解析工作树的 .biogit 目录 (链接工作树的 .biogit 文件指向其管理目录)。*/
+    static std::filesystem::path _resolve_mygit_dir(const std::filesystem::path& work_tree_root);
+    /** @brief (内部) 解析公共目录 (管理目录中 commondir 文件记录的路径，没有时为自身)。*/
+    static std::filesystem::path _resolve_common_dir(const std::filesystem::path& mygit_dir);
+    /** @brief (内部) 检查目录是否为有效的 BioGit 工作树根目录 (包括链接工作树)。*/
+    static bool _is_repository_root(const std::filesystem::path& work_tree_root);
+    /** @brief (内部) 检查仓库格式版本和对象格式扩展是否为本程序所支持，并按本仓库的对象格式登记备用对象库 (失败时打印错误)。*/
+    bool _check_repository_format() const;
+    /** @brief (内部) 网络协议和离线传输包只传输 SHA-1 对象：其他对象格式的仓库打印错误并返回 false。*/
+    bool _check_transport_object_format() const;
+
+    /**
+     * @brief (内部) 克隆后检出远程的默认分支 (按 refs/remotes/<远程名>/HEAD)，并设置上游跟踪。
+     */
+    bool _checkout_remote_head(const std::string& remote_name);
+
+    /**
+     * @brief (内部) 校验前置提交，把离线传输包中的对象逐个写入对象库并校验校验和。
+     * @return 成功时返回包的头部；否则返回 std::nullopt。
+     */
+    std::optional<BundleHeader> _unbundle_objects(const std::filesystem::path& bundle_path);
+
+    /**
+     * @brief (内部) 解析 bundle create / fast-export 的引用参数。
+     * @param ref_specs 分支、标签、引用全名或 --all；"<基准>..<引用>" 表示排除 <基准> 可达的提交。
+     * @param out_refs 输出 <引用全名, Commit 哈希> (按参数顺序，去重)。
+     * @param out_bases 输出各个 <基准> 的 Commit 哈希。
+     * @return 如果全部解析成功，返回 true；否则返回 false。
+     */
+    bool _resolve_ref_specs(const std::vector<std::string>& ref_specs,
+                            std::vector<std::pair<std::string, std::string>>& out_refs,
+                            std::vector<std::string>& out_bases) const;
+
 
 private:
     std::filesystem::path work_tree_root_; ///< 工作树的根目录绝对路径。
-    std::filesystem::path mygit_dir_;      ///< .biogit 目录的绝对路径。
+    std::filesystem::path mygit_dir_;      ///< .biogit 目录的绝对路径 (链接工作树为其管理目录)。
+    std::filesystem::path common_dir_;     ///< 对象、引用和配置所在的公共目录 (普通仓库与 mygit_dir_ 相同)。
     Index index_manager_;                  ///< 索引 (暂存区) 管理器实例。
 };
 
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+#include <cstdint>
+
+#include <zlib.h>
+
+namespace Biogit {
+
+/**
+ * @brief POSIX tar (ustar + pax 扩展头) 格式的构造函数，供 archive 命令流式输出归档。
+ * @details 所有条目的属主为 0/0、属主名为空，时间统一为提交时间，因此同一棵树总是产生完全相同的字节。
+ *  路径放不进 ustar 的 name/prefix 字段、符号链接目标超过 100 字节或文件超过 8 GiB 时，
+ *  在该条目之前写一个 pax 扩展头 ('x') 记录完整的值。
+ */
+namespace Tar {
+
+inline constexpr size_t BLOCK_SIZE = 512;
+
+/// 条目类型
+inline constexpr char TYPE_FILE = '0';
+inline constexpr char TYPE_SYMLINK = '2';
+inline constexpr char TYPE_DIRECTORY = '5';
+
+/// 一个归档条目的元数据
+struct EntryInfo {
+    std::string path;          ///< 归档内路径 ('/' 分隔，目录以 '/' 结尾)
+    char type = TYPE_FILE;
+    unsigned mode = 0644;
+    uint64_t size = 0;         ///< 文件内容长度 (目录和符号链接为 0)
+    int64_t mtime = 0;         ///< Unix 时间戳 (秒)
+    std::string link_target;   ///< 符号链接目标
+};
+
+/// 条目头部 (需要时前置 pax 扩展头)，长度为 BLOCK_SIZE 的整数倍
+std::string entry_header(const EntryInfo& entry);
+
+/// 全局 pax 头 ('g')，记录归档来源的 Commit 哈希 (与 git archive 相同，可用 `git get-tar-commit-id` 读出)
+std::string global_header(const std::string& commit_hash, int64_t mtime);
+
+/// 把长度为 size 的内容补齐到 BLOCK_SIZE 整数倍所需的零字节
+std::string padding(uint64_t size);
+
+/// 归档结尾 (两个全零块)
+std::string end_of_archive();
+
+}
+
+
+/**
+ * @brief 把写入的字节以 gzip 格式压缩后写入另一个输出流的 streambuf。
+ * @details 与 std::ostream 配合使用：std::ostream gz(&buf)；写完后必须调用 finish() 写出 gzip 尾部。
+ *  gzip 头部的时间字段为 0，因此相同输入产生相同输出。
+ */
+class GzipStreamBuf : public std::streambuf {
+public:
+    explicit GzipStreamBuf(std::ostream& sink, int level = Z_DEFAULT_COMPRESSION);
+    ~GzipStreamBuf() override;
+
+    GzipStreamBuf(const GzipStreamBuf&) = delete;
+    GzipStreamBuf& operator=(const GzipStreamBuf&) = delete;
+
+    /// 压缩剩余数据并写出 gzip 尾部；返回输出是否全部成功
+    bool finish();
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* data, std::streamsize size) override;
+    int sync() override;
+
+private:
+    bool deflate_buffer(const char* data, size_t size, int flush);
+
+    std::ostream& sink_;
+    z_stream stream_{};
+    std::vector<char> in_buffer_;
+    std::vector<char> out_buffer_;
+    bool initialized_ = false;
+    bool finished_ = false;
+    bool failed_ = false;
+};
+
+}
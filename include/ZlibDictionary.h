@@ -0,0 +1,115 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <filesystem>
+#include <cstddef>
+#include <cstdint>
+
+namespace Biogit {
+
+/**
+ * @brief zlib 预设字典 (deflateSetDictionary / inflateSetDictionary)。
+ * @details 字典编号取字典内容 SHA-1 的前 4 字节，同一内容在任何仓库中编号相同，可直接用于两端协商。
+ */
+struct ZlibDictionary {
+    uint32_t id = 0;             ///< 字典编号
+    std::vector<std::byte> data; ///< 字典内容
+};
+
+/**
+ * @brief 小型 Tree/Commit 对象的预设字典：训练、存储和压缩。
+ * @details
+ *  单个 Tree/Commit 只有几百字节，zlib 没有可以引用的上下文，单独压缩几乎没有收益；
+ *  但同一仓库中这类对象的模式、作者行、常见文件名高度重复。gc 时从仓库中抽样训练字典，
+ *  用它压缩小对象的磁盘存储和网络传输。\n
+ *  字典存放在 .biogit/dictionaries/<8位十六进制编号>，文件格式为 FILE_MAGIC + 格式版本 (1字节) + 字典内容；
+ *  字典一经写入不再修改，新训练的字典以新编号保存 (旧字典保留，用它编码的对象仍可读取)，
+ *  dictionaries/CURRENT 记录当前用于编码的字典编号。
+ */
+namespace ZlibDictionaries {
+
+/// 存储层编码时使用的编解码器编号 (与 ObjectCodec::id() 同一编号空间)
+inline constexpr uint8_t CODEC_ID = 2;
+
+/// 字典文件的前缀与格式版本
+inline constexpr char FILE_MAGIC[4] = {'B', 'G', 'Z', 'D'};
+inline constexpr uint8_t FORMAT_VERSION = 1;
+
+/// 内容不超过此大小的 Tree/Commit 对象使用字典压缩
+inline constexpr size_t MAX_OBJECT_SIZE = 4096;
+
+/// 字典压缩的完整对象字节 (含 "<type> <size>\0" 头部) 的上限，接收方据此在解压前拒绝过大的声明长度
+inline constexpr size_t MAX_OBJECT_BYTES = MAX_OBJECT_SIZE + 32;
+
+/// 训练出的字典的最大大小 (不超过 zlib 的 32KB 窗口)
+inline constexpr size_t MAX_DICTIONARY_SIZE = 16 * 1024;
+
+/// 训练所需的最少样本数，以及最多使用的样本数
+inline constexpr size_t MIN_TRAINING_SAMPLES = 16;
+inline constexpr size_t MAX_TRAINING_SAMPLES = 4096;
+
+/// 对象类型和内容大小是否适用字典压缩
+bool applies_to(std::string_view type, size_t content_size);
+
+/// 规范对象字节 ("type size\0content") 是否适用字典压缩 (网络传输时使用)
+bool applies_to_object(const char* object_bytes, size_t size);
+
+/// 字典编号与 8 位十六进制字符串互转
+std::string format_id(uint32_t id);
+std::optional<uint32_t> parse_id(const std::string& text);
+
+/// 计算字典内容的编号
+uint32_t compute_id(const std::vector<std::byte>& data);
+
+/// 对象库目录对应的字典目录 (.biogit/dictionaries/)
+std::filesystem::path directory(const std::filesystem::path& objects_dir);
+
+/**
+ * @brief 按编号加载字典 (进程内缓存)。字典不存在或文件损坏时返回 nullptr。
+ */
+std::shared_ptr<const ZlibDictionary> load(const std::filesystem::path& objects_dir, uint32_t id);
+
+/**
+ * @brief 加载当前用于编码的字典；仓库尚未训练字典时返回 nullptr。
+ */
+std::shared_ptr<const ZlibDictionary> current(const std::filesystem::path& objects_dir);
+
+/**
+ * @brief 列出仓库中所有字典的编号 (当前字典排在最前)。
+ */
+std::vector<uint32_t> list(const std::filesystem::path& objects_dir);
+
+/**
+ * @brief 保存字典 (已存在则不重复写入)。
+ * @param make_current 为 true 时同时把它设为当前字典。
+ * @return 字典编号；写入失败返回 std::nullopt。
+ */
+std::optional<uint32_t> install(const std::filesystem::path& objects_dir, const std::vector<std::byte>& data, bool make_current);
+
+/**
+ * @brief 从样本训练字典。
+ * @details
+ *  统计每个 8 字节片段出现在多少个样本中，把样本切成重叠的小段，按 “段内尚未被选中的
+ *  高频片段的出现次数之和” 贪心地挑选小段，选中后这些片段不再计分，直到字典达到大小上限。
+ *  越有价值的小段放在字典越靠后的位置 (zlib 对较近的匹配使用更短的距离编码)。
+ * @return 字典内容；样本中没有重复内容时返回空。
+ */
+std::vector<std::byte> train(const std::vector<std::vector<std::byte>>& samples, size_t max_size = MAX_DICTIONARY_SIZE);
+
+/**
+ * @brief 以 raw deflate 压缩数据；dictionary 为 nullptr 时不使用预设字典。
+ */
+std::optional<std::vector<std::byte>> deflate(const ZlibDictionary* dictionary, const std::byte* data, size_t size);
+
+/**
+ * @brief 解压 deflate() 的输出。结果长度与 expected_size 不一致或数据损坏时返回 std::nullopt。
+ */
+std::optional<std::vector<std::byte>> inflate(const ZlibDictionary* dictionary, const std::byte* data, size_t size, size_t expected_size);
+
+}
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+namespace BLAKE3 {
+
+    /// 分块 (chunk) 大小：BLAKE3 把输入按 1 KiB 切分，作为 Merkle 树的叶子
+    inline constexpr size_t CHUNK_LEN = 1024;
+
+    /// 输入达到此长度时，哈希按子树分给多个线程计算
+    inline constexpr size_t PARALLEL_MIN_LENGTH = 1 << 20;
+
+    /**
+     * @brief 计算给定字节数据的 BLAKE3 哈希值 (256 位)。
+     * @details 输入不小于 PARALLEL_MIN_LENGTH 时，左右子树在不同线程中计算 (最多 hardware_concurrency 个)；
+     *  BLAKE3 的树结构只由输入长度决定，结果与单线程计算完全相同。
+     * @return 64 个字符的十六进制哈希字符串。
+     */
+    std::string blake3(const std::vector<std::byte>& data);
+
+    /**
+     * @brief 计算给定文本字符串的 BLAKE3 哈希值。
+     * @return 64 个字符的十六进制哈希字符串。
+     */
+    std::string blake3(const std::string& text_data);
+
+    /**
+     * @brief 用至多 max_threads 个线程计算 BLAKE3 哈希值 (max_threads 为 1 时单线程)。
+     */
+    std::string blake3(const void* data, size_t length, size_t max_threads);
+
+
+    /**
+     * @brief 增量计算 BLAKE3 (用于流式处理大文件，无需将全部内容读入内存)。
+     */
+    class Hasher {
+    public:
+        Hasher();
+
+        /// 追加数据
+        void update(const void* data, size_t length);
+
+        /// 结束计算并返回 64 个字符的十六进制哈希 (调用后对象不应再使用)
+        std::string hex_digest();
+
+    private:
+        void push_chunk_chaining_value(std::array<uint32_t, 8> chaining_value, uint64_t total_chunks);
+
+        std::vector<std::array<uint32_t, 8>> cv_stack_;   ///< 已完成子树的链接值 (chaining value)
+        std::array<uint32_t, 8> chunk_cv_;                ///< 当前分块的链接值
+        std::array<std::byte, 64> block_{};               ///< 当前分块中尚未压缩的块
+        size_t block_length_ = 0;
+        size_t blocks_compressed_ = 0;                    ///< 当前分块中已压缩的块数
+        uint64_t chunk_counter_ = 0;
+    };
+
+};
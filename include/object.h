@@ -4,6 +4,9 @@
 #include <vector>
 #include <filesystem>
 #include <unordered_map>
+#include <optional>
+
+#include "Chunker.h"
 
 namespace Biogit {
 using std::string;
@@ -52,9 +55,10 @@ public:
      * @brief 将当前的 Blob 对象保存到对象库中。
      * 它会序列化对象，计算哈希，然后将序列化的数据写入文件。
      * @param objects_dir_path BioGit 仓库中 'objects' 目录的路径。
+     * @param path_hint 内容对应的工作区文件路径 (可为空)，用于选择存储层编解码器 (见 ObjectCodec.h)。
      * @return 对象的 SHA-1 哈希值 (40字符的十六进制字符串)；如果保存失败则返回 std::nullopt。
      */
-    std::optional<std::string> save(const std::filesystem::path& objects_dir_path) const;
+    std::optional<std::string> save(const std::filesystem::path& objects_dir_path, const std::filesystem::path& path_hint = {}) const;
 
     /**
      * @brief 从对象库中根据 SHA-1 哈希加载 Blob 对象。
@@ -64,6 +68,68 @@ public:
      */
     static std::optional<Blob> load_by_hash(const std::string& hash_hex, const std::filesystem::path& objects_dir_path);
 
+    /**
+     * @brief 读取 Blob 的大小和开头最多 max_bytes 字节的内容，不加载完整内容 (分块存储时只读取第一个 chunk)。
+     * @details 用于二进制检测等只需要抽样的场合；不校验哈希。
+     * @return <内容总大小, 开头部分>；对象不存在或不是 Blob 时返回 std::nullopt。
+     */
+    static std::optional<std::pair<uintmax_t, std::vector<std::byte>>> read_prefix(const std::string& hash_hex,
+                                                                                   const std::filesystem::path& objects_dir_path,
+                                                                                   size_t max_bytes);
+
+
+    // --- 分块存储 (大文件) ---
+    /**
+     * @brief 分块清单对象的类型标识符 ("manifest")。
+     * 清单存放在 Blob 自身的哈希之下，内容格式为：首行 "<总大小>"，之后每行 "<chunk哈希> <chunk大小>"。
+     */
+    static const std::string& manifest_type_str();
+
+    /**
+     * @brief 内容块对象的类型标识符 ("chunk")。格式："chunk <size>\0<data>"，按普通对象计算哈希。
+     */
+    static const std::string& chunk_type_str();
+
+    /**
+     * @brief 以分块形式保存 Blob：内容按 FastCDC 切分为 chunk 对象，再在 Blob 的哈希下写入清单。
+     * @details Blob 的哈希与整体保存时完全相同 (仍是 "blob <size>\0<content>" 的 SHA-1)，
+     * 因此 Tree / Index 中的引用与存储方式无关；已存在的 chunk 不会重复写入，不同版本之间共享未改动的块。
+     * @return Blob 的哈希；失败返回 std::nullopt。
+     */
+    std::optional<std::string> save_chunked(const std::filesystem::path& objects_dir_path, const FastCdcChunker& chunker) const;
+
+    /**
+     * @brief 解析清单内容 (不含头部)，返回其引用的 chunk 哈希 (按顺序，可能重复)。
+     */
+    static std::optional<std::vector<std::string>> parse_manifest_chunks(const std::vector<std::byte>& manifest_content);
+
+    /**
+     * @brief 解析清单内容 (不含头部)，返回各 chunk 的 <哈希, 大小> (按在 Blob 中的顺序)。
+     */
+    static std::optional<std::vector<std::pair<std::string, size_t>>> parse_manifest_entries(const std::vector<std::byte>& manifest_content);
+
+    /**
+     * @brief 按清单从对象库中读取所有 chunk 重组 Blob，并校验重组结果的哈希等于 hash_hex。
+     * @return 重组成功且哈希一致时返回 Blob；缺少 chunk 或校验失败返回 std::nullopt。
+     */
+    static std::optional<Blob> assemble_from_manifest(const std::string& hash_hex,
+                                                      const std::vector<std::byte>& manifest_content,
+                                                      const std::filesystem::path& objects_dir_path);
+
+    /**
+     * @brief 读取分块存储的 Blob 的 chunk 列表 <哈希, 大小>，用于逐块流式读取大文件；整体存储的 Blob 返回空列表。
+     * @details 只读取对象头部判断存储方式，不加载整体存储的 Blob 内容。
+     * @return 对象不存在或清单格式错误时返回 std::nullopt。
+     */
+    static std::optional<std::vector<std::pair<std::string, size_t>>> read_chunk_list(const std::string& hash_hex,
+                                                                                      const std::filesystem::path& objects_dir_path);
+
+    /**
+     * @brief 读取一个内容块的数据，并校验其哈希。
+     * @return 内容块不存在、类型不符或哈希不匹配时返回 std::nullopt。
+     */
+    static std::optional<std::vector<std::byte>> load_chunk(const std::string& chunk_hash_hex,
+                                                            const std::filesystem::path& objects_dir_path);
 
     /**
      * @brief 将 Blob 的内容作为 std::string 返回。
@@ -88,7 +154,7 @@ struct TreeEntry {
     bool is_directory() const;
 
     // 将此单个条目序列化为其字节格式
-    // 格式: "<模式> <名称>\0<40字符的十六进制SHA1哈希>"
+    // 格式: "<模式> <名称>\0<十六进制对象哈希 (SHA-1 为 40 字符，SHA-256/BLAKE3 为 64 字符)>"
     std::vector<std::byte> serialize() const;
 };
 
@@ -107,6 +173,12 @@ public:
     void add_entry(const TreeEntry& entry);
     void add_entry(const std::string& mode, const std::string& name, const std::string& sha1_hash_hex);
 
+    // 一次性设置全部条目 (只排序一次，用于条目很多的目录)
+    void set_entries(std::vector<TreeEntry> new_entries);
+
+    // 按名称查找条目：条目已按 Git 规则排序 (目录名视为带 '/' 后缀)，二分查找；不存在时返回 nullptr
+    const TreeEntry* find_entry(const std::string& name) const;
+
 
     /**
      * @brief 将 Tree 对象序列化为 Git 对象格式的字节流。
@@ -119,9 +191,10 @@ public:
     /**
      * @brief 从已去除 Git 对象头部的原始内容数据反序列化 Tree 对象。
      * @param raw_content_data 仅包含文件原始内容的字节向量。
+     * @param hash_hex_length 条目哈希的十六进制长度 (由仓库的对象格式决定，SHA-1 为 40)。
      * @return 如果成功，返回 Tree 对象；否则返回 std::nullopt
      */
-    static std::optional<Tree> deserialize(const std::vector<std::byte>& raw_content_data);
+    static std::optional<Tree> deserialize(const std::vector<std::byte>& raw_content_data, size_t hash_hex_length = 40);
 
 
     /**
@@ -227,6 +300,16 @@ public:
      */
     static std::optional<Commit> load_by_hash(const std::string& hash_hex, const std::filesystem::path& objects_dir_path);
 };
+
+/**
+ * @brief 已校验的 Commit / Tree 对象内容的进程内缓存 (按内容总字节数限制的 LRU)。
+ * @details 默认关闭；常驻进程 (daemon) 启用后，重复加载同一对象不再读文件、解压和重新校验哈希。
+ *  对象内容由哈希唯一确定，缓存不会过期。
+ */
+namespace ObjectCache {
+    /// 设置缓存容量 (内容总字节数)，超出时淘汰最久未用的对象；0 表示关闭并清空
+    void set_capacity(size_t bytes);
+}
 }
 
 
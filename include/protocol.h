@@ -16,6 +16,8 @@ namespace Protocol {
 const uint16_t HEAD_ID_LEN = 2; // 消息ID长度
 const uint16_t HEAD_DATA_LEN_FIELD = 4; // 消息体长度字段的长度
 const uint16_t HEAD_TOTAL_LEN = HEAD_ID_LEN + HEAD_DATA_LEN_FIELD; // 总头部长度 = 消息ID长度 + 消息体长度字段的长度
+const uint32_t MAX_PUT_OBJECT_DATA_LEN = UINT32_MAX - 40; // 一条 PUT_OBJECT 消息能携带的对象数据上限 (消息体长度字段为 4 字节，去掉 40 字节哈希)
+const uint32_t MAX_LFS_CHECK_OIDS = 65536;            // 一条 LFS_CHECK 消息最多询问的 oid 数，更多时由客户端分批发送
 
 
 // -------------------- Biogit 特定消息ID --------------------
@@ -28,7 +30,14 @@ const uint16_t MSG_REQ_GET_OBJECT = 2002;            // 客户端请求获取特
 const uint16_t MSG_REQ_CHECK_OBJECTS = 2003;         // 客户端发送一批哈希，询问服务器哪些已存在
 const uint16_t MSG_REQ_PUT_OBJECT = 2004;            // 客户端准备发送一个完整的 Git 对象
 const uint16_t MSG_REQ_UPDATE_REF = 2005;            // 客户端请求服务器更新某个引用
+const uint16_t MSG_REQ_LFS_CHECK = 2006;             // 客户端询问服务器内容库中哪些大文件内容已存在
+const uint16_t MSG_REQ_LFS_PUT_BLOCK = 2007;         // 客户端上传大文件内容的一个数据块
+const uint16_t MSG_REQ_LFS_GET_BLOCK = 2008;         // 客户端请求大文件内容的一个数据块
+const uint16_t MSG_REQ_DICT_NEGOTIATE = 2009;        // 客户端发送本地已有的字典编号，与服务器协商小对象传输使用的预设字典
 const uint16_t MSG_REQ_TARGET_REPO = 2010;           // 客户端指定目标仓库路径
+const uint16_t MSG_REQ_DICT_GET = 2011;              // 客户端下载服务器的预设字典
+const uint16_t MSG_REQ_PUT_OBJECT_DEFLATED = 2012;   // 客户端以协商的字典压缩后上传一个小对象
+const uint16_t MSG_REQ_PUT_OBJECT_DELTA = 2013;      // 客户端以服务器已有对象为基准，上传一个对象的二进制增量
 
 // --- 用户认证请求ID ---
 const uint16_t MSG_REQ_REGISTER_USER = 2020;        // 客户端请求注册新用户
@@ -48,6 +57,10 @@ const uint16_t MSG_RESP_OBJECT_NOT_FOUND = 3007;     // 服务器未找到客户
 const uint16_t MSG_RESP_CHECK_OBJECTS_RESULT = 3008; // 服务器响应对象存在性检查
 const uint16_t MSG_RESP_REF_UPDATED = 3009;          // 服务器成功更新了引用
 const uint16_t MSG_RESP_REF_UPDATE_DENIED = 3010;    // 服务器拒绝更新引用
+const uint16_t MSG_RESP_LFS_BLOCK = 3011;            // 服务器发送大文件内容的一个数据块
+const uint16_t MSG_RESP_DICT_SELECTED = 3012;        // 服务器回复协商出的字典编号
+const uint16_t MSG_RESP_DICT_CONTENT = 3013;         // 服务器发送预设字典的内容
+const uint16_t MSG_RESP_OBJECT_CONTENT_DEFLATED = 3014; // 服务器发送以字典压缩的对象内容
 const uint16_t MSG_RESP_TARGET_REPO_ACK = 3020;      // 服务器确认仓库已选定
 const uint16_t MSG_RESP_TARGET_REPO_ERROR = 3021;    // 服务器无法找到或加载仓库
 
@@ -87,6 +100,38 @@ inline bool unpack_header(const char* buffer, uint16_t& msg_id, uint32_t& body_l
     return true;
 }
 
+// 大文件传输中的偏移和长度使用 8 字节网络字节序 (大端) 整数
+inline void pack_u64(char* buffer, uint64_t value) {
+    for (int i = 7; i >= 0; --i) {
+        buffer[i] = static_cast<char>(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+inline uint64_t unpack_u64(const char* buffer) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value = (value << 8) | static_cast<unsigned char>(buffer[i]);
+    }
+    return value;
+}
+
+// 字典编号、对象长度等使用 4 字节网络字节序 (大端) 整数
+inline void pack_u32(char* buffer, uint32_t value) {
+    for (int i = 3; i >= 0; --i) {
+        buffer[i] = static_cast<char>(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+inline uint32_t unpack_u32(const char* buffer) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value = (value << 8) | static_cast<unsigned char>(buffer[i]);
+    }
+    return value;
+}
+
 
 // -------------------- 消息体内容的约定 --------------------
 /*
@@ -129,9 +174,10 @@ inline bool unpack_header(const char* buffer, uint16_t& msg_id, uint32_t& body_l
               (Token 后的内容为空，但分隔符 '\0' 存在，表示原始消息体部分长度为0)
 
     MSG_REQ_GET_OBJECT (2002):
-        Actual Request Payload: <40_char_sha1_hash_string>
+        Actual Request Payload: <40_char_sha1_hash_string>[<dict_id_uint32_t_net>]
         说明: 请求获取特定哈希的 Git 对象。哈希字符串固定40字节，不含 '\0'。
-        完整 Body: <token_str_with_null_term>\0<40_char_sha1_hash_string>
+              附带协商出的字典编号时，小型 Tree/Commit 以 MSG_RESP_OBJECT_CONTENT_DEFLATED 返回，其余对象仍以 MSG_RESP_OBJECT_CONTENT 返回。
+        完整 Body: <token_str_with_null_term>\0<40_char_sha1_hash_string>[<dict_id_uint32_t_net>]
 
     MSG_REQ_CHECK_OBJECTS (2003):
         Actual Request Payload: <num_hashes_uint32_t_net><40_char_sha1_1><40_char_sha1_2>...
@@ -154,6 +200,36 @@ inline bool unpack_header(const char* buffer, uint16_t& msg_id, uint32_t& body_l
               - optional_old_hash_40char_if_any (可选的40字节): 期望的旧 commit 哈希。如果提供，则其紧跟 new_hash。
         完整 Body: <token_str_with_null_term>\0<force_flag_byte><ref_name_str_with_null_term><new_hash_40char>[<optional_old_hash_40char_if_any>]
 
+    MSG_REQ_LFS_CHECK (2006):
+        Actual Request Payload: <num_oids_uint32_t_net><40_char_oid_1><40_char_oid_2>...
+        说明: 格式同 MSG_REQ_CHECK_OBJECTS，但检查的是服务器大文件内容库 (.biogit/lfs/) 中的内容 oid。
+              服务器以 MSG_RESP_CHECK_OBJECTS_RESULT 响应。
+
+    MSG_REQ_LFS_PUT_BLOCK (2007):
+        Actual Request Payload: <40_char_oid><offset_uint64_t_net><total_size_uint64_t_net><block_data>
+        说明: 上传大文件内容的一个数据块 (每块至多 LfsStore::BLOCK_SIZE 字节)。块必须按偏移顺序发送，
+              offset 为 0 时服务器重新开始接收；收齐 total_size 字节后服务器校验 oid 并移入内容库。
+              服务器以 MSG_RESP_ACK_OK (Body 为 oid) 或 MSG_RESP_ERROR 响应。
+
+    MSG_REQ_LFS_GET_BLOCK (2008):
+        Actual Request Payload: <40_char_oid><offset_uint64_t_net>
+        说明: 请求大文件内容从 offset 开始的一个数据块。
+              服务器以 MSG_RESP_LFS_BLOCK 响应；内容不存在时以 MSG_RESP_OBJECT_NOT_FOUND 响应。
+
+    MSG_REQ_DICT_NEGOTIATE (2009):
+        Actual Request Payload: <num_ids_uint32_t_net><dict_id_1_uint32_t_net><dict_id_2_uint32_t_net>...
+        说明: 客户端列出本地已有的预设字典编号 (当前字典在前)。服务器以 MSG_RESP_DICT_SELECTED 响应：
+              客户端也有服务器的当前字典时选用它，否则选用列表中第一个服务器也有的字典，都没有时为 0 (不使用字典)。
+
+    MSG_REQ_DICT_GET (2011):
+        Actual Request Payload: <dict_id_uint32_t_net>
+        说明: 下载服务器的一个预设字典。服务器以 MSG_RESP_DICT_CONTENT 响应；字典不存在时以 MSG_RESP_OBJECT_NOT_FOUND 响应。
+
+    MSG_REQ_PUT_OBJECT_DEFLATED (2012):
+        Actual Request Payload: <40_char_sha1_hash_from_client><dict_id_uint32_t_net><raw_length_uint32_t_net><deflate_data>
+        说明: 同 MSG_REQ_PUT_OBJECT，但对象的完整原始内容 (含 "type size\0") 以协商出的字典做 raw deflate 压缩。
+              服务器解压后按 MSG_REQ_PUT_OBJECT 的规则校验哈希并写入。
+
 
     ----------------------------------------------
     C. 测试消息 (通常无需认证)
@@ -217,6 +293,21 @@ inline bool unpack_header(const char* buffer, uint16_t& msg_id, uint32_t& body_l
         Body: (可选) <reason_message_str_with_null_term>
         说明: 服务器拒绝更新引用。消息体可以为空，或包含拒绝的原因。
 
+    MSG_RESP_LFS_BLOCK (3011):
+        Body: <40_char_oid><offset_uint64_t_net><total_size_uint64_t_net><block_data>
+        说明: 大文件内容的一个数据块。block_data 为空表示 offset 已到达内容末尾。
+
+    MSG_RESP_DICT_SELECTED (3012):
+        Body: <selected_dict_id_uint32_t_net><server_current_dict_id_uint32_t_net>
+        说明: 协商结果 (0 表示不使用字典) 和服务器的当前字典编号 (0 表示服务器尚未训练字典)。
+
+    MSG_RESP_DICT_CONTENT (3013):
+        Body: <dict_id_uint32_t_net><dict_data>
+
+    MSG_RESP_OBJECT_CONTENT_DEFLATED (3014):
+        Body: <40_char_sha1_hash_string_of_object><dict_id_uint32_t_net><raw_length_uint32_t_net><deflate_data>
+        说明: 同 MSG_RESP_OBJECT_CONTENT，但对象的完整原始内容以请求中给出的字典做 raw deflate 压缩。
+
     MSG_RESP_TARGET_REPO_ACK (3020):
         Body: (可选) <success_message_str_with_null_term>
         说明: 服务器确认仓库已成功选定。消息体可以为空或包含确认信息。
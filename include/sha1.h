@@ -1,6 +1,10 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
 namespace SHA1 {
     using std::string;
 
@@ -19,6 +23,27 @@ namespace SHA1 {
     std::string sha1(const std::string& text_data);
 
 
+    /**
+     * @brief 增量计算 SHA-1 (用于流式处理大文件，无需将全部内容读入内存)。
+     */
+    class Hasher {
+    public:
+        Hasher();
+
+        /// 追加数据
+        void update(const void* data, size_t length);
+
+        /// 结束计算并返回 40 个字符的十六进制哈希 (调用后对象不应再使用)
+        std::string hex_digest();
+
+    private:
+        std::array<uint32_t, 5> h_;
+        std::array<std::byte, 64> buffer_{};
+        size_t buffer_length_ = 0;
+        uint64_t total_length_ = 0;
+    };
+
+
     // 可变参数版本，使用 string 相加
     template<typename ... Args>
     string sha1(const Args &...args) {
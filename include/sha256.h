@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+namespace SHA256 {
+
+    /**
+     * @brief 计算给定字节数据的 SHA-256 哈希值。
+     * @param data 要计算哈希的字节向量。
+     * @return 64 个字符的十六进制 SHA-256 哈希字符串。
+     */
+    std::string sha256(const std::vector<std::byte>& data);
+
+    /**
+     * @brief 计算给定文本字符串的 SHA-256 哈希值。
+     * @return 64 个字符的十六进制 SHA-256 哈希字符串。
+     */
+    std::string sha256(const std::string& text_data);
+
+
+    /**
+     * @brief 增量计算 SHA-256 (用于流式处理大文件，无需将全部内容读入内存)。
+     */
+    class Hasher {
+    public:
+        Hasher();
+
+        /// 追加数据
+        void update(const void* data, size_t length);
+
+        /// 结束计算并返回 64 个字符的十六进制哈希 (调用后对象不应再使用)
+        std::string hex_digest();
+
+    private:
+        std::array<uint32_t, 8> h_;
+        std::array<std::byte, 64> buffer_{};
+        size_t buffer_length_ = 0;
+        uint64_t total_length_ = 0;
+    };
+
+};
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include <sstream>
+#include <iostream>
 
 
 namespace Utils {
@@ -40,6 +41,26 @@ struct LineEditOperation {
 std::vector<LineEditOperation> MyersDiffLines(const std::vector<std::string>& A, const std::vector<std::string>& B);
 
 
+/**
+ * @brief 统计从 A 到 B 新增和删除的行数 (用于 diff --stat)。
+ * @details 先剥离两边相同的前缀和后缀行，只对中间不同的部分运行 Myers，
+ * 对 “文件末尾追加” 等常见改动几乎是线性时间。
+ * @return <新增行数, 删除行数>
+ */
+std::pair<int, int> count_line_changes(const std::vector<std::string>& A, const std::vector<std::string>& B);
+
+
+/// 二进制检测抽样的字节数 (只看内容开头)
+inline constexpr size_t BINARY_SNIFF_SIZE = 8000;
+
+/**
+ * @brief 判断内容是否为二进制：抽样范围内含有 NUL 字节，或控制字符超过 10%。
+ * @details gzip/BAM/CRAM 等压缩格式的开头几乎必然满足其一；UTF-8 多字节字符按文本处理。
+ * @param size 可用的字节数，只检查前 BINARY_SNIFF_SIZE 字节。
+ */
+bool looks_binary(const char* data, size_t size);
+
+
 /**
  * @brief 打印统一差异格式 (Unified Diff Format)
  * @param file_path:
@@ -67,6 +88,24 @@ void print_unified_diff(
     const std::string& new_file_label_suffix,
     int num_context_lines = 3);
 
+/**
+ * @brief 打印统一差异格式，旧/新文件路径可以不同 (用于重命名/复制)。
+ * @param old_file_path 旧文件路径 (a/...)
+ * @param new_file_path 新文件路径 (b/...)
+ * @param extended_header_lines 紧跟在 "diff --biogit" 行之后的扩展头 (例如 "rename from ...")。
+ * @param out 输出流 (默认 std::cout；并行 diff 时为每个文件独立的缓冲区)。
+ * 内容无变化但扩展头非空时，只打印文件识别头和扩展头。
+ */
+void print_unified_diff(
+    const std::filesystem::path& old_file_path,
+    const std::filesystem::path& new_file_path,
+    const std::vector<LineEditOperation>& ses,
+    const std::string& old_file_label_suffix,
+    const std::string& new_file_label_suffix,
+    int num_context_lines,
+    const std::vector<std::string>& extended_header_lines,
+    std::ostream& out = std::cout);
+
 
 /**
  * @brief 检查 target_path 是否等于 base_path_spec，或者是否是 base_dir_spec 的子目录/子文件。
@@ -77,6 +116,13 @@ void print_unified_diff(
  */
 bool is_path_under_or_equal(const std::filesystem::path& target_path, const std::filesystem::path& base_dir_spec);
 
+/**
+ * @brief 写入 final_path 时使用的临时文件路径 (与 final_path 同目录，进程号 + 进程内序号保证唯一)。
+ * @details 多个线程或进程同时写入同一个目标 (例如内容相同的两个文件得到同一个对象) 时各写各的临时文件，
+ *  再重命名到目标，不会互相截断。
+ */
+std::filesystem::path unique_temp_path(const std::filesystem::path& final_path);
+
 
 // ---  Token ---
 /**
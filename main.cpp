@@ -3,12 +3,14 @@
 #include <vector>
 #include <optional>
 #include <filesystem>   // C++17 文件系统库
+#include <fstream>
 #include <numeric>      // For std::accumulate (如果需要拼接字符串)
 #include <algorithm>    // For std::find, std::all_of (检查字符串是否都是十六进制数字)
 #include <memory>       // For std::shared_ptr
 #include <condition_variable> // 用于服务器主循环的等待
 #include <mutex>          // 用于服务器主循环的等待
 #include <future>         // 用于服务器主循环的等待
+#include <cstdlib>        // std::getenv
 
 #include "include/Repository.h"
 #include "include/utils.h"
@@ -18,6 +20,7 @@
 #include "include/UserManager.h"
 #include "include/AsyncLogger.h"
 #include "include/protocol.h"
+#include "include/LocalDaemon.h"
 
 // --- 处理函数的向前声明 ---
 void print_usage(); // 打印用法信息
@@ -28,14 +31,19 @@ void handle_add(Biogit::Repository& repo, const std::vector<std::string>& args);
 void handle_commit(Biogit::Repository& repo, const std::vector<std::string>& args);
 void handle_status(Biogit::Repository& repo, const std::vector<std::string>& args);
 void handle_log(Biogit::Repository& repo, const std::vector<std::string>& args);
+void handle_blame(Biogit::Repository& repo, const std::vector<std::string>& args);
 void handle_branch(Biogit::Repository& repo, const std::vector<std::string>& args);
 void handle_switch(Biogit::Repository& repo, const std::vector<std::string>& args);
+void handle_worktree(Biogit::Repository& repo, const std::vector<std::string>& args);
 void handle_tag(Biogit::Repository& repo, const std::vector<std::string>& args);
 void handle_diff(Biogit::Repository& repo, const std::vector<std::string>& args);
 void handle_rm_cached(Biogit::Repository& repo, const std::vector<std::string>& args);
 void handle_rm(Biogit::Repository& repo, const std::vector<std::string>& args);
 void handle_show(Biogit::Repository& repo, const std::vector<std::string>& args);
+bool handle_cat_file(Biogit::Repository& repo, const std::vector<std::string>& args);
+bool handle_ls_tree(Biogit::Repository& repo, const std::vector<std::string>& args);
 void handle_merge(Biogit::Repository& repo, const std::vector<std::string>& args);
+void handle_gc(Biogit::Repository& repo, const std::vector<std::string>& args);
 
 // 配置命令处理函数
 void handle_config(Biogit::Repository* repo, const std::vector<std::string>& args); // repo 可以为 nullptr (例如全局配置)
@@ -46,6 +54,11 @@ void handle_remote(Biogit::Repository& repo, const std::vector<std::string>& arg
 void handle_fetch(Biogit::Repository& repo, const std::vector<std::string>& args);
 void handle_push(Biogit::Repository& repo, const std::vector<std::string>& args);
 void handle_pull(Biogit::Repository& repo, const std::vector<std::string>& args);
+void handle_bundle(Biogit::Repository& repo, const std::vector<std::string>& args);
+bool handle_fast_import(Biogit::Repository& repo, const std::vector<std::string>& args);
+bool handle_fast_export(Biogit::Repository& repo, const std::vector<std::string>& args);
+bool handle_archive(Biogit::Repository& repo, const std::vector<std::string>& args);
+bool handle_daemon(Biogit::Repository& repo, const std::vector<std::string>& args);
 
 // 客户端用户认证命令处理函数
 void handle_register_user(const std::vector<std::string>& args);
@@ -53,29 +66,37 @@ void handle_login_user(const std::vector<std::string>& args);
 
 // 服务器命令处理函数
 void handle_server_start(const std::vector<std::string>& args);
+void handle_server_fork(const std::vector<std::string>& args);
 
 // 打印程序用法和支持的命令
 void print_usage() {
     std::cout << "用法: biogit2 <命令> [<参数>...]" << std::endl; 
     std::cout << "\n常用的本地命令:" << std::endl; 
-    std::cout << "  init [<路径>]               创建空 BioGit 仓库或重新初始化现有仓库" << std::endl; 
+    std::cout << "  init [--object-format=<sha1|sha256|blake3>] [<路径>]  创建空 BioGit 仓库或重新初始化现有仓库" << std::endl; 
     std::cout << "  add <路径规则>...         将文件内容添加到索引区" << std::endl; 
     std::cout << "  status                    显示工作区状态" << std::endl; 
     std::cout << "  commit -m <消息>       记录变更到仓库" << std::endl; 
-    std::cout << "  log                       显示提交日志" << std::endl; 
+    std::cout << "  log [--] [<路径>...]      显示提交日志 (可限定为改动过指定路径的提交)" << std::endl; 
+    std::cout << "  blame [<提交>] [--] <文件> 逐行显示文件的最后修改提交和作者" << std::endl; 
     std::cout << "  branch                    列出、创建或删除分支" << std::endl; 
     std::cout << "  branch <名称> [<起点>]   创建新分支" << std::endl; 
     std::cout << "  branch (-d | -D) <名称>   删除分支" << std::endl; 
     std::cout << "  switch <分支或提交>      切换分支或恢复工作区文件" << std::endl; 
+    std::cout << "  worktree add <路径> <分支> | list  管理共享对象库的多个工作树" << std::endl; 
     std::cout << "  tag                       列出、创建或删除标签" << std::endl; 
     std::cout << "  tag <名称> [<提交>]     创建新标签" << std::endl; 
     std::cout << "  tag -d <名称>             删除标签" << std::endl; 
-    std::cout << "  diff [--staged] [<c1> <c2>] [<路径>...]" << std::endl; 
+    std::cout << "  diff [--staged] [--stat | --name-only | --name-status] [--no-renames] [-M<相似度>] [-C]" << std::endl; 
+    std::cout << "       [<c1> <c2>] [<路径>...]" << std::endl; 
     std::cout << "                            显示提交之间、提交和工作区等之间的差异" << std::endl; 
     std::cout << "  rm <路径规则>...          从工作区和索引区移除文件" << std::endl; 
     std::cout << "  rm-cached <路径规则>...   从索引区移除文件" << std::endl; 
-    std::cout << "  show <对象>             显示各种类型的对象 (blob, tree, commit, tag)" << std::endl; 
+    std::cout << "  show <对象>             显示各种类型的对象 (blob, tree, commit, tag)，对象可写作 <提交>:<路径>" << std::endl; 
+    std::cout << "  ls-tree <提交> [<路径>]   列出提交中某个目录的条目 (路径以 '/' 结尾时列出其内容)" << std::endl;
+    std::cout << "  cat-file (--batch | --batch-check)   从标准输入批量查询对象 (常驻进程)" << std::endl;
     std::cout << "  merge <分支或提交>      合并两个或多个开发历史" << std::endl; 
+    std::cout << "  gc                        训练小对象的压缩字典并重新编码对象库" << std::endl; 
+    std::cout << "  daemon (start | stop | status)   管理仓库的常驻进程 (status/log/diff/show/ls-tree/branch 自动交给它执行)" << std::endl;
 
     std::cout << "\n配置:" << std::endl; 
     std::cout << "  config <键> [<值>]    获取和设置仓库或全局选项" << std::endl; 
@@ -83,6 +104,10 @@ void print_usage() {
 
     std::cout << "\n远程仓库操作 (客户端):" << std::endl; 
     std::cout << "  clone <URL> [<目录>]       克隆仓库到新目录" << std::endl; 
+    std::cout << "  bundle create <文件> <引用>... | unbundle <文件> [<远程名>]  离线传输包" << std::endl; 
+    std::cout << "  fast-import [--force]                   从标准输入批量导入提交" << std::endl;
+    std::cout << "  fast-export <引用>...                   把历史导出为导入流 (标准输出)" << std::endl;
+    std::cout << "  archive [--format=tar|tgz] [--prefix=<前缀>/] [-o <文件>] <提交> [<路径>]  不检出直接打包为 tar" << std::endl;
     std::cout << "  remote add <名称> <URL>   添加远程仓库" << std::endl; 
     std::cout << "  remote remove <名称>      移除远程仓库" << std::endl; 
     std::cout << "  remote -v                 列出远程仓库及其URL" << std::endl; 
@@ -100,6 +125,8 @@ void print_usage() {
     std::cout << "\n服务器操作:" << std::endl; 
     std::cout << "  server start <端口> <仓库根目录> <用户数据文件> <Token密钥> [<日志目录>] [<日志文件名前缀>]" << std::endl; 
     std::cout << "                            启动 BioGit 服务器" << std::endl; 
+    std::cout << "  server fork <仓库根目录> <源仓库> <新仓库>" << std::endl;
+    std::cout << "                            在服务器上 fork 仓库 (对象存放于共享对象池)" << std::endl;
     std::cout << std::endl; 
 }
 
@@ -116,9 +143,37 @@ bool parse_host_port(const std::string& addr_str, std::string& host, std::string
 }
 
 std::string server_addr_str = "localhost:10088";
+std::streambuf* stderr_buffer = nullptr; // 标准错误原来的缓冲区 (main 开头把 std::cerr 并入了标准输出)
+
+// 向标准输出写数据流的命令 (fast-export、archive、cat-file)：标准输出只写数据，诊断信息写回标准错误
+void use_stdout_for_data() {
+    std::ios::sync_with_stdio(false); // 数据可能很大，不与 C stdio 同步
+    std::cerr.rdbuf(stderr_buffer);
+}
+
+// 可以交给常驻进程执行的只读命令
+bool is_daemon_command(const std::string& command, const std::vector<std::string>& args) {
+    return command == "status" || command == "log" || command == "diff" || command == "show" || command == "ls-tree" ||
+           (command == "branch" && args.empty());
+}
+
+// 常驻进程中执行一条只读命令，返回退出码
+int run_daemon_command(Biogit::Repository& repo, const std::string& command, const std::vector<std::string>& args) {
+    if (!is_daemon_command(command, args)) {
+        std::cerr << "错误: 常驻进程不执行 '" << command << "' 命令。" << std::endl;
+        return 1;
+    }
+    if (command == "status") handle_status(repo, args);
+    else if (command == "log") handle_log(repo, args);
+    else if (command == "diff") handle_diff(repo, args);
+    else if (command == "show") handle_show(repo, args);
+    else if (command == "ls-tree") return handle_ls_tree(repo, args) ? 0 : 1;
+    else handle_branch(repo, args);
+    return 0;
+}
 
 int main(int argc, char* argv[]) {
-    std::cerr.rdbuf(std::cout.rdbuf());
+    stderr_buffer = std::cerr.rdbuf(std::cout.rdbuf());
 
     if (argc < 2) { // 如果参数少于2个 (程序名 + 命令)，则打印用法并退出
         print_usage();
@@ -160,6 +215,13 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    // 只读命令优先交给仓库的常驻进程执行；没有常驻进程或连接失败时在本进程执行
+    if (repo_opt && is_daemon_command(command, args) && !std::getenv("BIOGIT_NO_DAEMON")) {
+        if (auto exit_code = Biogit::LocalDaemon::forward(repo_opt->get_mygit_directory(), command, args)) {
+            return *exit_code;
+        }
+    }
+
     // 命令分发和执行
     try {
         if (command == "init") {
@@ -176,12 +238,18 @@ int main(int argc, char* argv[]) {
         } else if (command == "log") {
             if (!repo_opt) { std::cerr << "错误：'log' 命令未加载仓库。" << std::endl; return 128; }
             handle_log(*repo_opt, args);
+        } else if (command == "blame") {
+            if (!repo_opt) { std::cerr << "错误：'blame' 命令未加载仓库。" << std::endl; return 128; }
+            handle_blame(*repo_opt, args);
         } else if (command == "branch") {
             if (!repo_opt) { std::cerr << "错误：'branch' 命令未加载仓库。" << std::endl; return 128; }
             handle_branch(*repo_opt, args);
         } else if (command == "switch") {
             if (!repo_opt) { std::cerr << "错误：'switch' 命令未加载仓库。" << std::endl; return 128; }
             handle_switch(*repo_opt, args);
+        } else if (command == "worktree") {
+            if (!repo_opt) { std::cerr << "错误：'worktree' 命令未加载仓库。" << std::endl; return 128; }
+            handle_worktree(*repo_opt, args);
         } else if (command == "tag") {
             if (!repo_opt) { std::cerr << "错误：'tag' 命令未加载仓库。" << std::endl; return 128; }
             handle_tag(*repo_opt, args);
@@ -197,9 +265,18 @@ int main(int argc, char* argv[]) {
         } else if (command == "show"){
              if (!repo_opt) { std::cerr << "错误：'show' 命令未加载仓库。" << std::endl; return 128; }
              handle_show(*repo_opt, args);
+        } else if (command == "cat-file") {
+            if (!repo_opt) { std::cerr << "错误：'cat-file' 命令未加载仓库。" << std::endl; return 128; }
+            if (!handle_cat_file(*repo_opt, args)) return 1;
+        } else if (command == "ls-tree") {
+            if (!repo_opt) { std::cerr << "错误：'ls-tree' 命令未加载仓库。" << std::endl; return 128; }
+            if (!handle_ls_tree(*repo_opt, args)) return 1;
         } else if (command == "merge"){
             if (!repo_opt) { std::cerr << "错误：'merge' 命令未加载仓库。" << std::endl; return 128; }
             handle_merge(*repo_opt, args);
+        } else if (command == "gc") {
+            if (!repo_opt) { std::cerr << "错误：'gc' 命令未加载仓库。" << std::endl; return 128; }
+            handle_gc(*repo_opt, args);
         } else if (command == "config") {
             // config 命令可能在仓库内外执行 (例如 --global)，所以 repo_opt 可能为空
             handle_config(repo_opt.has_value() ? &(*repo_opt) : nullptr, args);
@@ -217,12 +294,31 @@ int main(int argc, char* argv[]) {
         } else if (command == "pull") {
             if (!repo_opt) { std::cerr << "错误：'pull' 命令未加载仓库。" << std::endl; return 128; }
             handle_pull(*repo_opt, args);
+        } else if (command == "bundle") {
+            if (!repo_opt) { std::cerr << "错误：'bundle' 命令未加载仓库。" << std::endl; return 128; }
+            handle_bundle(*repo_opt, args);
+        } else if (command == "fast-import") {
+            if (!repo_opt) { std::cerr << "错误：'fast-import' 命令未加载仓库。" << std::endl; return 128; }
+            if (!handle_fast_import(*repo_opt, args)) return 1;
+        } else if (command == "fast-export") {
+            if (!repo_opt) { std::cerr << "错误：'fast-export' 命令未加载仓库。" << std::endl; return 128; }
+            if (!handle_fast_export(*repo_opt, args)) return 1;
+        } else if (command == "archive") {
+            if (!repo_opt) { std::cerr << "错误：'archive' 命令未加载仓库。" << std::endl; return 128; }
+            if (!handle_archive(*repo_opt, args)) return 1;
+        } else if (command == "daemon") {
+            if (!repo_opt) { std::cerr << "错误：'daemon' 命令未加载仓库。" << std::endl; return 128; }
+            if (!handle_daemon(*repo_opt, args)) return 1;
         } else if (command == "register") { // 客户端注册命令
             handle_register_user(args);
         } else if (command == "login") {    // 客户端登录命令
             handle_login_user(args);
         } else if (command == "server") {   // 服务器相关命令
-            handle_server_start(args);
+            if (!args.empty() && args[0] == "fork") {
+                handle_server_fork(args);
+            } else {
+                handle_server_start(args);
+            }
         } else if (command == "help" || command == "--help" || command == "-h") { // 帮助命令
             print_usage();
         }
@@ -243,10 +339,21 @@ int main(int argc, char* argv[]) {
 // 处理 'init' 命令
 void handle_init(const std::vector<std::string>& args) {
     std::filesystem::path repo_path = "."; // 默认为当前目录
-    if (!args.empty()) {
-        repo_path = args[0];
+    Biogit::ObjectFormat::Algorithm object_format = Biogit::ObjectFormat::Algorithm::SHA1;
+    const std::string format_option = "--object-format=";
+    for (const auto& arg : args) {
+        if (arg.starts_with(format_option)) {
+            auto format_opt = Biogit::ObjectFormat::parse(arg.substr(format_option.size()));
+            if (!format_opt) {
+                std::cerr << "错误: 未知的对象格式 '" << arg.substr(format_option.size()) << "' (可选 sha1、sha256、blake3)。" << std::endl;
+                return;
+            }
+            object_format = *format_opt;
+        } else {
+            repo_path = arg;
+        }
     }
-    auto repo = Biogit::Repository::init(repo_path);
+    auto repo = Biogit::Repository::init(repo_path, object_format);
 }
 
 // 处理 'add' 命令
@@ -287,7 +394,38 @@ void handle_status(Biogit::Repository& repo, const std::vector<std::string>& arg
 
 
 void handle_log(Biogit::Repository& repo, const std::vector<std::string>& args) {
-    repo.log();
+    // biogit2 log [--] [<路径>...]
+    std::vector<std::filesystem::path> paths_filter;
+    for (const auto& arg : args) {
+        if (arg == "--") continue;
+        paths_filter.push_back(arg);
+    }
+    repo.log(paths_filter);
+}
+
+// 处理 'blame' 命令
+void handle_blame(Biogit::Repository& repo, const std::vector<std::string>& args) {
+    // biogit2 blame [<提交>] [--] <文件>
+    std::vector<std::string> positional;
+    bool seen_separator = false;
+    std::string file_arg;
+    for (const auto& arg : args) {
+        if (arg == "--" && !seen_separator) { seen_separator = true; continue; }
+        if (seen_separator) { file_arg = arg; } else { positional.push_back(arg); }
+    }
+    std::string commit_ish = "HEAD";
+    if (file_arg.empty() && positional.size() == 1) {
+        file_arg = positional[0];
+    } else if (file_arg.empty() && positional.size() == 2) {
+        commit_ish = positional[0];
+        file_arg = positional[1];
+    } else if (!file_arg.empty() && positional.size() == 1) {
+        commit_ish = positional[0];
+    } else if (file_arg.empty() || !positional.empty()) {
+        std::cerr << "用法: biogit2 blame [<提交>] [--] <文件>" << std::endl;
+        return;
+    }
+    repo.blame(file_arg, commit_ish);
 }
 
 // 处理 'branch' 命令
@@ -318,6 +456,18 @@ void handle_switch(Biogit::Repository& repo, const std::vector<std::string>& arg
     repo.switch_branch(args[0]); //
 }
 
+// 处理 'worktree' 命令
+void handle_worktree(Biogit::Repository& repo, const std::vector<std::string>& args) {
+    if (!args.empty() && args[0] == "add" && args.size() == 3) {
+        repo.worktree_add(args[1], args[2]);
+    } else if (!args.empty() && args[0] == "list" && args.size() == 1) {
+        repo.worktree_list();
+    } else {
+        std::cerr << "用法: biogit2 worktree add <路径> <分支>" << std::endl;
+        std::cerr << "   或: biogit2 worktree list" << std::endl;
+    }
+}
+
 // 处理 'tag' 命令
 void handle_tag(Biogit::Repository& repo, const std::vector<std::string>& args) {
     if (args.empty()) { // 列出所有标签
@@ -349,6 +499,35 @@ void handle_diff(Biogit::Repository& repo, const std::vector<std::string>& args)
         remaining_args.erase(staged_it); // 从剩余参数中移除 --staged
     }
 
+    // 检查输出格式选项 (--stat, --name-only, --name-status) 和重命名/复制检测选项 (--no-renames, -M[<相似度>], -C / --find-copies)
+    for (auto it = remaining_args.begin(); it != remaining_args.end();) {
+        if (*it == "--stat") {
+            options.output_format = Biogit::DiffOutputFormat::STAT;
+        } else if (*it == "--name-only") {
+            options.output_format = Biogit::DiffOutputFormat::NAME_ONLY;
+        } else if (*it == "--name-status") {
+            options.output_format = Biogit::DiffOutputFormat::NAME_STATUS;
+        } else if (*it == "--no-renames") {
+            options.detect_renames = false;
+        } else if (*it == "-C" || *it == "--find-copies") {
+            options.detect_copies = true;
+        } else if (it->rfind("-M", 0) == 0) {
+            options.detect_renames = true;
+            if (it->length() > 2) {
+                try {
+                    options.rename_similarity = std::stoi(it->substr(2));
+                } catch (const std::exception&) {
+                    std::cerr << "错误: 无效的相似度 '" << *it << "'。" << std::endl;
+                    return;
+                }
+            }
+        } else {
+            ++it;
+            continue;
+        }
+        it = remaining_args.erase(it);
+    }
+
     // 根据剩余参数数量判断 diff 类型
     if (remaining_args.size() >= 2 && !(remaining_args[0].rfind("-",0)==0) && !(remaining_args[1].rfind("-",0)==0) ) {
         // diff <commit1> <commit2> [<路径>...]
@@ -394,12 +573,32 @@ void handle_rm_cached(Biogit::Repository& repo, const std::vector<std::string>&
 // 处理 'show' 命令
 void handle_show(Biogit::Repository& repo, const std::vector<std::string>& args){
     if(args.empty()){
-        std::cerr << "用法: biogit2 show <对象哈希前缀>" << std::endl;
+        std::cerr << "用法: biogit2 show <对象哈希前缀 | 分支或标签 | 提交:路径>" << std::endl;
         return;
     }
     repo.show_object_by_hash(args[0]); //
 }
 
+// 处理 'ls-tree' 命令
+bool handle_ls_tree(Biogit::Repository& repo, const std::vector<std::string>& args) {
+    // biogit2 ls-tree <提交> [<路径>]
+    if (args.empty() || args.size() > 2) {
+        std::cerr << "用法: biogit2 ls-tree <提交> [<路径>]" << std::endl;
+        return false;
+    }
+    return repo.ls_tree(args[0], args.size() == 2 ? args[1] : "");
+}
+
+// 处理 'cat-file' 命令
+bool handle_cat_file(Biogit::Repository& repo, const std::vector<std::string>& args) {
+    if (args.size() != 1 || (args[0] != "--batch" && args[0] != "--batch-check")) {
+        std::cerr << "用法: biogit2 cat-file (--batch | --batch-check)   (从标准输入逐行读取对象名)" << std::endl;
+        return false;
+    }
+    use_stdout_for_data();
+    return repo.cat_file_batch(std::cin, std::cout, args[0] == "--batch-check");
+}
+
 // 处理 'merge' 命令
 void handle_merge(Biogit::Repository& repo, const std::vector<std::string>& args){
     if(args.empty()){
@@ -409,6 +608,15 @@ void handle_merge(Biogit::Repository& repo, const std::vector<std::string>& args
     repo.merge(args[0]); //
 }
 
+// 处理 'gc' 命令
+void handle_gc(Biogit::Repository& repo, const std::vector<std::string>& args){
+    if(!args.empty()){
+        std::cerr << "用法: biogit2 gc" << std::endl;
+        return;
+    }
+    repo.gc();
+}
+
 // 处理 'config' 命令
 void handle_config(Biogit::Repository* repo, const std::vector<std::string>& args) {
     if (args.empty()) {
@@ -444,6 +652,10 @@ void handle_config(Biogit::Repository* repo, const std::vector<std::string>& arg
             exit(1); // 模拟 Git 的行为
         }
     } else if (args.size() == 2) { // 设置配置项: biogit2 config <键> <值>
+        if (args[0] == Biogit::ObjectFormat::CONFIG_KEY || args[0] == Biogit::ObjectFormat::VERSION_KEY) {
+            std::cerr << "错误: 配置项 '" << args[0] << "' 在 init 时确定，不能修改 (已有对象不会随之改变)。" << std::endl;
+            return;
+        }
         if (!repo->config_set(args[0], args[1])) { //
             std::cerr << "错误: 设置配置项 '" << args[0] << "' 失败。" << std::endl;
         }
@@ -455,10 +667,15 @@ void handle_config(Biogit::Repository* repo, const std::vector<std::string>& arg
 // 处理 'clone' 命令
 void handle_clone(const std::vector<std::string>& args) {
     if (args.size() < 1 || args.size() > 2) {
-        std::cerr << "用法: biogit2 clone <仓库URL> [<目录>]" << std::endl;
+        std::cerr << "用法: biogit2 clone <仓库URL | 离线传输包> [<目录>]" << std::endl;
         return;
     }
     std::string url = args[0];
+    if (Biogit::Bundle::is_bundle(url)) { // 从离线传输包克隆，目录默认为包文件名 (去掉扩展名)
+        std::filesystem::path bundle_target = args.size() == 2 ? std::filesystem::path(args[1]) : std::filesystem::path(url).stem();
+        Biogit::Repository::clone_from_bundle(url, bundle_target);
+        return;
+    }
     std::filesystem::path target_dir; // 目标目录
     if (args.size() == 2) {
         target_dir = args[1];
@@ -479,6 +696,110 @@ void handle_clone(const std::vector<std::string>& args) {
     Biogit::Repository::clone(url, target_dir); //
 }
 
+// 处理 'bundle' 命令
+void handle_bundle(Biogit::Repository& repo, const std::vector<std::string>& args) {
+    if (args.size() >= 3 && args[0] == "create") {
+        repo.bundle_create(args[1], std::vector<std::string>(args.begin() + 2, args.end()));
+    } else if ((args.size() == 2 || args.size() == 3) && args[0] == "unbundle") {
+        repo.bundle_unbundle(args[1], args.size() == 3 ? args[2] : "origin");
+    } else {
+        std::cerr << "用法: biogit2 bundle create <文件> (<引用> | <基准>..<引用> | --all)..." << std::endl;
+        std::cerr << "   或: biogit2 bundle unbundle <文件> [<远程名>]" << std::endl;
+    }
+}
+
+// 处理 'fast-import' 命令
+bool handle_fast_import(Biogit::Repository& repo, const std::vector<std::string>& args) {
+    if (args.size() > 1 || (args.size() == 1 && args[0] != "--force")) {
+        std::cerr << "用法: biogit2 fast-import [--force] < <导入流>" << std::endl;
+        return false;
+    }
+    std::ios::sync_with_stdio(false); // 导入流可能很大，不与 C stdio 同步以加快读取
+    return repo.fast_import(std::cin, !args.empty());
+}
+
+// 处理 'fast-export' 命令
+bool handle_fast_export(Biogit::Repository& repo, const std::vector<std::string>& args) {
+    if (args.empty()) {
+        std::cerr << "用法: biogit2 fast-export (<引用> | <基准>..<引用> | --all)... > <导出流>" << std::endl;
+        return false;
+    }
+    use_stdout_for_data();
+    return repo.fast_export(args, std::cout);
+}
+
+// 处理 'archive' 命令
+bool handle_archive(Biogit::Repository& repo, const std::vector<std::string>& args) {
+    std::string format, prefix, output_file;
+    std::vector<std::string> positional;
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i].rfind("--format=", 0) == 0) format = args[i].substr(9);
+        else if (args[i].rfind("--prefix=", 0) == 0) prefix = args[i].substr(9);
+        else if (args[i] == "-o" && i + 1 < args.size()) output_file = args[++i];
+        else positional.push_back(args[i]);
+    }
+    auto ends_with = [](const std::string& s, const std::string& suffix) {
+        return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    if (format.empty()) { // 按输出文件名推断
+        format = (ends_with(output_file, ".tgz") || ends_with(output_file, ".tar.gz")) ? "tgz" : "tar";
+    }
+    if (positional.empty() || positional.size() > 2 || (format != "tar" && format != "tgz" && format != "tar.gz")) {
+        std::cerr << "用法: biogit2 archive [--format=tar|tgz] [--prefix=<前缀>/] [-o <文件>] <提交> [<路径>]" << std::endl;
+        return false;
+    }
+    const bool gzip = format != "tar";
+    const std::string sub_path = positional.size() == 2 ? positional[1] : "";
+
+    if (output_file.empty()) {
+        use_stdout_for_data();
+        return repo.archive(positional[0], sub_path, prefix, std::cout, gzip);
+    }
+    // 先写临时文件，成功后再改名，失败时不留下不完整的归档
+    const std::filesystem::path temp_file = output_file + ".tmp";
+    bool ok;
+    {
+        std::ofstream ofs(temp_file, std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open()) {
+            std::cerr << "错误: 无法创建文件 '" << output_file << "'。" << std::endl;
+            return false;
+        }
+        ok = repo.archive(positional[0], sub_path, prefix, ofs, gzip);
+    }
+    std::error_code ec;
+    if (ok) std::filesystem::rename(temp_file, output_file, ec);
+    if (!ok || ec) {
+        if (ec) std::cerr << "错误: 无法写入文件 '" << output_file << "': " << ec.message() << std::endl;
+        std::filesystem::remove(temp_file, ec);
+        return false;
+    }
+    return true;
+}
+
+// 处理 'daemon' 命令
+bool handle_daemon(Biogit::Repository& repo, const std::vector<std::string>& args) {
+    // biogit2 daemon (start | stop | status)
+    if (args.size() != 1) {
+        std::cerr << "用法: biogit2 daemon (start | stop | status)" << std::endl;
+        return false;
+    }
+    if (args[0] == "start") {
+        return Biogit::LocalDaemon::start(repo, run_daemon_command);
+    }
+    if (args[0] == "stop") {
+        if (Biogit::LocalDaemon::stop(repo.get_mygit_directory())) std::cout << "常驻进程已停止。" << std::endl;
+        else std::cout << "常驻进程未在运行。" << std::endl;
+        return true;
+    }
+    if (args[0] == "status") {
+        if (Biogit::LocalDaemon::is_running(repo.get_mygit_directory())) std::cout << "常驻进程正在运行。" << std::endl;
+        else std::cout << "常驻进程未在运行。" << std::endl;
+        return true;
+    }
+    std::cerr << "错误: 未知的 daemon 子命令 '" << args[0] << "'。" << std::endl;
+    return false;
+}
+
 // 处理 'remote' 命令
 void handle_remote(Biogit::Repository& repo, const std::vector<std::string>& args) {
     if (args.empty() || args[0] == "-v") { // 列出远程仓库
@@ -522,7 +843,7 @@ void handle_fetch(Biogit::Repository& repo, const std::vector<std::string>& args
         ref_to_fetch = args[1];
     }
     // 尝试从仓库的 .biogit 目录加载 Token
-    std::optional<std::string> token_opt = Utils::loadRepositoryToken(repo.get_mygit_directory()); //
+    std::optional<std::string> token_opt = Utils::loadRepositoryToken(repo.get_common_directory()); //
     if (!token_opt) { // 如果没有找到 Token
         std::cerr << "错误: 未登录。请先使用 'biogit2 login' 为此仓库登录。" << std::endl;
         return;
@@ -568,7 +889,7 @@ void handle_push(Biogit::Repository& repo, const std::vector<std::string>& args)
         }
     }
 
-    std::optional<std::string> token_opt = Utils::loadRepositoryToken(repo.get_mygit_directory()); //
+    std::optional<std::string> token_opt = Utils::loadRepositoryToken(repo.get_common_directory()); //
     if (!token_opt) {
         std::cerr << "错误: 未登录。请先使用 'biogit2 login' 为此仓库登录。" << std::endl;
         return;
@@ -589,7 +910,7 @@ void handle_pull(Biogit::Repository& repo, const std::vector<std::string>& args)
         remote_branch = args[1];
     }
 
-    std::optional<std::string> token_opt = Utils::loadRepositoryToken(repo.get_mygit_directory()); //
+    std::optional<std::string> token_opt = Utils::loadRepositoryToken(repo.get_common_directory()); //
     if (!token_opt) {
         std::cerr << "错误: 未登录。请先使用 'biogit2 login' 为此仓库登录。" << std::endl;
         return;
@@ -664,9 +985,10 @@ void handle_login_user(const std::vector<std::string>& args) {
         std::cout << "登录成功。" << std::endl;
         // 尝试找到当前仓库的 .biogit 目录以保存 Token
         std::optional<std::filesystem::path> root_path_opt = Biogit::Repository::find_repository_root(std::filesystem::current_path());
-        if (root_path_opt) { // 如果在仓库内
-            std::filesystem::path biogit_dir = *root_path_opt / Biogit::Repository::MYGIT_DIR_NAME;
-            if(Utils::saveRepositoryToken(biogit_dir, token_received)){ //
+        std::optional<Biogit::Repository> token_repo_opt;
+        if (root_path_opt) token_repo_opt = Biogit::Repository::load(*root_path_opt);
+        if (token_repo_opt) { // 如果在仓库内 (链接工作树的 Token 保存在主仓库的 .biogit)
+            if(Utils::saveRepositoryToken(token_repo_opt->get_common_directory(), token_received)){ //
                  std::cout << "Token 已为此仓库保存。" << std::endl;
             } else { // 保存失败
                  std::cout << "警告: 无法为此仓库保存 Token。" << std::endl;
@@ -681,6 +1003,31 @@ void handle_login_user(const std::vector<std::string>& args) {
     client.Disconnect(); // 断开连接
 }
 
+// 处理 'server fork' 命令
+void handle_server_fork(const std::vector<std::string>& args) {
+    // biogit2 server fork <root_repo_dir> <source_repo> <new_repo>
+    if (args.size() != 4) {
+        std::cerr << "用法: biogit2 server fork <仓库根目录> <源仓库> <新仓库>" << std::endl;
+        return;
+    }
+    std::filesystem::path root_repo_dir = args[1];
+    // 仓库路径相对于仓库根目录，不允许越出根目录
+    for (const std::string& repo_arg : {args[2], args[3]}) {
+        std::filesystem::path repo_rel_path(repo_arg);
+        if (repo_rel_path.is_absolute() ||
+            std::any_of(repo_rel_path.begin(), repo_rel_path.end(), [](const auto& part) { return part == ".."; })) {
+            std::cerr << "错误: 仓库路径必须是仓库根目录下的相对路径: " << repo_arg << std::endl;
+            return;
+        }
+    }
+
+    // 同一仓库根目录下的所有 fork 共享一个对象池
+    std::filesystem::path pool_objects_dir = root_repo_dir / ".biogit-pool" / "objects";
+    if (!Biogit::Repository::fork(root_repo_dir / args[2], root_repo_dir / args[3], pool_objects_dir)) {
+        std::cerr << "错误: fork 失败。" << std::endl;
+    }
+}
+
 // 处理 'server start' 命令
 void handle_server_start(const std::vector<std::string>& args) {
     // biogit2 server start <port> <root_repo_dir> <token_secret> [<log_dir>] [<log_base_name>]
@@ -0,0 +1,195 @@
+#include "../include/BinaryDelta.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Biogit {
+
+namespace {
+
+/// 多项式滚动哈希的乘数 (按 2^32 取模)
+constexpr uint32_t MULTIPLIER = 0x01000193u;
+
+void put_varint(std::vector<std::byte>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<std::byte>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<std::byte>(value));
+}
+
+bool get_varint(const std::byte* data, size_t size, size_t& pos, uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (pos >= size) return false;
+        uint8_t byte = static_cast<uint8_t>(data[pos++]);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+uint32_t block_hash(const std::byte* data, size_t length) {
+    uint32_t hash = 0;
+    for (size_t i = 0; i < length; ++i) {
+        hash = hash * MULTIPLIER + static_cast<uint8_t>(data[i]);
+    }
+    return hash;
+}
+
+/// 哈希表槽位：再混合一次，避免低位分布不均
+size_t slot_of(uint32_t hash, size_t mask) {
+    return static_cast<size_t>((hash ^ (hash >> 15)) * 0x2c1b3c6du) & mask;
+}
+
+void emit_insert(std::vector<std::byte>& out, const std::byte* data, size_t length) {
+    if (length == 0) return;
+    out.push_back(static_cast<std::byte>(BinaryDelta::OP_INSERT));
+    put_varint(out, length);
+    out.insert(out.end(), data, data + length);
+}
+
+void emit_copy(std::vector<std::byte>& out, size_t offset, size_t length) {
+    out.push_back(static_cast<std::byte>(BinaryDelta::OP_COPY));
+    put_varint(out, offset);
+    put_varint(out, length);
+}
+
+}
+
+
+std::optional<std::vector<std::byte>> BinaryDelta::apply(const std::byte* base, size_t base_size,
+                                                         const std::byte* delta, size_t delta_size,
+                                                         size_t max_target_size) {
+    size_t pos = 0;
+    uint64_t declared_base_size = 0, target_size = 0;
+    if (!get_varint(delta, delta_size, pos, declared_base_size) || declared_base_size != base_size) return std::nullopt;
+    if (!get_varint(delta, delta_size, pos, target_size) || target_size > max_target_size) return std::nullopt;
+    // 预留空间不超过 “基准 + 增量” 的大小，声明的目标长度异常时不会一次分配巨量内存
+    std::vector<std::byte> target;
+    target.reserve(static_cast<size_t>(std::min<uint64_t>(target_size, static_cast<uint64_t>(base_size) + delta_size)));
+    while (pos < delta_size) {
+        uint8_t op = static_cast<uint8_t>(delta[pos++]);
+        if (op == OP_COPY) {
+            uint64_t offset = 0, length = 0;
+            if (!get_varint(delta, delta_size, pos, offset) || !get_varint(delta, delta_size, pos, length)) return std::nullopt;
+            if (length == 0 || offset > base_size || length > base_size - offset) return std::nullopt;
+            if (length > target_size - target.size()) return std::nullopt;
+            target.insert(target.end(), base + offset, base + offset + length);
+        } else if (op == OP_INSERT) {
+            uint64_t length = 0;
+            if (!get_varint(delta, delta_size, pos, length)) return std::nullopt;
+            if (length == 0 || length > delta_size - pos || length > target_size - target.size()) return std::nullopt;
+            target.insert(target.end(), delta + pos, delta + pos + length);
+            pos += static_cast<size_t>(length);
+        } else {
+            return std::nullopt;
+        }
+    }
+    if (target.size() != target_size) return std::nullopt;
+    return target;
+}
+
+
+DeltaIndex::DeltaIndex(const std::byte* base, size_t base_size)
+    : base_(base), base_size_(base_size), block_size_(MIN_BLOCK_SIZE) {
+    // 1. 按基准大小确定块长度
+    size_t block_count = base_size / block_size_;
+    while (block_count > MAX_INDEX_ENTRIES) {
+        block_size_ *= 2;
+        block_count = base_size / block_size_;
+    }
+    power_ = 1;
+    for (size_t i = 1; i < block_size_; ++i) power_ *= MULTIPLIER;
+
+    // 偏移以 32 位保存；超出范围的基准不建立索引 (编码结果只有 INSERT)
+    if (block_count == 0 || base_size >= std::numeric_limits<uint32_t>::max()) return;
+
+    // 2. 建立开放寻址哈希表 (负载不超过 1/2)
+    size_t table_size = 1;
+    while (table_size < block_count * 2) table_size <<= 1;
+    table_mask_ = table_size - 1;
+    hashes_.assign(table_size, 0);
+    offsets_.assign(table_size, 0);
+    for (size_t block = 0; block < block_count; ++block) {
+        size_t offset = block * block_size_;
+        uint32_t hash = block_hash(base_ + offset, block_size_);
+        size_t slot = slot_of(hash, table_mask_);
+        while (offsets_[slot] != 0) slot = (slot + 1) & table_mask_;
+        hashes_[slot] = hash;
+        offsets_[slot] = static_cast<uint32_t>(offset + 1);
+    }
+}
+
+
+bool DeltaIndex::find_match(uint32_t hash, const std::byte* target, size_t target_size, size_t pos,
+                            size_t& out_base_offset, size_t& out_length) const {
+    out_length = 0;
+    size_t candidates = 0;
+    for (size_t slot = slot_of(hash, table_mask_); offsets_[slot] != 0 && candidates < MAX_CANDIDATES;
+         slot = (slot + 1) & table_mask_) {
+        if (hashes_[slot] != hash) continue;
+        ++candidates;
+        size_t offset = offsets_[slot] - 1;
+        if (std::memcmp(base_ + offset, target + pos, block_size_) != 0) continue;
+
+        size_t length = block_size_;
+        size_t limit = std::min(base_size_ - offset, target_size - pos);
+        while (length < limit && base_[offset + length] == target[pos + length]) ++length;
+        if (length > out_length) {
+            out_length = length;
+            out_base_offset = offset;
+        }
+    }
+    return out_length > 0;
+}
+
+
+std::optional<std::vector<std::byte>> DeltaIndex::encode(const std::byte* target, size_t target_size,
+                                                         size_t max_delta_size) const {
+    std::vector<std::byte> delta;
+    put_varint(delta, base_size_);
+    put_varint(delta, target_size);
+
+    size_t pos = 0;          // 当前窗口起点
+    size_t insert_start = 0; // 尚未输出的字面数据起点
+    bool have_hash = false;
+    uint32_t hash = 0;
+    while (!offsets_.empty() && pos + block_size_ <= target_size) {
+        if (!have_hash) {
+            hash = block_hash(target + pos, block_size_);
+            have_hash = true;
+        }
+
+        size_t base_offset = 0, length = 0;
+        if (find_match(hash, target, target_size, pos, base_offset, length)) {
+            // 向前扩展：吸收尚未输出的字面数据末尾与基准相同的部分
+            size_t match_start = pos;
+            while (match_start > insert_start && base_offset > 0 &&
+                   base_[base_offset - 1] == target[match_start - 1]) {
+                --match_start;
+                --base_offset;
+                ++length;
+            }
+            emit_insert(delta, target + insert_start, match_start - insert_start);
+            emit_copy(delta, base_offset, length);
+            pos = match_start + length;
+            insert_start = pos;
+            have_hash = false;
+        } else {
+            // 窗口右移一个字节：移出首字节，移入新字节
+            if (pos + block_size_ < target_size) {
+                hash = (hash - static_cast<uint8_t>(target[pos]) * power_) * MULTIPLIER
+                       + static_cast<uint8_t>(target[pos + block_size_]);
+            }
+            ++pos;
+        }
+        if (delta.size() + (pos - insert_start) > max_delta_size) return std::nullopt;
+    }
+
+    emit_insert(delta, target + insert_start, target_size - insert_start);
+    if (delta.size() > max_delta_size) return std::nullopt;
+    return delta;
+}
+
+}
@@ -0,0 +1,278 @@
+#include "../include/Bundle.h"
+
+#include <zlib.h>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+namespace Biogit {
+
+namespace {
+
+constexpr uint64_t MAX_DEFLATE_RATIO = 1032; ///< deflate 数据还原后与压缩前的最大长度比
+
+bool hex_to_binary(const std::string& hex, unsigned char out[20]) {
+    if (hex.size() != 40) return false;
+    for (size_t i = 0; i < 20; ++i) {
+        unsigned value = 0;
+        for (size_t j = 0; j < 2; ++j) {
+            char c = hex[i * 2 + j];
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= static_cast<unsigned>(c - '0');
+            else if (c >= 'a' && c <= 'f') value |= static_cast<unsigned>(c - 'a' + 10);
+            else return false;
+        }
+        out[i] = static_cast<unsigned char>(value);
+    }
+    return true;
+}
+
+std::string binary_to_hex(const unsigned char in[20]) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(40, '0');
+    for (size_t i = 0; i < 20; ++i) {
+        hex[i * 2] = digits[in[i] >> 4];
+        hex[i * 2 + 1] = digits[in[i] & 0x0f];
+    }
+    return hex;
+}
+
+bool is_hex_hash(const std::string& s) {
+    unsigned char ignored[20];
+    return hex_to_binary(s, ignored);
+}
+
+}
+
+
+bool Bundle::is_bundle(const std::filesystem::path& file_path) {
+    std::ifstream ifs(file_path, std::ios::binary);
+    std::string first_line;
+    return ifs.is_open() && std::getline(ifs, first_line) && first_line == SIGNATURE;
+}
+
+
+// --- BundleWriter ---
+
+BundleWriter::~BundleWriter() {
+    if (!finished_ && !temp_path_.empty()) {
+        ofs_.close();
+        std::error_code ec;
+        std::filesystem::remove(temp_path_, ec); // 未完成的包不留下
+    }
+}
+
+void BundleWriter::write_bytes(const void* data, size_t size) {
+    ofs_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    hasher_.update(data, size);
+}
+
+bool BundleWriter::open(const std::filesystem::path& file_path, const BundleHeader& header, uint64_t object_count) {
+    file_path_ = file_path;
+    temp_path_ = file_path;
+    temp_path_ += ".tmp";
+    expected_count_ = object_count;
+
+    ofs_.open(temp_path_, std::ios::binary | std::ios::trunc);
+    if (!ofs_.is_open()) {
+        std::cerr << "错误: 无法创建文件 '" << temp_path_.string() << "'。" << std::endl;
+        temp_path_.clear();
+        return false;
+    }
+
+    // 1. 文本头部
+    ofs_ << Bundle::SIGNATURE << "\n";
+    for (const auto& prerequisite : header.prerequisites) ofs_ << "-" << prerequisite << "\n";
+    for (const auto& [ref_name, hash] : header.refs) ofs_ << hash << " " << ref_name << "\n";
+    if (!header.head_ref.empty()) ofs_ << "@" << header.head_ref << "\n";
+    ofs_ << "\n";
+
+    // 2. 对象流开头 (之后的字节都计入校验和)
+    write_bytes(Bundle::PACK_MAGIC, sizeof(Bundle::PACK_MAGIC));
+    unsigned char count_bytes[8];
+    for (int i = 0; i < 8; ++i) count_bytes[i] = static_cast<unsigned char>(object_count >> (56 - 8 * i));
+    write_bytes(count_bytes, sizeof(count_bytes));
+    return ofs_.good();
+}
+
+bool BundleWriter::add_object(const std::string& hash_hex, const char* data, size_t size) {
+    unsigned char hash_bytes[20];
+    if (!hex_to_binary(hash_hex, hash_bytes)) {
+        std::cerr << "错误: 无效的对象哈希 '" << hash_hex << "'。" << std::endl;
+        return false;
+    }
+
+    // 压缩没有收益 (例如已压缩的文件格式) 时原样写入
+    uLongf bound = compressBound(static_cast<uLong>(size));
+    std::vector<Bytef> compressed(bound);
+    uint8_t storage = Bundle::STORED_RAW;
+    const void* payload = data;
+    size_t payload_size = size;
+    if (compress2(compressed.data(), &bound, reinterpret_cast<const Bytef*>(data), static_cast<uLong>(size),
+                  Z_DEFAULT_COMPRESSION) == Z_OK && bound < size) {
+        storage = Bundle::STORED_ZLIB;
+        payload = compressed.data();
+        payload_size = bound;
+    }
+
+    std::vector<unsigned char> entry_header(hash_bytes, hash_bytes + 20);
+    entry_header.push_back(storage);
+    for (uint64_t value : {static_cast<uint64_t>(size), static_cast<uint64_t>(payload_size)}) {
+        while (value >= 0x80) {
+            entry_header.push_back(static_cast<unsigned char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        entry_header.push_back(static_cast<unsigned char>(value));
+    }
+    write_bytes(entry_header.data(), entry_header.size());
+    write_bytes(payload, payload_size);
+    ++written_count_;
+    if (!ofs_.good()) {
+        std::cerr << "错误: 写入文件 '" << temp_path_.string() << "' 失败。" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool BundleWriter::finish() {
+    if (written_count_ != expected_count_) {
+        std::cerr << "错误: 包中对象数 (" << written_count_ << ") 与头部声明 (" << expected_count_ << ") 不一致。" << std::endl;
+        return false;
+    }
+    ofs_ << hasher_.hex_digest();
+    ofs_.close();
+    if (!ofs_.good()) {
+        std::cerr << "错误: 写入文件 '" << temp_path_.string() << "' 失败。" << std::endl;
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp_path_, file_path_, ec);
+    if (ec) {
+        std::cerr << "错误: 无法将 '" << temp_path_.string() << "' 改名为 '" << file_path_.string() << "': " << ec.message() << std::endl;
+        return false;
+    }
+    finished_ = true;
+    return true;
+}
+
+
+// --- BundleReader ---
+
+bool BundleReader::read_bytes(void* data, size_t size) {
+    if (!ifs_.read(static_cast<char*>(data), static_cast<std::streamsize>(size))) return false;
+    hasher_.update(data, size);
+    return true;
+}
+
+bool BundleReader::read_varint(uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        unsigned char byte = 0;
+        if (!read_bytes(&byte, 1)) return false;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+bool BundleReader::open(const std::filesystem::path& file_path) {
+    file_path_ = file_path;
+    ifs_.open(file_path, std::ios::binary);
+    if (!ifs_.is_open()) {
+        std::cerr << "错误: 无法打开文件 '" << file_path.string() << "'。" << std::endl;
+        return false;
+    }
+
+    // 1. 文本头部
+    std::string line;
+    if (!std::getline(ifs_, line) || line != Bundle::SIGNATURE) {
+        std::cerr << "错误: '" << file_path.string() << "' 不是 BioGit 离线传输包。" << std::endl;
+        return false;
+    }
+    while (std::getline(ifs_, line) && !line.empty()) {
+        if (line[0] == '-' && is_hex_hash(line.substr(1))) {
+            header_.prerequisites.push_back(line.substr(1));
+        } else if (line[0] == '@' && line.size() > 1) {
+            header_.head_ref = line.substr(1);
+        } else if (line.size() > 41 && line[40] == ' ' && is_hex_hash(line.substr(0, 40))) {
+            header_.refs.emplace_back(line.substr(41), line.substr(0, 40));
+        } else {
+            std::cerr << "错误: 离线传输包头部格式无效: '" << line << "'" << std::endl;
+            return false;
+        }
+    }
+
+    // 2. 对象流开头
+    char magic[4];
+    unsigned char count_bytes[8];
+    if (!read_bytes(magic, sizeof(magic)) || std::memcmp(magic, Bundle::PACK_MAGIC, sizeof(magic)) != 0 ||
+        !read_bytes(count_bytes, sizeof(count_bytes))) {
+        std::cerr << "错误: 离线传输包 '" << file_path.string() << "' 的对象流已损坏。" << std::endl;
+        return false;
+    }
+    for (unsigned char byte : count_bytes) object_count_ = (object_count_ << 8) | byte;
+    return true;
+}
+
+bool BundleReader::next(std::string& out_hash_hex, std::vector<char>& out_data) {
+    if (failed_ || read_count_ >= object_count_) return false;
+    auto fail = [this](const std::string& message) {
+        std::cerr << "错误: 离线传输包 '" << file_path_.string() << "' " << message << std::endl;
+        failed_ = true;
+        return false;
+    };
+
+    unsigned char hash_bytes[20];
+    uint8_t storage = 0;
+    uint64_t size = 0, payload_size = 0;
+    if (!read_bytes(hash_bytes, sizeof(hash_bytes)) || !read_bytes(&storage, 1) ||
+        !read_varint(size) || !read_varint(payload_size)) {
+        return fail("在第 " + std::to_string(read_count_ + 1) + " 个对象处被截断。");
+    }
+    // 数据长度不可能超过剩余文件长度，规范长度不超过 uint32_t 且不超过 deflate 的最大压缩比 (约 1032:1)，
+    // 避免损坏或恶意的长度字段导致巨量分配
+    if (payload_size > static_cast<uint64_t>(std::filesystem::file_size(file_path_)) ||
+        size > std::numeric_limits<uint32_t>::max() || size > payload_size * MAX_DEFLATE_RATIO + 64 ||
+        (storage == Bundle::STORED_RAW && payload_size != size) ||
+        (storage != Bundle::STORED_RAW && storage != Bundle::STORED_ZLIB)) {
+        return fail("的对象条目格式无效。");
+    }
+
+    std::vector<char> payload(static_cast<size_t>(payload_size));
+    if (!read_bytes(payload.data(), payload.size())) {
+        return fail("在第 " + std::to_string(read_count_ + 1) + " 个对象处被截断。");
+    }
+    if (storage == Bundle::STORED_ZLIB) {
+        out_data.assign(static_cast<size_t>(size), '\0');
+        uLongf dest_size = static_cast<uLongf>(size);
+        if (uncompress(reinterpret_cast<Bytef*>(out_data.data()), &dest_size,
+                       reinterpret_cast<const Bytef*>(payload.data()), static_cast<uLong>(payload.size())) != Z_OK ||
+            dest_size != size) {
+            return fail("中的对象无法解压。");
+        }
+    } else {
+        out_data = std::move(payload);
+    }
+
+    out_hash_hex = binary_to_hex(hash_bytes);
+    SHA1::Hasher object_hasher;
+    object_hasher.update(out_data.data(), out_data.size());
+    if (object_hasher.hex_digest() != out_hash_hex) {
+        return fail("中的对象 " + out_hash_hex.substr(0, 7) + " 内容与哈希不符。");
+    }
+    ++read_count_;
+    return true;
+}
+
+bool BundleReader::verify_checksum() {
+    if (failed_ || read_count_ != object_count_) return false;
+    std::string expected = hasher_.hex_digest();
+    char stored[40];
+    if (!ifs_.read(stored, sizeof(stored)) || std::string(stored, sizeof(stored)) != expected) {
+        std::cerr << "错误: 离线传输包 '" << file_path_.string() << "' 的校验和不匹配 (文件不完整或已损坏)。" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}
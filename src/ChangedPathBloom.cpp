@@ -0,0 +1,192 @@
+#include "../include/ChangedPathBloom.h"
+#include "../include/ObjectFormat.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace Biogit {
+
+// --- BloomFilter 实现 ---
+
+namespace {
+
+/**
+ * @brief 带种子的 64 位 FNV-1a 哈希。
+ */
+uint64_t fnv1a_64(const std::string& key, uint64_t seed) {
+    uint64_t hash = 14695981039346656037ULL ^ seed;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    // 末尾再做一次混合，避免短键的低位分布过于集中
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+}
+
+BloomFilter::BloomFilter(size_t expected_entries) {
+    size_t num_bits = expected_entries * BITS_PER_ENTRY;
+    if (num_bits < MIN_BITS) {
+        num_bits = MIN_BITS;
+    }
+    bits_.assign((num_bits + 7) / 8, 0);
+}
+
+BloomFilter BloomFilter::saturated() {
+    BloomFilter filter;
+    filter.saturated_ = true;
+    return filter;
+}
+
+void BloomFilter::add(const std::string& key) {
+    if (saturated_ || bits_.empty()) return;
+
+    const uint64_t num_bits = bits_.size() * 8;
+    const uint64_t h1 = fnv1a_64(key, 0);
+    const uint64_t h2 = fnv1a_64(key, 0x9e3779b97f4a7c15ULL) | 1; // 保证步长为奇数
+    for (uint32_t i = 0; i < NUM_HASHES; ++i) {
+        uint64_t bit = (h1 + i * h2) % num_bits;
+        bits_[bit / 8] |= static_cast<uint8_t>(1u << (bit % 8));
+    }
+}
+
+bool BloomFilter::might_contain(const std::string& key) const {
+    if (saturated_ || bits_.empty()) return true;
+
+    const uint64_t num_bits = bits_.size() * 8;
+    const uint64_t h1 = fnv1a_64(key, 0);
+    const uint64_t h2 = fnv1a_64(key, 0x9e3779b97f4a7c15ULL) | 1;
+    for (uint32_t i = 0; i < NUM_HASHES; ++i) {
+        uint64_t bit = (h1 + i * h2) % num_bits;
+        if ((bits_[bit / 8] & (1u << (bit % 8))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string BloomFilter::format_for_file() const {
+    if (saturated_) return "*";
+
+    static const char* hex_digits = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(bits_.size() * 2);
+    for (uint8_t byte : bits_) {
+        hex.push_back(hex_digits[byte >> 4]);
+        hex.push_back(hex_digits[byte & 0x0f]);
+    }
+    return std::to_string(bits_.size() * 8) + " " + hex;
+}
+
+std::optional<BloomFilter> BloomFilter::parse_from_string(const std::string& text) {
+    if (text == "*") return saturated();
+
+    std::istringstream iss(text);
+    size_t num_bits = 0;
+    std::string hex;
+    if (!(iss >> num_bits >> hex) || num_bits == 0 || num_bits % 8 != 0 || hex.length() != num_bits / 4) {
+        return std::nullopt;
+    }
+
+    auto hex_value = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    };
+
+    BloomFilter filter;
+    filter.bits_.resize(num_bits / 8);
+    for (size_t i = 0; i < filter.bits_.size(); ++i) {
+        int hi = hex_value(hex[2 * i]);
+        int lo = hex_value(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return std::nullopt;
+        filter.bits_[i] = static_cast<uint8_t>((hi << 4) | lo);
+    }
+    return filter;
+}
+
+
+// --- ChangedPathBloomStore 实现 ---
+
+const std::string ChangedPathBloomStore::FILE_NAME = "commit-bloom";
+
+ChangedPathBloomStore::ChangedPathBloomStore(const std::filesystem::path& biogit_dir_path)
+    : file_path_(biogit_dir_path / FILE_NAME) {
+}
+
+bool ChangedPathBloomStore::load() {
+    filters_.clear();
+    if (!std::filesystem::exists(file_path_)) {
+        return true;
+    }
+
+    std::ifstream ifs(file_path_);
+    if (!ifs.is_open()) {
+        std::cerr << "错误: 无法打开改动路径过滤器文件: " << file_path_.string() << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(ifs, line)) {
+        size_t space_pos = line.find(' ');
+        if (space_pos == std::string::npos || !ObjectFormat::is_id_length(space_pos)) continue; // 非法行 (例如写入被中断)，按缺失处理，之后会被重新计算
+
+        auto filter_opt = BloomFilter::parse_from_string(line.substr(space_pos + 1));
+        if (filter_opt) {
+            filters_[line.substr(0, space_pos)] = std::move(*filter_opt);
+        }
+    }
+    return !ifs.bad();
+}
+
+const BloomFilter* ChangedPathBloomStore::get(const std::string& commit_hash) const {
+    auto it = filters_.find(commit_hash);
+    return it == filters_.end() ? nullptr : &it->second;
+}
+
+bool ChangedPathBloomStore::record(const std::string& commit_hash, const std::set<std::string>& changed_paths) {
+    if (!ObjectFormat::is_id_length(commit_hash.length())) return false;
+    if (filters_.count(commit_hash)) return true;
+
+    // 1. 展开所有父目录前缀
+    std::set<std::string> keys;
+    for (const auto& path_str : changed_paths) {
+        keys.insert(path_str);
+        size_t slash_pos = path_str.rfind('/');
+        while (slash_pos != std::string::npos && slash_pos > 0) {
+            keys.insert(path_str.substr(0, slash_pos));
+            slash_pos = path_str.rfind('/', slash_pos - 1);
+        }
+    }
+
+    // 2. 构建过滤器 (改动过多时直接写入饱和标记)
+    BloomFilter filter = BloomFilter::saturated();
+    if (changed_paths.size() <= MAX_CHANGED_PATHS) {
+        filter = BloomFilter(keys.size());
+        for (const auto& key : keys) {
+            filter.add(key);
+        }
+    }
+
+    // 3. 追加写入旁路文件
+    std::ofstream ofs(file_path_, std::ios::app);
+    if (!ofs.is_open()) {
+        std::cerr << "警告: 无法写入改动路径过滤器文件: " << file_path_.string() << std::endl;
+        return false;
+    }
+    ofs << commit_hash << " " << filter.format_for_file() << "\n";
+    if (!ofs.good()) {
+        std::cerr << "警告: 写入改动路径过滤器文件失败: " << file_path_.string() << std::endl;
+        return false;
+    }
+
+    filters_[commit_hash] = std::move(filter);
+    return true;
+}
+
+}
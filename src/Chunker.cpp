@@ -0,0 +1,90 @@
+#include "../include/Chunker.h"
+
+#include <algorithm>
+#include <array>
+
+namespace Biogit {
+
+namespace {
+
+/**
+ * @brief 生成 Gear 哈希表：256 个固定的伪随机 64 位数 (splitmix64)。
+ * 表必须在所有版本之间保持不变，否则相同内容会得到不同的切点。
+ */
+std::array<uint64_t, 256> make_gear_table() {
+    std::array<uint64_t, 256> table{};
+    uint64_t state = 0x6269'6f67'6974'4344ULL; // "biogitCD"
+    for (auto& value : table) {
+        state += 0x9e3779b97f4a7c15ULL;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        value = z ^ (z >> 31);
+    }
+    return table;
+}
+
+const std::array<uint64_t, 256> GEAR = make_gear_table();
+
+/**
+ * @brief 构造一个只有最高 bits 位为 1 的掩码 (Gear 哈希的高位综合了最近约 64 字节的内容)。
+ */
+uint64_t high_bits_mask(unsigned bits) {
+    bits = std::clamp(bits, 1u, 63u);
+    return ~0ULL << (64 - bits);
+}
+
+unsigned log2_floor(size_t value) {
+    unsigned bits = 0;
+    while (value > 1) {
+        value >>= 1;
+        ++bits;
+    }
+    return bits;
+}
+
+}
+
+FastCdcChunker::FastCdcChunker(ChunkingParams params) : params_(params) {
+    params_.min_size = std::max<size_t>(params_.min_size, 64);
+    params_.avg_size = std::max(params_.avg_size, params_.min_size);
+    params_.max_size = std::max(params_.max_size, params_.avg_size);
+
+    unsigned avg_bits = log2_floor(params_.avg_size);
+    mask_small_ = high_bits_mask(avg_bits + 2);
+    mask_large_ = high_bits_mask(avg_bits - 2);
+}
+
+size_t FastCdcChunker::next_cut(const uint8_t* data, size_t size) const {
+    if (size <= params_.min_size) {
+        return size;
+    }
+    size_t limit = std::min(size, params_.max_size);
+    size_t normal = std::min(limit, params_.avg_size);
+
+    uint64_t fingerprint = 0;
+    size_t i = params_.min_size;
+    for (; i < normal; ++i) {
+        fingerprint = (fingerprint << 1) + GEAR[data[i]];
+        if ((fingerprint & mask_small_) == 0) return i + 1;
+    }
+    for (; i < limit; ++i) {
+        fingerprint = (fingerprint << 1) + GEAR[data[i]];
+        if ((fingerprint & mask_large_) == 0) return i + 1;
+    }
+    return limit;
+}
+
+std::vector<size_t> FastCdcChunker::split(const std::byte* data, size_t size) const {
+    std::vector<size_t> chunk_sizes;
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    size_t offset = 0;
+    while (offset < size) {
+        size_t chunk_size = next_cut(bytes + offset, size - offset);
+        chunk_sizes.push_back(chunk_size);
+        offset += chunk_size;
+    }
+    return chunk_sizes;
+}
+
+}
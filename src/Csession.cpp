@@ -274,6 +274,16 @@ void Csession::ProcessTargetRepoRequest(const char* body_data, uint32_t body_len
     // 6. 调用 Repository::load 尝试加载指定路径的仓库
     std::optional<Repository> loaded_repo_opt = Repository::load(full_repo_path); //
 
+    // 7. 协议中的对象 ID 固定为 40 位 SHA-1，其他对象格式的仓库不能通过网络访问
+    if (loaded_repo_opt && loaded_repo_opt->get_object_format() != ObjectFormat::Algorithm::SHA1) {
+        std::string err_msg = "Error: Repository at " + final_rel_path.generic_string() + " uses object format '" +
+                              ObjectFormat::name(loaded_repo_opt->get_object_format()) + "', which the network protocol does not support.";
+        std::cerr << "CSession [" << _uuid << "]: " << err_msg << std::endl;
+        Send(err_msg, Protocol::MSG_RESP_TARGET_REPO_ERROR);
+        SetActiveRepository(nullptr, "");
+        return;
+    }
+
     if (loaded_repo_opt) {
         try {
             // 创建一个指向加载成功的 Repository 对象的 shared_ptr
@@ -0,0 +1,526 @@
+#include "../include/DiffDriver.h"
+#include "../include/utils.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+
+namespace Biogit {
+
+namespace {
+
+/// 记录内部的一段改动 (字节区间)
+struct ByteEdit {
+    size_t a_begin, a_end; ///< 旧序列中的区间 [a_begin, a_end)
+    size_t b_begin, b_end; ///< 新序列中的区间 [b_begin, b_end)
+};
+
+/**
+ * @brief 对两段行区间运行 Myers，输出从第一处改动到最后一处改动的一个 Hunk (两段完全相同时不输出)。
+ */
+void append_line_diff_hunk(const std::vector<std::string>& lines_a, size_t a_begin, size_t a_end,
+                           const std::vector<std::string>& lines_b, size_t b_begin, size_t b_end,
+                           const std::string& section, std::vector<DiffHunk>& hunks) {
+    std::vector<std::string> slice_a(lines_a.begin() + a_begin, lines_a.begin() + a_end);
+    std::vector<std::string> slice_b(lines_b.begin() + b_begin, lines_b.begin() + b_end);
+    std::vector<Utils::LineEditOperation> ses = Utils::MyersDiffLines(slice_a, slice_b);
+
+    size_t first = 0, last = ses.size();
+    while (first < ses.size() && ses[first].type == Utils::EditType::MATCH) ++first;
+    while (last > first && ses[last - 1].type == Utils::EditType::MATCH) --last;
+    if (first == last) {
+        return;
+    }
+
+    // 改动之前的 MATCH 行数即两边的起始偏移
+    DiffHunk hunk;
+    hunk.old_start = a_begin + first;
+    hunk.new_start = b_begin + first;
+    hunk.section = section;
+    for (size_t i = first; i < last; ++i) {
+        const auto& op = ses[i];
+        switch (op.type) {
+            case Utils::EditType::MATCH:  hunk.lines.push_back(" " + op.line_content); ++hunk.old_count; ++hunk.new_count; break;
+            case Utils::EditType::DELETE: hunk.lines.push_back("-" + op.line_content); ++hunk.old_count; break;
+            case Utils::EditType::INSERT: hunk.lines.push_back("+" + op.line_content); ++hunk.new_count; break;
+        }
+    }
+    hunks.push_back(std::move(hunk));
+}
+
+/// 行尾的第一个空白之前的部分 (序列 ID / read ID)
+std::string first_token(std::string_view text) {
+    size_t end = text.find_first_of(" \t");
+    return std::string(text.substr(0, end));
+}
+
+/**
+ * @brief 从 (i, j) 开始寻找两边重新对齐的位置：A[i+di..] 与 B[j+dj..] 的 ANCHOR_LENGTH 个字节相同，di+dj 尽量小。
+ */
+std::optional<std::pair<size_t, size_t>> find_resync(std::string_view a, size_t i, std::string_view b, size_t j) {
+    const size_t anchor = FastaDiffDriver::ANCHOR_LENGTH;
+    const size_t max_di = std::min(FastaDiffDriver::RESYNC_WINDOW, a.size() - i);
+    const size_t max_dj = std::min(FastaDiffDriver::RESYNC_WINDOW, b.size() - j);
+    for (size_t total = 1; total <= max_di + max_dj; ++total) {
+        size_t di_low = total > max_dj ? total - max_dj : 0;
+        size_t di_high = std::min(total, max_di);
+        for (size_t di = di_low; di <= di_high; ++di) {
+            size_t dj = total - di;
+            size_t rest_a = a.size() - i - di, rest_b = b.size() - j - dj;
+            size_t length = std::min(anchor, std::min(rest_a, rest_b));
+            // 靠近末尾时不足一个锚点长度：两边剩余部分必须完全相同
+            if (length < anchor && rest_a != rest_b) continue;
+            if (std::memcmp(a.data() + i + di, b.data() + j + dj, length) == 0) {
+                return std::make_pair(di, dj);
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+/**
+ * @brief 字节级比较两段序列，返回改动段列表 (按位置排序)。
+ */
+std::vector<ByteEdit> diff_sequence_bytes(std::string_view a, std::string_view b) {
+    // 1. 剥离相同的前缀和后缀
+    size_t prefix = 0;
+    const size_t min_size = std::min(a.size(), b.size());
+    while (prefix < min_size && a[prefix] == b[prefix]) ++prefix;
+    size_t suffix = 0;
+    while (suffix < min_size - prefix && a[a.size() - 1 - suffix] == b[b.size() - 1 - suffix]) ++suffix;
+
+    std::string_view mid_a = a.substr(prefix, a.size() - prefix - suffix);
+    std::string_view mid_b = b.substr(prefix, b.size() - prefix - suffix);
+    std::vector<ByteEdit> edits;
+    if (mid_a.empty() && mid_b.empty()) {
+        return edits;
+    }
+
+    // 2. 逐字节扫描中间部分；遇到不同时寻找重新对齐的位置
+    size_t i = 0, j = 0;
+    while (i < mid_a.size() || j < mid_b.size()) {
+        if (i < mid_a.size() && j < mid_b.size() && mid_a[i] == mid_b[j]) {
+            ++i;
+            ++j;
+            continue;
+        }
+        auto resync = (i < mid_a.size() && j < mid_b.size()) ? find_resync(mid_a, i, mid_b, j) : std::nullopt;
+        if (!resync) { // 找不到对齐位置 (或一边已到末尾)：剩余部分作为一整段改动
+            edits.push_back({prefix + i, prefix + mid_a.size(), prefix + j, prefix + mid_b.size()});
+            break;
+        }
+        edits.push_back({prefix + i, prefix + i + resync->first, prefix + j, prefix + j + resync->second});
+        i += resync->first;
+        j += resync->second;
+    }
+    return edits;
+}
+
+/**
+ * @brief 把字节区间 [begin, end) 映射为所在的行区间 [first, last)。空区间映射为其位置所在的那一行。
+ * @param line_starts 每一行在拼接序列中的起始偏移
+ */
+std::pair<size_t, size_t> byte_range_to_lines(const std::vector<size_t>& line_starts, size_t total_size, size_t begin, size_t end) {
+    if (line_starts.empty()) {
+        return {0, 0};
+    }
+    if (total_size == 0) {
+        return {0, line_starts.size()};
+    }
+    auto line_of = [&](size_t pos) {
+        pos = std::min(pos, total_size - 1);
+        return static_cast<size_t>(std::upper_bound(line_starts.begin(), line_starts.end(), pos) - line_starts.begin()) - 1;
+    };
+    size_t first = line_of(begin);
+    size_t last = end > begin ? line_of(end - 1) : first;
+    return {first, last + 1};
+}
+
+/// 把序列行拼接为一个字符串，同时记录每行的起始偏移
+std::string join_sequence_lines(const std::vector<std::string>& lines, size_t begin, size_t end, std::vector<size_t>& line_starts) {
+    std::string sequence;
+    line_starts.clear();
+    for (size_t i = begin; i < end; ++i) {
+        line_starts.push_back(sequence.size());
+        sequence += lines[i];
+    }
+    return sequence;
+}
+
+/// 判断两个行区间的内容是否完全相同
+bool same_lines(const std::vector<std::string>& lines_a, size_t a_begin, size_t a_count,
+                const std::vector<std::string>& lines_b, size_t b_begin, size_t b_count) {
+    return a_count == b_count &&
+           std::equal(lines_a.begin() + a_begin, lines_a.begin() + a_begin + a_count, lines_b.begin() + b_begin);
+}
+
+}
+
+
+// ---------------- DiffDriver ----------------
+
+void DiffDriver::diff_record(const std::vector<std::string>& lines_a, const DiffRecord& record_a,
+                             const std::vector<std::string>& lines_b, const DiffRecord& record_b,
+                             std::vector<DiffHunk>& hunks) const {
+    append_line_diff_hunk(lines_a, record_a.first_line, record_a.first_line + record_a.line_count,
+                          lines_b, record_b.first_line, record_b.first_line + record_b.line_count, "", hunks);
+}
+
+std::optional<std::vector<DiffHunk>> DiffDriver::diff(const std::vector<std::string>& lines_a,
+                                                      const std::vector<std::string>& lines_b) const {
+    auto records_a_opt = split_records(lines_a);
+    auto records_b_opt = split_records(lines_b);
+    if (!records_a_opt || !records_b_opt) {
+        return std::nullopt;
+    }
+    const auto& records_a = *records_a_opt;
+    const auto& records_b = *records_b_opt;
+
+    // 1. 统计每个键在两边尚未处理的出现次数
+    std::unordered_map<std::string, size_t> remaining_a, remaining_b;
+    for (const auto& record : records_a) ++remaining_a[record.key];
+    for (const auto& record : records_b) ++remaining_b[record.key];
+
+    // 2. 线性对齐：键相同则配对；键在对面已不再出现则视为删除/新增；
+    //    两边的键都在对面后续出现 (记录顺序调整) 时，把旧记录视为删除，新位置的记录随后视为新增
+    std::vector<DiffHunk> hunks;
+    auto add_hunk = [&hunks](DiffHunk hunk) {
+        if (!hunks.empty()) { // 与前一个 Hunk 在两边都首尾相接时合并
+            DiffHunk& previous = hunks.back();
+            if (previous.old_start + previous.old_count == hunk.old_start &&
+                previous.new_start + previous.new_count == hunk.new_start) {
+                previous.old_count += hunk.old_count;
+                previous.new_count += hunk.new_count;
+                previous.lines.insert(previous.lines.end(), std::make_move_iterator(hunk.lines.begin()),
+                                      std::make_move_iterator(hunk.lines.end()));
+                return;
+            }
+        }
+        hunks.push_back(std::move(hunk));
+    };
+    auto whole_record_hunk = [](const std::vector<std::string>& lines, const DiffRecord& record, char prefix,
+                                size_t other_position, bool is_old) {
+        DiffHunk hunk;
+        (is_old ? hunk.old_start : hunk.new_start) = record.first_line;
+        (is_old ? hunk.old_count : hunk.new_count) = record.line_count;
+        (is_old ? hunk.new_start : hunk.old_start) = other_position;
+        for (size_t i = record.first_line; i < record.first_line + record.line_count; ++i) {
+            hunk.lines.push_back(prefix + lines[i]);
+        }
+        return hunk;
+    };
+
+    size_t i = 0, j = 0;
+    while (i < records_a.size() || j < records_b.size()) {
+        const size_t position_a = i < records_a.size() ? records_a[i].first_line : lines_a.size();
+        const size_t position_b = j < records_b.size() ? records_b[j].first_line : lines_b.size();
+
+        if (i < records_a.size() && j < records_b.size() && records_a[i].key == records_b[j].key) {
+            const DiffRecord& record_a = records_a[i];
+            const DiffRecord& record_b = records_b[j];
+            if (!same_lines(lines_a, record_a.first_line, record_a.line_count, lines_b, record_b.first_line, record_b.line_count)) {
+                std::vector<DiffHunk> record_hunks;
+                diff_record(lines_a, record_a, lines_b, record_b, record_hunks);
+                for (auto& hunk : record_hunks) add_hunk(std::move(hunk));
+            }
+            --remaining_a[record_a.key];
+            --remaining_b[record_b.key];
+            ++i;
+            ++j;
+        } else if (i < records_a.size() && (j >= records_b.size() || remaining_b[records_a[i].key] == 0 ||
+                                            remaining_a[records_b[j].key] > 0)) {
+            add_hunk(whole_record_hunk(lines_a, records_a[i], '-', position_b, true));
+            --remaining_a[records_a[i].key];
+            ++i;
+        } else {
+            add_hunk(whole_record_hunk(lines_b, records_b[j], '+', position_a, false));
+            --remaining_b[records_b[j].key];
+            ++j;
+        }
+    }
+    return hunks;
+}
+
+
+// ---------------- FASTA ----------------
+
+std::vector<std::string> FastaDiffDriver::default_patterns() const {
+    return {"*.fa", "*.fasta", "*.fna", "*.ffn", "*.faa", "*.fas"};
+}
+
+std::optional<std::vector<DiffRecord>> FastaDiffDriver::split_records(const std::vector<std::string>& lines) const {
+    std::vector<DiffRecord> records;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if (lines[i].starts_with('>')) {
+            records.push_back({first_token(std::string_view(lines[i]).substr(1)), i, 1});
+        } else if (records.empty()) { // 第一条标题行之前的内容 (例如空行) 作为一条无标题的记录
+            records.push_back({"", i, 1});
+        } else {
+            ++records.back().line_count;
+        }
+    }
+    return records;
+}
+
+void FastaDiffDriver::diff_record(const std::vector<std::string>& lines_a, const DiffRecord& record_a,
+                                  const std::vector<std::string>& lines_b, const DiffRecord& record_b,
+                                  std::vector<DiffHunk>& hunks) const {
+    // 1. 标题行 (序列 ID 相同，描述可能不同)
+    const bool has_header = lines_a[record_a.first_line].starts_with('>');
+    const std::string header = has_header ? lines_a[record_a.first_line] : "";
+    if (has_header && lines_a[record_a.first_line] != lines_b[record_b.first_line]) {
+        DiffHunk hunk;
+        hunk.old_start = record_a.first_line;
+        hunk.old_count = 1;
+        hunk.new_start = record_b.first_line;
+        hunk.new_count = 1;
+        hunk.lines = {"-" + lines_a[record_a.first_line], "+" + lines_b[record_b.first_line]};
+        hunks.push_back(std::move(hunk));
+    }
+
+    // 2. 拼接序列行
+    const size_t seq_begin_a = record_a.first_line + (has_header ? 1 : 0);
+    const size_t seq_end_a = record_a.first_line + record_a.line_count;
+    const size_t seq_begin_b = record_b.first_line + (has_header ? 1 : 0);
+    const size_t seq_end_b = record_b.first_line + record_b.line_count;
+    std::vector<size_t> starts_a, starts_b;
+    std::string sequence_a = join_sequence_lines(lines_a, seq_begin_a, seq_end_a, starts_a);
+    std::string sequence_b = join_sequence_lines(lines_b, seq_begin_b, seq_end_b, starts_b);
+
+    if (sequence_a == sequence_b) {
+        // 序列相同但换行位置不同 (重新折叠)：只能按行比较
+        if (!same_lines(lines_a, seq_begin_a, seq_end_a - seq_begin_a, lines_b, seq_begin_b, seq_end_b - seq_begin_b)) {
+            append_line_diff_hunk(lines_a, seq_begin_a, seq_end_a, lines_b, seq_begin_b, seq_end_b, header, hunks);
+        }
+        return;
+    }
+
+    // 3. 字节级比较，并把相近的改动合并
+    std::vector<ByteEdit> edits = diff_sequence_bytes(sequence_a, sequence_b);
+    std::vector<ByteEdit> islands;
+    for (const auto& edit : edits) {
+        if (!islands.empty() && (edit.a_begin - islands.back().a_end < MERGE_GAP || edit.b_begin - islands.back().b_end < MERGE_GAP)) {
+            islands.back().a_end = edit.a_end;
+            islands.back().b_end = edit.b_end;
+        } else {
+            islands.push_back(edit);
+        }
+    }
+
+    // 4. 映射为行区间；行区间重叠或相接的改动合并为一个 Hunk
+    struct LineIsland { size_t a_first, a_last, b_first, b_last, position; };
+    std::vector<LineIsland> line_islands;
+    for (const auto& island : islands) {
+        auto [a_first, a_last] = byte_range_to_lines(starts_a, sequence_a.size(), island.a_begin, island.a_end);
+        auto [b_first, b_last] = byte_range_to_lines(starts_b, sequence_b.size(), island.b_begin, island.b_end);
+        if (!line_islands.empty() && (a_first <= line_islands.back().a_last || b_first <= line_islands.back().b_last)) {
+            line_islands.back().a_last = std::max(line_islands.back().a_last, a_last);
+            line_islands.back().b_last = std::max(line_islands.back().b_last, b_last);
+        } else {
+            line_islands.push_back({a_first, a_last, b_first, b_last, island.a_begin});
+        }
+    }
+
+    for (const auto& island : line_islands) {
+        DiffHunk hunk;
+        hunk.old_start = seq_begin_a + island.a_first;
+        hunk.old_count = island.a_last - island.a_first;
+        hunk.new_start = seq_begin_b + island.b_first;
+        hunk.new_count = island.b_last - island.b_first;
+        hunk.section = header + (header.empty() ? "" : " ") + "(碱基 " + std::to_string(island.position + 1) + ")";
+        for (size_t line = island.a_first; line < island.a_last; ++line) hunk.lines.push_back("-" + lines_a[seq_begin_a + line]);
+        for (size_t line = island.b_first; line < island.b_last; ++line) hunk.lines.push_back("+" + lines_b[seq_begin_b + line]);
+        hunks.push_back(std::move(hunk));
+    }
+}
+
+
+// ---------------- FASTQ ----------------
+
+std::vector<std::string> FastqDiffDriver::default_patterns() const {
+    return {"*.fq", "*.fastq"};
+}
+
+std::optional<std::vector<DiffRecord>> FastqDiffDriver::split_records(const std::vector<std::string>& lines) const {
+    if (lines.size() % 4 != 0) {
+        return std::nullopt;
+    }
+    std::vector<DiffRecord> records;
+    records.reserve(lines.size() / 4);
+    for (size_t i = 0; i < lines.size(); i += 4) {
+        if (!lines[i].starts_with('@') || !lines[i + 2].starts_with('+')) {
+            return std::nullopt; // 多行 FASTQ 或格式错误：回退到按行比较
+        }
+        records.push_back({first_token(std::string_view(lines[i]).substr(1)), i, 4});
+    }
+    return records;
+}
+
+
+// ---------------- VCF ----------------
+
+std::vector<std::string> VcfDiffDriver::default_patterns() const {
+    return {"*.vcf"};
+}
+
+std::optional<std::vector<DiffRecord>> VcfDiffDriver::split_records(const std::vector<std::string>& lines) const {
+    std::vector<DiffRecord> records;
+    records.reserve(lines.size());
+    for (size_t i = 0; i < lines.size(); ++i) {
+        const std::string& line = lines[i];
+        if (line.starts_with('#') || line.empty()) {
+            records.push_back({line, i, 1}); // 元信息与表头：整行作为键
+            continue;
+        }
+        size_t chrom_end = line.find('\t');
+        size_t pos_end = chrom_end == std::string::npos ? std::string::npos : line.find('\t', chrom_end + 1);
+        if (pos_end == std::string::npos) {
+            return std::nullopt; // 不是制表符分隔的 VCF 数据行
+        }
+        records.push_back({line.substr(0, pos_end), i, 1});
+    }
+    return records;
+}
+
+
+// ---------------- 注册表与输出 ----------------
+
+namespace DiffDrivers {
+
+namespace {
+
+const std::array<const DiffDriver*, 3>& registry() {
+    static const FastaDiffDriver fasta_driver;
+    static const FastqDiffDriver fastq_driver;
+    static const VcfDiffDriver vcf_driver;
+    static const std::array<const DiffDriver*, 3> drivers = {&fasta_driver, &fastq_driver, &vcf_driver};
+    return drivers;
+}
+
+std::vector<std::string> split_patterns(const std::string& value) {
+    std::vector<std::string> patterns;
+    std::string current;
+    for (char ch : value) {
+        if (ch == ',' || ch == ' ' || ch == '\t') {
+            if (!current.empty()) patterns.push_back(std::move(current));
+            current.clear();
+        } else {
+            current += ch;
+        }
+    }
+    if (!current.empty()) patterns.push_back(std::move(current));
+    return patterns;
+}
+
+/// 统一差异格式的起始行号 (1-based；行数为 0 时为插入位置之前的行号)
+size_t hunk_line_number(size_t start, size_t count) {
+    return count == 0 ? start : start + 1;
+}
+
+}
+
+bool glob_match(const std::string& pattern, const std::string& text) {
+    size_t p = 0, t = 0;
+    size_t star_p = std::string::npos, star_t = 0;
+    while (t < text.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+            ++p;
+            ++t;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star_p = p++;
+            star_t = t;
+        } else if (star_p != std::string::npos) { // 回溯：让上一个 '*' 多匹配一个字符
+            p = star_p + 1;
+            t = ++star_t;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') ++p;
+    return p == pattern.size();
+}
+
+const DiffDriver* find_for_path(const std::filesystem::path& relative_path, const ConfigLookup& config) {
+    const std::string file_name = relative_path.filename().string();
+    const std::string generic_path = relative_path.generic_string();
+    for (const DiffDriver* driver : registry()) {
+        std::vector<std::string> patterns = driver->default_patterns();
+        if (config) {
+            if (auto configured = config("diff." + std::string(driver->name()) + ".pattern")) {
+                patterns = split_patterns(*configured);
+            }
+        }
+        for (const auto& pattern : patterns) {
+            const std::string& subject = pattern.find('/') == std::string::npos ? file_name : generic_path;
+            if (glob_match(pattern, subject)) {
+                return driver;
+            }
+        }
+    }
+    return nullptr;
+}
+
+ConfigLookup snapshot_config(const ConfigLookup& config) {
+    auto values = std::make_shared<std::map<std::string, std::optional<std::string>>>();
+    if (config) {
+        for (const DiffDriver* driver : registry()) {
+            const std::string key = "diff." + std::string(driver->name()) + ".pattern";
+            (*values)[key] = config(key);
+        }
+    }
+    return [values](const std::string& key) -> std::optional<std::string> {
+        auto it = values->find(key);
+        return it != values->end() ? it->second : std::nullopt;
+    };
+}
+
+void print_hunks(const std::filesystem::path& old_file_path,
+                 const std::filesystem::path& new_file_path,
+                 const std::vector<DiffHunk>& hunks,
+                 const std::string& old_file_label_suffix,
+                 const std::string& new_file_label_suffix,
+                 const std::vector<std::string>& extended_header_lines,
+                 std::ostream& out) {
+    if (hunks.empty() && extended_header_lines.empty()) {
+        return;
+    }
+    out << "diff --biogit a/" << old_file_path.generic_string() << " b/" << new_file_path.generic_string() << std::endl;
+    for (const auto& header_line : extended_header_lines) {
+        out << header_line << std::endl;
+    }
+    if (hunks.empty()) {
+        return;
+    }
+    out << "--- a/" << old_file_path.generic_string() << old_file_label_suffix << std::endl;
+    out << "+++ b/" << new_file_path.generic_string() << new_file_label_suffix << std::endl;
+    for (const auto& hunk : hunks) {
+        out << "@@ -" << hunk_line_number(hunk.old_start, hunk.old_count) << "," << hunk.old_count
+            << " +" << hunk_line_number(hunk.new_start, hunk.new_count) << "," << hunk.new_count << " @@";
+        if (!hunk.section.empty()) {
+            out << " " << hunk.section;
+        }
+        out << std::endl;
+        for (const auto& line : hunk.lines) {
+            out << line << std::endl;
+        }
+    }
+}
+
+std::pair<int, int> count_changes(const std::vector<DiffHunk>& hunks) {
+    int insertions = 0, deletions = 0;
+    for (const auto& hunk : hunks) {
+        for (const auto& line : hunk.lines) {
+            if (line.starts_with('+')) ++insertions;
+            else if (line.starts_with('-')) ++deletions;
+        }
+    }
+    return {insertions, deletions};
+}
+
+}
+
+}
@@ -0,0 +1,221 @@
+#include "../include/FastExport.h"
+#include "../include/Repository.h"
+#include "../include/object.h"
+
+#include <iostream>
+#include <map>
+#include <unordered_set>
+
+namespace Biogit {
+
+FastExporter::FastExporter(const Repository& repo, std::ostream& out)
+    : repo_(repo), out_(out), objects_dir_(repo.get_objects_directory()) {}
+
+
+/**
+ * @brief 收集要导出的提交，按拓扑顺序排列，并为每个提交选定输出时使用的引用 (最先到达它的引用)。
+ * @details 用显式栈做后序遍历 (父提交先于子提交)，历史再长也不会递归过深。
+ */
+bool FastExporter::collect_commits(const std::vector<std::pair<std::string, std::string>>& refs,
+                                   const std::vector<std::string>& bases,
+                                   std::vector<std::pair<std::string, size_t>>& out_ordered) {
+    // 1. 基准提交可达的提交不导出
+    std::unordered_set<std::string> excluded;
+    std::vector<std::string> pending(bases.begin(), bases.end());
+    while (!pending.empty()) {
+        std::string commit_hash = pending.back();
+        pending.pop_back();
+        if (!excluded.insert(commit_hash).second) continue;
+        auto commit_opt = Commit::load_by_hash(commit_hash, objects_dir_);
+        if (!commit_opt) continue;
+        for (const auto& parent_hash : commit_opt->parent_hashes_hex) pending.push_back(parent_hash);
+    }
+
+    // 2. 从各引用出发后序遍历
+    std::unordered_set<std::string> visited;
+    for (size_t ref_index = 0; ref_index < refs.size(); ++ref_index) {
+        std::vector<std::pair<std::string, bool>> stack{{refs[ref_index].second, false}}; // <提交, 父提交是否已展开>
+        while (!stack.empty()) {
+            auto [commit_hash, expanded] = stack.back();
+            stack.pop_back();
+            if (expanded) {
+                out_ordered.emplace_back(commit_hash, ref_index);
+                continue;
+            }
+            if (excluded.count(commit_hash) || !visited.insert(commit_hash).second) continue;
+            auto commit_opt = Commit::load_by_hash(commit_hash, objects_dir_);
+            if (!commit_opt) {
+                std::cerr << "错误: 无法加载提交 " << commit_hash.substr(0, 7) << "。" << std::endl;
+                return false;
+            }
+            stack.emplace_back(commit_hash, true);
+            const auto& parents = commit_opt->parent_hashes_hex;
+            for (auto it = parents.rbegin(); it != parents.rend(); ++it) stack.emplace_back(*it, false); // 第一个父提交最先处理
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 比较两个 Tree，得到把旧树变成新树的 D/M 改动 (删除在前)。
+ * @details 两边按名称对齐条目：哈希和模式都相同的条目 (包括整个子树) 直接跳过；
+ *  只对两边都是目录且哈希不同的条目递归。整个目录被删除时只输出一条 D；新出现的目录必须展开以列出其中的文件。
+ */
+bool FastExporter::diff_trees(const std::string& old_tree_hash, const std::string& new_tree_hash,
+                              const std::string& prefix, std::vector<FileChange>& changes) const {
+    if (old_tree_hash == new_tree_hash) return true;
+
+    // 1. 加载两边的 Tree (空哈希视为空树)
+    std::optional<Tree> old_tree, new_tree;
+    std::map<std::string, const TreeEntry*> old_entries, new_entries;
+    if (!old_tree_hash.empty()) {
+        old_tree = Tree::load_by_hash(old_tree_hash, objects_dir_);
+        if (!old_tree) { std::cerr << "错误: 无法加载 Tree 对象 " << old_tree_hash.substr(0, 7) << "。" << std::endl; return false; }
+        for (const auto& entry : old_tree->entries) old_entries[entry.name] = &entry;
+    }
+    if (!new_tree_hash.empty()) {
+        new_tree = Tree::load_by_hash(new_tree_hash, objects_dir_);
+        if (!new_tree) { std::cerr << "错误: 无法加载 Tree 对象 " << new_tree_hash.substr(0, 7) << "。" << std::endl; return false; }
+        for (const auto& entry : new_tree->entries) new_entries[entry.name] = &entry;
+    }
+
+    // 2. 逐个名称比较
+    for (const auto& [name, old_entry] : old_entries) {
+        auto new_it = new_entries.find(name);
+        const TreeEntry* new_entry = new_it != new_entries.end() ? new_it->second : nullptr;
+        if (new_entry && old_entry->sha1_hash_hex == new_entry->sha1_hash_hex && old_entry->mode == new_entry->mode) continue;
+        const std::string path = prefix + name;
+        if (new_entry && old_entry->is_directory() && new_entry->is_directory()) {
+            if (!diff_trees(old_entry->sha1_hash_hex, new_entry->sha1_hash_hex, path + "/", changes)) return false;
+        } else if (!new_entry || old_entry->is_directory() != new_entry->is_directory()) {
+            changes.push_back({true, path, "", ""}); // 删除，或文件与目录互相替换
+        }
+    }
+    for (const auto& [name, new_entry] : new_entries) {
+        auto old_it = old_entries.find(name);
+        const TreeEntry* old_entry = old_it != old_entries.end() ? old_it->second : nullptr;
+        if (old_entry && old_entry->sha1_hash_hex == new_entry->sha1_hash_hex && old_entry->mode == new_entry->mode) continue;
+        const std::string path = prefix + name;
+        if (new_entry->is_directory()) {
+            if (old_entry && old_entry->is_directory()) continue; // 已在上面递归比较
+            if (!diff_trees("", new_entry->sha1_hash_hex, path + "/", changes)) return false;
+        } else {
+            changes.push_back({false, path, new_entry->mode, new_entry->sha1_hash_hex});
+        }
+    }
+    return true;
+}
+
+
+std::string FastExporter::quote_path(const std::string& path) {
+    if (path.find_first_of("\"\n") == std::string::npos) return path;
+    std::string quoted = "\"";
+    for (char c : path) {
+        if (c == '"' || c == '\\') quoted += '\\';
+        if (c == '\n') quoted += "\\n";
+        else quoted += c;
+    }
+    return quoted + "\"";
+}
+
+std::string FastExporter::commit_ref(const std::string& commit_hash) const {
+    auto it = marks_.find(commit_hash);
+    return it != marks_.end() ? ":" + std::to_string(it->second) : commit_hash; // 未导出的提交 (基准可达) 直接用哈希
+}
+
+bool FastExporter::emit_blob(const std::string& blob_hash) {
+    if (marks_.count(blob_hash)) return true; // 已输出过，用标记引用
+    auto blob_opt = Blob::load_by_hash(blob_hash, objects_dir_);
+    if (!blob_opt) {
+        std::cerr << "错误: 无法加载 Blob 对象 " << blob_hash.substr(0, 7) << "。" << std::endl;
+        return false;
+    }
+    const std::uint64_t mark = next_mark_++;
+    out_ << "blob\nmark :" << mark << "\ndata " << blob_opt->content.size() << "\n";
+    out_.write(reinterpret_cast<const char*>(blob_opt->content.data()), static_cast<std::streamsize>(blob_opt->content.size()));
+    out_ << "\n";
+    marks_[blob_hash] = mark;
+    ++blob_count_;
+    return true;
+}
+
+bool FastExporter::emit_commit(const std::string& commit_hash, const std::string& ref_name) {
+    auto commit_opt = Commit::load_by_hash(commit_hash, objects_dir_);
+    if (!commit_opt) {
+        std::cerr << "错误: 无法加载提交 " << commit_hash.substr(0, 7) << "。" << std::endl;
+        return false;
+    }
+    const Commit& commit = *commit_opt;
+
+    // 1. 相对第一个父提交的改动，先输出其中尚未输出的 Blob
+    std::string parent_tree_hash;
+    if (!commit.parent_hashes_hex.empty()) {
+        auto parent_opt = Commit::load_by_hash(commit.parent_hashes_hex[0], objects_dir_);
+        if (!parent_opt) {
+            std::cerr << "错误: 无法加载提交 " << commit.parent_hashes_hex[0].substr(0, 7) << "。" << std::endl;
+            return false;
+        }
+        parent_tree_hash = parent_opt->tree_hash_hex;
+    }
+    std::vector<FileChange> changes;
+    if (!diff_trees(parent_tree_hash, commit.tree_hash_hex, "", changes)) return false;
+    for (const FileChange& change : changes) {
+        if (!change.deleted && !emit_blob(change.hash)) return false;
+    }
+
+    // 2. 提交头部
+    if (commit.parent_hashes_hex.empty()) out_ << "reset " << ref_name << "\n"; // 根提交不接在引用已有的提交之后
+    const std::uint64_t mark = next_mark_++;
+    out_ << "commit " << ref_name << "\nmark :" << mark << "\n";
+    out_ << "author " << commit.author.format_for_commit() << "\n";
+    out_ << "committer " << commit.committer.format_for_commit() << "\n";
+    out_ << "data " << commit.message.size() + 1 << "\n" << commit.message << "\n";
+    for (size_t i = 0; i < commit.parent_hashes_hex.size(); ++i) {
+        const std::string& parent_hash = commit.parent_hashes_hex[i];
+        if (i > 0) out_ << "merge " << commit_ref(parent_hash) << "\n";
+        else if (last_commit_on_ref_[ref_name] != parent_hash) out_ << "from " << commit_ref(parent_hash) << "\n";
+    }
+
+    // 3. 文件改动 (删除已排在前面)
+    for (const FileChange& change : changes) {
+        if (change.deleted) out_ << "D " << quote_path(change.path) << "\n";
+    }
+    for (const FileChange& change : changes) {
+        if (!change.deleted) out_ << "M " << change.mode << " :" << marks_[change.hash] << " " << quote_path(change.path) << "\n";
+    }
+    out_ << "\n";
+
+    marks_[commit_hash] = mark;
+    last_commit_on_ref_[ref_name] = commit_hash;
+    ++commit_count_;
+    return out_.good();
+}
+
+
+bool FastExporter::run(const std::vector<std::pair<std::string, std::string>>& refs, const std::vector<std::string>& bases) {
+    // 1. 拓扑排序
+    std::vector<std::pair<std::string, size_t>> ordered_commits;
+    if (!collect_commits(refs, bases, ordered_commits)) return false;
+
+    // 2. 逐个输出提交
+    for (const auto& [commit_hash, ref_index] : ordered_commits) {
+        if (!emit_commit(commit_hash, refs[ref_index].first)) return false;
+    }
+
+    // 3. 引用的最终位置 (提交可能是以其他引用的名义输出的)
+    for (const auto& [ref_name, tip_hash] : refs) {
+        auto it = last_commit_on_ref_.find(ref_name);
+        if (it != last_commit_on_ref_.end() && it->second == tip_hash) continue;
+        out_ << "reset " << ref_name << "\nfrom " << commit_ref(tip_hash) << "\n\n";
+    }
+    out_.flush();
+    if (!out_.good()) {
+        std::cerr << "错误: 写入导出流失败。" << std::endl;
+        return false;
+    }
+    std::cerr << "fast-export: 导出 " << blob_count_ << " 个 Blob，" << commit_count_ << " 个提交，"
+              << refs.size() << " 个引用。" << std::endl;
+    return true;
+}
+
+}
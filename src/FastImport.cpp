@@ -0,0 +1,514 @@
+#include "../include/FastImport.h"
+#include "../include/Repository.h"
+#include "../include/object.h"
+#include "../include/ObjectAlternates.h"
+
+#include <fstream>
+#include <iostream>
+
+namespace Biogit {
+
+namespace {
+
+bool starts_with(const std::string& s, const std::string& prefix) {
+    return s.rfind(prefix, 0) == 0;
+}
+
+bool is_hex_hash(const std::string& s) {
+    return ObjectFormat::is_id_length(s.length()) && s.find_first_not_of("0123456789abcdef") == std::string::npos;
+}
+
+/// 引用名补全：不以 refs/ 开头的视为分支名
+std::string full_ref_name(const std::string& name) {
+    return starts_with(name, "refs/") ? name : "refs/heads/" + name;
+}
+
+}
+
+
+FastImporter::FastImporter(Repository& repo, bool force)
+    : repo_(repo), force_(force), objects_dir_(repo.get_objects_directory()),
+      chunk_threshold_(repo._chunk_threshold()), bloom_store_(repo.get_common_directory()) {
+    bloom_store_.load();
+}
+
+FastImporter::~FastImporter() = default;
+
+
+bool FastImporter::error(const std::string& message) {
+    std::cerr << "错误: fast-import 第 " << line_number_ << " 行: " << message << std::endl;
+    return false;
+}
+
+bool FastImporter::read_line(std::istream& in, std::string& line) {
+    if (has_pending_line_) {
+        line = std::move(pending_line_);
+        has_pending_line_ = false;
+        return true;
+    }
+    if (!std::getline(in, line)) return false;
+    ++line_number_;
+    return true;
+}
+
+/**
+ * @brief 读取 data 命令的内容："data <字节数>" 之后正好读取该数量的字节 (其后可选一个换行)；
+ *        "data <<<分隔符>" 之后逐行读取，直到遇到只含分隔符的行。
+ */
+bool FastImporter::read_data(std::istream& in, const std::string& data_line, std::string& out_data) {
+    out_data.clear();
+    const std::string spec = data_line.substr(5);
+    if (starts_with(spec, "<<")) {
+        const std::string delimiter = spec.substr(2);
+        std::string line;
+        while (true) {
+            if (!std::getline(in, line)) return error("data 内容缺少结束分隔符 '" + delimiter + "'。");
+            ++line_number_;
+            if (line == delimiter) return true;
+            out_data += line;
+            out_data += '\n';
+        }
+    }
+
+    uint64_t size = 0;
+    try {
+        size_t parsed = 0;
+        size = std::stoull(spec, &parsed);
+        if (parsed != spec.size()) return error("无效的 data 长度 '" + spec + "'。");
+    } catch (const std::exception&) {
+        return error("无效的 data 长度 '" + spec + "'。");
+    }
+    out_data.resize(static_cast<size_t>(size));
+    if (size > 0 && !in.read(out_data.data(), static_cast<std::streamsize>(size))) {
+        return error("data 内容被截断 (应有 " + std::to_string(size) + " 字节)。");
+    }
+    for (char c : out_data) if (c == '\n') ++line_number_;
+    if (in.peek() == '\n') {
+        in.get();
+        ++line_number_;
+    }
+    return true;
+}
+
+std::optional<std::uint64_t> FastImporter::parse_mark(const std::string& text) const {
+    if (text.size() < 2 || text[0] != ':' || text.find_first_not_of("0123456789", 1) != std::string::npos) return std::nullopt;
+    try {
+        return std::stoull(text.substr(1));
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
+/**
+ * @brief 解析路径：支持 C 风格引号 (\\ \" \n \t 和三位八进制转义)；拒绝空路径、空组件以及 "." 和 ".."。
+ */
+std::optional<std::string> FastImporter::parse_path(const std::string& text) const {
+    std::string path;
+    if (!text.empty() && text[0] == '"') {
+        if (text.size() < 2 || text.back() != '"') return std::nullopt;
+        const size_t end = text.size() - 1; // 结束引号的位置
+        for (size_t i = 1; i < end; ++i) {
+            char c = text[i];
+            if (c != '\\') {
+                path += c;
+                continue;
+            }
+            if (++i >= end) return std::nullopt;
+            char escaped = text[i];
+            if (escaped == 'n') path += '\n';
+            else if (escaped == 't') path += '\t';
+            else if (escaped >= '0' && escaped <= '7' && i + 2 < end) {
+                path += static_cast<char>(((escaped - '0') << 6) | ((text[i + 1] - '0') << 3) | (text[i + 2] - '0'));
+                i += 2;
+            } else path += escaped;
+        }
+    } else {
+        path = text;
+    }
+
+    if (path.empty()) return std::nullopt;
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t slash = path.find('/', start);
+        std::string component = path.substr(start, slash == std::string::npos ? std::string::npos : slash - start);
+        if (component.empty() || component == "." || component == "..") return std::nullopt;
+        if (slash == std::string::npos) break;
+        start = slash + 1;
+    }
+    return path;
+}
+
+
+std::optional<std::string> FastImporter::store_blob(const std::string& data) {
+    Blob blob(data);
+    std::optional<std::string> hash_opt =
+        (chunk_threshold_ > 0 && data.size() >= chunk_threshold_)
+            ? blob.save_chunked(objects_dir_, chunker_)
+            : blob.save(objects_dir_);
+    if (hash_opt) ++blob_count_;
+    return hash_opt;
+}
+
+std::optional<std::string> FastImporter::resolve_data_ref(const std::string& data_ref) {
+    if (auto mark = parse_mark(data_ref)) {
+        auto it = marks_.find(*mark);
+        if (it == marks_.end()) {
+            error("未定义的标记 '" + data_ref + "'。");
+            return std::nullopt;
+        }
+        return it->second;
+    }
+    if (is_hex_hash(data_ref) && ObjectAlternates::contains(objects_dir_, data_ref)) return data_ref;
+    error("无效的数据引用 '" + data_ref + "'。");
+    return std::nullopt;
+}
+
+std::optional<std::string> FastImporter::resolve_commit(const std::string& commit_ish) {
+    if (auto mark = parse_mark(commit_ish)) {
+        auto it = marks_.find(*mark);
+        if (it != marks_.end()) return it->second;
+        error("未定义的标记 '" + commit_ish + "'。");
+        return std::nullopt;
+    }
+    if (is_hex_hash(commit_ish) && ObjectAlternates::contains(objects_dir_, commit_ish)) return commit_ish;
+    for (const std::string& name : {commit_ish, full_ref_name(commit_ish)}) {
+        auto it = branches_.find(name);
+        if (it != branches_.end() && !it->second.commit_hash.empty()) return it->second.commit_hash;
+    }
+    if (auto resolved = repo_._resolve_commit_ish_to_full_hash(commit_ish)) return resolved;
+    error("无法解析提交 '" + commit_ish + "'。");
+    return std::nullopt;
+}
+
+
+bool FastImporter::load_node(TreeNode& node) {
+    if (node.loaded) return true;
+    node.loaded = true;
+    if (node.hash.empty()) return true;
+    auto tree_opt = Tree::load_by_hash(node.hash, objects_dir_);
+    if (!tree_opt) return error("无法加载 Tree 对象 " + node.hash.substr(0, 7) + "。");
+    for (const auto& entry : tree_opt->entries) {
+        TreeNodeEntry node_entry{entry.mode, entry.sha1_hash_hex, nullptr};
+        if (entry.is_directory()) {
+            node_entry.subtree = std::make_unique<TreeNode>();
+            node_entry.subtree->hash = entry.sha1_hash_hex;
+        }
+        node.entries.emplace(entry.name, std::move(node_entry));
+    }
+    return true;
+}
+
+bool FastImporter::set_path(TreeNode& root, const std::string& path, const std::string& mode, const std::string& hash) {
+    TreeNode* node = &root;
+    size_t start = 0;
+    size_t slash;
+    while ((slash = path.find('/', start)) != std::string::npos) {
+        if (!load_node(*node)) return false;
+        node->hash.clear();
+        TreeNodeEntry& entry = node->entries[path.substr(start, slash - start)];
+        if (!entry.subtree) { // 新目录，或用目录替换同名文件
+            entry.mode = "040000";
+            entry.subtree = std::make_unique<TreeNode>();
+            entry.subtree->loaded = true;
+        }
+        entry.hash.clear();
+        node = entry.subtree.get();
+        start = slash + 1;
+    }
+    if (!load_node(*node)) return false;
+    node->hash.clear();
+    node->entries[path.substr(start)] = TreeNodeEntry{mode, hash, nullptr};
+    return true;
+}
+
+bool FastImporter::remove_path(TreeNode& node, const std::string& path) {
+    if (!load_node(node)) return false;
+    size_t slash = path.find('/');
+    auto it = node.entries.find(path.substr(0, slash));
+    if (it == node.entries.end()) return true; // 路径不存在，忽略
+    if (slash == std::string::npos) {
+        node.entries.erase(it);
+        node.hash.clear();
+        return true;
+    }
+    if (!it->second.subtree) return true;
+    TreeNode& child = *it->second.subtree;
+    if (!remove_path(child, path.substr(slash + 1))) return false;
+    if (child.hash.empty()) { // 子目录有改动 (改动过的目录的各级父目录也都标记为已改动)
+        node.hash.clear();
+        it->second.hash.clear();
+        if (child.entries.empty()) node.entries.erase(it); // 不保留空目录
+    }
+    return true;
+}
+
+std::optional<std::string> FastImporter::write_node(TreeNode& node) {
+    if (!node.hash.empty()) return node.hash; // 未修改的子树不展开、不重写
+    std::vector<TreeEntry> tree_entries;
+    tree_entries.reserve(node.entries.size());
+    for (auto& [name, entry] : node.entries) {
+        if (entry.subtree) {
+            std::optional<std::string> subtree_hash = write_node(*entry.subtree);
+            if (!subtree_hash) return std::nullopt;
+            entry.hash = *subtree_hash;
+        }
+        tree_entries.emplace_back(entry.mode, name, entry.hash);
+    }
+    Tree tree;
+    tree.set_entries(std::move(tree_entries));
+    std::optional<std::string> hash_opt = tree.save(objects_dir_);
+    if (!hash_opt) {
+        error("保存 Tree 对象失败。");
+        return std::nullopt;
+    }
+    node.hash = *hash_opt;
+    return node.hash;
+}
+
+FastImporter::BranchState& FastImporter::branch_state(const std::string& ref_name) {
+    auto it = branches_.find(ref_name);
+    if (it != branches_.end()) return it->second;
+
+    // 第一次用到的引用：从仓库中已有的引用开始
+    BranchState state;
+    state.root = std::make_unique<TreeNode>();
+    std::ifstream ref_ifs(repo_.get_common_directory() / ref_name);
+    std::string commit_hash;
+    if (ref_ifs >> commit_hash && is_hex_hash(commit_hash)) {
+        if (auto commit_opt = Commit::load_by_hash(commit_hash, objects_dir_)) {
+            state.commit_hash = commit_hash;
+            state.root->hash = commit_opt->tree_hash_hex;
+        }
+    }
+    if (state.root->hash.empty()) state.root->loaded = true;
+    return branches_.emplace(ref_name, std::move(state)).first->second;
+}
+
+
+bool FastImporter::parse_blob(std::istream& in) {
+    std::string line;
+    std::optional<std::uint64_t> mark;
+    if (!read_line(in, line)) return error("blob 命令不完整。");
+    if (starts_with(line, "mark ")) {
+        mark = parse_mark(line.substr(5));
+        if (!mark) return error("无效的标记 '" + line.substr(5) + "'。");
+        if (!read_line(in, line)) return error("blob 命令不完整。");
+    }
+    if (starts_with(line, "original-oid ") && !read_line(in, line)) return error("blob 命令不完整。");
+    if (!starts_with(line, "data ")) return error("blob 命令缺少 data。");
+
+    std::string data;
+    if (!read_data(in, line, data)) return false;
+    std::optional<std::string> hash_opt = store_blob(data);
+    if (!hash_opt) return error("保存 Blob 失败。");
+    if (mark) marks_[*mark] = *hash_opt;
+    return true;
+}
+
+bool FastImporter::parse_commit(std::istream& in, const std::string& ref_name) {
+    std::string line;
+    std::optional<std::uint64_t> mark;
+    auto next_line = [&]() { return read_line(in, line) || error("commit 命令不完整。"); };
+
+    // 1. 头部：mark、author、committer、提交信息
+    if (!next_line()) return false;
+    if (starts_with(line, "mark ")) {
+        mark = parse_mark(line.substr(5));
+        if (!mark) return error("无效的标记 '" + line.substr(5) + "'。");
+        if (!next_line()) return false;
+    }
+    if (starts_with(line, "original-oid ") && !next_line()) return false;
+    std::optional<PersonTimestamp> author;
+    if (starts_with(line, "author ")) {
+        author = PersonTimestamp::parse_from_line_content(line.substr(7));
+        if (!author) return error("无效的 author 行。");
+        if (!next_line()) return false;
+    }
+    if (!starts_with(line, "committer ")) return error("commit 命令缺少 committer。");
+    std::optional<PersonTimestamp> committer = PersonTimestamp::parse_from_line_content(line.substr(10));
+    if (!committer) return error("无效的 committer 行。");
+    if (!next_line()) return false;
+    if (!starts_with(line, "data ")) return error("commit 命令缺少提交信息 (data)。");
+    std::string message;
+    if (!read_data(in, line, message)) return false;
+    while (!message.empty() && message.back() == '\n') message.pop_back(); // 与本地提交一致，不保存末尾换行
+
+    // 2. 父提交：from 重置分支的树；没有 from 时接在分支当前提交之后
+    BranchState& state = branch_state(ref_name);
+    std::vector<std::string> parents;
+    bool have_line = static_cast<bool>(read_line(in, line));
+    if (have_line && starts_with(line, "from ")) {
+        std::optional<std::string> from_hash = resolve_commit(line.substr(5));
+        if (!from_hash) return false;
+        auto from_commit = Commit::load_by_hash(*from_hash, objects_dir_);
+        if (!from_commit) return error("无法加载提交 " + from_hash->substr(0, 7) + "。");
+        parents.push_back(*from_hash);
+        state.root = std::make_unique<TreeNode>();
+        state.root->hash = from_commit->tree_hash_hex;
+        have_line = static_cast<bool>(read_line(in, line));
+    } else if (!state.commit_hash.empty()) {
+        parents.push_back(state.commit_hash);
+    }
+    while (have_line && starts_with(line, "merge ")) {
+        std::optional<std::string> merge_hash = resolve_commit(line.substr(6));
+        if (!merge_hash) return false;
+        parents.push_back(*merge_hash);
+        have_line = static_cast<bool>(read_line(in, line));
+    }
+    const std::string parent_tree_hash = state.root->hash;
+
+    // 3. 文件修改
+    while (have_line) {
+        if (starts_with(line, "M ")) {
+            size_t mode_end = line.find(' ', 2);
+            size_t ref_end = mode_end == std::string::npos ? std::string::npos : line.find(' ', mode_end + 1);
+            if (ref_end == std::string::npos) return error("无效的 M 命令。");
+            std::string mode = line.substr(2, mode_end - 2);
+            const std::string data_ref = line.substr(mode_end + 1, ref_end - mode_end - 1);
+            std::optional<std::string> path = parse_path(line.substr(ref_end + 1));
+            if (!path) return error("无效的路径 '" + line.substr(ref_end + 1) + "'。");
+            if (mode == "644") mode = "100644";
+            else if (mode == "755") mode = "100755";
+            if (mode != "100644" && mode != "100755" && mode != "120000") return error("不支持的文件模式 '" + mode + "'。");
+
+            std::optional<std::string> blob_hash;
+            if (data_ref == "inline") {
+                std::string data_line, data;
+                if (!read_line(in, data_line) || !starts_with(data_line, "data ")) return error("inline 之后缺少 data。");
+                if (!read_data(in, data_line, data)) return false;
+                blob_hash = store_blob(data);
+                if (!blob_hash) return error("保存 Blob 失败。");
+            } else {
+                blob_hash = resolve_data_ref(data_ref);
+                if (!blob_hash) return false;
+            }
+            if (!set_path(*state.root, *path, mode, *blob_hash)) return false;
+        } else if (starts_with(line, "D ")) {
+            std::optional<std::string> path = parse_path(line.substr(2));
+            if (!path) return error("无效的路径 '" + line.substr(2) + "'。");
+            if (!remove_path(*state.root, *path)) return false;
+        } else if (line == "deleteall") {
+            state.root = std::make_unique<TreeNode>();
+            state.root->loaded = true;
+        } else if (line.empty()) {
+            break; // 提交结束
+        } else {
+            pending_line_ = std::move(line); // 下一条命令
+            has_pending_line_ = true;
+            break;
+        }
+        have_line = static_cast<bool>(read_line(in, line));
+    }
+
+    // 4. 写出修改过的 Tree 和 Commit
+    std::optional<std::string> tree_hash = write_node(*state.root);
+    if (!tree_hash) return false;
+    Commit commit;
+    commit.tree_hash_hex = *tree_hash;
+    commit.parent_hashes_hex = parents;
+    commit.committer = *committer;
+    commit.author = author ? *author : *committer;
+    commit.message = message;
+    std::optional<std::string> commit_hash = commit.save(objects_dir_);
+    if (!commit_hash) return error("保存 Commit 失败。");
+    state.commit_hash = *commit_hash;
+    if (mark) marks_[*mark] = *commit_hash;
+    ++commit_count_;
+
+    // 5. 记录改动路径过滤器 (只比较哈希不同的子树)
+    //    有子树无法加载时不记录：不完整的过滤器会让路径限定的 log 漏掉该提交
+    std::set<std::string> changed_paths;
+    if (repo_._collect_changed_paths(parent_tree_hash, *tree_hash, "", changed_paths)) {
+        bloom_store_.record(*commit_hash, changed_paths);
+    }
+    return true;
+}
+
+bool FastImporter::parse_reset(std::istream& in, const std::string& ref_name) {
+    BranchState& state = branch_state(ref_name);
+    std::string line;
+    if (read_line(in, line)) {
+        if (starts_with(line, "from ")) {
+            std::optional<std::string> from_hash = resolve_commit(line.substr(5));
+            if (!from_hash) return false;
+            auto from_commit = Commit::load_by_hash(*from_hash, objects_dir_);
+            if (!from_commit) return error("无法加载提交 " + from_hash->substr(0, 7) + "。");
+            state.commit_hash = *from_hash;
+            state.root = std::make_unique<TreeNode>();
+            state.root->hash = from_commit->tree_hash_hex;
+            return true;
+        }
+        if (!line.empty()) {
+            pending_line_ = std::move(line);
+            has_pending_line_ = true;
+        }
+    }
+    // 没有 from：之后在此引用上的提交是根提交
+    state.commit_hash.clear();
+    state.root = std::make_unique<TreeNode>();
+    state.root->loaded = true;
+    return true;
+}
+
+
+bool FastImporter::update_refs() {
+    if (!repo_._sync_objects()) return false; // 导入的对象先落盘，再移动引用
+    bool all_updated = true;
+    for (const auto& [ref_name, state] : branches_) {
+        if (state.commit_hash.empty()) continue;
+        const std::filesystem::path ref_file = repo_.get_common_directory() / ref_name;
+        std::string old_hash;
+        {
+            std::ifstream ref_ifs(ref_file);
+            ref_ifs >> old_hash;
+        }
+        if (old_hash == state.commit_hash) continue;
+        if (is_hex_hash(old_hash) && !force_ &&
+            repo_._find_common_ancestor(old_hash, state.commit_hash).value_or("") != old_hash) {
+            std::cerr << "错误: 引用 '" << ref_name << "' 不是快进更新 (" << old_hash.substr(0, 7) << " -> "
+                      << state.commit_hash.substr(0, 7) << ")，未更新。使用 --force 覆盖。" << std::endl;
+            all_updated = false;
+            continue;
+        }
+        std::error_code ec;
+        std::filesystem::create_directories(ref_file.parent_path(), ec);
+        std::ofstream ref_ofs(ref_file, std::ios::trunc);
+        ref_ofs << state.commit_hash << std::endl;
+        if (!ref_ofs.good()) {
+            std::cerr << "错误: 无法写入引用文件 '" << ref_file.string() << "'。" << std::endl;
+            all_updated = false;
+        } else {
+            ++ref_count_;
+        }
+    }
+    return all_updated;
+}
+
+
+bool FastImporter::run(std::istream& in) {
+    std::string line;
+    bool ok = true;
+    while (ok && read_line(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        if (line == "blob") ok = parse_blob(in);
+        else if (starts_with(line, "commit ") || starts_with(line, "reset ")) {
+            // 引用名之后会拼接成公共目录下的文件路径
+            const bool is_commit = starts_with(line, "commit ");
+            const std::string ref_name = full_ref_name(line.substr(is_commit ? 7 : 6));
+            if (!Repository::is_valid_ref_name(ref_name)) ok = error("无效的引用名 '" + ref_name + "'。");
+            else ok = is_commit ? parse_commit(in, ref_name) : parse_reset(in, ref_name);
+        }
+        else if (starts_with(line, "progress ")) std::cout << line << std::endl;
+        else if (line == "checkpoint") ok = update_refs();
+        else if (line == "done") break;
+        else ok = error("未知命令 '" + line + "'。");
+    }
+
+    // 引用在流结束 (或出错) 时统一更新：出错前已完整写出的提交仍然可达
+    bool refs_ok = update_refs();
+    std::cout << "fast-import: 导入 " << blob_count_ << " 个 Blob，" << commit_count_ << " 个提交，"
+              << ref_count_ << " 个引用。" << std::endl;
+    return ok && refs_ok;
+}
+
+}
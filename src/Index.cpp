@@ -5,6 +5,7 @@
 #include <sstream>
 #include <filesystem>
 #include "Repository.h"
+#include "ObjectFormat.h"
 
 namespace Biogit {
 
@@ -50,7 +51,7 @@ std::optional<IndexEntry> IndexEntry::parse_from_line(const std::string& line) {
         return std::nullopt;
     }
 
-    if (entry.blob_hash_hex.length() != 40) return std::nullopt; // 哈希长度校验
+    if (!ObjectFormat::is_id_length(entry.blob_hash_hex.length())) return std::nullopt; // 哈希长度校验
 
     entry.file_path = std::filesystem::path(path_str).lexically_normal(); // 规范化路径
 
@@ -78,12 +79,35 @@ Index::Index(const std::filesystem::path& biogit_dir_path)
 
 }
 
-void Index::sort_entries_() {
-    std::sort(entries_.begin(), entries_.end());
+void Index::sort_entries_() const {
+    if (sorted_) return;
+    std::sort(entries_.begin(), entries_.end(), [this](const IndexEntry& a, const IndexEntry& b) {
+        return paths_.less(a.path_id, b.path_id);
+    });
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        slots_[entries_[i].path_id] = i;
+    }
+    sorted_ = true;
+}
+
+void Index::put_entry_(IndexEntry&& entry) {
+    auto slot_it = slots_.find(entry.path_id);
+    if (slot_it != slots_.end()) {
+        entries_[slot_it->second] = std::move(entry); // 更新 (位置不变)
+        return;
+    }
+    if (!entries_.empty() && !paths_.less(entries_.back().path_id, entry.path_id)) {
+        sorted_ = false; // 不是追加在末尾的有序位置，延迟到读取时统一排序
+    }
+    slots_.emplace(entry.path_id, entries_.size());
+    entries_.push_back(std::move(entry)); // 添加
 }
 
 bool Index::load() {
     entries_.clear();
+    slots_.clear();
+    paths_.clear();
+    sorted_ = true;
     loaded_ = false;
 
     if (!std::filesystem::exists(index_file_path_)) {
@@ -109,13 +133,14 @@ bool Index::load() {
         // 对于非空白行，尝试解析
         auto entry_opt = IndexEntry::parse_from_line(line);
         if (entry_opt) {
-            entries_.push_back(*entry_opt);
+            entry_opt->path_id = paths_.intern(entry_opt->file_path.generic_string());
+            put_entry_(std::move(*entry_opt));
         } else {
             // 如果 IndexEntry::parse_from_line 对一个非空白行返回了 std::nullopt，
             // 这意味着该行数据格式有问题。
             std::cerr << "错误 (Index::load): 解析索引文件第 " << line_number << " 行失败，索引可能已损坏: '" << line << "'" << std::endl;
+            clear_in_memory();  // 清空已部分加载的条目，保持状态一致性
             loaded_ = false;    // 标记加载失败
-            entries_.clear();   // 清空已部分加载的条目，保持状态一致性
             // ifs.close(); // RAII 会处理关闭，但显式关闭也可以
             return false;       // 遇到无法解析的有效数据行，则认为加载失败
         }
@@ -124,8 +149,8 @@ bool Index::load() {
     // 检查循环是否因为流本身的错误（而不是正常EOF）而终止
     if (ifs.bad()) {
         std::cerr << "错误: 读取索引文件时发生底层I/O错误: " << index_file_path_.string() << std::endl;
+        clear_in_memory();
         loaded_ = false;
-        entries_.clear();
         return false;
     }
     // 如果循环正常结束（因为到达EOF），并且没有因为解析错误提前返回，那么加载是成功的。
@@ -137,6 +162,7 @@ bool Index::load() {
 }
 
 bool Index::write() const {
+    sort_entries_();
     std::ofstream ofs(index_file_path_, std::ios::trunc); // trunc 会清空已存在的文件
     if (!ofs.is_open()) {
         std::cerr << "错误: 无法打开索引文件进行写入: " << index_file_path_.string() << std::endl;
@@ -168,28 +194,28 @@ bool Index::add_or_update_entry(const std::filesystem::path& relative_path,
     }
 
     // 假设 relative_path 已经是规范化的、相对于工作树根的路径
+    return add_or_update_entry(paths_.intern(relative_path.generic_string()), blob_hash_hex, file_mode, mtime, file_size);
+}
+
+bool Index::add_or_update_entry(PathTable::PathId path_id,
+                                    const std::string& blob_hash_hex,
+                                    const std::string& file_mode,
+                                    const std::chrono::system_clock::time_point& mtime,
+                                    uint64_t file_size) {
     IndexEntry new_entry;
     new_entry.mode = file_mode;
     new_entry.blob_hash_hex = blob_hash_hex;
-    new_entry.file_path = relative_path;
+    new_entry.file_path = paths_.path(path_id);
+    new_entry.path_id = path_id;
     new_entry.mtime = mtime;
     new_entry.file_size = file_size;
 
-    if (new_entry.blob_hash_hex.length() != 40) { // 基本验证
+    if (!ObjectFormat::is_id_length(new_entry.blob_hash_hex.length())) { // 基本验证
         std::cerr << "错误: 尝试添加的 IndexEntry 哈希无效: " << new_entry.file_path.string() << std::endl;
         return false;
     }
 
-    auto it = std::find_if(entries_.begin(), entries_.end(),
-                           [&relative_path](const IndexEntry& e){ return e.file_path == relative_path; });
-
-    if (it != entries_.end()) {
-        *it = new_entry; // 更新
-    } else {
-        entries_.push_back(new_entry); // 添加
-    }
-
-    sort_entries_(); // 添加或更新后排序
+    put_entry_(std::move(new_entry)); // 已有条目按 ID 原地更新，新条目追加 (需要时再排序)
     return true;
 }
 
@@ -203,34 +229,46 @@ bool Index::remove_entry(const std::filesystem::path& relative_path) {
     }
 
     // relative_path 已经是规范化的
-    auto initial_size = entries_.size();
-    entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
-                                  [&relative_path](const IndexEntry& e){ return e.file_path == relative_path; }),
-                   entries_.end());
+    std::optional<PathTable::PathId> path_id_opt = paths_.find(relative_path.generic_string());
+    if (!path_id_opt) return false;
+    auto slot_it = slots_.find(*path_id_opt);
+    if (slot_it == slots_.end()) return false;
+
+    const size_t removed_slot = slot_it->second;
+    slots_.erase(slot_it);
+    entries_.erase(entries_.begin() + static_cast<std::ptrdiff_t>(removed_slot));
+    for (size_t i = removed_slot; i < entries_.size(); ++i) {
+        slots_[entries_[i].path_id] = i; // 之后的条目前移一位
+    }
+    return true;
+}
 
-    return entries_.size() < initial_size;
+const IndexEntry* Index::find_entry(const std::filesystem::path& relative_file_path) const {
+    std::optional<PathTable::PathId> path_id_opt = paths_.find(relative_file_path.lexically_normal().generic_string());
+    if (!path_id_opt) return nullptr;
+    auto slot_it = slots_.find(*path_id_opt);
+    return slot_it == slots_.end() ? nullptr : &entries_[slot_it->second];
 }
 
 std::optional<IndexEntry> Index::get_entry(const std::filesystem::path& relative_file_path) const {
-    std::filesystem::path normalized_path = relative_file_path.lexically_normal();
-
-    auto it = std::lower_bound(entries_.begin(), entries_.end(), normalized_path,
-        [](const IndexEntry& entry, const std::filesystem::path& path_val) {
-            return entry.file_path < path_val;
-        });
-
-    if (it != entries_.end() && it->file_path == normalized_path) {
-        return *it;
+    const IndexEntry* entry = find_entry(relative_file_path);
+    if (entry) {
+        return *entry;
     }
     return std::nullopt;
 }
 
 const std::vector<IndexEntry>& Index::get_all_entries() const {
+    sort_entries_();
     return entries_;
 }
 
 void Index::clear_in_memory() {
     entries_.clear();
+    slots_.clear();
+    paths_.clear();
+    sorted_ = true;
+    loaded_ = true; // 视为已加载的空索引，避免随后的 add_or_update_entry 从磁盘重新加载旧条目
 }
 
 
@@ -0,0 +1,510 @@
+#include "../include/IoBackend.h"
+#include "../include/OrderedTaskPool.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ostream>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#define BIOGIT_HAVE_IO_URING 1
+#endif
+#endif
+
+namespace Biogit {
+
+namespace {
+
+constexpr size_t MAX_IO_CHUNK = size_t{1} << 30; ///< 单次 read / write 的最大长度 (io_uring 的长度字段只有 32 位)
+
+/// 把 stat 的修改时间换算成 std::filesystem::file_time_type (与 last_write_time 的结果一致)
+std::filesystem::file_time_type to_file_time(int64_t seconds, int64_t nanoseconds) {
+    const std::chrono::system_clock::time_point sys_time(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+        std::chrono::seconds(seconds) + std::chrono::nanoseconds(nanoseconds)));
+    return std::chrono::time_point_cast<std::filesystem::file_time_type::duration>(std::chrono::file_clock::from_sys(sys_time));
+}
+
+// --- 阻塞实现 (线程池后端直接使用；io_uring 后端出错时退回) ---
+
+std::optional<IoBackend::FileStat> stat_file_blocking(const std::filesystem::path& path) {
+    struct stat file_stat {};
+    if (::stat(path.c_str(), &file_stat) != 0) return std::nullopt;
+    return IoBackend::FileStat{S_ISREG(file_stat.st_mode), static_cast<uint64_t>(file_stat.st_size),
+                               to_file_time(file_stat.st_mtim.tv_sec, file_stat.st_mtim.tv_nsec)};
+}
+
+std::optional<std::vector<std::byte>> read_file_blocking(const std::filesystem::path& path) {
+    // O_NONBLOCK：路径恰好是 FIFO 时不阻塞在 open 上 (随后因不是常规文件而放弃)
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+    if (fd < 0) return std::nullopt;
+    std::optional<std::vector<std::byte>> content;
+    struct stat file_stat {};
+    if (::fstat(fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode)) {
+        std::vector<std::byte> buffer(static_cast<size_t>(file_stat.st_size));
+        size_t done = 0;
+        bool ok = true;
+        while (done < buffer.size()) {
+            const ssize_t n = ::read(fd, buffer.data() + done, std::min(buffer.size() - done, MAX_IO_CHUNK));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                ok = false;
+                break;
+            }
+            if (n == 0) break; // 文件在读取过程中变短
+            done += static_cast<size_t>(n);
+        }
+        if (ok) {
+            buffer.resize(done);
+            content = std::move(buffer);
+        }
+    }
+    ::close(fd);
+    return content;
+}
+
+bool write_file_blocking(const IoBackend::WriteRequest& request) {
+    const int fd = ::open(request.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0) return false;
+    size_t done = 0;
+    bool ok = true;
+    while (done < request.size) {
+        const ssize_t n = ::write(fd, request.data + done, std::min(request.size - done, MAX_IO_CHUNK));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ok = false;
+            break;
+        }
+        if (n == 0) {
+            ok = false;
+            break;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return ::close(fd) == 0 && ok;
+}
+
+/**
+ * @brief 线程池后端：在 OrderedTaskPool 的工作线程上执行阻塞系统调用，同时进行的操作数等于线程数。
+ */
+class ThreadPoolBackend final : public IoBackend {
+public:
+    explicit ThreadPoolBackend(size_t queue_depth) : pool_(queue_depth) {}
+
+    Kind kind() const override { return Kind::ThreadPool; }
+    const char* name() const override { return "threads"; }
+    size_t queue_depth() const override { return pool_.thread_count(); }
+
+    std::vector<std::optional<FileStat>> stat_files(const std::vector<std::filesystem::path>& paths) override {
+        std::vector<std::optional<FileStat>> results(paths.size());
+        for_each(paths.size(), [&](size_t i) { results[i] = stat_file_blocking(paths[i]); });
+        return results;
+    }
+
+    std::vector<std::optional<std::vector<std::byte>>> read_files(const std::vector<std::filesystem::path>& paths) override {
+        std::vector<std::optional<std::vector<std::byte>>> results(paths.size());
+        for_each(paths.size(), [&](size_t i) { results[i] = read_file_blocking(paths[i]); });
+        return results;
+    }
+
+    std::vector<bool> write_files(const std::vector<WriteRequest>& requests) override {
+        std::vector<char> results(requests.size(), 0); // vector<bool> 的元素不能被多个线程同时写入
+        for_each(requests.size(), [&](size_t i) { results[i] = write_file_blocking(requests[i]); });
+        return std::vector<bool>(results.begin(), results.end());
+    }
+
+private:
+    /// 把 count 个操作分成若干任务交给线程池 (每个线程约 8 个任务，既能均衡负载又摊薄调度开销)
+    template <typename Fn>
+    void for_each(size_t count, Fn fn) const {
+        if (count == 0) return;
+        const size_t per_task = std::max<size_t>(1, count / (pool_.thread_count() * 8));
+        std::vector<OrderedTaskPool::Task> tasks;
+        for (size_t begin = 0; begin < count; begin += per_task) {
+            const size_t end = std::min(begin + per_task, count);
+            tasks.push_back([&fn, begin, end](std::ostream&) {
+                for (size_t i = begin; i < end; ++i) fn(i);
+            });
+        }
+        std::ostream discard(nullptr); // 任务不产生输出
+        pool_.run(tasks, discard);
+    }
+
+    OrderedTaskPool pool_;
+};
+
+#ifdef BIOGIT_HAVE_IO_URING
+
+/**
+ * @brief 最小的 io_uring 封装：映射提交队列和完成队列，按队列深度分批提交请求并收取结果。
+ * @details 只在创建它的线程中使用；不使用 SQPOLL，每轮用一次 io_uring_enter 提交新请求并等待至少一个完成。
+ */
+class IoUringRing {
+public:
+    static std::unique_ptr<IoUringRing> create(unsigned entries) {
+        io_uring_params params {};
+        const long fd = ::syscall(__NR_io_uring_setup, entries, &params);
+        if (fd < 0) return nullptr;
+        std::unique_ptr<IoUringRing> ring(new IoUringRing());
+        ring->fd_ = static_cast<int>(fd);
+
+        ring->sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        ring->cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            ring->sq_ring_size_ = ring->cq_ring_size_ = std::max(ring->sq_ring_size_, ring->cq_ring_size_);
+        }
+        ring->sq_ring_ = map(ring->fd_, ring->sq_ring_size_, IORING_OFF_SQ_RING);
+        if (!ring->sq_ring_) return nullptr;
+        ring->cq_ring_ = single_mmap ? ring->sq_ring_ : map(ring->fd_, ring->cq_ring_size_, IORING_OFF_CQ_RING);
+        if (!ring->cq_ring_) return nullptr;
+        ring->sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        ring->sqes_ = static_cast<io_uring_sqe*>(map(ring->fd_, ring->sqes_size_, IORING_OFF_SQES));
+        if (!ring->sqes_) return nullptr;
+
+        auto* sq = static_cast<char*>(ring->sq_ring_);
+        ring->sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        ring->sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        ring->sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        ring->sq_entries_ = params.sq_entries;
+        auto* cq = static_cast<char*>(ring->cq_ring_);
+        ring->cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        ring->cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        ring->cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        ring->cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        if (!ring->supports_required_ops()) return nullptr;
+        return ring;
+    }
+
+    ~IoUringRing() {
+        if (sqes_) ::munmap(sqes_, sqes_size_);
+        if (cq_ring_ && cq_ring_ != sq_ring_) ::munmap(cq_ring_, cq_ring_size_);
+        if (sq_ring_) ::munmap(sq_ring_, sq_ring_size_);
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    IoUringRing(const IoUringRing&) = delete;
+    IoUringRing& operator=(const IoUringRing&) = delete;
+
+    unsigned entries() const { return sq_entries_; }
+
+    /**
+     * @brief 执行 count 个请求，同时在途的不超过环的大小：prep(i, sqe) 填写第 i 个请求，complete(i, res) 处理其结果。
+     * @return io_uring_enter 出现无法恢复的错误时返回 false (此时部分请求的结果可能已交给 complete)。
+     */
+    template <typename Prep, typename Complete>
+    bool run(size_t count, Prep&& prep, Complete&& complete) {
+        size_t next = 0;
+        size_t in_flight = 0;      // 已放入提交队列但尚未收到结果的请求数
+        unsigned unsubmitted = 0;  // 已放入提交队列但内核尚未取走的请求数
+        unsigned tail = *sq_tail_; // 只有本线程写 tail
+        while (next < count || in_flight > 0) {
+            while (next < count && in_flight < sq_entries_) {
+                const unsigned slot = tail & sq_mask_;
+                io_uring_sqe& sqe = sqes_[slot];
+                std::memset(&sqe, 0, sizeof(sqe));
+                prep(next, sqe);
+                sqe.user_data = next;
+                sq_array_[slot] = slot;
+                ++tail;
+                ++next;
+                ++in_flight;
+                ++unsubmitted;
+            }
+            __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+
+            const long submitted = ::syscall(__NR_io_uring_enter, fd_, unsubmitted, 1U, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (submitted >= 0) {
+                unsubmitted -= static_cast<unsigned>(submitted);
+            } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                return false;
+            }
+
+            unsigned head = *cq_head_; // 只有本线程写 head
+            const unsigned cq_tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+            for (; head != cq_tail; ++head) {
+                const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+                complete(static_cast<size_t>(cqe.user_data), cqe.res);
+                --in_flight;
+            }
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        }
+        return true;
+    }
+
+private:
+    IoUringRing() = default;
+
+    static void* map(int fd, size_t size, off_t offset) {
+        void* address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+        return address == MAP_FAILED ? nullptr : address;
+    }
+
+    /// 内核是否支持用到的全部操作 (statx / openat / read / write / close 自 5.6 起可用)
+    bool supports_required_ops() const {
+        constexpr unsigned PROBE_OPS = 256;
+        std::vector<std::byte> buffer(sizeof(io_uring_probe) + PROBE_OPS * sizeof(io_uring_probe_op)); // 内核要求清零
+        auto* probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+        if (::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PROBE, probe, PROBE_OPS) < 0) return false;
+        for (unsigned op : {IORING_OP_STATX, IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_WRITE, IORING_OP_CLOSE}) {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) return false;
+        }
+        return true;
+    }
+
+    int fd_ = -1;
+    void* sq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    void* cq_ring_ = nullptr;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+};
+
+void prep_statx(io_uring_sqe& sqe, const std::filesystem::path& path, struct statx* buffer) {
+    sqe.opcode = IORING_OP_STATX;
+    sqe.fd = AT_FDCWD;
+    sqe.addr = reinterpret_cast<uintptr_t>(path.c_str());
+    sqe.len = STATX_TYPE | STATX_SIZE | STATX_MTIME;
+    sqe.off = reinterpret_cast<uintptr_t>(buffer);
+}
+
+void prep_openat(io_uring_sqe& sqe, const std::filesystem::path& path, int flags, mode_t mode) {
+    sqe.opcode = IORING_OP_OPENAT;
+    sqe.fd = AT_FDCWD;
+    sqe.addr = reinterpret_cast<uintptr_t>(path.c_str());
+    sqe.len = mode;
+    sqe.open_flags = static_cast<uint32_t>(flags);
+}
+
+void prep_rw(io_uring_sqe& sqe, uint8_t opcode, int fd, const std::byte* buffer, size_t length, uint64_t offset) {
+    sqe.opcode = opcode;
+    sqe.fd = fd;
+    sqe.addr = reinterpret_cast<uintptr_t>(buffer);
+    sqe.len = static_cast<uint32_t>(std::min(length, MAX_IO_CHUNK));
+    sqe.off = offset;
+}
+
+void prep_close(io_uring_sqe& sqe, int fd) {
+    sqe.opcode = IORING_OP_CLOSE;
+    sqe.fd = fd;
+}
+
+IoBackend::FileStat from_statx(const struct statx& stx) {
+    return IoBackend::FileStat{S_ISREG(stx.stx_mode), stx.stx_size, to_file_time(stx.stx_mtime.tv_sec, stx.stx_mtime.tv_nsec)};
+}
+
+/**
+ * @brief io_uring 后端：stat 用一轮 statx；读取和写入分三轮 (openat [+ statx]、read / write、close)，每轮整批提交。
+ * @details 短读 / 短写在下一轮从中断处继续。io_uring_enter 出现无法恢复的错误时，该批操作改用阻塞实现重做。
+ */
+class IoUringBackend final : public IoBackend {
+public:
+    static std::unique_ptr<IoUringBackend> create(size_t queue_depth) {
+        if (queue_depth == 0) queue_depth = std::max<size_t>(32, std::thread::hardware_concurrency() * 4);
+        auto ring = IoUringRing::create(static_cast<unsigned>(std::min<size_t>(queue_depth, 4096)));
+        if (!ring) return nullptr;
+        return std::unique_ptr<IoUringBackend>(new IoUringBackend(std::move(ring)));
+    }
+
+    Kind kind() const override { return Kind::IoUring; }
+    const char* name() const override { return "io_uring"; }
+    size_t queue_depth() const override { return ring_->entries(); }
+
+    std::vector<std::optional<FileStat>> stat_files(const std::vector<std::filesystem::path>& paths) override {
+        std::vector<std::optional<FileStat>> results(paths.size());
+        std::vector<struct statx> buffers(paths.size());
+        const bool ok = ring_->run(paths.size(),
+            [&](size_t i, io_uring_sqe& sqe) { prep_statx(sqe, paths[i], &buffers[i]); },
+            [&](size_t i, int res) { if (res == 0) results[i] = from_statx(buffers[i]); });
+        if (!ok) {
+            for (size_t i = 0; i < paths.size(); ++i) results[i] = stat_file_blocking(paths[i]);
+        }
+        return results;
+    }
+
+    std::vector<std::optional<std::vector<std::byte>>> read_files(const std::vector<std::filesystem::path>& paths) override {
+        const size_t count = paths.size();
+        std::vector<std::optional<std::vector<std::byte>>> results(count);
+        std::vector<struct statx> stats(count);
+        std::vector<int> stat_results(count, -1);
+        std::vector<int> fds(count, -1);
+
+        // 1. 同时提交 statx (取大小和类型) 和 openat：请求 2i 为 statx，2i+1 为 openat
+        bool ok = ring_->run(count * 2,
+            [&](size_t op, io_uring_sqe& sqe) {
+                if (op % 2 == 0) prep_statx(sqe, paths[op / 2], &stats[op / 2]);
+                else prep_openat(sqe, paths[op / 2], O_RDONLY | O_CLOEXEC | O_NONBLOCK, 0);
+            },
+            [&](size_t op, int res) {
+                if (op % 2 == 0) stat_results[op / 2] = res;
+                else fds[op / 2] = res;
+            });
+
+        // 2. 读取常规文件的内容
+        std::vector<std::vector<std::byte>> buffers(count);
+        std::vector<size_t> done(count, 0);
+        std::vector<char> failed(count, 1);
+        std::vector<size_t> pending;
+        for (size_t i = 0; ok && i < count; ++i) {
+            if (fds[i] < 0 || stat_results[i] != 0 || !S_ISREG(stats[i].stx_mode)) continue;
+            failed[i] = 0;
+            buffers[i].resize(static_cast<size_t>(stats[i].stx_size));
+            if (!buffers[i].empty()) pending.push_back(i);
+        }
+        while (ok && !pending.empty()) {
+            std::vector<size_t> unfinished;
+            ok = ring_->run(pending.size(),
+                [&](size_t k, io_uring_sqe& sqe) {
+                    const size_t i = pending[k];
+                    prep_rw(sqe, IORING_OP_READ, fds[i], buffers[i].data() + done[i], buffers[i].size() - done[i], done[i]);
+                },
+                [&](size_t k, int res) {
+                    const size_t i = pending[k];
+                    if (res == -EINTR || res == -EAGAIN) {
+                        unfinished.push_back(i);
+                    } else if (res < 0) {
+                        failed[i] = 1;
+                    } else if (res == 0) {
+                        buffers[i].resize(done[i]); // 文件在读取过程中变短
+                    } else {
+                        done[i] += static_cast<size_t>(res);
+                        if (done[i] < buffers[i].size()) unfinished.push_back(i);
+                    }
+                });
+            pending = std::move(unfinished);
+        }
+
+        // 3. 关闭文件
+        close_all(fds);
+        if (!ok) {
+            for (size_t i = 0; i < count; ++i) results[i] = read_file_blocking(paths[i]);
+            return results;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (!failed[i]) results[i] = std::move(buffers[i]);
+        }
+        return results;
+    }
+
+    std::vector<bool> write_files(const std::vector<WriteRequest>& requests) override {
+        const size_t count = requests.size();
+        std::vector<int> fds(count, -1);
+
+        // 1. 打开 (创建或截断) 全部文件
+        bool ok = ring_->run(count,
+            [&](size_t i, io_uring_sqe& sqe) {
+                prep_openat(sqe, requests[i].path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+            },
+            [&](size_t i, int res) { fds[i] = res; });
+
+        // 2. 写入内容
+        std::vector<size_t> done(count, 0);
+        std::vector<char> succeeded(count, 0);
+        std::vector<size_t> pending;
+        for (size_t i = 0; ok && i < count; ++i) {
+            if (fds[i] < 0) continue;
+            succeeded[i] = 1;
+            if (requests[i].size > 0) pending.push_back(i);
+        }
+        while (ok && !pending.empty()) {
+            std::vector<size_t> unfinished;
+            ok = ring_->run(pending.size(),
+                [&](size_t k, io_uring_sqe& sqe) {
+                    const size_t i = pending[k];
+                    prep_rw(sqe, IORING_OP_WRITE, fds[i], requests[i].data + done[i], requests[i].size - done[i], done[i]);
+                },
+                [&](size_t k, int res) {
+                    const size_t i = pending[k];
+                    if (res == -EINTR || res == -EAGAIN) {
+                        unfinished.push_back(i);
+                    } else if (res <= 0) {
+                        succeeded[i] = 0;
+                    } else {
+                        done[i] += static_cast<size_t>(res);
+                        if (done[i] < requests[i].size) unfinished.push_back(i);
+                    }
+                });
+            pending = std::move(unfinished);
+        }
+
+        // 3. 关闭文件：close 失败 (例如延迟报告的写入错误) 也算写入失败
+        std::vector<int> close_results = close_all(fds);
+        if (!ok) {
+            std::vector<bool> results(count);
+            for (size_t i = 0; i < count; ++i) results[i] = write_file_blocking(requests[i]);
+            return results;
+        }
+        std::vector<bool> results(count);
+        for (size_t i = 0; i < count; ++i) results[i] = succeeded[i] && close_results[i] == 0;
+        return results;
+    }
+
+private:
+    explicit IoUringBackend(std::unique_ptr<IoUringRing> ring) : ring_(std::move(ring)) {}
+
+    /// 关闭全部已打开的文件，返回每个文件的 close 结果 (未打开或结果未知的为 -EBADF)
+    std::vector<int> close_all(const std::vector<int>& fds) {
+        std::vector<size_t> open_indices;
+        for (size_t i = 0; i < fds.size(); ++i) {
+            if (fds[i] >= 0) open_indices.push_back(i);
+        }
+        std::vector<int> results(fds.size(), -EBADF);
+        // 提交出错时不再重试：已提交的 close 可能已经生效，再次关闭可能关掉别处新打开的同号文件
+        ring_->run(open_indices.size(),
+            [&](size_t k, io_uring_sqe& sqe) { prep_close(sqe, fds[open_indices[k]]); },
+            [&](size_t k, int res) { results[open_indices[k]] = res; });
+        return results;
+    }
+
+    std::unique_ptr<IoUringRing> ring_;
+};
+
+#endif
+
+}
+
+std::unique_ptr<IoBackend> IoBackend::create(Kind kind, size_t queue_depth) {
+#ifdef BIOGIT_HAVE_IO_URING
+    if (kind != Kind::ThreadPool) {
+        if (auto backend = IoUringBackend::create(queue_depth)) return backend;
+    }
+#endif
+    return std::make_unique<ThreadPoolBackend>(queue_depth);
+}
+
+std::optional<IoBackend::Kind> IoBackend::parse_kind(const std::string& value) {
+    if (value == "auto") return Kind::Auto;
+    if (value == "threads") return Kind::ThreadPool;
+    if (value == "io_uring") return Kind::IoUring;
+    return std::nullopt;
+}
+
+bool IoBackend::io_uring_available() {
+#ifdef BIOGIT_HAVE_IO_URING
+    static const bool available = IoUringRing::create(1) != nullptr;
+    return available;
+#else
+    return false;
+#endif
+}
+
+}
@@ -0,0 +1,214 @@
+#include "../include/LfsStore.h"
+#include "../include/sha1.h"
+#include "../include/utils.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace Biogit {
+
+const std::string LfsPointer::VERSION_LINE = "version biogit-lfs/1";
+const std::string LfsStore::DIR_NAME = "lfs";
+
+namespace {
+
+bool is_valid_oid(const std::string& oid) {
+    return oid.length() == 40 && std::all_of(oid.begin(), oid.end(), ::isxdigit);
+}
+
+/**
+ * @brief 流式计算文件内容的 SHA-1，同时可选地把内容复制到 copy_to。
+ */
+std::optional<std::pair<std::string, uintmax_t>> hash_file(const std::filesystem::path& file_path, std::ofstream* copy_to) {
+    std::ifstream ifs(file_path, std::ios::binary);
+    if (!ifs.is_open()) {
+        std::cerr << "错误: 无法打开文件 '" << file_path.string() << "'。" << std::endl;
+        return std::nullopt;
+    }
+    SHA1::Hasher hasher;
+    std::vector<char> buffer(LfsStore::BLOCK_SIZE);
+    uintmax_t total = 0;
+    while (ifs) {
+        ifs.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        std::streamsize got = ifs.gcount();
+        if (got <= 0) break;
+        hasher.update(buffer.data(), static_cast<size_t>(got));
+        if (copy_to) copy_to->write(buffer.data(), got);
+        total += static_cast<uintmax_t>(got);
+    }
+    if (ifs.bad() || (copy_to && !copy_to->good())) {
+        std::cerr << "错误: 读取或复制文件 '" << file_path.string() << "' 失败。" << std::endl;
+        return std::nullopt;
+    }
+    return std::make_pair(hasher.hex_digest(), total);
+}
+
+}
+
+std::string LfsPointer::serialize() const {
+    std::ostringstream oss;
+    oss << VERSION_LINE << "\n"
+        << "oid sha1:" << oid << "\n"
+        << "size " << size << "\n";
+    return oss.str();
+}
+
+std::optional<LfsPointer> LfsPointer::parse(const std::string& content) {
+    if (content.size() > MAX_POINTER_SIZE || !content.starts_with(VERSION_LINE + "\n")) {
+        return std::nullopt;
+    }
+    std::istringstream iss(content.substr(VERSION_LINE.length() + 1));
+    std::string oid_key, oid_value, size_key;
+    LfsPointer pointer;
+    if (!(iss >> oid_key >> oid_value >> size_key >> pointer.size) ||
+        oid_key != "oid" || !oid_value.starts_with("sha1:") || size_key != "size") {
+        return std::nullopt;
+    }
+    pointer.oid = oid_value.substr(5);
+    if (!is_valid_oid(pointer.oid)) {
+        return std::nullopt;
+    }
+    return pointer;
+}
+
+LfsStore::LfsStore(std::filesystem::path biogit_dir) : lfs_dir_(std::move(biogit_dir) / DIR_NAME) {
+}
+
+std::filesystem::path LfsStore::object_path(const std::string& oid) const {
+    return lfs_dir_ / "objects" / oid.substr(0, 2) / oid.substr(2, 2) / oid;
+}
+
+bool LfsStore::contains(const std::string& oid) const {
+    std::error_code ec;
+    return is_valid_oid(oid) && std::filesystem::is_regular_file(object_path(oid), ec);
+}
+
+std::optional<LfsPointer> LfsStore::pointer_for_file(const std::filesystem::path& file_path) {
+    auto hashed = hash_file(file_path, nullptr);
+    if (!hashed) return std::nullopt;
+    return LfsPointer{hashed->first, hashed->second};
+}
+
+std::optional<LfsPointer> LfsStore::store_file(const std::filesystem::path& file_path) const {
+    // 1. 复制到临时文件的同时计算哈希，避免读取两遍
+    std::error_code ec;
+    std::filesystem::path incoming_dir = lfs_dir_ / "incoming";
+    std::filesystem::create_directories(incoming_dir, ec);
+    std::filesystem::path temp_path = Utils::unique_temp_path(incoming_dir / (file_path.filename().string() + ".add"));
+
+    std::optional<std::pair<std::string, uintmax_t>> hashed;
+    {
+        std::ofstream ofs(temp_path, std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open()) {
+            std::cerr << "错误: 无法创建临时文件 '" << temp_path.string() << "'。" << std::endl;
+            return std::nullopt;
+        }
+        hashed = hash_file(file_path, &ofs);
+    }
+    if (!hashed) {
+        std::filesystem::remove(temp_path, ec);
+        return std::nullopt;
+    }
+    LfsPointer pointer{hashed->first, hashed->second};
+
+    // 2. 移入内容库 (已存在时丢弃临时文件)
+    if (contains(pointer.oid)) {
+        std::filesystem::remove(temp_path, ec);
+        return pointer;
+    }
+    std::filesystem::path final_path = object_path(pointer.oid);
+    std::filesystem::create_directories(final_path.parent_path(), ec);
+    std::filesystem::rename(temp_path, final_path, ec);
+    if (ec) {
+        std::cerr << "错误: 无法将大文件内容移入 '" << final_path.string() << "': " << ec.message() << std::endl;
+        std::filesystem::remove(temp_path, ec);
+        return std::nullopt;
+    }
+    return pointer;
+}
+
+bool LfsStore::materialize(const LfsPointer& pointer, const std::filesystem::path& destination, bool use_hardlink) const {
+    if (!contains(pointer.oid)) {
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::remove(destination, ec);
+    if (use_hardlink) {
+        std::filesystem::create_hard_link(object_path(pointer.oid), destination, ec);
+        if (!ec) return true;
+    }
+    ec.clear();
+    std::filesystem::copy_file(object_path(pointer.oid), destination, std::filesystem::copy_options::overwrite_existing, ec);
+    if (ec) {
+        std::cerr << "错误: 无法写出大文件 '" << destination.string() << "': " << ec.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::optional<std::vector<char>> LfsStore::read_block(const std::string& oid, uintmax_t offset, size_t max_length) const {
+    if (!contains(oid)) {
+        return std::nullopt;
+    }
+    std::ifstream ifs(object_path(oid), std::ios::binary);
+    if (!ifs.is_open()) {
+        return std::nullopt;
+    }
+    ifs.seekg(static_cast<std::streamoff>(offset));
+    std::vector<char> block(std::min(max_length, BLOCK_SIZE));
+    ifs.read(block.data(), static_cast<std::streamsize>(block.size()));
+    block.resize(static_cast<size_t>(std::max<std::streamsize>(ifs.gcount(), 0)));
+    return block;
+}
+
+bool LfsStore::receive_block(const std::string& oid, uintmax_t offset, uintmax_t total_size, const char* data, size_t length) const {
+    if (!is_valid_oid(oid) || offset + length > total_size) {
+        return false;
+    }
+    if (contains(oid)) {
+        return true; // 已有完整内容 (例如另一次传输已完成)
+    }
+
+    // 1. 追加到未完成的文件；偏移必须与已接收的字节数一致
+    std::error_code ec;
+    std::filesystem::path incoming_dir = lfs_dir_ / "incoming";
+    std::filesystem::create_directories(incoming_dir, ec);
+    std::filesystem::path part_path = incoming_dir / (oid + ".part");
+    uintmax_t received = std::filesystem::exists(part_path, ec) ? std::filesystem::file_size(part_path, ec) : 0;
+    if (offset != 0 && offset != received) {
+        std::cerr << "错误: 大文件 " << oid.substr(0, 7) << " 的数据块不连续 (偏移 " << offset
+                  << "，已接收 " << received << ")。" << std::endl;
+        return false;
+    }
+    {
+        std::ofstream ofs(part_path, std::ios::binary | (offset == 0 ? std::ios::trunc : std::ios::app));
+        ofs.write(data, static_cast<std::streamsize>(length));
+        if (!ofs.good()) {
+            std::cerr << "错误: 写入 '" << part_path.string() << "' 失败。" << std::endl;
+            return false;
+        }
+    }
+    if (offset + length < total_size) {
+        return true;
+    }
+
+    // 2. 收齐后校验哈希，再移入内容库
+    auto hashed = hash_file(part_path, nullptr);
+    if (!hashed || hashed->first != oid || hashed->second != total_size) {
+        std::cerr << "错误: 大文件 " << oid.substr(0, 7) << " 接收完成后哈希校验失败。" << std::endl;
+        std::filesystem::remove(part_path, ec);
+        return false;
+    }
+    std::filesystem::path final_path = object_path(oid);
+    std::filesystem::create_directories(final_path.parent_path(), ec);
+    std::filesystem::rename(part_path, final_path, ec);
+    if (ec) {
+        std::cerr << "错误: 无法将大文件内容移入 '" << final_path.string() << "': " << ec.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,387 @@
+#include "../include/LocalDaemon.h"
+#include "../include/Repository.h"
+#include "../include/object.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <iostream>
+#include <streambuf>
+
+#include <boost/asio.hpp>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Biogit {
+
+const std::string LocalDaemon::SOCKET_FILE_NAME = "daemon.sock";
+
+namespace {
+
+using boost::asio::local::stream_protocol;
+
+constexpr int LIVENESS_CHECK_INTERVAL_MS = 60 * 1000; ///< 空闲时检查套接字文件是否还在的间隔
+constexpr int CLIENT_TIMEOUT_MS = 30 * 1000;          ///< 客户端这么久不发送请求 (或不接收输出) 时断开它
+constexpr uint32_t MAX_REQUEST_STRINGS = 64 * 1024;
+constexpr uint32_t MAX_STRING_LENGTH = 1 << 20;
+constexpr char FRAME_OUTPUT = 'o';
+constexpr char FRAME_EXIT = 'x';
+
+// --- 帧读写 (出错时抛出 boost::system::system_error) ---
+// 常驻进程一侧的连接设为非阻塞：asio 的同步读写在阻塞套接字上会无限期等待 (SO_RCVTIMEO 对它无效)，
+// 这里改为 poll 等待并设置超时，一个不说话的客户端不会让常驻进程停在它身上。客户端一侧的套接字是阻塞的，不会等待。
+
+void wait_ready(stream_protocol::socket& socket, short events) {
+    pollfd fd{socket.native_handle(), events, 0};
+    int ready = 0;
+    do {
+        ready = ::poll(&fd, 1, CLIENT_TIMEOUT_MS);
+    } while (ready < 0 && errno == EINTR);
+    if (ready == 0) throw boost::system::system_error(boost::asio::error::timed_out);
+    if (ready < 0) throw boost::system::system_error(boost::system::error_code(errno, boost::system::system_category()));
+}
+
+void read_exact(stream_protocol::socket& socket, void* data, size_t length) {
+    char* p = static_cast<char*>(data);
+    while (length > 0) {
+        boost::system::error_code ec;
+        const size_t n = socket.read_some(boost::asio::buffer(p, length), ec);
+        if (ec == boost::asio::error::would_block) {
+            wait_ready(socket, POLLIN);
+            continue;
+        }
+        if (ec) throw boost::system::system_error(ec);
+        p += n;
+        length -= n;
+    }
+}
+
+void write_exact(stream_protocol::socket& socket, const void* data, size_t length) {
+    const char* p = static_cast<const char*>(data);
+    while (length > 0) {
+        boost::system::error_code ec;
+        const size_t n = socket.write_some(boost::asio::buffer(p, length), ec);
+        if (ec == boost::asio::error::would_block) {
+            wait_ready(socket, POLLOUT);
+            continue;
+        }
+        if (ec) throw boost::system::system_error(ec);
+        p += n;
+        length -= n;
+    }
+}
+
+void write_u32(stream_protocol::socket& socket, uint32_t value) {
+    write_exact(socket, &value, sizeof(value));
+}
+
+uint32_t read_u32(stream_protocol::socket& socket) {
+    uint32_t value = 0;
+    read_exact(socket, &value, sizeof(value));
+    return value;
+}
+
+void write_strings(stream_protocol::socket& socket, const std::vector<std::string>& strings) {
+    write_u32(socket, static_cast<uint32_t>(strings.size()));
+    for (const auto& s : strings) {
+        write_u32(socket, static_cast<uint32_t>(s.size()));
+        write_exact(socket, s.data(), s.size());
+    }
+}
+
+bool read_strings(stream_protocol::socket& socket, std::vector<std::string>& out_strings) {
+    const uint32_t count = read_u32(socket);
+    if (count > MAX_REQUEST_STRINGS) return false;
+    out_strings.resize(count);
+    for (auto& s : out_strings) {
+        const uint32_t length = read_u32(socket);
+        if (length > MAX_STRING_LENGTH) return false;
+        s.resize(length);
+        if (length > 0) read_exact(socket, s.data(), length);
+    }
+    return true;
+}
+
+void write_exit_frame(stream_protocol::socket& socket, int32_t exit_code) {
+    try {
+        write_exact(socket, &FRAME_EXIT, 1);
+        write_exact(socket, &exit_code, sizeof(exit_code));
+    } catch (const boost::system::system_error&) { // 客户端已断开或不再接收时无人接收，忽略
+    }
+}
+
+bool connect(stream_protocol::socket& socket, const std::filesystem::path& socket_path) {
+    std::error_code fs_ec;
+    if (!std::filesystem::exists(socket_path, fs_ec)) return false; // 没有启动常驻进程 (绝大多数情况)
+    boost::system::error_code ec;
+    try {
+        socket.connect(stream_protocol::endpoint(socket_path.string()), ec);
+    } catch (const boost::system::system_error&) { // 路径超过 sockaddr_un 的长度限制
+        return false;
+    }
+    return !ec;
+}
+
+
+/**
+ * @brief 把写入的字节作为 'o' 帧发给客户端的 streambuf；客户端断开 (例如输出接到了 head) 或超时不接收后丢弃其余输出。
+ */
+class SocketOutputBuf : public std::streambuf {
+public:
+    explicit SocketOutputBuf(stream_protocol::socket& socket) : socket_(socket), buffer_(64 * 1024) {
+        setp(buffer_.data(), buffer_.data() + buffer_.size());
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        send_buffer();
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override {
+        send_buffer();
+        return 0;
+    }
+
+private:
+    void send_buffer() {
+        const uint32_t length = static_cast<uint32_t>(pptr() - pbase());
+        if (length > 0 && !disconnected_) {
+            try {
+                write_exact(socket_, &FRAME_OUTPUT, 1);
+                write_u32(socket_, length);
+                write_exact(socket_, pbase(), length);
+            } catch (const boost::system::system_error&) {
+                disconnected_ = true;
+            }
+        }
+        setp(buffer_.data(), buffer_.data() + buffer_.size());
+    }
+
+    stream_protocol::socket& socket_;
+    std::vector<char> buffer_;
+    bool disconnected_ = false;
+};
+
+
+/**
+ * @brief 处理一个连接上的请求。
+ * @return 收到退出请求时返回 false。
+ */
+bool serve_request(stream_protocol::socket& socket, const std::filesystem::path& work_tree_root,
+                   const std::filesystem::path& socket_path, const LocalDaemon::CommandHandler& handler) {
+    // 1. 读取请求：客户端工作目录、命令、参数
+    std::vector<std::string> request;
+    try {
+        if (!read_strings(socket, request) || request.size() < 2) return true;
+    } catch (const boost::system::system_error&) {
+        return true;
+    }
+    const std::string& command = request[1];
+    const std::vector<std::string> args(request.begin() + 2, request.end());
+
+    // 2. 常驻进程自身的控制命令
+    if (command == "daemon") {
+        const bool stop_requested = args.size() == 1 && args[0] == "stop";
+        if (stop_requested) {
+            std::error_code ec;
+            std::filesystem::remove(socket_path, ec); // 回复之前删除，stop 返回后即可重新 start
+        }
+        write_exit_frame(socket, 0);
+        return !stop_requested;
+    }
+
+    // 3. 在客户端的工作目录中执行命令，标准输出和标准错误都转发给客户端
+    std::error_code ec;
+    std::filesystem::current_path(request[0], ec);
+    SocketOutputBuf output(socket);
+    std::streambuf* saved_out = std::cout.rdbuf(&output);
+    std::streambuf* saved_err = std::cerr.rdbuf(&output);
+    int exit_code = 1;
+    try {
+        // 每次重新加载：Repository 本身不缓存 HEAD、引用或配置，可复用的状态都在进程内缓存中
+        std::optional<Repository> repo_opt = Repository::load(work_tree_root);
+        if (repo_opt) exit_code = handler(*repo_opt, command, args);
+    } catch (const std::exception& e) {
+        std::cerr << "错误: " << e.what() << std::endl;
+    }
+    std::cout.flush();
+    std::cout.rdbuf(saved_out);
+    std::cerr.rdbuf(saved_err);
+    std::cout.clear();
+    std::cerr.clear();
+    std::filesystem::current_path(work_tree_root, ec);
+
+    write_exit_frame(socket, exit_code);
+    return true;
+}
+
+/**
+ * @brief 常驻进程主循环：逐个处理连接，直到收到退出请求或套接字文件被删除。
+ */
+void serve(boost::asio::io_context& io_context, stream_protocol::acceptor& acceptor,
+           const std::filesystem::path& work_tree_root, const std::filesystem::path& socket_path,
+           const LocalDaemon::CommandHandler& handler) {
+    while (true) {
+        pollfd listener{acceptor.native_handle(), POLLIN, 0};
+        int ready = ::poll(&listener, 1, LIVENESS_CHECK_INTERVAL_MS);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        if (ready == 0) {
+            std::error_code ec;
+            if (!std::filesystem::exists(socket_path, ec)) return; // 仓库或套接字文件已被删除
+            continue;
+        }
+
+        stream_protocol::socket socket(io_context);
+        boost::system::error_code ec;
+        acceptor.accept(socket, ec);
+        if (ec) continue;
+        socket.non_blocking(true, ec);
+        if (ec) continue;
+        if (!serve_request(socket, work_tree_root, socket_path, handler)) return;
+    }
+}
+
+}
+
+
+bool LocalDaemon::start(const Repository& repo, CommandHandler handler) {
+    const std::filesystem::path socket_path = repo.get_mygit_directory() / SOCKET_FILE_NAME;
+    if (is_running(repo.get_mygit_directory())) {
+        std::cout << "常驻进程已在运行 (" << socket_path.string() << ")。" << std::endl;
+        return true;
+    }
+
+    // 1. 绑定套接字 (删除上次异常退出留下的套接字文件)，成功后才 fork，保证返回时已可连接
+    std::error_code fs_ec;
+    std::filesystem::remove(socket_path, fs_ec);
+    //    bind 创建套接字文件时就只有属主可连接：先收紧 umask，而不是 bind 之后再 chmod (两者之间其他用户可以连接)
+    boost::asio::io_context io_context;
+    stream_protocol::acceptor acceptor(io_context);
+    const mode_t saved_umask = ::umask(S_IRWXG | S_IRWXO);
+    try {
+        stream_protocol::endpoint endpoint(socket_path.string());
+        acceptor.open(endpoint.protocol());
+        acceptor.bind(endpoint);
+        acceptor.listen();
+    } catch (const boost::system::system_error& e) {
+        ::umask(saved_umask);
+        std::cerr << "错误: 无法在 '" << socket_path.string() << "' 上监听: " << e.what() << std::endl;
+        return false;
+    }
+    ::umask(saved_umask);
+
+    // 2. fork 出常驻进程
+    std::cout.flush();
+    io_context.notify_fork(boost::asio::io_context::fork_prepare);
+    const pid_t pid = ::fork();
+    if (pid < 0) {
+        io_context.notify_fork(boost::asio::io_context::fork_parent);
+        std::cerr << "错误: 无法创建常驻进程。" << std::endl;
+        std::filesystem::remove(socket_path, fs_ec);
+        return false;
+    }
+    if (pid > 0) {
+        io_context.notify_fork(boost::asio::io_context::fork_parent);
+        std::cout << "常驻进程已启动 (pid " << pid << ")，监听 " << socket_path.string() << std::endl;
+        return true;
+    }
+
+    // 3. 子进程：脱离终端，服务到收到退出请求为止
+    io_context.notify_fork(boost::asio::io_context::fork_child);
+    ::setsid();
+    std::signal(SIGPIPE, SIG_IGN); // 客户端提前断开时写入失败而不是被信号终止
+    const int null_fd = ::open("/dev/null", O_RDWR);
+    if (null_fd >= 0) {
+        ::dup2(null_fd, STDIN_FILENO);
+        ::dup2(null_fd, STDOUT_FILENO);
+        ::dup2(null_fd, STDERR_FILENO);
+        if (null_fd > STDERR_FILENO) ::close(null_fd);
+    }
+    std::filesystem::current_path(repo.get_work_tree_root(), fs_ec);
+    Repository::set_ref_cache_capacity(REF_CACHE_ENTRIES);
+    ObjectCache::set_capacity(OBJECT_CACHE_BYTES);
+    serve(io_context, acceptor, repo.get_work_tree_root(), socket_path, handler);
+    acceptor.close();
+    std::exit(0);
+}
+
+
+bool LocalDaemon::stop(const std::filesystem::path& mygit_dir) {
+    boost::asio::io_context io_context;
+    stream_protocol::socket socket(io_context);
+    if (!connect(socket, mygit_dir / SOCKET_FILE_NAME)) return false;
+    try {
+        write_strings(socket, {"", "daemon", "stop"});
+        char tag = 0;
+        boost::asio::read(socket, boost::asio::buffer(&tag, 1));
+        return tag == FRAME_EXIT;
+    } catch (const boost::system::system_error&) {
+        return false;
+    }
+}
+
+
+bool LocalDaemon::is_running(const std::filesystem::path& mygit_dir) {
+    boost::asio::io_context io_context;
+    stream_protocol::socket socket(io_context);
+    return connect(socket, mygit_dir / SOCKET_FILE_NAME);
+}
+
+
+std::optional<int> LocalDaemon::forward(const std::filesystem::path& mygit_dir, const std::string& command,
+                                        const std::vector<std::string>& args) {
+    boost::asio::io_context io_context;
+    stream_protocol::socket socket(io_context);
+    if (!connect(socket, mygit_dir / SOCKET_FILE_NAME)) return std::nullopt;
+
+    // 1. 发送请求
+    std::error_code fs_ec;
+    std::vector<std::string> request{std::filesystem::current_path(fs_ec).string(), command};
+    request.insert(request.end(), args.begin(), args.end());
+    try {
+        write_strings(socket, request);
+    } catch (const boost::system::system_error&) {
+        return std::nullopt;
+    }
+
+    // 2. 接收输出直到退出码
+    bool received_output = false;
+    std::vector<char> data;
+    try {
+        while (true) {
+            char tag = 0;
+            boost::asio::read(socket, boost::asio::buffer(&tag, 1));
+            if (tag == FRAME_EXIT) {
+                int32_t exit_code = 0;
+                boost::asio::read(socket, boost::asio::buffer(&exit_code, sizeof(exit_code)));
+                std::cout.flush();
+                return exit_code;
+            }
+            if (tag != FRAME_OUTPUT) break;
+            const uint32_t length = read_u32(socket);
+            data.resize(length);
+            boost::asio::read(socket, boost::asio::buffer(data.data(), length));
+            std::cout.write(data.data(), length);
+            received_output = true;
+        }
+    } catch (const boost::system::system_error&) {
+    }
+
+    // 命令都是只读的：还没有输出时可以安全地改在本进程执行
+    if (!received_output) return std::nullopt;
+    std::cout.flush();
+    std::cerr << "错误: 与常驻进程的连接意外中断。" << std::endl;
+    return 1;
+}
+
+}
@@ -5,6 +5,10 @@
 #include"protocol.h"
 #include "Repository.h"
 #include "UserManager.h"
+#include "object.h"
+#include "LfsStore.h"
+#include "ZlibDictionary.h"
+#include "BinaryDelta.h"
 
 
 namespace Biogit {
@@ -123,6 +127,13 @@ void LogicSystem::RegisterCallBacks() {
     _fun_callbacks[Protocol::MSG_REQ_CHECK_OBJECTS] = std::bind(&LogicSystem::HandleReqCheckObjects, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
     _fun_callbacks[Protocol::MSG_REQ_PUT_OBJECT] = std::bind(&LogicSystem::HandleReqPutObject, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
     _fun_callbacks[Protocol::MSG_REQ_UPDATE_REF] = std::bind(&LogicSystem::HandleReqUpdateRef, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
+    _fun_callbacks[Protocol::MSG_REQ_LFS_CHECK] = std::bind(&LogicSystem::HandleReqLfsCheck, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
+    _fun_callbacks[Protocol::MSG_REQ_LFS_PUT_BLOCK] = std::bind(&LogicSystem::HandleReqLfsPutBlock, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
+    _fun_callbacks[Protocol::MSG_REQ_LFS_GET_BLOCK] = std::bind(&LogicSystem::HandleReqLfsGetBlock, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
+    _fun_callbacks[Protocol::MSG_REQ_DICT_NEGOTIATE] = std::bind(&LogicSystem::HandleReqDictNegotiate, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
+    _fun_callbacks[Protocol::MSG_REQ_DICT_GET] = std::bind(&LogicSystem::HandleReqDictGet, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
+    _fun_callbacks[Protocol::MSG_REQ_PUT_OBJECT_DEFLATED] = std::bind(&LogicSystem::HandleReqPutObjectDeflated, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
+    _fun_callbacks[Protocol::MSG_REQ_PUT_OBJECT_DELTA] = std::bind(&LogicSystem::HandleReqPutObjectDelta, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
     _fun_callbacks[Protocol::MSG_REQ_REGISTER_USER] = std::bind(&LogicSystem::HandleReqRegisterUser, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
     _fun_callbacks[Protocol::MSG_REQ_LOGIN_USER] = std::bind(&LogicSystem::HandleReqLoginUser, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
 
@@ -427,11 +438,12 @@ void LogicSystem::HandleReqGetObject(std::shared_ptr<Csession> session, uint16_t
         return;
     }
 
-    // 2. 校验原始载荷的格式 (应该是40字节的哈希)
-    if (original_body_len != 40 || original_body_ptr == nullptr) {
+    // 2. 校验原始载荷的格式 (40字节的哈希，可附带4字节的字典编号)
+    if ((original_body_len != 40 && original_body_len != 44) || original_body_ptr == nullptr) {
         session->Send("Invalid request payload for GET_OBJECT (expected 40-byte hash).", Protocol::MSG_RESP_ERROR); return;
     }
-    std::string object_hash(original_body_ptr, original_body_len);
+    std::string object_hash(original_body_ptr, 40);
+    uint32_t dictionary_id = original_body_len == 44 ? Protocol::unpack_u32(original_body_ptr + 40) : 0;
 
     // 3. 检查仓库是否选定
     if (!session->IsRepositorySelected()) { session->Send("No repository selected for GET_OBJECT.", Protocol::MSG_RESP_ERROR); return; }
@@ -441,7 +453,24 @@ void LogicSystem::HandleReqGetObject(std::shared_ptr<Csession> session, uint16_t
     // 4. 获取对象内容
     std::optional<std::vector<char>> raw_content_opt = active_repo->get_raw_object_content(object_hash); //
 
-    // 5. 发送响应
+    // 5. 发送响应 (客户端给出字典且本仓库也有时，小型 Tree/Commit 压缩后发送)
+    if (raw_content_opt && !raw_content_opt->empty() && dictionary_id != 0 &&
+        ZlibDictionaries::applies_to_object(raw_content_opt->data(), raw_content_opt->size())) {
+        auto dictionary = ZlibDictionaries::load(active_repo->get_objects_directory(), dictionary_id);
+        auto deflated = dictionary ? ZlibDictionaries::deflate(dictionary.get(), reinterpret_cast<const std::byte*>(raw_content_opt->data()),
+                                                               raw_content_opt->size())
+                                   : std::nullopt;
+        if (deflated && deflated->size() + 8 < raw_content_opt->size()) {
+            std::vector<char> response_payload_go(40 + 8);
+            std::memcpy(response_payload_go.data(), object_hash.data(), 40);
+            Protocol::pack_u32(response_payload_go.data() + 40, dictionary_id);
+            Protocol::pack_u32(response_payload_go.data() + 44, static_cast<uint32_t>(raw_content_opt->size()));
+            const char* deflated_data = reinterpret_cast<const char*>(deflated->data());
+            response_payload_go.insert(response_payload_go.end(), deflated_data, deflated_data + deflated->size());
+            session->Send(response_payload_go, Protocol::MSG_RESP_OBJECT_CONTENT_DEFLATED);
+            return;
+        }
+    }
     if (raw_content_opt && !raw_content_opt->empty()) {
         std::vector<char> response_payload_go;
         response_payload_go.reserve(40 + raw_content_opt->size());
@@ -557,25 +586,47 @@ void LogicSystem::HandleReqPutObject(std::shared_ptr<Csession> session, uint16_t
     const char* actual_object_raw_data = original_body_ptr + 40;
     uint32_t actual_object_data_len = original_body_len - 40;
 
-    // 3a. 基本的哈希格式校验
+    StoreUploadedObject(session, active_repo, object_hash_from_client, actual_object_raw_data, actual_object_data_len);
+}
+
+
+/**
+ * @brief 校验客户端上传的对象并写入仓库，发送 MSG_RESP_ACK_OK 或 MSG_RESP_ERROR。
+ * @details 哈希不匹配时，若对象是分块清单，则用已上传的 chunk 重组后按 Blob 哈希校验。
+ */
+void LogicSystem::StoreUploadedObject(std::shared_ptr<Csession> session, std::shared_ptr<Repository> active_repo,
+                                      const std::string& object_hash_from_client, const char* actual_object_raw_data, uint32_t actual_object_data_len) {
+    // 1. 基本的哈希格式校验
     if (object_hash_from_client.length() != 40 || !std::all_of(object_hash_from_client.begin(), object_hash_from_client.end(), ::isxdigit)) {
          session->Send("Invalid object hash format in PUT_OBJECT request.", Protocol::MSG_RESP_ERROR); return;
     }
 
-    // 4. 数据校验：重新计算接收到的对象数据的SHA1哈希
+    // 2. 数据校验：重新计算接收到的对象数据的SHA1哈希
     std::vector<std::byte> object_bytes_for_hash_calc(actual_object_data_len);
     if (actual_object_data_len > 0) { // 允许空对象数据，例如空 blob 序列化后不为0但其内容部分为0
         std::memcpy(object_bytes_for_hash_calc.data(), reinterpret_cast<const std::byte*>(actual_object_raw_data), actual_object_data_len);
     }
     std::string calculated_hash = SHA1::sha1(object_bytes_for_hash_calc); //
     if (calculated_hash != object_hash_from_client) {
-        session->Send("Object data hash mismatch.", Protocol::MSG_RESP_ERROR); return;
+        // 分块存储的 Blob 以清单形式存放在 Blob 哈希之下：用已上传的 chunk 重组后校验
+        const std::string manifest_prefix = Blob::manifest_type_str() + " ";
+        size_t header_end = std::string(actual_object_raw_data, std::min<uint32_t>(actual_object_data_len, 32)).find('\0');
+        bool is_manifest = header_end != std::string::npos &&
+                           std::string(actual_object_raw_data, header_end).starts_with(manifest_prefix);
+        if (!is_manifest) {
+            session->Send("Object data hash mismatch.", Protocol::MSG_RESP_ERROR); return;
+        }
+        std::vector<std::byte> manifest_content(object_bytes_for_hash_calc.begin() + header_end + 1, object_bytes_for_hash_calc.end());
+        if (!Blob::assemble_from_manifest(object_hash_from_client, manifest_content, active_repo->get_objects_directory())) {
+            session->Send("Chunk manifest verification failed (missing chunks or hash mismatch).", Protocol::MSG_RESP_ERROR); return;
+        }
+        calculated_hash = object_hash_from_client;
     }
 
-    // 5. 对象写入
+    // 3. 对象写入
     bool write_ok = active_repo->write_raw_object(calculated_hash, actual_object_raw_data, actual_object_data_len); //
 
-    // 6. 发送响应
+    // 4. 发送响应
     if (write_ok) {
         session->Send(calculated_hash, Protocol::MSG_RESP_ACK_OK); //
     } else {
@@ -584,6 +635,335 @@ void LogicSystem::HandleReqPutObject(std::shared_ptr<Csession> session, uint16_t
 }
 
 
+/**
+ * @brief 处理客户端发送的 MSG_REQ_PUT_OBJECT_DEFLATED (以预设字典压缩的小对象上传) 请求。
+ * 载荷格式: <40_char_sha1_hash_from_client><dict_id_uint32_t_net><raw_length_uint32_t_net><deflate_data>；
+ * 用仓库中的同一字典解压后，按 MSG_REQ_PUT_OBJECT 的规则校验并写入。
+ * @param session 指向 CSession 的共享指针。
+ * @param msg_id 消息ID (应为 Protocol::MSG_REQ_PUT_OBJECT_DEFLATED)。
+ * @param body_data_with_token 指向包含Token前缀的完整消息体的指针。
+ * @param body_length_with_token 完整消息体的总长度。
+ */
+void LogicSystem::HandleReqPutObjectDeflated(std::shared_ptr<Csession> session, uint16_t msg_id, const char* body_data_with_token, uint32_t body_length_with_token) {
+    if (!session || session->IsClosed()) return;
+
+    const char* original_body_ptr = nullptr;
+    uint32_t original_body_len = 0;
+    std::string username_from_token;
+
+    // 1. 认证并准备载荷
+    if (!authenticateAndPreparePayload(session, body_data_with_token, body_length_with_token, "PUT_OBJECT_DEFLATED", original_body_ptr, original_body_len, username_from_token)) {
+        return;
+    }
+
+    // 2. 检查仓库是否已选定
+    if (!session->IsRepositorySelected()) { session->Send("No repository selected for PUT_OBJECT_DEFLATED.", Protocol::MSG_RESP_ERROR); return; }
+    std::shared_ptr<Repository> active_repo = session->GetActiveRepository();
+    if (!active_repo) { session->Send("Server internal error: repo context lost for PUT_OBJECT_DEFLATED.", Protocol::MSG_RESP_ERROR); return; }
+
+    // 3. 解析载荷并用字典解压
+    if (original_body_len <= 48) { session->Send("Invalid payload for PUT_OBJECT_DEFLATED (too short).", Protocol::MSG_RESP_ERROR); return; }
+    std::string object_hash_from_client(original_body_ptr, 40);
+    uint32_t dictionary_id = Protocol::unpack_u32(original_body_ptr + 40);
+    uint32_t raw_length = Protocol::unpack_u32(original_body_ptr + 44);
+    // 只有小型 Tree/Commit 会以字典压缩上传，声明长度超过上限时不分配缓冲区直接拒绝
+    if (raw_length > ZlibDictionaries::MAX_OBJECT_BYTES) {
+        session->Send("Raw length too large for PUT_OBJECT_DEFLATED.", Protocol::MSG_RESP_ERROR); return;
+    }
+    auto dictionary = ZlibDictionaries::load(active_repo->get_objects_directory(), dictionary_id);
+    if (!dictionary) { session->Send("Unknown dictionary for PUT_OBJECT_DEFLATED.", Protocol::MSG_RESP_ERROR); return; }
+    auto inflated = ZlibDictionaries::inflate(dictionary.get(), reinterpret_cast<const std::byte*>(original_body_ptr + 48),
+                                              original_body_len - 48, raw_length);
+    if (!inflated) { session->Send("Failed to inflate object data for PUT_OBJECT_DEFLATED.", Protocol::MSG_RESP_ERROR); return; }
+
+    // 4. 校验并写入
+    StoreUploadedObject(session, active_repo, object_hash_from_client, reinterpret_cast<const char*>(inflated->data()), raw_length);
+}
+
+
+/**
+ * @brief 处理客户端发送的 MSG_REQ_PUT_OBJECT_DELTA (以服务器已有对象为基准的增量上传) 请求。
+ * 载荷格式: <40_char_sha1_hash_from_client><40_char_base_sha1_hash><delta_data>；
+ * 读取基准对象的规范字节，执行增量还原出完整对象，再按 MSG_REQ_PUT_OBJECT 的规则校验并写入。
+ * 基准对象不存在时响应 MSG_RESP_OBJECT_NOT_FOUND，客户端随后改为上传完整对象。
+ * @param session 指向 CSession 的共享指针。
+ * @param msg_id 消息ID (应为 Protocol::MSG_REQ_PUT_OBJECT_DELTA)。
+ * @param body_data_with_token 指向包含Token前缀的完整消息体的指针。
+ * @param body_length_with_token 完整消息体的总长度。
+ */
+void LogicSystem::HandleReqPutObjectDelta(std::shared_ptr<Csession> session, uint16_t msg_id, const char* body_data_with_token, uint32_t body_length_with_token) {
+    if (!session || session->IsClosed()) return;
+
+    const char* original_body_ptr = nullptr;
+    uint32_t original_body_len = 0;
+    std::string username_from_token;
+
+    // 1. 认证并准备载荷
+    if (!authenticateAndPreparePayload(session, body_data_with_token, body_length_with_token, "PUT_OBJECT_DELTA", original_body_ptr, original_body_len, username_from_token)) {
+        return;
+    }
+
+    // 2. 检查仓库是否已选定
+    if (!session->IsRepositorySelected()) { session->Send("No repository selected for PUT_OBJECT_DELTA.", Protocol::MSG_RESP_ERROR); return; }
+    std::shared_ptr<Repository> active_repo = session->GetActiveRepository();
+    if (!active_repo) { session->Send("Server internal error: repo context lost for PUT_OBJECT_DELTA.", Protocol::MSG_RESP_ERROR); return; }
+
+    // 3. 解析载荷并读取基准对象 (只接受完整哈希，不做前缀匹配)
+    if (original_body_len <= 80) { session->Send("Invalid payload for PUT_OBJECT_DELTA (too short).", Protocol::MSG_RESP_ERROR); return; }
+    std::string object_hash_from_client(original_body_ptr, 40);
+    std::string base_hash(original_body_ptr + 40, 40);
+    if (!std::all_of(base_hash.begin(), base_hash.end(), ::isxdigit)) {
+        session->Send("Invalid base hash format in PUT_OBJECT_DELTA request.", Protocol::MSG_RESP_ERROR); return;
+    }
+    std::optional<std::vector<char>> base_content = active_repo->get_raw_object_content(base_hash);
+    if (!base_content) { session->Send(base_hash, Protocol::MSG_RESP_OBJECT_NOT_FOUND); return; }
+
+    // 4. 还原目标对象 (增量记录了基准长度，基准不一致时还原失败；目标长度不得超过 PUT_OBJECT 能上传的对象大小)
+    auto reconstructed = BinaryDelta::apply(reinterpret_cast<const std::byte*>(base_content->data()), base_content->size(),
+                                            reinterpret_cast<const std::byte*>(original_body_ptr + 80), original_body_len - 80,
+                                            Protocol::MAX_PUT_OBJECT_DATA_LEN);
+    if (!reconstructed) {
+        session->Send("Failed to apply delta for PUT_OBJECT_DELTA.", Protocol::MSG_RESP_ERROR); return;
+    }
+
+    // 5. 校验并写入
+    StoreUploadedObject(session, active_repo, object_hash_from_client, reinterpret_cast<const char*>(reconstructed->data()),
+                        static_cast<uint32_t>(reconstructed->size()));
+}
+
+
+/**
+ * @brief 处理客户端发送的 MSG_REQ_DICT_NEGOTIATE (协商预设字典) 请求。
+ * 载荷格式: <num_ids_uint32_t_net><dict_id_uint32_t_net>...；
+ * 以 MSG_RESP_DICT_SELECTED 响应 <selected_id><server_current_id>。
+ * @param session 指向 CSession 的共享指针。
+ * @param msg_id 消息ID (应为 Protocol::MSG_REQ_DICT_NEGOTIATE)。
+ * @param body_data_with_token 指向包含Token前缀的完整消息体的指针。
+ * @param body_length_with_token 完整消息体的总长度。
+ */
+void LogicSystem::HandleReqDictNegotiate(std::shared_ptr<Csession> session, uint16_t msg_id, const char* body_data_with_token, uint32_t body_length_with_token) {
+    if (!session || session->IsClosed()) return;
+
+    const char* original_body_ptr = nullptr;
+    uint32_t original_body_len = 0;
+    std::string username_from_token;
+
+    // 1. 认证并准备载荷
+    if (!authenticateAndPreparePayload(session, body_data_with_token, body_length_with_token, "DICT_NEGOTIATE", original_body_ptr, original_body_len, username_from_token)) {
+        return;
+    }
+    if (!session->IsRepositorySelected()) { session->Send("No repository selected for DICT_NEGOTIATE.", Protocol::MSG_RESP_ERROR); return; }
+    std::shared_ptr<Repository> active_repo = session->GetActiveRepository();
+    if (!active_repo) { session->Send("Server internal error: repo context lost for DICT_NEGOTIATE.", Protocol::MSG_RESP_ERROR); return; }
+
+    // 2. 解析客户端的字典列表
+    if (original_body_len < 4) { session->Send("Invalid payload for DICT_NEGOTIATE.", Protocol::MSG_RESP_ERROR); return; }
+    uint32_t num_ids = Protocol::unpack_u32(original_body_ptr);
+    if (original_body_len != 4 + 4ull * num_ids) { session->Send("Payload length mismatch for DICT_NEGOTIATE.", Protocol::MSG_RESP_ERROR); return; }
+    std::vector<uint32_t> client_ids(num_ids);
+    for (uint32_t i = 0; i < num_ids; ++i) client_ids[i] = Protocol::unpack_u32(original_body_ptr + 4 + 4 * i);
+
+    // 3. 优先使用服务器的当前字典，否则使用客户端列表中第一个服务器也有的字典
+    const std::filesystem::path objects_dir = active_repo->get_objects_directory();
+    auto current_dictionary = ZlibDictionaries::current(objects_dir);
+    uint32_t server_current_id = current_dictionary ? current_dictionary->id : 0;
+    uint32_t selected_id = 0;
+    if (server_current_id != 0 && std::find(client_ids.begin(), client_ids.end(), server_current_id) != client_ids.end()) {
+        selected_id = server_current_id;
+    } else {
+        for (uint32_t id : client_ids) {
+            if (id != 0 && ZlibDictionaries::load(objects_dir, id)) { selected_id = id; break; }
+        }
+    }
+
+    std::vector<char> response_payload(8);
+    Protocol::pack_u32(response_payload.data(), selected_id);
+    Protocol::pack_u32(response_payload.data() + 4, server_current_id);
+    session->Send(response_payload, Protocol::MSG_RESP_DICT_SELECTED);
+}
+
+
+/**
+ * @brief 处理客户端发送的 MSG_REQ_DICT_GET (下载预设字典) 请求。
+ * 载荷格式: <dict_id_uint32_t_net>；以 MSG_RESP_DICT_CONTENT 响应，字典不存在时以 MSG_RESP_OBJECT_NOT_FOUND 响应。
+ * @param session 指向 CSession 的共享指针。
+ * @param msg_id 消息ID (应为 Protocol::MSG_REQ_DICT_GET)。
+ * @param body_data_with_token 指向包含Token前缀的完整消息体的指针。
+ * @param body_length_with_token 完整消息体的总长度。
+ */
+void LogicSystem::HandleReqDictGet(std::shared_ptr<Csession> session, uint16_t msg_id, const char* body_data_with_token, uint32_t body_length_with_token) {
+    if (!session || session->IsClosed()) return;
+
+    const char* original_body_ptr = nullptr;
+    uint32_t original_body_len = 0;
+    std::string username_from_token;
+
+    if (!authenticateAndPreparePayload(session, body_data_with_token, body_length_with_token, "DICT_GET", original_body_ptr, original_body_len, username_from_token)) {
+        return;
+    }
+    if (!session->IsRepositorySelected()) { session->Send("No repository selected for DICT_GET.", Protocol::MSG_RESP_ERROR); return; }
+    std::shared_ptr<Repository> active_repo = session->GetActiveRepository();
+    if (!active_repo) { session->Send("Server internal error: repo context lost for DICT_GET.", Protocol::MSG_RESP_ERROR); return; }
+    if (original_body_len != 4) { session->Send("Invalid payload for DICT_GET (expected 4-byte id).", Protocol::MSG_RESP_ERROR); return; }
+
+    uint32_t dictionary_id = Protocol::unpack_u32(original_body_ptr);
+    auto dictionary = ZlibDictionaries::load(active_repo->get_objects_directory(), dictionary_id);
+    if (!dictionary) {
+        session->Send(ZlibDictionaries::format_id(dictionary_id), Protocol::MSG_RESP_OBJECT_NOT_FOUND);
+        return;
+    }
+    std::vector<char> response_payload(4);
+    Protocol::pack_u32(response_payload.data(), dictionary_id);
+    const char* dictionary_data = reinterpret_cast<const char*>(dictionary->data.data());
+    response_payload.insert(response_payload.end(), dictionary_data, dictionary_data + dictionary->data.size());
+    session->Send(response_payload, Protocol::MSG_RESP_DICT_CONTENT);
+}
+
+
+/**
+ * @brief 处理客户端发送的 MSG_REQ_LFS_CHECK (检查大文件内容是否存在) 请求。
+ * 载荷格式与 MSG_REQ_CHECK_OBJECTS 相同，但检查的是仓库 .biogit/lfs/ 内容库中的 oid；
+ * 以 MSG_RESP_CHECK_OBJECTS_RESULT 响应。
+ * @param session 指向 CSession 的共享指针。
+ * @param msg_id 消息ID (应为 Protocol::MSG_REQ_LFS_CHECK)。
+ * @param body_data_with_token 指向包含Token前缀的完整消息体的指针。
+ * @param body_length_with_token 完整消息体的总长度。
+ */
+void LogicSystem::HandleReqLfsCheck(std::shared_ptr<Csession> session, uint16_t msg_id, const char* body_data_with_token, uint32_t body_length_with_token) {
+    if (!session || session->IsClosed()) return;
+
+    const char* original_body_ptr = nullptr;
+    uint32_t original_body_len = 0;
+    std::string username_from_token;
+
+    // 1. 认证并准备载荷
+    if (!authenticateAndPreparePayload(session, body_data_with_token, body_length_with_token, "LFS_CHECK", original_body_ptr, original_body_len, username_from_token)) {
+        return;
+    }
+
+    // 2. 检查仓库是否选定
+    if (!session->IsRepositorySelected()) { session->Send("No repository selected for LFS_CHECK.", Protocol::MSG_RESP_ERROR); return; }
+    std::shared_ptr<Repository> active_repo = session->GetActiveRepository();
+    if (!active_repo) { session->Send("Server internal error: repo context lost for LFS_CHECK.", Protocol::MSG_RESP_ERROR); return; }
+
+    // 3. 解析原始载荷: <num_oids_uint32_t_net><40_char_oid_1>...
+    if (original_body_len < sizeof(uint32_t)) {
+        session->Send("Invalid payload for LFS_CHECK (too short for count).", Protocol::MSG_RESP_ERROR); return;
+    }
+    uint32_t num_oids_net;
+    std::memcpy(&num_oids_net, original_body_ptr, sizeof(uint32_t));
+    uint32_t num_oids = boost::asio::detail::socket_ops::network_to_host_long(num_oids_net);
+    if (num_oids > Protocol::MAX_LFS_CHECK_OIDS) {
+        session->Send("Too many oids for LFS_CHECK.", Protocol::MSG_RESP_ERROR); return;
+    }
+    if (original_body_len != sizeof(uint32_t) + 40ull * num_oids) {
+        session->Send("Payload length mismatch for LFS_CHECK.", Protocol::MSG_RESP_ERROR); return;
+    }
+
+    // 4. 检查每个 oid 是否在内容库中，并发送响应
+    LfsStore lfs_store(active_repo->get_objects_directory().parent_path());
+    std::vector<char> response_payload(sizeof(uint32_t) + num_oids);
+    std::memcpy(response_payload.data(), &num_oids_net, sizeof(uint32_t));
+    for (uint32_t i = 0; i < num_oids; ++i) {
+        std::string oid(original_body_ptr + sizeof(uint32_t) + i * 40, 40);
+        response_payload[sizeof(uint32_t) + i] = lfs_store.contains(oid) ? static_cast<char>(0x01) : static_cast<char>(0x00);
+    }
+    session->Send(response_payload, Protocol::MSG_RESP_CHECK_OBJECTS_RESULT);
+}
+
+
+/**
+ * @brief 处理客户端发送的 MSG_REQ_LFS_PUT_BLOCK (上传大文件内容数据块) 请求。
+ * 1. 认证客户端并检查仓库是否选定。
+ * 2. 解析载荷: <40_char_oid><offset_uint64_t_net><total_size_uint64_t_net><block_data>。
+ * 3. 交给 LfsStore::receive_block 追加到未完成文件；最后一块到达时由它校验 oid 并移入内容库。
+ * 4. 成功时发送 MSG_RESP_ACK_OK (Body 为 oid)，否则发送 MSG_RESP_ERROR。
+ * @param session 指向 CSession 的共享指针。
+ * @param msg_id 消息ID (应为 Protocol::MSG_REQ_LFS_PUT_BLOCK)。
+ * @param body_data_with_token 指向包含Token前缀的完整消息体的指针。
+ * @param body_length_with_token 完整消息体的总长度。
+ */
+void LogicSystem::HandleReqLfsPutBlock(std::shared_ptr<Csession> session, uint16_t msg_id, const char* body_data_with_token, uint32_t body_length_with_token) {
+    if (!session || session->IsClosed()) return;
+
+    const char* original_body_ptr = nullptr;
+    uint32_t original_body_len = 0;
+    std::string username_from_token;
+
+    // 1. 认证并准备载荷
+    if (!authenticateAndPreparePayload(session, body_data_with_token, body_length_with_token, "LFS_PUT_BLOCK", original_body_ptr, original_body_len, username_from_token)) {
+        return;
+    }
+    if (!session->IsRepositorySelected()) { session->Send("No repository selected for LFS_PUT_BLOCK.", Protocol::MSG_RESP_ERROR); return; }
+    std::shared_ptr<Repository> active_repo = session->GetActiveRepository();
+    if (!active_repo) { session->Send("Server internal error: repo context lost for LFS_PUT_BLOCK.", Protocol::MSG_RESP_ERROR); return; }
+
+    // 2. 解析原始载荷
+    const uint32_t header_len = 40 + 8 + 8;
+    if (original_body_len < header_len) {
+        session->Send("Invalid payload for LFS_PUT_BLOCK (too short for header).", Protocol::MSG_RESP_ERROR); return;
+    }
+    std::string oid(original_body_ptr, 40);
+    uint64_t offset = Protocol::unpack_u64(original_body_ptr + 40);
+    uint64_t total_size = Protocol::unpack_u64(original_body_ptr + 48);
+
+    // 3. 写入内容库
+    LfsStore lfs_store(active_repo->get_objects_directory().parent_path());
+    if (!lfs_store.receive_block(oid, offset, total_size, original_body_ptr + header_len, original_body_len - header_len)) {
+        session->Send("Failed to store LFS block (bad offset, write error or hash mismatch).", Protocol::MSG_RESP_ERROR); return;
+    }
+    session->Send(oid, Protocol::MSG_RESP_ACK_OK);
+}
+
+
+/**
+ * @brief 处理客户端发送的 MSG_REQ_LFS_GET_BLOCK (下载大文件内容数据块) 请求。
+ * 载荷为 <40_char_oid><offset_uint64_t_net>；以 MSG_RESP_LFS_BLOCK 发送从 offset 开始的至多一块数据，
+ * 内容不存在时发送 MSG_RESP_OBJECT_NOT_FOUND。
+ * @param session 指向 CSession 的共享指针。
+ * @param msg_id 消息ID (应为 Protocol::MSG_REQ_LFS_GET_BLOCK)。
+ * @param body_data_with_token 指向包含Token前缀的完整消息体的指针。
+ * @param body_length_with_token 完整消息体的总长度。
+ */
+void LogicSystem::HandleReqLfsGetBlock(std::shared_ptr<Csession> session, uint16_t msg_id, const char* body_data_with_token, uint32_t body_length_with_token) {
+    if (!session || session->IsClosed()) return;
+
+    const char* original_body_ptr = nullptr;
+    uint32_t original_body_len = 0;
+    std::string username_from_token;
+
+    // 1. 认证并准备载荷
+    if (!authenticateAndPreparePayload(session, body_data_with_token, body_length_with_token, "LFS_GET_BLOCK", original_body_ptr, original_body_len, username_from_token)) {
+        return;
+    }
+    if (!session->IsRepositorySelected()) { session->Send("No repository selected for LFS_GET_BLOCK.", Protocol::MSG_RESP_ERROR); return; }
+    std::shared_ptr<Repository> active_repo = session->GetActiveRepository();
+    if (!active_repo) { session->Send("Server internal error: repo context lost for LFS_GET_BLOCK.", Protocol::MSG_RESP_ERROR); return; }
+
+    // 2. 解析原始载荷
+    if (original_body_len != 40 + 8) {
+        session->Send("Invalid payload for LFS_GET_BLOCK (expected oid + offset).", Protocol::MSG_RESP_ERROR); return;
+    }
+    std::string oid(original_body_ptr, 40);
+    uint64_t offset = Protocol::unpack_u64(original_body_ptr + 40);
+
+    // 3. 读取数据块并发送
+    LfsStore lfs_store(active_repo->get_objects_directory().parent_path());
+    auto block_opt = lfs_store.read_block(oid, offset, LfsStore::BLOCK_SIZE);
+    if (!block_opt) {
+        session->Send(oid, Protocol::MSG_RESP_OBJECT_NOT_FOUND); return;
+    }
+    std::error_code ec;
+    uint64_t total_size = std::filesystem::file_size(lfs_store.object_path(oid), ec);
+    std::vector<char> response_payload(40 + 8 + 8);
+    std::memcpy(response_payload.data(), oid.data(), 40);
+    Protocol::pack_u64(response_payload.data() + 40, offset);
+    Protocol::pack_u64(response_payload.data() + 48, total_size);
+    response_payload.insert(response_payload.end(), block_opt->begin(), block_opt->end());
+    session->Send(response_payload, Protocol::MSG_RESP_LFS_BLOCK);
+}
+
+
 /**
  * @brief 处理客户端发送的 MSG_REQ_UPDATE_REF (更新引用) 请求。
  * 1. 认证客户端。
@@ -0,0 +1,137 @@
+#include "../include/ObjectAlternates.h"
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+
+namespace Biogit {
+namespace ObjectAlternates {
+
+namespace {
+
+/// 一个被读取过的 alternates 文件及其修改时间 (文件不存在时为 file_time_type::min())
+using FileStamps = std::vector<std::pair<std::filesystem::path, std::filesystem::file_time_type>>;
+
+/**
+ * @brief alternates 的进程内缓存 (服务器的多个会话共享)：对象目录 -> (递归读取过的各 alternates 文件的修改时间, 备用目录列表)。
+ * @details 备用目录自身的 alternates 变化 (包括新建) 也会使缓存失效，而不只是本仓库的 alternates 文件。
+ */
+struct AlternatesCache {
+    std::mutex mutex;
+    std::map<std::string, std::pair<FileStamps, std::vector<std::filesystem::path>>> entries;
+};
+
+AlternatesCache& cache() {
+    static AlternatesCache instance;
+    return instance;
+}
+
+/**
+ * @brief 读取一个对象目录的 alternates 文件 (不递归)。
+ */
+std::vector<std::filesystem::path> read_file(const std::filesystem::path& objects_dir) {
+    std::vector<std::filesystem::path> dirs;
+    std::ifstream ifs(objects_dir / FILE_NAME);
+    std::string line;
+    while (std::getline(ifs, line)) {
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        std::filesystem::path dir(line);
+        if (dir.is_relative()) dir = objects_dir / dir;
+        dirs.push_back(dir.lexically_normal());
+    }
+    return dirs;
+}
+
+std::filesystem::file_time_type modified_time(const std::filesystem::path& file_path) {
+    std::error_code ec;
+    auto modified = std::filesystem::last_write_time(file_path, ec);
+    return ec ? std::filesystem::file_time_type::min() : modified;
+}
+
+void collect(const std::filesystem::path& objects_dir, int depth, std::set<std::string>& seen,
+             std::vector<std::filesystem::path>& out, FileStamps& stamps) {
+    if (depth > MAX_DEPTH) return;
+    // 修改时间先于内容读取：读取期间文件被改写时，下次调用会看到时间变化并重新读取
+    stamps.emplace_back(objects_dir / FILE_NAME, modified_time(objects_dir / FILE_NAME));
+    for (const auto& dir : read_file(objects_dir)) {
+        if (!seen.insert(dir.generic_string()).second) continue;
+        out.push_back(dir);
+        collect(dir, depth + 1, seen, out, stamps);
+    }
+}
+
+bool stamps_match(const FileStamps& stamps) {
+    for (const auto& [file_path, modified] : stamps) {
+        if (modified_time(file_path) != modified) return false;
+    }
+    return true;
+}
+
+}
+
+
+std::vector<std::filesystem::path> list(const std::filesystem::path& objects_dir) {
+    std::error_code ec;
+    if (!std::filesystem::exists(objects_dir / FILE_NAME, ec)) return {}; // 没有 alternates 文件 (绝大多数仓库)
+
+    const std::string key = objects_dir.lexically_normal().generic_string();
+    AlternatesCache& c = cache();
+    {
+        std::unique_lock<std::mutex> lock(c.mutex);
+        auto it = c.entries.find(key);
+        if (it != c.entries.end()) {
+            auto cached = it->second; // 校验要 stat 多个文件，不在锁内进行
+            lock.unlock();
+            if (stamps_match(cached.first)) return cached.second;
+        }
+    }
+
+    std::set<std::string> seen{key};
+    std::vector<std::filesystem::path> dirs;
+    FileStamps stamps;
+    collect(objects_dir, 1, seen, dirs, stamps);
+
+    std::lock_guard<std::mutex> lock(c.mutex);
+    c.entries[key] = {std::move(stamps), dirs};
+    return dirs;
+}
+
+std::filesystem::path locate(const std::filesystem::path& objects_dir, const std::string& hash_hex) {
+    std::filesystem::path local_path = objects_dir / hash_hex.substr(0, 2) / hash_hex.substr(2);
+    std::error_code ec;
+    if (std::filesystem::exists(local_path, ec)) return local_path;
+    for (const auto& dir : list(objects_dir)) {
+        std::filesystem::path alternate_path = dir / hash_hex.substr(0, 2) / hash_hex.substr(2);
+        if (std::filesystem::exists(alternate_path, ec)) return alternate_path;
+    }
+    return local_path;
+}
+
+bool contains(const std::filesystem::path& objects_dir, const std::string& hash_hex) {
+    std::error_code ec;
+    return std::filesystem::exists(locate(objects_dir, hash_hex), ec);
+}
+
+bool add(const std::filesystem::path& objects_dir, const std::filesystem::path& alternate_objects_dir) {
+    std::filesystem::path alternate = std::filesystem::absolute(alternate_objects_dir).lexically_normal();
+    for (const auto& dir : read_file(objects_dir)) {
+        if (dir == alternate) return true;
+    }
+
+    std::error_code ec;
+    std::filesystem::path file_path = objects_dir / FILE_NAME;
+    std::filesystem::create_directories(file_path.parent_path(), ec);
+    std::ofstream ofs(file_path, std::ios::app);
+    ofs << alternate.generic_string() << "\n";
+    if (!ofs.good()) {
+        std::cerr << "错误: 无法写入备用对象库文件 '" << file_path.string() << "'。" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}
+}
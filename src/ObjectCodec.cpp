@@ -0,0 +1,658 @@
+#include "../include/ObjectCodec.h"
+#include "../include/object.h"
+#include "../include/ZlibDictionary.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <zlib.h>
+
+namespace Biogit {
+
+namespace {
+
+// ---------------- 通用的字节流读写辅助 ----------------
+
+void put_varint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+/**
+ * @brief 带边界检查的顺序读取器；任何越界读取都会把 ok 置为 false。
+ */
+struct ByteReader {
+    const uint8_t* data;
+    size_t size;
+    size_t pos = 0;
+    bool ok = true;
+
+    bool at_end() const { return pos >= size; }
+
+    uint8_t u8() {
+        if (pos >= size) { ok = false; return 0; }
+        return data[pos++];
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = u8();
+            if (!ok) return 0;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        ok = false;
+        return 0;
+    }
+
+    const uint8_t* take(size_t length) {
+        if (length > size - std::min(pos, size)) { ok = false; return nullptr; }
+        const uint8_t* p = data + pos;
+        pos += length;
+        return p;
+    }
+};
+
+enum SectionMethod : uint8_t { STORED = 0, ZLIB = 1 };
+
+/**
+ * @brief 写入一个流：<原始长度><方法><存储长度><数据>。allow_zlib 时仅在压缩有收益时使用 zlib。
+ */
+void put_section(std::vector<uint8_t>& out, const std::vector<uint8_t>& raw, bool allow_zlib) {
+    put_varint(out, raw.size());
+    if (allow_zlib && raw.size() > 64) {
+        uLongf bound = compressBound(static_cast<uLong>(raw.size()));
+        std::vector<uint8_t> compressed(bound);
+        if (compress2(compressed.data(), &bound, raw.data(), static_cast<uLong>(raw.size()), Z_BEST_COMPRESSION) == Z_OK &&
+            bound < raw.size()) {
+            out.push_back(ZLIB);
+            put_varint(out, bound);
+            out.insert(out.end(), compressed.begin(), compressed.begin() + static_cast<std::ptrdiff_t>(bound));
+            return;
+        }
+    }
+    out.push_back(STORED);
+    put_varint(out, raw.size());
+    out.insert(out.end(), raw.begin(), raw.end());
+}
+
+std::optional<std::vector<uint8_t>> get_section(ByteReader& in) {
+    uint64_t raw_size = in.varint();
+    uint8_t method = in.u8();
+    uint64_t stored_size = in.varint();
+    const uint8_t* stored = in.take(stored_size);
+    if (!in.ok) return std::nullopt;
+
+    // 分配缓冲区前先按存储长度校验声明的原始长度，损坏的对象文件不能让这里申请任意大的内存
+    // (stored_size 已不超过输入长度；deflate 的压缩比不超过 1032:1)
+    constexpr uint64_t MAX_ZLIB_EXPANSION = 1032;
+    if (method == STORED) {
+        if (stored_size != raw_size) return std::nullopt;
+        std::vector<uint8_t> raw(raw_size);
+        if (raw_size > 0) std::memcpy(raw.data(), stored, raw_size);
+        return raw;
+    }
+    if (method == ZLIB) {
+        if (raw_size > stored_size * MAX_ZLIB_EXPANSION) return std::nullopt;
+        std::vector<uint8_t> raw(raw_size);
+        uLongf dest_size = static_cast<uLongf>(raw_size);
+        if (uncompress(raw.data(), &dest_size, stored, static_cast<uLong>(stored_size)) != Z_OK || dest_size != raw_size) {
+            return std::nullopt;
+        }
+        return raw;
+    }
+    return std::nullopt;
+}
+
+// ---------------- 序列编解码器的内部格式 ----------------
+
+enum SequenceFormat : uint8_t { FORMAT_FASTA = 1, FORMAT_FASTQ = 2 };
+constexpr uint8_t FLAG_TRAILING_NEWLINE = 0x01;
+
+int base_code(uint8_t upper) {
+    switch (upper) {
+        case 'A': return 0;
+        case 'C': return 1;
+        case 'G': return 2;
+        case 'T': return 3;
+        default: return -1;
+    }
+}
+
+constexpr std::array<char, 4> CODE_TO_BASE = {'A', 'C', 'G', 'T'};
+
+bool is_nucleotide(uint8_t c) {
+    switch (c) {
+        case 'A': case 'C': case 'G': case 'T': case 'N':
+        case 'a': case 'c': case 'g': case 't': case 'n':
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief 碱基流编码器：2 bit 打包、例外段、大小写段。
+ */
+class BaseStreamWriter {
+public:
+    void append(const uint8_t* seq, size_t length) {
+        for (size_t i = 0; i < length; ++i) {
+            uint8_t c = seq[i];
+            bool lower = c >= 'a' && c <= 'z';
+            uint8_t upper = lower ? static_cast<uint8_t>(c - 32) : c;
+
+            // 大小写段 (从大写段开始交替)
+            if (lower != current_lower_) {
+                put_varint(case_runs_, case_run_length_);
+                case_run_length_ = 0;
+                current_lower_ = lower;
+            }
+            ++case_run_length_;
+
+            // 2 bit 碱基 (例外位置写 0)
+            int code = base_code(upper);
+            if (total_ % 4 == 0) packed_.push_back(0);
+            if (code > 0) packed_.back() |= static_cast<uint8_t>(code << ((total_ % 4) * 2));
+            if (code < 0) add_exception(upper);
+            ++total_;
+        }
+    }
+
+    uint64_t total() const { return total_; }
+    const std::vector<uint8_t>& packed() const { return packed_; }
+
+    std::vector<uint8_t> finish_exceptions() {
+        flush_exception();
+        return exceptions_;
+    }
+
+    std::vector<uint8_t> finish_case_runs() {
+        put_varint(case_runs_, case_run_length_);
+        case_run_length_ = 0;
+        return case_runs_;
+    }
+
+private:
+    void add_exception(uint8_t byte) {
+        if (exception_length_ > 0 && byte == exception_byte_ && exception_start_ + exception_length_ == total_) {
+            ++exception_length_;
+            return;
+        }
+        flush_exception();
+        exception_start_ = total_;
+        exception_length_ = 1;
+        exception_byte_ = byte;
+    }
+
+    void flush_exception() {
+        if (exception_length_ == 0) return;
+        put_varint(exceptions_, exception_start_ - last_exception_end_);
+        put_varint(exceptions_, exception_length_);
+        exceptions_.push_back(exception_byte_);
+        last_exception_end_ = exception_start_ + exception_length_;
+        exception_length_ = 0;
+    }
+
+    uint64_t total_ = 0;
+    std::vector<uint8_t> packed_;
+    std::vector<uint8_t> exceptions_;
+    uint64_t exception_start_ = 0, exception_length_ = 0, last_exception_end_ = 0;
+    uint8_t exception_byte_ = 0;
+    std::vector<uint8_t> case_runs_;
+    uint64_t case_run_length_ = 0;
+    bool current_lower_ = false;
+};
+
+/**
+ * @brief 碱基流解码器：按顺序还原字符。
+ */
+class BaseStreamReader {
+public:
+    BaseStreamReader(const std::vector<uint8_t>& packed, uint64_t total,
+                     const std::vector<uint8_t>& exceptions, const std::vector<uint8_t>& case_runs)
+        : packed_(packed), total_(total),
+          exceptions_{exceptions.data(), exceptions.size()}, case_runs_{case_runs.data(), case_runs.size()} {
+        next_exception();
+        case_remaining_ = case_runs_.varint();
+    }
+
+    /// 追加 length 个字符到 out；数据不足时返回 false
+    bool emit(size_t length, std::string& out) {
+        if (length > total_ - pos_) return false;
+        for (size_t i = 0; i < length; ++i, ++pos_) {
+            char c;
+            if (exception_length_ > 0 && pos_ >= exception_start_) {
+                c = static_cast<char>(exception_byte_);
+                if (pos_ + 1 == exception_start_ + exception_length_) next_exception();
+            } else {
+                c = CODE_TO_BASE[(packed_[pos_ / 4] >> ((pos_ % 4) * 2)) & 0x3];
+            }
+            while (case_remaining_ == 0 && !case_runs_.at_end()) {
+                lower_ = !lower_;
+                case_remaining_ = case_runs_.varint();
+            }
+            if (case_remaining_ == 0) return false;
+            --case_remaining_;
+            if (lower_) c = static_cast<char>(c + 32);
+            out.push_back(c);
+        }
+        return exceptions_.ok && case_runs_.ok;
+    }
+
+    bool finished() const { return pos_ == total_ && exception_length_ == 0 && case_remaining_ == 0 && case_runs_.at_end(); }
+
+private:
+    void next_exception() {
+        exception_length_ = 0;
+        if (exceptions_.at_end()) return;
+        exception_start_ = last_exception_end_ + exceptions_.varint();
+        exception_length_ = exceptions_.varint();
+        exception_byte_ = exceptions_.u8();
+        last_exception_end_ = exception_start_ + exception_length_;
+    }
+
+    const std::vector<uint8_t>& packed_;
+    uint64_t total_;
+    uint64_t pos_ = 0;
+    ByteReader exceptions_;
+    uint64_t exception_start_ = 0, exception_length_ = 0, last_exception_end_ = 0;
+    uint8_t exception_byte_ = 0;
+    ByteReader case_runs_;
+    uint64_t case_remaining_ = 0;
+    bool lower_ = false;
+};
+
+/// 行长度游程：连续相同长度的序列行合并为 (长度, 行数)
+struct LineRun {
+    uint64_t length = 0;
+    uint64_t count = 0;
+};
+
+/// 从文本中按 '\n' 依次取出下一行 (不含 '\n')
+bool next_text_line(const std::vector<uint8_t>& text, size_t& pos, std::string& line) {
+    if (pos >= text.size()) return false;
+    const uint8_t* begin = text.data() + pos;
+    const void* newline = std::memchr(begin, '\n', text.size() - pos);
+    if (!newline) return false;
+    size_t length = static_cast<const uint8_t*>(newline) - begin;
+    line.assign(reinterpret_cast<const char*>(begin), length);
+    pos += length + 1;
+    return true;
+}
+
+}
+
+
+// ---------------- SequenceCodec ----------------
+
+bool SequenceCodec::accepts(const std::byte* data, size_t size, const std::filesystem::path& path_hint) const {
+    if (size < ObjectCodecs::MIN_ENCODE_SIZE) {
+        return false;
+    }
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+
+    // 1. 路径提示：常见序列文件扩展名直接尝试编码 (编码失败或无收益时仍会回退为原样存储)
+    static const std::array<std::string, 7> sequence_extensions = {".fa", ".fasta", ".fna", ".ffn", ".fas", ".fq", ".fastq"};
+    std::string extension = path_hint.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    if (std::find(sequence_extensions.begin(), sequence_extensions.end(), extension) != sequence_extensions.end()) {
+        return bytes[0] == '>' || bytes[0] == '@' || is_nucleotide(bytes[0]);
+    }
+
+    // 2. 内容嗅探：抽样前 4KB，非标题行中核苷酸字符应占绝大多数
+    //    (分块存储的大文件中间的块可能不以 '>' 开头，因此不要求首字符)
+    const size_t sample_size = std::min<size_t>(size, 4096);
+    size_t nucleotides = 0, others = 0, line_index = 0;
+    bool skip_line = false;
+    bool fastq = bytes[0] == '@';
+    for (size_t i = 0; i < sample_size; ++i) {
+        uint8_t c = bytes[i];
+        bool line_start = i == 0 || bytes[i - 1] == '\n';
+        if (line_start) {
+            skip_line = fastq ? (line_index % 4 != 1) : (c == '>');
+            ++line_index;
+        }
+        if (c == '\r') return false;
+        if (c == '\n' || skip_line) continue;
+        (is_nucleotide(c) ? nucleotides : others)++;
+    }
+    return nucleotides >= 64 && nucleotides >= 9 * others;
+}
+
+std::optional<std::vector<std::byte>> SequenceCodec::encode(const std::byte* data, size_t size) const {
+    if (size == 0) return std::nullopt;
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    if (std::memchr(bytes, '\r', size)) return std::nullopt;
+
+    // 1. 切分行 (以 '\n' 结尾的内容不产生末尾的空行)
+    const bool trailing_newline = bytes[size - 1] == '\n';
+    std::vector<std::pair<size_t, size_t>> lines; // <起始偏移, 长度>
+    for (size_t start = 0; start < size;) {
+        const void* newline = std::memchr(bytes + start, '\n', size - start);
+        size_t end = newline ? static_cast<size_t>(static_cast<const uint8_t*>(newline) - bytes) : size;
+        lines.emplace_back(start, end - start);
+        start = end + 1;
+    }
+
+    // 2. 按格式把各行分配到不同的流
+    const uint8_t format = bytes[0] == '@' ? FORMAT_FASTQ : FORMAT_FASTA;
+    std::vector<uint8_t> layout, headers, plus_lines, qualities;
+    BaseStreamWriter bases;
+    LineRun run;
+    auto flush_run = [&](bool tagged) {
+        if (run.count == 0) return;
+        put_varint(layout, tagged ? run.length + 1 : run.length); // FASTA 中 0 保留给标题行
+        put_varint(layout, run.count);
+        run = {};
+    };
+    auto add_sequence_line = [&](size_t start, size_t length, bool tagged) {
+        if (run.count > 0 && run.length != length) flush_run(tagged);
+        run.length = length;
+        ++run.count;
+        bases.append(bytes + start, length);
+    };
+
+    if (format == FORMAT_FASTQ) {
+        if (lines.size() % 4 != 0) return std::nullopt;
+        for (size_t i = 0; i < lines.size(); i += 4) {
+            auto [h_start, h_len] = lines[i];
+            auto [s_start, s_len] = lines[i + 1];
+            auto [p_start, p_len] = lines[i + 2];
+            auto [q_start, q_len] = lines[i + 3];
+            if (h_len == 0 || bytes[h_start] != '@' || p_len == 0 || bytes[p_start] != '+' || q_len != s_len) {
+                return std::nullopt; // 非严格 4 行记录 (例如多行 FASTQ)：不编码
+            }
+            headers.insert(headers.end(), bytes + h_start + 1, bytes + h_start + h_len);
+            headers.push_back('\n');
+            plus_lines.insert(plus_lines.end(), bytes + p_start + 1, bytes + p_start + p_len);
+            plus_lines.push_back('\n');
+            qualities.insert(qualities.end(), bytes + q_start, bytes + q_start + q_len);
+            add_sequence_line(s_start, s_len, false);
+        }
+        flush_run(false);
+    } else {
+        for (const auto& [start, length] : lines) {
+            if (length > 0 && bytes[start] == '>') {
+                flush_run(true);
+                put_varint(layout, 0);
+                headers.insert(headers.end(), bytes + start + 1, bytes + start + length);
+                headers.push_back('\n');
+            } else {
+                add_sequence_line(start, length, true);
+            }
+        }
+        flush_run(true);
+    }
+
+    // 3. 输出：格式、标志、碱基总数，然后依次是各个流
+    std::vector<uint8_t> out;
+    out.push_back(format);
+    out.push_back(trailing_newline ? FLAG_TRAILING_NEWLINE : 0);
+    put_varint(out, bases.total());
+    put_section(out, layout, true);
+    put_section(out, headers, true);
+    put_section(out, plus_lines, true);
+    put_section(out, qualities, true);
+    put_section(out, bases.packed(), false); // 2 bit 数据几乎不可再压缩，原样存放以加快解码
+    put_section(out, bases.finish_exceptions(), true);
+    put_section(out, bases.finish_case_runs(), true);
+
+    std::vector<std::byte> result(out.size());
+    std::memcpy(result.data(), out.data(), out.size());
+    return result;
+}
+
+std::optional<std::vector<std::byte>> SequenceCodec::decode(const std::byte* data, size_t size) const {
+    ByteReader in{reinterpret_cast<const uint8_t*>(data), size};
+    const uint8_t format = in.u8();
+    const uint8_t flags = in.u8();
+    const uint64_t total_bases = in.varint();
+    auto layout = get_section(in);
+    auto headers = get_section(in);
+    auto plus_lines = get_section(in);
+    auto qualities = get_section(in);
+    auto packed = get_section(in);
+    auto exceptions = get_section(in);
+    auto case_runs = get_section(in);
+    if (!in.ok || !in.at_end() || !layout || !headers || !plus_lines || !qualities || !packed || !exceptions || !case_runs ||
+        (format != FORMAT_FASTA && format != FORMAT_FASTQ) || packed->size() != (total_bases + 3) / 4) {
+        return std::nullopt;
+    }
+
+    BaseStreamReader bases(*packed, total_bases, *exceptions, *case_runs);
+    ByteReader layout_in{layout->data(), layout->size()};
+    std::string text;
+    text.reserve(total_bases + total_bases / 50 + headers->size() + qualities->size() * 2);
+    size_t header_pos = 0, plus_pos = 0, quality_pos = 0;
+    std::string line;
+
+    while (!layout_in.at_end()) {
+        uint64_t value = layout_in.varint();
+        if (format == FORMAT_FASTA && value == 0) { // 标题行
+            if (!next_text_line(*headers, header_pos, line)) return std::nullopt;
+            text += '>';
+            text += line;
+            text += '\n';
+            continue;
+        }
+        uint64_t length = format == FORMAT_FASTA ? value - 1 : value;
+        uint64_t count = layout_in.varint();
+        if (!layout_in.ok) return std::nullopt;
+        for (uint64_t i = 0; i < count; ++i) {
+            if (format == FORMAT_FASTQ) {
+                if (!next_text_line(*headers, header_pos, line)) return std::nullopt;
+                text += '@';
+                text += line;
+                text += '\n';
+            }
+            if (!bases.emit(length, text)) return std::nullopt;
+            text += '\n';
+            if (format == FORMAT_FASTQ) {
+                if (!next_text_line(*plus_lines, plus_pos, line) || quality_pos + length > qualities->size()) return std::nullopt;
+                text += '+';
+                text += line;
+                text += '\n';
+                text.append(reinterpret_cast<const char*>(qualities->data() + quality_pos), length);
+                text += '\n';
+                quality_pos += length;
+            }
+        }
+    }
+    if (!layout_in.ok || !bases.finished() || header_pos != headers->size() ||
+        plus_pos != plus_lines->size() || quality_pos != qualities->size()) {
+        return std::nullopt;
+    }
+    if (!(flags & FLAG_TRAILING_NEWLINE)) {
+        if (text.empty()) return std::nullopt;
+        text.pop_back(); // 最后一行原本没有换行符
+    }
+
+    std::vector<std::byte> result(text.size());
+    std::memcpy(result.data(), text.data(), text.size());
+    return result;
+}
+
+
+// ---------------- 注册表与存储层入口 ----------------
+
+namespace ObjectCodecs {
+
+namespace {
+
+const std::array<const ObjectCodec*, 1>& registry() {
+    static const SequenceCodec sequence_codec;
+    static const std::array<const ObjectCodec*, 1> codecs = {&sequence_codec};
+    return codecs;
+}
+
+bool has_magic(const std::vector<std::byte>& bytes) {
+    return bytes.size() > sizeof(MAGIC) && std::memcmp(bytes.data(), MAGIC, sizeof(MAGIC)) == 0;
+}
+
+/// MAGIC + 编号 + 规范头部 (含 '\0')，后接编码内容
+std::vector<std::byte> make_stored_prefix(uint8_t codec_id, const std::vector<std::byte>& object_bytes, size_t header_end, size_t extra) {
+    std::vector<std::byte> stored;
+    stored.reserve(sizeof(MAGIC) + 1 + header_end + 1 + extra);
+    for (char ch : MAGIC) stored.push_back(static_cast<std::byte>(ch));
+    stored.push_back(static_cast<std::byte>(codec_id));
+    stored.insert(stored.end(), object_bytes.begin(), object_bytes.begin() + static_cast<std::ptrdiff_t>(header_end + 1));
+    return stored;
+}
+
+/**
+ * @brief 以仓库当前字典压缩小型 Tree/Commit；没有字典或没有收益时返回 std::nullopt。
+ */
+std::optional<std::vector<std::byte>> encode_with_dictionary(const std::vector<std::byte>& object_bytes, size_t header_end,
+                                                             const std::filesystem::path& objects_dir) {
+    auto dictionary = ZlibDictionaries::current(objects_dir);
+    if (!dictionary) return std::nullopt;
+    const std::byte* content = object_bytes.data() + header_end + 1;
+    const size_t content_size = object_bytes.size() - header_end - 1;
+    auto compressed = ZlibDictionaries::deflate(dictionary.get(), content, content_size);
+    if (!compressed || compressed->size() + 4 + sizeof(MAGIC) + 1 >= content_size) return std::nullopt;
+
+    std::vector<std::byte> stored = make_stored_prefix(ZlibDictionaries::CODEC_ID, object_bytes, header_end, 4 + compressed->size());
+    for (int shift = 24; shift >= 0; shift -= 8) { // 字典编号 (大端)
+        stored.push_back(static_cast<std::byte>((dictionary->id >> shift) & 0xFF));
+    }
+    stored.insert(stored.end(), compressed->begin(), compressed->end());
+    return stored;
+}
+
+}
+
+const ObjectCodec* find(uint8_t id) {
+    for (const ObjectCodec* codec : registry()) {
+        if (codec->id() == id) return codec;
+    }
+    return nullptr;
+}
+
+const ObjectCodec* select(const std::byte* data, size_t size, const std::filesystem::path& path_hint) {
+    for (const ObjectCodec* codec : registry()) {
+        if (codec->accepts(data, size, path_hint)) return codec;
+    }
+    return nullptr;
+}
+
+std::vector<std::byte> encode_for_storage(const std::vector<std::byte>& object_bytes, const std::filesystem::path& path_hint,
+                                          const std::filesystem::path& objects_dir) {
+    // 1. 解析规范头部：小型 Tree/Commit 使用预设字典，其余只编码 blob/chunk
+    const char* raw = reinterpret_cast<const char*>(object_bytes.data());
+    size_t header_end = std::string_view(raw, std::min<size_t>(object_bytes.size(), 64)).find('\0');
+    if (header_end == std::string_view::npos) return object_bytes;
+    std::string_view header(raw, header_end);
+    std::string_view type = header.substr(0, header.find(' '));
+    if (ZlibDictionaries::applies_to(type, object_bytes.size() - header_end - 1)) {
+        if (objects_dir.empty()) return object_bytes;
+        auto stored = encode_with_dictionary(object_bytes, header_end, objects_dir);
+        return stored ? std::move(*stored) : object_bytes;
+    }
+    if (type != Blob::type_str() && type != Blob::chunk_type_str()) return object_bytes;
+
+    const std::byte* content = object_bytes.data() + header_end + 1;
+    const size_t content_size = object_bytes.size() - header_end - 1;
+    const ObjectCodec* codec = select(content, content_size, path_hint);
+    if (!codec) return object_bytes;
+
+    // 2. 编码，并确认有体积收益且能逐字节还原
+    auto encoded = codec->encode(content, content_size);
+    if (!encoded || encoded->size() + sizeof(MAGIC) + 1 >= content_size) return object_bytes;
+    auto round_trip = codec->decode(encoded->data(), encoded->size());
+    if (!round_trip || round_trip->size() != content_size ||
+        !std::equal(round_trip->begin(), round_trip->end(), content)) {
+        std::cerr << "警告: " << codec->name() << " 编解码器往返校验失败，对象按原样存储。" << std::endl;
+        return object_bytes;
+    }
+
+    // 3. MAGIC + 编号 + 规范头部 + 编码内容
+    std::vector<std::byte> stored = make_stored_prefix(codec->id(), object_bytes, header_end, encoded->size());
+    stored.insert(stored.end(), encoded->begin(), encoded->end());
+    return stored;
+}
+
+std::optional<std::vector<std::byte>> decode_from_storage(const std::vector<std::byte>& stored_bytes, const std::filesystem::path& objects_dir) {
+    if (!has_magic(stored_bytes)) {
+        return stored_bytes;
+    }
+    const uint8_t codec_id = static_cast<uint8_t>(stored_bytes[sizeof(MAGIC)]);
+    const ObjectCodec* codec = find(codec_id);
+    if (!codec && codec_id != ZlibDictionaries::CODEC_ID) {
+        std::cerr << "错误: 对象使用了未知的编解码器 (编号 " << static_cast<int>(codec_id) << ")。" << std::endl;
+        return std::nullopt;
+    }
+    const size_t header_begin = sizeof(MAGIC) + 1;
+    const char* raw = reinterpret_cast<const char*>(stored_bytes.data());
+    size_t header_end = std::string_view(raw + header_begin, std::min<size_t>(stored_bytes.size() - header_begin, 64)).find('\0');
+    if (header_end == std::string_view::npos) return std::nullopt;
+    header_end += header_begin;
+    std::string_view header(raw + header_begin, header_end - header_begin);
+    const std::byte* encoded = stored_bytes.data() + header_end + 1;
+    const size_t encoded_size = stored_bytes.size() - header_end - 1;
+
+    std::optional<std::vector<std::byte>> content;
+    if (codec) {
+        content = codec->decode(encoded, encoded_size);
+        if (!content) {
+            std::cerr << "错误: " << codec->name() << " 编解码器无法还原对象内容 (数据损坏)。" << std::endl;
+            return std::nullopt;
+        }
+    } else { // 预设字典压缩：4 字节字典编号 + raw deflate 数据
+        if (encoded_size < 4) return std::nullopt;
+        uint32_t dictionary_id = 0;
+        for (size_t i = 0; i < 4; ++i) dictionary_id = (dictionary_id << 8) | static_cast<uint8_t>(encoded[i]);
+        auto dictionary = objects_dir.empty() ? nullptr : ZlibDictionaries::load(objects_dir, dictionary_id);
+        if (!dictionary) {
+            std::cerr << "错误: 找不到对象所用的字典 " << ZlibDictionaries::format_id(dictionary_id) << "。" << std::endl;
+            return std::nullopt;
+        }
+        size_t expected_size = 0;
+        try {
+            expected_size = std::stoul(std::string(header.substr(header.find(' ') + 1)));
+        } catch (const std::exception&) {
+            return std::nullopt;
+        }
+        content = ZlibDictionaries::inflate(dictionary.get(), encoded + 4, encoded_size - 4, expected_size);
+        if (!content) {
+            std::cerr << "错误: 无法以字典 " << ZlibDictionaries::format_id(dictionary_id) << " 还原对象内容 (数据损坏)。" << std::endl;
+            return std::nullopt;
+        }
+    }
+    if (header.substr(header.find(' ') + 1) != std::to_string(content->size())) {
+        std::cerr << "错误: 还原后的对象大小与头部不符。" << std::endl;
+        return std::nullopt;
+    }
+
+    std::vector<std::byte> object_bytes;
+    object_bytes.reserve(header.size() + 1 + content->size());
+    object_bytes.insert(object_bytes.end(), stored_bytes.begin() + static_cast<std::ptrdiff_t>(header_begin),
+                        stored_bytes.begin() + static_cast<std::ptrdiff_t>(header_end + 1));
+    object_bytes.insert(object_bytes.end(), content->begin(), content->end());
+    return object_bytes;
+}
+
+std::optional<std::vector<std::byte>> read_object_file(const std::filesystem::path& file_path) {
+    std::ifstream ifs(file_path, std::ios::binary | std::ios::ate);
+    if (!ifs.is_open()) {
+        return std::nullopt;
+    }
+    std::streamsize size = ifs.tellg();
+    if (size < 0) return std::nullopt;
+    ifs.seekg(0, std::ios::beg);
+    std::vector<std::byte> stored(static_cast<size_t>(size));
+    if (size > 0 && !ifs.read(reinterpret_cast<char*>(stored.data()), size)) {
+        return std::nullopt;
+    }
+    return decode_from_storage(stored, file_path.parent_path().parent_path());
+}
+
+}
+
+}
@@ -0,0 +1,119 @@
+#include "../include/ObjectFormat.h"
+#include "../include/sha1.h"
+#include "../include/sha256.h"
+#include "../include/blake3.h"
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+namespace Biogit {
+namespace ObjectFormat {
+
+namespace {
+
+/**
+ * @brief 对象目录 -> 算法 的进程内登记表 (服务器的多个会话共享)。
+ */
+struct FormatRegistry {
+    std::mutex mutex;
+    std::map<std::string, Algorithm> algorithms;
+};
+
+FormatRegistry& registry() {
+    static FormatRegistry instance;
+    return instance;
+}
+
+std::string directory_key(const std::filesystem::path& objects_dir) {
+    return objects_dir.lexically_normal().generic_string();
+}
+
+}
+
+
+const char* name(Algorithm algorithm) {
+    switch (algorithm) {
+        case Algorithm::SHA256: return "sha256";
+        case Algorithm::BLAKE3: return "blake3";
+        default: return "sha1";
+    }
+}
+
+std::optional<Algorithm> parse(const std::string& name) {
+    std::string lowered = name;
+    std::transform(lowered.begin(), lowered.end(), lowered.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (lowered == "sha1") return Algorithm::SHA1;
+    if (lowered == "sha256") return Algorithm::SHA256;
+    if (lowered == "blake3") return Algorithm::BLAKE3;
+    return std::nullopt;
+}
+
+size_t hex_length(Algorithm algorithm) {
+    return algorithm == Algorithm::SHA1 ? 40 : 64;
+}
+
+bool is_id_length(size_t length) {
+    return length == 40 || length == 64;
+}
+
+bool is_hex_id(const std::string& text) {
+    return is_id_length(text.length()) && std::all_of(text.begin(), text.end(), ::isxdigit);
+}
+
+void set_algorithm(const std::filesystem::path& objects_dir, Algorithm algorithm) {
+    FormatRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.algorithms[directory_key(objects_dir)] = algorithm;
+}
+
+std::optional<Algorithm> find_algorithm(const std::filesystem::path& objects_dir) {
+    FormatRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    auto it = reg.algorithms.find(directory_key(objects_dir));
+    if (it == reg.algorithms.end()) return std::nullopt;
+    return it->second;
+}
+
+Algorithm algorithm_of(const std::filesystem::path& objects_dir) {
+    std::optional<Algorithm> algorithm = find_algorithm(objects_dir);
+    if (!algorithm) {
+        // 按错误的算法计算哈希会把对象写到错误的文件名下，宁可立即失败
+        throw std::logic_error("object format of '" + objects_dir.string() + "' is not registered");
+    }
+    return *algorithm;
+}
+
+std::string hash(Algorithm algorithm, const std::vector<std::byte>& object_bytes) {
+    switch (algorithm) {
+        case Algorithm::SHA256: return SHA256::sha256(object_bytes);
+        case Algorithm::BLAKE3: return BLAKE3::blake3(object_bytes);
+        default: return SHA1::sha1(object_bytes);
+    }
+}
+
+std::string hash(const std::filesystem::path& objects_dir, const std::vector<std::byte>& object_bytes) {
+    return hash(algorithm_of(objects_dir), object_bytes);
+}
+
+
+Hasher::Hasher(Algorithm algorithm) {
+    switch (algorithm) {
+        case Algorithm::SHA256: state_.emplace<SHA256::Hasher>(); break;
+        case Algorithm::BLAKE3: state_.emplace<BLAKE3::Hasher>(); break;
+        default: state_.emplace<SHA1::Hasher>(); break;
+    }
+}
+
+void Hasher::update(const void* data, size_t length) {
+    std::visit([data, length](auto& hasher) { hasher.update(data, length); }, state_);
+}
+
+std::string Hasher::hex_digest() {
+    return std::visit([](auto& hasher) { return hasher.hex_digest(); }, state_);
+}
+
+}
+}
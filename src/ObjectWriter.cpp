@@ -0,0 +1,289 @@
+#include "../include/ObjectWriter.h"
+#include "../include/utils.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Biogit {
+namespace ObjectWriter {
+
+namespace {
+
+/**
+ * @brief 一个对象目录已打开的文件描述符。文件描述符在对象被淘汰且没有写入者使用时关闭。
+ */
+struct ObjectDirectory {
+    std::string path;
+    int dir_fd = -1;
+    std::mutex mutex;                                  ///< 保护 fanout_fds 的打开
+    std::array<int, 256> fanout_fds;                   ///< 扇出子目录 (-1 为尚未打开)
+    std::atomic<bool> unsynced{false};                 ///< batch 模式下是否有尚未 syncfs 的对象
+
+    ObjectDirectory() { fanout_fds.fill(-1); }
+    ~ObjectDirectory() {
+        for (int fd : fanout_fds) {
+            if (fd >= 0) ::close(fd);
+        }
+        if (dir_fd >= 0) ::close(dir_fd);
+    }
+};
+
+/**
+ * @brief 写入层的进程内状态 (服务器的多个会话共享)：最近使用的对象目录 (表头最新) 和各对象目录的持久化方式。
+ */
+struct WriterState {
+    std::mutex mutex;
+    std::list<std::shared_ptr<ObjectDirectory>> directories;
+    std::map<std::string, Durability> durabilities;
+    std::atomic<bool> tmpfile_unsupported{false};      ///< 文件系统不支持 O_TMPFILE 时不再尝试
+};
+
+WriterState& state() {
+    static WriterState instance;
+    return instance;
+}
+
+std::string directory_key(const std::filesystem::path& objects_dir) {
+    return objects_dir.lexically_normal().generic_string();
+}
+
+Durability durability_of(const std::string& key) {
+    WriterState& st = state();
+    std::lock_guard<std::mutex> lock(st.mutex);
+    auto it = st.durabilities.find(key);
+    return it != st.durabilities.end() ? it->second : Durability::NONE;
+}
+
+/**
+ * @brief 取得对象目录的缓存项 (不存在时打开对象目录并放入缓存，必要时淘汰最久未用的一项)。
+ */
+std::shared_ptr<ObjectDirectory> open_directory(const std::filesystem::path& objects_dir) {
+    const std::string key = directory_key(objects_dir);
+    WriterState& st = state();
+    {
+        std::lock_guard<std::mutex> lock(st.mutex);
+        for (auto it = st.directories.begin(); it != st.directories.end(); ++it) {
+            if ((*it)->path != key) continue;
+            st.directories.splice(st.directories.begin(), st.directories, it);
+            return st.directories.front();
+        }
+    }
+
+    int dir_fd = ::open(key.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0 && errno == ENOENT) {
+        std::error_code ec;
+        std::filesystem::create_directories(key, ec);
+        dir_fd = ::open(key.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    }
+    if (dir_fd < 0) {
+        std::cerr << "错误: 无法打开对象目录 '" << key << "': " << std::strerror(errno) << std::endl;
+        return nullptr;
+    }
+    auto directory = std::make_shared<ObjectDirectory>();
+    directory->path = key;
+    directory->dir_fd = dir_fd;
+
+    std::shared_ptr<ObjectDirectory> evicted;
+    {
+        std::lock_guard<std::mutex> lock(st.mutex);
+        for (const auto& existing : st.directories) {
+            if (existing->path == key) return existing; // 其他线程已先打开 (本线程打开的在析构时关闭)
+        }
+        st.directories.push_front(directory);
+        if (st.directories.size() > MAX_CACHED_DIRS) {
+            evicted = st.directories.back();
+            st.directories.pop_back();
+        }
+    }
+    // 被淘汰的对象目录还有未刷盘的对象时立即刷盘，之后的 sync() 找不到它
+    if (evicted && evicted->unsynced.exchange(false)) ::syncfs(evicted->dir_fd);
+    return directory;
+}
+
+/**
+ * @brief 扇出子目录的文件描述符 (不存在时创建)。
+ */
+int fanout_fd(ObjectDirectory& directory, const std::string& fanout_name) {
+    const size_t slot = static_cast<size_t>(std::stoul(fanout_name, nullptr, 16));
+    std::lock_guard<std::mutex> lock(directory.mutex);
+    if (directory.fanout_fds[slot] >= 0) return directory.fanout_fds[slot];
+
+    int fd = ::openat(directory.dir_fd, fanout_name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0 && errno == ENOENT) {
+        if (::mkdirat(directory.dir_fd, fanout_name.c_str(), 0755) != 0 && errno != EEXIST) {
+            std::cerr << "错误: 无法创建对象子目录 '" << directory.path << "/" << fanout_name << "': "
+                      << std::strerror(errno) << std::endl;
+            return -1;
+        }
+        fd = ::openat(directory.dir_fd, fanout_name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    }
+    if (fd < 0) {
+        std::cerr << "错误: 无法打开对象子目录 '" << directory.path << "/" << fanout_name << "': "
+                  << std::strerror(errno) << std::endl;
+        return -1;
+    }
+    directory.fanout_fds[slot] = fd;
+    return fd;
+}
+
+bool write_all(int fd, const std::vector<std::byte>& bytes) {
+    const char* data = reinterpret_cast<const char*>(bytes.data());
+    size_t remaining = bytes.size();
+    while (remaining > 0) {
+        ssize_t written = ::write(fd, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+/**
+ * @brief 写完内容后按持久化方式刷盘 (EACH) 或发起回写 (BATCH)。
+ */
+bool flush_file(int fd, Durability durability) {
+    if (durability == Durability::EACH) return ::fdatasync(fd) == 0;
+#ifdef SYNC_FILE_RANGE_WRITE
+    if (durability == Durability::BATCH) ::sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE); // 只是提前开始回写，失败无妨
+#endif
+    return true;
+}
+
+/**
+ * @brief 写入唯一命名的临时文件，再 renameat 为对象文件名 (已存在时原子替换)。
+ */
+bool write_renamed(ObjectDirectory& directory, int dir_fd, const std::string& file_name, const std::string& display_path,
+                   const std::vector<std::byte>& stored_bytes, Durability durability) {
+    const std::string temp_name = Utils::unique_temp_path(file_name).filename().string();
+    int fd = ::openat(dir_fd, temp_name.c_str(), O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC, 0444);
+    if (fd < 0) {
+        std::cerr << "错误: 无法创建对象临时文件 '" << display_path << "': " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    bool written = write_all(fd, stored_bytes) && flush_file(fd, durability);
+    const int write_errno = errno;
+    ::close(fd);
+    if (!written || ::renameat(dir_fd, temp_name.c_str(), dir_fd, file_name.c_str()) != 0) {
+        std::cerr << "错误: 写入对象文件 '" << display_path << "' 失败: " << std::strerror(written ? errno : write_errno) << std::endl;
+        ::unlinkat(dir_fd, temp_name.c_str(), 0);
+        return false;
+    }
+    if (durability == Durability::BATCH) directory.unsynced = true;
+    return true;
+}
+
+}
+
+
+Durability parse_durability(const std::optional<std::string>& value) {
+    if (!value) return Durability::NONE;
+    std::string lowered = *value;
+    std::transform(lowered.begin(), lowered.end(), lowered.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (lowered == "batch") return Durability::BATCH;
+    if (lowered == "true" || lowered == "yes" || lowered == "on" || lowered == "1") return Durability::EACH;
+    return Durability::NONE;
+}
+
+void set_durability(const std::filesystem::path& objects_dir, Durability durability) {
+    WriterState& st = state();
+    std::lock_guard<std::mutex> lock(st.mutex);
+    st.durabilities[directory_key(objects_dir)] = durability;
+}
+
+
+bool write(const std::filesystem::path& objects_dir, const std::string& hash_hex, const std::vector<std::byte>& stored_bytes) {
+    // 1. 对象目录和扇出子目录 (文件描述符已缓存时不再访问文件系统)
+    std::shared_ptr<ObjectDirectory> directory = open_directory(objects_dir);
+    if (!directory) return false;
+    const int dir_fd = fanout_fd(*directory, hash_hex.substr(0, 2));
+    if (dir_fd < 0) return false;
+    const std::string file_name = hash_hex.substr(2);
+    const Durability durability = durability_of(directory->path);
+    const std::string display_path = directory->path + "/" + hash_hex.substr(0, 2) + "/" + file_name;
+
+    // 2. 匿名临时文件：写完后 linkat 赋予文件名 (已存在即成功)
+    WriterState& st = state();
+    if (!st.tmpfile_unsupported.load(std::memory_order_relaxed)) {
+        int fd = ::openat(dir_fd, ".", O_TMPFILE | O_WRONLY | O_CLOEXEC, 0444);
+        if (fd >= 0) {
+            if (!write_all(fd, stored_bytes) || !flush_file(fd, durability)) {
+                std::cerr << "错误: 写入对象文件 '" << display_path << "' 失败: " << std::strerror(errno) << std::endl;
+                ::close(fd);
+                return false;
+            }
+            const std::string proc_path = "/proc/self/fd/" + std::to_string(fd);
+            int link_result = ::linkat(AT_FDCWD, proc_path.c_str(), dir_fd, file_name.c_str(), AT_SYMLINK_FOLLOW);
+            const int link_errno = errno;
+            ::close(fd);
+            if (link_result == 0 || link_errno == EEXIST) {
+                if (durability == Durability::BATCH) directory->unsynced = true;
+                return true;
+            }
+            if (link_errno != ENOENT) {
+                std::cerr << "错误: 无法创建对象文件 '" << display_path << "': " << std::strerror(link_errno) << std::endl;
+                return false;
+            }
+            st.tmpfile_unsupported = true; // 没有挂载 /proc，无法给匿名文件命名
+        } else if (errno == EOPNOTSUPP || errno == EISDIR || errno == EINVAL) {
+            st.tmpfile_unsupported = true; // 内核或文件系统不支持 O_TMPFILE
+        } else {
+            std::cerr << "错误: 无法创建对象临时文件于 '" << directory->path << "/" << hash_hex.substr(0, 2) << "': "
+                      << std::strerror(errno) << std::endl;
+            return false;
+        }
+    }
+
+    // 3. 回退：唯一命名的临时文件 + renameat (内容相同，覆盖并发写入者的同名对象也无妨)
+    return write_renamed(*directory, dir_fd, file_name, display_path, stored_bytes, durability);
+}
+
+
+bool rewrite(const std::filesystem::path& objects_dir, const std::string& hash_hex, const std::vector<std::byte>& stored_bytes) {
+    std::shared_ptr<ObjectDirectory> directory = open_directory(objects_dir);
+    if (!directory) return false;
+    const int dir_fd = fanout_fd(*directory, hash_hex.substr(0, 2));
+    if (dir_fd < 0) return false;
+    const std::string file_name = hash_hex.substr(2);
+    const std::string display_path = directory->path + "/" + hash_hex.substr(0, 2) + "/" + file_name;
+    return write_renamed(*directory, dir_fd, file_name, display_path, stored_bytes, durability_of(directory->path));
+}
+
+
+bool sync(const std::filesystem::path& objects_dir) {
+    const std::string key = directory_key(objects_dir);
+    std::shared_ptr<ObjectDirectory> directory;
+    {
+        WriterState& st = state();
+        std::lock_guard<std::mutex> lock(st.mutex);
+        for (const auto& entry : st.directories) {
+            if (entry->path == key) directory = entry;
+        }
+    }
+    // 缓存项已被淘汰时，淘汰时已经刷过盘
+    if (!directory || !directory->unsynced.exchange(false)) return true;
+    if (::syncfs(directory->dir_fd) != 0) {
+        std::cerr << "错误: 无法把对象刷到磁盘 (" << key << "): " << std::strerror(errno) << std::endl;
+        directory->unsynced = true;
+        return false;
+    }
+    return true;
+}
+
+}
+}
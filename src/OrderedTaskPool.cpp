@@ -0,0 +1,110 @@
+#include "../include/OrderedTaskPool.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace Biogit {
+
+namespace {
+
+/**
+ * @brief 执行单个任务，捕获其异常。
+ */
+void run_task_guarded(const OrderedTaskPool::Task& task, std::ostream& out) {
+    try {
+        task(out);
+    } catch (const std::exception& e) {
+        std::cerr << "错误: 并行任务执行失败: " << e.what() << std::endl;
+    }
+}
+
+}
+
+OrderedTaskPool::OrderedTaskPool(size_t num_threads, size_t max_buffered)
+    : num_threads_(num_threads), max_buffered_(max_buffered) {
+    if (num_threads_ == 0) {
+        num_threads_ = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    if (max_buffered_ == 0) {
+        max_buffered_ = num_threads_ * 4;
+    }
+    max_buffered_ = std::max(max_buffered_, num_threads_);
+}
+
+void OrderedTaskPool::run(const std::vector<Task>& tasks, std::ostream& out) const {
+    const size_t worker_count = std::min(num_threads_, tasks.size());
+    if (worker_count <= 1) { // 无需并行：直接按顺序执行并写入目标流
+        for (const auto& task : tasks) {
+            run_task_guarded(task, out);
+        }
+        return;
+    }
+
+    // 环形缓冲区：任务 i 的结果存放在 slots[i % window]
+    const size_t window = max_buffered_;
+    std::vector<std::string> slots(window);
+    std::vector<bool> ready(window, false);
+
+    std::mutex mutex;
+    std::condition_variable result_ready_cv; // 通知调用线程：有结果完成
+    std::condition_variable slot_free_cv;    // 通知工作线程：有空闲槽位
+    size_t next_task = 0;                    // 下一个待领取的任务
+    size_t next_output = 0;                  // 下一个待输出的任务
+
+    auto worker = [&]() {
+        while (true) {
+            size_t task_index;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                // 领取任务前等待窗口中有空位，限制已完成但未输出的结果数量
+                slot_free_cv.wait(lock, [&]() {
+                    return next_task >= tasks.size() || next_task < next_output + window;
+                });
+                if (next_task >= tasks.size()) return;
+                task_index = next_task++;
+            }
+
+            std::ostringstream buffer;
+            run_task_guarded(tasks[task_index], buffer);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                slots[task_index % window] = buffer.str();
+                ready[task_index % window] = true;
+            }
+            result_ready_cv.notify_one();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers.emplace_back(worker);
+    }
+
+    // 调用线程按顺序输出
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        std::string result;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            result_ready_cv.wait(lock, [&]() { return ready[i % window]; });
+            result.swap(slots[i % window]);
+            ready[i % window] = false;
+            ++next_output;
+        }
+        slot_free_cv.notify_all();
+        out << result;
+    }
+    out.flush();
+
+    for (auto& thread : workers) {
+        thread.join();
+    }
+}
+
+}
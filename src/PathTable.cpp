@@ -0,0 +1,138 @@
+#include "../include/PathTable.h"
+
+#include <cstring>
+
+namespace Biogit {
+
+namespace {
+
+/// 依次取出 '/' 分隔的路径组件 (跳过空组件和 ".")，对每个组件调用 visit；visit 返回 false 时停止
+template <typename Visitor>
+bool for_each_component(std::string_view relative_path, Visitor&& visit) {
+    size_t begin = 0;
+    while (begin <= relative_path.size()) {
+        size_t end = relative_path.find('/', begin);
+        if (end == std::string_view::npos) end = relative_path.size();
+        std::string_view component = relative_path.substr(begin, end - begin);
+        if (!component.empty() && component != "." && !visit(component)) return false;
+        begin = end + 1;
+    }
+    return true;
+}
+
+}
+
+
+PathTable::PathTable() {
+    nodes_.push_back({ROOT, 0, std::string_view()});
+}
+
+PathTable::PathTable(const PathTable& other) : PathTable() {
+    *this = other;
+}
+
+PathTable& PathTable::operator=(const PathTable& other) {
+    if (this == &other) return *this;
+    clear();
+    nodes_.reserve(other.nodes_.size());
+    children_.reserve(other.children_.size());
+    // 父节点的 ID 总是小于子节点，按 ID 顺序重新驻留即可得到相同的 ID
+    for (size_t id = 1; id < other.nodes_.size(); ++id) {
+        intern_child(other.nodes_[id].parent, other.nodes_[id].name);
+    }
+    return *this;
+}
+
+std::string_view PathTable::store_name_(std::string_view name) {
+    if (name.size() > BLOCK_SIZE) { // 超长名称单独一块，插在最后一块之前以免浪费当前块的剩余空间
+        auto block = std::make_unique<char[]>(name.size());
+        std::memcpy(block.get(), name.data(), name.size());
+        std::string_view stored(block.get(), name.size());
+        blocks_.insert(blocks_.empty() ? blocks_.end() : blocks_.end() - 1, std::move(block));
+        return stored;
+    }
+    if (BLOCK_SIZE - block_used_ < name.size()) {
+        blocks_.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+        block_used_ = 0;
+    }
+    char* destination = blocks_.back().get() + block_used_;
+    std::memcpy(destination, name.data(), name.size());
+    block_used_ += name.size();
+    return std::string_view(destination, name.size());
+}
+
+PathTable::PathId PathTable::intern_child(PathId parent, std::string_view name) {
+    auto it = children_.find(ChildKey{parent, name});
+    if (it != children_.end()) return it->second;
+
+    const PathId id = static_cast<PathId>(nodes_.size());
+    std::string_view stored_name = store_name_(name);
+    nodes_.push_back({parent, nodes_[parent].depth + 1, stored_name});
+    children_.emplace(ChildKey{parent, stored_name}, id);
+    return id;
+}
+
+PathTable::PathId PathTable::intern(std::string_view relative_path) {
+    PathId current = ROOT;
+    for_each_component(relative_path, [&](std::string_view component) {
+        current = intern_child(current, component);
+        return true;
+    });
+    return current;
+}
+
+std::optional<PathTable::PathId> PathTable::find(std::string_view relative_path) const {
+    PathId current = ROOT;
+    bool found = for_each_component(relative_path, [&](std::string_view component) {
+        auto it = children_.find(ChildKey{current, component});
+        if (it == children_.end()) return false;
+        current = it->second;
+        return true;
+    });
+    if (!found) return std::nullopt;
+    return current;
+}
+
+bool PathTable::less(PathId a, PathId b) const {
+    if (a == b) return false;
+    // 1. 把较深的一方上移到相同深度；相遇说明一方是另一方的祖先，祖先在前
+    PathId x = a, y = b;
+    while (nodes_[x].depth > nodes_[y].depth) x = nodes_[x].parent;
+    while (nodes_[y].depth > nodes_[x].depth) y = nodes_[y].parent;
+    if (x == y) return nodes_[a].depth < nodes_[b].depth;
+
+    // 2. 同时上移到共同父目录之下，按该层的名称比较
+    while (nodes_[x].parent != nodes_[y].parent) {
+        x = nodes_[x].parent;
+        y = nodes_[y].parent;
+    }
+    return nodes_[x].name < nodes_[y].name;
+}
+
+std::string PathTable::generic_string(PathId id) const {
+    size_t length = 0;
+    for (PathId current = id; current != ROOT; current = nodes_[current].parent) {
+        length += nodes_[current].name.size() + 1;
+    }
+    if (length == 0) return std::string();
+
+    std::string result(length - 1, '/');
+    size_t end = result.size();
+    for (PathId current = id; current != ROOT; current = nodes_[current].parent) {
+        std::string_view component = nodes_[current].name;
+        end -= component.size();
+        std::memcpy(result.data() + end, component.data(), component.size());
+        if (end > 0) --end; // 跳过分隔符
+    }
+    return result;
+}
+
+void PathTable::clear() {
+    nodes_.clear();
+    nodes_.push_back({ROOT, 0, std::string_view()});
+    children_.clear();
+    blocks_.clear();
+    block_used_ = BLOCK_SIZE;
+}
+
+}
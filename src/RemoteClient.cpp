@@ -443,7 +443,13 @@ uint16_t RemoteClient::GetObject(const std::string& token, const std::string& ob
         return Protocol::MSG_RESP_ERROR;
     }
 
-    std::vector<char> payload_with_token = buildPayloadWithToken(token, object_hash.data(), static_cast<uint32_t>(object_hash.length()));
+    // 已协商字典时附带字典编号，服务器可以压缩返回小型 Tree/Commit
+    std::string original_payload_go = object_hash;
+    if (_wire_dictionary) {
+        original_payload_go.resize(40 + 4);
+        Protocol::pack_u32(original_payload_go.data() + 40, _wire_dictionary->id);
+    }
+    std::vector<char> payload_with_token = buildPayloadWithToken(token, original_payload_go.data(), static_cast<uint32_t>(original_payload_go.length()));
     SendNode request(payload_with_token.data(), static_cast<uint32_t>(payload_with_token.size()), Protocol::MSG_REQ_GET_OBJECT); //
 
     uint16_t response_id;
@@ -462,6 +468,24 @@ uint16_t RemoteClient::GetObject(const std::string& token, const std::string& ob
                 std::cerr << "RemoteClient Error (GetObject): OBJECT_CONTENT response too short." << std::endl;
                 return Protocol::MSG_RESP_ERROR;
             }
+        } else if (response_id == Protocol::MSG_RESP_OBJECT_CONTENT_DEFLATED) {
+            // <hash40><dict_id><raw_length><deflate_data>：用协商的字典还原为对象的完整原始内容
+            if (response_body.size() < 48 || !_wire_dictionary ||
+                Protocol::unpack_u32(response_body.data() + 40) != _wire_dictionary->id) {
+                std::cerr << "RemoteClient Error (GetObject): Unexpected OBJECT_CONTENT_DEFLATED response." << std::endl;
+                return Protocol::MSG_RESP_ERROR;
+            }
+            uint32_t raw_length = Protocol::unpack_u32(response_body.data() + 44);
+            auto inflated = ZlibDictionaries::inflate(_wire_dictionary.get(), reinterpret_cast<const std::byte*>(response_body.data() + 48),
+                                                      response_body.size() - 48, raw_length);
+            if (!inflated) {
+                std::cerr << "RemoteClient Error (GetObject): Failed to inflate object content." << std::endl;
+                return Protocol::MSG_RESP_ERROR;
+            }
+            out_received_object_hash_from_server.assign(response_body.data(), 40);
+            out_object_raw_content.assign(reinterpret_cast<const char*>(inflated->data()),
+                                          reinterpret_cast<const char*>(inflated->data()) + inflated->size());
+            return Protocol::MSG_RESP_OBJECT_CONTENT;
         } else if (response_id == Protocol::MSG_RESP_OBJECT_NOT_FOUND) {
             if (response_body.size() == 40) { // 响应体是被请求的哈希
                 out_received_object_hash_from_server.assign(response_body.data(), 40);
@@ -539,12 +563,26 @@ bool RemoteClient::PutObject(const std::string& token, const std::string& object
     std::vector<char> original_payload_po;
     original_payload_po.reserve(40 + data_length);
     original_payload_po.insert(original_payload_po.end(), object_hash.begin(), object_hash.end());
-    if (data_length > 0) {
+    uint16_t request_id = Protocol::MSG_REQ_PUT_OBJECT;
+
+    // 已协商字典时，小型 Tree/Commit 压缩后上传: <hash40><dict_id><raw_length><deflate_data>
+    std::optional<std::vector<std::byte>> deflated;
+    if (_wire_dictionary && ZlibDictionaries::applies_to_object(raw_data, data_length)) {
+        deflated = ZlibDictionaries::deflate(_wire_dictionary.get(), reinterpret_cast<const std::byte*>(raw_data), data_length);
+    }
+    if (deflated && deflated->size() + 8 < data_length) {
+        original_payload_po.resize(40 + 8);
+        Protocol::pack_u32(original_payload_po.data() + 40, _wire_dictionary->id);
+        Protocol::pack_u32(original_payload_po.data() + 44, data_length);
+        const char* deflated_data = reinterpret_cast<const char*>(deflated->data());
+        original_payload_po.insert(original_payload_po.end(), deflated_data, deflated_data + deflated->size());
+        request_id = Protocol::MSG_REQ_PUT_OBJECT_DEFLATED;
+    } else if (data_length > 0) {
         original_payload_po.insert(original_payload_po.end(), raw_data, raw_data + data_length);
     }
 
     std::vector<char> payload_with_token = buildPayloadWithToken(token, original_payload_po.data(), static_cast<uint32_t>(original_payload_po.size()));
-    SendNode request(payload_with_token.data(), static_cast<uint32_t>(payload_with_token.size()), Protocol::MSG_REQ_PUT_OBJECT); //
+    SendNode request(payload_with_token.data(), static_cast<uint32_t>(payload_with_token.size()), request_id); //
 
     uint16_t response_id;
     std::vector<char> response_body;
@@ -570,6 +608,216 @@ bool RemoteClient::PutObject(const std::string& token, const std::string& object
     return PutObject(token, object_hash, raw_object_data_vec.data(), static_cast<uint32_t>(raw_object_data_vec.size()));
 }
 
+
+/**
+ * @brief 上传对象相对服务器已有对象的二进制增量 (MSG_REQ_PUT_OBJECT_DELTA)。
+ * 载荷格式: <40_char_sha1_hash><40_char_base_sha1_hash><delta_data>
+ * @return 服务器还原并校验成功返回 true；基准不存在 (MSG_RESP_OBJECT_NOT_FOUND)、服务器不支持或校验失败返回 false。
+ */
+bool RemoteClient::PutObjectDelta(const std::string& token, const std::string& object_hash, const std::string& base_hash,
+                                  const std::vector<std::byte>& delta) {
+    if (object_hash.length() != 40 || base_hash.length() != 40) { std::cerr << "RemoteClient Error (PutObjectDelta): Invalid hash length." << std::endl; return false; }
+
+    std::vector<char> original_payload;
+    original_payload.reserve(80 + delta.size());
+    original_payload.insert(original_payload.end(), object_hash.begin(), object_hash.end());
+    original_payload.insert(original_payload.end(), base_hash.begin(), base_hash.end());
+    const char* delta_data = reinterpret_cast<const char*>(delta.data());
+    original_payload.insert(original_payload.end(), delta_data, delta_data + delta.size());
+
+    std::vector<char> payload_with_token = buildPayloadWithToken(token, original_payload.data(), static_cast<uint32_t>(original_payload.size()));
+    SendNode request(payload_with_token.data(), static_cast<uint32_t>(payload_with_token.size()), Protocol::MSG_REQ_PUT_OBJECT_DELTA);
+
+    uint16_t response_id;
+    std::vector<char> response_body;
+    if (!SendAndReceive(request, response_id, response_body, "PUT_OBJECT_DELTA")) return false;
+    if (response_id == Protocol::MSG_RESP_AUTH_REQUIRED) { std::cerr << "RemoteClient: Auth required for PutObjectDelta." << std::endl; return false; }
+    return response_id == Protocol::MSG_RESP_ACK_OK;
+}
+
+/**
+ * @brief 向服务器发送 MSG_REQ_LFS_CHECK 消息，询问哪些大文件内容已在服务器内容库中。
+ * @param token 认证 Token。
+ * @param oids_to_check 要检查的内容 oid 列表。
+ * @param out_existence_results 输出参数，每个有效 oid 的存在状态。
+ * @return 如果成功收到并解析了检查结果，返回 true。
+ */
+bool RemoteClient::CheckLfsObjects(const std::string& token, const std::vector<std::string>& oids_to_check,
+                                   std::vector<ObjectExistenceStatus>& out_existence_results) {
+    out_existence_results.clear();
+    if (oids_to_check.empty()) return true;
+
+    std::vector<std::string> valid_oids;
+    for (const auto& oid : oids_to_check) {
+        if (oid.length() == 40 && std::all_of(oid.begin(), oid.end(), ::isxdigit)) valid_oids.push_back(oid);
+    }
+    if (valid_oids.empty()) return false;
+
+    // 服务器每条消息最多接受 MAX_LFS_CHECK_OIDS 个 oid，超过时分批询问
+    out_existence_results.reserve(valid_oids.size());
+    for (size_t begin = 0; begin < valid_oids.size(); begin += Protocol::MAX_LFS_CHECK_OIDS) {
+        const size_t end = std::min(valid_oids.size(), begin + Protocol::MAX_LFS_CHECK_OIDS);
+        std::vector<char> original_payload(sizeof(uint32_t));
+        original_payload.reserve(sizeof(uint32_t) + 40 * (end - begin));
+        for (size_t i = begin; i < end; ++i) original_payload.insert(original_payload.end(), valid_oids[i].begin(), valid_oids[i].end());
+        uint32_t num_oids_net = boost::asio::detail::socket_ops::host_to_network_long(static_cast<uint32_t>(end - begin));
+        std::memcpy(original_payload.data(), &num_oids_net, sizeof(uint32_t));
+
+        std::vector<char> payload_with_token = buildPayloadWithToken(token, original_payload.data(), static_cast<uint32_t>(original_payload.size()));
+        SendNode request(payload_with_token.data(), static_cast<uint32_t>(payload_with_token.size()), Protocol::MSG_REQ_LFS_CHECK);
+
+        uint16_t response_id;
+        std::vector<char> response_body;
+        if (!SendAndReceive(request, response_id, response_body, "LFS_CHECK")) return false;
+        if (response_id == Protocol::MSG_RESP_AUTH_REQUIRED) { std::cerr << "RemoteClient: Auth required for CheckLfsObjects." << std::endl; return false; }
+        if (response_id != Protocol::MSG_RESP_CHECK_OBJECTS_RESULT) return false;
+        if (response_body.size() != sizeof(uint32_t) + (end - begin)) return false;
+        for (size_t i = begin; i < end; ++i) {
+            out_existence_results.push_back({valid_oids[i], (response_body[sizeof(uint32_t) + (i - begin)] == 0x01)});
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 向服务器发送 MSG_REQ_LFS_PUT_BLOCK 消息，上传大文件内容的一个数据块。
+ * @param token 认证 Token。
+ * @param oid 内容的40位哈希。
+ * @param offset 本块在内容中的起始偏移 (必须等于服务器已接收的字节数，或为 0 表示重新开始)。
+ * @param total_size 内容的总字节数。
+ * @param block_data 本块数据。
+ * @param block_length 本块长度。
+ * @return 如果服务器确认接收 (MSG_RESP_ACK_OK)，返回 true。
+ */
+bool RemoteClient::PutLfsBlock(const std::string& token, const std::string& oid, uint64_t offset, uint64_t total_size,
+                               const char* block_data, uint32_t block_length) {
+    if (oid.length() != 40) { std::cerr << "RemoteClient Error (PutLfsBlock): Invalid oid length." << std::endl; return false; }
+
+    std::vector<char> original_payload(40 + 8 + 8);
+    std::memcpy(original_payload.data(), oid.data(), 40);
+    Protocol::pack_u64(original_payload.data() + 40, offset);
+    Protocol::pack_u64(original_payload.data() + 48, total_size);
+    if (block_length > 0) {
+        original_payload.insert(original_payload.end(), block_data, block_data + block_length);
+    }
+
+    std::vector<char> payload_with_token = buildPayloadWithToken(token, original_payload.data(), static_cast<uint32_t>(original_payload.size()));
+    SendNode request(payload_with_token.data(), static_cast<uint32_t>(payload_with_token.size()), Protocol::MSG_REQ_LFS_PUT_BLOCK);
+
+    uint16_t response_id;
+    std::vector<char> response_body;
+    if (SendAndReceive(request, response_id, response_body, "LFS_PUT_BLOCK")) {
+        if (response_id == Protocol::MSG_RESP_AUTH_REQUIRED) { std::cerr << "RemoteClient: Auth required for PutLfsBlock." << std::endl; return false; }
+        if (response_id == Protocol::MSG_RESP_ACK_OK) return true;
+        if (response_id == Protocol::MSG_RESP_ERROR) {
+            std::cerr << "RemoteClient Error (PutLfsBlock): " << std::string(response_body.begin(), response_body.end()) << std::endl;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 向服务器发送 MSG_REQ_LFS_GET_BLOCK 消息，下载大文件内容从 offset 开始的一个数据块。
+ * @param token 认证 Token。
+ * @param oid 内容的40位哈希。
+ * @param offset 请求的起始偏移。
+ * @param out_total_size 输出参数，内容的总字节数。
+ * @param out_block_data 输出参数，本块数据 (为空表示已到达末尾)。
+ * @return 如果收到 MSG_RESP_LFS_BLOCK，返回 true；服务器没有该内容或通信失败时返回 false。
+ */
+bool RemoteClient::GetLfsBlock(const std::string& token, const std::string& oid, uint64_t offset,
+                               uint64_t& out_total_size, std::vector<char>& out_block_data) {
+    out_total_size = 0;
+    out_block_data.clear();
+    if (oid.length() != 40) { std::cerr << "RemoteClient Error (GetLfsBlock): Invalid oid length." << std::endl; return false; }
+
+    std::vector<char> original_payload(40 + 8);
+    std::memcpy(original_payload.data(), oid.data(), 40);
+    Protocol::pack_u64(original_payload.data() + 40, offset);
+
+    std::vector<char> payload_with_token = buildPayloadWithToken(token, original_payload.data(), static_cast<uint32_t>(original_payload.size()));
+    SendNode request(payload_with_token.data(), static_cast<uint32_t>(payload_with_token.size()), Protocol::MSG_REQ_LFS_GET_BLOCK);
+
+    uint16_t response_id;
+    std::vector<char> response_body;
+    if (SendAndReceive(request, response_id, response_body, "LFS_GET_BLOCK")) {
+        if (response_id == Protocol::MSG_RESP_AUTH_REQUIRED) { std::cerr << "RemoteClient: Auth required for GetLfsBlock." << std::endl; return false; }
+        if (response_id == Protocol::MSG_RESP_LFS_BLOCK && response_body.size() >= 56 &&
+            std::string(response_body.data(), 40) == oid && Protocol::unpack_u64(response_body.data() + 40) == offset) {
+            out_total_size = Protocol::unpack_u64(response_body.data() + 48);
+            out_block_data.assign(response_body.begin() + 56, response_body.end());
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 向服务器发送 MSG_REQ_DICT_NEGOTIATE 消息，协商小对象传输使用的预设字典。
+ * @param token 认证 Token。
+ * @param local_dictionary_ids 本地已有的字典编号 (当前字典在前)。
+ * @param out_selected_id 输出参数，双方都有的字典编号 (0 表示不使用字典)。
+ * @param out_server_current_id 输出参数，服务器的当前字典编号 (0 表示服务器没有字典)。
+ * @return 如果收到 MSG_RESP_DICT_SELECTED，返回 true。
+ */
+bool RemoteClient::NegotiateDictionary(const std::string& token, const std::vector<uint32_t>& local_dictionary_ids,
+                                       uint32_t& out_selected_id, uint32_t& out_server_current_id) {
+    out_selected_id = 0;
+    out_server_current_id = 0;
+
+    std::vector<char> original_payload(4 + 4 * local_dictionary_ids.size());
+    Protocol::pack_u32(original_payload.data(), static_cast<uint32_t>(local_dictionary_ids.size()));
+    for (size_t i = 0; i < local_dictionary_ids.size(); ++i) {
+        Protocol::pack_u32(original_payload.data() + 4 + 4 * i, local_dictionary_ids[i]);
+    }
+
+    std::vector<char> payload_with_token = buildPayloadWithToken(token, original_payload.data(), static_cast<uint32_t>(original_payload.size()));
+    SendNode request(payload_with_token.data(), static_cast<uint32_t>(payload_with_token.size()), Protocol::MSG_REQ_DICT_NEGOTIATE);
+
+    uint16_t response_id;
+    std::vector<char> response_body;
+    if (SendAndReceive(request, response_id, response_body, "DICT_NEGOTIATE")) {
+        if (response_id == Protocol::MSG_RESP_AUTH_REQUIRED) { std::cerr << "RemoteClient: Auth required for NegotiateDictionary." << std::endl; return false; }
+        if (response_id == Protocol::MSG_RESP_DICT_SELECTED && response_body.size() == 8) {
+            out_selected_id = Protocol::unpack_u32(response_body.data());
+            out_server_current_id = Protocol::unpack_u32(response_body.data() + 4);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 向服务器发送 MSG_REQ_DICT_GET 消息，下载一个预设字典。
+ * @param token 认证 Token。
+ * @param dictionary_id 字典编号。
+ * @param out_dictionary_data 输出参数，字典内容 (已校验内容与编号一致)。
+ * @return 如果收到并校验了字典内容，返回 true。
+ */
+bool RemoteClient::GetDictionary(const std::string& token, uint32_t dictionary_id, std::vector<std::byte>& out_dictionary_data) {
+    out_dictionary_data.clear();
+    char original_payload[4];
+    Protocol::pack_u32(original_payload, dictionary_id);
+
+    std::vector<char> payload_with_token = buildPayloadWithToken(token, original_payload, sizeof(original_payload));
+    SendNode request(payload_with_token.data(), static_cast<uint32_t>(payload_with_token.size()), Protocol::MSG_REQ_DICT_GET);
+
+    uint16_t response_id;
+    std::vector<char> response_body;
+    if (SendAndReceive(request, response_id, response_body, "DICT_GET")) {
+        if (response_id == Protocol::MSG_RESP_AUTH_REQUIRED) { std::cerr << "RemoteClient: Auth required for GetDictionary." << std::endl; return false; }
+        if (response_id == Protocol::MSG_RESP_DICT_CONTENT && response_body.size() > 4 &&
+            Protocol::unpack_u32(response_body.data()) == dictionary_id) {
+            out_dictionary_data.resize(response_body.size() - 4);
+            std::memcpy(out_dictionary_data.data(), response_body.data() + 4, out_dictionary_data.size());
+            if (ZlibDictionaries::compute_id(out_dictionary_data) == dictionary_id) return true;
+            std::cerr << "RemoteClient Error (GetDictionary): Dictionary content does not match its id." << std::endl;
+            out_dictionary_data.clear();
+        }
+    }
+    return false;
+}
+
 /**
  * @brief 向服务器发送 MSG_REQ_UPDATE_REF 消息。
  * 此方法现在需要认证 Token。
@@ -0,0 +1,273 @@
+#include "../include/RenameDetector.h"
+#include "../include/object.h"
+
+#include <algorithm>
+#include <iostream>
+#include <set>
+#include <unordered_map>
+
+namespace Biogit {
+
+namespace {
+
+constexpr size_t MAX_CHUNK_BYTES = 64; // 单个内容块的最大长度 (过长的行被切成多块)
+
+/**
+ * @brief 64 位整数混合函数 (splitmix64 的终结步骤)。
+ */
+uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * @brief 将内容切分为块并返回块哈希的多重集合 (每个块哈希与其出现次数组合，使重复行仍可区分)。
+ */
+std::vector<uint64_t> chunk_hashes(const std::string& content) {
+    std::vector<uint64_t> elements;
+    std::unordered_map<uint64_t, uint64_t> occurrences;
+
+    uint64_t hash = 14695981039346656037ULL;
+    size_t chunk_len = 0;
+    auto finish_chunk = [&]() {
+        if (chunk_len == 0) return;
+        uint64_t nth = occurrences[hash]++;
+        elements.push_back(mix64(hash ^ mix64(nth + 1)));
+        hash = 14695981039346656037ULL;
+        chunk_len = 0;
+    };
+
+    for (unsigned char c : content) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+        ++chunk_len;
+        if (c == '\n' || chunk_len >= MAX_CHUNK_BYTES) {
+            finish_chunk();
+        }
+    }
+    finish_chunk();
+    return elements;
+}
+
+}
+
+RenameDetector::RenameDetector(BlobLoader loader, RenameDetectionOptions options)
+    : loader_(std::move(loader)), options_(options) {
+}
+
+const RenameDetector::Sketch* RenameDetector::sketch_for(const std::string& blob_hash) {
+    auto it = sketch_cache_.find(blob_hash);
+    if (it == sketch_cache_.end()) {
+        std::optional<Sketch> sketch_opt;
+        auto content_opt = loader_(blob_hash);
+        if (content_opt) {
+            Sketch sketch;
+            sketch.size = content_opt->size();
+            std::vector<uint64_t> elements = chunk_hashes(*content_opt);
+            if (!elements.empty()) {
+                sketch.signature.assign(SIGNATURE_SIZE, UINT64_MAX);
+                for (uint64_t element : elements) {
+                    for (size_t i = 0; i < SIGNATURE_SIZE; ++i) {
+                        uint64_t h = mix64(element ^ (0x9e3779b97f4a7c15ULL * (i + 1)));
+                        if (h < sketch.signature[i]) sketch.signature[i] = h;
+                    }
+                }
+            }
+            sketch_opt = std::move(sketch);
+        }
+        it = sketch_cache_.emplace(blob_hash, std::move(sketch_opt)).first;
+    }
+    return it->second ? &*it->second : nullptr;
+}
+
+int RenameDetector::estimate_similarity(const Sketch& a, const Sketch& b) {
+    if (a.signature.empty() || b.signature.empty()) return 0;
+
+    size_t equal_slots = 0;
+    for (size_t i = 0; i < SIGNATURE_SIZE; ++i) {
+        if (a.signature[i] == b.signature[i]) ++equal_slots;
+    }
+    int jaccard_percent = static_cast<int>(equal_slots * 100 / SIGNATURE_SIZE);
+
+    // 大小差异过大时，即使共享的块很多也不应视为重命名
+    size_t max_size = std::max(a.size, b.size);
+    int size_percent = max_size == 0 ? 100 : static_cast<int>(std::min(a.size, b.size) * 100 / max_size);
+    return std::min(jaccard_percent, size_percent);
+}
+
+std::vector<RenamePair> RenameDetector::detect(const std::map<std::filesystem::path, std::string>& deleted,
+                                               const std::map<std::filesystem::path, std::string>& added,
+                                               const std::map<std::filesystem::path, std::string>& copy_sources) {
+    std::vector<RenamePair> result;
+    if (added.empty() || (deleted.empty() && !(options_.detect_copies && !copy_sources.empty()))) {
+        return result;
+    }
+
+    // 空文件之间的 “重命名” 没有意义，不参与配对
+    const std::string empty_blob_hash = ObjectFormat::hash(options_.object_format, Blob(std::string()).serialize());
+
+    // --- 1. 精确匹配 (按 Blob 哈希) ---
+    std::unordered_map<std::string, std::vector<std::filesystem::path>> deleted_by_hash;
+    for (const auto& [path, hash] : deleted) {
+        if (hash != empty_blob_hash) deleted_by_hash[hash].push_back(path);
+    }
+    std::unordered_map<std::string, std::filesystem::path> copy_source_by_hash;
+    if (options_.detect_copies) {
+        for (const auto& [path, hash] : copy_sources) {
+            if (hash != empty_blob_hash) copy_source_by_hash.emplace(hash, path);
+        }
+    }
+
+    std::set<std::filesystem::path> used_deleted;
+    std::set<std::filesystem::path> matched_added;
+
+    for (const auto& [new_path, new_hash] : added) {
+        if (new_hash == empty_blob_hash) continue;
+
+        auto it = deleted_by_hash.find(new_hash);
+        if (it != deleted_by_hash.end()) {
+            // 优先选择文件名相同且尚未被使用的源
+            const std::filesystem::path* chosen = nullptr;
+            for (const auto& candidate : it->second) {
+                if (used_deleted.count(candidate)) continue;
+                if (candidate.filename() == new_path.filename()) { chosen = &candidate; break; }
+                if (!chosen) chosen = &candidate;
+            }
+            if (chosen) {
+                used_deleted.insert(*chosen);
+                matched_added.insert(new_path);
+                result.push_back({*chosen, new_path, new_hash, new_hash, 100, false});
+                continue;
+            }
+            if (options_.detect_copies) {
+                matched_added.insert(new_path);
+                result.push_back({it->second.front(), new_path, new_hash, new_hash, 100, true});
+                continue;
+            }
+        }
+        auto copy_it = copy_source_by_hash.find(new_hash);
+        if (copy_it != copy_source_by_hash.end()) {
+            matched_added.insert(new_path);
+            result.push_back({copy_it->second, new_path, new_hash, new_hash, 100, true});
+        }
+    }
+
+    // --- 2. 非精确匹配 (MinHash 草图 + LSH 索引) ---
+    struct Source {
+        std::filesystem::path path;
+        std::string blob_hash;
+        bool is_copy_source;
+    };
+    std::vector<Source> sources;
+    for (const auto& [path, hash] : deleted) {
+        if (!used_deleted.count(path) && hash != empty_blob_hash) sources.push_back({path, hash, false});
+    }
+    if (options_.detect_copies) {
+        for (const auto& [path, hash] : copy_sources) {
+            if (hash != empty_blob_hash) sources.push_back({path, hash, true});
+        }
+    }
+    std::vector<std::pair<std::filesystem::path, std::string>> targets;
+    for (const auto& [path, hash] : added) {
+        if (!matched_added.count(path) && hash != empty_blob_hash) targets.emplace_back(path, hash);
+    }
+
+    if (!options_.exact_only && !sources.empty() && !targets.empty()) {
+        if (sources.size() + targets.size() > options_.rename_limit) {
+            std::cerr << "警告: 参与重命名检测的文件过多 (" << sources.size() + targets.size()
+                      << " > " << options_.rename_limit << ")，仅进行精确重命名检测。" << std::endl;
+        } else {
+            // a. 为每个源建立 LSH 分段索引
+            const size_t num_bands = SIGNATURE_SIZE / BAND_ROWS;
+            auto band_key = [](const std::vector<uint64_t>& signature, size_t band) {
+                uint64_t key = mix64(band + 1);
+                for (size_t r = 0; r < BAND_ROWS; ++r) {
+                    key = mix64(key ^ signature[band * BAND_ROWS + r]);
+                }
+                return key;
+            };
+
+            std::unordered_map<uint64_t, std::vector<size_t>> band_index;
+            std::vector<const Sketch*> source_sketches(sources.size(), nullptr);
+            for (size_t i = 0; i < sources.size(); ++i) {
+                source_sketches[i] = sketch_for(sources[i].blob_hash);
+                if (!source_sketches[i] || source_sketches[i]->signature.empty()) continue;
+                for (size_t band = 0; band < num_bands; ++band) {
+                    band_index[band_key(source_sketches[i]->signature, band)].push_back(i);
+                }
+            }
+
+            // b. 对每个目标，从索引中取出候选并打分
+            struct Scored {
+                int score;
+                size_t target_idx;
+                size_t source_idx;
+            };
+            std::vector<Scored> scored_pairs;
+            for (size_t t = 0; t < targets.size(); ++t) {
+                const Sketch* target_sketch = sketch_for(targets[t].second);
+                if (!target_sketch || target_sketch->signature.empty()) continue;
+
+                std::unordered_map<size_t, size_t> band_hits;
+                for (size_t band = 0; band < num_bands; ++band) {
+                    auto it = band_index.find(band_key(target_sketch->signature, band));
+                    if (it == band_index.end()) continue;
+                    for (size_t source_idx : it->second) ++band_hits[source_idx];
+                }
+
+                std::vector<std::pair<size_t, size_t>> candidates(band_hits.begin(), band_hits.end());
+                std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+                    return a.second != b.second ? a.second > b.second : a.first < b.first;
+                });
+                if (candidates.size() > options_.max_candidates_per_file) {
+                    candidates.resize(options_.max_candidates_per_file);
+                }
+
+                for (const auto& [source_idx, hits] : candidates) {
+                    int score = estimate_similarity(*source_sketches[source_idx], *target_sketch);
+                    if (score >= options_.min_similarity) {
+                        scored_pairs.push_back({score, t, source_idx});
+                    }
+                }
+            }
+
+            // c. 按得分从高到低贪心配对 (同分时重命名优先于复制，再按路径保证结果稳定)
+            std::sort(scored_pairs.begin(), scored_pairs.end(), [&](const Scored& a, const Scored& b) {
+                if (a.score != b.score) return a.score > b.score;
+                if (sources[a.source_idx].is_copy_source != sources[b.source_idx].is_copy_source) {
+                    return !sources[a.source_idx].is_copy_source;
+                }
+                if (targets[a.target_idx].first != targets[b.target_idx].first) {
+                    return targets[a.target_idx].first < targets[b.target_idx].first;
+                }
+                return sources[a.source_idx].path < sources[b.source_idx].path;
+            });
+
+            std::vector<bool> target_done(targets.size(), false);
+            for (const auto& pair : scored_pairs) {
+                if (target_done[pair.target_idx]) continue;
+                const Source& source = sources[pair.source_idx];
+                bool is_copy = source.is_copy_source;
+                if (!is_copy && used_deleted.count(source.path)) {
+                    if (!options_.detect_copies) continue;
+                    is_copy = true; // 删除的源已被重命名占用，其余目标视为复制
+                }
+                if (!is_copy) used_deleted.insert(source.path);
+                target_done[pair.target_idx] = true;
+                result.push_back({source.path, targets[pair.target_idx].first,
+                                  source.blob_hash, targets[pair.target_idx].second, pair.score, is_copy});
+            }
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [](const RenamePair& a, const RenamePair& b) {
+        return a.new_path < b.new_path;
+    });
+    return result;
+}
+
+}
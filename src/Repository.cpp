@@ -2,16 +2,134 @@
 #include "../include/RemoteClient.h"
 #include "../include/object.h"
 #include "../include/utils.h"
-
+#include "../include/ChangedPathBloom.h"
+#include "../include/ObjectCodec.h"
+#include "../include/DiffDriver.h"
+#include "../include/ZlibDictionary.h"
+#include "../include/BinaryDelta.h"
+#include "../include/ObjectAlternates.h"
+#include "../include/ObjectWriter.h"
+#include "../include/FastImport.h"
+#include "../include/FastExport.h"
+#include "../include/TarArchive.h"
+#include "../include/IoBackend.h"
+
+#include <charconv>
+#include <cstring>
+#include <iomanip>
+#include <atomic>
 #include <iostream>
+#include <list>
 #include <map>
+#include <mutex>
 #include <set>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include <sys/stat.h>
+
 namespace Biogit {
 
 using std::cout,std::endl;
 
+namespace {
+
+using FlatTreeFiles = std::map<std::filesystem::path, std::pair<std::string, std::string>>;
+
+/**
+ * @brief 已展开 Tree 的进程内缓存 (常驻进程的多次请求共享)：<对象目录, Tree 哈希> -> 文件映射。
+ * @details Tree 的内容由哈希唯一确定，缓存不会过期；只保留最近用到的几棵树 (通常就是 HEAD 的树)。
+ */
+struct FlatTreeCache {
+    static constexpr size_t CAPACITY = 4;
+    std::mutex mutex;
+    std::vector<std::pair<std::string, std::shared_ptr<const FlatTreeFiles>>> entries; ///< 最近使用的在末尾
+};
+
+FlatTreeCache& flat_tree_cache() {
+    static FlatTreeCache instance;
+    return instance;
+}
+
+/**
+ * @brief 文件的身份：修改时间、状态改变时间 (纳秒)、inode 和大小都相同才视为同一份内容。
+ * @details 修改时间距现在不到 RACY_WINDOW_NS 的文件不能仅凭身份复用：同一时间戳粒度内的再次改写
+ *  可能保持修改时间和大小不变 (racy 问题)，只有时间戳已 “落定” 的文件才能缓存。
+ */
+struct FileStamp {
+    static constexpr int64_t RACY_WINDOW_NS = 2'000'000'000; ///< 覆盖粒度最粗的文件系统时间戳 (2 秒)
+
+    int64_t mtime_ns = 0;
+    int64_t ctime_ns = 0;
+    uint64_t inode = 0;
+    uint64_t size = 0;
+    uint32_t mode = 0;
+    bool operator==(const FileStamp&) const = default;
+
+    /// 读取文件的身份；文件不存在或无法访问时返回 std::nullopt
+    static std::optional<FileStamp> of(const std::filesystem::path& file_path) {
+        struct stat file_stat {};
+        if (::stat(file_path.c_str(), &file_stat) != 0) return std::nullopt;
+        return FileStamp{static_cast<int64_t>(file_stat.st_mtim.tv_sec) * 1'000'000'000 + file_stat.st_mtim.tv_nsec,
+                         static_cast<int64_t>(file_stat.st_ctim.tv_sec) * 1'000'000'000 + file_stat.st_ctim.tv_nsec,
+                         static_cast<uint64_t>(file_stat.st_ino),
+                         static_cast<uint64_t>(file_stat.st_size),
+                         static_cast<uint32_t>(file_stat.st_mode)};
+    }
+
+    bool is_regular_file() const { return S_ISREG(mode); }
+
+    /// 时间戳是否已落定 (可以缓存)
+    bool is_settled() const {
+        const int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        return now_ns - mtime_ns >= RACY_WINDOW_NS;
+    }
+};
+
+/**
+ * @brief 已解析索引的进程内缓存：索引文件 -> (文件身份, 索引)。索引文件被改写后重新解析，刚写入的索引不缓存。
+ */
+struct IndexSnapshotCache {
+    std::mutex mutex;
+    std::map<std::string, std::pair<FileStamp, std::shared_ptr<const Index>>> entries;
+};
+
+IndexSnapshotCache& index_snapshot_cache() {
+    static IndexSnapshotCache instance;
+    return instance;
+}
+
+/**
+ * @brief 引用文件 (HEAD、分支、标签) 内容的进程内 LRU：文件路径 -> (文件身份, 首行内容)。
+ * @details 默认关闭 (容量 0)，由常驻进程启用。引用文件常被原地改写为同样长度的哈希，
+ *  因此与索引一样按完整的文件身份校验，且刚写入的文件不缓存。
+ */
+struct RefFileCache {
+    struct Entry { std::string path; FileStamp stamp; std::string content; };
+
+    std::mutex mutex;
+    size_t capacity = 0;
+    std::list<Entry> lru; ///< 最近使用的在前
+    std::unordered_map<std::string, std::list<Entry>::iterator> by_path;
+
+    void evict_to(size_t limit) {
+        while (lru.size() > limit) {
+            by_path.erase(lru.back().path);
+            lru.pop_back();
+        }
+    }
+};
+
+RefFileCache& ref_file_cache() {
+    static RefFileCache instance;
+    return instance;
+}
+
+}
+
 // --- 定义静态常量成员 ---
 const std::string Repository::MYGIT_DIR_NAME = ".biogit";
 const std::string Repository::OBJECTS_DIR_NAME = "objects";
@@ -24,17 +142,136 @@ const std::string Repository::INDEX_FILE_NAME = "index";
 const std::string Repository::CONFIG_FILE_NAME = "config";
 const std::string Repository::MERGE_HEAD_FILE_NAME="MERGE_HEAD";
 const std::string Repository::FILE_CONFLICTS="FILE_CONFLICTS";
+const std::string Repository::BLAME_CACHE_DIR_NAME="blame-cache";
+const std::string Repository::WORKTREES_DIR_NAME="worktrees";
+const std::string Repository::WORKTREE_LINK_PREFIX="biogitdir: ";
 
 
 /**
  * @brief Repository 类的构造函数。
  * @details 初始化仓库对象的核心路径信息和索引管理器。
  * 此构造函数设计为私有或受保护，强制通过静态工厂方法 init() 或 load() 创建实例。
+ * 链接工作树 (worktree add 创建) 的 .biogit 是一个指向主仓库 worktrees/<名称> 的文件，
+ * 此时 mygit_dir_ 为该管理目录 (HEAD、index)，common_dir_ 为主仓库的 .biogit (对象、引用、配置)。
  * @param work_tree_path 仓库工作树的根目录的绝对路径。
  */
 Repository::Repository(const std::filesystem::path& work_tree_path)
     : work_tree_root_(std::filesystem::absolute(work_tree_path)),
-      mygit_dir_(work_tree_root_ / MYGIT_DIR_NAME) ,index_manager_(mygit_dir_){
+      mygit_dir_(_resolve_mygit_dir(work_tree_root_)),
+      common_dir_(_resolve_common_dir(mygit_dir_)), index_manager_(mygit_dir_){
+    // 对象格式和对象写入层的持久化方式按对象目录登记 (同一对象目录的多个 Repository 共享)
+    std::map<std::string, std::string> configs = load_all_config();
+    auto config_value = [&configs](const char* key) -> std::optional<std::string> {
+        auto it = configs.find(key);
+        return it != configs.end() ? std::optional<std::string>(it->second) : std::nullopt;
+    };
+    auto format_opt = config_value(ObjectFormat::CONFIG_KEY);
+    ObjectFormat::set_algorithm(get_objects_directory(),
+                                format_opt ? ObjectFormat::parse(*format_opt).value_or(ObjectFormat::Algorithm::SHA1) : ObjectFormat::Algorithm::SHA1);
+    ObjectWriter::set_durability(get_objects_directory(), ObjectWriter::parse_durability(config_value(ObjectWriter::CONFIG_KEY)));
+}
+
+
+/**
+ * @brief 解析工作树的 .biogit 目录：普通仓库为 <工作树>/.biogit；
+ *        链接工作树的 .biogit 是文件，内容为 "biogitdir: <管理目录>"。
+ * @param work_tree_root 工作树根目录的绝对路径。
+ * @return .biogit 目录 (或链接工作树的管理目录) 的绝对路径。
+ */
+std::filesystem::path Repository::_resolve_mygit_dir(const std::filesystem::path &work_tree_root) {
+    std::error_code ec;
+    std::filesystem::path mygit_path = work_tree_root / MYGIT_DIR_NAME;
+    if (!std::filesystem::is_regular_file(mygit_path, ec)) return mygit_path;
+
+    std::ifstream ifs(mygit_path);
+    std::string line;
+    std::getline(ifs, line);
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+    if (line.rfind(WORKTREE_LINK_PREFIX, 0) != 0) return mygit_path;
+    std::filesystem::path admin_dir(line.substr(WORKTREE_LINK_PREFIX.size()));
+    if (admin_dir.is_relative()) admin_dir = work_tree_root / admin_dir;
+    return admin_dir.lexically_normal();
+}
+
+
+/**
+ * @brief 解析对象、引用和配置所在的公共目录：管理目录中有 commondir 文件时为其记录的路径，否则为自身。
+ */
+std::filesystem::path Repository::_resolve_common_dir(const std::filesystem::path &mygit_dir) {
+    std::ifstream ifs(mygit_dir / "commondir");
+    std::string line;
+    if (!ifs.is_open() || !std::getline(ifs, line)) return mygit_dir;
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+    if (line.empty()) return mygit_dir;
+    std::filesystem::path common_dir(line);
+    if (common_dir.is_relative()) common_dir = mygit_dir / common_dir;
+    return common_dir.lexically_normal();
+}
+
+
+/**
+ * @brief 检查仓库格式：core.repositoryFormatVersion 不能高于本程序支持的版本，
+ *        extensions.objectFormat 必须是本程序认识的算法；备用对象库按本仓库的对象格式登记，
+ *        已按其他格式登记的备用对象库不能使用。
+ */
+bool Repository::_check_repository_format() const {
+    std::map<std::string, std::string> configs = load_all_config();
+    auto version_it = configs.find(ObjectFormat::VERSION_KEY);
+    if (version_it != configs.end()) {
+        int version = 0;
+        auto [ptr, parse_ec] = std::from_chars(version_it->second.data(), version_it->second.data() + version_it->second.size(), version);
+        if (parse_ec != std::errc() || ptr != version_it->second.data() + version_it->second.size() ||
+            version < 0 || version > ObjectFormat::MAX_REPOSITORY_FORMAT_VERSION) {
+            std::cerr << "错误: 不支持的仓库格式版本 '" << version_it->second << "' (本程序最高支持 "
+                      << ObjectFormat::MAX_REPOSITORY_FORMAT_VERSION << ")。" << std::endl;
+            return false;
+        }
+    }
+    auto format_it = configs.find(ObjectFormat::CONFIG_KEY);
+    if (format_it != configs.end() && !ObjectFormat::parse(format_it->second)) {
+        std::cerr << "错误: 不支持的对象格式 '" << format_it->second << "'。" << std::endl;
+        return false;
+    }
+    const ObjectFormat::Algorithm object_format = get_object_format();
+    for (const std::filesystem::path& alternate_dir : ObjectAlternates::list(get_objects_directory())) {
+        std::optional<ObjectFormat::Algorithm> registered = ObjectFormat::find_algorithm(alternate_dir);
+        if (registered && *registered != object_format) {
+            std::cerr << "错误: 备用对象库 '" << alternate_dir.string() << "' 的对象格式为 " << ObjectFormat::name(*registered)
+                      << "，与本仓库 (" << ObjectFormat::name(object_format) << ") 不同。" << std::endl;
+            return false;
+        }
+        ObjectFormat::set_algorithm(alternate_dir, object_format);
+    }
+    return true;
+}
+
+
+/**
+ * @brief 检查仓库能否参与对象传输：网络协议和离线传输包中的对象 ID 固定为 40 位 SHA-1。
+ */
+bool Repository::_check_transport_object_format() const {
+    ObjectFormat::Algorithm object_format = get_object_format();
+    if (object_format != ObjectFormat::Algorithm::SHA1) {
+        std::cerr << "错误: 网络协议和离线传输包目前只支持 SHA-1 对象格式的仓库 (本仓库为 "
+                  << ObjectFormat::name(object_format) << ")。" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ * @brief 检查目录是否为有效的 BioGit 工作树根目录 (包括链接工作树)。
+ */
+bool Repository::_is_repository_root(const std::filesystem::path &work_tree_root) {
+    std::error_code ec;
+    if (!std::filesystem::exists(work_tree_root / MYGIT_DIR_NAME, ec)) return false;
+    const std::filesystem::path mygit_dir = _resolve_mygit_dir(work_tree_root);
+    const std::filesystem::path common_dir = _resolve_common_dir(mygit_dir);
+    return std::filesystem::is_directory(mygit_dir, ec) &&
+           std::filesystem::exists(mygit_dir / HEAD_FILE_NAME, ec) &&
+           std::filesystem::exists(common_dir / OBJECTS_DIR_NAME, ec) &&
+           std::filesystem::exists(common_dir / REFS_DIR_NAME, ec);
 }
 
 
@@ -43,7 +280,7 @@ Repository::Repository(const std::filesystem::path& work_tree_path)
  * @param work_tree_path 要初始化仓库的工作树目录路径。默认为当前工作目录。
  * @return 如果成功，返回一个包含 Repository 对象的 std::optional；否则返回 std::nullopt。
  */
-std::optional<Repository> Repository::init(const std::filesystem::path& work_tree_path) {
+std::optional<Repository> Repository::init(const std::filesystem::path& work_tree_path, ObjectFormat::Algorithm object_format) {
     std::error_code ec;
 
     // 1. 转换绝对路径，创建工作目录
@@ -108,8 +345,21 @@ std::optional<Repository> Repository::init(const std::filesystem::path& work_tre
     }
     index_ofs.close();
 
+    // 6. 非 SHA-1 对象格式：写入仓库格式扩展 (不认识它的程序会拒绝加载此仓库)
+    Repository repo(abs_work_tree_path); // 使用私有构造函数创建对象
+    if (object_format != ObjectFormat::Algorithm::SHA1) {
+        if (!repo.config_set(ObjectFormat::VERSION_KEY, std::to_string(ObjectFormat::MAX_REPOSITORY_FORMAT_VERSION)) ||
+            !repo.config_set(ObjectFormat::CONFIG_KEY, ObjectFormat::name(object_format))) {
+            std::cerr << "错误: 无法写入仓库格式配置。" << std::endl;
+            return std::nullopt;
+        }
+        ObjectFormat::set_algorithm(repo.get_objects_directory(), object_format);
+        std::cout << "已初始化空的 BioGit 仓库 (对象格式 " << ObjectFormat::name(object_format) << ") 于 " << mygit_path.string() << std::endl;
+        return repo;
+    }
+
     std::cout << "已初始化空的 BioGit 仓库于 " << mygit_path.string() << std::endl;
-    return Repository(abs_work_tree_path); // 使用私有构造函数创建并返回对象
+    return repo;
 }
 
 /**
@@ -123,22 +373,175 @@ std::optional<Repository> Repository::load(const std::filesystem::path &work_tre
     std::filesystem::path abs_work_tree_path = std::filesystem::absolute(work_tree_path);
     abs_work_tree_path = abs_work_tree_path.lexically_normal();
 
-    // 2. 构造 .biogit 目录的路径
-    std::filesystem::path mygit_path = abs_work_tree_path / MYGIT_DIR_NAME;
-
-    // 3. 检查核心目录和文件是否存在，以判断是否为有效的 BioGit 仓库
-    if (std::filesystem::exists(mygit_path, ec) &&
-        std::filesystem::is_directory(mygit_path, ec) &&
-        std::filesystem::exists(mygit_path / HEAD_FILE_NAME, ec) &&
-        std::filesystem::exists(mygit_path / OBJECTS_DIR_NAME, ec) &&
-        std::filesystem::exists(mygit_path / REFS_DIR_NAME, ec)) {
-        return Repository(abs_work_tree_path);
+    // 2. 检查核心目录和文件是否存在，以判断是否为有效的 BioGit 仓库 (链接工作树经 .biogit 文件解析)
+    if (_is_repository_root(abs_work_tree_path)) {
+        Repository repo(abs_work_tree_path);
+        // 3. 拒绝本程序不认识的仓库格式版本或对象格式 (按错误的哈希算法读写会损坏仓库)
+        if (!repo._check_repository_format()) {
+            return std::nullopt;
+        }
+        return repo;
     }
     std::cerr << "错误: '" << abs_work_tree_path.string() << "' 不是一个有效的 BioGit 仓库工作树根目录。" << std::endl;
     return std::nullopt;
 }
 
 
+/**
+ * @brief (服务器端) 以共享对象池为后盾 fork 一个仓库。
+ * @param source_work_tree 源仓库的工作树根目录。
+ * @param target_work_tree 新仓库的工作树根目录。
+ * @param pool_objects_dir 共享对象池的对象目录。
+ * @return 成功时返回新仓库；否则返回 std::nullopt。
+ */
+std::optional<Repository> Repository::fork(const std::filesystem::path &source_work_tree,
+    const std::filesystem::path &target_work_tree,
+    const std::filesystem::path &pool_objects_dir) {
+
+    std::error_code ec;
+    const std::filesystem::path pool_dir = std::filesystem::absolute(pool_objects_dir).lexically_normal();
+
+    // 1. 加载源仓库，把它的对象移入对象池
+    std::optional<Repository> source_opt = load(source_work_tree);
+    if (!source_opt) return std::nullopt;
+    std::optional<size_t> moved_count = source_opt->share_objects_with_pool(pool_dir);
+    if (!moved_count) return std::nullopt;
+    std::cout << "已将 " << *moved_count << " 个对象移入共享对象池 " << pool_dir.string() << std::endl;
+
+    // 2. 以源仓库的对象格式初始化新仓库，以对象池为备用对象库
+    std::optional<Repository> target_opt = init(target_work_tree, source_opt->get_object_format());
+    if (!target_opt) return std::nullopt;
+    if (!ObjectAlternates::add(target_opt->get_objects_directory(), pool_dir)) return std::nullopt;
+
+    // 3. 复制引用 (分支、标签和 HEAD)
+    const std::filesystem::path& source_mygit = source_opt->common_dir_;
+    const std::filesystem::path& target_mygit = target_opt->common_dir_;
+    for (const std::string& sub_dir : {HEADS_DIR_NAME, TAGS_DIR_NAME}) {
+        std::filesystem::path from = source_mygit / REFS_DIR_NAME / sub_dir;
+        if (!std::filesystem::exists(from, ec)) continue;
+        std::filesystem::copy(from, target_mygit / REFS_DIR_NAME / sub_dir,
+                              std::filesystem::copy_options::recursive | std::filesystem::copy_options::overwrite_existing, ec);
+        if (ec) {
+            std::cerr << "错误: 复制引用目录 '" << from.string() << "' 失败: " << ec.message() << std::endl;
+            return std::nullopt;
+        }
+    }
+    std::filesystem::copy_file(source_opt->get_head_file_path(), target_opt->get_head_file_path(),
+                               std::filesystem::copy_options::overwrite_existing, ec);
+    if (ec) {
+        std::cerr << "错误: 复制 HEAD 失败: " << ec.message() << std::endl;
+        return std::nullopt;
+    }
+
+    // 4. 大文件内容库以硬链接共享 (跨文件系统时复制)
+    const std::filesystem::path source_lfs = source_mygit / LfsStore::DIR_NAME;
+    if (std::filesystem::is_directory(source_lfs, ec)) {
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(source_lfs, ec)) {
+            if (!entry.is_regular_file(ec)) continue;
+            std::filesystem::path to = target_mygit / LfsStore::DIR_NAME / std::filesystem::relative(entry.path(), source_lfs, ec);
+            std::filesystem::create_directories(to.parent_path(), ec);
+            std::filesystem::create_hard_link(entry.path(), to, ec);
+            if (ec) {
+                ec.clear();
+                std::filesystem::copy_file(entry.path(), to, std::filesystem::copy_options::skip_existing, ec);
+                if (ec) {
+                    std::cerr << "错误: 复制大文件内容 '" << entry.path().string() << "' 失败: " << ec.message() << std::endl;
+                    return std::nullopt;
+                }
+            }
+        }
+    }
+
+    std::cout << "已创建 fork: " << target_opt->get_work_tree_root().string() << " (源仓库: "
+              << source_opt->get_work_tree_root().string() << ")" << std::endl;
+    return target_opt;
+}
+
+
+/**
+ * @brief 把本仓库的对象移入共享对象池，并把对象池登记为本仓库的备用对象库。
+ * @param pool_objects_dir 共享对象池的对象目录。
+ * @return 移入对象池 (或删除重复副本) 的对象数；失败返回 std::nullopt。
+ */
+std::optional<size_t> Repository::share_objects_with_pool(const std::filesystem::path &pool_objects_dir) const {
+    std::error_code ec;
+    const std::filesystem::path objects_dir = get_objects_directory();
+    const std::filesystem::path pool_dir = std::filesystem::absolute(pool_objects_dir).lexically_normal();
+    if (pool_dir == objects_dir.lexically_normal()) {
+        std::cerr << "错误: 共享对象池不能是仓库自身的对象目录。" << std::endl;
+        return std::nullopt;
+    }
+    // 对象池只存放一种对象格式的对象
+    const ObjectFormat::Algorithm object_format = get_object_format();
+    std::optional<ObjectFormat::Algorithm> pool_format = ObjectFormat::find_algorithm(pool_dir);
+    if (pool_format && *pool_format != object_format) {
+        std::cerr << "错误: 共享对象池 '" << pool_dir.string() << "' 的对象格式为 " << ObjectFormat::name(*pool_format)
+                  << "，与本仓库 (" << ObjectFormat::name(object_format) << ") 不同。" << std::endl;
+        return std::nullopt;
+    }
+    ObjectFormat::set_algorithm(pool_dir, object_format);
+
+    // 1. 创建对象池，并先登记为备用对象库
+    std::filesystem::create_directories(pool_dir, ec);
+    if (ec) {
+        std::cerr << "错误: 无法创建共享对象池 '" << pool_dir.string() << "': " << ec.message() << std::endl;
+        return std::nullopt;
+    }
+    if (!ObjectAlternates::add(objects_dir, pool_dir)) return std::nullopt;
+
+    // 2. 复制字典 (对象池中的对象按对象池的字典目录解码；字典文件一经写入不再修改)
+    const std::filesystem::path dictionaries_dir = ZlibDictionaries::directory(objects_dir);
+    const std::filesystem::path pool_dictionaries_dir = ZlibDictionaries::directory(pool_dir);
+    for (uint32_t dictionary_id : ZlibDictionaries::list(objects_dir)) {
+        const std::string file_name = ZlibDictionaries::format_id(dictionary_id);
+        if (std::filesystem::exists(pool_dictionaries_dir / file_name, ec)) continue;
+        std::filesystem::create_directories(pool_dictionaries_dir, ec);
+        std::filesystem::path temp_path = pool_dictionaries_dir / (file_name + ".tmp");
+        std::filesystem::copy_file(dictionaries_dir / file_name, temp_path, std::filesystem::copy_options::overwrite_existing, ec);
+        if (!ec) std::filesystem::rename(temp_path, pool_dictionaries_dir / file_name, ec);
+        if (ec) {
+            std::cerr << "错误: 无法复制字典 " << file_name << " 到共享对象池: " << ec.message() << std::endl;
+            return std::nullopt;
+        }
+    }
+
+    // 3. 收集本仓库的对象文件 (移动前先收集，避免边遍历边修改目录)
+    std::vector<std::filesystem::path> object_files;
+    for (const auto& dir_entry : std::filesystem::directory_iterator(objects_dir, ec)) {
+        if (!dir_entry.is_directory(ec) || dir_entry.path().filename().string().length() != 2) continue;
+        for (const auto& file_entry : std::filesystem::directory_iterator(dir_entry.path(), ec)) {
+            if (file_entry.is_regular_file(ec) && file_entry.path().extension() != ".tmp") {
+                object_files.push_back(file_entry.path());
+            }
+        }
+    }
+
+    // 4. 逐个移入对象池：对象池中已有的删除本地副本，否则重命名 (跨文件系统时复制后删除)
+    size_t moved_count = 0;
+    for (const auto& object_file : object_files) {
+        std::filesystem::path pool_file = pool_dir / object_file.parent_path().filename() / object_file.filename();
+        if (!std::filesystem::exists(pool_file, ec)) {
+            std::filesystem::create_directories(pool_file.parent_path(), ec);
+            std::filesystem::rename(object_file, pool_file, ec);
+            if (ec) {
+                ec.clear();
+                std::filesystem::path temp_path = pool_file;
+                temp_path += ".tmp";
+                std::filesystem::copy_file(object_file, temp_path, std::filesystem::copy_options::overwrite_existing, ec);
+                if (!ec) std::filesystem::rename(temp_path, pool_file, ec);
+                if (ec) {
+                    std::cerr << "错误: 无法把对象 '" << object_file.string() << "' 移入共享对象池: " << ec.message() << std::endl;
+                    return std::nullopt;
+                }
+            }
+        }
+        if (std::filesystem::exists(object_file, ec)) std::filesystem::remove(object_file, ec);
+        ++moved_count;
+    }
+    return moved_count;
+}
+
+
 /**
  * @brief 将指定的文件或目录添加到索引 (暂存区)。
  * @param path_to_add_original 要添加的文件或目录的路径 (可以是绝对路径或相对于当前工作目录的路径)。
@@ -193,7 +596,7 @@ bool Repository::add(const std::filesystem::path &path_to_add_original) {
             std::error_code entry_ec;
             if (dir_entry.is_regular_file(entry_ec)) { // 只处理常规文件，忽略目录本身、符号链接等
                 // 跳过 .biogit 目录内的所有内容
-                if (dir_entry.path().string().rfind(mygit_dir_.string(), 0) == 0) {
+                if (dir_entry.path().string().rfind((work_tree_root_ / MYGIT_DIR_NAME).string(), 0) == 0) {
                     continue;
                 }
                 files_to_process.push_back(dir_entry.path().lexically_normal());
@@ -204,7 +607,7 @@ bool Repository::add(const std::filesystem::path &path_to_add_original) {
         }
     } else if (std::filesystem::is_regular_file(abs_path_to_add, ec)) { // 如果是常规文件，将其添加到待处理列表
         // 跳过 .biogit 目录内的所有内容
-        if (abs_path_to_add.string().rfind(mygit_dir_.string(), 0) == 0) {
+        if (abs_path_to_add.string().rfind((work_tree_root_ / MYGIT_DIR_NAME).string(), 0) == 0) {
             std::cout << "提示 (add): 不能添加 .biogit 目录内部的文件: '" << abs_path_to_add.string() << "'" << std::endl;
         } else {
             files_to_process.push_back(abs_path_to_add);
@@ -226,89 +629,148 @@ bool Repository::add(const std::filesystem::path &path_to_add_original) {
         return true;
     }
 
-    // --- 步骤 B: 循环处理每个找到的文件 ---
+    // --- 步骤 B: 经 I/O 后端 (core.ioBackend，队列深度 core.ioThreads) 批量 stat 并按批读取各文件，
+    //             并行哈希、保存 Blob，再按顺序更新索引 ---
     bool overall_success = true; // 跟踪整个 add 操作是否所有文件都成功
-
-    for (const auto& current_file_abs_path : files_to_process) {
-        // B.1 将文件的绝对路径转换为相对于工作树根目录的路径
+    const uintmax_t chunk_threshold = _chunk_threshold(); // 超过此大小的文件分块存储
+    const FastCdcChunker chunker;
+    const uintmax_t lfs_threshold = _lfs_threshold(); // 超过此大小的文件以指针形式存储 (0 表示不启用)
+    const LfsStore lfs_store(common_dir_);
+    std::unique_ptr<IoBackend> io_backend = _io_backend();
+
+    /// 一个文件的处理结果 (index_manager_ 不是线程安全的，由调用线程统一写入)
+    struct StagedFile {
+        bool ok = false;
         std::filesystem::path relative_path;
-        relative_path = std::filesystem::relative(current_file_abs_path, work_tree_root_, ec);
+        std::string blob_hash;
+        std::chrono::system_clock::time_point mtime;
+        uint64_t size = 0;
+    };
+    std::vector<StagedFile> staged_files(files_to_process.size());
+
+    // B.0. 先取元数据再读内容：读取期间文件被修改时，索引中记录的修改时间早于内容，下次 status 会重新比较
+    const std::vector<std::optional<IoBackend::FileStat>> file_stats = io_backend->stat_files(files_to_process);
+    auto is_lfs_file = [&](size_t i) {
+        return lfs_threshold > 0 && file_stats[i] && file_stats[i]->size >= lfs_threshold;
+    };
 
+    /// content 为 nullptr 表示大文件 (流式存入内容库，不读入内存)
+    auto stage_file = [&](size_t i, std::optional<std::vector<std::byte>>* content, std::ostream& out) {
+        const std::filesystem::path& current_file_abs_path = files_to_process[i];
+        StagedFile& result = staged_files[i];
+        std::error_code ec;
+        // B.1 将文件的绝对路径转换为相对于工作树根目录的路径
+        std::filesystem::path relative_path = std::filesystem::relative(current_file_abs_path, work_tree_root_, ec);
         if (ec) {
-            std::cerr << "错误: 计算文件 '" << current_file_abs_path.string()
-                      << "' 的相对路径失败: " << ec.message() << std::endl;
-            overall_success = false;
-            continue; // 处理下一个文件
+            out << "错误: 计算文件 '" << current_file_abs_path.string()
+                << "' 的相对路径失败: " << ec.message() << std::endl;
+            return;
         }
         if (relative_path.empty() || relative_path.string().rfind("..", 0) == 0) {
-            std::cerr << "错误: 文件 '" << current_file_abs_path.string()
-                      << "' 不在工作树 '" << work_tree_root_.string() << "' 内部。" << std::endl;
-            overall_success = false;
-            continue;
+            out << "错误: 文件 '" << current_file_abs_path.string()
+                << "' 不在工作树 '" << work_tree_root_.string() << "' 内部。" << std::endl;
+            return;
         }
         relative_path = relative_path.lexically_normal();
 
-        // B.2. 读取文件内容
-        std::ifstream file_stream(current_file_abs_path, std::ios::binary);
-        if (!file_stream.is_open()) {
-            std::cerr << "错误: 无法打开文件 '" << current_file_abs_path.string() << "' 进行读取。" << std::endl;
-            overall_success = false;
-            continue;
+        if (!file_stats[i]) {
+            out << "错误: 无法获取文件 '" << current_file_abs_path.string() << "' 的元数据。" << std::endl;
+            return;
         }
 
-        file_stream.seekg(0, std::ios::end);
-        std::streamsize file_size_on_disk = file_stream.tellg();
-        file_stream.seekg(0, std::ios::beg);
-        std::vector<std::byte> file_content_bytes(static_cast<size_t>(file_size_on_disk));
-        if (file_size_on_disk > 0) {
-            if (!file_stream.read(reinterpret_cast<char*>(file_content_bytes.data()), file_size_on_disk)) {
-                std::cerr << "错误: 读取文件内容失败: " << current_file_abs_path.string() << std::endl;
-                overall_success = false;
-                file_stream.close();
-                continue;
+        // B.2. 达到大文件阈值的文件：内容流式存入 .biogit/lfs/，对象库中只保存一个很小的指针 Blob
+        uint64_t file_size_on_disk = 0;
+        std::optional<std::string> blob_hash_opt;
+        if (!content) {
+            auto pointer_opt = lfs_store.store_file(current_file_abs_path);
+            if (!pointer_opt) {
+                out << "错误: 无法将大文件 '" << current_file_abs_path.string() << "' 存入内容库。" << std::endl;
+                return;
             }
-        }
-        file_stream.close();
-
-        // B.3. 创建 Blob 对象并保存到对象库
-        Blob blob_to_save(file_content_bytes);
-        std::optional<std::string> blob_hash_opt = blob_to_save.save(get_objects_directory());
+            file_size_on_disk = pointer_opt->size;
+            blob_hash_opt = Blob(pointer_opt->serialize()).save(get_objects_directory());
+        } else {
+            // 普通文件：内容已由 I/O 后端读入
+            if (!*content) {
+                out << "错误: 无法打开文件 '" << current_file_abs_path.string() << "' 进行读取。" << std::endl;
+                return;
+            }
+            file_size_on_disk = (*content)->size();
 
-        if (!blob_hash_opt) {
-            std::cerr << "错误: 保存文件 '" << current_file_abs_path.string() << "' 的 Blob 对象失败。" << std::endl;
-            overall_success = false;
-            continue;
+            // B.3. 创建 Blob 对象并保存到对象库 (较大的文件按内容分块存储，未改动的块在版本之间共享)
+            Blob blob_to_save(std::move(**content));
+            content->reset();
+            blob_hash_opt =
+                (chunk_threshold > 0 && file_size_on_disk >= chunk_threshold)
+                    ? blob_to_save.save_chunked(get_objects_directory(), chunker)
+                    : blob_to_save.save(get_objects_directory(), relative_path);
         }
-        std::string blob_hash = *blob_hash_opt;
 
-        // B.4. 获取文件模式和元数据
-        std::string file_mode_str = "100644"; // TODO 简化成普通文件模式
-        auto last_write_time = std::filesystem::last_write_time(current_file_abs_path, ec);
-        if (ec) {
-            std::cerr << "错误: 无法获取文件 '" << current_file_abs_path.string() << "' 的最后修改时间: " << ec.message() << std::endl;
-            overall_success = false;
-            continue;
+        if (!blob_hash_opt) {
+            out << "错误: 保存文件 '" << current_file_abs_path.string() << "' 的 Blob 对象失败。" << std::endl;
+            return;
         }
 
-        auto file_time_duration_since_epoch = last_write_time.time_since_epoch();
+        // B.4. 记录文件元数据
         auto system_clock_compatible_duration =
-            std::chrono::duration_cast<std::chrono::system_clock::duration>(file_time_duration_since_epoch);
-        std::chrono::system_clock::time_point mtime(system_clock_compatible_duration); // 直接构造 mtime
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(file_stats[i]->mtime.time_since_epoch());
+
+        result.relative_path = relative_path;
+        result.blob_hash = *blob_hash_opt;
+        result.mtime = std::chrono::system_clock::time_point(system_clock_compatible_duration); // 直接构造 mtime
+        result.size = file_size_on_disk;
+        result.ok = true;
+    };
+
+    // 按批读取 (每批内容总量有上限，大文件不读入内存)，读完一批并行处理一批
+    constexpr uintmax_t READ_BATCH_BYTES = 64 * 1024 * 1024;
+    const OrderedTaskPool stage_pool(_configured_thread_count("core.ioThreads"));
+    for (size_t next = 0; next < files_to_process.size();) {
+        std::vector<size_t> batch;
+        std::vector<std::filesystem::path> batch_read_paths;
+        std::vector<size_t> content_slots; // batch 中每个文件在 batch_read_paths 中的下标 (大文件不读取)
+        uintmax_t batch_bytes = 0;
+        while (next < files_to_process.size() && (batch.empty() || batch_bytes < READ_BATCH_BYTES)) {
+            const size_t i = next++;
+            batch.push_back(i);
+            if (is_lfs_file(i)) {
+                content_slots.push_back(SIZE_MAX);
+            } else {
+                content_slots.push_back(batch_read_paths.size());
+                batch_read_paths.push_back(files_to_process[i]);
+                batch_bytes += file_stats[i] ? file_stats[i]->size : 0;
+            }
+        }
+        std::vector<std::optional<std::vector<std::byte>>> contents = io_backend->read_files(batch_read_paths);
 
-        uint64_t file_size_val = static_cast<uint64_t>(file_size_on_disk); // 已在读取时获取
+        std::vector<OrderedTaskPool::Task> stage_tasks;
+        stage_tasks.reserve(batch.size());
+        for (size_t k = 0; k < batch.size(); ++k) {
+            stage_tasks.push_back([&, i = batch[k], slot = content_slots[k]](std::ostream& out) {
+                stage_file(i, slot == SIZE_MAX ? nullptr : &contents[slot], out);
+            });
+        }
+        stage_pool.run(stage_tasks, std::cout);
+    }
 
-        // B.5. 将文件信息更新到索引管理器 (内存中)
-        if (!index_manager_.add_or_update_entry(relative_path, blob_hash, file_mode_str, mtime, file_size_val)) {
-            std::cerr << "错误: 更新文件 '" << relative_path.string() << "' 到索引失败。" << std::endl;
+    // B.5. 将文件信息按顺序更新到索引管理器 (内存中)
+    const std::string file_mode_str = "100644"; // TODO 简化成普通文件模式
+    for (const StagedFile& staged : staged_files) {
+        if (!staged.ok) {
+            overall_success = false;
+            continue;
+        }
+        if (!index_manager_.add_or_update_entry(staged.relative_path, staged.blob_hash, file_mode_str, staged.mtime, staged.size)) {
+            std::cerr << "错误: 更新文件 '" << staged.relative_path.string() << "' 到索引失败。" << std::endl;
             overall_success = false;
         } else {
-            std::cout << "已暂存: " << relative_path.string() << std::endl;
+            std::cout << "已暂存: " << staged.relative_path.string() << std::endl;
         }
-    } // 文件处理循环结束
+    }
 
-    // --- 步骤 C: 将更新后的索引写回磁盘 ---
+    // --- 步骤 C: 将更新后的索引写回磁盘 (索引引用的 Blob 先落盘) ---
     if (overall_success) { // 只有在所有文件处理（尝试）都未导致致命错误时才考虑写入
-        if (!index_manager_.write()) {
+        if (!_sync_objects() || !index_manager_.write()) {
             std::cerr << "严重错误: 写入索引文件失败！暂存的更改可能未保存。" << std::endl;
             return false; // 索引写入失败是严重错误
         }
@@ -477,29 +939,35 @@ bool Repository::rm(const std::filesystem::path& path_to_remove_original) {
     bool existed_in_wd = std::filesystem::exists(absolute_path_to_remove_in_wd);
 
     if (existed_in_wd) {
-        // 1. 读取工作目录文件内容
-        std::ifstream file_stream_wd(absolute_path_to_remove_in_wd, std::ios::binary);
-        if (!file_stream_wd.is_open()) {
-            std::cerr << "错误: 无法打开工作目录文件 '" << absolute_path_to_remove_in_wd.string() << "' 以进行严格检查。" << std::endl;
-            return false;
-        }
-        file_stream_wd.seekg(0, std::ios::end);
-        std::streamsize file_size_wd = file_stream_wd.tellg();
-        file_stream_wd.seekg(0, std::ios::beg);
-        std::vector<std::byte> wd_content_bytes(static_cast<size_t>(file_size_wd));
-        if (file_size_wd > 0) {
-            if (!file_stream_wd.read(reinterpret_cast<char*>(wd_content_bytes.data()), file_size_wd)) {
-                std::cerr << "错误: 读取工作目录文件 '" << absolute_path_to_remove_in_wd.string() << "' 内容失败以进行严格检查。" << std::endl;
-                file_stream_wd.close();
+        // 0. 达到大文件阈值的文件按指针计算哈希，不读入内存
+        std::string wd_blob_hash;
+        if (auto lfs_blob_hash_opt = _lfs_pointer_blob_hash(absolute_path_to_remove_in_wd, _lfs_threshold())) {
+            wd_blob_hash = *lfs_blob_hash_opt;
+        } else {
+            // 1. 读取工作目录文件内容
+            std::ifstream file_stream_wd(absolute_path_to_remove_in_wd, std::ios::binary);
+            if (!file_stream_wd.is_open()) {
+                std::cerr << "错误: 无法打开工作目录文件 '" << absolute_path_to_remove_in_wd.string() << "' 以进行严格检查。" << std::endl;
                 return false;
             }
-        }
-        file_stream_wd.close();
+            file_stream_wd.seekg(0, std::ios::end);
+            std::streamsize file_size_wd = file_stream_wd.tellg();
+            file_stream_wd.seekg(0, std::ios::beg);
+            std::vector<std::byte> wd_content_bytes(static_cast<size_t>(file_size_wd));
+            if (file_size_wd > 0) {
+                if (!file_stream_wd.read(reinterpret_cast<char*>(wd_content_bytes.data()), file_size_wd)) {
+                    std::cerr << "错误: 读取工作目录文件 '" << absolute_path_to_remove_in_wd.string() << "' 内容失败以进行严格检查。" << std::endl;
+                    file_stream_wd.close();
+                    return false;
+                }
+            }
+            file_stream_wd.close();
 
-        // 2. 创建工作目录内容的 Blob 对象并计算其序列化后的哈希
-        Blob wd_blob(wd_content_bytes); //
-        std::vector<std::byte> serialized_wd_blob_data = wd_blob.serialize(); //
-        std::string wd_blob_hash = SHA1::sha1(serialized_wd_blob_data); //
+            // 2. 创建工作目录内容的 Blob 对象并计算其序列化后的哈希
+            Blob wd_blob(wd_content_bytes); //
+            std::vector<std::byte> serialized_wd_blob_data = wd_blob.serialize(); //
+            wd_blob_hash = ObjectFormat::hash(get_objects_directory(), serialized_wd_blob_data); //
+        }
 
         // 3. 与索引中的 Blob 哈希进行比较
         if (wd_blob_hash != entry_in_index_ref.blob_hash_hex) { //
@@ -562,8 +1030,7 @@ std::optional<std::string> Repository::commit(const std::string& message) {
     }
 
     // 保证是有序的 因为构建 Tree需要有序
-    std::vector<IndexEntry> index_entries = index_manager_.get_all_entries(); // 获取副本或const引用
-    std::sort(index_entries.begin(), index_entries.end()); //
+    const std::vector<IndexEntry>& index_entries = index_manager_.get_all_entries(); // 已按路径排序
 
 
     // 检查 MERGE_HEAD 文件是否存在，以判断是否正在进行合并提交
@@ -591,7 +1058,7 @@ std::optional<std::string> Repository::commit(const std::string& message) {
     // 这种情况是允许的，因为合并提交本身就是一个记录。
 
     // 3. 从索引条目构建 Tree 对象，并获取根 Tree 的哈希
-    std::optional<std::string> root_tree_hash_opt = _build_trees_and_get_root_hash(index_entries); //
+    std::optional<std::string> root_tree_hash_opt = _build_trees_and_get_root_hash(index_manager_); //
     if (!root_tree_hash_opt) {
         std::cerr << "错误: 构建 Tree 对象失败。" << std::endl;
         return std::nullopt;
@@ -626,7 +1093,7 @@ std::optional<std::string> Repository::commit(const std::string& message) {
                 if (head_commit_hash_opt) { // head_commit_hash_opt 是当前 HEAD 解析出的 commit
                     parent_commit_hashes.push_back(*head_commit_hash_opt);
                 }
-            } else if (head_content_line.length() == 40) { // HEAD 分离
+            } else if (ObjectFormat::is_id_length(head_content_line.length())) { // HEAD 分离
                  if (head_commit_hash_opt && head_content_line == *head_commit_hash_opt) {
                     parent_commit_hashes.push_back(*head_commit_hash_opt);
                  } else if (head_commit_hash_opt) { // head_content_line 可能与解析的不一致？理论上应该一致
@@ -656,7 +1123,7 @@ std::optional<std::string> Repository::commit(const std::string& message) {
 
         std::ifstream m_head_ifs(merge_head_file);
         std::string theirs_commit_hash;
-        if (m_head_ifs >> theirs_commit_hash && theirs_commit_hash.length() == 40) {
+        if (m_head_ifs >> theirs_commit_hash && ObjectFormat::is_id_length(theirs_commit_hash.length())) {
             parent_commit_hashes.push_back(theirs_commit_hash); // THEIRS 作为第二个父节点
         } else {
             std::cerr << "错误: 无法从 MERGE_HEAD 读取有效的第二个父 commit 哈希。" << std::endl;
@@ -708,16 +1175,20 @@ std::optional<std::string> Repository::commit(const std::string& message) {
         return std::nullopt;
     }
     std::string new_commit_hash = *new_commit_hash_opt;
+    _record_changed_paths(new_commit_hash); // 记录改动路径过滤器，供路径限定的 log 使用
     std::cout << "已提交 ["
               << (parent_commit_hashes.empty() ? "根提交" : (is_completing_merge ? "合并提交" : "新提交")) // 根据情况显示提交类型
               << " " << new_commit_hash.substr(0, 7) << "] "
               << message.substr(0, message.find('\n')) << std::endl;
 
 
-    // 8. 更新分支引用 (或 HEAD 如果是分离头)
+    // 8. 更新分支引用 (或 HEAD 如果是分离头)；引用指向的对象先落盘
+    if (!_sync_objects()) {
+        return std::nullopt;
+    }
     if (!current_branch_ref_path_for_update.empty()) {
         // 如果 HEAD 指向一个分支 (例如 "refs/heads/main")，则更新该分支文件
-        std::filesystem::path branch_file_to_update = mygit_dir_ / current_branch_ref_path_for_update;
+        std::filesystem::path branch_file_to_update = common_dir_ / current_branch_ref_path_for_update;
         std::ofstream branch_ofs(branch_file_to_update, std::ios::trunc);
         if (!branch_ofs.is_open()) {
             std::cerr << "严重错误: 无法打开分支文件 '" << branch_file_to_update.string() << "' 进行更新！" << std::endl;
@@ -764,7 +1235,7 @@ std::optional<std::string> Repository::commit(const std::string& message) {
     // --- 步骤 9: 更新索引以匹配新的 HEAD ---
     // 无论是否合并提交，成功提交后，索引都应该与新的 commit 的树一致
     index_manager_.clear_in_memory(); // 先清空内存中的旧条目
-    _populate_index_from_tree_recursive(root_tree_hash, "", index_manager_); // 用新 commit 的 tree 填充索引
+    _populate_index_from_tree_recursive(root_tree_hash, PathTable::ROOT, index_manager_); // 用新 commit 的 tree 填充索引
 
     if (!index_manager_.write()) { // 将更新后的索引写回磁盘
         std::cerr << "警告: 提交后更新索引文件失败。" << std::endl;
@@ -817,7 +1288,7 @@ void Repository::status() const {
                 } else {
                     // std::cout << "当前分支 '" << current_branch_display_name << "' 尚无提交。" << std::endl; // 这条信息可能在后面处理
                 }
-            } else if (head_content_line.length() == 40) {
+            } else if (ObjectFormat::is_id_length(head_content_line.length())) {
                 current_branch_display_name = "HEAD (分离于 " + head_content_line.substr(0, 7) + ")";
                 if (head_commit_hash_opt) {
                     is_repository_empty = false;
@@ -858,11 +1329,13 @@ void Repository::status() const {
 
 
     // --- 2. 加载 HEAD Commit 的文件树 (State 1) ---
-    std::map<std::filesystem::path, std::pair<std::string, std::string>> head_commit_files_map;
+    // 已展开的树取自进程内缓存 (常驻进程中 HEAD 不变时无需重新读取任何 Tree)
+    std::shared_ptr<const std::map<std::filesystem::path, std::pair<std::string, std::string>>> head_tree_files =
+        std::make_shared<const std::map<std::filesystem::path, std::pair<std::string, std::string>>>();
     if (head_commit_hash_opt) {
         auto commit_opt = Commit::load_by_hash(*head_commit_hash_opt, get_objects_directory());
         if (commit_opt) {
-            _load_tree_contents_recursive(commit_opt->tree_hash_hex, "", head_commit_files_map);
+            head_tree_files = _flattened_tree(commit_opt->tree_hash_hex);
         } else {
             std::cerr << "警告 (status): 无法加载 HEAD commit 对象 " << *head_commit_hash_opt << std::endl;
             is_repository_empty = true; // 如果HEAD commit加载失败，视作仓库没有有效历史
@@ -870,33 +1343,26 @@ void Repository::status() const {
     } else { // 如果没有 head_commit_hash_opt，也说明仓库是空的或初始状态
         is_repository_empty = true;
     }
+    const auto& head_commit_files_map = *head_tree_files;
 
 
     // --- 3. 加载 Index (暂存区) 内容 (State 2) ---
-    Index index_reader(mygit_dir_); // Index构造函数接收 .biogit 目录
-    bool index_load_successful = index_reader.load();
-    if (!index_load_successful && std::filesystem::exists(mygit_dir_ / Repository::INDEX_FILE_NAME)) { // INDEX_FILE_NAME 来自Repository
+    std::shared_ptr<const Index> index_reader = _index_snapshot(); // 索引文件未变化时复用上次解析的结果
+    if (!index_reader) {
          std::cerr << "错误 (status): 加载索引失败，但索引文件存在。状态可能不准确。" << std::endl;
+         index_reader = std::make_shared<const Index>(mygit_dir_);
     }
-    const auto& staged_entries_vec = index_reader.get_all_entries(); // 使用staged_entries_vec
-    std::map<std::filesystem::path, const IndexEntry*> staged_files_map;
-    for (const auto& entry : staged_entries_vec) {
-        staged_files_map[entry.file_path] = &entry;
-    }
+    const auto& staged_entries_vec = index_reader->get_all_entries(); // 已按路径排序；按路径查找经索引的路径表 (不再另建路径映射)
 
     // --- 用于比较的列表 ---
     std::vector<std::pair<std::string, std::filesystem::path>> changes_to_be_committed;
     std::vector<std::pair<std::string, std::filesystem::path>> changes_not_staged;
     std::vector<std::filesystem::path> untracked_files_list; // 修正：之前叫untracked_files，这里统一
 
-    // 收集所有在HEAD或Index中出现过的文件路径，用于后续识别未跟踪文件
-    std::set<std::filesystem::path> all_known_paths_in_head_or_index;
-
     // --- 4.1 比较 Index vs HEAD ("Changes to be committed") ---
-    for (const auto& staged_pair : staged_files_map) {
-        const std::filesystem::path& rel_path = staged_pair.first;
-        const IndexEntry* staged_entry = staged_pair.second;
-        all_known_paths_in_head_or_index.insert(rel_path);
+    for (const IndexEntry& staged : staged_entries_vec) {
+        const std::filesystem::path& rel_path = staged.file_path;
+        const IndexEntry* staged_entry = &staged;
 
         auto head_it = head_commit_files_map.find(rel_path);
         if (head_it == head_commit_files_map.end()) {
@@ -909,14 +1375,23 @@ void Repository::status() const {
     }
     for (const auto& head_pair : head_commit_files_map) {
         const std::filesystem::path& rel_path = head_pair.first;
-        all_known_paths_in_head_or_index.insert(rel_path);
-        if (staged_files_map.find(rel_path) == staged_files_map.end()) {
+        if (!index_reader->find_entry(rel_path)) {
             changes_to_be_committed.push_back({"删除:   ", rel_path});
         }
     }
 
     // --- 4.2 遍历工作目录，比较 Working Directory vs Index ("Changes not staged" & "Untracked files") ---
-    std::set<std::filesystem::path> files_found_in_work_tree;
+    std::vector<bool> staged_found_in_work_tree(staged_entries_vec.size(), false); // 按索引条目下标记录
+    std::vector<std::filesystem::path> untracked_candidates; // 不在索引中的工作区文件
+    const uintmax_t lfs_threshold = _lfs_threshold();
+
+    /// 已跟踪的工作区文件：先在遍历目录时收集，再并行比较 (stat、必要时读取并哈希)
+    struct TrackedFile {
+        std::filesystem::path rel_path;
+        std::filesystem::path abs_path;
+        const IndexEntry* staged_entry;
+    };
+    std::vector<TrackedFile> tracked_files;
 
     if (std::filesystem::exists(work_tree_root_) && std::filesystem::is_directory(work_tree_root_)) {
         std::filesystem::recursive_directory_iterator dir_iter(
@@ -935,7 +1410,7 @@ void Repository::status() const {
 
                 // 跳过 .biogit 目录
                 // 确保比较的是规范化后的路径
-                if (current_abs_path_from_iterator.lexically_normal().string().rfind(mygit_dir_.lexically_normal().string(), 0) == 0) {
+                if (current_abs_path_from_iterator.lexically_normal().string().rfind((work_tree_root_ / MYGIT_DIR_NAME).lexically_normal().string(), 0) == 0) {
                     if (dir_iter.depth() == 0 && current_abs_path_from_iterator.filename() == MYGIT_DIR_NAME) {
                          dir_iter.disable_recursion_pending();
                     }
@@ -948,59 +1423,13 @@ void Repository::status() const {
 
                     if (ec || rel_path.empty() || rel_path.string().rfind("..",0) == 0) continue;
 
-                    files_found_in_work_tree.insert(rel_path);
-
-                    auto staged_it = staged_files_map.find(rel_path);
-                    if (staged_it != staged_files_map.end()) {
-                        const IndexEntry* staged_entry = staged_it->second;
-                        bool metadata_differs = false;
-
-                        auto ftime_workdir = std::filesystem::last_write_time(current_file_abs_path, ec);
-                        if (ec) { metadata_differs = true; }
-                        else {
-                            auto file_time_duration_since_epoch = ftime_workdir.time_since_epoch();
-                            auto system_clock_compatible_duration =
-                                std::chrono::duration_cast<std::chrono::system_clock::duration>(file_time_duration_since_epoch);
-                            std::chrono::system_clock::time_point mtime_workdir(system_clock_compatible_duration);
-                            if (mtime_workdir != staged_entry->mtime) {
-                                metadata_differs = true;
-                            }
-                        }
-
-                        uintmax_t size_workdir = std::filesystem::file_size(current_file_abs_path, ec);
-                        if (ec) { metadata_differs = true; }
-                        else if (size_workdir != staged_entry->file_size) {
-                            metadata_differs = true;
-                        }
-
-                        if (metadata_differs) {
-                            std::ifstream ifs(current_file_abs_path, std::ios::binary);
-                            std::vector<std::byte> content;
-                            if(ifs.is_open()){
-                                ifs.seekg(0, std::ios::end);
-                                std::streamsize file_size_check = ifs.tellg();
-                                ifs.seekg(0, std::ios::beg);
-                                if (file_size_check > 0) {
-                                    content.resize(static_cast<size_t>(file_size_check));
-                                    if (!ifs.read(reinterpret_cast<char*>(content.data()), file_size_check)) {
-                                        content.clear();
-                                    }
-                                }
-                                ifs.close();
-                            }
-
-                            if (!content.empty() || (std::filesystem::exists(current_file_abs_path) && std::filesystem::file_size(current_file_abs_path)==0) ) {
-                                Blob temp_blob(content);
-                                std::string workdir_blob_hash = SHA1::sha1(temp_blob.serialize());
-                                if (workdir_blob_hash != staged_entry->blob_hash_hex) {
-                                    changes_not_staged.push_back({"修改:   ", rel_path});
-                                }
-                            } else if (std::filesystem::exists(current_file_abs_path)) {
-                                changes_not_staged.push_back({"错误读取:", rel_path});
-                            }
-                        }
+                    const IndexEntry* staged_entry = index_reader->find_entry(rel_path);
+                    if (staged_entry) {
+                        staged_found_in_work_tree[static_cast<size_t>(staged_entry - staged_entries_vec.data())] = true;
+                        tracked_files.push_back({rel_path, current_file_abs_path, staged_entry});
+                    } else {
+                        untracked_candidates.push_back(rel_path); // 是否未跟踪还要看 HEAD (4.4)
                     }
-                    // Untracked files will be determined later by set difference
                 } else if (entry_ec) {
                      std::cerr << "警告 (status): 检查工作区路径 '" << current_abs_path_from_iterator.string() // 使用 current_abs_path_from_iterator
                               << "' 类型时出错: " << entry_ec.message() << std::endl;
@@ -1009,19 +1438,93 @@ void Repository::status() const {
         }
     }
 
+    // 4.2.1 比较已跟踪文件与 Index：经 I/O 后端 (core.ioBackend，队列深度 core.ioThreads) 批量 stat，
+    //       只读取元数据有变化的文件，再并行哈希；结果按路径顺序汇总
+    std::unique_ptr<IoBackend> io_backend = _io_backend();
+    std::vector<std::filesystem::path> tracked_abs_paths;
+    tracked_abs_paths.reserve(tracked_files.size());
+    for (const TrackedFile& tracked : tracked_files) tracked_abs_paths.push_back(tracked.abs_path);
+    const std::vector<std::optional<IoBackend::FileStat>> tracked_stats = io_backend->stat_files(tracked_abs_paths);
+
+    std::vector<const char*> tracked_results(tracked_files.size(), nullptr); // nullptr 表示未改动
+    std::vector<size_t> files_to_compare; // 元数据有变化、需要比较内容的文件
+    for (size_t i = 0; i < tracked_files.size(); ++i) {
+        const std::optional<IoBackend::FileStat>& stat_opt = tracked_stats[i];
+        if (stat_opt) {
+            auto system_clock_compatible_duration =
+                std::chrono::duration_cast<std::chrono::system_clock::duration>(stat_opt->mtime.time_since_epoch());
+            std::chrono::system_clock::time_point mtime_workdir(system_clock_compatible_duration);
+            if (mtime_workdir == tracked_files[i].staged_entry->mtime && stat_opt->size == tracked_files[i].staged_entry->file_size) {
+                continue;
+            }
+        }
+        files_to_compare.push_back(i);
+    }
+
+    // 大文件按指针比较，不读入内存；其余文件按批读入 (每批内容总量有上限)，读完一批并行哈希一批
+    auto is_lfs_candidate = [&](size_t i) {
+        return lfs_threshold > 0 && tracked_stats[i] && tracked_stats[i]->size >= lfs_threshold;
+    };
+    constexpr uintmax_t READ_BATCH_BYTES = 64 * 1024 * 1024;
+    const OrderedTaskPool hash_pool(_configured_thread_count("core.ioThreads"));
+    for (size_t next = 0; next < files_to_compare.size();) {
+        std::vector<size_t> batch;
+        std::vector<std::filesystem::path> batch_read_paths;
+        std::vector<size_t> content_slots; // batch 中每个文件在 batch_read_paths 中的下标 (大文件不读取)
+        uintmax_t batch_bytes = 0;
+        while (next < files_to_compare.size() && (batch.empty() || batch_bytes < READ_BATCH_BYTES)) {
+            const size_t i = files_to_compare[next++];
+            batch.push_back(i);
+            if (is_lfs_candidate(i)) {
+                content_slots.push_back(SIZE_MAX);
+            } else {
+                content_slots.push_back(batch_read_paths.size());
+                batch_read_paths.push_back(tracked_files[i].abs_path);
+                batch_bytes += tracked_stats[i] ? tracked_stats[i]->size : 0;
+            }
+        }
+        std::vector<std::optional<std::vector<std::byte>>> contents = io_backend->read_files(batch_read_paths);
+
+        std::vector<OrderedTaskPool::Task> compare_tasks;
+        compare_tasks.reserve(batch.size());
+        for (size_t k = 0; k < batch.size(); ++k) {
+            compare_tasks.push_back([&, i = batch[k], slot = content_slots[k]](std::ostream&) {
+                const IndexEntry* staged_entry = tracked_files[i].staged_entry;
+                if (slot == SIZE_MAX) {
+                    std::optional<std::string> lfs_blob_hash_opt = _lfs_pointer_blob_hash(tracked_files[i].abs_path, lfs_threshold);
+                    if (!lfs_blob_hash_opt) {
+                        tracked_results[i] = "错误读取:";
+                    } else if (*lfs_blob_hash_opt != staged_entry->blob_hash_hex) {
+                        tracked_results[i] = "修改:   ";
+                    }
+                } else if (contents[slot]) {
+                    Blob temp_blob(std::move(*contents[slot]));
+                    std::string workdir_blob_hash = ObjectFormat::hash(get_objects_directory(), temp_blob.serialize());
+                    if (workdir_blob_hash != staged_entry->blob_hash_hex) {
+                        tracked_results[i] = "修改:   ";
+                    }
+                } else if (tracked_stats[i]) { // 文件存在但无法读取 (遍历后才被删除的文件不报告)
+                    tracked_results[i] = "错误读取:";
+                }
+            });
+        }
+        hash_pool.run(compare_tasks, std::cout);
+    }
+    for (size_t i = 0; i < tracked_files.size(); ++i) {
+        if (tracked_results[i]) changes_not_staged.push_back({tracked_results[i], tracked_files[i].rel_path});
+    }
+
     // 4.3 检查 Index 中有但工作目录中没有的文件
-    for (const auto& staged_pair : staged_files_map) {
-        const std::filesystem::path& rel_path = staged_pair.first;
-        if (files_found_in_work_tree.find(rel_path) == files_found_in_work_tree.end()) {
-            changes_not_staged.push_back({"删除:   ", rel_path});
+    for (size_t i = 0; i < staged_entries_vec.size(); ++i) {
+        if (!staged_found_in_work_tree[i]) {
+            changes_not_staged.push_back({"删除:   ", staged_entries_vec[i].file_path});
         }
     }
 
     // 4.4 找出真正的未跟踪文件: 在工作目录中，但既不在HEAD也不在Index中
-    for(const auto& work_tree_file_rel_path : files_found_in_work_tree) {
-        // all_known_paths_in_head_or_index 包含了所有在 HEAD 或 Index 中已知的路径
-        if (all_known_paths_in_head_or_index.find(work_tree_file_rel_path) == all_known_paths_in_head_or_index.end()) {
-            untracked_files_list.push_back(work_tree_file_rel_path);
+    for (auto& work_tree_file_rel_path : untracked_candidates) {
+        if (head_commit_files_map.find(work_tree_file_rel_path) == head_commit_files_map.end()) {
+            untracked_files_list.push_back(std::move(work_tree_file_rel_path));
         }
     }
 
@@ -1100,7 +1603,7 @@ void Repository::status() const {
 }
 
 
-void Repository::log() const {
+void Repository::log(const std::vector<std::filesystem::path>& paths_filter) const {
     // 1. 获取当前 HEAD 指向的 Commit 哈希
     std::optional<std::string> current_commit_hash_opt = _get_head_commit_hash();
 
@@ -1118,7 +1621,7 @@ void Repository::log() const {
 
                 if (head_content_line.rfind("ref: refs/heads/", 0) == 0) {
                     std::string branch_ref = head_content_line.substr(std::string("ref: refs/heads/").length());
-                    if (!std::filesystem::exists(mygit_dir_ / ("refs/heads/" + branch_ref))) {
+                    if (!std::filesystem::exists(common_dir_ / ("refs/heads/" + branch_ref))) {
                         std::cout << "当前分支 '" << branch_ref << "' 尚无提交。" << std::endl;
                     }
                 }
@@ -1131,6 +1634,27 @@ void Repository::log() const {
     int commit_count = 0; // 用于控制输出数量（可选）
     const int MAX_LOG_ENTRIES = 50; // 示例：最多显示50条日志
 
+    // 路径限定: 规范化为相对于工作树根目录、以 '/' 分隔的字符串。指向根目录的路径等价于不限定
+    std::vector<std::string> filter_keys;
+    bool filter_whole_tree = false;
+    for (const auto& user_path : paths_filter) {
+        auto relative_path_opt = normalize_and_relativize_path(user_path);
+        if (!relative_path_opt) return;
+        std::string key = relative_path_opt->generic_string();
+        while (!key.empty() && key.back() == '/') key.pop_back();
+        if (key.empty() || key == ".") {
+            filter_whole_tree = true;
+        } else {
+            filter_keys.push_back(key);
+        }
+    }
+    const bool path_limited = !filter_keys.empty() && !filter_whole_tree;
+
+    ChangedPathBloomStore bloom_store(common_dir_);
+    if (path_limited) {
+        bloom_store.load();
+    }
+
     // 2. 循环追溯并打印父 Commit
     while (!commit_to_log_hash.empty() && commit_count < MAX_LOG_ENTRIES) {
         // a. 加载 Commit 对象
@@ -1141,6 +1665,50 @@ void Repository::log() const {
         }
         const Commit& current_commit = *commit_opt;
 
+        // 路径限定时，先查询改动路径过滤器：一定未改动这些路径的 Commit 直接跳过，无需比较 Tree
+        if (path_limited) {
+            bool touches_filter = false;
+            const BloomFilter* bloom = bloom_store.get(commit_to_log_hash);
+            bool maybe_touches = (bloom == nullptr);
+            if (bloom) {
+                for (const auto& key : filter_keys) {
+                    if (bloom->might_contain(key)) { maybe_touches = true; break; }
+                }
+            }
+
+            if (maybe_touches) {
+                // 过滤器缺失或 “可能包含”：比较 Tree 得到准确结果 (缺失时顺便补记过滤器)
+                std::string parent_tree_hash;
+                if (!current_commit.parent_hashes_hex.empty()) {
+                    auto parent_opt = Commit::load_by_hash(current_commit.parent_hashes_hex[0], get_objects_directory());
+                    if (parent_opt) parent_tree_hash = parent_opt->tree_hash_hex;
+                }
+                std::set<std::string> changed_paths;
+                const bool complete = _collect_changed_paths(parent_tree_hash, current_commit.tree_hash_hex, "", changed_paths);
+                if (!complete) {
+                    touches_filter = true; // 无法确定改动范围：按 “可能改动” 显示，且不记录过滤器
+                } else if (bloom == nullptr) {
+                    bloom_store.record(commit_to_log_hash, changed_paths);
+                }
+
+                for (const auto& key : filter_keys) {
+                    if (!complete) break;
+                    // 命中文件本身，或命中以 "key/" 开头的目录下的文件
+                    auto under_it = changed_paths.lower_bound(key + "/");
+                    if (changed_paths.count(key) ||
+                        (under_it != changed_paths.end() && under_it->compare(0, key.length() + 1, key + "/") == 0)) {
+                        touches_filter = true;
+                        break;
+                    }
+                }
+            }
+
+            if (!touches_filter) {
+                commit_to_log_hash = current_commit.parent_hashes_hex.empty() ? "" : current_commit.parent_hashes_hex[0];
+                continue;
+            }
+        }
+
         // b. 打印 Commit 信息
         std::cout << "\033[33mcommit " << commit_to_log_hash << "\033[0m" << std::endl; // 黄色显示 commit 哈希
 
@@ -1174,7 +1742,9 @@ void Repository::log() const {
         commit_count++;
     } // end while
 
-    if (commit_count == 0 && current_commit_hash_opt) {
+    if (commit_count == 0 && path_limited) {
+        std::cout << "没有改动过指定路径的提交。" << std::endl;
+    } else if (commit_count == 0 && current_commit_hash_opt) {
         std::cout << "无法显示提交历史（无法加载起始提交）。" << std::endl;
     } else if (commit_count >= MAX_LOG_ENTRIES) {
         std::cout << "...\n(已达到最大日志显示数量)" << std::endl;
@@ -1183,41 +1753,252 @@ void Repository::log() const {
 
 
 /**
- * @brief 创建一个新的本地分支。
- * @param branch_name 新分支的名称。
- * @param start_point_commit_hash_param (可选) 新分支基于的Commit的SHA-1哈希。
- * 如果为空，则基于当前HEAD指向的Commit创建。
- * @return 如果分支创建成功，返回 true；否则返回 false (例如分支已存在，或起点Commit无效)。
+ * @brief 逐行显示文件内容最后一次被修改的 Commit (类似 git blame)。
+ * @details
+ * 从起始 Commit 开始按提交时间从新到旧回溯历史，每个 Commit 持有一组“尚未确定来源”的行：
+ *   - 父提交中该文件的 Blob 哈希相同 (或改动路径过滤器表明一定未改动)，所有行原样交给父提交；
+ *   - 否则用 Myers diff 比较父提交与当前版本，匹配 (MATCH) 的行交给父提交继续追溯；
+ *   - 没有交给任何父提交的行，其来源就是当前 Commit。
+ * 若启用缓存 (配置 blame.cache，默认开启)，起始 Commit 的结果会写入 .biogit/blame-cache，
+ * 之后回溯到已缓存的 (Commit, 路径) 时直接复用，只需处理新增的历史。
  */
-bool Repository::branch_create(const std::string& branch_name, const std::string& start_point_commit_hash_param) {
-    // 检查分支名称是否有效
-    if (branch_name.empty() || branch_name.find('/') != std::string::npos || branch_name == "HEAD") {
-        std::cerr << "错误: 无效的分支名称 '" << branch_name << "'" << std::endl;
+bool Repository::blame(const std::filesystem::path& file_path, const std::string& commit_ish) const {
+    // 1. 解析路径与起始 Commit
+    auto relative_path_opt = normalize_and_relativize_path(file_path);
+    if (!relative_path_opt) return false;
+    const std::string relative_path = relative_path_opt->generic_string();
+
+    auto start_commit_hash_opt = _resolve_commit_ish_to_full_hash(commit_ish);
+    if (!start_commit_hash_opt) {
+        std::cerr << "错误: 无法解析提交 '" << commit_ish << "'。" << std::endl;
         return false;
     }
+    const std::string start_commit_hash = *start_commit_hash_opt;
 
-    std::filesystem::path new_branch_file_path = get_heads_directory() / branch_name;
-    std::error_code ec;
-
-    if (std::filesystem::exists(new_branch_file_path, ec)) {
-        std::cerr << "错误: 分支 '" << branch_name << "' 已存在。" << std::endl;
+    auto start_commit_opt = Commit::load_by_hash(start_commit_hash, get_objects_directory());
+    if (!start_commit_opt) {
+        std::cerr << "错误: 无法加载 Commit 对象 " << start_commit_hash << std::endl;
         return false;
     }
-    if (ec) {
-        std::cerr << "错误: 检查分支文件 '" << new_branch_file_path.string() << "' 是否存在时出错: " << ec.message() << std::endl;
+    auto start_blob_opt = _find_blob_hash_in_tree(start_commit_opt->tree_hash_hex, relative_path);
+    if (!start_blob_opt) {
+        std::cerr << "错误: 路径 '" << relative_path << "' 不在提交 " << start_commit_hash.substr(0, 7) << " 中。" << std::endl;
         return false;
     }
+    auto final_lines_opt = _get_blob_lines(*start_blob_opt);
+    if (!final_lines_opt) return false;
+    const std::vector<std::string>& final_lines = *final_lines_opt;
 
-    std::string target_commit_hash;
+    auto cache_setting = config_get("blame.cache");
+    const bool use_cache = !(cache_setting && (*cache_setting == "false" || *cache_setting == "0"));
 
-    if (!start_point_commit_hash_param.empty()) {
-        // 如果用户指定了起点 Commit 哈希
-        std::optional<string> full_hash_ptr = _resolve_commit_ish_to_full_hash(start_point_commit_hash_param);
+    // 2. 初始化：所有行都待定，位于起始 Commit
+    std::vector<BlameOrigin> origins(final_lines.size());
 
-        if (full_hash_ptr) { // 基本的哈希长度检查
-            // 验证 commit_hash 是否真的存在于对象库中
-            string full_hash = *full_hash_ptr;
-            auto commit_opt = Commit::load_by_hash(full_hash, get_objects_directory());
+    // 回溯队列中的一个节点: 某个 Commit 中的待定行 <该 Commit 版本中的行号, 最终行号>
+    struct PendingCommit {
+        Commit commit;
+        std::string blob_hash;
+        std::vector<std::pair<int, int>> lines;
+    };
+    std::map<std::string, PendingCommit> pending;
+    auto newer_first = [&pending](const std::string& a, const std::string& b) {
+        auto ta = pending.at(a).commit.committer.timestamp;
+        auto tb = pending.at(b).commit.committer.timestamp;
+        return ta != tb ? ta < tb : a < b;
+    };
+    std::vector<std::string> queue; // 以 newer_first 为比较器的堆
+
+    // 同一 Blob 只切分一次；Blob 的切分结果只保留到引用它的最后一个待处理 Commit 处理完
+    std::map<std::string, std::vector<std::string>> blob_lines_cache;
+    std::map<std::string, int> pending_blob_refs; // <Blob 哈希, 引用它的待处理 Commit 数>
+    std::vector<std::string> touched_blobs;        // 本轮切分或读取过的 Blob
+    auto lines_of_blob = [&](const std::string& blob_hash) -> const std::vector<std::string>* {
+        auto it = blob_lines_cache.find(blob_hash);
+        if (it == blob_lines_cache.end()) {
+            auto lines_opt = _get_blob_lines(blob_hash);
+            if (!lines_opt) return nullptr;
+            it = blob_lines_cache.emplace(blob_hash, std::move(*lines_opt)).first;
+        }
+        touched_blobs.push_back(blob_hash);
+        return &it->second;
+    };
+
+    PendingCommit start_node{*start_commit_opt, *start_blob_opt, {}};
+    for (int i = 0; i < static_cast<int>(final_lines.size()); ++i) start_node.lines.emplace_back(i, i);
+    pending.emplace(start_commit_hash, std::move(start_node));
+    ++pending_blob_refs[*start_blob_opt];
+    queue.push_back(start_commit_hash);
+
+    ChangedPathBloomStore bloom_store(common_dir_);
+    bloom_store.load();
+
+    // 3. 按提交时间从新到旧回溯
+    while (!queue.empty()) {
+        // 释放上一轮用过、已不被任何待处理 Commit 引用的 Blob
+        for (const std::string& blob_hash : touched_blobs) {
+            if (!pending_blob_refs.count(blob_hash)) blob_lines_cache.erase(blob_hash);
+        }
+        touched_blobs.clear();
+
+        std::pop_heap(queue.begin(), queue.end(), newer_first);
+        std::string commit_hash = queue.back();
+        queue.pop_back();
+        PendingCommit node = std::move(pending.at(commit_hash));
+        pending.erase(commit_hash);
+        if (--pending_blob_refs[node.blob_hash] == 0) pending_blob_refs.erase(node.blob_hash);
+
+        // a. 命中缓存：直接复用该 (Commit, 路径) 的结果
+        if (use_cache) {
+            auto cached_opt = _load_blame_cache(commit_hash, relative_path);
+            const std::vector<std::string>* node_lines = lines_of_blob(node.blob_hash);
+            if (cached_opt && node_lines && cached_opt->size() == node_lines->size()) {
+                for (const auto& [line_in_commit, final_idx] : node.lines) {
+                    origins[final_idx] = (*cached_opt)[line_in_commit];
+                }
+                continue;
+            }
+        }
+
+        // b. 把待定行交给各个父提交
+        std::vector<std::pair<int, int>> remaining = std::move(node.lines);
+        for (size_t parent_idx = 0; parent_idx < node.commit.parent_hashes_hex.size() && !remaining.empty(); ++parent_idx) {
+            const std::string& parent_hash = node.commit.parent_hashes_hex[parent_idx];
+
+            std::vector<std::pair<int, int>> passed;
+            std::vector<std::pair<int, int>> kept;
+            std::string parent_blob_hash;
+
+            const BloomFilter* bloom = (parent_idx == 0) ? bloom_store.get(commit_hash) : nullptr;
+            auto parent_it = pending.find(parent_hash);
+            std::optional<Commit> parent_commit_opt;
+            if (parent_it != pending.end()) {
+                parent_commit_opt = parent_it->second.commit;
+            } else {
+                parent_commit_opt = Commit::load_by_hash(parent_hash, get_objects_directory());
+            }
+            if (!parent_commit_opt) continue;
+
+            if (bloom && !bloom->might_contain(relative_path)) {
+                // 过滤器表明该路径相对第一父提交一定未改动
+                parent_blob_hash = node.blob_hash;
+                passed = std::move(remaining);
+            } else {
+                auto parent_blob_opt = _find_blob_hash_in_tree(parent_commit_opt->tree_hash_hex, relative_path);
+                if (!parent_blob_opt) continue; // 父提交中没有该文件
+                parent_blob_hash = *parent_blob_opt;
+
+                if (parent_blob_hash == node.blob_hash) {
+                    passed = std::move(remaining);
+                } else {
+                    const std::vector<std::string>* parent_lines = lines_of_blob(parent_blob_hash);
+                    const std::vector<std::string>* node_lines = lines_of_blob(node.blob_hash);
+                    if (!parent_lines || !node_lines) continue;
+
+                    // 当前版本的行号 -> 父版本的行号
+                    std::vector<int> to_parent(node_lines->size(), -1);
+                    for (const auto& op : Utils::MyersDiffLines(*parent_lines, *node_lines)) {
+                        if (op.type == Utils::EditType::MATCH) to_parent[op.index_b] = op.index_a;
+                    }
+                    for (const auto& [line_in_commit, final_idx] : remaining) {
+                        if (to_parent[line_in_commit] >= 0) {
+                            passed.emplace_back(to_parent[line_in_commit], final_idx);
+                        } else {
+                            kept.emplace_back(line_in_commit, final_idx);
+                        }
+                    }
+                }
+            }
+            remaining = std::move(kept);
+
+            if (passed.empty()) continue;
+            if (parent_it == pending.end()) {
+                pending.emplace(parent_hash, PendingCommit{*parent_commit_opt, parent_blob_hash, std::move(passed)});
+                ++pending_blob_refs[parent_blob_hash];
+                queue.push_back(parent_hash);
+                std::push_heap(queue.begin(), queue.end(), newer_first);
+            } else {
+                auto& parent_lines_list = parent_it->second.lines;
+                parent_lines_list.insert(parent_lines_list.end(), passed.begin(), passed.end());
+            }
+        }
+
+        // c. 剩余的行来源于当前 Commit
+        for (const auto& [line_in_commit, final_idx] : remaining) {
+            origins[final_idx] = BlameOrigin{commit_hash, line_in_commit};
+        }
+    }
+
+    if (use_cache) {
+        _save_blame_cache(start_commit_hash, relative_path, origins);
+    }
+
+    // 4. 打印结果: <短哈希> (<作者> <日期> <行号>) <内容>
+    std::map<std::string, std::optional<Commit>> commit_cache;
+    size_t author_width = 0;
+    for (const auto& origin : origins) {
+        if (!commit_cache.count(origin.commit_hash)) {
+            commit_cache[origin.commit_hash] = Commit::load_by_hash(origin.commit_hash, get_objects_directory());
+        }
+        const auto& c = commit_cache[origin.commit_hash];
+        if (c) author_width = std::max(author_width, c->author.name.length());
+    }
+    const int line_no_width = static_cast<int>(std::to_string(final_lines.size()).length());
+
+    for (size_t i = 0; i < final_lines.size(); ++i) {
+        const BlameOrigin& origin = origins[i];
+        const auto& c = commit_cache[origin.commit_hash];
+        std::string author = c ? c->author.name : "?";
+        char date_buf[32] = "<未知日期>";
+        if (c) {
+            std::time_t t = std::chrono::system_clock::to_time_t(c->author.timestamp);
+            std::strftime(date_buf, sizeof(date_buf), "%Y-%m-%d %H:%M:%S", std::localtime(&t));
+        }
+        std::cout << "\033[33m" << origin.commit_hash.substr(0, 8) << "\033[0m ("
+                  << author << std::string(author_width - std::min(author_width, author.length()), ' ') << " "
+                  << date_buf << " " << std::setw(line_no_width) << (i + 1) << ") "
+                  << final_lines[i] << std::endl;
+    }
+    return true;
+}
+
+
+/**
+ * @brief 创建一个新的本地分支。
+ * @param branch_name 新分支的名称。
+ * @param start_point_commit_hash_param (可选) 新分支基于的Commit的SHA-1哈希。
+ * 如果为空，则基于当前HEAD指向的Commit创建。
+ * @return 如果分支创建成功，返回 true；否则返回 false (例如分支已存在，或起点Commit无效)。
+ */
+bool Repository::branch_create(const std::string& branch_name, const std::string& start_point_commit_hash_param) {
+    // 检查分支名称是否有效
+    if (branch_name.empty() || branch_name.find('/') != std::string::npos || branch_name == "HEAD") {
+        std::cerr << "错误: 无效的分支名称 '" << branch_name << "'" << std::endl;
+        return false;
+    }
+
+    std::filesystem::path new_branch_file_path = get_heads_directory() / branch_name;
+    std::error_code ec;
+
+    if (std::filesystem::exists(new_branch_file_path, ec)) {
+        std::cerr << "错误: 分支 '" << branch_name << "' 已存在。" << std::endl;
+        return false;
+    }
+    if (ec) {
+        std::cerr << "错误: 检查分支文件 '" << new_branch_file_path.string() << "' 是否存在时出错: " << ec.message() << std::endl;
+        return false;
+    }
+
+    std::string target_commit_hash;
+
+    if (!start_point_commit_hash_param.empty()) {
+        // 如果用户指定了起点 Commit 哈希
+        std::optional<string> full_hash_ptr = _resolve_commit_ish_to_full_hash(start_point_commit_hash_param);
+
+        if (full_hash_ptr) { // 基本的哈希长度检查
+            // 验证 commit_hash 是否真的存在于对象库中
+            string full_hash = *full_hash_ptr;
+            auto commit_opt = Commit::load_by_hash(full_hash, get_objects_directory());
             if (!commit_opt) {
                 std::cerr << "错误: 起点Commit '" << full_hash<< "' 未找到。" << std::endl;
                 return false;
@@ -1275,19 +2056,11 @@ void Repository::branch_list() const {
     bool head_is_detached = false;
 
     // 1. 读取 HEAD 文件以确定当前分支或状态
-    std::filesystem::path head_file_path = get_head_file_path();
-    if (std::filesystem::exists(head_file_path)) {
-        std::ifstream head_ifs(head_file_path);
-        std::string head_content_line;
-        if (std::getline(head_ifs, head_content_line)) {
-            if (!head_content_line.empty() && (head_content_line.back() == '\n' || head_content_line.back() == '\r')) { head_content_line.pop_back(); }
-            if (!head_content_line.empty() && head_content_line.back() == '\r') { head_content_line.pop_back(); }
-
-            if (head_content_line.rfind("ref: refs/heads/", 0) == 0) {
-                current_branch_name_from_head = head_content_line.substr(std::string("ref: refs/heads/").length());
-            } else if (head_content_line.length() == 40) {
-                head_is_detached = true;
-            }
+    if (std::optional<std::string> head_content_line = _read_ref_file(get_head_file_path())) {
+        if (head_content_line->rfind("ref: refs/heads/", 0) == 0) {
+            current_branch_name_from_head = head_content_line->substr(std::string("ref: refs/heads/").length());
+        } else if (ObjectFormat::is_id_length(head_content_line->length())) {
+            head_is_detached = true;
         }
     }
 
@@ -1383,6 +2156,11 @@ bool Repository::branch_delete(const std::string& branch_name, bool force) {
         }
         head_ifs.close();
     }
+    if (auto other_worktree = _worktree_with_branch(branch_name)) {
+        std::cerr << "错误: 不能删除分支 '" << branch_name << "'，它已在工作树 '"
+                  << other_worktree->string() << "' 中检出。" << std::endl;
+        return false;
+    }
 
     // 5. (简化版：跳过合并状态检查)
 
@@ -1425,7 +2203,7 @@ bool Repository::switch_branch(const std::string& target_identifier) {
         // target_identifier 是一个已存在的分支名
         std::ifstream branch_file_ifs(potential_branch_file_path);
         std::string commit_hash_from_branch;
-        if (!(branch_file_ifs >> commit_hash_from_branch) || commit_hash_from_branch.length() != 40) {
+        if (!(branch_file_ifs >> commit_hash_from_branch) || !ObjectFormat::is_id_length(commit_hash_from_branch.length())) {
             std::cerr << "错误: 无法读取分支 '" << target_identifier << "' 的有效 Commit 哈希。" << std::endl;
             return false;
         }
@@ -1450,6 +2228,12 @@ bool Repository::switch_branch(const std::string& target_identifier) {
             std::cout << "已在分支 '" << target_identifier << "'" << std::endl;
             return true;
         }
+        // 同一分支不能同时在两个工作树中检出 (否则一个工作树的提交会让另一个的索引和工作目录过时)
+        if (auto other_worktree = _worktree_with_branch(target_identifier)) {
+            std::cerr << "错误: 分支 '" << target_identifier << "' 已在工作树 '"
+                      << other_worktree->string() << "' 中检出。" << std::endl;
+            return false;
+        }
 
     } else if (ec) { // 检查分支文件是否存在时发生错误
         std::cerr << "错误: 检查目标 '" << target_identifier << "' 是否为分支时出错: " << ec.message() << std::endl;
@@ -1507,7 +2291,7 @@ bool Repository::switch_branch(const std::string& target_identifier) {
 
     // 5. 更新索引以匹配目标 Tree
     index_manager_.clear_in_memory(); //
-    _populate_index_from_tree_recursive(target_root_tree_hash, "", index_manager_); //
+    _populate_index_from_tree_recursive(target_root_tree_hash, PathTable::ROOT, index_manager_); //
     if (!index_manager_.write()) { //
         std::cerr << "严重错误: 更新索引文件以匹配目标 '" << target_identifier << "' 失败！" << std::endl;
         return false;
@@ -1537,6 +2321,169 @@ bool Repository::switch_branch(const std::string& target_identifier) {
 }
 
 
+/**
+ * @brief 为指定分支新建一个链接工作树，与本仓库共享对象库、引用和配置。
+ * @details
+ *  管理目录为 <公共目录>/worktrees/<名称>，保存该工作树自己的 HEAD 和 index，
+ *  以及 commondir (公共目录) 和 gitdir (工作树 .biogit 文件的位置)。
+ *  工作树根目录下的 .biogit 是一个文件，内容为 "biogitdir: <管理目录>"。
+ * @param worktree_path 新工作树的路径 (不存在或为空目录)。
+ * @param branch_name 要检出的本地分支，不能已在其他工作树中检出。
+ * @return 如果成功，返回 true；否则返回 false。
+ */
+bool Repository::worktree_add(const std::filesystem::path& worktree_path, const std::string& branch_name) {
+    std::error_code ec;
+
+    // 1. 检查分支：必须存在，且未在任何工作树 (包括当前工作树) 中检出
+    if (!branch_exists(branch_name)) {
+        std::cerr << "错误: 分支 '" << branch_name << "' 不存在。" << std::endl;
+        return false;
+    }
+    if (auto other_worktree = _worktree_with_branch(branch_name, false)) {
+        std::cerr << "错误: 分支 '" << branch_name << "' 已在工作树 '"
+                  << other_worktree->string() << "' 中检出。" << std::endl;
+        return false;
+    }
+    std::optional<std::string> commit_hash_opt = _resolve_commit_ish_to_full_hash(branch_name);
+    if (!commit_hash_opt) return false;
+    auto commit_opt = Commit::load_by_hash(*commit_hash_opt, get_objects_directory());
+    if (!commit_opt) {
+        std::cerr << "错误: 无法加载分支 '" << branch_name << "' 指向的 Commit。" << std::endl;
+        return false;
+    }
+
+    // 2. 检查目标路径：不存在或为空目录
+    std::filesystem::path abs_worktree_path = std::filesystem::absolute(worktree_path).lexically_normal();
+    if (std::filesystem::exists(abs_worktree_path, ec)) {
+        if (!std::filesystem::is_directory(abs_worktree_path, ec) || !std::filesystem::is_empty(abs_worktree_path, ec)) {
+            std::cerr << "错误: '" << abs_worktree_path.string() << "' 已存在且不是空目录。" << std::endl;
+            return false;
+        }
+    } else if (!std::filesystem::create_directories(abs_worktree_path, ec)) {
+        std::cerr << "错误: 无法创建目录 '" << abs_worktree_path.string() << "': " << ec.message() << std::endl;
+        return false;
+    }
+
+    // 3. 创建管理目录 (名称取目录名，重名时追加序号)
+    const std::filesystem::path worktrees_dir = common_dir_ / WORKTREES_DIR_NAME;
+    std::string base_name = abs_worktree_path.filename().string();
+    if (base_name.empty()) base_name = "worktree";
+    std::string name = base_name;
+    for (int suffix = 1; std::filesystem::exists(worktrees_dir / name, ec); ++suffix) {
+        name = base_name + std::to_string(suffix);
+    }
+    const std::filesystem::path admin_dir = worktrees_dir / name;
+    if (!std::filesystem::create_directories(admin_dir, ec)) {
+        std::cerr << "错误: 无法创建工作树管理目录 '" << admin_dir.string() << "': " << ec.message() << std::endl;
+        return false;
+    }
+    {
+        std::ofstream head_ofs(admin_dir / HEAD_FILE_NAME, std::ios::trunc);
+        head_ofs << "ref: refs/heads/" << branch_name << "\n";
+        std::ofstream common_ofs(admin_dir / "commondir", std::ios::trunc);
+        common_ofs << common_dir_.generic_string() << "\n";
+        std::ofstream gitdir_ofs(admin_dir / "gitdir", std::ios::trunc);
+        gitdir_ofs << (abs_worktree_path / MYGIT_DIR_NAME).generic_string() << "\n";
+        std::ofstream link_ofs(abs_worktree_path / MYGIT_DIR_NAME, std::ios::trunc);
+        link_ofs << WORKTREE_LINK_PREFIX << admin_dir.generic_string() << "\n";
+        if (!head_ofs.good() || !common_ofs.good() || !gitdir_ofs.good() || !link_ofs.good()) {
+            std::cerr << "错误: 写入工作树 '" << abs_worktree_path.string() << "' 的管理文件失败。" << std::endl;
+            return false;
+        }
+    }
+
+    // 4. 检出分支内容并写入该工作树自己的索引
+    std::optional<Repository> worktree_opt = load(abs_worktree_path);
+    if (!worktree_opt) return false;
+    if (!worktree_opt->_update_working_directory_from_tree(commit_opt->tree_hash_hex, {})) {
+        std::cerr << "错误: 检出分支 '" << branch_name << "' 到工作树失败。" << std::endl;
+        return false;
+    }
+    worktree_opt->index_manager_.clear_in_memory();
+    worktree_opt->_populate_index_from_tree_recursive(commit_opt->tree_hash_hex, PathTable::ROOT, worktree_opt->index_manager_);
+    if (!worktree_opt->index_manager_.write()) {
+        std::cerr << "错误: 写入工作树索引失败。" << std::endl;
+        return false;
+    }
+
+    std::cout << "已创建工作树 '" << abs_worktree_path.string() << "' (分支 '" << branch_name << "', "
+              << commit_hash_opt->substr(0, 7) << ")" << std::endl;
+    return true;
+}
+
+
+/**
+ * @brief 列出主工作树和所有链接工作树：路径、HEAD 指向的 Commit 和分支。
+ */
+void Repository::worktree_list() const {
+    for (const auto& [worktree_root, admin_dir] : _list_worktrees()) {
+        std::ifstream head_ifs(admin_dir / HEAD_FILE_NAME);
+        std::string head_line;
+        std::getline(head_ifs, head_line);
+        while (!head_line.empty() && (head_line.back() == '\r' || head_line.back() == ' ')) head_line.pop_back();
+
+        std::string commit_hash = head_line;
+        std::string branch_label = "(分离 HEAD)";
+        if (head_line.rfind("ref: refs/heads/", 0) == 0) {
+            const std::string branch = head_line.substr(16);
+            branch_label = "[" + branch + "]";
+            std::ifstream branch_ifs(get_heads_directory() / branch);
+            commit_hash.clear();
+            branch_ifs >> commit_hash;
+        }
+        std::cout << worktree_root.string() << "  "
+                  << (commit_hash.size() >= 7 ? commit_hash.substr(0, 7) : std::string("0000000")) << " "
+                  << branch_label << std::endl;
+    }
+}
+
+
+/**
+ * @brief (内部) 列出共享同一公共目录的所有工作树：(工作树根目录, 管理目录)，主工作树在前。
+ * @details 工作树目录已被删除的管理目录 (gitdir 指向的文件不存在) 视为过期，不列出。
+ */
+std::vector<std::pair<std::filesystem::path, std::filesystem::path>> Repository::_list_worktrees() const {
+    std::error_code ec;
+    std::vector<std::pair<std::filesystem::path, std::filesystem::path>> worktrees;
+    worktrees.emplace_back(common_dir_.parent_path(), common_dir_);
+
+    std::vector<std::filesystem::path> admin_dirs;
+    for (const auto& entry : std::filesystem::directory_iterator(common_dir_ / WORKTREES_DIR_NAME, ec)) {
+        if (entry.is_directory(ec)) admin_dirs.push_back(entry.path());
+    }
+    std::sort(admin_dirs.begin(), admin_dirs.end());
+    for (const auto& admin_dir : admin_dirs) {
+        std::ifstream gitdir_ifs(admin_dir / "gitdir");
+        std::string link_file;
+        if (!std::getline(gitdir_ifs, link_file) || link_file.empty()) continue;
+        if (!std::filesystem::is_regular_file(link_file, ec)) continue;
+        worktrees.emplace_back(std::filesystem::path(link_file).parent_path(), admin_dir);
+    }
+    return worktrees;
+}
+
+
+/**
+ * @brief (内部) 查找已检出指定分支的工作树。
+ * @param branch_name 分支名称。
+ * @param skip_current 是否跳过当前工作树。
+ * @return 检出该分支的工作树根目录；没有则返回 std::nullopt。
+ */
+std::optional<std::filesystem::path> Repository::_worktree_with_branch(const std::string& branch_name,
+                                                                       bool skip_current) const {
+    const std::string expected_ref = "ref: refs/heads/" + branch_name;
+    for (const auto& [worktree_root, admin_dir] : _list_worktrees()) {
+        if (skip_current && admin_dir.lexically_normal() == mygit_dir_.lexically_normal()) continue;
+        std::ifstream head_ifs(admin_dir / HEAD_FILE_NAME);
+        std::string head_line;
+        std::getline(head_ifs, head_line);
+        while (!head_line.empty() && (head_line.back() == '\r' || head_line.back() == ' ')) head_line.pop_back();
+        if (head_line == expected_ref) return worktree_root;
+    }
+    return std::nullopt;
+}
+
+
 /**
  * @brief 显示不同版本之间文件内容的具体差异
  * @param options ： DiffOptions类型
@@ -1555,6 +2502,17 @@ void Repository::diff(const DiffOptions& options) {
         }
     }
 
+    // 摘要模式下只收集改动列表，最后统一输出
+    const bool summary_mode = options.output_format != DiffOutputFormat::PATCH;
+    // 只列路径的模式不读取任何 Blob：重命名检测只按哈希做精确匹配
+    const bool names_only = options.output_format == DiffOutputFormat::NAME_ONLY ||
+                            options.output_format == DiffOutputFormat::NAME_STATUS;
+    std::vector<DiffFileChange> summary_changes;
+    // 补丁模式下逐文件的 diff 任务 (读取 Blob、比较、格式化)，按路径顺序收集后并行执行
+    std::vector<OrderedTaskPool::Task> diff_tasks;
+    // 各任务共用的配置只读取一次 (任务在本函数返回前执行完毕，按引用捕获)
+    const DiffSettings settings = _diff_settings();
+
     // --- 模式选择 ---
 
     // 模式 3: 比较两个指定的 Commit / 分支
@@ -1590,13 +2548,21 @@ void Repository::diff(const DiffOptions& options) {
         if (!commit1_obj_opt) { std::cerr << "错误: 无法加载 commit '" << options.commit1_hash_str << "' (resolved to " << full_hash1.substr(0,7) << ")" << std::endl; return; }
         if (!commit2_obj_opt) { std::cerr << "错误: 无法加载 commit '" << options.commit2_hash_str << "' (resolved to " << full_hash2.substr(0,7) << ")" << std::endl; return; }
 
-        // 加载两个 commit 各自根树的内容到 map 中
+        // 加载两个 commit 各自根树的内容到 map 中 (指定了路径时只沿路径展开对应的子树)
         // map 结构: 文件相对路径 -> {blob 哈希, 文件模式}
         std::map<std::filesystem::path, std::pair<std::string, std::string>> files_map1;
-        _load_tree_contents_recursive(commit1_obj_opt->tree_hash_hex, "", files_map1); //
-
         std::map<std::filesystem::path, std::pair<std::string, std::string>> files_map2;
-        _load_tree_contents_recursive(commit2_obj_opt->tree_hash_hex, "", files_map2);
+        if (options.paths_to_diff.empty()) {
+            _load_tree_contents_recursive(commit1_obj_opt->tree_hash_hex, "", files_map1); //
+            _load_tree_contents_recursive(commit2_obj_opt->tree_hash_hex, "", files_map2);
+        } else {
+            for (const auto& p_user_input : options.paths_to_diff) {
+                std::optional<std::filesystem::path> rel_p_opt = normalize_and_relativize_path(p_user_input);
+                if (!rel_p_opt) continue; // 下面收集路径时会给出警告
+                _load_tree_contents_at_path(commit1_obj_opt->tree_hash_hex, *rel_p_opt, files_map1);
+                _load_tree_contents_at_path(commit2_obj_opt->tree_hash_hex, *rel_p_opt, files_map2);
+            }
+        }
 
         // 收集需要处理的路径集合
         std::set<std::filesystem::path> paths_to_process;
@@ -1644,8 +2610,48 @@ void Repository::diff(const DiffOptions& options) {
         std::string label1_suffix = " (" + options.commit1_hash_str.substr(0, std::min((size_t)7, options.commit1_hash_str.length())) + ")";
         std::string label2_suffix = " (" + options.commit2_hash_str.substr(0, std::min((size_t)7, options.commit2_hash_str.length())) + ")";
 
+        // 重命名/复制检测：只存在于一边的文件之间进行配对
+        std::map<std::filesystem::path, const RenamePair*> renames_by_new_path;
+        std::set<std::filesystem::path> renamed_old_paths;
+        std::vector<RenamePair> rename_pairs;
+        if (options.detect_renames) {
+            std::map<std::filesystem::path, std::string> deleted_files, added_files, copy_sources;
+            for (const auto& path : paths_to_process) {
+                auto it1 = files_map1.find(path);
+                auto it2 = files_map2.find(path);
+                if (it1 != files_map1.end() && it2 == files_map2.end()) deleted_files[path] = it1->second.first;
+                else if (it1 == files_map1.end() && it2 != files_map2.end()) added_files[path] = it2->second.first;
+            }
+            if (options.detect_copies) {
+                for (const auto& [path, entry] : files_map1) {
+                    if (files_map2.count(path)) copy_sources[path] = entry.first;
+                }
+            }
+            rename_pairs = _detect_renames(deleted_files, added_files, copy_sources, options.detect_copies, options.rename_similarity,
+                                           names_only);
+            for (const auto& pair : rename_pairs) {
+                renames_by_new_path[pair.new_path] = &pair;
+                if (!pair.is_copy) renamed_old_paths.insert(pair.old_path);
+            }
+        }
+
         // 遍历所有需要处理的路径，进行比较
         for (const auto& path : paths_to_process) {
+            if (renamed_old_paths.count(path)) continue; // 已作为重命名的源输出
+            auto rename_it = renames_by_new_path.find(path);
+            if (rename_it != renames_by_new_path.end()) {
+                const RenamePair& rename_pair = *rename_it->second;
+                if (summary_mode) {
+                    summary_changes.push_back({rename_pair.is_copy ? 'C' : 'R', rename_pair.old_path, rename_pair.new_path,
+                                               rename_pair.old_blob_hash, rename_pair.new_blob_hash, false, rename_pair.similarity});
+                } else {
+                    diff_tasks.push_back([this, &settings, rename_pair, label1_suffix, label2_suffix](std::ostream& out) {
+                        _print_rename_diff(rename_pair, label1_suffix, label2_suffix, settings, out);
+                    });
+                }
+                continue;
+            }
+
             auto it1 = files_map1.find(path);
             auto it2 = files_map2.find(path);
             // 获取各自的 blob 哈希，如果文件不存在于某个 commit 中，则哈希为空字符串
@@ -1656,28 +2662,39 @@ void Repository::diff(const DiffOptions& options) {
             // 则内容相同，无需 diff
             if (blob_hash1 == blob_hash2) continue;
 
-            // 获取两个版本的行内容。如果 blob_hash 为空，则视为空文件内容。
-            auto lines1_opt = blob_hash1.empty() ? std::make_optional<std::vector<std::string>>({}) : _get_blob_lines(blob_hash1);
-            auto lines2_opt = blob_hash2.empty() ? std::make_optional<std::vector<std::string>>({}) : _get_blob_lines(blob_hash2);
-
-            // 确保能成功加载两边的内容（即使是空内容）才进行 diff
-            if (lines1_opt && lines2_opt) {
-                _perform_and_print_file_diff(path, *lines1_opt, label1_suffix, *lines2_opt, label2_suffix); //
+            if (summary_mode) { // 摘要模式：状态直接由 Tree 比较得出，不读取 Blob
+                char status = blob_hash1.empty() ? 'A' : (blob_hash2.empty() ? 'D' : 'M');
+                summary_changes.push_back({status, path, path, blob_hash1, blob_hash2});
+                continue;
             }
+
+            diff_tasks.push_back([this, &settings, path, blob_hash1, blob_hash2, label1_suffix, label2_suffix](std::ostream& out) {
+                if (_print_binary_diff_if_needed(path, path, blob_hash1, blob_hash2, false, {}, settings, out)) return;
+                // 获取两个版本的行内容。如果 blob_hash 为空，则视为空文件内容。
+                auto lines1_opt = blob_hash1.empty() ? std::make_optional<std::vector<std::string>>({}) : _get_blob_lines(blob_hash1);
+                auto lines2_opt = blob_hash2.empty() ? std::make_optional<std::vector<std::string>>({}) : _get_blob_lines(blob_hash2);
+
+                // 确保能成功加载两边的内容（即使是空内容）才进行 diff
+                if (lines1_opt && lines2_opt) {
+                    _perform_and_print_file_diff(path, *lines1_opt, label1_suffix, *lines2_opt, label2_suffix, settings, out);
+                }
+            });
         }
 
     } else if (options.staged) {
         // --- 模式 2: Index vs HEAD ---
         std::optional<std::string> head_commit_hash_opt = _get_head_commit_hash(); //
-        std::map<std::filesystem::path, std::pair<std::string, std::string>> head_files_map; // path -> {blob_hash, mode}
+        std::shared_ptr<const std::map<std::filesystem::path, std::pair<std::string, std::string>>> head_tree_files =
+            std::make_shared<const std::map<std::filesystem::path, std::pair<std::string, std::string>>>();
         if (head_commit_hash_opt) {
             auto commit_opt = Commit::load_by_hash(*head_commit_hash_opt, get_objects_directory());
             if (commit_opt) {
-                _load_tree_contents_recursive(commit_opt->tree_hash_hex, "", head_files_map);
+                head_tree_files = _flattened_tree(commit_opt->tree_hash_hex);
             } else {
                 std::cerr << "警告 (diff --staged): 无法加载 HEAD commit " << *head_commit_hash_opt << std::endl;
             }
         }
+        const auto& head_files_map = *head_tree_files; // path -> {blob_hash, mode}
         // 如果没有 HEAD commit (例如新仓库首次提交前), head_files_map 会为空。
 
         const auto& index_entries = index_manager_.get_all_entries();
@@ -1700,11 +2717,9 @@ void Repository::diff(const DiffOptions& options) {
                     const auto& user_spec_path = *rel_p_opt;
                     bool path_found_for_current_spec = false; // 用于判断此 p_user_input 是否找到了任何匹配项
                     // 检查是否为 Index 中的文件 (直接匹配)
-                    auto idx_entry_it = std::find_if(index_entries.begin(), index_entries.end(),
-                                                     [&](const IndexEntry& e){ return e.file_path == user_spec_path; });
-                    if (idx_entry_it != index_entries.end()) {
+                    if (const IndexEntry* idx_entry = index_manager_.find_entry(user_spec_path)) {
                         paths_to_process.insert(user_spec_path);
-                        index_files_map[user_spec_path] = idx_entry_it->blob_hash_hex;
+                        index_files_map[user_spec_path] = idx_entry->blob_hash_hex;
                         path_found_for_current_spec = true;
                     }
                     // 检查是否为 HEAD 中的文件 (直接匹配)
@@ -1736,17 +2751,55 @@ void Repository::diff(const DiffOptions& options) {
             // 对于已在 paths_to_process 中的文件，如果它在索引中，确保 index_files_map 有其条目
             for(const auto& path_in_set : paths_to_process) {
                 if(index_files_map.find(path_in_set) == index_files_map.end()) { // 如果还不在map里
-                     auto idx_entry_it = std::find_if(index_entries.begin(), index_entries.end(),
-                                                      [&](const IndexEntry& e){ return e.file_path == path_in_set;});
-                     if(idx_entry_it != index_entries.end()) {
-                         index_files_map[path_in_set] = idx_entry_it->blob_hash_hex;
+                     if(const IndexEntry* idx_entry = index_manager_.find_entry(path_in_set)) {
+                         index_files_map[path_in_set] = idx_entry->blob_hash_hex;
                      }
                 }
             }
         }
 
+        // 重命名/复制检测 (HEAD -> Index)
+        std::map<std::filesystem::path, const RenamePair*> renames_by_new_path;
+        std::set<std::filesystem::path> renamed_old_paths;
+        std::vector<RenamePair> rename_pairs;
+        if (options.detect_renames) {
+            std::map<std::filesystem::path, std::string> deleted_files, added_files, copy_sources;
+            for (const auto& path : paths_to_process) {
+                bool in_index = index_files_map.count(path) > 0;
+                auto it_head = head_files_map.find(path);
+                if (it_head != head_files_map.end() && !in_index) deleted_files[path] = it_head->second.first;
+                else if (it_head == head_files_map.end() && in_index) added_files[path] = index_files_map[path];
+            }
+            if (options.detect_copies) {
+                for (const auto& [path, entry] : head_files_map) {
+                    if (index_manager_.get_entry(path)) copy_sources[path] = entry.first;
+                }
+            }
+            rename_pairs = _detect_renames(deleted_files, added_files, copy_sources, options.detect_copies, options.rename_similarity,
+                                           names_only);
+            for (const auto& pair : rename_pairs) {
+                renames_by_new_path[pair.new_path] = &pair;
+                if (!pair.is_copy) renamed_old_paths.insert(pair.old_path);
+            }
+        }
+
         // 遍历确定的路径进行比较
         for (const auto& path : paths_to_process) {
+            if (renamed_old_paths.count(path)) continue;
+            auto rename_it = renames_by_new_path.find(path);
+            if (rename_it != renames_by_new_path.end()) {
+                const RenamePair& rename_pair = *rename_it->second;
+                if (summary_mode) {
+                    summary_changes.push_back({rename_pair.is_copy ? 'C' : 'R', rename_pair.old_path, rename_pair.new_path,
+                                               rename_pair.old_blob_hash, rename_pair.new_blob_hash, false, rename_pair.similarity});
+                } else {
+                    diff_tasks.push_back([this, &settings, rename_pair](std::ostream& out) {
+                        _print_rename_diff(rename_pair, " (HEAD)", " (Index)", settings, out);
+                    });
+                }
+                continue;
+            }
+
             auto it_idx = index_files_map.find(path);
             bool in_index = (it_idx != index_files_map.end());
             std::string index_blob_hash = in_index ? it_idx->second : "";
@@ -1758,17 +2811,27 @@ void Repository::diff(const DiffOptions& options) {
             // 如果两边都存在且哈希相同，或者两边都不存在，则跳过
             if (index_blob_hash == head_blob_hash && in_index == in_head) continue;
 
-            auto lines_head_opt = head_blob_hash.empty() ? std::make_optional<std::vector<std::string>>({}) : _get_blob_lines(head_blob_hash);
-            auto lines_index_opt = index_blob_hash.empty() ? std::make_optional<std::vector<std::string>>({}) : _get_blob_lines(index_blob_hash);
-
-            if(lines_head_opt && lines_index_opt) {
-                 _perform_and_print_file_diff(path, *lines_head_opt, " (HEAD)", *lines_index_opt, " (Index)");
+            if (summary_mode) { // 摘要模式：状态直接由 Index 与 Tree 比较得出
+                char status = !in_head ? 'A' : (!in_index ? 'D' : 'M');
+                summary_changes.push_back({status, path, path, head_blob_hash, index_blob_hash});
+                continue;
             }
+
+            diff_tasks.push_back([this, &settings, path, head_blob_hash, index_blob_hash](std::ostream& out) {
+                if (_print_binary_diff_if_needed(path, path, head_blob_hash, index_blob_hash, false, {}, settings, out)) return;
+                auto lines_head_opt = head_blob_hash.empty() ? std::make_optional<std::vector<std::string>>({}) : _get_blob_lines(head_blob_hash);
+                auto lines_index_opt = index_blob_hash.empty() ? std::make_optional<std::vector<std::string>>({}) : _get_blob_lines(index_blob_hash);
+
+                if(lines_head_opt && lines_index_opt) {
+                     _perform_and_print_file_diff(path, *lines_head_opt, " (HEAD)", *lines_index_opt, " (Index)", settings, out);
+                }
+            });
         }
 
     } else {
         // --- 模式 1: Working Directory vs Index ---
         const auto& index_entries = index_manager_.get_all_entries(); // 获取所有索引条目
+        const uintmax_t lfs_threshold = settings.lfs_threshold; // 大文件在工作区与索引之间按指针比较
 
         for (const auto& entry : index_entries) { // 遍历索引中的每个文件
             std::filesystem::path relative_path = entry.file_path; // 获取文件的相对路径
@@ -1788,60 +2851,104 @@ void Repository::diff(const DiffOptions& options) {
             }
             if (!process_this_path) continue; // 如果不需要处理此路径，则跳过
 
-            std::string hash_from_index = entry.blob_hash_hex; // 获取索引中的 blob 哈希
-            std::optional<std::vector<std::string>> lines_from_index_opt = _get_blob_lines(hash_from_index);
-            if (!lines_from_index_opt) { // 如果无法加载索引中的内容，记录错误并跳过
-                std::cerr << "警告 (diff): 无法加载索引中文件 '" << relative_path.string() << "' 的内容。" << std::endl;
+            if (summary_mode) {
+                // 摘要模式：先用 mtime 和大小快速判断 (与 status 相同)，只有元数据不同时才读取文件计算哈希
+                std::filesystem::path abs_wd_path = work_tree_root_ / relative_path;
+                std::error_code ec;
+                if (!std::filesystem::exists(abs_wd_path, ec)) {
+                    summary_changes.push_back({'D', relative_path, relative_path, entry.blob_hash_hex, ""});
+                    continue;
+                }
+                auto ftime_workdir = std::filesystem::last_write_time(abs_wd_path, ec);
+                bool metadata_differs = static_cast<bool>(ec);
+                if (!ec) {
+                    std::chrono::system_clock::time_point mtime_workdir(
+                        std::chrono::duration_cast<std::chrono::system_clock::duration>(ftime_workdir.time_since_epoch()));
+                    uintmax_t size_workdir = std::filesystem::file_size(abs_wd_path, ec);
+                    metadata_differs = ec || mtime_workdir != entry.mtime || size_workdir != entry.file_size;
+                }
+                if (!metadata_differs) continue;
+
+                std::string wd_blob_hash;
+                if (auto lfs_blob_hash_opt = _lfs_pointer_blob_hash(abs_wd_path, lfs_threshold)) {
+                    wd_blob_hash = *lfs_blob_hash_opt;
+                } else if (auto wd_hash_opt = _hash_workdir_file(abs_wd_path)) {
+                    wd_blob_hash = *wd_hash_opt;
+                }
+                if (wd_blob_hash != entry.blob_hash_hex) {
+                    summary_changes.push_back({'M', relative_path, relative_path, entry.blob_hash_hex, "", true});
+                }
                 continue;
             }
 
-            // 获取工作目录中对应文件的行内容
-            std::optional<std::vector<std::string>> lines_from_wd_opt = _get_workdir_lines(relative_path);
+            diff_tasks.push_back([this, &settings, relative_path, hash_from_index = entry.blob_hash_hex, index_mtime = entry.mtime,
+                                  index_size = entry.file_size, lfs_threshold](std::ostream& out) {
+                std::filesystem::path abs_path = work_tree_root_ / relative_path;
+                std::error_code exists_ec;
+                const bool wd_exists = std::filesystem::exists(abs_path, exists_ec);
+
+                // 大小和修改时间与索引记录一致时视为未改动 (与 status 相同)，不读取文件内容
+                if (wd_exists) {
+                    std::error_code stat_ec;
+                    auto ftime_workdir = std::filesystem::last_write_time(abs_path, stat_ec);
+                    uintmax_t size_workdir = stat_ec ? 0 : std::filesystem::file_size(abs_path, stat_ec);
+                    if (!stat_ec && size_workdir == index_size &&
+                        std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                            ftime_workdir.time_since_epoch())) == index_mtime) {
+                        return;
+                    }
+                }
 
-            if (!lines_from_wd_opt.has_value()) { // 文件在索引中，但在工作目录中不存在 (被删除)
-                _perform_and_print_file_diff(relative_path, *lines_from_index_opt, " (Index)", {}, " (Working Directory)");
-            } else { // 文件在索引和工作目录中都存在
-                // 计算工作目录文件的实际内容哈希，以判断是否真的发生了更改
-                std::vector<std::byte> wd_byte_content;
-                std::filesystem::path abs_wd_path = work_tree_root_ / relative_path;
-                std::ifstream wd_ifs_bytes(abs_wd_path, std::ios::binary);
-                if(wd_ifs_bytes) {
-                    wd_ifs_bytes.seekg(0, std::ios::end); std::streamsize size = wd_ifs_bytes.tellg();
-                    wd_ifs_bytes.seekg(0, std::ios::beg);
-                    if (size >= 0) { // 允许空文件
-                        wd_byte_content.resize(static_cast<size_t>(size));
-                        if (size > 0) { // 只有在文件非空时才读取
-                            if(!wd_ifs_bytes.read(reinterpret_cast<char*>(wd_byte_content.data()), size)){
-                                std::cerr << "警告 (diff): 读取工作目录文件 '" << abs_wd_path.string() << "' 内容失败。" << std::endl;
-                                // 可以选择跳过，或者进行基于已读取内容的diff（如果部分读取）
-                                // 为简单起见，如果读取失败，我们可能无法准确计算哈希，所以回退到直接内容比较
-                                 _perform_and_print_file_diff(relative_path, *lines_from_index_opt, " (Index)", *lines_from_wd_opt, " (Working Directory)");
-                                wd_ifs_bytes.close();
-                                continue;
-                            }
-                        }
-                    }  else { // 读取文件大小失败
-                        std::cerr << "警告 (diff): 获取工作目录文件 '" << abs_wd_path.string() << "' 大小失败。" << std::endl;
-                         _perform_and_print_file_diff(relative_path, *lines_from_index_opt, " (Index)", *lines_from_wd_opt, " (Working Directory)");
-                        wd_ifs_bytes.close();
-                        continue;
+                // 二进制文件不按行读取：流式计算哈希，内容确有变化时只打印摘要
+                auto index_probe = _probe_blob(hash_from_index);
+                auto wd_probe = wd_exists ? _probe_workdir_file(relative_path, lfs_threshold) : std::nullopt;
+                if ((index_probe && index_probe->binary) || (wd_probe && wd_probe->binary)) {
+                    if (!wd_exists) {
+                        _print_binary_diff_if_needed(relative_path, relative_path, hash_from_index, "", false, {}, settings, out);
+                        return;
+                    }
+                    std::optional<std::string> wd_hash = _hash_workdir_file(abs_path);
+                    if (!wd_hash || *wd_hash != hash_from_index) {
+                        _print_binary_diff_if_needed(relative_path, relative_path, hash_from_index, "", true, {}, settings, out);
                     }
-                } else { // 文件打开失败（理论上 _get_workdir_lines 已经检查过一次，但这里再次确保）
-                     std::cerr << "警告 (diff): 无法打开工作目录文件 '" << abs_wd_path.string() << "' 以计算哈希。" << std::endl;
-                     _perform_and_print_file_diff(relative_path, *lines_from_index_opt, " (Index)", *lines_from_wd_opt, " (Working Directory)");
-                     continue;
+                    return;
                 }
-                wd_ifs_bytes.close();
 
-                Blob wd_blob(wd_byte_content); //
-                std::string hash_wd = SHA1::sha1(wd_blob.serialize()); //
+                std::optional<std::vector<std::string>> lines_from_index_opt = _get_blob_lines(hash_from_index);
+                if (!lines_from_index_opt) { // 如果无法加载索引中的内容，记录错误并跳过
+                    std::cerr << "警告 (diff): 无法加载索引中文件 '" << relative_path.string() << "' 的内容。" << std::endl;
+                    return;
+                }
+
+                // 获取工作目录中对应文件的行内容
+                std::optional<std::vector<std::string>> lines_from_wd_opt = _get_workdir_lines(relative_path, lfs_threshold);
 
-                if (hash_wd != hash_from_index) { // 如果哈希不同，则内容已更改
-                    _perform_and_print_file_diff(relative_path, *lines_from_index_opt, " (Index)", *lines_from_wd_opt, " (Working Directory)");
+                if (!lines_from_wd_opt.has_value()) { // 文件在索引中，但在工作目录中不存在 (被删除)
+                    _perform_and_print_file_diff(relative_path, *lines_from_index_opt, " (Index)", {}, " (Working Directory)", settings, out);
+                } else if (auto lfs_blob_hash_opt = _lfs_pointer_blob_hash(abs_path, lfs_threshold)) {
+                    // 大文件：工作区一侧的“内容”就是它的指针文本，只比较指针
+                    if (*lfs_blob_hash_opt != hash_from_index) {
+                        _perform_and_print_file_diff(relative_path, *lines_from_index_opt, " (Index)", *lines_from_wd_opt, " (Working Directory)", settings, out);
+                    }
+                } else { // 文件在索引和工作目录中都存在：按内容哈希判断是否真的发生了更改
+                    std::optional<std::string> hash_wd = _hash_workdir_file(abs_path);
+                    if (!hash_wd) {
+                        // 无法计算哈希时回退为直接比较内容
+                        std::cerr << "警告 (diff): 无法读取工作目录文件 '" << abs_path.string() << "' 以计算哈希。" << std::endl;
+                    }
+                    if (!hash_wd || *hash_wd != hash_from_index) {
+                        _perform_and_print_file_diff(relative_path, *lines_from_index_opt, " (Index)", *lines_from_wd_opt, " (Working Directory)", settings, out);
+                    }
                 }
-            }
+            });
         }
     }
+
+    if (summary_mode) {
+        _print_diff_summary(summary_changes, options.output_format, settings);
+    } else {
+        _run_diff_tasks(diff_tasks);
+    }
 }
 
 
@@ -2097,7 +3204,7 @@ bool Repository::merge(const std::string& branch_to_merge_name) {
         // 通过
         if (!_update_working_directory_from_tree(theirs_commit_obj->tree_hash_hex, ours_files_map_ff)) { std::cerr << "错误: 快进合并时更新工作目录失败。" << std::endl; return false; } //
         index_manager_.clear_in_memory(); //
-        _populate_index_from_tree_recursive(theirs_commit_obj->tree_hash_hex, "", index_manager_); //
+        _populate_index_from_tree_recursive(theirs_commit_obj->tree_hash_hex, PathTable::ROOT, index_manager_); //
         if (!index_manager_.write()) { std::cerr << "严重错误: 快进合并时写入索引文件失败！" << std::endl; return false; } //
 
         std::filesystem::path branch_file_to_update = get_heads_directory() / current_branch_ref_path_str;
@@ -2132,6 +3239,42 @@ bool Repository::merge(const std::string& branch_to_merge_name) {
     _load_tree_contents_recursive(base_commit_obj->tree_hash_hex, "", base_files);
     _load_tree_contents_recursive(ours_commit_obj->tree_hash_hex, "", ours_files);
     _load_tree_contents_recursive(theirs_commit_obj->tree_hash_hex, "", theirs_files);
+    const auto ours_files_at_head = ours_files; // 更新工作目录时需要 HEAD 原始的文件列表
+
+    //    c.2.1 重命名检测：一边把文件 X 重命名为 Y 时，把另一边的 X 视为 Y 参与三路比较，
+    //          这样“一边改名、另一边修改内容”可以自动合并，而不是 删除/修改 冲突
+    auto detect_side_renames = [this, &base_files](
+            const std::map<std::filesystem::path, std::pair<std::string, std::string>>& side_files) {
+        std::map<std::filesystem::path, std::string> deleted_files, added_files;
+        for (const auto& [path, entry] : base_files) {
+            if (!side_files.count(path)) deleted_files[path] = entry.first;
+        }
+        for (const auto& [path, entry] : side_files) {
+            if (!base_files.count(path)) added_files[path] = entry.first;
+        }
+        return _detect_renames(deleted_files, added_files, {}, false, 50);
+    };
+    auto apply_renames = [&base_files](const std::vector<RenamePair>& renames,
+            std::map<std::filesystem::path, std::pair<std::string, std::string>>& other_side_files) {
+        for (const auto& rename : renames) {
+            auto other_it = other_side_files.find(rename.old_path);
+            // 只有另一边仍保留原路径、且目标路径两边都未被占用时才改键，避免覆盖真实文件
+            if (other_it == other_side_files.end() || other_side_files.count(rename.new_path) ||
+                base_files.count(rename.new_path)) {
+                continue;
+            }
+            std::cout << "  检测到重命名: " << rename.old_path.string() << " -> " << rename.new_path.string()
+                      << " (" << rename.similarity << "%)" << std::endl;
+            other_side_files[rename.new_path] = other_it->second;
+            other_side_files.erase(other_it);
+            base_files[rename.new_path] = base_files.at(rename.old_path);
+            base_files.erase(rename.old_path);
+        }
+    };
+    std::vector<RenamePair> theirs_renames = detect_side_renames(theirs_files);
+    std::vector<RenamePair> ours_renames = detect_side_renames(ours_files);
+    apply_renames(theirs_renames, ours_files);
+    apply_renames(ours_renames, theirs_files);
 
     //    c.3 不直接修改 index_manager_ ，通过临时变量 IndexEntry 列表用于最终的合并 commit  如果合并成功（无冲突），则用此结果更新 index_manager_
     std::vector<IndexEntry> merged_entries_accumulator; // 用于存储成功合并的条目
@@ -2251,7 +3394,7 @@ bool Repository::merge(const std::string& branch_to_merge_name) {
     //  4.2 刷新暂存区 ，加入所有合并文件
     std::string merged_final_tree_hash;
     if (!index_manager_.get_all_entries().empty()) {
-        auto merged_tree_hash_opt = _build_trees_and_get_root_hash(index_manager_.get_all_entries()); //
+        auto merged_tree_hash_opt = _build_trees_and_get_root_hash(index_manager_); //
         if (!merged_tree_hash_opt) { std::cerr<<"错误: 构建合并树失败"<<std::endl; return false; }
         merged_final_tree_hash = *merged_tree_hash_opt;
     } else {
@@ -2261,7 +3404,7 @@ bool Repository::merge(const std::string& branch_to_merge_name) {
     }
 
     //  4.3 更新工作目录  这个时候已经没用冲突， 随意选择一个文件列表就行
-    if (!_update_working_directory_from_tree(merged_final_tree_hash, ours_files)) { //
+    if (!_update_working_directory_from_tree(merged_final_tree_hash, ours_files_at_head)) { //
         std::cerr << "错误: 合并后更新工作目录失败。" << std::endl;
         return false;
     }
@@ -2292,11 +3435,13 @@ bool Repository::merge(const std::string& branch_to_merge_name) {
     auto new_merge_commit_hash_opt = new_merge_commit.save(get_objects_directory()); //
     if (!new_merge_commit_hash_opt) { std::cerr << "错误: 保存合并提交失败。" <<std::endl; return false; }
     std::string new_merge_commit_hash = *new_merge_commit_hash_opt;
+    _record_changed_paths(new_merge_commit_hash);
 
     std::cout << "Merge made by 'simple' strategy." << std::endl;
     std::cout << "Committed merge " << new_merge_commit_hash.substr(0,7) << std::endl;
 
-    //  4.5 更新当前分支的引用或直接更新 HEAD
+    //  4.5 更新当前分支的引用或直接更新 HEAD (引用指向的对象先落盘)
+    if (!_sync_objects()) return false;
     if (is_head_currently_on_branch && !current_branch_ref_path_str.empty()) {
         std::filesystem::path branch_file_to_update = get_heads_directory() / current_branch_ref_path_str;
         std::ofstream m_branch_ofs(branch_file_to_update, std::ios::trunc);
@@ -2548,7 +3693,7 @@ std::vector<std::pair<std::string, std::string>> Repository::get_all_local_refs(
                 std::filesystem::path ref_file_path = entry.path();
                 std::ifstream ref_file(ref_file_path);
                 std::string commit_hash;
-                if (ref_file >> commit_hash && commit_hash.length() == 40) {
+                if (ref_file >> commit_hash && ObjectFormat::is_id_length(commit_hash.length())) {
                     // 构造完整的引用名称，例如 "refs/heads/main"
                     std::string ref_full_name = "refs/heads/" + ref_file_path.filename().string();
                     refs_info.push_back({ref_full_name, commit_hash});
@@ -2574,7 +3719,7 @@ std::vector<std::pair<std::string, std::string>> Repository::get_all_local_refs(
                 std::ifstream tag_file(tag_file_path);
                 std::string object_hash; // 标签可能指向commit，也可能指向tag对象（附注标签）
                                         // 对于轻量标签，这里直接是commit哈希
-                if (tag_file >> object_hash && object_hash.length() == 40) {
+                if (tag_file >> object_hash && ObjectFormat::is_id_length(object_hash.length())) {
                     // 构造完整的标签名称，例如 "refs/tags/v1.0"
                     std::string tag_full_name = "refs/tags/" + tag_file_path.filename().string();
 
@@ -2642,6 +3787,19 @@ std::optional<std::vector<char>> Repository::get_raw_object_content(const std::s
     }
     // 对于空对象（理论上不应该有，但以防万一），buffer 会是空的，这是正确的。
 
+    // 经编解码器存储的对象还原为规范字节 (对端按规范字节校验哈希)
+    if (!buffer.empty() && buffer[0] == ObjectCodecs::MAGIC[0]) {
+        std::vector<std::byte> stored_bytes(buffer.size());
+        std::memcpy(stored_bytes.data(), buffer.data(), buffer.size());
+        auto object_bytes = ObjectCodecs::decode_from_storage(stored_bytes, get_objects_directory());
+        if (!object_bytes) {
+            std::cerr << "错误: 无法还原对象文件内容: " << object_file_path.string() << std::endl;
+            return std::nullopt;
+        }
+        buffer.assign(reinterpret_cast<const char*>(object_bytes->data()),
+                      reinterpret_cast<const char*>(object_bytes->data()) + object_bytes->size());
+    }
+
     return buffer; // 返回包含对象完整原始内容的字节向量
 }
 
@@ -2665,7 +3823,7 @@ bool Repository::object_exists(const std::string& object_hash) const {
  * @return 如果写入成功或对象已存在，返回 true；否则返回 false。
  */
 bool Repository::write_raw_object(const std::string& object_hash, const char* raw_data, uint32_t length) {
-    if (object_hash.length() != 40) {
+    if (!ObjectFormat::is_id_length(object_hash.length())) {
         std::cerr << "Repository Error (write_raw_object): Invalid hash length for '" << object_hash << "'." << std::endl;
         return false;
     }
@@ -2676,52 +3834,41 @@ bool Repository::write_raw_object(const std::string& object_hash, const char* ra
     // 不过，由于哈希已经在 LogicSystem 中校验过了，这里可以信任 object_hash 和 length 的匹配性。
 
     std::filesystem::path objects_dir = get_objects_directory(); // 获取 .biogit/objects/ 路径
-    std::filesystem::path subdir = objects_dir / object_hash.substr(0, 2); // 哈希前两位作为子目录
-    std::filesystem::path final_obj_path = subdir / object_hash.substr(2); // 后38位作为文件名
-    std::error_code ec;
 
-    // 1. 检查对象是否已存在
-    if (std::filesystem::exists(final_obj_path, ec)) {
-        // std::cout << "Repository Info (write_raw_object): Object " << object_hash << " already exists. No need to write." << std::endl;
+    // 1. 检查对象是否已存在 (包括备用对象库：fork 推送已在对象池中的对象时不重复存储)
+    if (ObjectAlternates::contains(objects_dir, object_hash)) {
         return true; // 对象已存在，视为成功
     }
-    if (ec) { // exists 检查本身出错
-        std::cerr << "Repository Error (write_raw_object): Error checking existence of " << final_obj_path.string() << ": " << ec.message() << std::endl;
-        return false;
-    }
 
-    // 2. 创建子目录 (如果不存在)
-    if (!std::filesystem::exists(subdir, ec)) {
-        if (!std::filesystem::create_directories(subdir, ec)) {
-            std::cerr << "Repository Error (write_raw_object): Failed to create object subdir: " << subdir.string() << " - " << ec.message() << std::endl;
-            return false;
-        }
-    } else if (!std::filesystem::is_directory(subdir, ec)) { // 如果路径存在但不是目录
-        std::cerr << "Repository Error (write_raw_object): Object subdir path exists but is not a directory: " << subdir.string() << std::endl;
-        return false;
-    }
-    if (ec) { // is_directory 或 create_directories 的其他错误
-        std::cerr << "Repository Error (write_raw_object): Filesystem error with subdir " << subdir.string() << ": " << ec.message() << std::endl;
+    // 2. 写入对象文件 (序列内容经存储层编解码器压缩存放；写入层保证不会留下不完整的对象)
+    std::vector<std::byte> object_bytes(length);
+    if (length > 0) std::memcpy(object_bytes.data(), raw_data, length);
+    std::vector<std::byte> stored_bytes = ObjectCodecs::encode_for_storage(object_bytes, {}, objects_dir);
+    if (!ObjectWriter::write(objects_dir, object_hash, stored_bytes)) {
+        std::cerr << "Repository Error (write_raw_object): Failed to write object " << object_hash << "." << std::endl;
         return false;
     }
+    // std::cout << "Repository Info (write_raw_object): Successfully wrote object " << object_hash << std::endl;
+    return true;
+}
 
-    // 3. 写入对象文件
-    std::ofstream ofs(final_obj_path, std::ios::binary | std::ios::trunc); // 以二进制和覆盖模式打开
-    if (!ofs.is_open()) {
-        std::cerr << "Repository Error (write_raw_object): Failed to open object file for writing: " << final_obj_path.string() << std::endl;
-        return false;
-    }
-    if (length > 0) { // 只有当有数据时才写入
-        ofs.write(raw_data, length);
-    }
-    ofs.close();
 
-    if (!ofs.good()) { // 检查写入和关闭操作是否都成功
-        std::cerr << "Repository Error (write_raw_object): Failed to write or close object file: " << final_obj_path.string() << std::endl;
-        std::filesystem::remove(final_obj_path, ec); // 尝试删除写入失败或不完整的文件
-        return false;
+/**
+ * @brief 检查引用全名能否安全地作为公共目录下的相对路径使用 (以 "refs/" 开头，没有 ".."、反斜杠、控制字符、空分量或 "." 分量)。
+ */
+bool Repository::is_valid_ref_name(const std::string& ref_full_name) {
+    if (ref_full_name.rfind("refs/", 0) != 0 || ref_full_name.find("..") != std::string::npos) return false;
+    for (char c : ref_full_name) {
+        if (c == '\\' || static_cast<unsigned char>(c) < 0x20 || c == 0x7f) return false;
+    }
+    size_t start = 0;
+    while (start <= ref_full_name.size()) {
+        size_t end = ref_full_name.find('/', start);
+        if (end == std::string::npos) end = ref_full_name.size();
+        const std::string_view component(ref_full_name.data() + start, end - start);
+        if (component.empty() || component == ".") return false;
+        start = end + 1;
     }
-    // std::cout << "Repository Info (write_raw_object): Successfully wrote object " << object_hash << std::endl;
     return true;
 }
 
@@ -2742,14 +3889,13 @@ Repository::UpdateRefResult Repository::update_ref(
 
     // 1. 参数校验：引用名称格式
     if (!(ref_full_name.rfind("refs/heads/", 0) == 0 || ref_full_name.rfind("refs/tags/", 0) == 0) ||
-        ref_full_name.back() == '/' || ref_full_name.find("..") != std::string::npos ||
-        ref_full_name.find("//") != std::string::npos) {
+        !is_valid_ref_name(ref_full_name)) {
         std::cerr << "Repository Error (update_ref): Invalid ref name format: " << ref_full_name << std::endl;
         return UpdateRefResult::INVALID_REF_NAME;
     }
 
     // 2. 参数校验：new_commit_hash 格式和存在性
-    if (new_commit_hash.length() != 40 || !std::all_of(new_commit_hash.begin(), new_commit_hash.end(), ::isxdigit)) {
+    if (new_commit_hash.length() != ObjectFormat::hex_length(get_object_format()) || !std::all_of(new_commit_hash.begin(), new_commit_hash.end(), ::isxdigit)) {
         std::cerr << "Repository Error (update_ref): Invalid new_commit_hash format: " << new_commit_hash << std::endl;
         return UpdateRefResult::NEW_COMMIT_NOT_FOUND; // 或者更具体的错误码
     }
@@ -2761,7 +3907,7 @@ Repository::UpdateRefResult Repository::update_ref(
     }
 
     // 3. 获取引用文件的路径
-    std::filesystem::path ref_file_path = mygit_dir_ / ref_full_name;
+    std::filesystem::path ref_file_path = common_dir_ / ref_full_name;
     std::error_code ec;
 
     std::string current_ref_value_on_server;
@@ -2773,7 +3919,7 @@ Repository::UpdateRefResult Repository::update_ref(
             return UpdateRefResult::IO_ERROR;
         }
         std::ifstream ifs(ref_file_path);
-        if (ifs >> current_ref_value_on_server && current_ref_value_on_server.length() == 40) {
+        if (ifs >> current_ref_value_on_server && ObjectFormat::is_id_length(current_ref_value_on_server.length())) {
             ref_existed_on_server = true;
         } else {
             // 文件存在但内容无效或为空，视为不存在或需要被覆盖
@@ -2833,6 +3979,10 @@ Repository::UpdateRefResult Repository::update_ref(
         return UpdateRefResult::IO_ERROR;
     }
 
+    // 推送上来的对象先落盘，再让引用指向它们
+    if (!_sync_objects()) {
+        return UpdateRefResult::IO_ERROR;
+    }
 
     std::ofstream ofs(ref_file_path, std::ios::trunc); // 覆盖写入
     if (!ofs.is_open()) {
@@ -2891,6 +4041,7 @@ bool Repository::push(const std::string& remote_name,
                       const std::string& remote_ref_full_name_on_server_param,
                       bool force,
                       const std::string& token) {
+    if (!_check_transport_object_format()) return false;
 
     std::cout << "Attempting to push local '" << local_ref_full_name_param
               << "' to remote '" << remote_name << "' as '" << remote_ref_full_name_on_server_param
@@ -2967,6 +4118,7 @@ bool Repository::push(const std::string& remote_name,
         return false;
     }
     std::cout << "  Successfully targeted remote repository '" << server_repo_path_from_url << "'." << std::endl;
+    _negotiate_wire_dictionary(client, token, false);
 
     std::optional<std::map<std::string, std::string>> remote_refs_map_opt = client.ListRemoteRefs(token); // <--- 传递 token
     if (!remote_refs_map_opt) {
@@ -3058,6 +4210,29 @@ bool Repository::push(const std::string& remote_name,
     }
 
     // --- 7. 上传缺失的对象 ---
+    // 大文件内容先于其指针 Blob 上传，服务器上的指针总能找到对应内容
+    std::vector<std::string> commits_for_lfs = commits_to_send_hashes;
+    if (!local_tip_hash.empty()) commits_for_lfs.push_back(local_tip_hash);
+    if (!_push_lfs_contents(client, token, commits_for_lfs)) {
+        client.Disconnect();
+        return false;
+    }
+    // 分块清单放在最后上传：服务器接收清单时会用已上传的 chunk 重组并校验 Blob 哈希
+    std::stable_partition(objects_to_upload_final_list.begin(), objects_to_upload_final_list.end(),
+                          [this](const std::string& hash) {
+                              auto object_path_opt = _find_object_file_by_prefix(hash);
+                              if (!object_path_opt) return true;
+                              std::ifstream ifs(*object_path_opt, std::ios::binary); // 只读取头部的类型
+                              std::string type_prefix(Blob::manifest_type_str().length() + 1, '\0');
+                              ifs.read(type_prefix.data(), static_cast<std::streamsize>(type_prefix.size()));
+                              return type_prefix != Blob::manifest_type_str() + " ";
+                          });
+    // 服务器上已有同一路径的旧版本时上传增量；服务器拒绝 (不支持或基准不一致) 后其余对象都完整上传
+    std::map<std::string, std::string> delta_bases = _collect_delta_bases(remote_tip_hash, commits_to_send_hashes);
+    bool delta_enabled = !delta_bases.empty();
+    std::string indexed_base_hash;             // 相邻的 chunk 常以同一对象为基准，复用其索引
+    std::vector<char> indexed_base_content;
+    std::unique_ptr<DeltaIndex> delta_index;
     for (const std::string& hash_to_upload : objects_to_upload_final_list) {
         std::optional<std::vector<char>> raw_content_opt = get_raw_object_content(hash_to_upload);
         if (!raw_content_opt) { // 包括内容为空的情况，get_raw_object_content 应该返回 nullopt
@@ -3065,6 +4240,31 @@ bool Repository::push(const std::string& remote_name,
             client.Disconnect();
             return false;
         }
+        auto base_it = delta_bases.find(hash_to_upload);
+        if (delta_enabled && base_it != delta_bases.end() && raw_content_opt->size() >= MIN_DELTA_TARGET_SIZE) {
+            if (indexed_base_hash != base_it->second) {
+                delta_index.reset();
+                indexed_base_hash = base_it->second;
+                if (auto base_content_opt = get_raw_object_content(base_it->second)) {
+                    indexed_base_content = std::move(*base_content_opt);
+                    delta_index = std::make_unique<DeltaIndex>(reinterpret_cast<const std::byte*>(indexed_base_content.data()),
+                                                               indexed_base_content.size());
+                }
+            }
+            std::optional<std::vector<std::byte>> delta_opt;
+            if (delta_index) { // 增量不到完整内容的一半才值得发送
+                delta_opt = delta_index->encode(reinterpret_cast<const std::byte*>(raw_content_opt->data()),
+                                                raw_content_opt->size(), raw_content_opt->size() / 2);
+            }
+            if (delta_opt) {
+                if (client.PutObjectDelta(token, hash_to_upload, base_it->second, *delta_opt)) {
+                    std::cout << "  Uploaded object " << hash_to_upload.substr(0, 7) << " as delta against " << base_it->second.substr(0, 7)
+                              << " (" << delta_opt->size() << " of " << raw_content_opt->size() << " bytes)" << std::endl;
+                    continue;
+                }
+                delta_enabled = false;
+            }
+        }
         if (!client.PutObject(token, hash_to_upload, *raw_content_opt)) { // <--- 传递 token
             std::cerr << "Push Error: Failed to upload object " << hash_to_upload.substr(0,7) << " to server." << std::endl;
             client.Disconnect();
@@ -3134,6 +4334,7 @@ bool Repository::push(const std::string& remote_name,
 bool Repository::fetch(const std::string& remote_name,
                        const std::string& token,
                        const std::string& ref_to_fetch_param /* = "" */) {
+    if (!_check_transport_object_format()) return false;
     std::cout << "Fetching from remote '" << remote_name << "'";
     if (!ref_to_fetch_param.empty()) {
         std::cout << " (ref: " << ref_to_fetch_param << ")";
@@ -3195,6 +4396,7 @@ bool Repository::fetch(const std::string& remote_name,
         return false;
     }
     std::cout << "  Successfully targeted remote repository '" << server_repo_path_from_url << "'." << std::endl;
+    _negotiate_wire_dictionary(client, token, true);
 
     // --- 3. 获取远程所有引用 (或特定引用) ---
     // ListRemoteRefs 现在需要 Token
@@ -3217,7 +4419,7 @@ bool Repository::fetch(const std::string& remote_name,
     auto remote_head_iter = all_remote_refs_map.find("HEAD");
     if (remote_head_iter != all_remote_refs_map.end()) {
         const std::string& remote_head_content = remote_head_iter->second; // 例如 "ref: refs/heads/main"
-        std::filesystem::path local_remote_head_path = mygit_dir_ / "refs" / "remotes" / remote_name / "HEAD";
+        std::filesystem::path local_remote_head_path = common_dir_ / "refs" / "remotes" / remote_name / "HEAD";
         std::error_code ec_head_write;
         std::filesystem::path remote_head_parent_dir = local_remote_head_path.parent_path();
 
@@ -3308,7 +4510,7 @@ bool Repository::fetch(const std::string& remote_name,
         // 构造本地对应的远程跟踪引用路径或标签路径
         if (remote_ref_full_name.starts_with("refs/heads/")) {
             std::string branch_name = remote_ref_full_name.substr(std::string("refs/heads/").length());
-            local_equivalent_ref_path_fs = mygit_dir_ / "refs" / "remotes" / remote_name / branch_name;
+            local_equivalent_ref_path_fs = common_dir_ / "refs" / "remotes" / remote_name / branch_name;
         } else if (remote_ref_full_name.starts_with("refs/tags/")) {
             std::string tag_name = remote_ref_full_name.substr(std::string("refs/tags/").length());
             local_equivalent_ref_path_fs = get_tags_directory() / tag_name;
@@ -3326,7 +4528,7 @@ bool Repository::fetch(const std::string& remote_name,
             std::filesystem::is_regular_file(local_equivalent_ref_path_fs, ec_ref_read_local)) {
             std::ifstream ifs(local_equivalent_ref_path_fs);
             ifs >> local_current_tip_hash_for_ref;
-            if (local_current_tip_hash_for_ref.length() != 40) local_current_tip_hash_for_ref.clear(); // 无效则清空
+            if (!ObjectFormat::is_id_length(local_current_tip_hash_for_ref.length())) local_current_tip_hash_for_ref.clear(); // 无效则清空
         }
         if (ec_ref_read_local) { // 记录文件系统错误
             std::cerr << "Fetch Warning: Error checking local ref " << local_equivalent_ref_path_fs.string() << ": " << ec_ref_read_local.message() << std::endl;
@@ -3441,7 +4643,7 @@ bool Repository::fetch(const std::string& remote_name,
             }
         } else if (type_str_read == Tree::type_str()) {
             // Tree::deserialize 需要的是去除头部 ("tree size\0") 后的内容
-            auto tree_obj_opt = Tree::deserialize(actual_content_data_byte_vec);
+            auto tree_obj_opt = Tree::deserialize(actual_content_data_byte_vec, ObjectFormat::hex_length(get_object_format()));
             if (tree_obj_opt) {
                 for (const auto& entry : tree_obj_opt->entries) {
                     // Tree 条目中的哈希已经是其他对象的哈希 (Tree 或 Blob)
@@ -3451,8 +4653,19 @@ bool Repository::fetch(const std::string& remote_name,
                     }
                 }
             }
+        } else if (type_str_read == Blob::manifest_type_str()) {
+            // 分块存储的 Blob：只下载本地缺失的 chunk
+            auto chunk_hashes_opt = Blob::parse_manifest_chunks(actual_content_data_byte_vec);
+            if (chunk_hashes_opt) {
+                for (const auto& chunk_hash : *chunk_hashes_opt) {
+                    if (processing_queue_set.find(chunk_hash) == processing_queue_set.end()) {
+                        object_processing_queue.push(chunk_hash);
+                        processing_queue_set.insert(chunk_hash);
+                    }
+                }
+            }
         }
-        // Blob 对象没有其他 Git 对象依赖，不需要进一步操作
+        // Blob / chunk 对象没有其他 Git 对象依赖，不需要进一步操作
     } // end while object_processing_queue
 
     if (downloaded_count > 0) {
@@ -3464,8 +4677,19 @@ bool Repository::fetch(const std::string& remote_name,
     }
 
 
-    // --- 7. 更新本地的远程跟踪引用文件 ---
+    // --- 6.5 下载新 tip 引用到的大文件内容 (失败只警告：检出时会写出指针文件) ---
+    if (!critical_download_error) {
+        std::vector<std::string> fetched_tips;
+        for (const auto& ref_update_pair : refs_to_update_locally_fs_path) fetched_tips.push_back(ref_update_pair.second);
+        _fetch_lfs_contents(client, token, fetched_tips);
+    }
+
+    // --- 7. 更新本地的远程跟踪引用文件 (下载的对象先落盘) ---
     bool all_ref_updates_succeeded = true;
+    if (!_sync_objects()) {
+        client.Disconnect();
+        return false;
+    }
     if (critical_download_error && !refs_to_update_locally_fs_path.empty()){
         std::cerr << "Fetch Error: Due to critical object download errors, local refs will not be updated to potentially inconsistent states." << std::endl;
         all_ref_updates_succeeded = false;
@@ -3510,7 +4734,7 @@ bool Repository::fetch(const std::string& remote_name,
                 // 尝试获得相对于 .biogit 目录的引用名，以便更友好地显示
                 std::string display_ref_name = local_ref_file_fs.filename().string(); // 默认文件名
                 try { // relative 操作在某些情况下可能抛异常
-                    std::filesystem::path relative_to_mygit = std::filesystem::relative(local_ref_file_fs, mygit_dir_);
+                    std::filesystem::path relative_to_mygit = std::filesystem::relative(local_ref_file_fs, common_dir_);
                     display_ref_name = relative_to_mygit.generic_string();
                 } catch (const std::exception& e_rel) {
                     // 保持使用文件名
@@ -3755,9 +4979,26 @@ std::optional<Repository> Repository::clone(
     std::cout << "  获取数据完成。\n" << std::endl;
 
     // --- 步骤 5: 检出远程仓库的默认分支/状态 ---
-    // (这部分的逻辑与您之前的版本相同，它读取本地存储的远程 HEAD 信息，
-    //  创建本地分支，更新HEAD、Index、Workdir，设置上游)
-    std::filesystem::path local_stored_remote_head_path = cloned_repo.get_mygit_directory() / "refs" / "remotes" / "origin" / "HEAD";
+    // (读取本地存储的远程 HEAD 信息，创建本地分支，更新HEAD、Index、Workdir，设置上游)
+    if (!cloned_repo._checkout_remote_head("origin")) return std::nullopt;
+
+    // **重要**：根据您的简化方案，clone 时使用的临时 Token (clone_session_token)
+    // **不应该**被保存到新克隆的仓库的 .biogit 目录中。
+    // 用户需要在新仓库目录下显式执行 `biogit2 login` 来为该仓库获取并存储他们自己的 Token。
+
+    std::cout << "克隆完成。" << std::endl;
+    return cloned_repo;
+}
+
+
+/**
+ * @brief (内部) 克隆后检出远程的默认分支：按 refs/remotes/<远程名>/HEAD 创建同名本地分支 (没有时尝试 main)，
+ *        填充索引和工作目录，并设置上游跟踪。
+ * @param remote_name 远程名称。
+ * @return 如果成功 (或远程没有可检出的分支)，返回 true；否则返回 false。
+ */
+bool Repository::_checkout_remote_head(const std::string& remote_name) {
+    std::filesystem::path local_stored_remote_head_path = common_dir_ / "refs" / "remotes" / remote_name / "HEAD";
     std::string remote_default_branch_name_fallback = "main";
     std::string target_checkout_identifier = remote_default_branch_name_fallback;
     bool is_target_a_commit_hash = false;
@@ -3768,7 +5009,7 @@ std::optional<Repository> Repository::clone(
             if (!line.empty() && (line.back()=='\n'||line.back()=='\r')) line.pop_back(); if (!line.empty() && line.back()=='\r') line.pop_back();
             std::string ref_prefix = "ref: refs/heads/";
             if (line.rfind(ref_prefix,0)==0) { target_checkout_identifier = line.substr(ref_prefix.length()); is_target_a_commit_hash = false; std::cout << "  远程HEAD指向分支 '" << target_checkout_identifier << "'。" << std::endl;}
-            else if (line.length()==40 && std::all_of(line.begin(),line.end(),::isxdigit)) { target_checkout_identifier=line; is_target_a_commit_hash=true; std::cout << "  远程HEAD分离，指向commit " <<target_checkout_identifier.substr(0,7)<<"."<<std::endl;}
+            else if (ObjectFormat::is_id_length(line.length()) && std::all_of(line.begin(),line.end(),::isxdigit)) { target_checkout_identifier=line; is_target_a_commit_hash=true; std::cout << "  远程HEAD分离，指向commit " <<target_checkout_identifier.substr(0,7)<<"."<<std::endl;}
             else {std::cout << "  警告: 无法解析远程HEAD ('"<<line<<"')。尝试默认 '"<<remote_default_branch_name_fallback<<"'。" << std::endl; target_checkout_identifier = remote_default_branch_name_fallback; is_target_a_commit_hash = false;}
         } rth_ifs.close();
     } else {std::cout << "  未找到本地存储的远程HEAD。尝试默认 '"<<remote_default_branch_name_fallback<<"'。" << std::endl; target_checkout_identifier = remote_default_branch_name_fallback; is_target_a_commit_hash = false;}
@@ -3776,51 +5017,672 @@ std::optional<Repository> Repository::clone(
     std::string final_commit_to_checkout_hash;
     if (is_target_a_commit_hash) { final_commit_to_checkout_hash = target_checkout_identifier; }
     else {
-        std::optional<std::string> remote_branch_tip = cloned_repo._resolve_commit_ish_to_full_hash("origin/" + target_checkout_identifier);
-        if (!remote_branch_tip) { std::cerr << "错误: 无法找到 'origin/" << target_checkout_identifier << "' 的commit哈希。" << std::endl; return cloned_repo; }
+        std::optional<std::string> remote_branch_tip = _resolve_commit_ish_to_full_hash(remote_name + "/" + target_checkout_identifier);
+        if (!remote_branch_tip) { std::cerr << "错误: 无法找到 '" << remote_name << "/" << target_checkout_identifier << "' 的commit哈希。" << std::endl; return true; }
         final_commit_to_checkout_hash = *remote_branch_tip;
     }
 
     std::cout << "  正在检出 commit " << final_commit_to_checkout_hash.substr(0,7) << "..." << std::endl;
-    auto commit_obj = Commit::load_by_hash(final_commit_to_checkout_hash, cloned_repo.get_objects_directory());
-    if (!commit_obj) { std::cerr << "错误: 无法加载目标commit对象。" << std::endl; return std::nullopt;}
+    auto commit_obj = Commit::load_by_hash(final_commit_to_checkout_hash, get_objects_directory());
+    if (!commit_obj) { std::cerr << "错误: 无法加载目标commit对象。" << std::endl; return false;}
     std::string tree_hash = commit_obj->tree_hash_hex;
 
-    std::filesystem::path head_f = cloned_repo.get_head_file_path(); std::ofstream head_o(head_f, std::ios::trunc);
-    if (!head_o) { std::cerr << "错误: 打开HEAD文件失败。" << std::endl; return std::nullopt;}
+    std::filesystem::path head_f = get_head_file_path(); std::ofstream head_o(head_f, std::ios::trunc);
+    if (!head_o) { std::cerr << "错误: 打开HEAD文件失败。" << std::endl; return false;}
     if (is_target_a_commit_hash) { head_o << final_commit_to_checkout_hash << std::endl;}
     else {
         std::string local_branch = target_checkout_identifier;
-        if (!cloned_repo.branch_exists(local_branch)) {
-            if (!cloned_repo.branch_create(local_branch, final_commit_to_checkout_hash)) { std::cerr << "错误: 创建本地分支 '"<<local_branch<<"' 失败。"<<std::endl; head_o.close(); return std::nullopt;}
+        if (!branch_exists(local_branch)) {
+            if (!branch_create(local_branch, final_commit_to_checkout_hash)) { std::cerr << "错误: 创建本地分支 '"<<local_branch<<"' 失败。"<<std::endl; head_o.close(); return false;}
         }
         head_o << "ref: refs/heads/" << local_branch << std::endl;
     }
-    head_o.close(); if(!head_o.good()){ std::cerr << "错误: 写入HEAD文件失败。" << std::endl; return std::nullopt;}
+    head_o.close(); if(!head_o.good()){ std::cerr << "错误: 写入HEAD文件失败。" << std::endl; return false;}
 
-    cloned_repo.index_manager_.clear_in_memory();
-    cloned_repo._populate_index_from_tree_recursive(tree_hash, "", cloned_repo.index_manager_);
-    if (!cloned_repo.index_manager_.write()) { std::cerr << "错误: 写入初始索引失败。" << std::endl; return std::nullopt;}
+    index_manager_.clear_in_memory();
+    _populate_index_from_tree_recursive(tree_hash, PathTable::ROOT, index_manager_);
+    if (!index_manager_.write()) { std::cerr << "错误: 写入初始索引失败。" << std::endl; return false;}
     std::map<std::filesystem::path, std::pair<std::string, std::string>> empty_map;
-    if (!cloned_repo._update_working_directory_from_tree(tree_hash, empty_map)) { std::cerr << "错误: 更新工作目录失败。" << std::endl; return std::nullopt;}
+    if (!_update_working_directory_from_tree(tree_hash, empty_map)) { std::cerr << "错误: 更新工作目录失败。" << std::endl; return false;}
 
     if (!is_target_a_commit_hash) {
         std::string local_branch_cfg = target_checkout_identifier;
-        cloned_repo.config_set("branch." + local_branch_cfg + ".remote", "origin");
-        cloned_repo.config_set("branch." + local_branch_cfg + ".merge", "refs/heads/" + local_branch_cfg);
-        std::cout << "  本地分支 '" << local_branch_cfg << "' 已设置以跟踪 'origin/" << local_branch_cfg << "'。" << std::endl;
+        config_set("branch." + local_branch_cfg + ".remote", remote_name);
+        config_set("branch." + local_branch_cfg + ".merge", "refs/heads/" + local_branch_cfg);
+        std::cout << "  本地分支 '" << local_branch_cfg << "' 已设置以跟踪 '" << remote_name << "/" << local_branch_cfg << "'。" << std::endl;
     }
     std::cout << "  检出完成。" << std::endl;
+    return true;
+}
+
+
+/**
+ * @brief 把指定引用的历史写入离线传输包，供没有网络连接时批量传输。
+ * @param bundle_path 输出文件路径。
+ * @param ref_specs 引用列表：分支名、标签名、引用全名或 --all；"<基准>..<引用>" 形式表示接收方已有 <基准>，
+ *        其可达的 Commit 和基准树中的对象不写入包内，<基准> 记为前置 Commit。
+ * @return 如果成功，返回 true；否则返回 false。
+ * @details 先只收集对象哈希，再逐个读出对象写入文件，内存中同时只保留一个对象的内容。
+ */
+bool Repository::bundle_create(const std::filesystem::path& bundle_path, const std::vector<std::string>& ref_specs) const {
+    if (!_check_transport_object_format()) return false;
+
+    // 1. 解析引用和前置 Commit
+    BundleHeader header;
+    if (!_resolve_ref_specs(ref_specs, header.refs, header.prerequisites)) return false;
+    if (header.refs.empty()) {
+        std::cerr << "错误: 没有要写入离线传输包的引用。" << std::endl;
+        return false;
+    }
+    {
+        std::ifstream head_ifs(get_head_file_path());
+        std::string head_line;
+        std::getline(head_ifs, head_line);
+        if (!head_line.empty() && head_line.back() == '\r') head_line.pop_back();
+        if (head_line.rfind("ref: ", 0) == 0) {
+            for (const auto& ref : header.refs) {
+                if (ref.first == head_line.substr(5)) header.head_ref = ref.first;
+            }
+        }
+    }
+
+    // 2. 前置 Commit 可达的 Commit 不写入；前置 Commit 树中的对象视为接收方已有
+    std::set<std::string> walked_commits;
+    auto walk_commits = [this, &walked_commits](std::vector<std::string> pending, std::vector<std::string>* out_commits) {
+        while (!pending.empty()) {
+            std::string commit_hash = pending.back();
+            pending.pop_back();
+            if (!walked_commits.insert(commit_hash).second) continue;
+            auto commit_opt = Commit::load_by_hash(commit_hash, get_objects_directory());
+            if (!commit_opt) continue;
+            if (out_commits) out_commits->push_back(commit_hash);
+            for (const auto& parent_hash : commit_opt->parent_hashes_hex) pending.push_back(parent_hash);
+        }
+    };
+    walk_commits(header.prerequisites, nullptr);
+    std::set<std::string> visited_objects;
+    {
+        std::set<std::string> known_objects;
+        for (const std::string& prerequisite : header.prerequisites) {
+            if (auto commit_opt = Commit::load_by_hash(prerequisite, get_objects_directory())) {
+                collect_objects_recursive_for_push(commit_opt->tree_hash_hex, known_objects, visited_objects);
+            }
+        }
+    }
+
+    // 3. 收集要写入的对象 (只保存哈希)
+    std::vector<std::string> tips;
+    for (const auto& [ref_name, hash] : header.refs) tips.push_back(hash);
+    std::vector<std::string> commits_to_bundle;
+    walk_commits(tips, &commits_to_bundle);
+    std::set<std::string> objects_to_bundle;
+    for (const std::string& commit_hash : commits_to_bundle) {
+        collect_objects_recursive_for_push(commit_hash, objects_to_bundle, visited_objects);
+    }
+
+    // 4. 顺序写入对象
+    BundleWriter writer;
+    if (!writer.open(bundle_path, header, objects_to_bundle.size())) return false;
+    for (const std::string& object_hash : objects_to_bundle) {
+        std::optional<std::vector<char>> raw_content = get_raw_object_content(object_hash);
+        if (!raw_content) {
+            std::cerr << "错误: 无法读取对象 " << object_hash.substr(0, 7) << "。" << std::endl;
+            return false;
+        }
+        if (!writer.add_object(object_hash, raw_content->data(), raw_content->size())) return false;
+    }
+    if (!writer.finish()) return false;
+
+    std::cout << "已创建离线传输包 '" << bundle_path.string() << "'：" << header.refs.size() << " 个引用，"
+              << commits_to_bundle.size() << " 个提交，" << objects_to_bundle.size() << " 个对象";
+    if (!header.prerequisites.empty()) std::cout << "，" << header.prerequisites.size() << " 个前置提交";
+    std::cout << "。" << std::endl;
+    return true;
+}
 
-    // **重要**：根据您的简化方案，clone 时使用的临时 Token (clone_session_token)
-    // **不应该**被保存到新克隆的仓库的 .biogit 目录中。
-    // 用户需要在新仓库目录下显式执行 `biogit2 login` 来为该仓库获取并存储他们自己的 Token。
 
+/**
+ * @brief 私有辅助方法：解析 bundle create / fast-export 的引用参数
+ * @details --all 展开为所有本地分支和标签；"<基准>..<引用>" 的 <基准> 可以是任意提交，
+ *  <引用> 必须是本地分支、标签或引用全名。
+ */
+bool Repository::_resolve_ref_specs(const std::vector<std::string>& ref_specs,
+                                    std::vector<std::pair<std::string, std::string>>& out_refs,
+                                    std::vector<std::string>& out_bases) const {
+    std::set<std::string> added_refs;
+    auto add_ref = [&](const std::string& full_ref_name) -> bool {
+        std::ifstream ref_ifs(common_dir_ / full_ref_name);
+        std::string hash;
+        if (!(ref_ifs >> hash) || !ObjectFormat::is_id_length(hash.length())) {
+            std::cerr << "错误: 无法读取引用 '" << full_ref_name << "'。" << std::endl;
+            return false;
+        }
+        if (added_refs.insert(full_ref_name).second) out_refs.emplace_back(full_ref_name, hash);
+        return true;
+    };
+    for (const std::string& spec : ref_specs) {
+        if (spec == "--all") {
+            for (const auto& [ref_name, hash] : get_all_local_refs()) {
+                if (ref_name != "HEAD" && !add_ref(ref_name)) return false;
+            }
+            continue;
+        }
+        std::string ref_part = spec;
+        size_t range_pos = spec.find("..");
+        if (range_pos != std::string::npos) {
+            std::optional<std::string> base_hash = _resolve_commit_ish_to_full_hash(spec.substr(0, range_pos));
+            if (!base_hash) return false;
+            out_bases.push_back(*base_hash);
+            ref_part = spec.substr(range_pos + 2);
+        }
+        std::string full_ref_name;
+        if (ref_part.rfind("refs/", 0) == 0) full_ref_name = ref_part;
+        else if (branch_exists(ref_part)) full_ref_name = "refs/heads/" + ref_part;
+        else if (std::filesystem::exists(get_tags_directory() / ref_part)) full_ref_name = "refs/tags/" + ref_part;
+        else {
+            std::cerr << "错误: '" << ref_part << "' 不是本地分支或标签。" << std::endl;
+            return false;
+        }
+        if (!is_valid_ref_name(full_ref_name)) {
+            std::cerr << "错误: 无效的引用名 '" << full_ref_name << "'。" << std::endl;
+            return false;
+        }
+        if (!add_ref(full_ref_name)) return false;
+    }
+    return true;
+}
+
+
+/**
+ * @brief 把指定引用的历史导出为 fast-import 格式的流。
+ * @param ref_specs 分支、标签、引用全名或 --all；"<基准>..<引用>" 表示只导出 <基准> 之后的提交。
+ * @param out 输出流。
+ * @return 如果成功，返回 true；否则返回 false。
+ */
+bool Repository::fast_export(const std::vector<std::string>& ref_specs, std::ostream& out) const {
+    std::vector<std::pair<std::string, std::string>> refs;
+    std::vector<std::string> bases;
+    if (!_resolve_ref_specs(ref_specs, refs, bases)) return false;
+    if (refs.empty()) {
+        std::cerr << "错误: 没有要导出的引用。" << std::endl;
+        return false;
+    }
+    FastExporter exporter(*this, out);
+    return exporter.run(refs, bases);
+}
+
+
+/**
+ * @brief 列出提交中某个路径的 Tree 条目
+ * 沿路径逐级二分查找，只读取路径经过的 Tree (以及要列出的那一个目录)，与树的总大小无关。
+ */
+bool Repository::ls_tree(const std::string &commit_ish, const std::string &relative_path) const {
+    // 1. 解析提交
+    std::optional<std::string> commit_hash_opt = _resolve_commit_ish_to_full_hash(commit_ish);
+    if (!commit_hash_opt) {
+        std::cerr << "错误: 无法解析提交 '" << commit_ish << "'。" << std::endl;
+        return false;
+    }
+    auto commit_opt = Commit::load_by_hash(*commit_hash_opt, get_objects_directory());
+    if (!commit_opt) {
+        std::cerr << "错误: 无法加载提交 " << commit_hash_opt->substr(0, 7) << "。" << std::endl;
+        return false;
+    }
+
+    // 2. 沿路径找到条目
+    std::string path = relative_path;
+    const bool list_contents = path.empty() || path.back() == '/';
+    while (!path.empty() && path.back() == '/') path.pop_back();
+    auto entry = _find_entry_in_tree(commit_opt->tree_hash_hex, path);
+    if (!entry) {
+        std::cerr << "错误: 路径 '" << relative_path << "' 不在提交 " << commit_hash_opt->substr(0, 7) << " 中。" << std::endl;
+        return false;
+    }
+
+    auto print_entry = [](const std::string& mode, const std::string& hash, const std::string& entry_path) {
+        std::cout << std::setw(6) << std::left << mode << " "
+                  << (mode == "040000" ? Tree::type_str() : Blob::type_str()) << " "
+                  << hash << "\t" << entry_path << std::endl;
+    };
+
+    // 3. 路径本身 (文件，或不以 '/' 结尾的目录)
+    if (!list_contents || entry->first != "040000") {
+        print_entry(entry->first, entry->second, path);
+        return true;
+    }
+
+    // 4. 目录的条目
+    auto tree_opt = Tree::load_by_hash(entry->second, get_objects_directory());
+    if (!tree_opt) {
+        std::cerr << "错误: 无法加载 Tree 对象 " << entry->second.substr(0, 7) << "。" << std::endl;
+        return false;
+    }
+    const std::string prefix = path.empty() ? "" : path + "/";
+    for (const auto& tree_entry : tree_opt->entries) {
+        print_entry(tree_entry.mode, tree_entry.sha1_hash_hex, prefix + tree_entry.name);
+    }
+    return true;
+}
+
+
+/**
+ * @brief 批量查询对象，供外部工具以一个常驻进程代替大量 show 调用。
+ * @details 仓库只加载一次；提交名解析、备用对象库列表、压缩字典等进程内缓存在各次查询之间共享，
+ *  "<提交>:<路径>" 查询还共享已读取的 Tree 条目。分块存储的大文件逐块写出，不会整个读入内存。
+ */
+bool Repository::cat_file_batch(std::istream& in, std::ostream& out, bool check_only) const {
+    TreeEntryCache tree_cache;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+
+        // 1. 解析对象名并读取头部
+        std::optional<std::string> object_hash = _resolve_object_name(line, &tree_cache);
+        std::optional<std::pair<std::string, uintmax_t>> header;
+        if (object_hash) header = _read_object_header(*object_hash);
+        if (!header) {
+            out << line << " missing\n";
+            out.flush();
+            continue;
+        }
+        out << *object_hash << " " << header->first << " " << header->second << "\n";
+
+        // 2. 写出内容
+        if (!check_only) {
+            bool content_ok = false;
+            auto chunk_list = header->first == Blob::type_str() ? Blob::read_chunk_list(*object_hash, get_objects_directory())
+                                                                : std::optional<std::vector<std::pair<std::string, size_t>>>{};
+            if (chunk_list && !chunk_list->empty()) {
+                content_ok = true;
+                for (const auto& [chunk_hash, chunk_size] : *chunk_list) {
+                    auto chunk_opt = Blob::load_chunk(chunk_hash, get_objects_directory());
+                    if (!chunk_opt) { content_ok = false; break; }
+                    out.write(reinterpret_cast<const char*>(chunk_opt->data()), static_cast<std::streamsize>(chunk_opt->size()));
+                }
+            } else if (auto parsed_result = read_and_parse_object_file_content(ObjectAlternates::locate(get_objects_directory(), *object_hash))) {
+                const auto& content = std::get<2>(*parsed_result);
+                out.write(reinterpret_cast<const char*>(content.data()), static_cast<std::streamsize>(content.size()));
+                content_ok = content.size() == header->second;
+            }
+            if (!content_ok) {
+                // 应答头部已写出，无法再改为 missing：中止，避免调用方按长度读取时错位
+                std::cerr << "错误: 读取对象 " << *object_hash << " 的内容失败。" << std::endl;
+                out.flush();
+                return false;
+            }
+            out << "\n";
+        }
+        out.flush();
+        if (!out.good()) return false;
+    }
+    return true;
+}
+
+
+/**
+ * @brief 把某个提交的树 (或其中一个路径) 以 tar 格式写出，不经过检出。
+ * @details
+ *  调用线程按 Tree 中的顺序遍历 (只加载 Tree 和文件头部)，为每个条目生成一个写出任务；
+ *  任务由 OrderedTaskPool 并行执行 (预读 Blob)，再按顺序写入输出，因此输出与线程数无关。
+ *  分块存储的大文件和内容库中的大文件按块拆成多个任务，内存中最多缓冲有限个块，不会整个读入。
+ *  所有条目的时间取提交时间，属主为 0，同一提交总是得到相同的归档。线程数由配置项 archive.threads 决定。
+ */
+bool Repository::archive(const std::string& commit_ish, const std::string& sub_path, const std::string& prefix,
+                         std::ostream& out, bool gzip) const {
+    // 1. 解析提交和路径
+    std::optional<std::string> commit_hash = _resolve_commit_ish_to_full_hash(commit_ish);
+    if (!commit_hash) return false;
+    auto commit_opt = Commit::load_by_hash(*commit_hash, get_objects_directory());
+    if (!commit_opt) {
+        std::cerr << "错误: 无法加载提交 " << commit_hash->substr(0, 7) << "。" << std::endl;
+        return false;
+    }
+    const int64_t mtime = std::chrono::duration_cast<std::chrono::seconds>(
+        commit_opt->committer.timestamp.time_since_epoch()).count();
+    std::vector<std::string> filter;
+    {
+        std::stringstream path_stream(sub_path);
+        std::string component;
+        while (std::getline(path_stream, component, '/')) {
+            if (component.empty() || component == ".") continue;
+            filter.push_back(component);
+        }
+    }
+    std::string path_prefix = prefix;
+    if (!path_prefix.empty() && path_prefix.back() != '/') path_prefix += '/';
+
+    // 2. 遍历树，生成按顺序输出的任务
+    const std::filesystem::path objects_dir = get_objects_directory();
+    const LfsStore lfs_store(common_dir_);
+    auto failed = std::make_shared<std::atomic<bool>>(false);
+    std::vector<OrderedTaskPool::Task> tasks;
+    tasks.emplace_back([header = Tar::global_header(*commit_hash, mtime)](std::ostream& task_out) { task_out << header; });
+
+    auto add_directory = [&](const std::string& path) {
+        Tar::EntryInfo info{path_prefix + path + "/", Tar::TYPE_DIRECTORY, 0755, 0, mtime, ""};
+        tasks.emplace_back([header = Tar::entry_header(info)](std::ostream& task_out) { task_out << header; });
+    };
+    // 按块写出的文件：头部一个任务，每块一个任务，最后一块之后补齐
+    auto add_blocks = [&](const Tar::EntryInfo& info, std::vector<std::function<std::optional<std::vector<char>>()>> readers) {
+        tasks.emplace_back([header = Tar::entry_header(info)](std::ostream& task_out) { task_out << header; });
+        for (size_t i = 0; i < readers.size(); ++i) {
+            const bool last = i + 1 == readers.size();
+            tasks.emplace_back([reader = std::move(readers[i]), last, size = info.size, path = info.path, failed](std::ostream& task_out) {
+                auto block = reader();
+                if (!block) {
+                    std::cerr << "错误: 无法读取 '" << path << "' 的内容。" << std::endl;
+                    *failed = true;
+                    return;
+                }
+                task_out.write(block->data(), static_cast<std::streamsize>(block->size()));
+                if (last) task_out << Tar::padding(size);
+            });
+        }
+    };
+    auto add_file = [&](const std::string& path, const TreeEntry& entry) -> bool {
+        Tar::EntryInfo info{path_prefix + path, Tar::TYPE_FILE, entry.mode == "100755" ? 0755u : 0644u, 0, mtime, ""};
+        const std::string blob_hash = entry.sha1_hash_hex;
+
+        // 符号链接和大文件指针很小，在遍历时直接读取
+        std::error_code ec;
+        const std::filesystem::path object_path = ObjectAlternates::locate(objects_dir, blob_hash);
+        const uintmax_t object_size = std::filesystem::file_size(object_path, ec);
+        if (ec) {
+            std::cerr << "错误: 找不到 '" << path << "' 的对象 " << blob_hash.substr(0, 7) << "。" << std::endl;
+            return false;
+        }
+        if (entry.mode == "120000" || object_size <= LfsPointer::MAX_POINTER_SIZE + 32) {
+            auto blob_opt = Blob::load_by_hash(blob_hash, objects_dir);
+            if (!blob_opt) {
+                std::cerr << "错误: 无法加载 '" << path << "' 的对象 " << blob_hash.substr(0, 7) << "。" << std::endl;
+                return false;
+            }
+            std::string content = blob_opt->get_content_as_string();
+            if (entry.mode == "120000") {
+                info.type = Tar::TYPE_SYMLINK;
+                info.mode = 0777;
+                info.link_target = content;
+                tasks.emplace_back([header = Tar::entry_header(info)](std::ostream& task_out) { task_out << header; });
+                return true;
+            }
+            // 与检出一致：内容库中有内容的大文件指针写出真实内容
+            auto pointer_opt = LfsPointer::parse(content);
+            if (pointer_opt && lfs_store.contains(pointer_opt->oid)) {
+                info.size = pointer_opt->size;
+                std::vector<std::function<std::optional<std::vector<char>>()>> readers;
+                for (uintmax_t offset = 0; offset < pointer_opt->size; offset += LfsStore::BLOCK_SIZE) {
+                    readers.emplace_back([&lfs_store, oid = pointer_opt->oid, offset]() {
+                        return lfs_store.read_block(oid, offset, LfsStore::BLOCK_SIZE);
+                    });
+                }
+                add_blocks(info, std::move(readers));
+                return true;
+            }
+            info.size = content.size();
+            tasks.emplace_back([header = Tar::entry_header(info), content = std::move(content)](std::ostream& task_out) {
+                task_out << header << content << Tar::padding(content.size());
+            });
+            return true;
+        }
+
+        // 分块存储的大文件逐块读取
+        auto chunk_list = Blob::read_chunk_list(blob_hash, objects_dir);
+        if (!chunk_list) {
+            std::cerr << "错误: 无法读取 '" << path << "' 的对象 " << blob_hash.substr(0, 7) << "。" << std::endl;
+            return false;
+        }
+        if (!chunk_list->empty()) {
+            std::vector<std::function<std::optional<std::vector<char>>()>> readers;
+            for (const auto& [chunk_hash, chunk_size] : *chunk_list) {
+                info.size += chunk_size;
+                readers.emplace_back([chunk_hash = chunk_hash, objects_dir]() -> std::optional<std::vector<char>> {
+                    auto chunk_opt = Blob::load_chunk(chunk_hash, objects_dir);
+                    if (!chunk_opt) return std::nullopt;
+                    const char* data = reinterpret_cast<const char*>(chunk_opt->data());
+                    return std::vector<char>(data, data + chunk_opt->size());
+                });
+            }
+            add_blocks(info, std::move(readers));
+            return true;
+        }
+
+        // 普通文件：在工作线程中读取
+        tasks.emplace_back([info, blob_hash, objects_dir, failed](std::ostream& task_out) mutable {
+            auto blob_opt = Blob::load_by_hash(blob_hash, objects_dir);
+            if (!blob_opt) {
+                std::cerr << "错误: 无法加载 '" << info.path << "' 的对象 " << blob_hash.substr(0, 7) << "。" << std::endl;
+                *failed = true;
+                return;
+            }
+            info.size = blob_opt->content.size();
+            task_out << Tar::entry_header(info);
+            task_out.write(reinterpret_cast<const char*>(blob_opt->content.data()), static_cast<std::streamsize>(info.size));
+            task_out << Tar::padding(info.size);
+        });
+        return true;
+    };
+
+    std::function<bool(const std::string&, const std::string&, size_t)> walk =
+        [&](const std::string& tree_hash, const std::string& dir_path, size_t filter_depth) -> bool {
+        auto tree_opt = Tree::load_by_hash(tree_hash, objects_dir);
+        if (!tree_opt) {
+            std::cerr << "错误: 无法加载 Tree 对象 " << tree_hash.substr(0, 7) << "。" << std::endl;
+            return false;
+        }
+        bool matched = filter_depth >= filter.size();
+        for (const auto& entry : tree_opt->entries) {
+            if (filter_depth < filter.size() && entry.name != filter[filter_depth]) continue;
+            matched = true;
+            const std::string path = dir_path.empty() ? entry.name : dir_path + "/" + entry.name;
+            if (entry.is_directory()) {
+                add_directory(path);
+                if (!walk(entry.sha1_hash_hex, path, filter_depth + 1)) return false;
+            } else if (filter_depth + 1 < filter.size()) {
+                matched = false; // 路径的中间部分是文件
+            } else if (!add_file(path, entry)) {
+                return false;
+            }
+        }
+        if (!matched) {
+            std::cerr << "错误: 路径 '" << sub_path << "' 不在提交 " << commit_hash->substr(0, 7) << " 中。" << std::endl;
+        }
+        return matched;
+    };
+    if (!walk(commit_opt->tree_hash_hex, "", 0)) return false;
+
+    // 3. 并行读取、按顺序写出
+    std::unique_ptr<GzipStreamBuf> gzip_buffer;
+    std::unique_ptr<std::ostream> gzip_stream;
+    if (gzip) {
+        gzip_buffer = std::make_unique<GzipStreamBuf>(out, Z_BEST_COMPRESSION);
+        gzip_stream = std::make_unique<std::ostream>(gzip_buffer.get());
+    }
+    std::ostream& tar_out = gzip ? *gzip_stream : out;
+    OrderedTaskPool(_configured_thread_count("archive.threads")).run(tasks, tar_out);
+    tar_out << Tar::end_of_archive();
+    tar_out.flush();
+    bool written = tar_out.good() && (!gzip_buffer || gzip_buffer->finish());
+    out.flush();
+    if (!written || !out.good()) {
+        std::cerr << "错误: 写入归档失败。" << std::endl;
+        return false;
+    }
+    return !*failed;
+}
+
+
+/**
+ * @brief 从输入流批量导入提交 (fast-import 格式)。
+ * @details 对象直接写入对象库，导入过程不读写索引和工作区；引用在流结束后更新。
+ *  如果导入前当前分支尚无提交且索引为空 (例如刚 init 的仓库)，导入后检出该分支；
+ *  否则当前分支被更新时只给出提示，工作区和索引保持不变。
+ * @param in 导入流。
+ * @param force 是否允许非快进地覆盖已有引用。
+ * @return 如果全部成功，返回 true；否则返回 false。
+ */
+bool Repository::fast_import(std::istream& in, bool force) {
+    // 1. 记录导入前的 HEAD 状态
+    const std::optional<std::string> head_before = _get_head_commit_hash();
+    if (!index_manager_.is_loaded()) index_manager_.load();
+    const bool checkout_after_import = !head_before && index_manager_.get_all_entries().empty();
+
+    // 2. 执行导入
+    FastImporter importer(*this, force);
+    bool ok = importer.run(in);
+
+    // 3. 当前分支被导入更新时同步或提示
+    const std::optional<std::string> head_after = _get_head_commit_hash();
+    if (!head_after || head_after == head_before) return ok;
+    if (!checkout_after_import) {
+        std::cout << "提示: 当前分支已更新到 " << head_after->substr(0, 7) << "，工作区和索引未改变。" << std::endl;
+        return ok;
+    }
+    auto commit_obj = Commit::load_by_hash(*head_after, get_objects_directory());
+    if (!commit_obj) { std::cerr << "错误: 无法加载导入的提交 " << head_after->substr(0, 7) << "。" << std::endl; return false; }
+    index_manager_.clear_in_memory();
+    _populate_index_from_tree_recursive(commit_obj->tree_hash_hex, PathTable::ROOT, index_manager_);
+    if (!index_manager_.write()) { std::cerr << "错误: 写入索引失败。" << std::endl; return false; }
+    std::map<std::filesystem::path, std::pair<std::string, std::string>> empty_map;
+    if (!_update_working_directory_from_tree(commit_obj->tree_hash_hex, empty_map)) {
+        std::cerr << "错误: 更新工作目录失败。" << std::endl;
+        return false;
+    }
+    std::cout << "已检出导入的提交 " << head_after->substr(0, 7) << "。" << std::endl;
+    return ok;
+}
+
+
+/**
+ * @brief 从离线传输包导入对象，并像 fetch 一样更新远程跟踪引用 (refs/remotes/<远程名>/)。
+ * @details 分支写入 refs/remotes/<远程名>/<分支>，本地没有的标签写入 refs/tags/。
+ *  之后可以照常 merge，或在网络可用时从同名远程增量 fetch (已导入的对象不会重复下载)。
+ * @param bundle_path 离线传输包路径。
+ * @param remote_name 远程名称，默认为 "origin"。
+ * @return 如果成功，返回 true；否则返回 false。
+ */
+bool Repository::bundle_unbundle(const std::filesystem::path& bundle_path, const std::string& remote_name) {
+    if (!_check_transport_object_format()) return false;
+    std::optional<BundleHeader> header_opt = _unbundle_objects(bundle_path);
+    if (!header_opt) return false;
+
+    // 对象全部写入并校验后才更新引用
+    std::error_code ec;
+    const std::filesystem::path remote_refs_dir = common_dir_ / REFS_DIR_NAME / "remotes" / remote_name;
+    size_t updated_count = 0;
+    for (const auto& [ref_name, hash] : header_opt->refs) {
+        std::filesystem::path ref_file;
+        if (ref_name.rfind("refs/heads/", 0) == 0) {
+            ref_file = remote_refs_dir / ref_name.substr(11);
+        } else if (ref_name.rfind("refs/tags/", 0) == 0) {
+            ref_file = common_dir_ / ref_name;
+            if (std::filesystem::exists(ref_file, ec)) {
+                std::ifstream existing_ifs(ref_file);
+                std::string existing_hash;
+                existing_ifs >> existing_hash;
+                if (existing_hash != hash) std::cout << "  警告: 本地已有标签 '" << ref_name.substr(10) << "'，未覆盖。" << std::endl;
+                continue;
+            }
+        } else {
+            std::cout << "  跳过引用 '" << ref_name << "'。" << std::endl;
+            continue;
+        }
+        std::filesystem::create_directories(ref_file.parent_path(), ec);
+        std::ofstream ref_ofs(ref_file, std::ios::trunc);
+        ref_ofs << hash << std::endl;
+        if (!ref_ofs.good()) {
+            std::cerr << "错误: 无法写入引用文件 '" << ref_file.string() << "'。" << std::endl;
+            return false;
+        }
+        std::cout << "  " << hash.substr(0, 7) << " -> " << std::filesystem::relative(ref_file, common_dir_ / REFS_DIR_NAME, ec).generic_string() << std::endl;
+        ++updated_count;
+    }
+    if (!header_opt->head_ref.empty()) {
+        std::filesystem::create_directories(remote_refs_dir, ec);
+        std::ofstream head_ofs(remote_refs_dir / HEAD_FILE_NAME, std::ios::trunc);
+        head_ofs << "ref: " << header_opt->head_ref << std::endl;
+    }
+    std::cout << "已从离线传输包更新 " << updated_count << " 个引用。" << std::endl;
+    return true;
+}
+
+
+/**
+ * @brief 从离线传输包克隆：初始化仓库，导入对象到远程 "origin" 的跟踪引用，再检出包中 HEAD 指向的分支。
+ * @details 不配置远程 URL；之后用 remote add origin <URL> 添加服务器，即可增量 fetch。
+ * @param bundle_path 离线传输包路径。
+ * @param target_directory_path 目标目录 (不存在或为空目录)。
+ * @return 如果成功，返回新仓库；否则返回 std::nullopt。
+ */
+std::optional<Repository> Repository::clone_from_bundle(const std::filesystem::path& bundle_path,
+                                                        const std::filesystem::path& target_directory_path) {
+    std::error_code ec;
+    std::cout << "正在从离线传输包 '" << bundle_path.string() << "' 克隆到 '" << target_directory_path.string() << "'..." << std::endl;
+    if (std::filesystem::exists(target_directory_path, ec) &&
+        (!std::filesystem::is_directory(target_directory_path, ec) || !std::filesystem::is_empty(target_directory_path, ec))) {
+        std::cerr << "错误: 目标路径 '" << target_directory_path.string() << "' 已存在且不是空目录。" << std::endl;
+        return std::nullopt;
+    }
+    const std::filesystem::path abs_bundle_path = std::filesystem::absolute(bundle_path);
+
+    std::optional<Repository> cloned_repo_opt = Repository::init(target_directory_path);
+    if (!cloned_repo_opt) return std::nullopt;
+    Repository cloned_repo = std::move(*cloned_repo_opt);
+    if (!cloned_repo.bundle_unbundle(abs_bundle_path, "origin")) return std::nullopt;
+    if (!cloned_repo._checkout_remote_head("origin")) return std::nullopt;
     std::cout << "克隆完成。" << std::endl;
     return cloned_repo;
 }
 
 
+/**
+ * @brief (内部) 校验前置 Commit 并把离线传输包中的对象逐个写入对象库，最后校验对象流的校验和。
+ * @return 成功时返回包的头部；否则返回 std::nullopt (已写入的对象都已通过哈希校验，可以保留)。
+ */
+std::optional<BundleHeader> Repository::_unbundle_objects(const std::filesystem::path& bundle_path) {
+    BundleReader reader;
+    if (!reader.open(bundle_path)) return std::nullopt;
+
+    // 0. 引用名之后会拼接成文件路径，写入任何对象前先整体校验
+    for (const auto& [ref_name, hash] : reader.header().refs) {
+        if (!is_valid_ref_name(ref_name)) {
+            std::cerr << "错误: 离线传输包包含无效的引用名 '" << ref_name << "'，拒绝导入。" << std::endl;
+            return std::nullopt;
+        }
+    }
+    const std::string& head_ref = reader.header().head_ref;
+    if (!head_ref.empty() && (head_ref.rfind("refs/heads/", 0) != 0 || !is_valid_ref_name(head_ref))) {
+        std::cerr << "错误: 离线传输包的 HEAD 引用 '" << head_ref << "' 无效，拒绝导入。" << std::endl;
+        return std::nullopt;
+    }
+
+    // 1. 前置 Commit 必须已在本仓库中
+    for (const std::string& prerequisite : reader.header().prerequisites) {
+        if (!ObjectAlternates::contains(get_objects_directory(), prerequisite)) {
+            std::cerr << "错误: 本仓库缺少离线传输包的前置提交 " << prerequisite.substr(0, 7)
+                      << "，请先导入更早的离线传输包或从服务器获取。" << std::endl;
+            return std::nullopt;
+        }
+    }
+
+    // 2. 逐个读出对象 (已校验哈希) 并写入
+    std::string object_hash;
+    std::vector<char> object_data;
+    uint64_t imported_count = 0;
+    while (reader.next(object_hash, object_data)) {
+        if (object_data.size() > std::numeric_limits<uint32_t>::max() ||
+            !write_raw_object(object_hash, object_data.data(), static_cast<uint32_t>(object_data.size()))) {
+            std::cerr << "错误: 写入对象 " << object_hash.substr(0, 7) << " 失败。" << std::endl;
+            return std::nullopt;
+        }
+        ++imported_count;
+    }
+    if (reader.failed() || !reader.verify_checksum()) return std::nullopt;
+    std::cout << "已导入 " << imported_count << " 个对象。" << std::endl;
+    return reader.header();
+}
+
+
 /**
  * @brief 私有辅助方法：从给定的起始路径向上查找 .biogit 仓库的工作树根目录。
  * @param starting_path 开始查找的路径，通常是当前工作目录。
@@ -3837,15 +5699,9 @@ std::optional<std::filesystem::path> Repository::find_repository_root(const std:
 
     // 向上查找，直到文件系统根目录
     while (current_path.has_parent_path()) { // 避免到达纯粹的根如 "C:" (它没有父路径) 或 "/"
-        std::filesystem::path biogit_dir = current_path / MYGIT_DIR_NAME;
-        if (std::filesystem::exists(biogit_dir, ec) && std::filesystem::is_directory(biogit_dir, ec)) {
-            // 进一步验证是否是合法的 .biogit 目录 (例如检查 HEAD, objects, refs 是否存在)
-            // 为简化，这里只检查 .biogit 目录本身
-            if (std::filesystem::exists(biogit_dir / HEAD_FILE_NAME, ec) &&
-                std::filesystem::exists(biogit_dir / OBJECTS_DIR_NAME, ec) &&
-                std::filesystem::exists(biogit_dir / REFS_DIR_NAME, ec)) {
-                return current_path; // 返回的是工作树的根目录
-            }
+        // 验证是否是合法的 .biogit (检查 HEAD, objects, refs 是否存在；链接工作树的 .biogit 为文件)
+        if (_is_repository_root(current_path)) {
+            return current_path; // 返回的是工作树的根目录
         }
 
         // 如果当前路径已经是根路径的父路径（即空路径），或者与父路径相同，则停止
@@ -3856,13 +5712,8 @@ std::optional<std::filesystem::path> Repository::find_repository_root(const std:
     }
 
     // 检查文件系统根目录
-    std::filesystem::path biogit_dir_at_root = current_path / MYGIT_DIR_NAME;
-    if (std::filesystem::exists(biogit_dir_at_root, ec) && std::filesystem::is_directory(biogit_dir_at_root, ec)) {
-        if (std::filesystem::exists(biogit_dir_at_root / HEAD_FILE_NAME, ec) &&
-            std::filesystem::exists(biogit_dir_at_root / OBJECTS_DIR_NAME, ec) &&
-            std::filesystem::exists(biogit_dir_at_root / REFS_DIR_NAME, ec)) {
-            return current_path;
-        }
+    if (_is_repository_root(current_path)) {
+        return current_path;
     }
 
     return std::nullopt; // 未找到
@@ -3913,9 +5764,12 @@ std::optional<std::filesystem::path> Repository::normalize_and_relativize_path(
 /**
  * @brief 私有辅助方法：从索引条目构建层级 Tree 对象并返回根 Tree 哈希
  * 注意：index保存的都是相对路径
+ * @details 目录按索引路径表中的 ID 分组：每个条目只把自己加入父目录，
+ *  再按深度从深到浅保存各目录的 Tree 并加入其父目录，不需要反复构造和比较路径。
  */
-std::optional<std::string> Repository::_build_trees_and_get_root_hash(
-    const std::vector<IndexEntry>& sorted_index_entries) {
+std::optional<std::string> Repository::_build_trees_and_get_root_hash(const Index& index) {
+    const std::vector<IndexEntry>& sorted_index_entries = index.get_all_entries();
+    const PathTable& paths = index.paths();
 
     if (sorted_index_entries.empty()) {
         Tree empty_tree;// 如果索引为空，创建一个空的 Tree 对象，保存并返回其哈希
@@ -3926,120 +5780,45 @@ std::optional<std::string> Repository::_build_trees_and_get_root_hash(
         return hash_opt;
     }
 
-    // 1. 收集所有涉及的目录路径 (包括根目录 "")
-    std::set<std::filesystem::path> all_dir_paths_set;
-    all_dir_paths_set.insert(std::filesystem::path("")); // 根目录
-
+    // 1. 把文件条目分到各自的父目录，并登记所有涉及的目录 (包括根目录)
+    std::unordered_map<PathTable::PathId, std::vector<TreeEntry>> dir_entries;
+    dir_entries[PathTable::ROOT];
     for (const auto& entry : sorted_index_entries) {
-        std::filesystem::path current_parent = entry.file_path.parent_path();
-        while (true) {
-            all_dir_paths_set.insert(current_parent.lexically_normal());
-            if (!current_parent.has_parent_path() || current_parent.parent_path() == current_parent) {
-                break; // 到达根或固定点
-            }
-            current_parent = current_parent.parent_path();
+        PathTable::PathId dir_id = paths.parent(entry.path_id);
+        dir_entries[dir_id].emplace_back(entry.mode, std::string(paths.name(entry.path_id)), entry.blob_hash_hex);
+        while (dir_id != PathTable::ROOT) { // 登记祖先目录，遇到已登记的即停止 (它的祖先也已登记)
+            dir_id = paths.parent(dir_id);
+            if (!dir_entries.try_emplace(dir_id).second) break;
         }
     }
 
-    std::vector<std::filesystem::path> sorted_dir_paths(all_dir_paths_set.begin(), all_dir_paths_set.end());
+    // 2. 按深度降序排序目录，确保子目录先处理 (根目录最后)
+    std::vector<PathTable::PathId> dir_ids;
+    dir_ids.reserve(dir_entries.size());
+    for (const auto& pair : dir_entries) dir_ids.push_back(pair.first);
+    std::sort(dir_ids.begin(), dir_ids.end(), [&paths](PathTable::PathId a, PathTable::PathId b) {
+        return paths.depth(a) != paths.depth(b) ? paths.depth(a) > paths.depth(b) : a < b;
+    });
 
-    // 2. 按深度（路径组件数量）降序排序目录路径，确保子目录先处理
-    std::sort(sorted_dir_paths.begin(), sorted_dir_paths.end(),
-        [](const std::filesystem::path& a, const std::filesystem::path& b) {
-            // 计算路径深度（组件数量）
-            auto count_components = [](const std::filesystem::path& p) {
-                size_t count = 0;
-                for (const auto& component : p) {
-                    if (!component.empty() && component.string() != ".") { // 忽略空和"."组件
-                        count++;
-                    }
-                }
-                return count;
-            };
-            size_t depth_a = count_components(a);
-            size_t depth_b = count_components(b);
-
-            if (depth_a != depth_b) {
-                return depth_a > depth_b; // 深度大的（子目录）在前
-            }
-            return a.string() > b.string(); // 同深度下按字典序降序，确保一致性
-        });
-
-    // 3. 迭代构建和保存 Tree 对象
-    std::map<std::filesystem::path, std::string> built_tree_hashes; // 存储已构建的 <目录路径, Tree哈希>
-
-    for (const auto& dir_to_build : sorted_dir_paths) {
+    // 3. 迭代构建和保存 Tree 对象，并把它加入父目录
+    for (PathTable::PathId dir_id : dir_ids) {
         Tree current_dir_tree;
+        current_dir_tree.set_entries(std::move(dir_entries[dir_id])); // 一次性排序
 
-        // a. 添加直接位于此目录下的文件条目
-        for (const auto& entry : sorted_index_entries) {
-            if (entry.file_path.parent_path().lexically_normal() == dir_to_build.lexically_normal()) {
-                current_dir_tree.add_entry(entry.mode,
-                                           entry.file_path.filename().string(),
-                                           entry.blob_hash_hex);
-            }
-        }
-
-        // b. 添加直接位于此目录下的子目录（的Tree）条目
-        //    遍历所有已构建的树哈希
-        for (const auto& pair : built_tree_hashes) {
-            const std::filesystem::path& built_subdir_path = pair.first; // 例如 "src", 或者 "src/utils"
-            const std::string& subdir_tree_hash = pair.second;
-
-            // 检查 built_subdir_path 是否是 dir_to_build 的直接子目录
-            bool is_direct_child = false;
-            if (dir_to_build.empty()) { // 如果当前正在构建根目录的 Tree ("")
-                // 那么，任何只有一个路径组件的 built_subdir_path 都是它的直接子目录
-                // 例如，如果 built_subdir_path 是 "src"，它的迭代器只有一个组件 "src"
-                // path("").begin() == path("").end() is true
-                // path("src").begin() != path("src").end(), and ++(path("src").begin()) == path("src").end()
-                auto it = built_subdir_path.begin();
-                if (it != built_subdir_path.end()) { // 确保路径不是空的 (虽然 built_tree_hashes 的键不应该是空的)
-                    ++it;
-                    if (it == built_subdir_path.end()) { // 只有一个组件
-                        is_direct_child = true;
-                    }
-                }
-            } else { // 如果当前正在构建的是一个非根目录的 Tree (例如 "src")
-                // 那么，如果 built_subdir_path 的父路径等于 dir_to_build，它就是直接子目录
-                if (built_subdir_path.has_parent_path() &&
-                    built_subdir_path.parent_path().lexically_normal() == dir_to_build.lexically_normal()) {
-                    is_direct_child = true;
-                }
-            }
-
-            if (is_direct_child) {
-                // (加入之前的调试打印，确认是否进入这里)
-                // std::cout << "      DEBUG: ==> MATCH! Adding subdir '" << built_subdir_path.filename().string()
-                //           << "' to tree for '" << dir_to_build.string() << "'" << std::endl;
-                current_dir_tree.add_entry("040000", // 目录模式
-                                           built_subdir_path.filename().string(), // 子目录的名称
-                                           subdir_tree_hash);
-            }
-            // else { // (调试打印)
-            //      std::cout << "      DEBUG: ==> NO MATCH for subdir '" << built_subdir_path.string()
-            //                << "' when building tree for '" << dir_to_build.string() << "'" << std::endl;
-            // }
-        }
-        // Tree::add_entry 内部会排序
-
-        // c. 保存当前构建的 Tree 对象
         auto tree_hash_opt = current_dir_tree.save(get_objects_directory());
         if (!tree_hash_opt) {
-            std::cerr << "错误: 保存目录 '" << dir_to_build.string() << "' 的 Tree 对象失败。" << std::endl;
+            std::cerr << "错误: 保存目录 '" << paths.generic_string(dir_id) << "' 的 Tree 对象失败。" << std::endl;
             return std::nullopt;
         }
-        built_tree_hashes[dir_to_build] = *tree_hash_opt;
+        if (dir_id == PathTable::ROOT) {
+            return tree_hash_opt; // 4. 根目录最后处理，返回根 Tree 的哈希
+        }
+        dir_entries[paths.parent(dir_id)].emplace_back("040000", std::string(paths.name(dir_id)), *tree_hash_opt);
     }
 
-    // 4. 返回根 Tree 的哈希 (对应于空路径 "" 的条目)
-    if (built_tree_hashes.count(std::filesystem::path(""))) {
-        return built_tree_hashes[std::filesystem::path("")];
-    } else {
-        // 如果索引为空，上面已处理。如果非空但根树未生成，说明逻辑有误。
-        std::cerr << "错误: 未能构建根 Tree 对象 (索引可能非空但无根目录条目被处理)。" << std::endl;
-        return std::nullopt;
-    }
+    // 如果索引为空，上面已处理。如果非空但根树未生成，说明逻辑有误。
+    std::cerr << "错误: 未能构建根 Tree 对象 (索引可能非空但无根目录条目被处理)。" << std::endl;
+    return std::nullopt;
 }
 
 
@@ -4051,40 +5830,171 @@ std::optional<std::string> Repository::_build_trees_and_get_root_hash(
  *   如果无法确定（例如新仓库，文件不存在或格式错误），返回 std::nullopt
  */
 std::optional<std::string> Repository::_get_head_commit_hash() const {
-    std::filesystem::path head_path = get_head_file_path(); // 获取 HEAD 文件路径
-    if (!std::filesystem::exists(head_path)) {
-        return std::nullopt; // HEAD 文件不存在，通常在新仓库的第一次提交前
-    }
-
-    std::ifstream head_file(head_path);
-    std::string line;
-    if (std::getline(head_file, line)) { // 读取 HEAD 文件内容
-        // 清理可能的行尾换行符
-        if (!line.empty() && (line.back() == '\n' || line.back() == '\r')) { line.pop_back(); }
-        if (!line.empty() && line.back() == '\r') { line.pop_back(); }
-
+    // HEAD 文件不存在时通常是新仓库的第一次提交前
+    std::optional<std::string> head_line = _read_ref_file(get_head_file_path());
+    if (head_line) {
+        const std::string& line = *head_line;
         // 检查是否是符号引用，格式如 "ref: refs/heads/main"
         if (line.rfind("ref: ", 0) == 0 && line.length() > 5) {
             std::string ref_path_str = line.substr(5); // 提取引用路径，例如 "refs/heads/main"
             ref_path_str.erase(0, ref_path_str.find_first_not_of(" ")); // 去除前导空格
 
-            std::filesystem::path branch_file_path = mygit_dir_ / ref_path_str; // 构建分支文件的完整路径
-            if (std::filesystem::exists(branch_file_path)) {
-                std::ifstream branch_file(branch_file_path);
-                std::string commit_hash;
-                // 从分支文件中读取 Commit 哈希
-                if (branch_file >> commit_hash && commit_hash.length() == 40) {
-                    return commit_hash; // 返回分支指向的 Commit 哈希
-                }
+            // 从分支文件中读取 Commit 哈希
+            std::optional<std::string> commit_hash = _read_ref_file(common_dir_ / ref_path_str);
+            if (commit_hash && ObjectFormat::is_id_length(commit_hash->length())) {
+                return commit_hash; // 返回分支指向的 Commit 哈希
             }
             // 如果分支文件不存在或内容无效，则认为该分支尚无提交
-        } else if (line.length() == 40) { // 如果内容是40字符，认为是分离头指针状态
+        } else if (ObjectFormat::is_id_length(line.length())) { // 如果内容是完整的对象哈希，认为是分离头指针状态
             return line; // 直接返回 Commit 哈希
         }
     }
     return std::nullopt; // 无法确定 HEAD Commit 哈希
 }
 
+/**
+ * @brief 私有辅助方法：读取引用文件的首行 (去除首尾空白)。
+ * @details 启用引用缓存 (set_ref_cache_capacity) 时按文件身份复用上次读到的内容；
+ *  时间戳尚未落定的文件只读不缓存，避免同一时间戳内的原地改写被当作未变化。
+ */
+std::optional<std::string> Repository::_read_ref_file(const std::filesystem::path &ref_file_path) {
+    std::optional<FileStamp> stamp = FileStamp::of(ref_file_path);
+    if (!stamp || !stamp->is_regular_file()) {
+        return std::nullopt;
+    }
+    const std::string key = ref_file_path.lexically_normal().generic_string();
+    RefFileCache& cache = ref_file_cache();
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto it = cache.by_path.find(key);
+        if (it != cache.by_path.end() && it->second->stamp == *stamp) {
+            cache.lru.splice(cache.lru.begin(), cache.lru, it->second);
+            return it->second->content;
+        }
+    }
+
+    std::ifstream ref_file(ref_file_path);
+    std::string line;
+    if (!std::getline(ref_file, line)) {
+        return std::nullopt;
+    }
+    const size_t first = line.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) {
+        return std::nullopt;
+    }
+    line = line.substr(first, line.find_last_not_of(" \t\r\n") - first + 1);
+
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (cache.capacity == 0) {
+        return line;
+    }
+    if (auto it = cache.by_path.find(key); it != cache.by_path.end()) {
+        cache.lru.erase(it->second);
+        cache.by_path.erase(it);
+    }
+    if (stamp->is_settled()) {
+        cache.lru.push_front({key, *stamp, line});
+        cache.by_path.emplace(key, cache.lru.begin());
+        cache.evict_to(cache.capacity);
+    }
+    return line;
+}
+
+void Repository::set_ref_cache_capacity(size_t entries) {
+    RefFileCache& cache = ref_file_cache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.capacity = entries;
+    cache.evict_to(entries);
+}
+
+
+/**
+ * @brief 私有辅助方法：取得 Tree 展开后的 <相对路径, {Blob哈希, 模式}> 映射，结果在进程内缓存。
+ * @details 单次命令只展开一次，与直接调用 _load_tree_contents_recursive 相同；
+ *  常驻进程 (daemon) 中 HEAD 不变时，后续的 status / diff --staged 不再读取任何 Tree 对象。
+ */
+std::shared_ptr<const std::map<std::filesystem::path, std::pair<std::string, std::string>>>
+Repository::_flattened_tree(const std::string &tree_hash_hex) const {
+    const std::string key = get_objects_directory().string() + "\n" + tree_hash_hex;
+    FlatTreeCache& cache = flat_tree_cache();
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        for (auto it = cache.entries.begin(); it != cache.entries.end(); ++it) {
+            if (it->first != key) continue;
+            std::rotate(it, it + 1, cache.entries.end()); // 移到末尾 (最近使用)
+            return cache.entries.back().second;
+        }
+    }
+
+    auto files = std::make_shared<FlatTreeFiles>();
+    _load_tree_contents_recursive(tree_hash_hex, "", *files);
+
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (cache.entries.size() >= FlatTreeCache::CAPACITY) cache.entries.erase(cache.entries.begin());
+    cache.entries.emplace_back(key, files);
+    return files;
+}
+
+/**
+ * @brief 私有辅助方法：取得已解析的索引，索引文件的身份 (修改时间、状态改变时间、inode、大小) 未变时复用进程内缓存的结果。
+ * @return 索引 (文件不存在时为空索引)；索引文件存在但解析失败时返回 nullptr。
+ */
+std::shared_ptr<const Index> Repository::_index_snapshot() const {
+    const std::filesystem::path index_path = mygit_dir_ / INDEX_FILE_NAME;
+    std::optional<FileStamp> stamp_opt = FileStamp::of(index_path);
+    if (!stamp_opt) { // 没有索引文件：空索引
+        auto empty = std::make_shared<Index>(mygit_dir_);
+        empty->load();
+        return empty;
+    }
+    const FileStamp& stamp = *stamp_opt;
+
+    IndexSnapshotCache& cache = index_snapshot_cache();
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto it = cache.entries.find(index_path.string());
+        if (it != cache.entries.end() && it->second.first == stamp) {
+            return it->second.second;
+        }
+    }
+
+    auto index = std::make_shared<Index>(mygit_dir_);
+    if (!index->load()) return nullptr;
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (!stamp.is_settled()) {
+        cache.entries.erase(index_path.string()); // 刚写入的索引：本次使用，但不缓存
+    } else {
+        cache.entries[index_path.string()] = {stamp, index};
+    }
+    return index;
+}
+
+
+/**
+ * @brief 私有辅助方法：只加载 Tree 中某个路径下的文件 (路径是文件时只加载该文件)
+ * 先沿路径逐级找到条目，只展开该条目对应的子树；路径为空或 "." 时展开整棵树。
+ * @param tree_hash_hex : 根 Tree 的哈希
+ * @param relative_path : 相对于根 Tree 的路径
+ * @param files_map : 用于存储结果的引用 (键为相对于根 Tree 的完整路径)
+ */
+void Repository::_load_tree_contents_at_path(const std::string &tree_hash_hex,
+    const std::filesystem::path &relative_path,
+    std::map<std::filesystem::path, std::pair<std::string, std::string>> &files_map) const {
+
+    const std::filesystem::path normalized_path = relative_path.lexically_normal();
+    if (normalized_path.empty() || normalized_path == ".") {
+        _load_tree_contents_recursive(tree_hash_hex, "", files_map);
+        return;
+    }
+    auto entry = _find_entry_in_tree(tree_hash_hex, normalized_path.generic_string());
+    if (!entry) return; // 路径在此树中不存在
+    if (entry->first == "040000") {
+        _load_tree_contents_recursive(entry->second, normalized_path, files_map);
+    } else {
+        files_map[normalized_path] = {entry->second, entry->first};
+    }
+}
+
 
 /**
  * @brief 私有辅助方法：递归加载 Tree 内容到 Map
@@ -4122,10 +6032,300 @@ void Repository::_load_tree_contents_recursive(const std::string &tree_hash_hex,
 }
 
 
+/**
+ * @brief 私有辅助方法：比较两个 Tree，收集发生变化的文件路径
+ * 两边按名称对齐 Tree 条目：哈希相同的条目 (包括整个子 Tree) 直接跳过，
+ * 只对哈希不同的子 Tree 继续递归，因此开销只与改动的规模相关。
+ * @param old_tree_hash : 旧 Tree 的哈希，为空表示空树
+ * @param new_tree_hash : 新 Tree 的哈希，为空表示空树
+ * @param current_path_prefix : 当前路径前缀
+ * @param changed_paths : 输出，改动文件的相对路径 ('/' 分隔)
+ * @return 所有需要比较的 Tree 都加载成功时返回 true；否则 changed_paths 只是部分结果
+ */
+bool Repository::_collect_changed_paths(const std::string &old_tree_hash,
+    const std::string &new_tree_hash,
+    const std::filesystem::path &current_path_prefix,
+    std::set<std::string> &changed_paths) const {
+
+    if (old_tree_hash == new_tree_hash) return true;
+
+    // 1. 加载两边的 Tree (空哈希视为空树)
+    std::map<std::string, const TreeEntry*> old_entries, new_entries;
+    std::optional<Tree> old_tree, new_tree;
+    if (!old_tree_hash.empty()) {
+        old_tree = Tree::load_by_hash(old_tree_hash, get_objects_directory());
+        if (!old_tree) { std::cerr << "警告: 无法加载 Tree 对象 " << old_tree_hash << std::endl; return false; }
+        for (const auto& entry : old_tree->entries) old_entries[entry.name] = &entry;
+    }
+    if (!new_tree_hash.empty()) {
+        new_tree = Tree::load_by_hash(new_tree_hash, get_objects_directory());
+        if (!new_tree) { std::cerr << "警告: 无法加载 Tree 对象 " << new_tree_hash << std::endl; return false; }
+        for (const auto& entry : new_tree->entries) new_entries[entry.name] = &entry;
+    }
+
+    // 2. 对两边出现过的每个名称进行比较
+    std::set<std::string> all_names;
+    for (const auto& pair : old_entries) all_names.insert(pair.first);
+    for (const auto& pair : new_entries) all_names.insert(pair.first);
+
+    for (const auto& name : all_names) {
+        auto old_it = old_entries.find(name);
+        auto new_it = new_entries.find(name);
+        const TreeEntry* old_entry = old_it != old_entries.end() ? old_it->second : nullptr;
+        const TreeEntry* new_entry = new_it != new_entries.end() ? new_it->second : nullptr;
+
+        if (old_entry && new_entry &&
+            old_entry->sha1_hash_hex == new_entry->sha1_hash_hex && old_entry->mode == new_entry->mode) {
+            continue; // 未改动
+        }
+
+        std::filesystem::path entry_full_path = (current_path_prefix / name).lexically_normal();
+
+        // 目录一侧递归展开 (另一侧若为文件，则该文件路径本身也算改动)
+        std::string old_subtree = (old_entry && old_entry->is_directory()) ? old_entry->sha1_hash_hex : "";
+        std::string new_subtree = (new_entry && new_entry->is_directory()) ? new_entry->sha1_hash_hex : "";
+        if (!old_subtree.empty() || !new_subtree.empty()) {
+            if (!_collect_changed_paths(old_subtree, new_subtree, entry_full_path, changed_paths)) return false;
+        }
+        if ((old_entry && !old_entry->is_directory()) || (new_entry && !new_entry->is_directory())) {
+            changed_paths.insert(entry_full_path.generic_string());
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief 私有辅助方法：batch 持久化方式下，把本次操作写入的对象刷到磁盘 (移动引用之前调用)
+ */
+bool Repository::_sync_objects() const {
+    return ObjectWriter::sync(get_objects_directory());
+}
+
+
+/**
+ * @brief 私有辅助方法：计算 Commit 相对第一个父提交的改动路径，并写入 commit-bloom 过滤器
+ * @param commit_hash : 已保存的 Commit 哈希
+ * @return 改动的文件路径集合；有对象无法加载时返回 std::nullopt 且不写入过滤器
+ *  (不完整的路径集合会让过滤器永久地误判 “未改动”，路径限定的 log 会漏掉该 Commit)
+ */
+std::optional<std::set<std::string>> Repository::_record_changed_paths(const std::string &commit_hash) const {
+    auto commit_opt = Commit::load_by_hash(commit_hash, get_objects_directory());
+    if (!commit_opt) return std::nullopt;
+
+    std::string parent_tree_hash;
+    if (!commit_opt->parent_hashes_hex.empty()) {
+        auto parent_opt = Commit::load_by_hash(commit_opt->parent_hashes_hex[0], get_objects_directory());
+        if (parent_opt) parent_tree_hash = parent_opt->tree_hash_hex;
+    }
+
+    std::set<std::string> changed_paths;
+    if (!_collect_changed_paths(parent_tree_hash, commit_opt->tree_hash_hex, "", changed_paths)) return std::nullopt;
+
+    // 新 Commit 只需追加一行，不必先读入整个旁路文件 (查询时才加载)
+    ChangedPathBloomStore bloom_store(common_dir_);
+    bloom_store.record(commit_hash, changed_paths);
+    return changed_paths;
+}
+
+
+/**
+ * @brief 私有辅助方法：在 Tree 中按路径逐级查找文件条目的 Blob 哈希
+ * @param tree_hash_hex : 根 Tree 的哈希
+ * @param relative_path : 相对于根 Tree 的文件路径 ('/' 分隔)
+ * @return 找到文件时返回 Blob 哈希；路径不存在或指向目录时返回 std::nullopt
+ */
+std::optional<std::string> Repository::_find_blob_hash_in_tree(const std::string &tree_hash_hex,
+    const std::string &relative_path) const {
+
+    auto entry = _find_entry_in_tree(tree_hash_hex, std::filesystem::path(relative_path).generic_string());
+    if (!entry || entry->first == "040000") return std::nullopt;
+    return entry->second;
+}
+
+
+/**
+ * @brief 私有辅助方法：在 Tree 中按路径逐级查找条目 (文件或目录)
+ * 只读取路径经过的各级 Tree，在每级已排序的条目中二分查找，不展开整棵树。
+ * 缓存以 Tree 哈希为键，Tree 内容不可变，因此缓存永远不会过期；条目过多时整体清空以限制内存。
+ */
+std::optional<std::pair<std::string, std::string>> Repository::_find_entry_in_tree(const std::string &tree_hash_hex,
+    const std::string &relative_path, TreeEntryCache *cache) const {
+
+    constexpr size_t MAX_CACHED_TREES = 4096;
+    std::pair<std::string, std::string> current{"040000", tree_hash_hex};
+    std::stringstream path_stream(relative_path);
+    std::string component;
+    while (std::getline(path_stream, component, '/')) {
+        if (component.empty()) continue;
+        if (current.first != "040000") return std::nullopt; // 路径中间是文件
+
+        // 1. 没有缓存时直接在读到的 Tree 中二分查找
+        if (!cache) {
+            auto tree_opt = Tree::load_by_hash(current.second, get_objects_directory());
+            if (!tree_opt) return std::nullopt;
+            const TreeEntry* entry = tree_opt->find_entry(component);
+            if (!entry) return std::nullopt;
+            current = {entry->mode, entry->sha1_hash_hex};
+            continue;
+        }
+
+        // 2. 读取当前目录的条目 (优先使用缓存)
+        auto cached = cache->find(current.second);
+        if (cached == cache->end()) {
+            auto tree_opt = Tree::load_by_hash(current.second, get_objects_directory());
+            if (!tree_opt) return std::nullopt;
+            std::map<std::string, std::pair<std::string, std::string>> loaded_entries;
+            for (const auto& entry : tree_opt->entries) loaded_entries[entry.name] = {entry.mode, entry.sha1_hash_hex};
+            if (cache->size() >= MAX_CACHED_TREES) cache->clear();
+            cached = cache->emplace(current.second, std::move(loaded_entries)).first;
+        }
+
+        // 3. 查找下一级
+        auto entry_it = cached->second.find(component);
+        if (entry_it == cached->second.end()) return std::nullopt;
+        current = entry_it->second;
+    }
+    return current;
+}
+
+
+/**
+ * @brief 私有辅助方法：把对象名解析为完整的对象哈希
+ * "<提交>:<路径>" 在提交的树中查找；全为十六进制的名称先按对象哈希 (前缀) 查找，再按提交名解析。
+ */
+std::optional<std::string> Repository::_resolve_object_name(const std::string &name, TreeEntryCache *cache) const {
+    size_t colon_pos = name.find(':');
+    if (colon_pos != std::string::npos) {
+        std::optional<std::string> commit_hash = _resolve_commit_ish_to_full_hash(name.substr(0, colon_pos));
+        if (!commit_hash) return std::nullopt;
+        auto commit_opt = Commit::load_by_hash(*commit_hash, get_objects_directory());
+        if (!commit_opt) return std::nullopt;
+        auto entry = _find_entry_in_tree(commit_opt->tree_hash_hex, name.substr(colon_pos + 1), cache);
+        if (!entry) return std::nullopt;
+        return entry->second;
+    }
+
+    if (name.length() >= 6 && name.length() <= 64 && std::all_of(name.begin(), name.end(), ::isxdigit)) {
+        if (auto object_path = _find_object_file_by_prefix(name)) {
+            return object_path->parent_path().filename().string() + object_path->filename().string();
+        }
+    }
+    return _resolve_commit_ish_to_full_hash(name);
+}
+
+
+/**
+ * @brief 私有辅助方法：只读取对象头部得到 <类型, 大小>
+ * 分块存储的 Blob 从清单首行读出完整大小 (清单很小)；经编解码器存储的对象只能完整还原后得到。
+ */
+std::optional<std::pair<std::string, uintmax_t>> Repository::_read_object_header(const std::string &full_hash) const {
+    std::filesystem::path object_path = ObjectAlternates::locate(get_objects_directory(), full_hash);
+    std::ifstream ifs(object_path, std::ios::binary);
+    if (!ifs.is_open()) return std::nullopt;
+
+    if (ifs.peek() == ObjectCodecs::MAGIC[0]) {
+        ifs.close();
+        auto parsed_result = read_and_parse_object_file_content(object_path);
+        if (!parsed_result) return std::nullopt;
+        return std::make_pair(std::get<0>(*parsed_result), static_cast<uintmax_t>(std::get<1>(*parsed_result)));
+    }
+
+    std::string type_str, size_str;
+    if (!std::getline(ifs, type_str, ' ') || !std::getline(ifs, size_str, '\0')) return std::nullopt;
+    uintmax_t size = 0;
+    try {
+        size = std::stoull(size_str);
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+    if (type_str == Blob::manifest_type_str()) {
+        std::string total_size_line;
+        if (!std::getline(ifs, total_size_line)) return std::nullopt;
+        try {
+            return std::make_pair(Blob::type_str(), static_cast<uintmax_t>(std::stoull(total_size_line)));
+        } catch (const std::exception&) {
+            return std::nullopt;
+        }
+    }
+    return std::make_pair(type_str, size);
+}
+
+
+/**
+ * @brief 私有辅助方法：blame 缓存文件的位置
+ * 缓存以 (Commit, 路径) 为键，文件名为 sha1("<Commit哈希>:<路径>")，按前两位分目录存放。
+ */
+std::filesystem::path Repository::_blame_cache_file_path(const std::string &commit_hash, const std::string &relative_path) const {
+    std::string key = sha1(commit_hash + ":" + relative_path);
+    return common_dir_ / BLAME_CACHE_DIR_NAME / key.substr(0, 2) / key.substr(2);
+}
+
+
+/**
+ * @brief 私有辅助方法：读取 (Commit, 路径) 的 blame 缓存
+ * 文件格式: 首行 "<Commit哈希> <路径>"，之后每行 "<来源Commit哈希> <来源行号>"
+ */
+std::optional<std::vector<Repository::BlameOrigin>> Repository::_load_blame_cache(const std::string &commit_hash,
+    const std::string &relative_path) const {
+
+    std::ifstream ifs(_blame_cache_file_path(commit_hash, relative_path));
+    if (!ifs.is_open()) return std::nullopt;
+
+    std::string header;
+    if (!std::getline(ifs, header) || header != commit_hash + " " + relative_path) {
+        return std::nullopt; // 键冲突或文件损坏，按未命中处理
+    }
+
+    std::vector<BlameOrigin> origins;
+    BlameOrigin origin;
+    while (ifs >> origin.commit_hash >> origin.line_index) {
+        if (!ObjectFormat::is_id_length(origin.commit_hash.length())) return std::nullopt;
+        origins.push_back(origin);
+    }
+    if (ifs.bad()) return std::nullopt;
+    return origins;
+}
+
+
+/**
+ * @brief 私有辅助方法：写入 (Commit, 路径) 的 blame 缓存 (先写临时文件再重命名，避免留下半截文件)
+ */
+bool Repository::_save_blame_cache(const std::string &commit_hash, const std::string &relative_path,
+    const std::vector<BlameOrigin> &origins) const {
+
+    std::filesystem::path cache_file = _blame_cache_file_path(commit_hash, relative_path);
+    std::error_code ec;
+    std::filesystem::create_directories(cache_file.parent_path(), ec);
+    if (ec) {
+        std::cerr << "警告: 无法创建 blame 缓存目录: " << ec.message() << std::endl;
+        return false;
+    }
+
+    std::filesystem::path tmp_file = cache_file;
+    tmp_file += ".tmp";
+    {
+        std::ofstream ofs(tmp_file, std::ios::trunc);
+        if (!ofs.is_open()) return false;
+        ofs << commit_hash << " " << relative_path << "\n";
+        for (const auto& origin : origins) {
+            ofs << origin.commit_hash << " " << origin.line_index << "\n";
+        }
+        if (!ofs.good()) return false;
+    }
+    std::filesystem::rename(tmp_file, cache_file, ec);
+    if (ec) {
+        std::filesystem::remove(tmp_file, ec);
+        return false;
+    }
+    return true;
+}
+
+
 /**
  * @brief 私有辅助方法：从给定的 Tree 哈希递归填充 Index 对象
  * @param tree_hash_hex : 当前要加载的 Tree 对象的哈希 (十六进制字符串)
- * @param current_path_prefix : 用于构建文件在仓库中完整相对路径的前缀。
+ * @param parent_dir_id : 当前 Tree 对应的目录在 target_index 路径表中的 ID (根 Tree 为 PathTable::ROOT)。
  * @param target_index // 传递 Index 对象的引用以直接修改
  * @detail
  *     Tree 格式 <模式> <名称>\0<哈希>
@@ -4133,24 +6333,24 @@ void Repository::_load_tree_contents_recursive(const std::string &tree_hash_hex,
  */
 void Repository::_populate_index_from_tree_recursive(
     const std::string& tree_hash_hex,
-    const std::filesystem::path& current_path_prefix,
+    PathTable::PathId parent_dir_id,
     Index& target_index // 注意：传入的是 Index 对象的引用
 ) const {
     auto tree_opt = Tree::load_by_hash(tree_hash_hex, get_objects_directory());
     if (!tree_opt) {
         std::cerr << "警告 (populate_index): 无法加载 Tree 对象 " << tree_hash_hex
-                  << " 当为路径 '" << current_path_prefix.string() << "' 填充索引时。" << std::endl;
+                  << " 当为路径 '" << target_index.paths().generic_string(parent_dir_id) << "' 填充索引时。" << std::endl;
         return;
     }
 
     for (const auto& entry : tree_opt->entries) {
-        std::filesystem::path entry_full_relative_path = (current_path_prefix / entry.name).lexically_normal();
+        const PathTable::PathId entry_path_id = target_index.intern_path(parent_dir_id, entry.name);
 
         if (entry.is_directory()) { // 模式 "040000"
-            _populate_index_from_tree_recursive(entry.sha1_hash_hex, entry_full_relative_path, target_index);
+            _populate_index_from_tree_recursive(entry.sha1_hash_hex, entry_path_id, target_index);
         } else { // 是文件 (Blob)
             // Tree 对象本身不存储元数据 需要读取文件
-            std::filesystem::path abs_file_path_in_worktree = work_tree_root_ / entry_full_relative_path;
+            std::filesystem::path abs_file_path_in_worktree = work_tree_root_ / target_index.paths().generic_string(entry_path_id);
             std::error_code ec;
             std::chrono::system_clock::time_point mtime;
             uint64_t file_size = 0;
@@ -4187,7 +6387,7 @@ void Repository::_populate_index_from_tree_recursive(
             // 调用 Index 的 add_or_update_entry 方法
             // 注意：entry.mode 和 entry.sha1_hash_hex 来自于刚提交的 Tree 对象
             target_index.add_or_update_entry(
-                entry_full_relative_path,
+                entry_path_id,
                 entry.sha1_hash_hex,
                 entry.mode,
                 mtime,
@@ -4210,6 +6410,17 @@ std::optional<std::tuple<std::string, size_t, std::vector<std::byte>>> Repositor
         std::cerr << "错误 (read_object): 无法打开对象文件 '" << file_path.string() << "'" << std::endl;
         return std::nullopt;
     }
+    if (ifs.peek() == ObjectCodecs::MAGIC[0]) { // 经编解码器存储的对象：还原后按规范格式解析
+        ifs.close();
+        auto object_bytes = ObjectCodecs::read_object_file(file_path);
+        if (!object_bytes) { return std::nullopt; }
+        const char* raw = reinterpret_cast<const char*>(object_bytes->data());
+        size_t space_pos = std::string_view(raw, object_bytes->size()).find(' ');
+        size_t null_pos = std::string_view(raw, object_bytes->size()).find('\0');
+        if (space_pos == std::string_view::npos || null_pos == std::string_view::npos || space_pos > null_pos) { return std::nullopt; }
+        std::vector<std::byte> content_data(object_bytes->begin() + static_cast<std::ptrdiff_t>(null_pos + 1), object_bytes->end());
+        return std::make_tuple(std::string(raw, space_pos), content_data.size(), std::move(content_data));
+    }
     std::string type_str_read;
     long long content_size_read = -1;
     char ch;
@@ -4244,35 +6455,47 @@ std::optional<std::filesystem::path> Repository::_find_object_file_by_prefix(con
     std::string subdir_name = hash_prefix.substr(0, 2);
     std::string remaining_prefix = hash_prefix.substr(2);
 
-    std::filesystem::path object_subdir = get_objects_directory() / subdir_name;
+    // 完整哈希直接定位 (本仓库优先，其次备用对象库)；宽度以本仓库的对象格式为准，
+    // 否则 sha256 仓库中的 40 位前缀会被当作完整的 sha1 哈希而找不到对象
     std::error_code ec;
-
-    if (!std::filesystem::exists(object_subdir, ec) || !std::filesystem::is_directory(object_subdir, ec)) {
-        //std::cerr << "提示: 未找到对象目录 " << object_subdir.string() << " (对于哈希前缀 " << hash_prefix << ")" << std::endl;
-        return std::nullopt;
-    }
-    if(ec) {
-        std::cerr << "错误: 检查对象目录 " << object_subdir.string() << " 时出错: " << ec.message() << std::endl;
+    const size_t id_length = ObjectFormat::hex_length(get_object_format());
+    if (hash_prefix.length() > id_length) return std::nullopt;
+    if (hash_prefix.length() == id_length) {
+        std::filesystem::path object_path = ObjectAlternates::locate(get_objects_directory(), hash_prefix);
+        if (std::filesystem::is_regular_file(object_path, ec)) return object_path;
         return std::nullopt;
     }
 
+    // 依次在本仓库和各备用对象库中查找，同一对象在多处出现时只算一个匹配
+    std::vector<std::filesystem::path> search_dirs{get_objects_directory()};
+    for (const auto& alternate_dir : ObjectAlternates::list(get_objects_directory())) search_dirs.push_back(alternate_dir);
 
     std::vector<std::filesystem::path> matches;
-    // 遍历对象目录所有文件 对比文件名字
-    for (const auto& entry : std::filesystem::directory_iterator(object_subdir, ec)) {
-        if (entry.is_regular_file(ec)) {
-            std::string filename = entry.path().filename().string();
-            if (filename.rfind(remaining_prefix, 0) == 0) {
-                matches.push_back(entry.path());
+    std::set<std::string> matched_names;
+    for (const auto& objects_dir : search_dirs) {
+        std::filesystem::path object_subdir = objects_dir / subdir_name;
+        if (!std::filesystem::exists(object_subdir, ec) || !std::filesystem::is_directory(object_subdir, ec)) {
+            ec.clear();
+            continue;
+        }
+
+        // 遍历对象目录所有文件 对比文件名字
+        for (const auto& entry : std::filesystem::directory_iterator(object_subdir, ec)) {
+            if (entry.is_regular_file(ec)) {
+                std::string filename = entry.path().filename().string();
+                if (filename.rfind(remaining_prefix, 0) == 0 && entry.path().extension() != ".tmp" &&
+                    matched_names.insert(filename).second) {
+                    matches.push_back(entry.path());
+                }
+            } else if (ec) {
+                std::cerr << "警告: 遍历对象目录 " << object_subdir.string() << " 时出错: " << entry.path().string() << ": " << ec.message() << std::endl;
+                ec.clear(); // 清除错误码继续
             }
-        } else if (ec) {
-            std::cerr << "警告: 遍历对象目录 " << object_subdir.string() << " 时出错: " << entry.path().string() << ": " << ec.message() << std::endl;
-            ec.clear(); // 清除错误码继续
         }
-    }
-    if (ec) { // directory_iterator 构造或迭代中的错误
-        std::cerr << "错误: 遍历对象目录 " << object_subdir.string() << " 失败: " << ec.message() << std::endl;
-        return std::nullopt;
+        if (ec) { // directory_iterator 构造或迭代中的错误
+            std::cerr << "错误: 遍历对象目录 " << object_subdir.string() << " 失败: " << ec.message() << std::endl;
+            return std::nullopt;
+        }
     }
 
 
@@ -4317,11 +6540,10 @@ std::optional<std::string> Repository::_resolve_commit_ish_to_full_hash(const st
 
     // 2. 检查是否是完整的引用路径 (以 "refs/" 开头)
     if (name_or_hash_prefix.rfind("refs/", 0) == 0) {
-        std::filesystem::path ref_file_path = mygit_dir_ / name_or_hash_prefix;
-        if (std::filesystem::exists(ref_file_path) && std::filesystem::is_regular_file(ref_file_path)) {
-            std::ifstream ref_file(ref_file_path);
-            std::string commit_hash_str;
-            if (ref_file >> commit_hash_str && commit_hash_str.length() == 40) {
+        std::optional<std::string> ref_content = _read_ref_file(common_dir_ / name_or_hash_prefix);
+        if (ref_content) {
+            const std::string& commit_hash_str = *ref_content;
+            if (commit_hash_str.length() == ObjectFormat::hex_length(get_object_format())) {
                 // 验证这个哈希确实是一个 commit 对象
                 auto commit_obj_opt = Commit::load_by_hash(commit_hash_str, get_objects_directory());
                 if (commit_obj_opt) {
@@ -4345,14 +6567,12 @@ std::optional<std::string> Repository::_resolve_commit_ish_to_full_hash(const st
         std::string remote_name_part = name_or_hash_prefix.substr(0, first_slash_pos);
         std::string branch_name_part = name_or_hash_prefix.substr(first_slash_pos + 1);
 
-        std::filesystem::path remote_tracking_branch_file_path =
-            mygit_dir_ / "refs" / "remotes" / remote_name_part / branch_name_part;
+        std::optional<std::string> ref_content =
+            _read_ref_file(common_dir_ / "refs" / "remotes" / remote_name_part / branch_name_part);
 
-        if (std::filesystem::exists(remote_tracking_branch_file_path) &&
-            std::filesystem::is_regular_file(remote_tracking_branch_file_path)) {
-            std::ifstream ref_file(remote_tracking_branch_file_path);
-            std::string commit_hash_str;
-            if (ref_file >> commit_hash_str && commit_hash_str.length() == 40) {
+        if (ref_content) {
+            const std::string& commit_hash_str = *ref_content;
+            if (commit_hash_str.length() == ObjectFormat::hex_length(get_object_format())) {
                 auto commit_obj_opt = Commit::load_by_hash(commit_hash_str, get_objects_directory());
                 if (commit_obj_opt) {
                     return commit_hash_str;
@@ -4366,11 +6586,10 @@ std::optional<std::string> Repository::_resolve_commit_ish_to_full_hash(const st
     // 4. 检查是否是短的分支名 (例如 "main" -> ".biogit/refs/heads/main")
     //    只在输入不包含 '/' 时才尝试，以避免与远程跟踪分支的简写形式冲突。
     if (name_or_hash_prefix.find('/') == std::string::npos) {
-        std::filesystem::path branch_file_path = get_heads_directory() / name_or_hash_prefix; //
-        if (std::filesystem::exists(branch_file_path) && std::filesystem::is_regular_file(branch_file_path)) {
-            std::ifstream branch_file(branch_file_path);
-            std::string commit_hash_str;
-            if (branch_file >> commit_hash_str && commit_hash_str.length() == 40) {
+        std::optional<std::string> branch_content = _read_ref_file(get_heads_directory() / name_or_hash_prefix);
+        if (branch_content) {
+            const std::string& commit_hash_str = *branch_content;
+            if (commit_hash_str.length() == ObjectFormat::hex_length(get_object_format())) {
                 auto commit_obj_opt = Commit::load_by_hash(commit_hash_str, get_objects_directory());
                 if (commit_obj_opt) {
                     return commit_hash_str;
@@ -4382,11 +6601,10 @@ std::optional<std::string> Repository::_resolve_commit_ish_to_full_hash(const st
     // 5. 检查是否是短的标签名 (例如 "v1.0" -> ".biogit/refs/tags/v1.0")
     //    同样，只在输入不包含 '/' 时才尝试。
     if (name_or_hash_prefix.find('/') == std::string::npos) {
-        std::filesystem::path tag_file_path = get_tags_directory() / name_or_hash_prefix; //
-        if (std::filesystem::exists(tag_file_path) && std::filesystem::is_regular_file(tag_file_path)) {
-            std::ifstream tag_file(tag_file_path);
-            std::string target_hash_str; // 标签可能指向 commit 或另一个 tag 对象 (附注标签)
-            if (tag_file >> target_hash_str && target_hash_str.length() == 40) {
+        std::optional<std::string> tag_content = _read_ref_file(get_tags_directory() / name_or_hash_prefix);
+        if (tag_content) {
+            const std::string& target_hash_str = *tag_content; // 标签可能指向 commit 或另一个 tag 对象 (附注标签)
+            if (target_hash_str.length() == ObjectFormat::hex_length(get_object_format())) {
                 // 当前假设是轻量标签，直接指向 commit
                 auto commit_obj_opt = Commit::load_by_hash(target_hash_str, get_objects_directory());
                 if (commit_obj_opt) {
@@ -4399,7 +6617,7 @@ std::optional<std::string> Repository::_resolve_commit_ish_to_full_hash(const st
 
     // 6. 尝试作为 commit 哈希或哈希前缀 (至少6个字符)
     //    确保输入看起来像一个哈希 (全是十六进制字符)
-    if (name_or_hash_prefix.length() >= 6 && name_or_hash_prefix.length() <= 40 &&
+    if (name_or_hash_prefix.length() >= 6 && name_or_hash_prefix.length() <= 64 &&
         std::all_of(name_or_hash_prefix.begin(), name_or_hash_prefix.end(), ::isxdigit)) {
 
         std::optional<std::filesystem::path> object_file_path_opt = _find_object_file_by_prefix(name_or_hash_prefix); //
@@ -4409,7 +6627,7 @@ std::optional<std::string> Repository::_resolve_commit_ish_to_full_hash(const st
             std::string file_part_str = object_file_path_opt->filename().string();
             std::string full_hash_str = dir_part_str + file_part_str;
 
-            if (full_hash_str.length() == 40) {
+            if (full_hash_str.length() == ObjectFormat::hex_length(get_object_format())) {
                 // 验证这个哈希确实是一个 commit 对象
                 auto commit_obj_opt = Commit::load_by_hash(full_hash_str, get_objects_directory());
                 if (commit_obj_opt) {
@@ -4435,8 +6653,11 @@ std::optional<std::string> Repository::_resolve_commit_ish_to_full_hash(const st
  * @return 如果成功加载并显示对象，返回 true；如果找不到对象、哈希有歧义或发生错误，返回 false。
  */
 bool Repository::show_object_by_hash(const std::string& object_hash_prefix, bool pretty_print)  {
-    // 1. 通过哈希前缀找到唯一的对象文件路径
-    std::optional<std::filesystem::path> object_file_path_opt = _find_object_file_by_prefix(object_hash_prefix);
+    // 1. 找到唯一的对象文件路径：哈希前缀、分支/标签名或 "<提交>:<路径>" (只读取路径经过的 Tree)
+    std::optional<std::filesystem::path> object_file_path_opt;
+    if (std::optional<std::string> full_hash_opt = _resolve_object_name(object_hash_prefix)) {
+        object_file_path_opt = _find_object_file_by_prefix(*full_hash_opt);
+    }
 
     if (!object_file_path_opt) {
         std::cout << "错误: 未找到对象或哈希前缀 '" << object_hash_prefix << "' 具有歧义。" << std::endl;
@@ -4455,7 +6676,7 @@ bool Repository::show_object_by_hash(const std::string& object_hash_prefix, bool
 
     // 3. 根据对象类型，反序列化并打印内容
     if (pretty_print) { // “美化”打印，类似 git cat-file -p
-        if (type_str_read == Blob::type_str()) {
+        if (type_str_read == Blob::type_str() || type_str_read == Blob::chunk_type_str()) {
             // Blob 对象的内容就是原始文件内容，直接打印
             for (std::byte b : raw_content_data) {
                 std::cout << static_cast<char>(b);
@@ -4464,8 +6685,20 @@ bool Repository::show_object_by_hash(const std::string& object_hash_prefix, bool
             if (!raw_content_data.empty() && raw_content_data.back() != static_cast<std::byte>('\n')) {
                 std::cout << std::endl;
             }
+        } else if (type_str_read == Blob::manifest_type_str()) {
+            // 分块存储的 Blob：重组后打印完整内容
+            std::string full_hash = object_file_path.parent_path().filename().string() + object_file_path.filename().string();
+            auto blob_opt = Blob::assemble_from_manifest(full_hash, raw_content_data, get_objects_directory());
+            if (!blob_opt) {
+                return false;
+            }
+            std::string content = blob_opt->get_content_as_string();
+            std::cout << content;
+            if (!content.empty() && content.back() != '\n') {
+                std::cout << std::endl;
+            }
         } else if (type_str_read == Tree::type_str()) {
-            auto tree_opt = Tree::deserialize(raw_content_data);
+            auto tree_opt = Tree::deserialize(raw_content_data, ObjectFormat::hex_length(get_object_format()));
             if (tree_opt) {
                 // Tree 对象的条目应该是已排序的 (在其序列化/反序列化逻辑中保证)
                 for (const auto& entry : tree_opt->entries) {
@@ -4536,27 +6769,22 @@ bool Repository::is_workspace_clean() const {
         return false; // 无法确定状态，保守处理为不干净
     }
     const auto& staged_entries = index_reader.get_all_entries();
-    std::map<std::filesystem::path, const IndexEntry*> staged_files_map;
-    for (const auto& entry : staged_entries) {
-        staged_files_map[entry.file_path] = &entry;
-    }
 
     // 3. 比较 Index vs HEAD (检查是否有“要提交的更改”)
-    for (const auto& staged_pair : staged_files_map) {
-        const auto& rel_path = staged_pair.first;
-        const auto* staged_entry = staged_pair.second;
+    for (const IndexEntry& staged_entry : staged_entries) {
+        const auto& rel_path = staged_entry.file_path;
         auto head_it = head_files_map.find(rel_path);
         if (head_it == head_files_map.end()) { // 文件在 Index 中，但不在 HEAD 中 (新暂存的文件)
             std::cout << "  提示 (is_workspace_clean): 已暂存的新文件: " << rel_path.string() << std::endl;
             return false;
         }
-        if (staged_entry->blob_hash_hex != head_it->second.first || staged_entry->mode != head_it->second.second) {
+        if (staged_entry.blob_hash_hex != head_it->second.first || staged_entry.mode != head_it->second.second) {
             std::cout << "  提示 (is_workspace_clean): 已暂存的修改: " << rel_path.string() << std::endl;
             return false;
         }
     }
     for (const auto& head_pair : head_files_map) {
-        if (staged_files_map.find(head_pair.first) == staged_files_map.end()) {
+        if (!index_reader.find_entry(head_pair.first)) {
             std::cout << "  提示 (is_workspace_clean): 已暂存的删除: " << head_pair.first.string() << std::endl;
             return false;
         }
@@ -4564,6 +6792,7 @@ bool Repository::is_workspace_clean() const {
 
     // 4. 比较 Working Directory vs Index (检查是否有“未暂存的更改”)
     std::error_code ec_wd;
+    const uintmax_t lfs_threshold = _lfs_threshold();
     if (std::filesystem::exists(work_tree_root_) && std::filesystem::is_directory(work_tree_root_)) {
         std::filesystem::recursive_directory_iterator dir_iter(
             work_tree_root_,
@@ -4582,7 +6811,7 @@ bool Repository::is_workspace_clean() const {
             const auto& current_abs_path_from_iterator = current_dir_entry_obj.path();
 
             // 跳过 .biogit 目录
-            if (current_abs_path_from_iterator.lexically_normal().string().rfind(mygit_dir_.lexically_normal().string(), 0) == 0) {
+            if (current_abs_path_from_iterator.lexically_normal().string().rfind((work_tree_root_ / MYGIT_DIR_NAME).lexically_normal().string(), 0) == 0) {
                 if (dir_iter.depth() == 0 && current_abs_path_from_iterator.filename() == MYGIT_DIR_NAME) {
                      dir_iter.disable_recursion_pending();
                 }
@@ -4593,9 +6822,8 @@ bool Repository::is_workspace_clean() const {
                 std::filesystem::path rel_path = std::filesystem::relative(current_abs_path_from_iterator.lexically_normal(), work_tree_root_, entry_ec).lexically_normal();
                 if (entry_ec || rel_path.empty() || rel_path.string().rfind("..",0) == 0) continue;
 
-                auto staged_it = staged_files_map.find(rel_path);
-                if (staged_it != staged_files_map.end()) { // 文件被跟踪
-                    const IndexEntry* staged_entry = staged_it->second;
+                const IndexEntry* staged_entry = index_reader.find_entry(rel_path);
+                if (staged_entry) { // 文件被跟踪
                     // bool metadata_differs = false;
                     // auto ftime_workdir = std::filesystem::last_write_time(current_abs_path_from_iterator, entry_ec);
                     // if (entry_ec) { metadata_differs = true; }
@@ -4611,6 +6839,13 @@ bool Repository::is_workspace_clean() const {
                     // else if (size_workdir != staged_entry->file_size) metadata_differs = true;
                     //
                     // if (metadata_differs) 元数据不同，需比较内容
+                        if (auto lfs_blob_hash_opt = _lfs_pointer_blob_hash(current_abs_path_from_iterator, lfs_threshold)) {
+                            if (*lfs_blob_hash_opt != staged_entry->blob_hash_hex) {
+                                std::cout << "  提示 (is_workspace_clean): 工作区修改未暂存: " << rel_path.string() << std::endl;
+                                return false;
+                            }
+                            continue; // 大文件按指针比较，不读入内存
+                        }
                         std::ifstream ifs_wd(current_abs_path_from_iterator, std::ios::binary);
                         std::vector<std::byte> content_wd;
                         if(ifs_wd.is_open()){
@@ -4619,7 +6854,7 @@ bool Repository::is_workspace_clean() const {
                             ifs_wd.close();
                         }
                         Blob temp_blob_wd(content_wd);
-                        if (SHA1::sha1(temp_blob_wd.serialize()) != staged_entry->blob_hash_hex) {
+                        if (ObjectFormat::hash(get_objects_directory(), temp_blob_wd.serialize()) != staged_entry->blob_hash_hex) {
                             std::cout << "  提示 (is_workspace_clean): 工作区修改未暂存: " << rel_path.string() << std::endl;
                             return false; // 内容已修改但未暂存
                         }
@@ -4630,10 +6865,10 @@ bool Repository::is_workspace_clean() const {
         }
     }
     // 检查是否有在索引中但工作目录中被删除的文件
-    for(const auto& staged_pair : staged_files_map) {
-        if (!std::filesystem::exists(work_tree_root_ / staged_pair.first))  {
+    for(const IndexEntry& staged_entry : staged_entries) {
+        if (!std::filesystem::exists(work_tree_root_ / staged_entry.file_path))  {
             // 文件在索引中，但在工作目录遍历时未找到
-            std::cout << "  提示 (is_workspace_clean): 文件从工作区删除但未暂存: " << staged_pair.first.string() << std::endl;
+            std::cout << "  提示 (is_workspace_clean): 文件从工作区删除但未暂存: " << staged_entry.file_path.string() << std::endl;
             return false;
         }
     }
@@ -4656,10 +6891,13 @@ bool Repository::_update_working_directory_from_tree(
     _load_tree_contents_recursive(target_root_tree_hash, "", target_tree_files_map);
 
     std::error_code ec;
+    const LfsStore lfs_store(common_dir_);
+    const bool lfs_use_hardlink = config_get("lfs.hardlink").value_or("false") == "true"; // 硬链接省空间，但就地修改文件会破坏内容库
 
-    // 1. 删除/修改工作目录中存在于 current_head 但不在 target_tree 中的文件，
-    //    或者内容/模式有变化的文件。
+    // 1. 找出需要写出的文件 (新增的、内容有变化的或工作区中缺失的)，并按顺序创建其父目录
     std::set<std::filesystem::path> paths_in_target_tree;
+    std::vector<std::pair<std::filesystem::path, std::string>> files_to_write; // <相对路径, Blob 哈希>
+    std::set<std::filesystem::path> created_directories;
     for (const auto& target_pair : target_tree_files_map) {
         paths_in_target_tree.insert(target_pair.first);
         const std::filesystem::path& rel_path = target_pair.first;
@@ -4677,39 +6915,96 @@ bool Repository::_update_working_directory_from_tree(
         }
         // (更精确的：如果文件已在工作区且元数据与index一致，可跳过写，但index刚被target_tree重置)
         // 简单起见，只要是目标树中的文件，就确保其内容正确。
+        if (!needs_update && std::filesystem::exists(abs_path_in_worktree)) continue;
 
-        if (needs_update || !std::filesystem::exists(abs_path_in_worktree)) {
-            // 从对象库加载 Blob 内容
-            auto blob_opt = Blob::load_by_hash(target_blob_hash, get_objects_directory());
-            if (!blob_opt) {
-                std::cerr << "错误 (checkout): 无法加载 Blob " << target_blob_hash << " 用于文件 " << rel_path.string() << std::endl;
-                return false; // 关键Blob丢失，更新失败
+        // 创建父目录 (如果不存在；同一目录只创建一次)
+        if (abs_path_in_worktree.has_parent_path() && created_directories.insert(abs_path_in_worktree.parent_path()).second) {
+            std::filesystem::create_directories(abs_path_in_worktree.parent_path(), ec);
+            if (ec) {
+                 std::cerr << "错误 (checkout): 创建目录 " << abs_path_in_worktree.parent_path().string() << " 失败: " << ec.message() << std::endl;
+                 return false;
             }
-            // 创建父目录 (如果不存在)
-            if (abs_path_in_worktree.has_parent_path()) {
-                std::filesystem::create_directories(abs_path_in_worktree.parent_path(), ec);
-                if (ec) {
-                     std::cerr << "错误 (checkout): 创建目录 " << abs_path_in_worktree.parent_path().string() << " 失败: " << ec.message() << std::endl;
-                     return false;
+        }
+        files_to_write.emplace_back(rel_path, target_blob_hash);
+    }
+
+    // 1.1 按批写出文件：并行加载 Blob (大文件指针直接从内容库写出)，再经 I/O 后端 (core.ioBackend，
+    //     队列深度 core.ioThreads) 整批写入；提示和错误按文件顺序输出，出错后不再写出后续批次。
+    //     每批的文件数和已加载的 Blob 总量都有上限：Blob 大小只有加载后才知道，已加载量达到上限后
+    //     尚未开始的文件推迟到下一批 (每批第一个文件总会加载，保证前进)
+    constexpr size_t FILES_PER_WRITE_BATCH = 256;                   // 限制同时驻留内存的 Blob 数
+    constexpr uintmax_t WRITE_BATCH_BYTES = 64 * 1024 * 1024;       // 限制同时驻留内存的 Blob 总量
+    std::unique_ptr<IoBackend> io_backend = _io_backend();
+    const OrderedTaskPool load_pool(_configured_thread_count("core.ioThreads"));
+    std::atomic<bool> write_failed{false};
+    std::vector<size_t> deferred_files; // 上一批因总量上限推迟的 files_to_write 下标
+    for (size_t next_file = 0; (next_file < files_to_write.size() || !deferred_files.empty()) && !write_failed;) {
+        std::vector<size_t> batch = std::move(deferred_files);
+        deferred_files.clear();
+        while (batch.size() < FILES_PER_WRITE_BATCH && next_file < files_to_write.size()) batch.push_back(next_file++);
+        std::vector<std::optional<Blob>> blobs_to_write(batch.size()); // 为空表示无需 (或无法) 由 I/O 后端写出
+        std::vector<char> deferred(batch.size(), 0);
+        std::atomic<uintmax_t> loaded_bytes{0};
+        std::vector<OrderedTaskPool::Task> load_tasks;
+        load_tasks.reserve(batch.size());
+        for (size_t k = 0; k < batch.size(); ++k) {
+            load_tasks.push_back([&, k](std::ostream& out) {
+                if (write_failed) return; // 已有文件失败，不再继续写出
+                if (k > 0 && loaded_bytes >= WRITE_BATCH_BYTES) {
+                    deferred[k] = 1;
+                    return;
                 }
+                const auto& [rel_path, target_blob_hash] = files_to_write[batch[k]];
+                const std::filesystem::path abs_path_in_worktree = work_tree_root_ / rel_path;
+                // 从对象库加载 Blob 内容
+                auto blob_opt = Blob::load_by_hash(target_blob_hash, get_objects_directory());
+                if (!blob_opt) {
+                    out << "错误 (checkout): 无法加载 Blob " << target_blob_hash << " 用于文件 " << rel_path.string() << std::endl;
+                    write_failed = true; // 关键Blob丢失，更新失败
+                    return;
+                }
+                // 大文件指针：从内容库写出真实内容；内容库中没有时写出指针文本，待获取内容后再检出
+                if (blob_opt->content.size() <= LfsPointer::MAX_POINTER_SIZE) {
+                    if (auto pointer_opt = LfsPointer::parse(blob_opt->get_content_as_string())) {
+                        if (lfs_store.materialize(*pointer_opt, abs_path_in_worktree, lfs_use_hardlink)) {
+                            return;
+                        }
+                        out << "提示: 大文件 '" << rel_path.string() << "' 的内容 (" << pointer_opt->oid.substr(0, 7)
+                            << ") 不在本地内容库中，已写出其指针文件。" << std::endl;
+                    }
+                }
+                // 启用硬链接时先断开旧文件，避免截断写入改坏内容库中的大文件
+                if (lfs_use_hardlink) {
+                    std::error_code remove_ec;
+                    std::filesystem::remove(abs_path_in_worktree, remove_ec);
+                }
+                loaded_bytes += blob_opt->content.size();
+                blobs_to_write[k] = std::move(blob_opt);
+            });
+        }
+        load_pool.run(load_tasks, std::cout);
+        if (write_failed) break;
+        for (size_t k = 0; k < batch.size(); ++k) {
+            if (deferred[k]) deferred_files.push_back(batch[k]);
+        }
+
+        std::vector<IoBackend::WriteRequest> write_requests;
+        for (size_t k = 0; k < batch.size(); ++k) {
+            const std::optional<Blob>& blob_opt = blobs_to_write[k];
+            if (!blob_opt) continue;
+            write_requests.push_back({work_tree_root_ / files_to_write[batch[k]].first, blob_opt->content.data(), blob_opt->content.size()});
+        }
+        const std::vector<bool> written = io_backend->write_files(write_requests);
+        for (size_t k = 0; k < written.size(); ++k) {
+            if (!written[k]) {
+                std::cerr << "错误 (checkout): 无法写入文件 " << write_requests[k].path.string() << std::endl;
+                write_failed = true;
             }
-            // 写入文件
-            std::ofstream ofs(abs_path_in_worktree, std::ios::binary | std::ios::trunc);
-            if (!ofs.is_open()) {
-                std::cerr << "错误 (checkout): 无法写入文件 " << abs_path_in_worktree.string() << std::endl;
-                return false;
-            }
-            const auto& content_bytes = blob_opt->content;
-            if (!content_bytes.empty()) {
-                ofs.write(reinterpret_cast<const char*>(content_bytes.data()), content_bytes.size());
-            }
-            ofs.close();
-            if (!ofs.good()){
-                 std::cerr << "错误 (checkout): 写入文件 " << abs_path_in_worktree.string() << " 时发生错误。" << std::endl;
-                 return false;
-            }
-            // TODO: 设置文件模式 (例如可执行位)，简化版中可省略
         }
+        // TODO: 设置文件模式 (例如可执行位)，简化版中可省略
+    }
+    if (write_failed) {
+        return false;
     }
 
     // 2. 删除工作目录中存在于 current_head (或只是存在于磁盘) 但不在 target_tree 中的文件
@@ -4758,12 +7053,20 @@ std::optional<std::vector<std::string>> Repository::_get_blob_lines(const std::s
  * @param relative_path 文件相对于工作树根的路径。
  * @return 如果成功，返回行列表；否则返回 std::nullopt。
  */
-std::optional<std::vector<std::string>> Repository::_get_workdir_lines(const std::filesystem::path& relative_path) const {
+std::optional<std::vector<std::string>> Repository::_get_workdir_lines(const std::filesystem::path& relative_path, uintmax_t lfs_threshold) const {
     std::filesystem::path absolute_path = work_tree_root_ / relative_path;
     if (!std::filesystem::exists(absolute_path) || !std::filesystem::is_regular_file(absolute_path)) {
         return std::nullopt; // 文件不存在或不是常规文件
     }
 
+    // 达到大文件阈值的文件以指针文本参与比较 (与 add 存入对象库的指针 Blob 一致)
+    std::error_code size_ec;
+    if (lfs_threshold > 0 && std::filesystem::file_size(absolute_path, size_ec) >= lfs_threshold && !size_ec) {
+        if (auto pointer_opt = LfsStore::pointer_for_file(absolute_path)) {
+            return Utils::string_to_lines(pointer_opt->serialize());
+        }
+    }
+
     std::ifstream ifs(absolute_path, std::ios::binary);
     if (!ifs.is_open()) {
         std::cerr << "错误: 无法打开工作目录文件 '" << absolute_path.string() << "'。" << std::endl;
@@ -4778,6 +7081,176 @@ std::optional<std::vector<std::string>> Repository::_get_workdir_lines(const std
 }
 
 
+/**
+ * @brief 探测 Blob 是否为二进制 (只读取开头 Utils::BINARY_SNIFF_SIZE 字节)。
+ * Blob 内容由哈希唯一确定，因此结果按哈希缓存在进程内，可供并行的 diff 任务共享；
+ * 缓存最多保留 PROBE_CACHE_CAPACITY 条，超出时淘汰最久未用的条目 (守护进程等长时间运行的进程中不会无限增长)。
+ */
+std::optional<Repository::ContentProbe> Repository::_probe_blob(const std::string& blob_hash) const {
+    constexpr size_t PROBE_CACHE_CAPACITY = 8192;
+    static std::mutex cache_mutex;
+    static std::list<std::pair<std::string, ContentProbe>> probe_lru; // 最近使用的在前
+    static std::unordered_map<std::string, std::list<std::pair<std::string, ContentProbe>>::iterator> probe_cache;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = probe_cache.find(blob_hash);
+        if (it != probe_cache.end()) {
+            probe_lru.splice(probe_lru.begin(), probe_lru, it->second);
+            return it->second->second;
+        }
+    }
+
+    auto prefix_opt = Blob::read_prefix(blob_hash, get_objects_directory(), Utils::BINARY_SNIFF_SIZE);
+    if (!prefix_opt) {
+        return std::nullopt;
+    }
+    const auto& [total_size, prefix] = *prefix_opt;
+    ContentProbe probe{Utils::looks_binary(reinterpret_cast<const char*>(prefix.data()), prefix.size()), total_size};
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (!probe_cache.count(blob_hash)) { // 并行任务可能已经先写入
+        probe_lru.emplace_front(blob_hash, probe);
+        probe_cache.emplace(blob_hash, probe_lru.begin());
+        if (probe_lru.size() > PROBE_CACHE_CAPACITY) {
+            probe_cache.erase(probe_lru.back().first);
+            probe_lru.pop_back();
+        }
+    }
+    return probe;
+}
+
+
+/**
+ * @brief 探测工作区文件是否为二进制 (只读取开头部分)。
+ */
+std::optional<Repository::ContentProbe> Repository::_probe_workdir_file(const std::filesystem::path& relative_path, uintmax_t lfs_threshold) const {
+    std::filesystem::path absolute_path = work_tree_root_ / relative_path;
+    std::error_code ec;
+    uintmax_t file_size = std::filesystem::file_size(absolute_path, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    if (lfs_threshold > 0 && file_size >= lfs_threshold) {
+        return ContentProbe{false, file_size}; // 以指针文本参与比较
+    }
+
+    std::ifstream ifs(absolute_path, std::ios::binary);
+    if (!ifs.is_open()) {
+        return std::nullopt;
+    }
+    std::vector<char> sample(static_cast<size_t>(std::min<uintmax_t>(file_size, Utils::BINARY_SNIFF_SIZE)));
+    ifs.read(sample.data(), static_cast<std::streamsize>(sample.size()));
+    return ContentProbe{Utils::looks_binary(sample.data(), static_cast<size_t>(ifs.gcount())), file_size};
+}
+
+
+/**
+ * @brief 以流式读取计算工作区文件的 Blob 对象哈希：先按文件大小写入对象头部，再逐块送入文件内容。
+ */
+std::optional<std::string> Repository::_hash_workdir_file(const std::filesystem::path& absolute_path) const {
+    std::error_code ec;
+    const uintmax_t file_size = std::filesystem::file_size(absolute_path, ec);
+    if (ec) return std::nullopt;
+    std::ifstream ifs(absolute_path, std::ios::binary);
+    if (!ifs.is_open()) return std::nullopt;
+
+    ObjectFormat::Hasher hasher(get_object_format());
+    const std::string header = Blob::type_str() + " " + std::to_string(file_size) + '\0';
+    hasher.update(header.data(), header.size());
+    std::vector<char> buffer(64 * 1024);
+    uintmax_t hashed_size = 0;
+    while (ifs) {
+        ifs.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        const std::streamsize read_count = ifs.gcount();
+        if (read_count <= 0) break;
+        hasher.update(buffer.data(), static_cast<size_t>(read_count));
+        hashed_size += static_cast<uintmax_t>(read_count);
+    }
+    if (ifs.bad() || hashed_size != file_size) return std::nullopt; // 读取出错或文件在读取期间被改动
+    return hasher.hex_digest();
+}
+
+
+/**
+ * @brief 任一版本为二进制时只打印摘要 (格式与 git 相同，附带大小变化)。
+ */
+bool Repository::_print_binary_diff_if_needed(const std::filesystem::path& old_path,
+                                              const std::filesystem::path& new_path,
+                                              const std::string& old_blob_hash,
+                                              const std::string& new_blob_hash,
+                                              bool new_from_workdir,
+                                              const std::vector<std::string>& extended_header_lines,
+                                              const DiffSettings& settings,
+                                              std::ostream& out) const {
+    // 1. 探测两边 (不存在的一边视为空文本)
+    const bool has_old = !old_blob_hash.empty();
+    const bool has_new = new_from_workdir || !new_blob_hash.empty();
+    std::optional<ContentProbe> old_probe = has_old ? _probe_blob(old_blob_hash) : std::make_optional(ContentProbe{});
+    std::optional<ContentProbe> new_probe = new_from_workdir ? _probe_workdir_file(new_path, settings.lfs_threshold)
+                                          : (has_new ? _probe_blob(new_blob_hash) : std::make_optional(ContentProbe{}));
+    if (!old_probe || !new_probe || (!old_probe->binary && !new_probe->binary)) {
+        return false;
+    }
+
+    // 2. 打印摘要
+    out << "diff --biogit a/" << old_path.generic_string() << " b/" << new_path.generic_string() << std::endl;
+    for (const auto& header_line : extended_header_lines) {
+        out << header_line << std::endl;
+    }
+    out << "Binary files " << (has_old ? "a/" + old_path.generic_string() : std::string("/dev/null"))
+        << " and " << (has_new ? "b/" + new_path.generic_string() : std::string("/dev/null")) << " differ"
+        << " (" << old_probe->size << " -> " << new_probe->size << " 字节";
+
+    // 3. (可选) 按内容定义分块估算增量：新版本中不属于旧版本任何块的字节数。
+    //    估算要把两边的完整内容读入内存，任一边超过 BINARY_DELTA_MAX_SIZE 时不估算
+    constexpr uintmax_t BINARY_DELTA_MAX_SIZE = 64 * 1024 * 1024;
+    if (settings.binary_delta && has_new &&
+        (old_probe->size > BINARY_DELTA_MAX_SIZE || new_probe->size > BINARY_DELTA_MAX_SIZE)) {
+        out << "，文件过大，未估算增量";
+    } else if (settings.binary_delta && has_new) {
+        auto load_bytes = [this](const std::string& blob_hash, const std::filesystem::path& workdir_path) -> std::optional<std::vector<std::byte>> {
+            if (!workdir_path.empty()) {
+                std::ifstream ifs(work_tree_root_ / workdir_path, std::ios::binary | std::ios::ate);
+                if (!ifs.is_open()) return std::nullopt;
+                const std::streamoff file_size = ifs.tellg();
+                if (file_size < 0 || static_cast<uintmax_t>(file_size) > BINARY_DELTA_MAX_SIZE) return std::nullopt; // 探测之后被改大
+                std::vector<std::byte> bytes(static_cast<size_t>(file_size));
+                ifs.seekg(0);
+                ifs.read(reinterpret_cast<char*>(bytes.data()), file_size);
+                if (ifs.gcount() != file_size) return std::nullopt;
+                return bytes;
+            }
+            auto blob_opt = Blob::load_by_hash(blob_hash, get_objects_directory());
+            if (!blob_opt) return std::nullopt;
+            return std::move(blob_opt->content);
+        };
+        auto old_bytes = has_old ? load_bytes(old_blob_hash, {}) : std::make_optional(std::vector<std::byte>{});
+        auto new_bytes = load_bytes(new_blob_hash, new_from_workdir ? new_path : std::filesystem::path{});
+        if (old_bytes && new_bytes) {
+            const FastCdcChunker chunker;
+            auto chunk_view = [](const std::vector<std::byte>& bytes, size_t offset, size_t length) {
+                return std::string_view(reinterpret_cast<const char*>(bytes.data()) + offset, length);
+            };
+            std::unordered_set<std::string_view> old_chunks;
+            size_t offset = 0;
+            for (size_t length : chunker.split(old_bytes->data(), old_bytes->size())) {
+                old_chunks.insert(chunk_view(*old_bytes, offset, length));
+                offset += length;
+            }
+            uintmax_t delta_size = 0;
+            offset = 0;
+            for (size_t length : chunker.split(new_bytes->data(), new_bytes->size())) {
+                if (!old_chunks.contains(chunk_view(*new_bytes, offset, length))) delta_size += length;
+                offset += length;
+            }
+            out << "，增量约 " << delta_size << " 字节";
+        }
+    }
+    out << ")" << std::endl;
+    return true;
+}
+
+
 /**
  * @brief 比较并打印两个版本文件内容的差异。
  * @param display_path 用于在 diff 输出中显示的文件路径。
@@ -4791,8 +7264,17 @@ void Repository::_perform_and_print_file_diff(
         const std::vector<std::string>& lines_a,
         const std::string& label_a_suffix,
         const std::vector<std::string>& lines_b,
-        const std::string& label_b_suffix){
-
+        const std::string& label_b_suffix,
+        const DiffSettings& settings,
+        std::ostream& out) const {
+
+    // 序列/变异文件按记录比较，避免折叠行错位导致整条序列都成为差异
+    if (const DiffDriver* driver = _diff_driver_for(display_path, settings)) {
+        if (auto hunks_opt = driver->diff(lines_a, lines_b)) {
+            DiffDrivers::print_hunks(display_path, display_path, *hunks_opt, label_a_suffix, label_b_suffix, {}, out);
+            return;
+        }
+    }
 
     std::vector<Utils::LineEditOperation> ses = Utils::MyersDiffLines(lines_a, lines_b);
 
@@ -4802,7 +7284,249 @@ void Repository::_perform_and_print_file_diff(
     // 确保您的 print_unified_diff 实现支持这个。
     // 为了简洁，我假设您的 print_unified_diff 内部会处理这个。
     // 如果不是，您可能需要在这里构建完整的标签字符串传递给它。
-    print_unified_diff(display_path, ses, label_a_suffix, label_b_suffix);
+    Utils::print_unified_diff(display_path, display_path, ses, label_a_suffix, label_b_suffix, 3, {}, out);
+}
+
+
+/**
+ * @brief 在删除和新增的文件之间检测重命名/复制
+ * 精确匹配按 Blob 哈希完成；非精确匹配使用 RenameDetector 的 MinHash 草图与 LSH 索引。
+ */
+std::vector<RenamePair> Repository::_detect_renames(
+        const std::map<std::filesystem::path, std::string>& deleted,
+        const std::map<std::filesystem::path, std::string>& added,
+        const std::map<std::filesystem::path, std::string>& copy_sources,
+        bool detect_copies,
+        int min_similarity,
+        bool exact_only) const {
+
+    RenameDetectionOptions detection_options;
+    detection_options.detect_copies = detect_copies;
+    detection_options.min_similarity = min_similarity;
+    detection_options.exact_only = exact_only;
+    detection_options.object_format = get_object_format();
+    if (auto limit_opt = config_get("diff.renameLimit")) {
+        try {
+            detection_options.rename_limit = std::stoul(*limit_opt);
+        } catch (const std::exception&) {
+            std::cerr << "警告: 配置项 diff.renameLimit 的值 '" << *limit_opt << "' 无效，使用默认值。" << std::endl;
+        }
+    }
+
+    std::filesystem::path objects_dir = get_objects_directory();
+    RenameDetector detector([objects_dir](const std::string& blob_hash) -> std::optional<std::string> {
+        auto blob_opt = Blob::load_by_hash(blob_hash, objects_dir);
+        if (!blob_opt) return std::nullopt;
+        return blob_opt->get_content_as_string();
+    }, detection_options);
+
+    return detector.detect(deleted, added, copy_sources);
+}
+
+
+/**
+ * @brief 打印一对重命名/复制文件的差异
+ * 格式与 git 一致: diff 行之后依次为 similarity index、rename from/to (或 copy from/to)，内容有变化时再输出 Hunk。
+ */
+void Repository::_print_rename_diff(const RenamePair& rename_pair,
+                                    const std::string& label_a_suffix,
+                                    const std::string& label_b_suffix,
+                                    const DiffSettings& settings,
+                                    std::ostream& out) const {
+    const std::string verb = rename_pair.is_copy ? "copy" : "rename";
+    std::vector<std::string> extended_headers = {
+        "similarity index " + std::to_string(rename_pair.similarity) + "%",
+        verb + " from " + rename_pair.old_path.generic_string(),
+        verb + " to " + rename_pair.new_path.generic_string()
+    };
+
+    std::vector<Utils::LineEditOperation> ses;
+    if (rename_pair.old_blob_hash != rename_pair.new_blob_hash) {
+        if (_print_binary_diff_if_needed(rename_pair.old_path, rename_pair.new_path, rename_pair.old_blob_hash,
+                                         rename_pair.new_blob_hash, false, extended_headers, settings, out)) {
+            return;
+        }
+        auto lines_a_opt = _get_blob_lines(rename_pair.old_blob_hash);
+        auto lines_b_opt = _get_blob_lines(rename_pair.new_blob_hash);
+        if (lines_a_opt && lines_b_opt) {
+            if (const DiffDriver* driver = _diff_driver_for(rename_pair.new_path, settings)) {
+                if (auto hunks_opt = driver->diff(*lines_a_opt, *lines_b_opt)) {
+                    DiffDrivers::print_hunks(rename_pair.old_path, rename_pair.new_path, *hunks_opt,
+                                             label_a_suffix, label_b_suffix, extended_headers, out);
+                    return;
+                }
+            }
+            ses = Utils::MyersDiffLines(*lines_a_opt, *lines_b_opt);
+        }
+    }
+    Utils::print_unified_diff(rename_pair.old_path, rename_pair.new_path, ses,
+                              label_a_suffix, label_b_suffix, 3, extended_headers, out);
+}
+
+
+/**
+ * @brief 并行执行逐文件的 diff 任务
+ * 每个任务负责一个文件的 Blob 读取、Myers 比较和格式化；结果按任务顺序 (即路径顺序) 输出。
+ */
+void Repository::_run_diff_tasks(const std::vector<OrderedTaskPool::Task>& diff_tasks) const {
+    OrderedTaskPool(_configured_thread_count("diff.threads")).run(diff_tasks, std::cout);
+}
+
+std::unique_ptr<IoBackend> Repository::_io_backend() const {
+    IoBackend::Kind kind = IoBackend::Kind::Auto;
+    if (auto backend_opt = config_get("core.ioBackend")) {
+        if (auto kind_opt = IoBackend::parse_kind(*backend_opt)) {
+            kind = *kind_opt;
+        } else {
+            std::cerr << "警告: 配置项 core.ioBackend 的值 '" << *backend_opt << "' 无效 (可选 auto、threads、io_uring)，使用 auto。" << std::endl;
+        }
+    }
+    std::unique_ptr<IoBackend> backend = IoBackend::create(kind, _configured_thread_count("core.ioThreads"));
+    if (kind == IoBackend::Kind::IoUring && backend->kind() != kind) {
+        std::cerr << "警告: 当前系统不支持 io_uring，改用线程池。" << std::endl;
+    }
+    return backend;
+}
+
+size_t Repository::_configured_thread_count(const std::string& config_key) const {
+    size_t num_threads = 0; // 0: 使用硬件并发数
+    if (auto threads_opt = config_get(config_key)) {
+        try {
+            num_threads = std::stoul(*threads_opt);
+        } catch (const std::exception&) {
+            std::cerr << "警告: 配置项 " << config_key << " 的值 '" << *threads_opt << "' 无效，使用默认值。" << std::endl;
+        }
+    }
+    return num_threads;
+}
+
+
+/**
+ * @brief 按路径选择按记录比较的 diff 驱动 (FASTA/FASTQ/VCF)
+ * 配置项 diff.<驱动名>.pattern 可覆盖默认的文件名模式；没有匹配时返回 nullptr。
+ */
+const DiffDriver* Repository::_diff_driver_for(const std::filesystem::path& relative_path, const DiffSettings& settings) const {
+    return DiffDrivers::find_for_path(relative_path, settings.driver_config);
+}
+
+Repository::DiffSettings Repository::_diff_settings() const {
+    DiffSettings settings;
+    settings.lfs_threshold = _lfs_threshold();
+    settings.binary_delta = config_get("diff.binaryDelta").value_or("false") == "true";
+    settings.driver_config = DiffDrivers::snapshot_config([this](const std::string& key) { return config_get(key); });
+    return settings;
+}
+
+
+/**
+ * @brief 以摘要格式打印改动列表
+ * --name-only:   <路径>
+ * --name-status: <状态>\t<路径>  (重命名/复制为 R<相似度>\t<旧路径>\t<新路径>)
+ * --stat:        " <路径> | <增删行数> +++--"，最后一行为汇总
+ */
+void Repository::_print_diff_summary(const std::vector<DiffFileChange>& changes, DiffOutputFormat format, const DiffSettings& settings) const {
+    if (format == DiffOutputFormat::NAME_ONLY) {
+        for (const auto& change : changes) {
+            std::cout << change.new_path.generic_string() << std::endl;
+        }
+        return;
+    }
+
+    if (format == DiffOutputFormat::NAME_STATUS) {
+        for (const auto& change : changes) {
+            if (change.status == 'R' || change.status == 'C') {
+                char similarity_buf[8];
+                std::snprintf(similarity_buf, sizeof(similarity_buf), "%03d", change.similarity);
+                std::cout << change.status << similarity_buf << "\t" << change.old_path.generic_string()
+                          << "\t" << change.new_path.generic_string() << std::endl;
+            } else {
+                std::cout << change.status << "\t" << change.new_path.generic_string() << std::endl;
+            }
+        }
+        return;
+    }
+
+    // --stat: 先统计每个文件的增删行数，再统一对齐输出
+    struct StatLine {
+        std::string display_name;
+        int insertions = 0;
+        int deletions = 0;
+        std::optional<std::pair<uintmax_t, uintmax_t>> binary_sizes; ///< 二进制文件: <旧大小, 新大小>
+    };
+    std::vector<StatLine> stat_lines;
+    stat_lines.reserve(changes.size());
+    size_t name_width = 0;
+    int max_changes = 0;
+    int total_insertions = 0, total_deletions = 0;
+
+    for (const auto& change : changes) {
+        StatLine stat_line;
+        stat_line.display_name = (change.status == 'R' || change.status == 'C')
+            ? change.old_path.generic_string() + " => " + change.new_path.generic_string()
+            : change.new_path.generic_string();
+
+        // 二进制文件不按行统计，只显示大小变化
+        auto old_probe = change.old_blob_hash.empty() ? std::make_optional(ContentProbe{}) : _probe_blob(change.old_blob_hash);
+        auto new_probe = change.new_from_workdir ? _probe_workdir_file(change.new_path, settings.lfs_threshold)
+                       : (change.new_blob_hash.empty() ? std::make_optional(ContentProbe{}) : _probe_blob(change.new_blob_hash));
+        if (old_probe && new_probe && (old_probe->binary || new_probe->binary)) {
+            stat_line.binary_sizes = std::make_pair(old_probe->size, new_probe->size);
+            name_width = std::max(name_width, stat_line.display_name.length());
+            stat_lines.push_back(std::move(stat_line));
+            continue;
+        }
+
+        std::vector<std::string> old_lines, new_lines;
+        if (!change.old_blob_hash.empty()) {
+            if (auto lines_opt = _get_blob_lines(change.old_blob_hash)) old_lines = std::move(*lines_opt);
+        }
+        if (change.new_from_workdir) {
+            if (auto lines_opt = _get_workdir_lines(change.new_path, settings.lfs_threshold)) new_lines = std::move(*lines_opt);
+        } else if (!change.new_blob_hash.empty() && change.new_blob_hash != change.old_blob_hash) {
+            if (auto lines_opt = _get_blob_lines(change.new_blob_hash)) new_lines = std::move(*lines_opt);
+        } else if (change.new_blob_hash == change.old_blob_hash) {
+            new_lines = old_lines; // 纯重命名
+        }
+
+        const DiffDriver* driver = _diff_driver_for(change.new_path, settings); // 序列/变异文件按记录统计
+        auto hunks_opt = driver ? driver->diff(old_lines, new_lines) : std::nullopt;
+        auto [insertions, deletions] = hunks_opt ? DiffDrivers::count_changes(*hunks_opt)
+                                                 : Utils::count_line_changes(old_lines, new_lines);
+        stat_line.insertions = insertions;
+        stat_line.deletions = deletions;
+        total_insertions += insertions;
+        total_deletions += deletions;
+        name_width = std::max(name_width, stat_line.display_name.length());
+        max_changes = std::max(max_changes, insertions + deletions);
+        stat_lines.push_back(std::move(stat_line));
+    }
+
+    const int MAX_GRAPH_WIDTH = 50; // +/- 图形的最大宽度
+    const int count_width = static_cast<int>(std::to_string(max_changes).length());
+    for (const auto& stat_line : stat_lines) {
+        if (stat_line.binary_sizes) {
+            std::cout << " " << stat_line.display_name << std::string(name_width - stat_line.display_name.length(), ' ')
+                      << " | Bin " << stat_line.binary_sizes->first << " -> " << stat_line.binary_sizes->second << " bytes" << std::endl;
+            continue;
+        }
+        int total = stat_line.insertions + stat_line.deletions;
+        int plus = stat_line.insertions, minus = stat_line.deletions;
+        if (max_changes > MAX_GRAPH_WIDTH) { // 按比例缩放，但有改动时至少显示一个字符
+            plus = stat_line.insertions == 0 ? 0 : std::max(1, stat_line.insertions * MAX_GRAPH_WIDTH / max_changes);
+            minus = stat_line.deletions == 0 ? 0 : std::max(1, stat_line.deletions * MAX_GRAPH_WIDTH / max_changes);
+        }
+        std::cout << " " << stat_line.display_name << std::string(name_width - stat_line.display_name.length(), ' ')
+                  << " | " << std::setw(count_width) << total << " "
+                  << "\033[32m" << std::string(plus, '+') << "\033[31m" << std::string(minus, '-') << "\033[0m" << std::endl;
+    }
+    std::cout << " " << stat_lines.size() << (stat_lines.size() == 1 ? " file changed" : " files changed");
+    if (total_insertions > 0 || total_deletions == 0) {
+        std::cout << ", " << total_insertions << (total_insertions == 1 ? " insertion(+)" : " insertions(+)");
+    }
+    if (total_deletions > 0 || total_insertions == 0) {
+        std::cout << ", " << total_deletions << (total_deletions == 1 ? " deletion(-)" : " deletions(-)");
+    }
+    std::cout << std::endl;
 }
 
 
@@ -5173,7 +7897,7 @@ bool Repository::get_commits_between(const std::string& tip_commit_hash,
 void Repository::collect_objects_recursive_for_push(const std::string& object_hash,
                                            std::set<std::string>& objects_to_collect,
                                            std::set<std::string>& visited_objects) const {
-    if (object_hash.empty() || object_hash.length() != 40 || visited_objects.count(object_hash)) {
+    if (object_hash.empty() || !ObjectFormat::is_id_length(object_hash.length()) || visited_objects.count(object_hash)) {
         return; // 哈希无效或已访问
     }
     visited_objects.insert(object_hash);
@@ -5215,7 +7939,7 @@ void Repository::collect_objects_recursive_for_push(const std::string& object_ha
         }
     } else if (type_str_read == Tree::type_str()) { //
         // 反序列化 tree 以获取其条目
-        auto tree_obj_opt = Tree::deserialize(raw_content_data); //
+        auto tree_obj_opt = Tree::deserialize(raw_content_data, ObjectFormat::hex_length(get_object_format())); //
         if (tree_obj_opt) {
             for (const auto& entry : tree_obj_opt->entries) {
                 collect_objects_recursive_for_push(entry.sha1_hash_hex, objects_to_collect, visited_objects);
@@ -5223,8 +7947,18 @@ void Repository::collect_objects_recursive_for_push(const std::string& object_ha
         } else {
             std::cerr << "Warning (collect_objects_recursive): Failed to deserialize tree object " << object_hash.substr(0,7) << std::endl;
         }
-    } else if (type_str_read == Blob::type_str()) {
-        // Blob 对象没有其他对象依赖，所以不需要进一步递归。它已经被加入 objects_to_collect 了。
+    } else if (type_str_read == Blob::manifest_type_str()) {
+        // 分块存储的 Blob：清单引用的每个 chunk 也是独立对象，服务器已有的 chunk 不会重复传输
+        auto chunk_hashes_opt = Blob::parse_manifest_chunks(raw_content_data);
+        if (chunk_hashes_opt) {
+            for (const auto& chunk_hash : *chunk_hashes_opt) {
+                collect_objects_recursive_for_push(chunk_hash, objects_to_collect, visited_objects);
+            }
+        } else {
+            std::cerr << "Warning (collect_objects_recursive): Failed to parse chunk manifest " << object_hash.substr(0,7) << std::endl;
+        }
+    } else if (type_str_read == Blob::type_str() || type_str_read == Blob::chunk_type_str()) {
+        // Blob / chunk 对象没有其他对象依赖，所以不需要进一步递归。它已经被加入 objects_to_collect 了。
     } else {
         std::cerr << "Warning (collect_objects_recursive): Unknown object type '" << type_str_read << "' for hash " << object_hash.substr(0,7) << std::endl;
     }
@@ -5264,6 +7998,396 @@ bool Repository::branch_exists(const std::string& branch_name) const {
 }
 
 
+/**
+ * @brief 读取分块存储阈值
+ * 配置项 core.chunkThreshold (字节)，0 表示禁用分块；未配置或无效时使用 DEFAULT_CHUNK_THRESHOLD。
+ */
+uintmax_t Repository::_chunk_threshold() const {
+    if (auto threshold_opt = config_get("core.chunkThreshold")) {
+        try {
+            return std::stoull(*threshold_opt);
+        } catch (const std::exception&) {
+            std::cerr << "警告: 配置项 core.chunkThreshold 的值 '" << *threshold_opt << "' 无效，使用默认值。" << std::endl;
+        }
+    }
+    return DEFAULT_CHUNK_THRESHOLD;
+}
+
+
+/**
+ * @brief 读取大文件指针存储阈值
+ * 配置项 lfs.threshold (字节)；未配置、为 0 或无效时不启用大文件指针存储。
+ */
+uintmax_t Repository::_lfs_threshold() const {
+    if (auto threshold_opt = config_get("lfs.threshold")) {
+        try {
+            return std::stoull(*threshold_opt);
+        } catch (const std::exception&) {
+            std::cerr << "警告: 配置项 lfs.threshold 的值 '" << *threshold_opt << "' 无效，已忽略。" << std::endl;
+        }
+    }
+    return 0;
+}
+
+
+std::optional<std::string> Repository::_lfs_pointer_blob_hash(const std::filesystem::path& absolute_path, uintmax_t lfs_threshold) const {
+    if (lfs_threshold == 0) {
+        return std::nullopt;
+    }
+    std::error_code ec;
+    uintmax_t file_size = std::filesystem::file_size(absolute_path, ec);
+    if (ec || file_size < lfs_threshold) {
+        return std::nullopt;
+    }
+    auto pointer_opt = LfsStore::pointer_for_file(absolute_path);
+    if (!pointer_opt) {
+        return std::nullopt;
+    }
+    return ObjectFormat::hash(get_objects_directory(), Blob(pointer_opt->serialize()).serialize());
+}
+
+
+/**
+ * @brief 收集提交 Tree 中的大文件指针
+ * 只检查不超过 LfsPointer::MAX_POINTER_SIZE 字节的 Blob，普通大文件不会被整个读入。
+ */
+std::map<std::string, LfsPointer> Repository::_collect_lfs_pointers(const std::vector<std::string>& commit_hashes) const {
+    std::map<std::string, LfsPointer> pointers;
+    std::set<std::string> visited_blobs;
+    for (const auto& commit_hash : commit_hashes) {
+        auto commit_opt = Commit::load_by_hash(commit_hash, get_objects_directory());
+        if (!commit_opt) continue;
+        std::map<std::filesystem::path, std::pair<std::string, std::string>> files;
+        _load_tree_contents_recursive(commit_opt->tree_hash_hex, "", files);
+        for (const auto& [path, blob_info] : files) {
+            if (!visited_blobs.insert(blob_info.first).second) continue;
+            auto object_path_opt = _find_object_file_by_prefix(blob_info.first);
+            std::error_code ec;
+            if (!object_path_opt || std::filesystem::file_size(*object_path_opt, ec) > LfsPointer::MAX_POINTER_SIZE + 32) continue;
+            auto blob_opt = Blob::load_by_hash(blob_info.first, get_objects_directory());
+            if (!blob_opt) continue;
+            if (auto pointer_opt = LfsPointer::parse(blob_opt->get_content_as_string())) {
+                pointers.emplace(pointer_opt->oid, *pointer_opt);
+            }
+        }
+    }
+    return pointers;
+}
+
+
+bool Repository::_push_lfs_contents(RemoteClient& client, const std::string& token, const std::vector<std::string>& commit_hashes) const {
+    std::map<std::string, LfsPointer> pointers = _collect_lfs_pointers(commit_hashes);
+    if (pointers.empty()) {
+        return true;
+    }
+
+    // 1. 询问服务器缺少哪些内容
+    std::vector<std::string> oids;
+    for (const auto& [oid, pointer] : pointers) oids.push_back(oid);
+    std::vector<ObjectExistenceStatus> statuses;
+    if (!client.CheckLfsObjects(token, oids, statuses)) {
+        std::cerr << "Push Error: Failed to check large file contents on server." << std::endl;
+        return false;
+    }
+
+    // 2. 逐个按块上传缺少的内容 (每块一条消息，内存中最多只有一块)
+    const LfsStore lfs_store(common_dir_);
+    for (const auto& status : statuses) {
+        if (status.exists_on_server) continue;
+        const LfsPointer& pointer = pointers.at(status.requested_hash);
+        if (!lfs_store.contains(pointer.oid)) {
+            std::cerr << "Push Error: Large file content " << pointer.oid.substr(0, 7) << " is missing from the local store." << std::endl;
+            return false;
+        }
+        uint64_t offset = 0;
+        do {
+            auto block_opt = lfs_store.read_block(pointer.oid, offset, LfsStore::BLOCK_SIZE);
+            if (!block_opt || (block_opt->empty() && offset < pointer.size)) {
+                std::cerr << "Push Error: Failed to read large file content " << pointer.oid.substr(0, 7) << "." << std::endl;
+                return false;
+            }
+            if (!client.PutLfsBlock(token, pointer.oid, offset, pointer.size, block_opt->data(), static_cast<uint32_t>(block_opt->size()))) {
+                std::cerr << "Push Error: Failed to upload large file content " << pointer.oid.substr(0, 7) << "." << std::endl;
+                return false;
+            }
+            offset += block_opt->size();
+        } while (offset < pointer.size);
+        std::cout << "  Uploaded large file content " << pointer.oid.substr(0, 7) << " (" << pointer.size << " bytes)" << std::endl;
+    }
+    return true;
+}
+
+
+bool Repository::_fetch_lfs_contents(RemoteClient& client, const std::string& token, const std::vector<std::string>& commit_hashes) const {
+    const LfsStore lfs_store(common_dir_);
+    bool all_ok = true;
+    for (const auto& [oid, pointer] : _collect_lfs_pointers(commit_hashes)) {
+        if (lfs_store.contains(oid)) continue;
+        uint64_t offset = 0;
+        bool complete = false;
+        while (!complete) {
+            uint64_t total_size = 0;
+            std::vector<char> block;
+            if (!client.GetLfsBlock(token, oid, offset, total_size, block) || total_size != pointer.size ||
+                (block.empty() && offset < total_size) ||
+                !lfs_store.receive_block(oid, offset, total_size, block.data(), block.size())) {
+                std::cerr << "Fetch Warning: Failed to download large file content " << oid.substr(0, 7) << "." << std::endl;
+                all_ok = false;
+                break;
+            }
+            offset += block.size();
+            complete = offset >= total_size;
+        }
+        if (complete) {
+            std::cout << "  Downloaded large file content " << oid.substr(0, 7) << " (" << pointer.size << " bytes)" << std::endl;
+        }
+    }
+    return all_ok;
+}
+
+
+/**
+ * @brief 私有辅助方法：为 push 要上传的文件内容寻找服务器上已有的增量基准
+ * @param remote_tip_hash : 服务器上目标分支的顶端提交 (为空表示分支不存在)
+ * @param commits_to_send : 待发送的提交
+ * @return <目标对象哈希, 基准对象哈希>
+ */
+std::map<std::string, std::string> Repository::_collect_delta_bases(const std::string &remote_tip_hash,
+    const std::vector<std::string> &commits_to_send) const {
+
+    std::map<std::string, std::string> delta_bases;
+    if (remote_tip_hash.empty()) return delta_bases;
+    auto remote_commit_opt = Commit::load_by_hash(remote_tip_hash, get_objects_directory());
+    if (!remote_commit_opt) return delta_bases; // 强制推送时本地可能没有远程顶端
+    const std::string& remote_tree_hash = remote_commit_opt->tree_hash_hex;
+
+    // 1. 每个待发送提交相对远程顶端改动的文件：<新版本 Blob, 远程版本 Blob>
+    std::set<std::pair<std::string, std::string>> blob_pairs;
+    for (const auto& commit_hash : commits_to_send) {
+        auto commit_opt = Commit::load_by_hash(commit_hash, get_objects_directory());
+        if (!commit_opt) continue;
+        std::set<std::string> changed_paths;
+        // 部分结果也可用：只是少选几个增量基准
+        _collect_changed_paths(remote_tree_hash, commit_opt->tree_hash_hex, "", changed_paths);
+        for (const auto& path : changed_paths) {
+            auto new_blob_opt = _find_blob_hash_in_tree(commit_opt->tree_hash_hex, path);
+            if (!new_blob_opt) continue;
+            auto old_blob_opt = _find_blob_hash_in_tree(remote_tree_hash, path);
+            if (!old_blob_opt || *old_blob_opt == *new_blob_opt) continue;
+            blob_pairs.emplace(*new_blob_opt, *old_blob_opt);
+        }
+    }
+
+    // 2. 按两个版本的存储方式确定基准 (分块存储时以 chunk 为单位)
+    auto load_object = [this](const std::string& hash) -> std::optional<std::tuple<std::string, size_t, std::vector<std::byte>>> {
+        auto object_path_opt = _find_object_file_by_prefix(hash);
+        if (!object_path_opt) return std::nullopt;
+        return read_and_parse_object_file_content(*object_path_opt);
+    };
+    for (const auto& [new_blob, old_blob] : blob_pairs) {
+        auto new_object_opt = load_object(new_blob);
+        auto old_object_opt = load_object(old_blob);
+        if (!new_object_opt || !old_object_opt) continue;
+        const bool new_chunked = std::get<0>(*new_object_opt) == Blob::manifest_type_str();
+        const bool old_chunked = std::get<0>(*old_object_opt) == Blob::manifest_type_str();
+
+        if (!new_chunked) {
+            // 旧版本分块存储时没有单个合适的基准，按原样上传
+            if (!old_chunked) delta_bases.emplace(new_blob, old_blob);
+            continue;
+        }
+        auto new_chunks = Blob::parse_manifest_entries(std::get<2>(*new_object_opt));
+        if (!new_chunks) continue;
+        if (!old_chunked) {
+            for (const auto& chunk : *new_chunks) delta_bases.emplace(chunk.first, old_blob);
+            continue;
+        }
+        auto old_chunks = Blob::parse_manifest_entries(std::get<2>(*old_object_opt));
+        if (!old_chunks || old_chunks->empty()) continue;
+
+        // 新 chunk 以旧版本中覆盖其起始偏移的 chunk 为基准 (超出旧版本末尾时取最后一个)
+        size_t new_offset = 0, old_index = 0, old_start = 0;
+        for (const auto& [chunk_hash, chunk_size] : *new_chunks) {
+            while (old_index + 1 < old_chunks->size() && old_start + (*old_chunks)[old_index].second <= new_offset) {
+                old_start += (*old_chunks)[old_index].second;
+                ++old_index;
+            }
+            if (chunk_hash != (*old_chunks)[old_index].first) {
+                delta_bases.emplace(chunk_hash, (*old_chunks)[old_index].first);
+            }
+            new_offset += chunk_size;
+        }
+    }
+    return delta_bases;
+}
+
+
+void Repository::_negotiate_wire_dictionary(RemoteClient& client, const std::string& token, bool adopt_remote_dictionary) const {
+    const std::filesystem::path objects_dir = get_objects_directory();
+    std::vector<uint32_t> local_ids = ZlibDictionaries::list(objects_dir);
+    uint32_t selected_id = 0;
+    uint32_t server_current_id = 0;
+    if (!client.NegotiateDictionary(token, local_ids, selected_id, server_current_id)) {
+        return; // 服务器不支持字典协商：按原样传输
+    }
+
+    // fetch 时取回本地没有的服务器当前字典，之后双方都用它
+    if (adopt_remote_dictionary && server_current_id != 0 && selected_id != server_current_id) {
+        std::vector<std::byte> dictionary_data;
+        if (client.GetDictionary(token, server_current_id, dictionary_data) &&
+            ZlibDictionaries::install(objects_dir, dictionary_data, local_ids.empty())) {
+            selected_id = server_current_id;
+            std::cout << "  Received dictionary " << ZlibDictionaries::format_id(server_current_id) << " from server." << std::endl;
+        }
+    }
+
+    if (selected_id != 0) {
+        auto dictionary = ZlibDictionaries::load(objects_dir, selected_id);
+        if (dictionary) {
+            client.SetWireDictionary(dictionary);
+            std::cout << "  Small trees and commits are deflated with dictionary " << ZlibDictionaries::format_id(selected_id) << "." << std::endl;
+        }
+    }
+}
+
+
+bool Repository::gc() {
+    const std::filesystem::path objects_dir = get_objects_directory();
+    std::error_code ec;
+
+    // 读取对象文件的存储字节
+    auto read_stored = [](const std::filesystem::path& path) -> std::optional<std::vector<std::byte>> {
+        std::ifstream ifs(path, std::ios::binary);
+        if (!ifs.is_open()) return std::nullopt;
+        std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        std::vector<std::byte> bytes(content.size());
+        std::memcpy(bytes.data(), content.data(), content.size());
+        return bytes;
+    };
+    // 只读取头部判断是否为适用字典的小对象 (编码存储的对象头部位于 MAGIC + 编号之后)
+    auto is_small_tree_or_commit = [](const std::filesystem::path& path) {
+        std::ifstream ifs(path, std::ios::binary);
+        char buffer[80] = {};
+        ifs.read(buffer, sizeof(buffer));
+        size_t length = static_cast<size_t>(ifs.gcount());
+        size_t offset = (length > sizeof(ObjectCodecs::MAGIC) && std::memcmp(buffer, ObjectCodecs::MAGIC, sizeof(ObjectCodecs::MAGIC)) == 0)
+                        ? sizeof(ObjectCodecs::MAGIC) + 1 : 0;
+        std::string_view header(buffer + std::min(offset, length), length - std::min(offset, length));
+        size_t space = header.find(' ');
+        size_t header_end = header.find('\0');
+        if (space == std::string_view::npos || header_end == std::string_view::npos || space > header_end) return false;
+        size_t content_size = 0;
+        auto size_text = header.substr(space + 1, header_end - space - 1);
+        if (std::from_chars(size_text.data(), size_text.data() + size_text.size(), content_size).ec != std::errc()) return false;
+        return ZlibDictionaries::applies_to(header.substr(0, space), content_size);
+    };
+
+    // 1. 收集小型 Tree/Commit 对象
+    std::vector<std::filesystem::path> small_objects;
+    for (const auto& dir_entry : std::filesystem::directory_iterator(objects_dir, ec)) {
+        if (!dir_entry.is_directory(ec) || dir_entry.path().filename().string().length() != 2) continue;
+        for (const auto& file_entry : std::filesystem::directory_iterator(dir_entry.path(), ec)) {
+            if (file_entry.is_regular_file(ec) && file_entry.path().extension() != ".tmp" &&
+                is_small_tree_or_commit(file_entry.path())) {
+                small_objects.push_back(file_entry.path());
+            }
+        }
+    }
+    std::sort(small_objects.begin(), small_objects.end());
+    std::cout << "小型 Tree/Commit 对象: " << small_objects.size() << " 个" << std::endl;
+
+    // 2. 均匀抽样训练字典，只有压缩效果优于当前字典 (和不用字典) 时才启用
+    auto current_dictionary = ZlibDictionaries::current(objects_dir);
+    if (small_objects.size() < ZlibDictionaries::MIN_TRAINING_SAMPLES) {
+        std::cout << "提示: 小对象少于 " << ZlibDictionaries::MIN_TRAINING_SAMPLES << " 个，跳过字典训练。" << std::endl;
+    } else {
+        std::vector<std::vector<std::byte>> samples;
+        const size_t stride = std::max<size_t>(1, small_objects.size() / ZlibDictionaries::MAX_TRAINING_SAMPLES);
+        for (size_t i = 0; i < small_objects.size() && samples.size() < ZlibDictionaries::MAX_TRAINING_SAMPLES; i += stride) {
+            auto object_bytes = ObjectCodecs::read_object_file(small_objects[i]);
+            if (!object_bytes) continue;
+            auto header_end = std::find(object_bytes->begin(), object_bytes->end(), std::byte{0});
+            if (header_end == object_bytes->end()) continue;
+            samples.emplace_back(header_end + 1, object_bytes->end());
+        }
+
+        ZlibDictionary trained;
+        trained.data = ZlibDictionaries::train(samples);
+        trained.id = ZlibDictionaries::compute_id(trained.data);
+        auto total_deflated = [&samples](const ZlibDictionary* dictionary) {
+            size_t total = 0;
+            for (const auto& sample : samples) {
+                auto deflated = ZlibDictionaries::deflate(dictionary, sample.data(), sample.size());
+                total += deflated ? deflated->size() : sample.size();
+            }
+            return total;
+        };
+        size_t without_dictionary = total_deflated(nullptr);
+        size_t with_trained = trained.data.empty() ? without_dictionary : total_deflated(&trained);
+        size_t with_current = current_dictionary ? total_deflated(current_dictionary.get()) : without_dictionary;
+        std::cout << "字典训练: " << samples.size() << " 个样本，字典 " << trained.data.size() << " 字节；样本压缩后 "
+                  << without_dictionary << " 字节 (无字典) / " << with_trained << " 字节 (新字典)";
+        if (current_dictionary) std::cout << " / " << with_current << " 字节 (当前字典 " << ZlibDictionaries::format_id(current_dictionary->id) << ")";
+        std::cout << std::endl;
+
+        if (with_trained < with_current && with_trained < without_dictionary) {
+            auto installed_id = ZlibDictionaries::install(objects_dir, trained.data, true);
+            if (!installed_id) {
+                std::cerr << "错误: 无法保存训练出的字典。" << std::endl;
+                return false;
+            }
+            current_dictionary = ZlibDictionaries::load(objects_dir, *installed_id);
+            std::cout << "已启用新字典 " << ZlibDictionaries::format_id(*installed_id) << "。" << std::endl;
+        } else {
+            std::cout << "提示: 新字典没有更好的压缩效果，保留" << (current_dictionary ? "当前字典。" : "不使用字典。") << std::endl;
+        }
+    }
+    if (!current_dictionary) {
+        return true;
+    }
+
+    // 3. 用当前字典重新编码尚未使用它的小对象 (由 ObjectWriter 原子替换对象文件)
+    // 字典编码的存储格式: MAGIC + 编号 + "type size\0" + 4 字节字典编号 + deflate 数据
+    auto stored_dictionary_id = [](const std::vector<std::byte>& stored) -> uint32_t {
+        const size_t header_begin = sizeof(ObjectCodecs::MAGIC) + 1;
+        if (stored.size() <= header_begin || std::memcmp(stored.data(), ObjectCodecs::MAGIC, sizeof(ObjectCodecs::MAGIC)) != 0 ||
+            static_cast<uint8_t>(stored[sizeof(ObjectCodecs::MAGIC)]) != ZlibDictionaries::CODEC_ID) {
+            return 0;
+        }
+        auto header_end = std::find(stored.begin() + header_begin, stored.end(), std::byte{0});
+        if (stored.end() - header_end < 5) return 0;
+        uint32_t id = 0;
+        for (int i = 1; i <= 4; ++i) id = (id << 8) | static_cast<uint8_t>(*(header_end + i));
+        return id;
+    };
+    size_t rewritten_count = 0;
+    uintmax_t bytes_before = 0;
+    uintmax_t bytes_after = 0;
+    for (const auto& path : small_objects) {
+        auto stored = read_stored(path);
+        if (!stored || stored_dictionary_id(*stored) == current_dictionary->id) continue;
+        auto object_bytes = ObjectCodecs::decode_from_storage(*stored, objects_dir);
+        if (!object_bytes) {
+            std::cerr << "警告: 无法读取对象 " << path.string() << "，跳过。" << std::endl;
+            continue;
+        }
+        std::vector<std::byte> encoded = ObjectCodecs::encode_for_storage(*object_bytes, {}, objects_dir);
+        if (encoded == *stored) continue;
+
+        const std::string hash_hex = path.parent_path().filename().string() + path.filename().string();
+        if (!ObjectWriter::rewrite(objects_dir, hash_hex, encoded)) return false;
+        ++rewritten_count;
+        bytes_before += stored->size();
+        bytes_after += encoded.size();
+    }
+    if (!ObjectWriter::sync(objects_dir)) return false;
+    std::cout << "已用字典 " << ZlibDictionaries::format_id(current_dictionary->id) << " 重新编码 " << rewritten_count << " 个对象";
+    if (rewritten_count > 0) std::cout << " (" << bytes_before << " -> " << bytes_after << " 字节)";
+    std::cout << "。" << std::endl;
+    return true;
+}
+
+
 void Repository::collect_objects_for_commits(const std::vector<std::string>& commit_hashes,
                                              std::set<std::string>& objects_to_collect) const {
     objects_to_collect.clear();
@@ -5284,14 +8408,20 @@ const std::filesystem::path& Repository::get_work_tree_root() const {
 const std::filesystem::path& Repository::get_mygit_directory() const {
     return mygit_dir_;
 }
+const std::filesystem::path& Repository::get_common_directory() const {
+    return common_dir_;
+}
 std::filesystem::path Repository::get_objects_directory() const {
-    return mygit_dir_ / OBJECTS_DIR_NAME;
+    return common_dir_ / OBJECTS_DIR_NAME;
+}
+ObjectFormat::Algorithm Repository::get_object_format() const {
+    return ObjectFormat::algorithm_of(get_objects_directory());
 }
 std::filesystem::path Repository::get_refs_directory() const {
-    return mygit_dir_ / REFS_DIR_NAME;
+    return common_dir_ / REFS_DIR_NAME;
 }
 std::filesystem::path Repository::get_heads_directory() const {
-    return mygit_dir_ / REFS_DIR_NAME / HEADS_DIR_NAME;
+    return common_dir_ / REFS_DIR_NAME / HEADS_DIR_NAME;
 }
 
 std::filesystem::path Repository::get_head_file_path() const {
@@ -5302,11 +8432,11 @@ std::filesystem::path Repository::get_index_file_path() const {
 }
 
 std::filesystem::path Repository::get_config_file_path() const {
-    return mygit_dir_ / CONFIG_FILE_NAME;
+    return common_dir_ / CONFIG_FILE_NAME;
 }
 
 std::filesystem::path Repository::get_tags_directory() const {
-    return mygit_dir_ / REFS_DIR_NAME  / TAGS_DIR_NAME;
+    return common_dir_ / REFS_DIR_NAME  / TAGS_DIR_NAME;
 }
 
 }
@@ -0,0 +1,196 @@
+#include "../include/TarArchive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace Biogit {
+namespace Tar {
+
+namespace {
+
+constexpr uint64_t MAX_OCTAL_SIZE = 077777777777ULL; // size 字段 11 位八进制所能表示的最大值
+
+/// 把 value 写成 width-1 位八进制数 (前补零) 加结尾 '\0'
+void write_octal(char* field, size_t width, uint64_t value) {
+    for (size_t i = width - 1; i-- > 0;) {
+        field[i] = static_cast<char>('0' + (value & 7));
+        value >>= 3;
+    }
+    field[width - 1] = '\0';
+}
+
+/// 把路径拆成 ustar 的 prefix (最多 155 字节) 和 name (最多 100 字节)；放不下时返回 false
+bool split_path(const std::string& path, std::string& prefix, std::string& name) {
+    if (path.size() <= 100) {
+        prefix.clear();
+        name = path;
+        return true;
+    }
+    // 目录以 '/' 结尾，拆分点不能是末尾的 '/' (name 不能为空)
+    for (size_t slash = path.find('/'); slash != std::string::npos && slash <= 155; slash = path.find('/', slash + 1)) {
+        size_t name_length = path.size() - slash - 1;
+        if (name_length > 0 && name_length <= 100) {
+            prefix = path.substr(0, slash);
+            name = path.substr(slash + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+/// 一条 pax 记录："<长度> <键>=<值>\n"，长度包括长度字段本身
+std::string pax_record(const std::string& key, const std::string& value) {
+    const size_t body_length = key.size() + value.size() + 3; // ' ' '=' '\n'
+    size_t length = body_length + 1;
+    while (std::to_string(length).size() + body_length != length) length = std::to_string(length).size() + body_length;
+    return std::to_string(length) + " " + key + "=" + value + "\n";
+}
+
+std::string ustar_header(const std::string& name, const std::string& prefix, char type, unsigned mode,
+                         uint64_t size, int64_t mtime, const std::string& link_target) {
+    char block[BLOCK_SIZE];
+    std::memset(block, 0, sizeof(block));
+    std::memcpy(block, name.data(), std::min<size_t>(name.size(), 100));
+    write_octal(block + 100, 8, mode);
+    write_octal(block + 108, 8, 0); // uid
+    write_octal(block + 116, 8, 0); // gid
+    write_octal(block + 124, 12, size);
+    write_octal(block + 136, 12, static_cast<uint64_t>(mtime < 0 ? 0 : mtime));
+    block[156] = type;
+    std::memcpy(block + 157, link_target.data(), std::min<size_t>(link_target.size(), 100));
+    std::memcpy(block + 257, "ustar", 6);
+    std::memcpy(block + 263, "00", 2);
+    write_octal(block + 329, 8, 0); // devmajor
+    write_octal(block + 337, 8, 0); // devminor
+    std::memcpy(block + 345, prefix.data(), std::min<size_t>(prefix.size(), 155));
+
+    // 校验和：校验和字段本身按 8 个空格计算
+    std::memset(block + 148, ' ', 8);
+    unsigned checksum = 0;
+    for (unsigned char byte : block) checksum += byte;
+    write_octal(block + 148, 7, checksum);
+    block[155] = ' ';
+    return std::string(block, sizeof(block));
+}
+
+/// pax 头 (类型 'x' 或 'g') 加其记录内容
+std::string pax_header(char type, const std::string& records, int64_t mtime) {
+    return ustar_header(type == 'g' ? "pax_global_header" : "././@PaxHeader", "", type, 0644, records.size(), mtime, "") +
+           records + padding(records.size());
+}
+
+}
+
+
+std::string entry_header(const EntryInfo& entry) {
+    std::string records;
+    std::string prefix, name;
+    if (!split_path(entry.path, prefix, name)) {
+        records += pax_record("path", entry.path);
+        name = entry.path.substr(0, 100); // 不认识 pax 的工具看到截断的路径
+        prefix.clear();
+    }
+    if (entry.link_target.size() > 100) records += pax_record("linkpath", entry.link_target);
+    if (entry.size > MAX_OCTAL_SIZE) records += pax_record("size", std::to_string(entry.size));
+
+    std::string header;
+    if (!records.empty()) header = pax_header('x', records, entry.mtime);
+    header += ustar_header(name, prefix, entry.type, entry.mode, entry.size > MAX_OCTAL_SIZE ? 0 : entry.size,
+                           entry.mtime, entry.link_target);
+    return header;
+}
+
+std::string global_header(const std::string& commit_hash, int64_t mtime) {
+    return pax_header('g', pax_record("comment", commit_hash), mtime);
+}
+
+std::string padding(uint64_t size) {
+    return std::string(static_cast<size_t>((BLOCK_SIZE - size % BLOCK_SIZE) % BLOCK_SIZE), '\0');
+}
+
+std::string end_of_archive() {
+    return std::string(2 * BLOCK_SIZE, '\0');
+}
+
+}
+
+
+// --- GzipStreamBuf ---
+
+GzipStreamBuf::GzipStreamBuf(std::ostream& sink, int level)
+    : sink_(sink), in_buffer_(64 * 1024), out_buffer_(64 * 1024) {
+    // windowBits + 16：输出 gzip 头部和尾部 (头部时间字段为 0)
+    if (deflateInit2(&stream_, level, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        std::cerr << "错误: 初始化 gzip 压缩失败。" << std::endl;
+        failed_ = true;
+        return;
+    }
+    initialized_ = true;
+    setp(in_buffer_.data(), in_buffer_.data() + in_buffer_.size());
+}
+
+GzipStreamBuf::~GzipStreamBuf() {
+    if (initialized_) deflateEnd(&stream_);
+}
+
+bool GzipStreamBuf::deflate_buffer(const char* data, size_t size, int flush) {
+    if (failed_ || !initialized_) return false;
+    stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream_.avail_in = static_cast<uInt>(size);
+    do {
+        stream_.next_out = reinterpret_cast<Bytef*>(out_buffer_.data());
+        stream_.avail_out = static_cast<uInt>(out_buffer_.size());
+        int ret = deflate(&stream_, flush);
+        if (ret == Z_STREAM_ERROR) {
+            failed_ = true;
+            return false;
+        }
+        size_t produced = out_buffer_.size() - stream_.avail_out;
+        if (produced > 0 && !sink_.write(out_buffer_.data(), static_cast<std::streamsize>(produced))) {
+            failed_ = true;
+            return false;
+        }
+    } while (stream_.avail_out == 0); // 输出缓冲区未填满说明输入已全部处理 (Z_FINISH 时即已写完尾部)
+    return true;
+}
+
+GzipStreamBuf::int_type GzipStreamBuf::overflow(int_type ch) {
+    if (finished_ || !deflate_buffer(pbase(), static_cast<size_t>(pptr() - pbase()), Z_NO_FLUSH)) return traits_type::eof();
+    setp(in_buffer_.data(), in_buffer_.data() + in_buffer_.size());
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize GzipStreamBuf::xsputn(const char* data, std::streamsize size) {
+    if (size < epptr() - pptr()) {
+        std::memcpy(pptr(), data, static_cast<size_t>(size));
+        pbump(static_cast<int>(size));
+        return size;
+    }
+    // 大块数据直接压缩，不经过缓冲区
+    if (traits_type::eq_int_type(overflow(traits_type::eof()), traits_type::eof())) return 0;
+    if (!deflate_buffer(data, static_cast<size_t>(size), Z_NO_FLUSH)) return 0;
+    return size;
+}
+
+int GzipStreamBuf::sync() {
+    // 只把缓冲区交给 zlib，不做 Z_SYNC_FLUSH，保证压缩结果与写入时的分段方式无关
+    if (traits_type::eq_int_type(overflow(traits_type::eof()), traits_type::eof())) return -1;
+    sink_.flush();
+    return sink_.good() ? 0 : -1;
+}
+
+bool GzipStreamBuf::finish() {
+    if (finished_) return !failed_;
+    if (traits_type::eq_int_type(overflow(traits_type::eof()), traits_type::eof())) return false;
+    finished_ = true;
+    if (!deflate_buffer(nullptr, 0, Z_FINISH)) return false;
+    sink_.flush();
+    return sink_.good();
+}
+
+}
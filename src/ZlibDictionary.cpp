@@ -0,0 +1,347 @@
+#include "../include/ZlibDictionary.h"
+#include "../include/object.h"
+#include "../include/sha1.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <zlib.h>
+
+namespace Biogit {
+
+namespace ZlibDictionaries {
+
+namespace {
+
+/// 训练时统计的片段长度、候选小段的长度和起点间隔
+constexpr size_t GRAM_LENGTH = 8;
+constexpr size_t SEGMENT_LENGTH = 64;
+constexpr size_t SEGMENT_STRIDE = 16;
+
+const char* CURRENT_FILE_NAME = "CURRENT";
+
+/**
+ * @brief 字典的进程内缓存 (服务器的多个会话共享)。
+ */
+struct DictionaryCache {
+    std::mutex mutex;
+    std::map<std::string, std::shared_ptr<const ZlibDictionary>> dictionaries; ///< "<目录>/<编号>" -> 字典
+    std::map<std::string, std::pair<std::filesystem::file_time_type, uint32_t>> current_ids; ///< 目录 -> (CURRENT 修改时间, 编号)
+};
+
+DictionaryCache& cache() {
+    static DictionaryCache instance;
+    return instance;
+}
+
+uint64_t load_gram(const std::byte* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+std::optional<uint32_t> read_current_id(const std::filesystem::path& dir) {
+    std::ifstream ifs(dir / CURRENT_FILE_NAME);
+    std::string line;
+    if (!ifs.is_open() || !std::getline(ifs, line)) return std::nullopt;
+    return parse_id(line);
+}
+
+bool write_file_atomically(const std::filesystem::path& path, const std::string& content) {
+    std::filesystem::path temp_path = path;
+    temp_path += ".tmp";
+    std::error_code ec;
+    {
+        std::ofstream ofs(temp_path, std::ios::binary | std::ios::trunc);
+        ofs.write(content.data(), static_cast<std::streamsize>(content.size()));
+        if (!ofs.good()) {
+            std::cerr << "错误: 无法写入文件 '" << temp_path.string() << "'。" << std::endl;
+            std::filesystem::remove(temp_path, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec) {
+        std::cerr << "错误: 无法重命名 '" << temp_path.string() << "': " << ec.message() << std::endl;
+        std::filesystem::remove(temp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+}
+
+bool applies_to(std::string_view type, size_t content_size) {
+    return content_size <= MAX_OBJECT_SIZE && (type == Tree::type_str() || type == Commit::type_str());
+}
+
+bool applies_to_object(const char* object_bytes, size_t size) {
+    std::string_view view(object_bytes, std::min<size_t>(size, 64));
+    size_t header_end = view.find('\0');
+    if (header_end == std::string_view::npos) return false;
+    std::string_view type = view.substr(0, std::min(view.find(' '), header_end));
+    return applies_to(type, size - header_end - 1);
+}
+
+std::string format_id(uint32_t id) {
+    static const char* digits = "0123456789abcdef";
+    std::string text(8, '0');
+    for (int i = 7; i >= 0; --i, id >>= 4) {
+        text[static_cast<size_t>(i)] = digits[id & 0xF];
+    }
+    return text;
+}
+
+std::optional<uint32_t> parse_id(const std::string& text) {
+    if (text.size() != 8 || !std::all_of(text.begin(), text.end(), ::isxdigit)) return std::nullopt;
+    uint32_t id = static_cast<uint32_t>(std::stoul(text, nullptr, 16));
+    if (id == 0) return std::nullopt; // 0 在协议中表示 “不使用字典”
+    return id;
+}
+
+uint32_t compute_id(const std::vector<std::byte>& data) {
+    uint32_t id = static_cast<uint32_t>(std::stoul(SHA1::sha1(data).substr(0, 8), nullptr, 16));
+    return id == 0 ? 1 : id;
+}
+
+std::filesystem::path directory(const std::filesystem::path& objects_dir) {
+    return objects_dir.parent_path() / "dictionaries";
+}
+
+std::shared_ptr<const ZlibDictionary> load(const std::filesystem::path& objects_dir, uint32_t id) {
+    const std::filesystem::path file_path = directory(objects_dir) / format_id(id);
+    DictionaryCache& c = cache();
+    {
+        std::lock_guard<std::mutex> lock(c.mutex);
+        auto it = c.dictionaries.find(file_path.string());
+        if (it != c.dictionaries.end()) return it->second;
+    }
+
+    std::ifstream ifs(file_path, std::ios::binary);
+    if (!ifs.is_open()) return nullptr;
+    std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    if (content.size() <= sizeof(FILE_MAGIC) + 1 || std::memcmp(content.data(), FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+        std::cerr << "错误: 字典文件 '" << file_path.string() << "' 格式无效。" << std::endl;
+        return nullptr;
+    }
+    if (static_cast<uint8_t>(content[sizeof(FILE_MAGIC)]) != FORMAT_VERSION) {
+        std::cerr << "错误: 字典文件 '" << file_path.string() << "' 的格式版本 ("
+                  << static_cast<int>(static_cast<uint8_t>(content[sizeof(FILE_MAGIC)])) << ") 不受支持。" << std::endl;
+        return nullptr;
+    }
+
+    auto dictionary = std::make_shared<ZlibDictionary>();
+    dictionary->id = id;
+    const size_t header_size = sizeof(FILE_MAGIC) + 1;
+    dictionary->data.resize(content.size() - header_size);
+    std::memcpy(dictionary->data.data(), content.data() + header_size, dictionary->data.size());
+    if (compute_id(dictionary->data) != id) {
+        std::cerr << "错误: 字典文件 '" << file_path.string() << "' 的内容与编号不符。" << std::endl;
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(c.mutex);
+    return c.dictionaries.emplace(file_path.string(), std::move(dictionary)).first->second;
+}
+
+std::shared_ptr<const ZlibDictionary> current(const std::filesystem::path& objects_dir) {
+    const std::filesystem::path dir = directory(objects_dir);
+    std::error_code ec;
+    auto modified = std::filesystem::last_write_time(dir / CURRENT_FILE_NAME, ec);
+    if (ec) return nullptr; // 尚未训练字典
+
+    std::optional<uint32_t> id;
+    DictionaryCache& c = cache();
+    {
+        std::lock_guard<std::mutex> lock(c.mutex);
+        auto it = c.current_ids.find(dir.string());
+        if (it != c.current_ids.end() && it->second.first == modified) id = it->second.second;
+    }
+    if (!id) { // 首次读取或 CURRENT 已被其他进程 (例如 gc) 更新
+        id = read_current_id(dir);
+        if (!id) return nullptr;
+        std::lock_guard<std::mutex> lock(c.mutex);
+        c.current_ids[dir.string()] = {modified, *id};
+    }
+    return load(objects_dir, *id);
+}
+
+std::vector<uint32_t> list(const std::filesystem::path& objects_dir) {
+    const std::filesystem::path dir = directory(objects_dir);
+    std::vector<uint32_t> ids;
+    std::error_code ec;
+    if (!std::filesystem::is_directory(dir, ec)) return ids;
+
+    std::optional<uint32_t> current_id = read_current_id(dir);
+    if (current_id) ids.push_back(*current_id);
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        auto id = parse_id(entry.path().filename().string());
+        if (id && id != current_id && entry.is_regular_file(ec)) ids.push_back(*id);
+    }
+    if (ids.size() > 1) std::sort(ids.begin() + (current_id ? 1 : 0), ids.end());
+    return ids;
+}
+
+std::optional<uint32_t> install(const std::filesystem::path& objects_dir, const std::vector<std::byte>& data, bool make_current) {
+    if (data.empty()) return std::nullopt;
+    const std::filesystem::path dir = directory(objects_dir);
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec) {
+        std::cerr << "错误: 无法创建字典目录 '" << dir.string() << "': " << ec.message() << std::endl;
+        return std::nullopt;
+    }
+
+    // 1. 写入字典文件 (内容相同的字典编号相同，已存在时不重复写入)
+    const uint32_t id = compute_id(data);
+    const std::filesystem::path file_path = dir / format_id(id);
+    if (!std::filesystem::exists(file_path, ec)) {
+        std::string content(FILE_MAGIC, sizeof(FILE_MAGIC));
+        content.push_back(static_cast<char>(FORMAT_VERSION));
+        content.append(reinterpret_cast<const char*>(data.data()), data.size());
+        if (!write_file_atomically(file_path, content)) return std::nullopt;
+    } else if (!load(objects_dir, id)) {
+        std::cerr << "错误: 已存在编号为 " << format_id(id) << " 的其他字典。" << std::endl;
+        return std::nullopt;
+    }
+
+    // 2. 更新 CURRENT
+    if (make_current && !write_file_atomically(dir / CURRENT_FILE_NAME, format_id(id) + "\n")) {
+        return std::nullopt;
+    }
+    return id;
+}
+
+std::vector<std::byte> train(const std::vector<std::vector<std::byte>>& samples, size_t max_size) {
+    // 1. 统计每个片段出现在多少个样本中
+    std::unordered_map<uint64_t, uint32_t> frequency;
+    std::unordered_set<uint64_t> seen;
+    for (const auto& sample : samples) {
+        if (sample.size() < GRAM_LENGTH) continue;
+        seen.clear();
+        for (size_t i = 0; i + GRAM_LENGTH <= sample.size(); ++i) {
+            uint64_t gram = load_gram(sample.data() + i);
+            if (seen.insert(gram).second) ++frequency[gram];
+        }
+    }
+
+    // 小段得分：段内每个不同片段 (只计出现在两个以上样本中的) 的出现次数之和；已选中的片段频次置 0
+    std::vector<uint64_t> grams;
+    auto score_of = [&](const std::vector<std::byte>& sample, size_t offset, size_t length) {
+        grams.clear();
+        for (size_t i = offset; i + GRAM_LENGTH <= offset + length; ++i) grams.push_back(load_gram(sample.data() + i));
+        std::sort(grams.begin(), grams.end());
+        grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+        uint64_t score = 0;
+        for (uint64_t gram : grams) {
+            uint32_t f = frequency[gram];
+            if (f > 1) score += f;
+        }
+        return score;
+    };
+
+    // 2. 候选小段入堆
+    struct Segment {
+        uint64_t score;
+        uint32_t sample;
+        uint32_t offset;
+        uint32_t length;
+        bool operator<(const Segment& other) const { return score < other.score; }
+    };
+    std::priority_queue<Segment> heap;
+    for (size_t s = 0; s < samples.size(); ++s) {
+        const auto& sample = samples[s];
+        for (size_t offset = 0; offset + GRAM_LENGTH <= sample.size(); offset += SEGMENT_STRIDE) {
+            size_t length = std::min(SEGMENT_LENGTH, sample.size() - offset);
+            uint64_t score = score_of(sample, offset, length);
+            if (score > 0) heap.push({score, static_cast<uint32_t>(s), static_cast<uint32_t>(offset), static_cast<uint32_t>(length)});
+        }
+    }
+
+    // 3. 惰性贪心：得分只会下降，堆顶重新计分后仍不低于次优者即可选中
+    std::vector<Segment> selected;
+    size_t total_size = 0;
+    while (!heap.empty() && total_size < max_size) {
+        Segment top = heap.top();
+        heap.pop();
+        const auto& sample = samples[top.sample];
+        top.score = score_of(sample, top.offset, top.length);
+        if (top.score == 0) continue;
+        if (!heap.empty() && top.score < heap.top().score) {
+            heap.push(top);
+            continue;
+        }
+        selected.push_back(top);
+        total_size += top.length;
+        for (size_t i = top.offset; i + GRAM_LENGTH <= top.offset + top.length; ++i) {
+            frequency[load_gram(sample.data() + i)] = 0;
+        }
+    }
+
+    // 4. 价值高的小段放在末尾；超出上限时截掉开头
+    std::vector<std::byte> dictionary;
+    dictionary.reserve(total_size);
+    for (auto it = selected.rbegin(); it != selected.rend(); ++it) {
+        const auto& sample = samples[it->sample];
+        dictionary.insert(dictionary.end(), sample.begin() + it->offset, sample.begin() + it->offset + it->length);
+    }
+    if (dictionary.size() > max_size) {
+        dictionary.erase(dictionary.begin(), dictionary.begin() + static_cast<std::ptrdiff_t>(dictionary.size() - max_size));
+    }
+    return dictionary;
+}
+
+std::optional<std::vector<std::byte>> deflate(const ZlibDictionary* dictionary, const std::byte* data, size_t size) {
+    z_stream zs{};
+    if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return std::nullopt;
+    }
+    if (dictionary && deflateSetDictionary(&zs, reinterpret_cast<const Bytef*>(dictionary->data.data()),
+                                           static_cast<uInt>(dictionary->data.size())) != Z_OK) {
+        deflateEnd(&zs);
+        return std::nullopt;
+    }
+    std::vector<std::byte> out(deflateBound(&zs, static_cast<uLong>(size)));
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<std::byte*>(data));
+    zs.avail_in = static_cast<uInt>(size);
+    zs.next_out = reinterpret_cast<Bytef*>(out.data());
+    zs.avail_out = static_cast<uInt>(out.size());
+    int ret = ::deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    if (ret != Z_STREAM_END) return std::nullopt;
+    return out;
+}
+
+std::optional<std::vector<std::byte>> inflate(const ZlibDictionary* dictionary, const std::byte* data, size_t size, size_t expected_size) {
+    z_stream zs{};
+    if (inflateInit2(&zs, -MAX_WBITS) != Z_OK) {
+        return std::nullopt;
+    }
+    if (dictionary && inflateSetDictionary(&zs, reinterpret_cast<const Bytef*>(dictionary->data.data()),
+                                           static_cast<uInt>(dictionary->data.size())) != Z_OK) {
+        inflateEnd(&zs);
+        return std::nullopt;
+    }
+    std::vector<std::byte> out(expected_size + 1); // 多留 1 字节以发现超长的数据
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<std::byte*>(data));
+    zs.avail_in = static_cast<uInt>(size);
+    zs.next_out = reinterpret_cast<Bytef*>(out.data());
+    zs.avail_out = static_cast<uInt>(out.size());
+    int ret = ::inflate(&zs, Z_FINISH);
+    size_t produced = zs.total_out;
+    inflateEnd(&zs);
+    if (ret != Z_STREAM_END || produced != expected_size) return std::nullopt;
+    out.resize(produced);
+    return out;
+}
+
+}
+
+}
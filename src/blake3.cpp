@@ -0,0 +1,236 @@
+#include "../include/blake3.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+namespace BLAKE3 {
+    namespace {
+
+    using ChainingValue = std::array<uint32_t, 8>;
+
+    constexpr ChainingValue IV = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                  0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    constexpr size_t MSG_PERMUTATION[16] = {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8};
+    constexpr size_t BLOCK_LEN = 64;
+
+    // 域分隔标志
+    constexpr uint32_t CHUNK_START = 1 << 0;
+    constexpr uint32_t CHUNK_END = 1 << 1;
+    constexpr uint32_t PARENT = 1 << 2;
+    constexpr uint32_t ROOT = 1 << 3;
+
+    inline uint32_t rotr(uint32_t x, int n) {
+        return (x >> n) | (x << (32 - n));
+    }
+
+    inline void g(uint32_t* s, size_t a, size_t b, size_t c, size_t d, uint32_t mx, uint32_t my) {
+        s[a] = s[a] + s[b] + mx;
+        s[d] = rotr(s[d] ^ s[a], 16);
+        s[c] = s[c] + s[d];
+        s[b] = rotr(s[b] ^ s[c], 12);
+        s[a] = s[a] + s[b] + my;
+        s[d] = rotr(s[d] ^ s[a], 8);
+        s[c] = s[c] + s[d];
+        s[b] = rotr(s[b] ^ s[c], 7);
+    }
+
+    void round_function(uint32_t* s, const uint32_t* m) {
+        // 列
+        g(s, 0, 4, 8, 12, m[0], m[1]);
+        g(s, 1, 5, 9, 13, m[2], m[3]);
+        g(s, 2, 6, 10, 14, m[4], m[5]);
+        g(s, 3, 7, 11, 15, m[6], m[7]);
+        // 对角线
+        g(s, 0, 5, 10, 15, m[8], m[9]);
+        g(s, 1, 6, 11, 12, m[10], m[11]);
+        g(s, 2, 7, 8, 13, m[12], m[13]);
+        g(s, 3, 4, 9, 14, m[14], m[15]);
+    }
+
+    /// 压缩函数：返回完整的 16 字状态 (前 8 字为链接值，根节点输出时 16 字全部使用)
+    std::array<uint32_t, 16> compress(const ChainingValue& cv, const uint32_t* block_words,
+                                      uint64_t counter, uint32_t block_len, uint32_t flags) {
+        std::array<uint32_t, 16> s = {cv[0], cv[1], cv[2], cv[3], cv[4], cv[5], cv[6], cv[7],
+                                      IV[0], IV[1], IV[2], IV[3],
+                                      static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32), block_len, flags};
+        uint32_t m[16];
+        std::memcpy(m, block_words, sizeof(m));
+        for (int r = 0; r < 7; ++r) {
+            round_function(s.data(), m);
+            if (r == 6) break;
+            uint32_t permuted[16];
+            for (size_t i = 0; i < 16; ++i) permuted[i] = m[MSG_PERMUTATION[i]];
+            std::memcpy(m, permuted, sizeof(m));
+        }
+        for (size_t i = 0; i < 8; ++i) {
+            s[i] ^= s[i + 8];
+            s[i + 8] ^= cv[i];
+        }
+        return s;
+    }
+
+    ChainingValue first_eight(const std::array<uint32_t, 16>& state) {
+        ChainingValue cv;
+        std::copy(state.begin(), state.begin() + 8, cv.begin());
+        return cv;
+    }
+
+    /// 把至多 64 字节按小端读成 16 个字 (不足部分补零)
+    void words_from_bytes(const std::byte* bytes, size_t length, uint32_t* words) {
+        std::byte block[BLOCK_LEN] = {};
+        if (length > 0) std::memcpy(block, bytes, length);
+        for (size_t i = 0; i < 16; ++i) {
+            words[i] = static_cast<uint32_t>(block[i * 4 + 0]) |
+                       (static_cast<uint32_t>(block[i * 4 + 1]) << 8) |
+                       (static_cast<uint32_t>(block[i * 4 + 2]) << 16) |
+                       (static_cast<uint32_t>(block[i * 4 + 3]) << 24);
+        }
+    }
+
+    /**
+     * @brief 树节点最后一次压缩的输入：作为子节点时取链接值，作为根节点时带 ROOT 标志输出哈希。
+     */
+    struct Output {
+        ChainingValue input_cv;
+        uint32_t block_words[16];
+        uint64_t counter;
+        uint32_t block_len;
+        uint32_t flags;
+
+        ChainingValue chaining_value() const {
+            return first_eight(compress(input_cv, block_words, counter, block_len, flags));
+        }
+
+        std::string root_hex() const {
+            std::array<uint32_t, 16> state = compress(input_cv, block_words, 0, block_len, flags | ROOT);
+            char hex_str[65];
+            for (size_t i = 0; i < 8; ++i) {
+                for (size_t j = 0; j < 4; ++j) {
+                    std::snprintf(hex_str + i * 8 + j * 2, 3, "%02x", (state[i] >> (8 * j)) & 0xff);
+                }
+            }
+            return std::string(hex_str, 64);
+        }
+    };
+
+    /// 一个完整或不完整 (最后一个) 分块的输出
+    Output chunk_output(const std::byte* data, size_t length, uint64_t chunk_counter) {
+        ChainingValue cv = IV;
+        const size_t block_count = length == 0 ? 1 : (length + BLOCK_LEN - 1) / BLOCK_LEN;
+        uint32_t words[16];
+        for (size_t i = 0; i + 1 < block_count; ++i) {
+            words_from_bytes(data + i * BLOCK_LEN, BLOCK_LEN, words);
+            cv = first_eight(compress(cv, words, chunk_counter, BLOCK_LEN, i == 0 ? CHUNK_START : 0));
+        }
+        const size_t last_offset = (block_count - 1) * BLOCK_LEN;
+        Output output{cv, {}, chunk_counter, static_cast<uint32_t>(length - last_offset),
+                      (block_count == 1 ? CHUNK_START : 0) | CHUNK_END};
+        words_from_bytes(data + last_offset, length - last_offset, output.block_words);
+        return output;
+    }
+
+    Output parent_output(const ChainingValue& left, const ChainingValue& right) {
+        Output output{IV, {}, 0, BLOCK_LEN, PARENT};
+        std::copy(left.begin(), left.end(), output.block_words);
+        std::copy(right.begin(), right.end(), output.block_words + 8);
+        return output;
+    }
+
+    /// 左子树的长度：不超过 (length - 1) / CHUNK_LEN 的最大 2 的幂个分块 (右子树至少 1 字节)
+    size_t left_subtree_length(size_t length) {
+        size_t full_chunks = (length - 1) / CHUNK_LEN;
+        size_t power = 1;
+        while (power * 2 <= full_chunks) power *= 2;
+        return power * CHUNK_LEN;
+    }
+
+    /**
+     * @brief 以 data 为内容、从第 chunk_counter 个分块开始的子树的输出。
+     * @details 输入足够大且还有线程可用时，左子树在新线程中计算，右子树在当前线程计算。
+     */
+    Output subtree_output(const std::byte* data, size_t length, uint64_t chunk_counter, size_t threads) {
+        if (length <= CHUNK_LEN) return chunk_output(data, length, chunk_counter);
+        const size_t left_length = left_subtree_length(length);
+        const uint64_t right_counter = chunk_counter + left_length / CHUNK_LEN;
+        ChainingValue left_cv, right_cv;
+        if (threads > 1 && length >= PARALLEL_MIN_LENGTH) {
+            const size_t left_threads = threads / 2;
+            std::thread left_worker([&] { left_cv = subtree_output(data, left_length, chunk_counter, left_threads).chaining_value(); });
+            right_cv = subtree_output(data + left_length, length - left_length, right_counter, threads - left_threads).chaining_value();
+            left_worker.join();
+        } else {
+            left_cv = subtree_output(data, left_length, chunk_counter, 1).chaining_value();
+            right_cv = subtree_output(data + left_length, length - left_length, right_counter, 1).chaining_value();
+        }
+        return parent_output(left_cv, right_cv);
+    }
+
+    }
+
+    std::string blake3(const void* data, size_t length, size_t max_threads) {
+        return subtree_output(static_cast<const std::byte*>(data), length, 0, std::max<size_t>(1, max_threads)).root_hex();
+    }
+
+    std::string blake3(const std::vector<std::byte>& data) {
+        size_t threads = data.size() >= PARALLEL_MIN_LENGTH ? std::max(1u, std::thread::hardware_concurrency()) : 1;
+        return blake3(data.data(), data.size(), threads);
+    }
+
+    std::string blake3(const std::string& text_data) {
+        return blake3(text_data.data(), text_data.size(), 1);
+    }
+
+    Hasher::Hasher() : chunk_cv_(IV) {}
+
+    void Hasher::push_chunk_chaining_value(std::array<uint32_t, 8> chaining_value, uint64_t total_chunks) {
+        // 分块总数末尾每有一个 0 位，就有一对相邻子树可以合并成父节点
+        while ((total_chunks & 1) == 0) {
+            chaining_value = parent_output(cv_stack_.back(), chaining_value).chaining_value();
+            cv_stack_.pop_back();
+            total_chunks >>= 1;
+        }
+        cv_stack_.push_back(chaining_value);
+    }
+
+    void Hasher::update(const void* data, size_t length) {
+        const std::byte* bytes = static_cast<const std::byte*>(data);
+        uint32_t words[16];
+        while (length > 0) {
+            // 1. 当前分块已满且还有输入：它不是最后一个分块，结束它并并入树中
+            if (blocks_compressed_ * BLOCK_LEN + block_length_ == CHUNK_LEN) {
+                Output output{chunk_cv_, {}, chunk_counter_, static_cast<uint32_t>(block_length_),
+                              (blocks_compressed_ == 0 ? CHUNK_START : 0) | CHUNK_END};
+                words_from_bytes(block_.data(), block_length_, output.block_words);
+                push_chunk_chaining_value(output.chaining_value(), chunk_counter_ + 1);
+                ++chunk_counter_;
+                chunk_cv_ = IV;
+                blocks_compressed_ = 0;
+                block_length_ = 0;
+            }
+            // 2. 块缓冲区已满且还有输入：它不是分块的最后一块，压缩它
+            if (block_length_ == BLOCK_LEN) {
+                words_from_bytes(block_.data(), BLOCK_LEN, words);
+                chunk_cv_ = first_eight(compress(chunk_cv_, words, chunk_counter_, BLOCK_LEN,
+                                                 blocks_compressed_ == 0 ? CHUNK_START : 0));
+                ++blocks_compressed_;
+                block_length_ = 0;
+            }
+            // 3. 填入块缓冲区
+            size_t take = std::min(length, BLOCK_LEN - block_length_);
+            std::memcpy(block_.data() + block_length_, bytes, take);
+            block_length_ += take;
+            bytes += take;
+            length -= take;
+        }
+    }
+
+    std::string Hasher::hex_digest() {
+        Output output{chunk_cv_, {}, chunk_counter_, static_cast<uint32_t>(block_length_),
+                      (blocks_compressed_ == 0 ? CHUNK_START : 0) | CHUNK_END};
+        words_from_bytes(block_.data(), block_length_, output.block_words);
+        for (auto it = cv_stack_.rbegin(); it != cv_stack_.rend(); ++it) {
+            output = parent_output(*it, output.chaining_value());
+        }
+        return output.root_hex();
+    }
+};
@@ -1,22 +1,88 @@
 #include "../include/object.h"
-#include "../include/sha1.h"
+#include "../include/ObjectCodec.h"
+#include "../include/ObjectAlternates.h"
+#include "../include/ObjectWriter.h"
+#include "../include/ObjectFormat.h"
+#include "../include/utils.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <list>
+#include <memory>
+#include <mutex>
 namespace Biogit {
+namespace {
+
 /**
- * @brief 内部辅助函数：用于从文件中读取对象头部和内容
- * @param file_path filesystem::path类型
- * @return 返回 {对象类型字符串, 对象大小, 对象内容字节流 (不含头部)} 如果解析失败或读取错误，返回 std::nullopt
+ * @brief 已校验对象内容的 LRU：<对象目录, 哈希> -> (类型, 内容)，按内容总字节数淘汰。
  */
-static std::optional<std::tuple<std::string, size_t, std::vector<std::byte>>>
-read_and_parse_object_file(const std::filesystem::path& file_path) {
-    std::ifstream ifs(file_path, std::ios::binary);
-    if (!ifs.is_open()) {
-        // std::cerr << "错误: 无法打开对象文件 '" << file_path.string() << "'" << std::endl;
-        return std::nullopt;
+struct VerifiedObjectCache {
+    using Content = std::shared_ptr<const std::vector<std::byte>>;
+    struct Entry { std::string key; std::string type; Content content; };
+
+    std::mutex mutex;
+    size_t capacity_bytes = 0; ///< 0 表示关闭
+    size_t used_bytes = 0;
+    std::list<Entry> lru; ///< 最近使用的在前
+    std::unordered_map<std::string, std::list<Entry>::iterator> by_key;
+
+    void evict_to(size_t limit) {
+        while (used_bytes > limit && !lru.empty()) {
+            used_bytes -= lru.back().content->size();
+            by_key.erase(lru.back().key);
+            lru.pop_back();
+        }
     }
+};
+
+VerifiedObjectCache& verified_object_cache() {
+    static VerifiedObjectCache instance;
+    return instance;
+}
 
+std::string verified_object_key(const std::filesystem::path& objects_dir_path, const std::string& hash_hex) {
+    return objects_dir_path.string() + "\n" + hash_hex;
+}
+
+/// 取出已校验且类型相符的对象内容；缓存关闭或未命中时返回 nullptr
+VerifiedObjectCache::Content find_verified_object(const std::filesystem::path& objects_dir_path,
+                                                  const std::string& hash_hex, const std::string& type) {
+    VerifiedObjectCache& cache = verified_object_cache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (cache.capacity_bytes == 0) return nullptr;
+    auto it = cache.by_key.find(verified_object_key(objects_dir_path, hash_hex));
+    if (it == cache.by_key.end() || it->second->type != type) return nullptr;
+    cache.lru.splice(cache.lru.begin(), cache.lru, it->second);
+    return it->second->content;
+}
+
+void remember_verified_object(const std::filesystem::path& objects_dir_path, const std::string& hash_hex,
+                              const std::string& type, const std::vector<std::byte>& content) {
+    VerifiedObjectCache& cache = verified_object_cache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (cache.capacity_bytes == 0 || content.size() > cache.capacity_bytes / 4) return; // 单个大对象不挤掉整个缓存
+    std::string key = verified_object_key(objects_dir_path, hash_hex);
+    if (cache.by_key.count(key)) return;
+    cache.lru.push_front({key, type, std::make_shared<const std::vector<std::byte>>(content)});
+    cache.by_key.emplace(std::move(key), cache.lru.begin());
+    cache.used_bytes += content.size();
+    cache.evict_to(cache.capacity_bytes);
+}
+
+}
+
+void ObjectCache::set_capacity(size_t bytes) {
+    VerifiedObjectCache& cache = verified_object_cache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.capacity_bytes = bytes;
+    cache.evict_to(bytes);
+}
+
+/**
+ * @brief 内部辅助函数：从规范对象字节流 "type size\0content" 中解析头部和内容
+ */
+static std::optional<std::tuple<std::string, size_t, std::vector<std::byte>>>
+parse_object_stream(std::istream& ifs) {
     std::string type_str_read;
     long long content_size_read = -1; // Git 对象大小理论上可以很大
     char ch;
@@ -67,6 +133,63 @@ read_and_parse_object_file(const std::filesystem::path& file_path) {
 }
 
 
+/**
+ * @brief 内部辅助函数：用于从文件中读取对象头部和内容
+ * @param file_path filesystem::path类型
+ * @return 返回 {对象类型字符串, 对象大小, 对象内容字节流 (不含头部)} 如果解析失败或读取错误，返回 std::nullopt
+ */
+static std::optional<std::tuple<std::string, size_t, std::vector<std::byte>>>
+read_and_parse_object_file(const std::filesystem::path& file_path) {
+    std::ifstream ifs(file_path, std::ios::binary);
+    if (!ifs.is_open()) {
+        // std::cerr << "错误: 无法打开对象文件 '" << file_path.string() << "'" << std::endl;
+        return std::nullopt;
+    }
+
+    // 经编解码器存储的对象以 '\0' 开头 (规范对象总以类型名开头)，先还原为规范字节再解析
+    if (ifs.peek() == ObjectCodecs::MAGIC[0]) {
+        ifs.close();
+        auto object_bytes = ObjectCodecs::read_object_file(file_path);
+        if (!object_bytes) {
+            return std::nullopt;
+        }
+        std::istringstream iss(std::string(reinterpret_cast<const char*>(object_bytes->data()), object_bytes->size()));
+        return parse_object_stream(iss);
+    }
+    return parse_object_stream(ifs);
+}
+
+/**
+ * @brief 内部辅助函数：构造 "<type> <size>\0<data>" 格式的对象字节流
+ */
+static std::vector<std::byte> make_object_bytes(const std::string& type, const std::byte* data, size_t size) {
+    std::string header_str = type + " " + std::to_string(size) + '\0';
+    std::vector<std::byte> object_bytes;
+    object_bytes.reserve(header_str.length() + size);
+    for (char ch : header_str) {
+        object_bytes.push_back(static_cast<std::byte>(ch));
+    }
+    object_bytes.insert(object_bytes.end(), data, data + size);
+    return object_bytes;
+}
+
+/**
+ * @brief 内部辅助函数：对象不存在 (本仓库和备用对象库都没有) 时写入
+ * @param path_hint 对象对应的文件路径 (可为空)，供存储层编解码器选择
+ * @return 写入成功或对象已存在时返回 true
+ */
+static bool write_object_file_if_absent(const std::filesystem::path& objects_dir_path,
+                                        const std::string& hash_hex,
+                                        const std::vector<std::byte>& object_bytes,
+                                        const std::filesystem::path& path_hint = {}) {
+    if (ObjectAlternates::contains(objects_dir_path, hash_hex)) {
+        return true;
+    }
+    // 写入层先写匿名临时文件再赋予文件名，不会留下不完整的对象；并行写入同一对象时互不干扰
+    std::vector<std::byte> stored_bytes = ObjectCodecs::encode_for_storage(object_bytes, path_hint, objects_dir_path);
+    return ObjectWriter::write(objects_dir_path, hash_hex, stored_bytes);
+}
+
 
 // --- 构造函数实现 ---
 Blob::Blob(std::vector<std::byte> data) : content(std::move(data)) {}
@@ -106,66 +229,32 @@ std::optional<Blob> Blob::deserialize(const std::vector<std::byte>& raw_content_
 
 
 
-std::optional<std::string> Blob::save(const std::filesystem::path& objects_dir_path) const {
+std::optional<std::string> Blob::save(const std::filesystem::path& objects_dir_path, const std::filesystem::path& path_hint) const {
     // 1. 序列化 Blob 对象 (获取 "blob <size>\0<content>" 格式的字节流)
     std::vector<std::byte> serialized_data = this->serialize();
 
-    // 2. 计算序列化数据的 SHA-1 哈希值 (作为文件名)
-    //    确保 SHA1::calculate 接受 vector<byte> 并返回十六进制字符串
-    std::string hash_hex = SHA1::sha1(serialized_data);
-    if (hash_hex.empty() || hash_hex.length() != 40) { // 基本的哈希有效性检查
-        std::cerr << "错误: 计算 SHA1 哈希失败或格式不正确。" << std::endl;
-        return std::nullopt;
-    }
-
-    // 3. 构建对象文件的存储路径 (例如: objects/ab/cdef...)
-    std::filesystem::path dir_part = objects_dir_path / hash_hex.substr(0, 2);
-    std::filesystem::path file_part = dir_part / hash_hex.substr(2);
-
-    std::error_code ec;
-    // 4. 创建对象子目录 (如果不存在)
-    if (!std::filesystem::exists(dir_part, ec)) {
-        if (!std::filesystem::create_directories(dir_part, ec)) {
-            std::cerr << "错误: 无法创建对象子目录 '" << dir_part.string() << "': " << ec.message() << std::endl;
-            return std::nullopt;
-        }
-    } else if (!std::filesystem::is_directory(dir_part, ec)) {
-         std::cerr << "错误: 对象路径的目录部分 '" << dir_part.string() << "' 已存在但不是目录。" << std::endl;
-        return std::nullopt;
-    }
-
-
-    // 5. 将序列化的数据写入文件 (如果文件已存在，则覆盖)
-    if (std::filesystem::exists(file_part, ec)) {
-        std::cout << "提示: 对象 " << hash_hex << " 已存在，无需保存。" << std::endl;
-        return hash_hex; // 对象已存在，返回其哈希
-    }
-
-    std::ofstream ofs(file_part, std::ios::binary | std::ios::trunc);
-    if (!ofs.is_open()) {
-        std::cerr << "错误: 无法打开或创建对象文件 '" << file_part.string() << "' 进行写入。" << std::endl;
+    // 2. 按仓库的对象格式计算序列化数据的哈希值 (作为文件名)
+    std::string hash_hex = ObjectFormat::hash(objects_dir_path, serialized_data);
+    if (!ObjectFormat::is_id_length(hash_hex.length())) { // 基本的哈希有效性检查
+        std::cerr << "错误: 计算对象哈希失败或格式不正确。" << std::endl;
         return std::nullopt;
     }
 
-    ofs.write(reinterpret_cast<const char*>(serialized_data.data()), serialized_data.size());
-    if (!ofs.good()) { // 检查写入操作是否成功
-        std::cerr << "错误: 写入对象文件 '" << file_part.string() << "' 失败。" << std::endl;
-        ofs.close(); // 尝试关闭
-        std::filesystem::remove(file_part, ec); // 尝试删除写入失败的文件
+    // 3. 对象不存在时写入 (先写临时文件再重命名：add 并行保存内容相同的文件时不会互相截断)
+    //    序列文件等可由存储层编解码器压缩存放 (哈希仍按规范字节计算)
+    if (!write_object_file_if_absent(objects_dir_path, hash_hex, serialized_data, path_hint)) {
         return std::nullopt;
     }
-    ofs.close();
-
     return hash_hex; // 返回计算出的哈希值
 }
 
 std::optional<Blob> Blob::load_by_hash(const std::string& hash_hex, const std::filesystem::path& objects_dir_path) {
-    if (hash_hex.length() != 40) {
+    if (!ObjectFormat::is_id_length(hash_hex.length())) {
         // std::cerr << "错误: 无效的 SHA1 哈希长度: " << hash_hex << std::endl;
         return std::nullopt;
     }
 
-    std::filesystem::path file_path = objects_dir_path / hash_hex.substr(0, 2) / hash_hex.substr(2);
+    std::filesystem::path file_path = ObjectAlternates::locate(objects_dir_path, hash_hex);
 
     if (!std::filesystem::exists(file_path)) {
         // std::cerr << "错误: 对象文件不存在 '" << file_path.string() << "'" << std::endl;
@@ -180,6 +269,11 @@ std::optional<Blob> Blob::load_by_hash(const std::string& hash_hex, const std::f
 
     const auto& [type_str_read, content_size_read, raw_content_data] = *parsed_result;
 
+    // 分块存储的 Blob：按清单重组 (重组时校验哈希)
+    if (type_str_read == Blob::manifest_type_str()) {
+        return Blob::assemble_from_manifest(hash_hex, raw_content_data, objects_dir_path);
+    }
+
     // 验证对象类型是否为 "blob"
     if (type_str_read != Blob::type_str()) {
         std::cerr << "错误: 对象类型不匹配于 '" << file_path.string()
@@ -194,7 +288,7 @@ std::optional<Blob> Blob::load_by_hash(const std::string& hash_hex, const std::f
     for (char ch_h : header_for_verify) { data_for_verify.push_back(static_cast<std::byte>(ch_h)); }
     data_for_verify.insert(data_for_verify.end(), raw_content_data.begin(), raw_content_data.end());
 
-    std::string calculated_hash = SHA1::sha1(data_for_verify);
+    std::string calculated_hash = ObjectFormat::hash(objects_dir_path, data_for_verify);
     if (calculated_hash != hash_hex) {
         std::cerr << "错误: 对象数据损坏或哈希不匹配于 '" << file_path.string()
                   << "'. 文件哈希: " << calculated_hash << ", 期望哈希: " << hash_hex << std::endl;
@@ -206,6 +300,255 @@ std::optional<Blob> Blob::load_by_hash(const std::string& hash_hex, const std::f
 }
 
 
+const std::string& Blob::manifest_type_str() {
+    static const std::string type = "manifest";
+    return type;
+}
+
+const std::string& Blob::chunk_type_str() {
+    static const std::string type = "chunk";
+    return type;
+}
+
+std::optional<std::string> Blob::save_chunked(const std::filesystem::path& objects_dir_path, const FastCdcChunker& chunker) const {
+    // 1. Blob 的哈希与整体存储时相同
+    std::string hash_hex = ObjectFormat::hash(objects_dir_path, this->serialize());
+    if (ObjectAlternates::contains(objects_dir_path, hash_hex)) {
+        return hash_hex; // 已存在 (整体或分块形式，或在备用对象库中)，无需保存
+    }
+
+    // 2. 切分内容并写入各个 chunk (已存在的 chunk 直接复用)
+    std::ostringstream manifest_text;
+    manifest_text << content.size() << "\n";
+    size_t offset = 0;
+    for (size_t chunk_size : chunker.split(content.data(), content.size())) {
+        std::vector<std::byte> chunk_bytes = make_object_bytes(chunk_type_str(), content.data() + offset, chunk_size);
+        std::string chunk_hash = ObjectFormat::hash(objects_dir_path, chunk_bytes);
+        if (!write_object_file_if_absent(objects_dir_path, chunk_hash, chunk_bytes)) {
+            return std::nullopt;
+        }
+        manifest_text << chunk_hash << " " << chunk_size << "\n";
+        offset += chunk_size;
+    }
+
+    // 3. 所有 chunk 写入后，再在 Blob 的哈希下写入清单
+    std::string manifest_str = manifest_text.str();
+    std::vector<std::byte> manifest_bytes = make_object_bytes(manifest_type_str(),
+        reinterpret_cast<const std::byte*>(manifest_str.data()), manifest_str.size());
+    if (!write_object_file_if_absent(objects_dir_path, hash_hex, manifest_bytes)) {
+        return std::nullopt;
+    }
+    return hash_hex;
+}
+
+/**
+ * @brief 解析清单内容为 <总大小, [<chunk哈希, chunk大小>...]>
+ */
+static std::optional<std::pair<size_t, std::vector<std::pair<std::string, size_t>>>>
+parse_manifest(const std::vector<std::byte>& manifest_content) {
+    std::string text(reinterpret_cast<const char*>(manifest_content.data()), manifest_content.size());
+    std::istringstream iss(text);
+    size_t total_size = 0;
+    if (!(iss >> total_size)) {
+        return std::nullopt;
+    }
+    std::vector<std::pair<std::string, size_t>> chunks;
+    std::string chunk_hash;
+    size_t chunk_size = 0;
+    while (iss >> chunk_hash >> chunk_size) {
+        if (!ObjectFormat::is_id_length(chunk_hash.length())) return std::nullopt;
+        chunks.emplace_back(chunk_hash, chunk_size);
+    }
+    if (!iss.eof()) {
+        return std::nullopt;
+    }
+    return std::make_pair(total_size, std::move(chunks));
+}
+
+std::optional<std::vector<std::string>> Blob::parse_manifest_chunks(const std::vector<std::byte>& manifest_content) {
+    auto manifest_opt = parse_manifest(manifest_content);
+    if (!manifest_opt) {
+        return std::nullopt;
+    }
+    std::vector<std::string> chunk_hashes;
+    chunk_hashes.reserve(manifest_opt->second.size());
+    for (const auto& [chunk_hash, chunk_size] : manifest_opt->second) {
+        chunk_hashes.push_back(chunk_hash);
+    }
+    return chunk_hashes;
+}
+
+std::optional<std::vector<std::pair<std::string, size_t>>> Blob::parse_manifest_entries(const std::vector<std::byte>& manifest_content) {
+    auto manifest_opt = parse_manifest(manifest_content);
+    if (!manifest_opt) {
+        return std::nullopt;
+    }
+    return std::move(manifest_opt->second);
+}
+
+std::optional<Blob> Blob::assemble_from_manifest(const std::string& hash_hex,
+                                                 const std::vector<std::byte>& manifest_content,
+                                                 const std::filesystem::path& objects_dir_path) {
+    auto manifest_opt = parse_manifest(manifest_content);
+    if (!manifest_opt) {
+        std::cerr << "错误: 分块清单格式错误 (Blob " << hash_hex << ")。" << std::endl;
+        return std::nullopt;
+    }
+    const auto& [total_size, chunks] = *manifest_opt;
+
+    // 1. 按顺序读取并拼接各个 chunk
+    std::vector<std::byte> assembled;
+    assembled.reserve(total_size);
+    for (const auto& [chunk_hash, chunk_size] : chunks) {
+        std::filesystem::path chunk_path = ObjectAlternates::locate(objects_dir_path, chunk_hash);
+        auto chunk_opt = read_and_parse_object_file(chunk_path);
+        if (!chunk_opt) {
+            std::cerr << "错误: Blob " << hash_hex << " 缺少内容块 " << chunk_hash << "。" << std::endl;
+            return std::nullopt;
+        }
+        const auto& [chunk_type, chunk_size_read, chunk_data] = *chunk_opt;
+        if (chunk_type != chunk_type_str() || chunk_size_read != chunk_size) {
+            std::cerr << "错误: 内容块 " << chunk_hash << " 类型或大小与清单不符。" << std::endl;
+            return std::nullopt;
+        }
+        assembled.insert(assembled.end(), chunk_data.begin(), chunk_data.end());
+    }
+    if (assembled.size() != total_size) {
+        std::cerr << "错误: Blob " << hash_hex << " 重组后的大小与清单不符。" << std::endl;
+        return std::nullopt;
+    }
+
+    // 2. 校验重组结果的哈希 (同时校验了每个 chunk 的内容)
+    Blob blob(std::move(assembled));
+    std::string calculated_hash = ObjectFormat::hash(objects_dir_path, blob.serialize());
+    if (calculated_hash != hash_hex) {
+        std::cerr << "错误: 分块 Blob 重组后哈希不匹配。重组哈希: " << calculated_hash << ", 期望哈希: " << hash_hex << std::endl;
+        return std::nullopt;
+    }
+    return blob;
+}
+
+std::optional<std::vector<std::pair<std::string, size_t>>> Blob::read_chunk_list(const std::string& hash_hex,
+                                                                               const std::filesystem::path& objects_dir_path) {
+    if (!ObjectFormat::is_id_length(hash_hex.length())) {
+        return std::nullopt;
+    }
+    std::filesystem::path file_path = ObjectAlternates::locate(objects_dir_path, hash_hex);
+    std::ifstream ifs(file_path, std::ios::binary);
+    if (!ifs.is_open()) {
+        return std::nullopt;
+    }
+    // 经编解码器存储的只有整体存储的文本 Blob
+    if (ifs.peek() == ObjectCodecs::MAGIC[0]) {
+        return std::vector<std::pair<std::string, size_t>>{};
+    }
+    std::string type_str_read;
+    if (!std::getline(ifs, type_str_read, ' ')) {
+        return std::nullopt;
+    }
+    if (type_str_read != manifest_type_str()) {
+        return std::vector<std::pair<std::string, size_t>>{};
+    }
+    ifs.close();
+
+    auto parsed_result = read_and_parse_object_file(file_path);
+    if (!parsed_result) {
+        return std::nullopt;
+    }
+    auto entries = parse_manifest_entries(std::get<2>(*parsed_result));
+    if (!entries) {
+        std::cerr << "错误: 分块清单格式错误 (Blob " << hash_hex << ")。" << std::endl;
+    }
+    return entries;
+}
+
+std::optional<std::vector<std::byte>> Blob::load_chunk(const std::string& chunk_hash_hex,
+                                                       const std::filesystem::path& objects_dir_path) {
+    auto chunk_opt = read_and_parse_object_file(ObjectAlternates::locate(objects_dir_path, chunk_hash_hex));
+    if (!chunk_opt || std::get<0>(*chunk_opt) != chunk_type_str()) {
+        std::cerr << "错误: 无法读取内容块 " << chunk_hash_hex << "。" << std::endl;
+        return std::nullopt;
+    }
+    std::vector<std::byte>& chunk_data = std::get<2>(*chunk_opt);
+    if (ObjectFormat::hash(objects_dir_path, make_object_bytes(chunk_type_str(), chunk_data.data(), chunk_data.size())) != chunk_hash_hex) {
+        std::cerr << "错误: 内容块 " << chunk_hash_hex << " 数据损坏或哈希不匹配。" << std::endl;
+        return std::nullopt;
+    }
+    return std::move(chunk_data);
+}
+
+
+std::optional<std::pair<uintmax_t, std::vector<std::byte>>> Blob::read_prefix(const std::string& hash_hex,
+                                                                               const std::filesystem::path& objects_dir_path,
+                                                                               size_t max_bytes) {
+    if (!ObjectFormat::is_id_length(hash_hex.length())) {
+        return std::nullopt;
+    }
+    std::filesystem::path file_path = ObjectAlternates::locate(objects_dir_path, hash_hex);
+    std::ifstream ifs(file_path, std::ios::binary);
+    if (!ifs.is_open()) {
+        return std::nullopt;
+    }
+
+    // 1. 经编解码器存储的对象需要完整还原 (编解码器只接受文本内容)
+    if (ifs.peek() == ObjectCodecs::MAGIC[0]) {
+        ifs.close();
+        auto parsed_result = read_and_parse_object_file(file_path);
+        if (!parsed_result || std::get<0>(*parsed_result) != Blob::type_str()) {
+            return std::nullopt;
+        }
+        auto& content_data = std::get<2>(*parsed_result);
+        uintmax_t total_size = content_data.size();
+        content_data.resize(std::min(content_data.size(), max_bytes));
+        return std::make_pair(total_size, std::move(content_data));
+    }
+
+    // 2. 只解析头部，再按类型读取开头部分
+    std::string type_str_read, size_str_read;
+    if (!std::getline(ifs, type_str_read, ' ') || !std::getline(ifs, size_str_read, '\0')) {
+        return std::nullopt;
+    }
+    uintmax_t content_size_read = 0;
+    try {
+        content_size_read = std::stoull(size_str_read);
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+
+    if (type_str_read == Blob::type_str()) {
+        std::vector<std::byte> prefix(static_cast<size_t>(std::min<uintmax_t>(content_size_read, max_bytes)));
+        if (!prefix.empty() && !ifs.read(reinterpret_cast<char*>(prefix.data()), static_cast<std::streamsize>(prefix.size()))) {
+            return std::nullopt;
+        }
+        return std::make_pair(content_size_read, std::move(prefix));
+    }
+
+    if (type_str_read == Blob::manifest_type_str()) { // 分块存储：总大小来自清单，开头部分来自第一个 chunk
+        std::vector<std::byte> manifest_content(static_cast<size_t>(content_size_read));
+        if (!manifest_content.empty() && !ifs.read(reinterpret_cast<char*>(manifest_content.data()), static_cast<std::streamsize>(manifest_content.size()))) {
+            return std::nullopt;
+        }
+        auto manifest_opt = parse_manifest(manifest_content);
+        if (!manifest_opt) {
+            return std::nullopt;
+        }
+        const auto& [total_size, chunks] = *manifest_opt;
+        std::vector<std::byte> prefix;
+        if (!chunks.empty()) {
+            const std::string& first_chunk_hash = chunks.front().first;
+            auto chunk_opt = read_and_parse_object_file(ObjectAlternates::locate(objects_dir_path, first_chunk_hash));
+            if (!chunk_opt) {
+                return std::nullopt;
+            }
+            prefix = std::move(std::get<2>(*chunk_opt));
+            prefix.resize(std::min(prefix.size(), max_bytes));
+        }
+        return std::make_pair(static_cast<uintmax_t>(total_size), std::move(prefix));
+    }
+    return std::nullopt;
+}
+
+
 std::string Blob::get_content_as_string() const {
     if (content.empty()) {
         return "";
@@ -220,9 +563,9 @@ std::string Blob::get_content_as_string() const {
 TreeEntry::TreeEntry(std::string m, std::string n, std::string hash_hex_str)
     : mode(std::move(m)), name(std::move(n)), sha1_hash_hex(std::move(hash_hex_str)) {
     // 可以添加对 sha1_hash_hex 长度和格式的验证
-    if (this->sha1_hash_hex.length() != 40) {
+    if (!ObjectFormat::is_id_length(this->sha1_hash_hex.length())) {
         // 根据你的错误处理策略，可以抛出异常或标记为无效
-        std::cerr << "警告: TreeEntry 创建时哈希长度不为40: " << this->sha1_hash_hex << std::endl;
+        std::cerr << "警告: TreeEntry 创建时哈希长度无效: " << this->sha1_hash_hex << std::endl;
     }
 }
 
@@ -238,7 +581,7 @@ std::vector<std::byte> TreeEntry::serialize() const {
     // 追加名称
     for (char ch : name) { entry_data.push_back(static_cast<std::byte>(ch)); }
     entry_data.push_back(static_cast<std::byte>('\0')); // 名称后的空终止符
-    // 追加40字符的十六进制SHA1哈希
+    // 追加十六进制对象哈希 (40 或 64 字符，取决于对象格式)
     for (char ch : sha1_hash_hex) { entry_data.push_back(static_cast<std::byte>(ch)); }
     return entry_data;
 }
@@ -266,7 +609,7 @@ void Tree::sort_entries() {
 }
 
 void Tree::add_entry(const TreeEntry& entry) {
-    if (entry.sha1_hash_hex.length() != 40) { // 基本验证
+    if (!ObjectFormat::is_id_length(entry.sha1_hash_hex.length())) { // 基本验证
         std::cerr << "错误: 尝试添加的 TreeEntry 哈希无效: " << entry.name << std::endl;
         return; // 或者抛出异常
     }
@@ -275,13 +618,29 @@ void Tree::add_entry(const TreeEntry& entry) {
 }
 
 void Tree::add_entry(const std::string& mode, const std::string& name, const std::string& sha1_hash_hex) {
-    if (sha1_hash_hex.length() != 40) { // 基本验证
+    if (!ObjectFormat::is_id_length(sha1_hash_hex.length())) { // 基本验证
         std::cerr << "错误: 尝试添加的 TreeEntry 哈希无效: " << name << std::endl;
         return; // 或者抛出异常
     }
     add_entry(TreeEntry(mode, name, sha1_hash_hex));
 }
 
+void Tree::set_entries(std::vector<TreeEntry> new_entries) {
+    entries = std::move(new_entries);
+    sort_entries();
+}
+
+const TreeEntry* Tree::find_entry(const std::string& name) const {
+    // 同名的文件和目录排序位置不同 ("a" 与 "a/")，两个位置各查一次
+    for (const std::string& key : {name, name + '/'}) {
+        auto it = std::lower_bound(entries.begin(), entries.end(), key, [](const TreeEntry& entry, const std::string& k) {
+            return (entry.is_directory() ? entry.name + '/' : entry.name) < k;
+        });
+        if (it != entries.end() && it->name == name) return &*it;
+    }
+    return nullptr;
+}
+
 std::vector<std::byte> Tree::serialize() const {
     std::vector<std::byte> content_data;
     for (const auto& entry : entries) { // entries 应该已经是排序好的
@@ -300,7 +659,7 @@ std::vector<std::byte> Tree::serialize() const {
     return serialized_data;
 }
 
-std::optional<Tree> Tree::deserialize(const std::vector<std::byte>& raw_content_data) {
+std::optional<Tree> Tree::deserialize(const std::vector<std::byte>& raw_content_data, size_t hash_hex_length) {
     Tree tree;
     size_t current_pos = 0;
 
@@ -329,16 +688,16 @@ std::optional<Tree> Tree::deserialize(const std::vector<std::byte>& raw_content_
         }
         current_pos = parse_ptr + 1; // 跳过 '\0'
 
-        // 3. 解析40字符的十六进制SHA1哈希
-        if (current_pos + 40 > raw_content_data.size()) {
+        // 3. 解析十六进制对象哈希 (长度由对象格式决定)
+        if (current_pos + hash_hex_length > raw_content_data.size()) {
             return std::nullopt; // 数据不足
         }
         std::string sha1_hex_str;
-        sha1_hex_str.reserve(40);
-        for (size_t i = 0; i < 40; ++i) {
+        sha1_hex_str.reserve(hash_hex_length);
+        for (size_t i = 0; i < hash_hex_length; ++i) {
             sha1_hex_str += static_cast<char>(raw_content_data[current_pos + i]);
         }
-        current_pos += 40;
+        current_pos += hash_hex_length;
 
         // 反序列化时，条目已经是正确顺序，直接添加到列表
         tree.entries.emplace_back(mode_str, name_str, sha1_hex_str);
@@ -351,50 +710,28 @@ std::optional<Tree> Tree::deserialize(const std::vector<std::byte>& raw_content_
 
 std::optional<std::string> Tree::save(const std::filesystem::path& objects_dir_path) const {
     std::vector<std::byte> serialized_data = this->serialize();
-    std::string hash_hex = SHA1::sha1(serialized_data); // 你的SHA1函数返回十六进制字符串
+    std::string hash_hex = ObjectFormat::hash(objects_dir_path, serialized_data);
 
-    if (hash_hex.empty() || hash_hex.length() != 40) {
-        std::cerr << "错误: Tree对象计算SHA1哈希失败或格式不正确。" << std::endl;
+    if (!ObjectFormat::is_id_length(hash_hex.length())) {
+        std::cerr << "错误: Tree对象计算哈希失败或格式不正确。" << std::endl;
         return std::nullopt;
     }
 
-    std::filesystem::path dir_part = objects_dir_path / hash_hex.substr(0, 2);
-    std::filesystem::path file_part = dir_part / hash_hex.substr(2);
-    std::error_code ec;
-
-    if (!std::filesystem::exists(dir_part, ec)) {
-        if (!std::filesystem::create_directories(dir_part, ec)) {
-            std::cerr << "错误: 无法创建对象子目录 '" << dir_part.string() << "': " << ec.message() << std::endl;
-            return std::nullopt;
-        }
-    } else if (!std::filesystem::is_directory(dir_part, ec)) {
-         std::cerr << "错误: 对象路径的目录部分 '" << dir_part.string() << "' 已存在但不是目录。" << std::endl;
-        return std::nullopt;
-    }
-
-    if (std::filesystem::exists(file_part, ec)) {
-        return hash_hex; // 对象已存在
-    }
-
-    std::ofstream ofs(file_part, std::ios::binary | std::ios::trunc);
-    if (!ofs.is_open()) {
-        std::cerr << "错误: 无法打开或创建对象文件 '" << file_part.string() << "' 进行写入。" << std::endl;
-        return std::nullopt;
-    }
-    ofs.write(reinterpret_cast<const char*>(serialized_data.data()), serialized_data.size());
-    if (!ofs.good()) {
-        std::cerr << "错误: 写入对象文件 '" << file_part.string() << "' 失败。" << std::endl;
-        ofs.close();
+    // 小对象在仓库训练过字典后以预设字典压缩存放
+    if (!write_object_file_if_absent(objects_dir_path, hash_hex, serialized_data)) {
         return std::nullopt;
     }
-    ofs.close();
     return hash_hex;
 }
 
 std::optional<Tree> Tree::load_by_hash(const std::string& hash_hex, const std::filesystem::path& objects_dir_path) {
-    if (hash_hex.length() != 40) { return std::nullopt; }
+    if (!ObjectFormat::is_id_length(hash_hex.length())) { return std::nullopt; }
+    const size_t entry_hash_length = ObjectFormat::hex_length(ObjectFormat::algorithm_of(objects_dir_path));
+    if (auto cached = find_verified_object(objects_dir_path, hash_hex, Tree::type_str())) {
+        return Tree::deserialize(*cached, entry_hash_length);
+    }
 
-    std::filesystem::path file_path = objects_dir_path / hash_hex.substr(0, 2) / hash_hex.substr(2);
+    std::filesystem::path file_path = ObjectAlternates::locate(objects_dir_path, hash_hex);
     if (!std::filesystem::exists(file_path)) { return std::nullopt; }
 
     auto parsed_result = read_and_parse_object_file(file_path);
@@ -414,14 +751,15 @@ std::optional<Tree> Tree::load_by_hash(const std::string& hash_hex, const std::f
     for (char ch_h : header_for_verify) { data_for_verify.push_back(static_cast<std::byte>(ch_h)); }
     data_for_verify.insert(data_for_verify.end(), raw_content_data.begin(), raw_content_data.end());
 
-    std::string calculated_hash = SHA1::sha1(data_for_verify);
+    std::string calculated_hash = ObjectFormat::hash(objects_dir_path, data_for_verify);
     if (calculated_hash != hash_hex) {
         std::cerr << "错误: Tree对象数据损坏或哈希不匹配于 '" << file_path.string()
                   << "'. 文件哈希: " << calculated_hash << ", 期望哈希: " << hash_hex << std::endl;
         return std::nullopt;
     }
 
-    return Tree::deserialize(raw_content_data);
+    remember_verified_object(objects_dir_path, hash_hex, Tree::type_str(), raw_content_data);
+    return Tree::deserialize(raw_content_data, entry_hash_length);
 }
 
 
@@ -549,9 +887,9 @@ std::optional<Commit> Commit::deserialize(const std::vector<std::byte>& raw_cont
             if (key == "tree") {
                 if (!commit.tree_hash_hex.empty()) return std::nullopt; // tree 只能有一个
                 commit.tree_hash_hex = value;
-                if (commit.tree_hash_hex.length() != 40) return std::nullopt; // 哈希长度验证
+                if (!ObjectFormat::is_id_length(commit.tree_hash_hex.length())) return std::nullopt; // 哈希长度验证
             } else if (key == "parent") {
-                if (value.length() != 40) return std::nullopt; // 哈希长度验证
+                if (!ObjectFormat::is_id_length(value.length())) return std::nullopt; // 哈希长度验证
                 commit.parent_hashes_hex.push_back(value);
             } else if (key == "author") {
                 auto author_opt = PersonTimestamp::parse_from_line_content(value);
@@ -595,50 +933,27 @@ std::optional<Commit> Commit::deserialize(const std::vector<std::byte>& raw_cont
 
 std::optional<std::string> Commit::save(const std::filesystem::path& objects_dir_path) const {
     std::vector<std::byte> serialized_data = this->serialize();
-    std::string hash_hex = SHA1::sha1(serialized_data);
-
-    if (hash_hex.empty() || hash_hex.length() != 40) {
-        std::cerr << "错误: Commit对象计算SHA1哈希失败或格式不正确。" << std::endl;
-        return std::nullopt;
-    }
-
-    std::filesystem::path dir_part = objects_dir_path / hash_hex.substr(0, 2);
-    std::filesystem::path file_part = dir_part / hash_hex.substr(2);
-    std::error_code ec;
+    std::string hash_hex = ObjectFormat::hash(objects_dir_path, serialized_data);
 
-    if (!std::filesystem::exists(dir_part, ec)) {
-        if (!std::filesystem::create_directories(dir_part, ec)) {
-            std::cerr << "错误: 无法创建对象子目录 '" << dir_part.string() << "': " << ec.message() << std::endl;
-            return std::nullopt;
-        }
-    } else if (!std::filesystem::is_directory(dir_part, ec)) {
-         std::cerr << "错误: 对象路径的目录部分 '" << dir_part.string() << "' 已存在但不是目录。" << std::endl;
+    if (!ObjectFormat::is_id_length(hash_hex.length())) {
+        std::cerr << "错误: Commit对象计算哈希失败或格式不正确。" << std::endl;
         return std::nullopt;
     }
 
-    if (std::filesystem::exists(file_part, ec)) {
-        return hash_hex; // 对象已存在
-    }
-
-    std::ofstream ofs(file_part, std::ios::binary | std::ios::trunc);
-    if (!ofs.is_open()) {
-        std::cerr << "错误: 无法打开或创建对象文件 '" << file_part.string() << "' 进行写入。" << std::endl;
+    // 小对象在仓库训练过字典后以预设字典压缩存放
+    if (!write_object_file_if_absent(objects_dir_path, hash_hex, serialized_data)) {
         return std::nullopt;
     }
-    ofs.write(reinterpret_cast<const char*>(serialized_data.data()), serialized_data.size());
-    if (!ofs.good()) {
-        std::cerr << "错误: 写入对象文件 '" << file_part.string() << "' 失败。" << std::endl;
-        ofs.close();
-        return std::nullopt;
-    }
-    ofs.close();
     return hash_hex;
 }
 
 std::optional<Commit> Commit::load_by_hash(const std::string& hash_hex, const std::filesystem::path& objects_dir_path) {
-    if (hash_hex.length() != 40) { return std::nullopt; }
+    if (!ObjectFormat::is_id_length(hash_hex.length())) { return std::nullopt; }
+    if (auto cached = find_verified_object(objects_dir_path, hash_hex, Commit::type_str())) {
+        return Commit::deserialize(*cached);
+    }
 
-    std::filesystem::path file_path = objects_dir_path / hash_hex.substr(0, 2) / hash_hex.substr(2);
+    std::filesystem::path file_path = ObjectAlternates::locate(objects_dir_path, hash_hex);
     if (!std::filesystem::exists(file_path)) { return std::nullopt; }
 
     auto parsed_result = read_and_parse_object_file(file_path);
@@ -658,13 +973,14 @@ std::optional<Commit> Commit::load_by_hash(const std::string& hash_hex, const st
     for (char ch_h : header_for_verify) { data_for_verify.push_back(static_cast<std::byte>(ch_h)); }
     data_for_verify.insert(data_for_verify.end(), raw_content_data.begin(), raw_content_data.end());
 
-    std::string calculated_hash = SHA1::sha1(data_for_verify);
+    std::string calculated_hash = ObjectFormat::hash(objects_dir_path, data_for_verify);
     if (calculated_hash != hash_hex) {
         std::cerr << "错误: Commit对象数据损坏或哈希不匹配于 '" << file_path.string()
                   << "'. 文件哈希: " << calculated_hash << ", 期望哈希: " << hash_hex << std::endl;
         return std::nullopt;
     }
 
+    remember_verified_object(objects_dir_path, hash_hex, Commit::type_str(), raw_content_data);
     return Commit::deserialize(raw_content_data);
 }
 }
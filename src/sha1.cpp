@@ -2,6 +2,8 @@
 #include <iostream>
 #include <vector>
 #include <cstdint>  // 添加uint32_t支持
+#include <cstring>
+#include <algorithm>
 namespace SHA1 {
     // 循环左移函数
     inline uint32_t S(uint32_t x, int n) {
@@ -31,6 +33,46 @@ namespace SHA1 {
             return 0xca62c1d6;
     }
 
+    // 处理一个 64 字节的数据块，更新中间哈希值 H
+    void compress_block(std::array<uint32_t, 5>& H, const std::byte* chunk_ptr) {
+        uint32_t W[80];
+        uint32_t H0 = H[0], H1 = H[1], H2 = H[2], H3 = H[3], H4 = H[4];
+
+        for (int j = 0; j < 16; ++j) {
+            W[j] = (static_cast<uint32_t>(chunk_ptr[j * 4 + 0]) << 24) |
+                   (static_cast<uint32_t>(chunk_ptr[j * 4 + 1]) << 16) |
+                   (static_cast<uint32_t>(chunk_ptr[j * 4 + 2]) << 8)  |
+                   (static_cast<uint32_t>(chunk_ptr[j * 4 + 3]) << 0);
+        }
+
+        for (int j = 16; j < 80; ++j) {
+            W[j] = S(W[j - 3] ^ W[j - 8] ^ W[j - 14] ^ W[j - 16], 1);
+        }
+
+        uint32_t A = H0;
+        uint32_t B = H1;
+        uint32_t C = H2;
+        uint32_t D = H3;
+        uint32_t E = H4;
+
+        for (int t = 0; t < 80; ++t) {
+            uint32_t temp = S(A, 5) + f_t(t, B, C, D) + E + K_t(t) + W[t];
+            E = D;
+            D = C;
+            C = S(B, 30);
+            B = A;
+            A = temp;
+        }
+
+        H0 += A;
+        H1 += B;
+        H2 += C;
+        H3 += D;
+        H4 += E;
+
+        H = {H0, H1, H2, H3, H4};
+    }
+
     // 核心SHA-1计算逻辑
     std::array<uint32_t, 5> process_data(const std::vector<std::byte>& original_data) {
         uint32_t H0 = 0x67452301;
@@ -53,44 +95,11 @@ namespace SHA1 {
         }
 
         int num_chunks = padded_data.size() / 64;
-        uint32_t W[80];
-
+        std::array<uint32_t, 5> H = {H0, H1, H2, H3, H4};
         for (int i = 0; i < num_chunks; ++i) {
-            const std::byte* chunk_ptr = padded_data.data() + (i * 64);
-
-            for (int j = 0; j < 16; ++j) {
-                W[j] = (static_cast<uint32_t>(chunk_ptr[j * 4 + 0]) << 24) |
-                       (static_cast<uint32_t>(chunk_ptr[j * 4 + 1]) << 16) |
-                       (static_cast<uint32_t>(chunk_ptr[j * 4 + 2]) << 8)  |
-                       (static_cast<uint32_t>(chunk_ptr[j * 4 + 3]) << 0);
-            }
-
-            for (int j = 16; j < 80; ++j) {
-                W[j] = S(W[j - 3] ^ W[j - 8] ^ W[j - 14] ^ W[j - 16], 1);
-            }
-
-            uint32_t A = H0;
-            uint32_t B = H1;
-            uint32_t C = H2;
-            uint32_t D = H3;
-            uint32_t E = H4;
-
-            for (int t = 0; t < 80; ++t) {
-                uint32_t temp = S(A, 5) + f_t(t, B, C, D) + E + K_t(t) + W[t];
-                E = D;
-                D = C;
-                C = S(B, 30);
-                B = A;
-                A = temp;
-            }
-
-            H0 += A;
-            H1 += B;
-            H2 += C;
-            H3 += D;
-            H4 += E;
+            compress_block(H, padded_data.data() + (i * 64));
         }
-        return {H0, H1, H2, H3, H4};
+        return H;
     }
 
     std::string sha1(const std::vector<std::byte>& data) {
@@ -111,4 +120,51 @@ namespace SHA1 {
         return sha1(byte_data); // 调用处理 vector<byte> 的版本
     }
 
+    std::string to_hex(const std::array<uint32_t, 5>& hash_components) {
+        char hex_str[41];
+        std::sprintf(hex_str, "%08x%08x%08x%08x%08x",
+                     hash_components[0], hash_components[1], hash_components[2],
+                     hash_components[3], hash_components[4]);
+        return std::string(hex_str);
+    }
+
+    Hasher::Hasher() : h_{0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0} {}
+
+    void Hasher::update(const void* data, size_t length) {
+        const std::byte* bytes = static_cast<const std::byte*>(data);
+        total_length_ += length;
+        // 1. 先填满上次剩余的缓冲区
+        if (buffer_length_ > 0) {
+            size_t take = std::min(length, buffer_.size() - buffer_length_);
+            std::memcpy(buffer_.data() + buffer_length_, bytes, take);
+            buffer_length_ += take;
+            bytes += take;
+            length -= take;
+            if (buffer_length_ < buffer_.size()) return;
+            compress_block(h_, buffer_.data());
+            buffer_length_ = 0;
+        }
+        // 2. 直接处理完整的数据块
+        while (length >= buffer_.size()) {
+            compress_block(h_, bytes);
+            bytes += buffer_.size();
+            length -= buffer_.size();
+        }
+        // 3. 保存剩余不足一块的数据
+        std::memcpy(buffer_.data(), bytes, length);
+        buffer_length_ = length;
+    }
+
+    std::string Hasher::hex_digest() {
+        uint64_t length_bits = total_length_ * 8;
+        std::byte padding[72] = {static_cast<std::byte>(0x80)};
+        size_t padding_length = (buffer_length_ < 56) ? (56 - buffer_length_) : (120 - buffer_length_);
+        update(padding, padding_length);
+        std::byte length_bytes[8];
+        for (int i = 0; i < 8; ++i) {
+            length_bytes[i] = static_cast<std::byte>((length_bits >> (56 - 8 * i)) & 0xFF);
+        }
+        update(length_bytes, 8);
+        return to_hex(h_);
+    }
 };
\ No newline at end of file
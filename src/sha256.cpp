@@ -0,0 +1,122 @@
+#include "../include/sha256.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+namespace SHA256 {
+    namespace {
+
+    constexpr uint32_t K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+    // 循环右移函数
+    inline uint32_t rotr(uint32_t x, int n) {
+        return (x >> n) | (x << (32 - n));
+    }
+
+    // 处理一个 64 字节的数据块，更新中间哈希值 H
+    void compress_block(std::array<uint32_t, 8>& H, const std::byte* block) {
+        uint32_t W[64];
+        for (int j = 0; j < 16; ++j) {
+            W[j] = (static_cast<uint32_t>(block[j * 4 + 0]) << 24) |
+                   (static_cast<uint32_t>(block[j * 4 + 1]) << 16) |
+                   (static_cast<uint32_t>(block[j * 4 + 2]) << 8)  |
+                   (static_cast<uint32_t>(block[j * 4 + 3]) << 0);
+        }
+        for (int j = 16; j < 64; ++j) {
+            uint32_t s0 = rotr(W[j - 15], 7) ^ rotr(W[j - 15], 18) ^ (W[j - 15] >> 3);
+            uint32_t s1 = rotr(W[j - 2], 17) ^ rotr(W[j - 2], 19) ^ (W[j - 2] >> 10);
+            W[j] = W[j - 16] + s0 + W[j - 7] + s1;
+        }
+
+        uint32_t a = H[0], b = H[1], c = H[2], d = H[3], e = H[4], f = H[5], g = H[6], h = H[7];
+        for (int t = 0; t < 64; ++t) {
+            uint32_t S1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+            uint32_t ch = (e & f) ^ ((~e) & g);
+            uint32_t temp1 = h + S1 + ch + K[t] + W[t];
+            uint32_t S0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+            uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t temp2 = S0 + maj;
+            h = g;
+            g = f;
+            f = e;
+            e = d + temp1;
+            d = c;
+            c = b;
+            b = a;
+            a = temp1 + temp2;
+        }
+
+        H[0] += a; H[1] += b; H[2] += c; H[3] += d;
+        H[4] += e; H[5] += f; H[6] += g; H[7] += h;
+    }
+
+    std::string to_hex(const std::array<uint32_t, 8>& hash_components) {
+        char hex_str[65];
+        for (size_t i = 0; i < hash_components.size(); ++i) {
+            std::snprintf(hex_str + i * 8, 9, "%08x", hash_components[i]);
+        }
+        return std::string(hex_str, 64);
+    }
+
+    }
+
+    std::string sha256(const std::vector<std::byte>& data) {
+        Hasher hasher;
+        hasher.update(data.data(), data.size());
+        return hasher.hex_digest();
+    }
+
+    std::string sha256(const std::string& text_data) {
+        Hasher hasher;
+        hasher.update(text_data.data(), text_data.size());
+        return hasher.hex_digest();
+    }
+
+    Hasher::Hasher() : h_{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19} {}
+
+    void Hasher::update(const void* data, size_t length) {
+        const std::byte* bytes = static_cast<const std::byte*>(data);
+        total_length_ += length;
+        // 1. 先填满上次剩余的缓冲区
+        if (buffer_length_ > 0) {
+            size_t take = std::min(length, buffer_.size() - buffer_length_);
+            std::memcpy(buffer_.data() + buffer_length_, bytes, take);
+            buffer_length_ += take;
+            bytes += take;
+            length -= take;
+            if (buffer_length_ < buffer_.size()) return;
+            compress_block(h_, buffer_.data());
+            buffer_length_ = 0;
+        }
+        // 2. 直接处理完整的数据块
+        while (length >= buffer_.size()) {
+            compress_block(h_, bytes);
+            bytes += buffer_.size();
+            length -= buffer_.size();
+        }
+        // 3. 保存剩余不足一块的数据
+        if (length > 0) std::memcpy(buffer_.data(), bytes, length);
+        buffer_length_ = length;
+    }
+
+    std::string Hasher::hex_digest() {
+        uint64_t length_bits = total_length_ * 8;
+        std::byte padding[72] = {static_cast<std::byte>(0x80)};
+        size_t padding_length = (buffer_length_ < 56) ? (56 - buffer_length_) : (120 - buffer_length_);
+        update(padding, padding_length);
+        std::byte length_bytes[8];
+        for (int i = 0; i < 8; ++i) {
+            length_bytes[i] = static_cast<std::byte>((length_bits >> (56 - 8 * i)) & 0xFF);
+        }
+        update(length_bytes, 8);
+        return to_hex(h_);
+    }
+};
@@ -1,8 +1,12 @@
 #include "../include/utils.h"
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <numeric>
 
+#include <unistd.h>
+
 namespace Utils{
 
 std::vector<std::string> string_to_lines(const std::string& content_str) {
@@ -148,34 +152,94 @@ found_solution:
 }
 
 
+std::pair<int, int> count_line_changes(const std::vector<std::string>& A, const std::vector<std::string>& B) {
+    // 1. 剥离相同的前缀和后缀
+    size_t prefix = 0;
+    while (prefix < A.size() && prefix < B.size() && A[prefix] == B[prefix]) {
+        ++prefix;
+    }
+    size_t suffix = 0;
+    while (suffix < A.size() - prefix && suffix < B.size() - prefix &&
+           A[A.size() - 1 - suffix] == B[B.size() - 1 - suffix]) {
+        ++suffix;
+    }
+
+    // 2. 一边为空时无需运行 Myers
+    const size_t a_mid = A.size() - prefix - suffix;
+    const size_t b_mid = B.size() - prefix - suffix;
+    if (a_mid == 0 || b_mid == 0) {
+        return {static_cast<int>(b_mid), static_cast<int>(a_mid)};
+    }
+
+    // 3. 对中间部分计算编辑脚本并计数
+    std::vector<std::string> a_middle(A.begin() + prefix, A.end() - suffix);
+    std::vector<std::string> b_middle(B.begin() + prefix, B.end() - suffix);
+    int insertions = 0, deletions = 0;
+    for (const auto& op : MyersDiffLines(a_middle, b_middle)) {
+        if (op.type == EditType::INSERT) ++insertions;
+        else if (op.type == EditType::DELETE) ++deletions;
+    }
+    return {insertions, deletions};
+}
+
+bool looks_binary(const char* data, size_t size) {
+    const size_t sample_size = std::min(size, BINARY_SNIFF_SIZE);
+    size_t control_chars = 0;
+    for (size_t i = 0; i < sample_size; ++i) {
+        unsigned char c = static_cast<unsigned char>(data[i]);
+        if (c == 0) {
+            return true;
+        }
+        if ((c < 0x20 && c != '\t' && c != '\n' && c != '\r' && c != '\f' && c != '\b' && c != 0x1B) || c == 0x7F) {
+            ++control_chars;
+        }
+    }
+    return control_chars * 10 > sample_size;
+}
+
 void print_unified_diff(
     const std::filesystem::path& file_path,
     const std::vector<LineEditOperation>& ses, // 编辑脚本
     const std::string& old_file_label_suffix,
     const std::string& new_file_label_suffix,
     int num_context_lines ) { // 上下文行数
+    print_unified_diff(file_path, file_path, ses, old_file_label_suffix, new_file_label_suffix, num_context_lines, {});
+}
+
+void print_unified_diff(
+    const std::filesystem::path& old_file_path,
+    const std::filesystem::path& new_file_path,
+    const std::vector<LineEditOperation>& ses, // 编辑脚本
+    const std::string& old_file_label_suffix,
+    const std::string& new_file_label_suffix,
+    int num_context_lines, // 上下文行数
+    const std::vector<std::string>& extended_header_lines,
+    std::ostream& out) {
 
     // 1. 初步检查：如果编辑脚本为空，或所有操作都是 MATCH，则没有差异可显示。
     bool has_actual_changes = false;
-    if (ses.empty()) {
-        // 注意：Repository::diff() 在调用此函数前，通常已通过哈希比较排除了文件内容完全相同的情况。
-        // 如果 ses 为空，可能表示输入文件本身为空，或者 Myers 实现对空文件返回空 ses。
-        return;
-    }
     for (const auto& op : ses) {
         if (op.type != EditType::MATCH) {
             has_actual_changes = true;
             break;
         }
     }
-    if (!has_actual_changes) {
+    // 注意：Repository::diff() 在调用此函数前，通常已通过哈希比较排除了文件内容完全相同的情况。
+    // 内容相同但带有扩展头 (例如纯重命名) 时，仍需打印文件识别头和扩展头。
+    if (!has_actual_changes && extended_header_lines.empty()) {
         return; // 文件内容相同
     }
 
     // 2. 打印文件识别头
-    std::cout << "diff --biogit a/" << file_path.generic_string() << " b/" << file_path.generic_string() << std::endl;
-    std::cout << "--- a/" << file_path.generic_string() << old_file_label_suffix << std::endl;
-    std::cout << "+++ b/" << file_path.generic_string() << new_file_label_suffix << std::endl;
+    out << "diff --biogit a/" << old_file_path.generic_string() << " b/" << new_file_path.generic_string() << std::endl;
+    for (const auto& header_line : extended_header_lines) {
+        out << header_line << std::endl;
+    }
+    if (!has_actual_changes) {
+        return;
+    }
+    out << "--- a/" << old_file_path.generic_string() << old_file_label_suffix << std::endl;
+    out << "+++ b/" << new_file_path.generic_string() << new_file_label_suffix << std::endl;
 
     int current_op_idx = 0; // 当前处理到的 SES 操作的索引
     while (current_op_idx < ses.size()) {
@@ -277,7 +341,7 @@ void print_unified_diff(
              // This might happen if context lines were gathered but no actual changes within them.
              // Should be rare if first_change_idx logic is correct.
         } else {
-            std::cout << "@@ -" << old_s << "," << old_l
+            out << "@@ -" << old_s << "," << old_l
                       << " +" << new_s << "," << new_l << " @@" << std::endl;
 
             // 6. 打印 Hunk 内容行
@@ -291,13 +355,20 @@ void print_unified_diff(
                 }
                 // op.line_content 是原始行，不需要额外加 std::endl，除非它本身不包含
                 // 但 MyersDiffLines 提供的 line_content 应该是完整的行
-                std::cout << prefix << op.line_content << std::endl;
+                out << prefix << op.line_content << std::endl;
             }
         }
         current_op_idx = hunk_end_in_ses; // 更新 SES 处理索引，准备下一个 Hunk
     }
 }
 
+std::filesystem::path unique_temp_path(const std::filesystem::path& final_path) {
+    static std::atomic<uint64_t> sequence{0};
+    std::filesystem::path temp_path = final_path;
+    temp_path += "." + std::to_string(::getpid()) + "." + std::to_string(sequence.fetch_add(1)) + ".tmp";
+    return temp_path;
+}
+
 bool is_path_under_or_equal(const std::filesystem::path& target_path, const std::filesystem::path& base_dir_spec) {
     if (target_path == base_dir_spec) { // 直接匹配文件本身
         return true;